@@ -60,6 +60,9 @@ typedef enum {
 	SYS_WAITQ_SLEEP,
 	SYS_WAITQ_WAKEUP,
 	SYS_WAITQ_DESTROY,
+	SYS_FUTEX_WAIT,
+	SYS_FUTEX_WAKE,
+	SYS_FUTEX_REQUEUE,
 	SYS_SMC_COHERENCE,
 
 	SYS_AS_AREA_CREATE,
@@ -97,6 +100,7 @@ typedef enum {
 
 	SYS_IPC_IRQ_SUBSCRIBE,
 	SYS_IPC_IRQ_UNSUBSCRIBE,
+	SYS_IPC_IRQ_COALESCE,
 
 	SYS_SYSINFO_GET_KEYS_SIZE,
 	SYS_SYSINFO_GET_KEYS,
@@ -81,6 +81,7 @@
 #ifndef __ASSEMBLER__
 
 #include <arch/pm.h>
+#include <stdbool.h>
 
 typedef struct {
 	int vendor;
@@ -100,6 +101,8 @@ struct star_msr {
 struct lstar_msr {
 };
 
+extern bool memcpy_rep_movsb;
+
 void cpu_setup_fpu(void);
 
 #endif /* __ASSEMBLER__ */
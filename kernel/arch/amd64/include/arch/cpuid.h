@@ -35,15 +35,17 @@
 #ifndef KERN_amd64_CPUID_H_
 #define KERN_amd64_CPUID_H_
 
-#define AMD_CPUID_EXTENDED  0x80000001
-#define AMD_EXT_NOEXECUTE   20
-#define AMD_EXT_LONG_MODE   29
+#define AMD_CPUID_EXTENDED      0x80000001
+#define AMD_EXT_NOEXECUTE       20
+#define AMD_EXT_LONG_MODE       29
 
-#define INTEL_CPUID_LEVEL     0x00000000
-#define INTEL_CPUID_STANDARD  0x00000001
-#define INTEL_CPUID_EXTENDED  0x80000000
-#define INTEL_SSE2            26
-#define INTEL_FXSAVE          24
+#define INTEL_CPUID_LEVEL       0x00000000
+#define INTEL_CPUID_STANDARD    0x00000001
+#define INTEL_CPUID_STRUCTURED  0x00000007
+#define INTEL_CPUID_EXTENDED    0x80000000
+#define INTEL_SSE2              26
+#define INTEL_FXSAVE            24
+#define INTEL_ERMS              9
 
 #ifndef __ASSEMBLER__
 
@@ -49,6 +49,14 @@
 #define IVT_IRQBASE   (IVT_EXCBASE + EXC_COUNT)
 #define IVT_FREEBASE  (IVT_IRQBASE + IRQ_COUNT)
 
+/*
+ * Vectors for message signalled interrupts. They are delivered to the local
+ * APIC and appear as IRQs numbered from IRQ_MSIBASE.
+ */
+#define MSI_COUNT    8
+#define IVT_MSIBASE  (IVT_FREEBASE + 4)
+#define IRQ_MSIBASE  IRQ_COUNT
+
 #define EXC_DE 0
 #define EXC_NM 7
 #define EXC_SS 12
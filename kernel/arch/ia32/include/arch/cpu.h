@@ -68,6 +68,7 @@
 #include <arch/pm.h>
 #include <arch/asm.h>
 #include <arch/cpuid.h>
+#include <stdbool.h>
 
 typedef struct {
 	unsigned int vendor;
@@ -83,6 +84,8 @@ typedef struct {
 	size_t iomapver_copy;  /** Copy of TASK's I/O Permission bitmap generation count. */
 } cpu_arch_t;
 
+extern bool memcpy_rep_movsb;
+
 #endif
 
 #endif
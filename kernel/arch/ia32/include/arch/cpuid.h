@@ -35,10 +35,12 @@
 #ifndef KERN_ia32_CPUID_H_
 #define KERN_ia32_CPUID_H_
 
-#define INTEL_CPUID_LEVEL     0x00000000
-#define INTEL_CPUID_STANDARD  0x00000001
-#define INTEL_PSE             3
-#define INTEL_SEP             11
+#define INTEL_CPUID_LEVEL       0x00000000
+#define INTEL_CPUID_STANDARD    0x00000001
+#define INTEL_CPUID_STRUCTURED  0x00000007
+#define INTEL_PSE               3
+#define INTEL_SEP               11
+#define INTEL_ERMS              9
 
 #ifndef __ASSEMBLER__
 
@@ -111,7 +113,7 @@ static inline void cpuid(uint32_t cmd, cpu_info_t *info)
 	    "cpuid\n"
 	    : "=a" (info->cpuid_eax), "=b" (info->cpuid_ebx),
 	      "=c" (info->cpuid_ecx), "=d" (info->cpuid_edx)
-	    : "a" (cmd)
+	    : "a" (cmd), "c" (0)
 	);
 }
 
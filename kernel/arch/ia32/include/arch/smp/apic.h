@@ -38,6 +38,9 @@
 #define L_APIC_BASE	0xfee00000
 #define IO_APIC_BASE	0xfec00000
 
+/** Address of the local APIC for message signalled interrupts */
+#define MSI_ADDRESS	0xfee00000
+
 #ifndef __ASSEMBLER__
 
 #include <cpu.h>
@@ -62,6 +62,14 @@ enum vendor {
 	VendorIntel
 };
 
+/** Use REP MOVSB/STOSB for the bulk of memcpy() and memset()
+ *
+ * Set only if all processors support Enhanced REP MOVSB/STOSB.
+ * The copy routines are correct either way, so a processor which
+ * has not been identified yet can safely observe any value.
+ */
+bool memcpy_rep_movsb = false;
+
 static const char *vendor_str[] = {
 	"Unknown Vendor",
 	"AMD",
@@ -118,10 +126,13 @@ void cpu_arch_init(void)
 void cpu_identify(void)
 {
 	cpu_info_t info;
+	uint32_t level;
+	bool erms = false;
 
 	CPU->arch.vendor = VendorUnknown;
 	if (has_cpuid()) {
 		cpuid(INTEL_CPUID_LEVEL, &info);
+		level = info.cpuid_eax;
 
 		/*
 		 * Check for AMD processor.
@@ -143,7 +154,17 @@ void cpu_identify(void)
 		CPU->arch.family = (info.cpuid_eax >> 8) & 0x0fU;
 		CPU->arch.model = (info.cpuid_eax >> 4) & 0x0fU;
 		CPU->arch.stepping = (info.cpuid_eax >> 0) & 0x0fU;
+
+		if (level >= INTEL_CPUID_STRUCTURED) {
+			cpuid(INTEL_CPUID_STRUCTURED, &info);
+			erms = (info.cpuid_ebx >> INTEL_ERMS) & 1;
+		}
 	}
+
+	if (CPU->id == 0)
+		memcpy_rep_movsb = erms;
+	else if (!erms)
+		memcpy_rep_movsb = false;
 }
 
 void cpu_print_report(cpu_t *cpu)
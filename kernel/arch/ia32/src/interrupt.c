@@ -206,6 +206,33 @@ static void irq_interrupt(unsigned int n, istate_t *istate __attribute__((unused
 		pic_ops->eoi(inum);
 }
 
+#ifdef CONFIG_SMP
+/** Handler of message signalled interrupts
+ *
+ * These are delivered by the local APIC directly, without any IRQ pin.
+ */
+static void msi_interrupt(unsigned int n, istate_t *istate __attribute__((unused)))
+{
+	assert(n >= IVT_MSIBASE);
+
+	unsigned int inum = IRQ_MSIBASE + (n - IVT_MSIBASE);
+	assert(inum < IRQ_MSIBASE + MSI_COUNT);
+
+	irq_t *irq = irq_dispatch_and_lock(inum);
+	if (irq) {
+		irq->handler(irq);
+		irq_spinlock_unlock(&irq->lock, false);
+	} else {
+#ifdef CONFIG_DEBUG
+		log(LF_ARCH, LVL_DEBUG, "cpu%u: unhandled MSI %u", CPU->id,
+		    inum);
+#endif
+	}
+
+	pic_ops->eoi(inum);
+}
+#endif
+
 static void pic_spurious(unsigned int n, istate_t *istate)
 {
 	unsigned int inum = n - IVT_IRQBASE;
@@ -247,6 +274,10 @@ void interrupt_init(void)
 	    (iroutine_t) pic_spurious);
 
 #ifdef CONFIG_SMP
+	for (i = 0; i < MSI_COUNT; i++)
+		exc_register(IVT_MSIBASE + i, "msi", true,
+		    (iroutine_t) msi_interrupt);
+
 	exc_register(VECTOR_TLB_SHOOTDOWN_IPI, "tlb_shootdown", true,
 	    (iroutine_t) tlb_shootdown_ipi);
 #endif
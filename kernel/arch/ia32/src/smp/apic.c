@@ -47,6 +47,7 @@
 #include <arch.h>
 #include <ddi/irq.h>
 #include <genarch/pic/pic_ops.h>
+#include <sysinfo/sysinfo.h>
 
 #ifdef CONFIG_SMP
 
@@ -246,6 +247,16 @@ void apic_init(void)
 	l_apic_debug();
 
 	bsp_l_apic = l_apic_id();
+
+	/*
+	 * Message signalled interrupts are sent to the BSP. The device writes
+	 * the data (the vector) to the address in fixed delivery mode.
+	 */
+	sysinfo_set_item_val("msi.address", NULL,
+	    MSI_ADDRESS | ((sysarg_t) bsp_l_apic << 12));
+	sysinfo_set_item_val("msi.data", NULL, IVT_MSIBASE);
+	sysinfo_set_item_val("msi.inr", NULL, IRQ_MSIBASE);
+	sysinfo_set_item_val("msi.count", NULL, MSI_COUNT);
 }
 
 /** Poll for APIC errors.
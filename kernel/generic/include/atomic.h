@@ -66,6 +66,25 @@ typedef atomic_size_t atomic_t;
 #define atomic_inc(val) \
 	((void) atomic_fetch_add(val, 1))
 
+/** Increment the value unless it is zero.
+ *
+ * This is used to take a reference to an object found in an RCU-protected
+ * structure, whose last reference might be dropped concurrently.
+ *
+ * @return True if the value was incremented.
+ */
+static inline bool atomic_inc_not_zero(atomic_t *val)
+{
+	size_t v = atomic_load_explicit(val, memory_order_relaxed);
+
+	do {
+		if (v == 0)
+			return false;
+	} while (!atomic_compare_exchange_weak(val, &v, v + 1));
+
+	return true;
+}
+
 #define local_atomic_exchange(var_addr, new_val) \
 	atomic_exchange_explicit( \
 	    (_Atomic typeof(*(var_addr)) *) (var_addr), \
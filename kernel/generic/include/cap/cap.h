@@ -38,10 +38,9 @@
 #include <abi/cap.h>
 #include <typedefs.h>
 #include <adt/list.h>
-#include <adt/hash.h>
-#include <adt/hash_table.h>
 #include <lib/ra.h>
 #include <synch/mutex.h>
+#include <synch/rcu.h>
 #include <atomic.h>
 
 typedef enum {
@@ -93,10 +92,15 @@ typedef struct kobject {
 		struct phone *phone;
 		struct waitq *waitq;
 	};
+
+	/** Used to free the kobject after an RCU grace period */
+	rcu_item_t rcu;
 } kobject_t;
 
 /*
- * A cap_t may only be accessed under the protection of the cap_info_t lock.
+ * A cap_t may only be accessed under the protection of the cap_info_t lock,
+ * except for the kobject pointer, which may also be read locklessly in an
+ * RCU read-side critical section.
  */
 typedef struct cap {
 	cap_state_t state;
@@ -110,18 +114,36 @@ typedef struct cap {
 	/* Link to the task's capabilities of the same kobject type. */
 	link_t type_link;
 
-	ht_link_t caps_link;
-
 	/* The underlying kernel object. */
 	kobject_t *kobject;
+
+	/** Used to free the capability after an RCU grace period */
+	rcu_item_t rcu;
 } cap_t;
 
+#define CAPS_NODE_BITS	6
+#define CAPS_NODE_SIZE	(1 << CAPS_NODE_BITS)
+#define CAPS_NODE_MASK	(CAPS_NODE_SIZE - 1)
+
+/** Node of the radix tree of capabilities indexed by capability handle */
+typedef struct caps_node {
+	/** Number of handle bits below the index into this node */
+	unsigned int shift;
+	/** Child nodes or, if shift is zero, capabilities */
+	void *slot[CAPS_NODE_SIZE];
+} caps_node_t;
+
 typedef struct cap_info {
 	mutex_t lock;
 
 	list_t type_list[KOBJECT_TYPE_MAX];
 
-	hash_table_t caps;
+	/**
+	 * Radix tree of capabilities. It is modified under the lock and can be
+	 * searched locklessly in an RCU read-side critical section. Nodes are
+	 * freed only together with the whole cap_info_t.
+	 */
+	caps_node_t *caps_root;
 	ra_arena_t *handles;
 } cap_info_t;
 
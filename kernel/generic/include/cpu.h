@@ -96,6 +96,15 @@ typedef struct cpu {
 
 	struct thread *fpu_owner;
 
+	/** Number of RCU quiescent states this processor passed through. */
+	atomic_size_t rcu_qs;
+
+	/** Protects rcu_pending. */
+	IRQ_SPINLOCK_DECLARE(rcu_lock);
+
+	/** RCU callbacks queued on this processor and not collected yet. */
+	list_t rcu_pending;
+
 	/**
 	 * Stack used by scheduler when there is no running thread.
 	 */
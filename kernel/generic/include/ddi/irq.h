@@ -82,6 +82,18 @@ typedef struct {
 	irq_code_t *code;
 	/** Counter. */
 	size_t counter;
+	/**
+	 * Maximum number of interrupts coalesced into one notification.
+	 * Values below two disable coalescing.
+	 */
+	size_t coalesce;
+	/**
+	 * Notification still waiting in the answerbox to which further
+	 * interrupts can be coalesced. Protected by the answerbox irq_lock.
+	 */
+	call_t *pending;
+	/** Number of interrupts coalesced into the pending notification. */
+	size_t pending_count;
 } ipc_notif_cfg_t;
 
 /** Structure representing one device IRQ.
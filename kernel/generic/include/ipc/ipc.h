@@ -165,6 +165,12 @@ typedef struct call {
 
 	/** Buffer for IPC_M_DATA_WRITE and IPC_M_DATA_READ. */
 	uint8_t *buffer;
+
+	/**
+	 * Reference to the call held by the IRQ which coalesces interrupts
+	 * into this notification. Protected by the answerbox irq_lock.
+	 */
+	struct call **notif_pending;
 } call_t;
 
 extern slab_cache_t *phone_cache;
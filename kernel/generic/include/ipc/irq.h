@@ -55,6 +55,7 @@ extern void ipc_irq_top_half_handler(irq_t *);
 extern errno_t ipc_irq_subscribe(answerbox_t *, inr_t, sysarg_t, uspace_ptr_irq_code_t,
     uspace_ptr_cap_irq_handle_t);
 extern errno_t ipc_irq_unsubscribe(answerbox_t *, cap_irq_handle_t);
+extern errno_t ipc_irq_coalesce(answerbox_t *, cap_irq_handle_t, size_t);
 
 /*
  * User friendly wrappers for ipc_irq_send_msg(). They are in the form
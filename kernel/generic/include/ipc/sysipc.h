@@ -59,6 +59,7 @@ extern sys_errno_t sys_ipc_hangup(cap_phone_handle_t);
 extern sys_errno_t sys_ipc_irq_subscribe(inr_t, sysarg_t, uspace_ptr_irq_code_t,
     uspace_ptr_cap_irq_handle_t);
 extern sys_errno_t sys_ipc_irq_unsubscribe(cap_irq_handle_t);
+extern sys_errno_t sys_ipc_irq_coalesce(cap_irq_handle_t, sysarg_t);
 
 extern sys_errno_t sys_ipc_connect_kbox(uspace_ptr_task_id_t, uspace_ptr_cap_phone_handle_t);
 
@@ -41,6 +41,7 @@
 #include <ipc/kbox.h>
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
+#include <synch/rcu.h>
 #include <adt/list.h>
 #include <adt/odict.h>
 #include <security/perm.h>
@@ -67,6 +68,10 @@ struct cap;
 typedef struct task {
 	/** Link to @c tasks ordered dictionary */
 	odlink_t ltasks;
+	/** Next task in the same bucket of the RCU-protected task hash */
+	struct task *hash_next;
+	/** Used to free the task structure after an RCU grace period */
+	rcu_item_t rcu;
 
 	/** Task lock.
 	 *
@@ -143,6 +148,7 @@ extern void task_destroy(task_t *);
 extern void task_hold(task_t *);
 extern void task_release(task_t *);
 extern task_t *task_find_by_id(task_id_t);
+extern task_t *task_get_by_id(task_id_t);
 extern size_t task_count(void);
 extern task_t *task_first(void);
 extern task_t *task_next(task_t *);
@@ -37,6 +37,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <adt/list.h>
 #include <synch/semaphore.h>
 #include <abi/synch.h>
 
@@ -46,13 +48,50 @@ typedef enum {
 	MUTEX_ACTIVE
 } mutex_type_t;
 
+/** Default number of spin iterations before a contended mutex sleeps */
+#define MUTEX_SPIN_LIMIT_DEFAULT  1000
+
+/** Class of mutexes.
+ *
+ * Mutexes of one class share the spinning policy and contention
+ * statistics. Classes are registered when the first mutex of the class
+ * is initialized and are never unregistered.
+ */
+typedef struct mutex_class {
+	/** Link to the list of registered classes. */
+	link_t link;
+	/** Name of the class. */
+	const char *name;
+	/**
+	 * Maximum number of spin iterations of a contended lock operation
+	 * before the thread goes to sleep. Zero disables spinning.
+	 */
+	atomic_uint spin_limit;
+
+	/** Number of lock operations which found the mutex locked. */
+	atomic_size_t contended;
+	/** Number of contended lock operations satisfied by spinning. */
+	atomic_size_t spun;
+	/** Number of contended lock operations which went to sleep. */
+	atomic_size_t slept;
+	/** Total number of spin iterations. */
+	atomic_size_t spins;
+} mutex_class_t;
+
+#define MUTEX_CLASS_INITIALIZER(cname) \
+	{ \
+		.name = (cname), \
+		.spin_limit = MUTEX_SPIN_LIMIT_DEFAULT, \
+	}
+
 struct thread;
 
 typedef struct {
 	mutex_type_t type;
 	semaphore_t sem;
-	struct thread *owner;
+	_Atomic(struct thread *) owner;
 	unsigned nesting;
+	mutex_class_t *cls;
 } mutex_t;
 
 #define mutex_lock(mtx) \
@@ -65,10 +104,14 @@ typedef struct {
 	_mutex_lock_timeout((mtx), (usec), SYNCH_FLAGS_NON_BLOCKING)
 
 extern void mutex_initialize(mutex_t *, mutex_type_t);
+extern void mutex_initialize_class(mutex_t *, mutex_type_t, mutex_class_t *);
 extern bool mutex_locked(mutex_t *);
 extern errno_t _mutex_lock_timeout(mutex_t *, uint32_t, unsigned int);
 extern void mutex_unlock(mutex_t *);
 
+extern void mutex_class_set_spin_limit(unsigned int);
+extern void mutex_class_print_list(void);
+
 #endif
 
 /** @}
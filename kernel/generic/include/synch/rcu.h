@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_RCU_H_
+#define KERN_RCU_H_
+
+#include <adt/list.h>
+#include <stddef.h>
+#include <preemption.h>
+
+struct rcu_item;
+
+typedef void (*rcu_func_t)(struct rcu_item *);
+
+/** Deferred callback, usually embedded in the object to be reclaimed. */
+typedef struct rcu_item {
+	link_t link;
+	rcu_func_t func;
+} rcu_item_t;
+
+/** Enter an RCU read-side critical section.
+ *
+ * Read-side critical sections can nest, must not sleep and must not
+ * be left on a different CPU. They are delimited by disabling preemption,
+ * as any pass through the scheduler is a quiescent state.
+ */
+#define rcu_read_lock()  preemption_disable()
+
+/** Leave an RCU read-side critical section. */
+#define rcu_read_unlock()  preemption_enable()
+
+/** Load an RCU-protected pointer within a read-side critical section. */
+#define rcu_dereference(ptr) \
+	__atomic_load_n(&(ptr), __ATOMIC_CONSUME)
+
+/** Publish a pointer to an initialized object for RCU readers. */
+#define rcu_assign_pointer(ptr, value) \
+	__atomic_store_n(&(ptr), (value), __ATOMIC_RELEASE)
+
+extern void rcu_init(void);
+extern void rcu_thread_init(void);
+extern void rcu_quiescent(void);
+extern void call_rcu(rcu_item_t *, rcu_func_t);
+extern void rcu_synchronize(void);
+extern size_t rcu_gp_completed(void);
+
+#endif
+
+/** @}
+ */
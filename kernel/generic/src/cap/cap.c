@@ -98,6 +98,8 @@
 static slab_cache_t *cap_cache;
 static slab_cache_t *kobject_cache;
 
+static mutex_class_t cap_info_mutex_class = MUTEX_CLASS_INITIALIZER("cap_info");
+
 kobject_ops_t *kobject_ops[KOBJECT_TYPE_MAX] = {
 	[KOBJECT_TYPE_CALL] = &call_kobject_ops,
 	[KOBJECT_TYPE_IRQ] = &irq_kobject_ops,
@@ -105,30 +107,106 @@ kobject_ops_t *kobject_ops[KOBJECT_TYPE_MAX] = {
 	[KOBJECT_TYPE_WAITQ] = &waitq_kobject_ops
 };
 
-static size_t caps_hash(const ht_link_t *item)
+/** Find capability in the radix tree
+ *
+ * The caller must either hold the cap_info_t lock or be in an RCU read-side
+ * critical section.
+ *
+ * @param info  Capability info structure to search.
+ * @param idx   Raw capability handle.
+ *
+ * @return Capability with the handle or NULL if there is none.
+ */
+static cap_t *caps_lookup(cap_info_t *info, uintptr_t idx)
 {
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return hash_mix(cap_handle_raw(cap->handle));
+	caps_node_t *node = rcu_dereference(info->caps_root);
+	if (!node)
+		return NULL;
+
+	/* The tree is not high enough to contain the handle. */
+	if ((idx >> node->shift) >> CAPS_NODE_BITS != 0)
+		return NULL;
+
+	while (node->shift > 0) {
+		node = rcu_dereference(
+		    node->slot[(idx >> node->shift) & CAPS_NODE_MASK]);
+		if (!node)
+			return NULL;
+	}
+
+	return rcu_dereference(node->slot[idx & CAPS_NODE_MASK]);
 }
 
-static size_t caps_key_hash(const void *key)
+static caps_node_t *caps_node_alloc(unsigned int shift)
 {
-	const cap_handle_t *handle = key;
-	return hash_mix(cap_handle_raw(*handle));
+	caps_node_t *node = malloc(sizeof(caps_node_t));
+	if (!node)
+		return NULL;
+
+	node->shift = shift;
+	for (size_t i = 0; i < CAPS_NODE_SIZE; i++)
+		node->slot[i] = NULL;
+
+	return node;
 }
 
-static bool caps_key_equal(const void *key, const ht_link_t *item)
+static void caps_node_free(caps_node_t *node)
 {
-	const cap_handle_t *handle = key;
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return *handle == cap->handle;
+	if (node->shift > 0) {
+		for (size_t i = 0; i < CAPS_NODE_SIZE; i++) {
+			if (node->slot[i])
+				caps_node_free(node->slot[i]);
+		}
+	}
+
+	free(node);
 }
 
-static hash_table_ops_t caps_ops = {
-	.hash = caps_hash,
-	.key_hash = caps_key_hash,
-	.key_equal = caps_key_equal
-};
+/** Make room for a capability in the radix tree
+ *
+ * Grows the tree and allocates the intermediate nodes as needed. New nodes are
+ * fully initialized before they are published to lockless readers.
+ *
+ * @param info  Capability info structure. Its lock must be held.
+ * @param idx   Raw capability handle.
+ *
+ * @return Leaf node in which the capability is to be stored.
+ * @return NULL if there is not enough memory.
+ */
+static caps_node_t *caps_leaf_get(cap_info_t *info, uintptr_t idx)
+{
+	caps_node_t *node = info->caps_root;
+	if (!node) {
+		node = caps_node_alloc(0);
+		if (!node)
+			return NULL;
+		rcu_assign_pointer(info->caps_root, node);
+	}
+
+	while ((idx >> node->shift) >> CAPS_NODE_BITS != 0) {
+		caps_node_t *root = caps_node_alloc(node->shift +
+		    CAPS_NODE_BITS);
+		if (!root)
+			return NULL;
+		root->slot[0] = node;
+		rcu_assign_pointer(info->caps_root, root);
+		node = root;
+	}
+
+	while (node->shift > 0) {
+		void **slot = &node->slot[(idx >> node->shift) & CAPS_NODE_MASK];
+		if (!*slot) {
+			caps_node_t *child = caps_node_alloc(node->shift -
+			    CAPS_NODE_BITS);
+			if (!child)
+				return NULL;
+			rcu_assign_pointer(*slot, child);
+		}
+		node = *slot;
+	}
+
+	return node;
+}
 
 void caps_init(void)
 {
@@ -152,8 +230,7 @@ errno_t caps_task_alloc(task_t *task)
 		goto error_handles;
 	if (!ra_span_add(task->cap_info->handles, CAPS_START, CAPS_SIZE))
 		goto error_span;
-	if (!hash_table_create(&task->cap_info->caps, 0, 0, &caps_ops))
-		goto error_span;
+	task->cap_info->caps_root = NULL;
 	return EOK;
 
 error_span:
@@ -169,7 +246,8 @@ error_handles:
  */
 void caps_task_init(task_t *task)
 {
-	mutex_initialize(&task->cap_info->lock, MUTEX_RECURSIVE);
+	mutex_initialize_class(&task->cap_info->lock, MUTEX_RECURSIVE,
+	    &cap_info_mutex_class);
 
 	for (kobject_type_t t = 0; t < KOBJECT_TYPE_MAX; t++)
 		list_initialize(&task->cap_info->type_list[t]);
@@ -181,7 +259,8 @@ void caps_task_init(task_t *task)
  */
 void caps_task_free(task_t *task)
 {
-	hash_table_destroy(&task->cap_info->caps);
+	if (task->cap_info->caps_root)
+		caps_node_free(task->cap_info->caps_root);
 	ra_arena_destroy(task->cap_info->handles);
 	free(task->cap_info);
 }
@@ -225,6 +304,7 @@ static void cap_initialize(cap_t *cap, task_t *task, cap_handle_t handle)
 	cap->state = CAP_STATE_FREE;
 	cap->task = task;
 	cap->handle = handle;
+	cap->kobject = NULL;
 	link_initialize(&cap->kobj_link);
 	link_initialize(&cap->type_link);
 }
@@ -245,10 +325,9 @@ static cap_t *cap_get(task_t *task, cap_handle_t handle, cap_state_t state)
 	if ((cap_handle_raw(handle) < CAPS_START) ||
 	    (cap_handle_raw(handle) > CAPS_LAST))
 		return NULL;
-	ht_link_t *link = hash_table_find(&task->cap_info->caps, &handle);
-	if (!link)
+	cap_t *cap = caps_lookup(task->cap_info, cap_handle_raw(handle));
+	if (!cap)
 		return NULL;
-	cap_t *cap = hash_table_get_inst(link, cap_t, caps_link);
 	if (cap->state != state)
 		return NULL;
 	return cap;
@@ -276,10 +355,17 @@ errno_t cap_alloc(task_t *task, cap_handle_t *handle)
 		mutex_unlock(&task->cap_info->lock);
 		return ENOMEM;
 	}
+	caps_node_t *leaf = caps_leaf_get(task->cap_info, hbase);
+	if (!leaf) {
+		ra_free(task->cap_info->handles, hbase, 1);
+		slab_free(cap_cache, cap);
+		mutex_unlock(&task->cap_info->lock);
+		return ENOMEM;
+	}
 	cap_initialize(cap, task, (cap_handle_t) hbase);
-	hash_table_insert(&task->cap_info->caps, &cap->caps_link);
-
 	cap->state = CAP_STATE_ALLOCATED;
+	rcu_assign_pointer(leaf->slot[hbase & CAPS_NODE_MASK], cap);
+
 	*handle = cap->handle;
 	mutex_unlock(&task->cap_info->lock);
 
@@ -305,7 +391,7 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 	assert(cap);
 	cap->state = CAP_STATE_PUBLISHED;
 	/* Hand over kobj's reference to cap */
-	cap->kobject = kobj;
+	rcu_assign_pointer(cap->kobject, kobj);
 	list_append(&cap->kobj_link, &kobj->caps_list);
 	list_append(&cap->type_link, &task->cap_info->type_list[kobj->type]);
 	mutex_unlock(&task->cap_info->lock);
@@ -314,7 +400,7 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 
 static void cap_unpublish_unsafe(cap_t *cap)
 {
-	cap->kobject = NULL;
+	rcu_assign_pointer(cap->kobject, NULL);
 	list_remove(&cap->kobj_link);
 	list_remove(&cap->type_link);
 	cap->state = CAP_STATE_ALLOCATED;
@@ -386,6 +472,12 @@ void cap_revoke(kobject_t *kobj)
 	mutex_unlock(&kobj->caps_list_lock);
 }
 
+static void cap_free_rcu(rcu_item_t *item)
+{
+	cap_t *cap = member_to_inst(item, cap_t, rcu);
+	slab_free(cap_cache, cap);
+}
+
 /** Free allocated capability
  *
  * @param task    Task in which to free the capability.
@@ -401,10 +493,15 @@ void cap_free(task_t *task, cap_handle_t handle)
 
 	assert(cap);
 
-	hash_table_remove_item(&task->cap_info->caps, &cap->caps_link);
-	ra_free(task->cap_info->handles, cap_handle_raw(handle), 1);
-	slab_free(cap_cache, cap);
+	uintptr_t idx = cap_handle_raw(handle);
+	caps_node_t *leaf = caps_leaf_get(task->cap_info, idx);
+	assert(leaf);
+	rcu_assign_pointer(leaf->slot[idx & CAPS_NODE_MASK], NULL);
+	ra_free(task->cap_info->handles, idx, 1);
 	mutex_unlock(&task->cap_info->lock);
+
+	/* Lockless readers of the capability may still be around. */
+	call_rcu(&cap->rcu, cap_free_rcu);
 }
 
 kobject_t *kobject_alloc(unsigned int flags)
@@ -434,7 +531,17 @@ void kobject_initialize(kobject_t *kobj, kobject_type_t type, void *raw)
 	kobj->raw = raw;
 }
 
+static void kobject_free_rcu(rcu_item_t *item)
+{
+	kobject_t *kobj = member_to_inst(item, kobject_t, rcu);
+	kobject_free(kobj);
+}
+
 /** Get new reference to kernel object from capability
+ *
+ * The lookup does not take the cap_info_t lock. The capability and its kernel
+ * object are found in an RCU read-side critical section, and the reference is
+ * taken only if the kernel object is not concurrently being destroyed.
  *
  * @param task    Task from which to get the reference.
  * @param handle  Capability handle.
@@ -449,15 +556,20 @@ kobject_get(struct task *task, cap_handle_t handle, kobject_type_t type)
 {
 	kobject_t *kobj = NULL;
 
-	mutex_lock(&task->cap_info->lock);
-	cap_t *cap = cap_get(task, handle, CAP_STATE_PUBLISHED);
+	if ((cap_handle_raw(handle) < CAPS_START) ||
+	    (cap_handle_raw(handle) > CAPS_LAST))
+		return NULL;
+
+	rcu_read_lock();
+	cap_t *cap = caps_lookup(task->cap_info, cap_handle_raw(handle));
 	if (cap) {
-		if (cap->kobject->type == type) {
-			kobj = cap->kobject;
-			atomic_inc(&kobj->refcnt);
-		}
+		/* The kobject is set only while the capability is published. */
+		kobj = rcu_dereference(cap->kobject);
+		if ((kobj) && ((kobj->type != type) ||
+		    (!atomic_inc_not_zero(&kobj->refcnt))))
+			kobj = NULL;
 	}
-	mutex_unlock(&task->cap_info->lock);
+	rcu_read_unlock();
 
 	return kobj;
 }
@@ -482,7 +594,8 @@ void kobject_put(kobject_t *kobj)
 {
 	if (atomic_postdec(&kobj->refcnt) == 1) {
 		KOBJECT_OP(kobj)->destroy(kobj->raw);
-		kobject_free(kobj);
+		/* Lockless kobject_get() may still be looking at kobj. */
+		call_rcu(&kobj->rcu, kobject_free_rcu);
 	}
 }
 
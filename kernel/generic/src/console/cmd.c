@@ -62,6 +62,7 @@
 #include <main/version.h>
 #include <mm/slab.h>
 #include <proc/scheduler.h>
+#include <synch/mutex.h>
 #include <proc/thread.h>
 #include <proc/task.h>
 #include <ipc/ipc.h>
@@ -503,6 +504,27 @@ static cmd_info_t caches_info = {
 	.argc = 0
 };
 
+static int cmd_mutexes(cmd_arg_t *argv);
+static cmd_info_t mutexes_info = {
+	.name = "mutexes",
+	.description = "List mutex classes and their contention statistics.",
+	.func = cmd_mutexes,
+	.argc = 0
+};
+
+/* Data and methods for 'mutex_spin' command */
+static int cmd_mutex_spin(cmd_arg_t *argv);
+static cmd_arg_t mutex_spin_argv = {
+	.type = ARG_TYPE_INT,
+};
+static cmd_info_t mutex_spin_info = {
+	.name = "mutex_spin",
+	.description = "<limit> Set spin limit of all mutex classes.",
+	.func = cmd_mutex_spin,
+	.argc = 1,
+	.argv = &mutex_spin_argv
+};
+
 static int cmd_sysinfo(cmd_arg_t *argv);
 static cmd_info_t sysinfo_info = {
 	.name = "sysinfo",
@@ -596,6 +618,8 @@ static cmd_info_t *basic_commands[] = {
 	&help_info,
 	&ipc_info,
 	&kill_info,
+	&mutexes_info,
+	&mutex_spin_info,
 	&physmem_info,
 	&reboot_info,
 	&sched_info,
@@ -1203,6 +1227,30 @@ int cmd_caches(cmd_arg_t *argv)
 	return 1;
 }
 
+/** Command for listing mutex classes
+ *
+ * @param argv Ignored
+ *
+ * @return Always 1
+ */
+int cmd_mutexes(cmd_arg_t *argv)
+{
+	mutex_class_print_list();
+	return 1;
+}
+
+/** Command for setting the spin limit of mutexes
+ *
+ * @param argv Integer argument from cmdline expected
+ *
+ * @return Always 1
+ */
+int cmd_mutex_spin(cmd_arg_t *argv)
+{
+	mutex_class_set_spin_limit((unsigned int) argv[0].intval);
+	return 1;
+}
+
 /** Command for dumping sysinfo
  *
  * @param argv Ignores
@@ -85,6 +85,10 @@ void cpu_init(void)
 
 			irq_spinlock_initialize(&cpus[i].lock, "cpus[].lock");
 
+			irq_spinlock_initialize(&cpus[i].rcu_lock,
+			    "cpus[].rcu_lock");
+			list_initialize(&cpus[i].rcu_pending);
+
 			for (unsigned int j = 0; j < RQ_COUNT; j++) {
 				irq_spinlock_initialize(&cpus[i].rq[j].lock, "cpus[].rq[].lock");
 				list_initialize(&cpus[i].rq[j].rq);
@@ -72,6 +72,8 @@ static slab_cache_t *answerbox_cache;
 
 slab_cache_t *phone_cache = NULL;
 
+static mutex_class_t phone_mutex_class = MUTEX_CLASS_INITIALIZER("phone");
+
 /** Initialize a call structure.
  *
  * @param call Call structure to be initialized.
@@ -194,7 +196,8 @@ bool ipc_phone_connect(phone_t *phone, answerbox_t *box)
  */
 void ipc_phone_init(phone_t *phone, task_t *caller)
 {
-	mutex_initialize(&phone->lock, MUTEX_PASSIVE);
+	mutex_initialize_class(&phone->lock, MUTEX_PASSIVE,
+	    &phone_mutex_class);
 	phone->caller = caller;
 	phone->callee = NULL;
 	phone->state = IPC_PHONE_FREE;
@@ -569,6 +572,12 @@ errno_t ipc_wait_for_call(answerbox_t *box, uint32_t usec, unsigned int flags,
 		    call_t, ab_link);
 		list_remove(&request->ab_link);
 
+		/* No more interrupts can be coalesced into the notification */
+		if (request->notif_pending) {
+			*request->notif_pending = NULL;
+			request->notif_pending = NULL;
+		}
+
 		irq_spinlock_unlock(&box->irq_lock, false);
 	} else if (!list_empty(&box->answers)) {
 		/* Count received answer */
@@ -966,14 +975,9 @@ static bool print_task_phone_cb(cap_t *cap, void *arg)
  */
 void ipc_print_task(task_id_t taskid)
 {
-	irq_spinlock_lock(&tasks_lock, true);
-	task_t *task = task_find_by_id(taskid);
-	if (!task) {
-		irq_spinlock_unlock(&tasks_lock, true);
+	task_t *task = task_get_by_id(taskid);
+	if (!task)
 		return;
-	}
-	task_hold(task);
-	irq_spinlock_unlock(&tasks_lock, true);
 
 	printf("[phone cap] [calls] [state\n");
 
@@ -50,6 +50,13 @@
  * - ARG5: payload modified by a 'top-half' handler (scratch[5])
  * - request_label: interrupt counter (may be needed to assure correct order
  *                  in multithreaded drivers)
+ *
+ * When coalescing is enabled with SYS_IPC_IRQ_COALESCE, an interrupt which
+ * arrives while the previous notification still waits in the answerbox is
+ * merged into it instead of queueing a new one. The payload arguments are
+ * or-ed together and the counter is updated, so the driver can tell how many
+ * interrupts a notification stands for. This is meant for top-half handlers
+ * which pass interrupt status bits in the payload.
  */
 
 #include <arch.h>
@@ -294,11 +301,27 @@ static void irq_hash_out(irq_t *irq)
 	irq_spinlock_unlock(&irq_uspace_hash_table_lock, true);
 }
 
+/** Stop coalescing interrupts into the pending notification. */
+static void irq_detach_pending(irq_t *irq)
+{
+	answerbox_t *box = irq->notif_cfg.answerbox;
+
+	irq_spinlock_lock(&box->irq_lock, true);
+
+	if (irq->notif_cfg.pending) {
+		irq->notif_cfg.pending->notif_pending = NULL;
+		irq->notif_cfg.pending = NULL;
+	}
+
+	irq_spinlock_unlock(&box->irq_lock, true);
+}
+
 static void irq_destroy(void *arg)
 {
 	irq_t *irq = (irq_t *) arg;
 
 	irq_hash_out(irq);
+	irq_detach_pending(irq);
 
 	/* Free up the IRQ code and associated structures. */
 	code_free(irq->notif_cfg.code);
@@ -371,6 +394,9 @@ errno_t ipc_irq_subscribe(answerbox_t *box, inr_t inr, sysarg_t imethod,
 	irq->notif_cfg.imethod = imethod;
 	irq->notif_cfg.code = code;
 	irq->notif_cfg.counter = 0;
+	irq->notif_cfg.coalesce = 0;
+	irq->notif_cfg.pending = NULL;
+	irq->notif_cfg.pending_count = 0;
 
 	/*
 	 * Insert the IRQ structure into the uspace IRQ hash table.
@@ -414,6 +440,77 @@ errno_t ipc_irq_unsubscribe(answerbox_t *box, cap_irq_handle_t handle)
 	return EOK;
 }
 
+/** Set coalescing of IRQ notifications.
+ *
+ * @param box     Answerbox associated with the notification.
+ * @param handle  IRQ capability handle.
+ * @param limit   Maximum number of interrupts coalesced into one
+ *                notification, values below two disable coalescing.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t ipc_irq_coalesce(answerbox_t *box, cap_irq_handle_t handle,
+    size_t limit)
+{
+	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_IRQ);
+	if (!kobj)
+		return ENOENT;
+
+	irq_t *irq = kobj->irq;
+	assert(irq->notif_cfg.answerbox == box);
+
+	irq_spinlock_lock(&irq->lock, true);
+	irq->notif_cfg.coalesce = limit;
+	irq_spinlock_unlock(&irq->lock, true);
+
+	if (limit < 2)
+		irq_detach_pending(irq);
+
+	kobject_put(kobj);
+	return EOK;
+}
+
+/** Coalesce an interrupt into the pending notification.
+ *
+ * Assume irq->lock is locked and interrupts disabled.
+ *
+ * @param irq  IRQ structure.
+ * @param args Payload arguments of the interrupt.
+ *
+ * @return True if the interrupt was coalesced, false if a new notification
+ *         has to be sent.
+ *
+ */
+static bool coalesce_call(irq_t *irq, const sysarg_t *args)
+{
+	ipc_notif_cfg_t *cfg = &irq->notif_cfg;
+
+	if (cfg->coalesce < 2)
+		return false;
+
+	bool coalesced = false;
+
+	irq_spinlock_lock(&cfg->answerbox->irq_lock, false);
+
+	call_t *call = cfg->pending;
+	if ((call) && (cfg->pending_count < cfg->coalesce)) {
+		ipc_set_arg1(&call->data, ipc_get_arg1(&call->data) | args[0]);
+		ipc_set_arg2(&call->data, ipc_get_arg2(&call->data) | args[1]);
+		ipc_set_arg3(&call->data, ipc_get_arg3(&call->data) | args[2]);
+		ipc_set_arg4(&call->data, ipc_get_arg4(&call->data) | args[3]);
+		ipc_set_arg5(&call->data, ipc_get_arg5(&call->data) | args[4]);
+
+		call->priv = ++cfg->counter;
+		cfg->pending_count++;
+		coalesced = true;
+	}
+
+	irq_spinlock_unlock(&cfg->answerbox->irq_lock, false);
+
+	return coalesced;
+}
+
 /** Add a call to the proper answerbox queue.
  *
  * Assume irq->lock is locked and interrupts disabled.
@@ -424,11 +521,57 @@ errno_t ipc_irq_unsubscribe(answerbox_t *box, cap_irq_handle_t handle)
  */
 static void send_call(irq_t *irq, call_t *call)
 {
-	irq_spinlock_lock(&irq->notif_cfg.answerbox->irq_lock, false);
-	list_append(&call->ab_link, &irq->notif_cfg.answerbox->irq_notifs);
-	irq_spinlock_unlock(&irq->notif_cfg.answerbox->irq_lock, false);
+	ipc_notif_cfg_t *cfg = &irq->notif_cfg;
+
+	irq_spinlock_lock(&cfg->answerbox->irq_lock, false);
+
+	list_append(&call->ab_link, &cfg->answerbox->irq_notifs);
+
+	/* Further interrupts can be coalesced into the new notification */
+	if (cfg->coalesce >= 2) {
+		if (cfg->pending)
+			cfg->pending->notif_pending = NULL;
 
-	waitq_wakeup(&irq->notif_cfg.answerbox->wq, WAKEUP_FIRST);
+		cfg->pending = call;
+		cfg->pending_count = 1;
+		call->notif_pending = &cfg->pending;
+	}
+
+	irq_spinlock_unlock(&cfg->answerbox->irq_lock, false);
+
+	waitq_wakeup(&cfg->answerbox->wq, WAKEUP_FIRST);
+}
+
+/** Send a notification with the given payload.
+ *
+ * Assume irq->lock is locked and interrupts disabled.
+ *
+ * @param irq  IRQ structure.
+ * @param args Payload arguments.
+ *
+ */
+static void notify(irq_t *irq, const sysarg_t *args)
+{
+	if (coalesce_call(irq, args))
+		return;
+
+	call_t *call = ipc_call_alloc();
+	if (!call)
+		return;
+
+	call->flags |= IPC_CALL_NOTIF;
+	/* Put a counter to the message */
+	call->priv = ++irq->notif_cfg.counter;
+
+	/* Set up args */
+	ipc_set_imethod(&call->data, irq->notif_cfg.imethod);
+	ipc_set_arg1(&call->data, args[0]);
+	ipc_set_arg2(&call->data, args[1]);
+	ipc_set_arg3(&call->data, args[2]);
+	ipc_set_arg4(&call->data, args[3]);
+	ipc_set_arg5(&call->data, args[4]);
+
+	send_call(irq, call);
 }
 
 /** Apply the top-half IRQ code to find out whether to accept the IRQ or not.
@@ -529,23 +672,15 @@ void ipc_irq_top_half_handler(irq_t *irq)
 	assert(irq_spinlock_locked(&irq->lock));
 
 	if (irq->notif_cfg.answerbox) {
-		call_t *call = ipc_call_alloc();
-		if (!call)
-			return;
-
-		call->flags |= IPC_CALL_NOTIF;
-		/* Put a counter to the message */
-		call->priv = ++irq->notif_cfg.counter;
-
-		/* Set up args */
-		ipc_set_imethod(&call->data, irq->notif_cfg.imethod);
-		ipc_set_arg1(&call->data, irq->notif_cfg.scratch[1]);
-		ipc_set_arg2(&call->data, irq->notif_cfg.scratch[2]);
-		ipc_set_arg3(&call->data, irq->notif_cfg.scratch[3]);
-		ipc_set_arg4(&call->data, irq->notif_cfg.scratch[4]);
-		ipc_set_arg5(&call->data, irq->notif_cfg.scratch[5]);
-
-		send_call(irq, call);
+		const sysarg_t args[] = {
+			irq->notif_cfg.scratch[1],
+			irq->notif_cfg.scratch[2],
+			irq->notif_cfg.scratch[3],
+			irq->notif_cfg.scratch[4],
+			irq->notif_cfg.scratch[5]
+		};
+
+		notify(irq, args);
 	}
 }
 
@@ -565,24 +700,8 @@ void ipc_irq_send_msg(irq_t *irq, sysarg_t a1, sysarg_t a2, sysarg_t a3,
 	irq_spinlock_lock(&irq->lock, true);
 
 	if (irq->notif_cfg.answerbox) {
-		call_t *call = ipc_call_alloc();
-		if (!call) {
-			irq_spinlock_unlock(&irq->lock, true);
-			return;
-		}
-
-		call->flags |= IPC_CALL_NOTIF;
-		/* Put a counter to the message */
-		call->priv = ++irq->notif_cfg.counter;
-
-		ipc_set_imethod(&call->data, irq->notif_cfg.imethod);
-		ipc_set_arg1(&call->data, a1);
-		ipc_set_arg2(&call->data, a2);
-		ipc_set_arg3(&call->data, a3);
-		ipc_set_arg4(&call->data, a4);
-		ipc_set_arg5(&call->data, a5);
-
-		send_call(irq, call);
+		const sysarg_t args[] = { a1, a2, a3, a4, a5 };
+		notify(irq, args);
 	}
 
 	irq_spinlock_unlock(&irq->lock, true);
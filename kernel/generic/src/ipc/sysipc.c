@@ -912,6 +912,23 @@ sys_errno_t sys_ipc_irq_unsubscribe(cap_irq_handle_t handle)
 	return 0;
 }
 
+/** Set coalescing of IRQ notifications.
+ *
+ * @param handle  IRQ capability handle.
+ * @param limit   Maximum number of interrupts coalesced into one
+ *                notification, values below two disable coalescing.
+ *
+ * @return Error code.
+ *
+ */
+sys_errno_t sys_ipc_irq_coalesce(cap_irq_handle_t handle, sysarg_t limit)
+{
+	if (!(perm_get(TASK) & PERM_IRQ_REG))
+		return EPERM;
+
+	return ipc_irq_coalesce(&TASK->answerbox, handle, limit);
+}
+
 /** Syscall connect to a task by ID
  *
  * @return Error code.
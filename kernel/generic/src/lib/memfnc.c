@@ -42,6 +42,12 @@
 #include <lib/memfnc.h>
 #include <typedefs.h>
 
+/*
+ * Architectures with CONFIG_ARCH_MEMFNC provide optimized versions
+ * of memset() and memcpy() themselves.
+ */
+#ifndef CONFIG_ARCH_MEMFNC
+
 /** Fill block of memory.
  *
  * Fill cnt bytes at dst address with the value val.
@@ -86,6 +92,8 @@ void *memcpy(void *dst, const void *src, size_t cnt)
 	return dst;
 }
 
+#endif /* CONFIG_ARCH_MEMFNC */
+
 /** Compare two memory areas.
  *
  * @param s1  Pointer to the first area to compare.
@@ -78,6 +78,7 @@
 #endif /* CONFIG_SMP */
 
 #include <synch/waitq.h>
+#include <synch/rcu.h>
 #include <synch/spinlock.h>
 
 #define ALIVE_CHARS  4
@@ -151,6 +152,9 @@ void kinit(void *arg)
 	 */
 	ARCH_OP(post_smp_init);
 
+	/* Start the thread detecting RCU grace periods */
+	rcu_thread_init();
+
 	/* Start thread computing system load */
 	thread = thread_create(kload, NULL, TASK, THREAD_FLAG_NONE,
 	    "kload");
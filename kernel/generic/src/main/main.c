@@ -77,6 +77,8 @@
 #include <mm/reserve.h>
 #include <synch/waitq.h>
 #include <synch/syswaitq.h>
+#include <synch/futex.h>
+#include <synch/rcu.h>
 #include <arch/arch.h>
 #include <arch.h>
 #include <arch/faddr.h>
@@ -275,10 +277,12 @@ void main_bsp_separated_stack(void)
 	clock_counter_init();
 	timeout_init();
 	scheduler_init();
+	rcu_init();
 	caps_init();
 	task_init();
 	thread_init();
 	sys_waitq_init();
+	futex_init();
 
 	sysinfo_set_item_data("boot_args", NULL, bargs, str_size(bargs) + 1);
 
@@ -96,6 +96,11 @@ static slab_cache_t *as_page_mapping_cache;
 /** Cache for used_space_ival_t objects */
 static slab_cache_t *used_space_ival_cache;
 
+/** Mutex classes of address spaces, address space areas and share info */
+static mutex_class_t as_mutex_class = MUTEX_CLASS_INITIALIZER("as");
+static mutex_class_t area_mutex_class = MUTEX_CLASS_INITIALIZER("as_area");
+static mutex_class_t si_mutex_class = MUTEX_CLASS_INITIALIZER("share_info");
+
 /** ASID subsystem lock.
  *
  * This lock protects:
@@ -131,7 +136,7 @@ _NO_TRACE static errno_t as_constructor(void *obj, unsigned int flags)
 	as_t *as = (as_t *) obj;
 
 	link_initialize(&as->inactive_as_with_asid_link);
-	mutex_initialize(&as->lock, MUTEX_PASSIVE);
+	mutex_initialize_class(&as->lock, MUTEX_PASSIVE, &as_mutex_class);
 
 	return as_constructor_arch(as, flags);
 }
@@ -784,7 +789,8 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 		return NULL;
 	}
 
-	mutex_initialize(&area->lock, MUTEX_PASSIVE);
+	mutex_initialize_class(&area->lock, MUTEX_PASSIVE,
+	    &area_mutex_class);
 
 	area->as = as;
 	odlink_initialize(&area->las_areas);
@@ -814,7 +820,8 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 			mutex_unlock(&as->lock);
 			return NULL;
 		}
-		mutex_initialize(&si->lock, MUTEX_PASSIVE);
+		mutex_initialize_class(&si->lock, MUTEX_PASSIVE,
+		    &si_mutex_class);
 		si->refcount = 1;
 		si->shared = false;
 		si->backend_shared_data = NULL;
@@ -53,6 +53,7 @@
 #include <arch/cycle.h>
 #include <atomic.h>
 #include <synch/spinlock.h>
+#include <synch/rcu.h>
 #include <config.h>
 #include <context.h>
 #include <fpu_context.h>
@@ -196,6 +197,13 @@ loop:
 		irq_spinlock_lock(&CPU->lock, false);
 		CPU->idle = true;
 		irq_spinlock_unlock(&CPU->lock, false);
+
+		/*
+		 * An idle processor is in a quiescent state. The periodic
+		 * clock interrupt brings us back here, so the state gets
+		 * noted again even if the processor stays idle.
+		 */
+		rcu_quiescent();
 		interrupts_enable();
 
 		/*
@@ -401,6 +409,12 @@ void scheduler_separated_stack(void)
 	if (old_as)
 		as_hold(old_as);
 
+	/*
+	 * The previous thread has left the processor, so it cannot be in
+	 * an RCU read-side critical section (those must not sleep).
+	 */
+	rcu_quiescent();
+
 	if (THREAD) {
 		/* Must be run after the switch to scheduler stack */
 		after_thread_ran();
@@ -77,6 +77,18 @@ IRQ_SPINLOCK_INITIALIZE(tasks_lock);
  */
 odict_t tasks;
 
+/** Number of buckets of the task hash (must be a power of two) */
+#define TASKS_HASH_SIZE  64
+
+/** Hash table of active tasks by task ID.
+ *
+ * The table contains the same tasks as the @c tasks dictionary. It is
+ * modified with tasks_lock held and can be searched locklessly within
+ * an RCU read-side critical section. The task structures are freed only
+ * after an RCU grace period.
+ */
+static task_t *tasks_hash[TASKS_HASH_SIZE];
+
 static task_id_t task_counter = 0;
 
 static slab_cache_t *task_cache;
@@ -255,11 +267,21 @@ task_t *task_create(as_t *as, const char *name)
 	odlink_initialize(&task->ltasks);
 	odict_insert(&task->ltasks, &tasks, NULL);
 
+	task_t **bucket = &tasks_hash[task->taskid % TASKS_HASH_SIZE];
+	task->hash_next = *bucket;
+	rcu_assign_pointer(*bucket, task);
+
 	irq_spinlock_unlock(&tasks_lock, true);
 
 	return task;
 }
 
+static void task_free_rcu(rcu_item_t *item)
+{
+	task_t *task = member_to_inst(item, task_t, rcu);
+	slab_free(task_cache, task);
+}
+
 /** Destroy task.
  *
  * @param task Task to be destroyed.
@@ -272,6 +294,12 @@ void task_destroy(task_t *task)
 	 */
 	irq_spinlock_lock(&tasks_lock, true);
 	odict_remove(&task->ltasks);
+
+	task_t **pprev = &tasks_hash[task->taskid % TASKS_HASH_SIZE];
+	while (*pprev != task)
+		pprev = &(*pprev)->hash_next;
+	rcu_assign_pointer(*pprev, task->hash_next);
+
 	irq_spinlock_unlock(&tasks_lock, true);
 
 	/*
@@ -284,7 +312,8 @@ void task_destroy(task_t *task)
 	 */
 	as_release(task->as);
 
-	slab_free(task_cache, task);
+	/* Lockless lookups may still be looking at the task structure. */
+	call_rcu(&task->rcu, task_free_rcu);
 }
 
 /** Hold a reference to a task.
@@ -435,6 +464,37 @@ task_t *task_find_by_id(task_id_t id)
 	return NULL;
 }
 
+/** Get reference to task by task ID.
+ *
+ * Unlike task_find_by_id(), this function does not require tasks_lock.
+ * The task is looked up locklessly and returned with a reference held,
+ * which the caller releases using task_release().
+ *
+ * @param id Task ID.
+ *
+ * @return Held task structure or NULL if there is no such task ID.
+ *
+ */
+task_t *task_get_by_id(task_id_t id)
+{
+	rcu_read_lock();
+
+	task_t *task = rcu_dereference(tasks_hash[id % TASKS_HASH_SIZE]);
+	while (task != NULL) {
+		if (task->taskid == id) {
+			/* The task may be just being destroyed. */
+			if (!atomic_inc_not_zero(&task->refcount))
+				task = NULL;
+			break;
+		}
+
+		task = rcu_dereference(task->hash_next);
+	}
+
+	rcu_read_unlock();
+	return task;
+}
+
 /** Get count of tasks.
  *
  * @return Number of tasks in the system
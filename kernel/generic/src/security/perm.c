@@ -88,19 +88,20 @@ static errno_t perm_grant(task_id_t taskid, perm_t perms)
 	if (!(perm_get(TASK) & PERM_PERM))
 		return EPERM;
 
-	irq_spinlock_lock(&tasks_lock, true);
-	task_t *task = task_find_by_id(taskid);
+	task_t *task = task_get_by_id(taskid);
+	if (!task)
+		return ENOENT;
 
-	if ((!task) || (!container_check(CONTAINER, task->container))) {
-		irq_spinlock_unlock(&tasks_lock, true);
+	if (!container_check(CONTAINER, task->container)) {
+		task_release(task);
 		return ENOENT;
 	}
 
-	irq_spinlock_lock(&task->lock, false);
+	irq_spinlock_lock(&task->lock, true);
 	task->perms |= perms;
-	irq_spinlock_unlock(&task->lock, false);
+	irq_spinlock_unlock(&task->lock, true);
 
-	irq_spinlock_unlock(&tasks_lock, true);
+	task_release(task);
 	return EOK;
 }
 
@@ -117,11 +118,12 @@ static errno_t perm_grant(task_id_t taskid, perm_t perms)
  */
 static errno_t perm_revoke(task_id_t taskid, perm_t perms)
 {
-	irq_spinlock_lock(&tasks_lock, true);
+	task_t *task = task_get_by_id(taskid);
+	if (!task)
+		return ENOENT;
 
-	task_t *task = task_find_by_id(taskid);
-	if ((!task) || (!container_check(CONTAINER, task->container))) {
-		irq_spinlock_unlock(&tasks_lock, true);
+	if (!container_check(CONTAINER, task->container)) {
+		task_release(task);
 		return ENOENT;
 	}
 
@@ -130,18 +132,18 @@ static errno_t perm_revoke(task_id_t taskid, perm_t perms)
 	 * a task can revoke permissions from itself even if it
 	 * doesn't have PERM_PERM.
 	 */
-	irq_spinlock_lock(&TASK->lock, false);
+	irq_spinlock_lock(&TASK->lock, true);
 
 	if ((!(TASK->perms & PERM_PERM)) || (task != TASK)) {
-		irq_spinlock_unlock(&TASK->lock, false);
-		irq_spinlock_unlock(&tasks_lock, true);
+		irq_spinlock_unlock(&TASK->lock, true);
+		task_release(task);
 		return EPERM;
 	}
 
 	task->perms &= ~perms;
-	irq_spinlock_unlock(&TASK->lock, false);
+	irq_spinlock_unlock(&TASK->lock, true);
 
-	irq_spinlock_unlock(&tasks_lock, true);
+	task_release(task);
 	return EOK;
 }
 
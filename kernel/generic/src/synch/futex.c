@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Address-keyed user space futexes.
+ *
+ * Unlike wait queues exposed as capabilities (see syswaitq.c), these futexes
+ * need no kernel object. A futex is identified by the physical address of an
+ * integer in user memory, so that it does not matter in which task and at
+ * which virtual address the integer is mapped.
+ *
+ * Threads sleeping on futexes are kept in a fixed array of buckets hashed by
+ * the physical address. Each sleeping thread has a private wait queue on its
+ * stack. Because the waiter is enqueued before the user space value is
+ * checked and the wait queue remembers missed wakeups, no wakeup can be lost
+ * between the check and the sleep.
+ *
+ * Besides waking up a given number of waiters, the waiters can be requeued
+ * from one futex to another without waking them up. This allows condition
+ * variables to move their waiters to the associated mutex on broadcast
+ * instead of waking all of them up at once.
+ */
+
+#include <synch/futex.h>
+#include <synch/spinlock.h>
+#include <synch/waitq.h>
+#include <adt/hash.h>
+#include <adt/list.h>
+#include <abi/synch.h>
+#include <barrier.h>
+#include <mm/page.h>
+#include <proc/task.h>
+#include <syscall/copy.h>
+
+#include <stdint.h>
+
+/** Number of futex buckets (must be a power of two) */
+#define FUTEX_BUCKETS  256
+
+typedef struct {
+	irq_spinlock_t lock;
+	/** List of futex_waiter_t */
+	list_t waiters;
+} futex_bucket_t;
+
+/** Thread sleeping on a futex */
+typedef struct {
+	/** Link to the bucket's list of waiters */
+	link_t link;
+	/** Bucket the waiter is enqueued in (changes on requeue) */
+	futex_bucket_t *bucket;
+	/** Physical address of the futex */
+	uintptr_t key;
+	/** True if the waiter was woken up and removed from the bucket */
+	bool woken;
+	waitq_t wq;
+} futex_waiter_t;
+
+static futex_bucket_t futex_buckets[FUTEX_BUCKETS];
+
+/** Initialize the futex subsystem */
+void futex_init(void)
+{
+	for (size_t i = 0; i < FUTEX_BUCKETS; i++) {
+		irq_spinlock_initialize(&futex_buckets[i].lock, "futex_bucket");
+		list_initialize(&futex_buckets[i].waiters);
+	}
+}
+
+static futex_bucket_t *futex_bucket(uintptr_t key)
+{
+	return &futex_buckets[hash_mix(key) & (FUTEX_BUCKETS - 1)];
+}
+
+/** Translate user space address of a futex to its key
+ *
+ * @param uaddr     User space address of the futex.
+ * @param[out] key  Physical address of the futex.
+ *
+ * @return EOK on success, EINVAL if the address is not aligned, ENOENT if
+ *         there is no memory at the address.
+ */
+static errno_t futex_key(uspace_ptr_int uaddr, uintptr_t *key)
+{
+	if ((uaddr % sizeof(int)) != 0)
+		return EINVAL;
+
+	errno_t rc = page_find_mapping(uaddr, key);
+	if (rc == ENOENT) {
+		/* The page may not have been faulted in yet. */
+		int val;
+		rc = copy_from_uspace(&val, uaddr, sizeof(val));
+		if (rc == EOK)
+			rc = page_find_mapping(uaddr, key);
+	}
+
+	return rc;
+}
+
+/** Lock the bucket of a waiter
+ *
+ * The waiter can be concurrently requeued to a different bucket. This
+ * function makes sure the bucket that is returned locked is the one the
+ * waiter is in.
+ */
+static futex_bucket_t *futex_waiter_lock(futex_waiter_t *waiter)
+{
+	while (true) {
+		futex_bucket_t *bucket = __atomic_load_n(&waiter->bucket,
+		    __ATOMIC_RELAXED);
+
+		irq_spinlock_lock(&bucket->lock, true);
+		if (bucket == waiter->bucket)
+			return bucket;
+		irq_spinlock_unlock(&bucket->lock, true);
+	}
+}
+
+/** Wake up waiters on a futex
+ *
+ * The waiter's wait queue is woken up with the bucket lock held, so that the
+ * waiter cannot leave futex_wait() and deallocate it in the meantime.
+ *
+ * @param bucket  Locked bucket of the futex.
+ * @param key     Key of the futex.
+ * @param count   Maximum number of waiters to wake up.
+ *
+ * @return Number of waiters woken up.
+ */
+static size_t futex_wake_locked(futex_bucket_t *bucket, uintptr_t key,
+    size_t count)
+{
+	size_t woken = 0;
+
+	list_foreach_safe(bucket->waiters, cur, next) {
+		if (woken == count)
+			break;
+
+		futex_waiter_t *waiter = list_get_instance(cur, futex_waiter_t,
+		    link);
+		if (waiter->key != key)
+			continue;
+
+		list_remove(&waiter->link);
+		waiter->woken = true;
+		waitq_wakeup(&waiter->wq, WAKEUP_FIRST);
+		woken++;
+	}
+
+	return woken;
+}
+
+/** Sleep on a futex if it has the expected value
+ *
+ * @param uaddr    User space address of the futex.
+ * @param val      Expected value of the futex.
+ * @param timeout  Timeout in microseconds (0 means no timeout).
+ *
+ * @return EOK if woken up, EAGAIN if the futex did not have the expected
+ *         value, ETIMEOUT or EINTR if the sleep timed out or was
+ *         interrupted, or another error code.
+ */
+sys_errno_t sys_futex_wait(uspace_ptr_int uaddr, int val, uint32_t timeout)
+{
+	futex_waiter_t waiter;
+
+	errno_t rc = futex_key(uaddr, &waiter.key);
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	link_initialize(&waiter.link);
+	waiter.bucket = futex_bucket(waiter.key);
+	waiter.woken = false;
+	waitq_initialize(&waiter.wq);
+
+	irq_spinlock_lock(&waiter.bucket->lock, true);
+	list_append(&waiter.link, &waiter.bucket->waiters);
+	irq_spinlock_unlock(&waiter.bucket->lock, true);
+
+	/*
+	 * Order the enqueueing before reading the value. Any change of the
+	 * value made after the read is followed by a wakeup which finds us
+	 * enqueued.
+	 */
+	memory_barrier();
+
+	int cur;
+	rc = copy_from_uspace(&cur, uaddr, sizeof(cur));
+	if ((rc == EOK) && (cur != val))
+		rc = EAGAIN;
+
+	if (rc == EOK) {
+#ifdef CONFIG_UDEBUG
+		udebug_stoppable_begin();
+#endif
+
+		rc = waitq_sleep_timeout(&waiter.wq, timeout,
+		    SYNCH_FLAGS_INTERRUPTIBLE, NULL);
+
+#ifdef CONFIG_UDEBUG
+		udebug_stoppable_end();
+#endif
+	}
+
+	futex_bucket_t *bucket = futex_waiter_lock(&waiter);
+	if (waiter.woken) {
+		/* We have consumed a wakeup, do not report a failure. */
+		rc = EOK;
+	} else {
+		list_remove(&waiter.link);
+	}
+	irq_spinlock_unlock(&bucket->lock, true);
+
+	return (sys_errno_t) rc;
+}
+
+/** Wake up waiters on a futex
+ *
+ * @param uaddr  User space address of the futex.
+ * @param count  Maximum number of waiters to wake up.
+ *
+ * @return Error code.
+ */
+sys_errno_t sys_futex_wake(uspace_ptr_int uaddr, size_t count)
+{
+	uintptr_t key;
+	errno_t rc = futex_key(uaddr, &key);
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	futex_bucket_t *bucket = futex_bucket(key);
+
+	irq_spinlock_lock(&bucket->lock, true);
+	(void) futex_wake_locked(bucket, key, count);
+	irq_spinlock_unlock(&bucket->lock, true);
+
+	return (sys_errno_t) EOK;
+}
+
+/** Wake up waiters on a futex and move the other waiters to another futex
+ *
+ * @param uaddr    User space address of the futex.
+ * @param wake     Maximum number of waiters to wake up.
+ * @param uaddr2   User space address of the futex to requeue waiters to.
+ * @param requeue  Maximum number of waiters to requeue.
+ *
+ * @return Error code.
+ */
+sys_errno_t sys_futex_requeue(uspace_ptr_int uaddr, size_t wake,
+    uspace_ptr_int uaddr2, size_t requeue)
+{
+	uintptr_t key;
+	errno_t rc = futex_key(uaddr, &key);
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	uintptr_t key2;
+	rc = futex_key(uaddr2, &key2);
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	/* Requeueing to the same futex would not change anything. */
+	if (key2 == key)
+		requeue = 0;
+
+	futex_bucket_t *bucket = futex_bucket(key);
+	futex_bucket_t *bucket2 = futex_bucket(key2);
+
+	/* Lock the buckets in a fixed order to avoid deadlock. */
+	if (bucket < bucket2) {
+		irq_spinlock_lock(&bucket->lock, true);
+		irq_spinlock_lock(&bucket2->lock, false);
+	} else {
+		irq_spinlock_lock(&bucket2->lock, true);
+		if (bucket != bucket2)
+			irq_spinlock_lock(&bucket->lock, false);
+	}
+
+	(void) futex_wake_locked(bucket, key, wake);
+
+	size_t moved = 0;
+	list_foreach_safe(bucket->waiters, cur, next) {
+		if (moved == requeue)
+			break;
+
+		futex_waiter_t *waiter = list_get_instance(cur, futex_waiter_t,
+		    link);
+		if (waiter->key != key)
+			continue;
+
+		list_remove(&waiter->link);
+		waiter->key = key2;
+		__atomic_store_n(&waiter->bucket, bucket2, __ATOMIC_RELAXED);
+		list_append(&waiter->link, &bucket2->waiters);
+		moved++;
+	}
+
+	if (bucket < bucket2) {
+		irq_spinlock_unlock(&bucket2->lock, false);
+		irq_spinlock_unlock(&bucket->lock, true);
+	} else {
+		if (bucket != bucket2)
+			irq_spinlock_unlock(&bucket->lock, false);
+		irq_spinlock_unlock(&bucket2->lock, true);
+	}
+
+	return (sys_errno_t) EOK;
+}
+
+/** @}
+ */
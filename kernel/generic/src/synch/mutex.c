@@ -43,6 +43,25 @@
 #include <stacktrace.h>
 #include <cpu.h>
 #include <proc/thread.h>
+#include <synch/spinlock.h>
+#include <atomic.h>
+#include <barrier.h>
+#include <stdio.h>
+
+/** Class of mutexes which were not assigned a class explicitly. */
+static mutex_class_t default_class = MUTEX_CLASS_INITIALIZER("default");
+
+/** Registered mutex classes. */
+static LIST_INITIALIZE(class_list);
+SPINLOCK_STATIC_INITIALIZE_NAME(class_list_lock, "mutex_class_list_lock");
+
+static void mutex_class_register(mutex_class_t *cls)
+{
+	spinlock_lock(&class_list_lock);
+	if (!link_in_use(&cls->link))
+		list_append(&cls->link, &class_list);
+	spinlock_unlock(&class_list_lock);
+}
 
 /** Initialize mutex.
  *
@@ -50,11 +69,28 @@
  * @param type  Type of the mutex.
  */
 void mutex_initialize(mutex_t *mtx, mutex_type_t type)
+{
+	mutex_initialize_class(mtx, type, &default_class);
+}
+
+/** Initialize mutex belonging to a mutex class.
+ *
+ * @param mtx   Mutex.
+ * @param type  Type of the mutex.
+ * @param cls   Class of the mutex.
+ */
+void mutex_initialize_class(mutex_t *mtx, mutex_type_t type,
+    mutex_class_t *cls)
 {
 	mtx->type = type;
-	mtx->owner = NULL;
+	atomic_init(&mtx->owner, NULL);
 	mtx->nesting = 0;
+	mtx->cls = cls;
 	semaphore_initialize(&mtx->sem, 1);
+
+	/* Avoid taking the lock for classes that are already registered. */
+	if (!link_in_use(&cls->link))
+		mutex_class_register(cls);
 }
 
 /** Find out whether the mutex is currently locked.
@@ -70,6 +106,88 @@ bool mutex_locked(mutex_t *mtx)
 
 #define MUTEX_DEADLOCK_THRESHOLD	100000000
 
+/** Find out whether the owner of a mutex is running on another CPU.
+ *
+ * The fields of the owner are read without locking, the result is only
+ * a hint. Thread structures come from a slab cache, so reading a stale
+ * owner that has meanwhile been destroyed does no harm.
+ */
+static bool mutex_owner_running(thread_t *owner)
+{
+	/* Make sure the fields are read anew in each spin iteration. */
+	compiler_barrier();
+	return (owner->state == Running) && (owner->cpu != CPU);
+}
+
+/** Spin waiting for a passive or recursive mutex.
+ *
+ * Spin as long as the owner of the mutex keeps running on another CPU,
+ * up to the spin limit of the mutex class. Once the owner releases the
+ * mutex, try to acquire it.
+ *
+ * @return True if the mutex was acquired, false if the caller must sleep.
+ */
+static bool mutex_spin(mutex_t *mtx)
+{
+	unsigned int limit = atomic_load_explicit(&mtx->cls->spin_limit,
+	    memory_order_relaxed);
+	unsigned int spins = 0;
+	bool locked = false;
+
+	while (spins < limit) {
+		thread_t *owner = atomic_load_explicit(&mtx->owner,
+		    memory_order_relaxed);
+
+		if (owner == NULL) {
+			/*
+			 * The mutex is being released or the new owner has not
+			 * recorded itself yet.
+			 */
+			if (semaphore_trydown(&mtx->sem) == EOK) {
+				locked = true;
+				break;
+			}
+		} else if (!mutex_owner_running(owner)) {
+			break;
+		}
+
+		spins++;
+	}
+
+	atomic_fetch_add_explicit(&mtx->cls->spins, spins,
+	    memory_order_relaxed);
+	return locked;
+}
+
+/** Acquire a passive or recursive mutex, spinning first if contended.
+ *
+ * @param mtx    Mutex.
+ * @param usec   Timeout in microseconds.
+ * @param flags  Specify mode of operation.
+ *
+ * @return See comment for waitq_sleep_timeout().
+ */
+static errno_t mutex_lock_adaptive(mutex_t *mtx, uint32_t usec,
+    unsigned int flags)
+{
+	/* Conditional locking neither spins nor counts as contention. */
+	if ((flags & SYNCH_FLAGS_NON_BLOCKING) && (usec == SYNCH_NO_TIMEOUT))
+		return _semaphore_down_timeout(&mtx->sem, usec, flags);
+
+	if (semaphore_trydown(&mtx->sem) == EOK)
+		return EOK;
+
+	atomic_inc(&mtx->cls->contended);
+
+	if (mutex_spin(mtx)) {
+		atomic_inc(&mtx->cls->spun);
+		return EOK;
+	}
+
+	atomic_inc(&mtx->cls->slept);
+	return _semaphore_down_timeout(&mtx->sem, usec, flags);
+}
+
 /** Acquire mutex.
  *
  * Timeout mode and non-blocking mode can be requested.
@@ -89,17 +207,23 @@ errno_t _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 	errno_t rc;
 
 	if (mtx->type == MUTEX_PASSIVE && THREAD) {
-		rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+		rc = mutex_lock_adaptive(mtx, usec, flags);
+		if (rc == EOK) {
+			atomic_store_explicit(&mtx->owner, THREAD,
+			    memory_order_relaxed);
+		}
 	} else if (mtx->type == MUTEX_RECURSIVE) {
 		assert(THREAD);
 
-		if (mtx->owner == THREAD) {
+		if (atomic_load_explicit(&mtx->owner, memory_order_relaxed) ==
+		    THREAD) {
 			mtx->nesting++;
 			return EOK;
 		} else {
-			rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+			rc = mutex_lock_adaptive(mtx, usec, flags);
 			if (rc == EOK) {
-				mtx->owner = THREAD;
+				atomic_store_explicit(&mtx->owner, THREAD,
+				    memory_order_relaxed);
 				mtx->nesting = 1;
 			}
 		}
@@ -134,13 +258,63 @@ errno_t _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 void mutex_unlock(mutex_t *mtx)
 {
 	if (mtx->type == MUTEX_RECURSIVE) {
-		assert(mtx->owner == THREAD);
+		assert(atomic_load_explicit(&mtx->owner, memory_order_relaxed) ==
+		    THREAD);
 		if (--mtx->nesting > 0)
 			return;
-		mtx->owner = NULL;
 	}
+
+	if (mtx->type != MUTEX_ACTIVE)
+		atomic_store_explicit(&mtx->owner, NULL, memory_order_relaxed);
+
 	semaphore_up(&mtx->sem);
 }
 
+/** Set spin limit of all mutex classes.
+ *
+ * @param limit  Maximum number of spin iterations of a contended lock
+ *               operation before the thread goes to sleep. Zero disables
+ *               spinning.
+ */
+void mutex_class_set_spin_limit(unsigned int limit)
+{
+	spinlock_lock(&class_list_lock);
+
+	list_foreach(class_list, link, mutex_class_t, cls) {
+		atomic_store_explicit(&cls->spin_limit, limit,
+		    memory_order_relaxed);
+	}
+
+	spinlock_unlock(&class_list_lock);
+}
+
+/** Print contention statistics of all mutex classes. */
+void mutex_class_print_list(void)
+{
+	printf("[class name      ] [spin  ] [contended ] [spun      ]"
+	    " [slept     ] [spins       ]\n");
+
+	/*
+	 * Classes are never unregistered, so it is enough to hold the lock
+	 * while moving to the next class and not while printing.
+	 */
+	spinlock_lock(&class_list_lock);
+	link_t *cur = list_first(&class_list);
+	spinlock_unlock(&class_list_lock);
+
+	while (cur != NULL) {
+		mutex_class_t *cls = list_get_instance(cur, mutex_class_t, link);
+
+		printf("%-18s %8u %12zu %12zu %12zu %14zu\n", cls->name,
+		    atomic_load(&cls->spin_limit), atomic_load(&cls->contended),
+		    atomic_load(&cls->spun), atomic_load(&cls->slept),
+		    atomic_load(&cls->spins));
+
+		spinlock_lock(&class_list_lock);
+		cur = list_next(cur, &class_list);
+		spinlock_unlock(&class_list_lock);
+	}
+}
+
 /** @}
  */
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Read-copy-update.
+ *
+ * Readers access RCU-protected data inside rcu_read_lock() and
+ * rcu_read_unlock() without taking any lock. Updaters unlink an object
+ * and then defer its reclamation using call_rcu() until a grace period
+ * has elapsed, i.e. until every processor has passed through a quiescent
+ * state and therefore no reader can still hold a reference to it.
+ *
+ * Read-side critical sections disable preemption, so entering the
+ * scheduler is a quiescent state. Each processor counts its quiescent
+ * states in rcu_qs. The counter is incremented whenever the scheduler is
+ * entered and whenever an idle processor wakes up (idle processors are
+ * woken up at least by the periodic clock interrupt).
+ *
+ * Callbacks are queued on the processor which calls call_rcu(), so that
+ * frequent callers (e.g. every IPC call releases a kobject) do not contend
+ * on a global lock. The rcu thread collects the queues of all processors
+ * in one batch and is woken up only if it sleeps and a queue becomes
+ * non-empty.
+ *
+ * Grace periods are detected by the rcu thread, which snapshots the
+ * counters of all processors and waits until each of them has changed.
+ * Then it invokes the callbacks which were collected before the snapshot.
+ */
+
+#include <synch/rcu.h>
+#include <synch/spinlock.h>
+#include <synch/waitq.h>
+#include <synch/semaphore.h>
+#include <proc/thread.h>
+#include <atomic.h>
+#include <config.h>
+#include <cpu.h>
+#include <arch.h>
+#include <log.h>
+#include <panic.h>
+#include <stdlib.h>
+
+/** How often the rcu thread checks for quiescent states (microseconds). */
+#define RCU_POLL_USEC  1000
+
+/** Wait queue of the rcu thread. */
+static waitq_t rcu_wq;
+
+/** The rcu thread sleeps or is about to sleep on rcu_wq. */
+static atomic_bool rcu_idle = false;
+
+/** Number of completed grace periods. */
+static atomic_size_t rcu_gp_count = 0;
+
+/** Quiescent state counters of processors at the start of a grace period. */
+static size_t *rcu_qs_snapshot;
+
+typedef struct {
+	rcu_item_t item;
+	semaphore_t done;
+} rcu_sync_t;
+
+/** Note a quiescent state of the current processor.
+ *
+ * Called by the scheduler. The current processor must not be in an RCU
+ * read-side critical section.
+ */
+void rcu_quiescent(void)
+{
+	atomic_fetch_add_explicit(&CPU->rcu_qs, 1, memory_order_release);
+}
+
+/** Wait until all processors pass through a quiescent state. */
+static void rcu_wait_for_readers(void)
+{
+	/* Order the updates preceding the grace period before the snapshot. */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		rcu_qs_snapshot[i] = atomic_load_explicit(&cpus[i].rcu_qs,
+		    memory_order_acquire);
+	}
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		/* Processors which are not running cannot hold references. */
+		while (cpus[i].active &&
+		    atomic_load_explicit(&cpus[i].rcu_qs,
+		    memory_order_acquire) == rcu_qs_snapshot[i])
+			thread_usleep(RCU_POLL_USEC);
+	}
+
+	atomic_thread_fence(memory_order_seq_cst);
+}
+
+/** Move callbacks queued on all processors to a batch.
+ *
+ * @param batch  List to append the callbacks to.
+ */
+static void rcu_collect(list_t *batch)
+{
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_lock(&cpus[i].rcu_lock, true);
+		list_concat(batch, &cpus[i].rcu_pending);
+		irq_spinlock_unlock(&cpus[i].rcu_lock, true);
+	}
+}
+
+/** Body of the rcu thread. */
+static void rcu_thread(void *arg)
+{
+	list_t batch;
+
+	list_initialize(&batch);
+
+	while (true) {
+		rcu_collect(&batch);
+
+		if (list_empty(&batch)) {
+			/*
+			 * Announce the sleep before checking the queues
+			 * again. A callback queued after the check sees
+			 * rcu_idle set and wakes the thread up.
+			 */
+			atomic_store(&rcu_idle, true);
+			rcu_collect(&batch);
+
+			if (list_empty(&batch)) {
+				waitq_sleep(&rcu_wq);
+				continue;
+			}
+
+			atomic_store(&rcu_idle, false);
+		}
+
+		rcu_wait_for_readers();
+		atomic_inc(&rcu_gp_count);
+
+		while (!list_empty(&batch)) {
+			rcu_item_t *item = list_get_instance(list_first(&batch),
+			    rcu_item_t, link);
+			list_remove(&item->link);
+			item->func(item);
+		}
+	}
+}
+
+/** Initialize RCU.
+ *
+ * Callbacks can be queued right after this, but they are not invoked
+ * until the rcu thread is started by rcu_thread_init().
+ */
+void rcu_init(void)
+{
+	waitq_initialize(&rcu_wq);
+}
+
+/** Start the rcu thread.
+ *
+ * Must be called after all processors have been counted.
+ */
+void rcu_thread_init(void)
+{
+	rcu_qs_snapshot = malloc(sizeof(size_t) * config.cpu_count);
+	if (rcu_qs_snapshot == NULL)
+		panic("Unable to allocate RCU state.");
+
+	thread_t *thread = thread_create(rcu_thread, NULL, TASK,
+	    THREAD_FLAG_UNCOUNTED, "rcu");
+	if (thread == NULL)
+		panic("Unable to create rcu thread.");
+
+	thread_detach(thread);
+	thread_ready(thread);
+}
+
+/** Defer a callback until the end of the next grace period.
+ *
+ * Can be called from any context including interrupt handlers and RCU
+ * read-side critical sections. The callback is invoked from the rcu
+ * thread and may sleep.
+ *
+ * @param item  Callback item, usually embedded in the object to be freed.
+ * @param func  Callback function.
+ */
+void call_rcu(rcu_item_t *item, rcu_func_t func)
+{
+	item->func = func;
+	link_initialize(&item->link);
+
+	ipl_t ipl = interrupts_disable();
+	irq_spinlock_lock(&CPU->rcu_lock, false);
+
+	bool first = list_empty(&CPU->rcu_pending);
+	list_append(&item->link, &CPU->rcu_pending);
+
+	irq_spinlock_unlock(&CPU->rcu_lock, false);
+	interrupts_restore(ipl);
+
+	/*
+	 * Until the rcu thread collects this queue, it is either awake or
+	 * it has been woken up by the caller which made the queue non-empty.
+	 */
+	if (!first)
+		return;
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (atomic_load(&rcu_idle) && atomic_exchange(&rcu_idle, false))
+		waitq_wakeup(&rcu_wq, WAKEUP_FIRST);
+}
+
+static void rcu_synchronize_cb(rcu_item_t *item)
+{
+	rcu_sync_t *sync = member_to_inst(item, rcu_sync_t, item);
+	semaphore_up(&sync->done);
+}
+
+/** Wait until a grace period elapses.
+ *
+ * All RCU read-side critical sections that started before the call have
+ * completed when this function returns. Must be called from a context
+ * which can sleep.
+ */
+void rcu_synchronize(void)
+{
+	rcu_sync_t sync;
+
+	semaphore_initialize(&sync.done, 0);
+	call_rcu(&sync.item, rcu_synchronize_cb);
+	semaphore_down(&sync.done);
+}
+
+/** Get the number of completed grace periods. */
+size_t rcu_gp_completed(void)
+{
+	return atomic_load(&rcu_gp_count);
+}
+
+/** @}
+ */
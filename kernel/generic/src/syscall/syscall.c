@@ -47,6 +47,7 @@
 #include <ipc/sysipc.h>
 #include <synch/smc.h>
 #include <synch/syswaitq.h>
+#include <synch/futex.h>
 #include <ddi/ddi.h>
 #include <ipc/event.h>
 #include <security/perm.h>
@@ -77,6 +78,9 @@ static syshandler_t syscall_table[] = {
 	[SYS_WAITQ_SLEEP] = (syshandler_t) sys_waitq_sleep,
 	[SYS_WAITQ_WAKEUP] = (syshandler_t) sys_waitq_wakeup,
 	[SYS_WAITQ_DESTROY] = (syshandler_t) sys_waitq_destroy,
+	[SYS_FUTEX_WAIT] = (syshandler_t) sys_futex_wait,
+	[SYS_FUTEX_WAKE] = (syshandler_t) sys_futex_wake,
+	[SYS_FUTEX_REQUEUE] = (syshandler_t) sys_futex_requeue,
 	[SYS_SMC_COHERENCE] = (syshandler_t) sys_smc_coherence,
 
 	/* Address space related syscalls. */
@@ -120,6 +124,7 @@ static syshandler_t syscall_table[] = {
 
 	[SYS_IPC_IRQ_SUBSCRIBE] = (syshandler_t) sys_ipc_irq_subscribe,
 	[SYS_IPC_IRQ_UNSUBSCRIBE] = (syshandler_t) sys_ipc_irq_unsubscribe,
+	[SYS_IPC_IRQ_COALESCE] = (syshandler_t) sys_ipc_irq_coalesce,
 
 	/* Sysinfo syscalls. */
 	[SYS_SYSINFO_GET_KEYS_SIZE] = (syshandler_t) sys_sysinfo_get_keys_size,
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <typedefs.h>
+#include <arch/cycle.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <syscall/copy.h>
+
+/** Size of the test buffers (largest copy plus room for misalignment) */
+#define BUFFER_SIZE  (65536 + 16)
+
+/** Total number of bytes copied in each measurement */
+#define BYTES_TOTAL  (4 * 1024 * 1024)
+
+/** Minimal number of repetitions of each measurement */
+#define ROUNDS_MIN  64
+
+/** Typical sizes of IPC payloads and syscall arguments */
+static size_t sizes[] = {
+	8, 16, 64, 256, 1024, 4096, 16384, 65536
+};
+
+typedef enum {
+	OP_MEMCPY,
+	OP_MEMSET,
+	OP_COPY_FROM_USPACE,
+	OP_COPY_TO_USPACE
+} op_t;
+
+static const char *op_names[] = {
+	"memcpy",
+	"memset",
+	"memcpy_from_uspace",
+	"memcpy_to_uspace"
+};
+
+static void fill_pattern(uint8_t *buf, size_t size, uint8_t seed)
+{
+	for (size_t i = 0; i < size; i++)
+		buf[i] = (uint8_t) (seed + i * 7);
+}
+
+/** Check that a copy of @a size bytes at all small misalignments is exact.
+ *
+ * Also check that the bytes around the destination are left intact.
+ */
+static const char *verify(op_t op, uint8_t *src, uint8_t *dst, size_t size)
+{
+	for (size_t soff = 0; soff < 8; soff++) {
+		for (size_t doff = 0; doff < 8; doff++) {
+			fill_pattern(src, size + 16, (uint8_t) soff);
+			memset(dst, 0xa5, size + 16);
+
+			uint8_t *d = dst + doff;
+			uint8_t *s = src + soff;
+
+			switch (op) {
+			case OP_MEMCPY:
+				if (memcpy(d, s, size) != d)
+					return "memcpy() returned wrong value";
+				break;
+			case OP_MEMSET:
+				if (memset(d, 0x3c, size) != d)
+					return "memset() returned wrong value";
+				break;
+			case OP_COPY_FROM_USPACE:
+				if (memcpy_from_uspace(d, (uspace_addr_t) s, size) == 0)
+					return "memcpy_from_uspace() failed";
+				break;
+			case OP_COPY_TO_USPACE:
+				if (memcpy_to_uspace((uspace_addr_t) d, s, size) == 0)
+					return "memcpy_to_uspace() failed";
+				break;
+			}
+
+			for (size_t i = 0; i < size; i++) {
+				uint8_t expected = (op == OP_MEMSET) ? 0x3c : s[i];
+				if (d[i] != expected)
+					return "Copied data does not match";
+			}
+
+			for (size_t i = 0; i < doff; i++) {
+				if (dst[i] != 0xa5)
+					return "Data before destination overwritten";
+			}
+
+			for (size_t i = doff + size; i < size + 16; i++) {
+				if (dst[i] != 0xa5)
+					return "Data after destination overwritten";
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void measure(op_t op, uint8_t *src, uint8_t *dst, size_t size)
+{
+	size_t rounds = BYTES_TOTAL / size;
+	if (rounds < ROUNDS_MIN)
+		rounds = ROUNDS_MIN;
+
+	uint64_t start = get_cycle();
+
+	for (size_t i = 0; i < rounds; i++) {
+		switch (op) {
+		case OP_MEMCPY:
+			memcpy(dst, src, size);
+			break;
+		case OP_MEMSET:
+			memset(dst, (int) i, size);
+			break;
+		case OP_COPY_FROM_USPACE:
+			(void) memcpy_from_uspace(dst, (uspace_addr_t) src, size);
+			break;
+		case OP_COPY_TO_USPACE:
+			(void) memcpy_to_uspace((uspace_addr_t) dst, src, size);
+			break;
+		}
+	}
+
+	uint64_t cycles = get_cycle() - start;
+	uint64_t bytes = (uint64_t) rounds * size;
+
+	if (cycles == 0) {
+		TPRINTF("%-20s %6zu B: cycle counter not available\n",
+		    op_names[op], size);
+		return;
+	}
+
+	/* Bytes per cycle in fixed point with two decimal places */
+	uint64_t bpc = (bytes * 100) / cycles;
+
+	TPRINTF("%-20s %6zu B: %" PRIu64 ".%02" PRIu64 " bytes/cycle "
+	    "(%" PRIu64 " cycles/call)\n", op_names[op], size, bpc / 100,
+	    bpc % 100, cycles / rounds);
+}
+
+const char *test_memcpy1(void)
+{
+	/*
+	 * The low-level uspace copy routines (which copy_from_uspace() and
+	 * copy_to_uspace() use after checking the address) are exercised on
+	 * kernel buffers. This only works where the kernel and uspace share
+	 * the address space and no page fault can occur.
+	 */
+#if defined(__i386__) || defined(__x86_64__)
+	op_t op_last = OP_COPY_TO_USPACE;
+#else
+	op_t op_last = OP_MEMSET;
+#endif
+
+	uint8_t *src = malloc(BUFFER_SIZE);
+	uint8_t *dst = malloc(BUFFER_SIZE);
+	if ((src == NULL) || (dst == NULL)) {
+		free(src);
+		free(dst);
+		return "Unable to allocate buffers";
+	}
+
+	const char *err = NULL;
+
+	for (op_t op = OP_MEMCPY; op <= op_last; op++) {
+		for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			/* Verifying large sizes at all offsets would be too slow */
+			if (sizes[i] <= 4096) {
+				err = verify(op, src, dst, sizes[i]);
+				if (err != NULL)
+					goto out;
+			}
+
+			measure(op, src, dst, sizes[i]);
+		}
+	}
+
+out:
+	free(src);
+	free(dst);
+	return err;
+}
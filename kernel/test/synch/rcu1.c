@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <atomic.h>
+#include <arch.h>
+#include <config.h>
+#include <cpu.h>
+#include <proc/task.h>
+#include <proc/thread.h>
+#include <synch/rcu.h>
+#include <synch/spinlock.h>
+#include <stdlib.h>
+
+#define OBJ_MAGIC   0x52435531
+#define OBJ_POISON  0xdeadbeef
+
+/** Number of object replacements in the stress phase */
+#define UPDATES  2000
+
+/** Duration of each throughput measurement (microseconds) */
+#define RUN_USEC  500000
+
+/** Number of reads between checks of the stop flag */
+#define BATCH  1024
+
+typedef struct {
+	uint32_t magic;
+	size_t value;
+	rcu_item_t rcu;
+} obj_t;
+
+typedef enum {
+	MODE_RCU,
+	MODE_SPINLOCK
+} read_mode_t;
+
+typedef struct {
+	read_mode_t mode;
+	size_t reads;
+	size_t errors;
+} reader_t;
+
+static obj_t *shared;
+SPINLOCK_INITIALIZE(shared_lock);
+
+static atomic_t stop;
+static atomic_t freed;
+
+static void obj_free(rcu_item_t *item)
+{
+	obj_t *obj = member_to_inst(item, obj_t, rcu);
+
+	obj->magic = OBJ_POISON;
+	free(obj);
+	atomic_inc(&freed);
+}
+
+static obj_t *obj_create(size_t value)
+{
+	obj_t *obj = malloc(sizeof(obj_t));
+	if (obj) {
+		obj->magic = OBJ_MAGIC;
+		obj->value = value;
+	}
+
+	return obj;
+}
+
+static void reader(void *arg)
+{
+	reader_t *rd = (reader_t *) arg;
+	size_t sum = 0;
+
+	while (!atomic_load(&stop)) {
+		for (size_t i = 0; i < BATCH; i++) {
+			obj_t *obj;
+
+			if (rd->mode == MODE_RCU) {
+				rcu_read_lock();
+				obj = rcu_dereference(shared);
+				if (obj->magic != OBJ_MAGIC)
+					rd->errors++;
+				sum += obj->value;
+				rcu_read_unlock();
+			} else {
+				spinlock_lock(&shared_lock);
+				obj = shared;
+				if (obj->magic != OBJ_MAGIC)
+					rd->errors++;
+				sum += obj->value;
+				spinlock_unlock(&shared_lock);
+			}
+		}
+
+		rd->reads += BATCH;
+	}
+
+	/* Keep the reads from being optimized away. */
+	if (sum == (size_t) -1)
+		rd->errors++;
+}
+
+/** Run one reader wired to each of the first @a count active processors.
+ *
+ * The readers run until @a stop is set. While they run, @a body is
+ * executed in the current thread.
+ */
+static const char *run_readers(read_mode_t mode, size_t count, reader_t *rds,
+    void (*body)(void))
+{
+	thread_t *threads[count];
+	size_t started = 0;
+
+	atomic_store(&stop, 0);
+
+	for (size_t i = 0; (i < config.cpu_count) && (started < count); i++) {
+		if (!cpus[i].active)
+			continue;
+
+		rds[started].mode = mode;
+		rds[started].reads = 0;
+		rds[started].errors = 0;
+
+		thread_t *thread = thread_create(reader, &rds[started], TASK,
+		    THREAD_FLAG_NONE, "rcu1");
+		if (!thread)
+			break;
+
+		thread_wire(thread, &cpus[i]);
+		threads[started++] = thread;
+		thread_ready(thread);
+	}
+
+	body();
+
+	atomic_store(&stop, 1);
+	for (size_t i = 0; i < started; i++) {
+		thread_join(threads[i]);
+		thread_detach(threads[i]);
+	}
+
+	if (started < count)
+		return "Unable to create reader thread";
+
+	for (size_t i = 0; i < started; i++) {
+		if (rds[i].errors > 0)
+			return "Reader saw a reclaimed object";
+	}
+
+	return NULL;
+}
+
+static void update_body(void)
+{
+	for (size_t i = 0; i < UPDATES; i++) {
+		obj_t *obj = obj_create(i);
+		if (!obj)
+			break;
+
+		spinlock_lock(&shared_lock);
+		obj_t *old = shared;
+		rcu_assign_pointer(shared, obj);
+		spinlock_unlock(&shared_lock);
+
+		call_rcu(&old->rcu, obj_free);
+
+		if (i % 64 == 0)
+			thread_usleep(1000);
+	}
+}
+
+static void sleep_body(void)
+{
+	thread_usleep(RUN_USEC);
+}
+
+static size_t active_cpus(void)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		if (cpus[i].active)
+			count++;
+	}
+
+	return count;
+}
+
+static const char *test_task_lookup(void)
+{
+	task_t *task = task_get_by_id(TASK->taskid);
+	if (task != TASK)
+		return "task_get_by_id() did not find the current task";
+	task_release(task);
+
+	task = task_get_by_id((task_id_t) -1);
+	if (task != NULL) {
+		task_release(task);
+		return "task_get_by_id() found a nonexistent task";
+	}
+
+	return NULL;
+}
+
+const char *test_rcu1(void)
+{
+	size_t ncpus = active_cpus();
+	reader_t *rds = malloc(sizeof(reader_t) * ncpus);
+	if (!rds)
+		return "Unable to allocate memory";
+
+	const char *err = test_task_lookup();
+	if (err) {
+		free(rds);
+		return err;
+	}
+
+	shared = obj_create(0);
+	if (!shared) {
+		free(rds);
+		return "Unable to allocate memory";
+	}
+
+	/*
+	 * Stress phase: readers on all processors while the object is being
+	 * replaced and the old copies are reclaimed after grace periods.
+	 */
+	atomic_store(&freed, 0);
+	size_t gp = rcu_gp_completed();
+
+	TPRINTF("Replacing object %u times under %zu readers...\n", UPDATES,
+	    ncpus);
+	err = run_readers(MODE_RCU, ncpus, rds, update_body);
+
+	rcu_synchronize();
+	TPRINTF("Reclaimed %zu objects in %zu grace periods\n",
+	    atomic_load(&freed), rcu_gp_completed() - gp);
+
+	if ((!err) && (atomic_load(&freed) != UPDATES))
+		err = "Not all objects were reclaimed";
+
+	/*
+	 * Throughput phase: compare read-side scaling of RCU with
+	 * a spinlock-protected pointer.
+	 */
+	for (size_t n = 1; (!err) && (n <= ncpus); n++) {
+		size_t total[2] = { 0, 0 };
+
+		for (read_mode_t mode = MODE_RCU; mode <= MODE_SPINLOCK; mode++) {
+			err = run_readers(mode, n, rds, sleep_body);
+			if (err)
+				break;
+
+			for (size_t i = 0; i < n; i++)
+				total[mode] += rds[i].reads;
+		}
+
+		if (!err) {
+			TPRINTF("%zu cpus: rcu %" PRIu64 " reads/s, "
+			    "spinlock %" PRIu64 " reads/s\n", n,
+			    (uint64_t) total[MODE_RCU] * 1000000 / RUN_USEC,
+			    (uint64_t) total[MODE_SPINLOCK] * 1000000 / RUN_USEC);
+		}
+	}
+
+	obj_t *obj = shared;
+	shared = NULL;
+	free(obj);
+	free(rds);
+
+	return err;
+}
@@ -45,8 +45,10 @@ test_t tests[] = {
 #include <mm/falloc1.def>
 #include <mm/falloc2.def>
 #include <mm/mapping1.def>
+#include <mm/memcpy1.def>
 #include <mm/slab1.def>
 #include <mm/slab2.def>
+#include <synch/rcu1.def>
 #include <synch/semaphore1.def>
 #include <synch/semaphore2.def>
 #include <print/print1.def>
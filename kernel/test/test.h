@@ -62,9 +62,11 @@ extern const char *test_fault1(void);
 extern const char *test_falloc1(void);
 extern const char *test_falloc2(void);
 extern const char *test_mapping1(void);
+extern const char *test_memcpy1(void);
 extern const char *test_purge1(void);
 extern const char *test_slab1(void);
 extern const char *test_slab2(void);
+extern const char *test_rcu1(void);
 extern const char *test_semaphore1(void);
 extern const char *test_semaphore2(void);
 extern const char *test_print1(void);
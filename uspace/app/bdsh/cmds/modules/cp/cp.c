@@ -428,17 +428,28 @@ static int copy_file(const char *src, const char *dest,
 	if (vb)
 		printf("%" PRIu64 " bytes to copy\n", total);
 
-	if (NULL == (buff = (char *) malloc(blen))) {
-		printf("Unable to allocate enough memory to read %s\n",
-		    src);
-		rc = ENOMEM;
-		goto out;
+	/* Let VFS and the file systems copy the data without passing them here */
+	aoff64_t copied;
+	while ((aoff64_t) total > posr &&
+	    (rc = vfs_copy_range(fd1, posr, fd2, posw, total - posr,
+	    &copied)) == EOK && copied > 0) {
+		posr += copied;
+		posw += copied;
 	}
 
-	while ((rc = vfs_read(fd1, &posr, buff, blen, &rbytes)) == EOK &&
-	    rbytes > 0) {
-		if ((rc = vfs_write(fd2, &posw, buff, rbytes, &wbytes)) != EOK)
-			break;
+	if (rc == ENOTSUP) {
+		if (NULL == (buff = (char *) malloc(blen))) {
+			printf("Unable to allocate enough memory to read %s\n",
+			    src);
+			rc = ENOMEM;
+			goto out;
+		}
+
+		while ((rc = vfs_read(fd1, &posr, buff, blen, &rbytes)) == EOK &&
+		    rbytes > 0) {
+			if ((rc = vfs_write(fd2, &posw, buff, rbytes, &wbytes)) != EOK)
+				break;
+		}
 	}
 
 	if (rc != EOK) {
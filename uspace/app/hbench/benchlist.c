@@ -38,13 +38,28 @@
 #include "hbench.h"
 
 benchmark_t *benchmarks[] = {
+	&benchmark_block_mix,
+	&benchmark_block_read,
 	&benchmark_dir_read,
 	&benchmark_fibril_mutex,
+	&benchmark_file_append,
+	&benchmark_file_copy,
 	&benchmark_file_read,
+	&benchmark_futex,
+	&benchmark_image_fs,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
+	&benchmark_make_files,
+	&benchmark_memcpy,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_parallel_copy,
+	&benchmark_path_lookup,
+	&benchmark_seq_io,
+	&benchmark_ping_pong,
+	&benchmark_ramdisk_read,
+	&benchmark_random_read,
+	&benchmark_tcp_xfer,
+	&benchmark_udp_irq
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
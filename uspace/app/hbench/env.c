@@ -141,5 +141,26 @@ const char *bench_env_param_get(bench_env_t *env, const char *key, const char *d
 	return param->value;
 }
 
+/** Get numeric benchmark parameter.
+ *
+ * @param env Benchmark environment.
+ * @param key Parameter name.
+ * @param default_value Value to use when the parameter is not set.
+ * @param value Place to store the parameter value.
+ * @return EOK on success, EINVAL if the parameter is not a number.
+ */
+errno_t bench_env_param_get_uint64(bench_env_t *env, const char *key,
+    uint64_t default_value, uint64_t *value)
+{
+	const char *str = bench_env_param_get(env, key, NULL);
+
+	if (str == NULL) {
+		*value = default_value;
+		return EOK;
+	}
+
+	return str_uint64_t(str, NULL, 0, true, value);
+}
+
 /** @}
  */
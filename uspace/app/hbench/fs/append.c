@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Grows a file from zero to the given size by small appends, which
+ * measures how the cost of extending a file depends on its size.
+ * Each iteration truncates the file and appends to it again.
+ *
+ * Parameters:
+ *  - filename: file to append to (created by the setup)
+ *  - file_size: size the file grows to in bytes (default 1 MiB),
+ *    sizes from 1 MiB to 1 GiB are of interest
+ *  - chunk: size of each append in bytes (default 4 KiB)
+ */
+
+static const char *path;
+static uint64_t file_size;
+static uint64_t chunk;
+static char *buf;
+static int fd = -1;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	path = bench_env_param_get(env, "filename", "/tmp/hbench_append");
+
+	errno_t rc = bench_env_param_get_uint64(env, "file_size", 1024 * 1024,
+	    &file_size);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid file_size: %s", str_error(rc));
+
+	rc = bench_env_param_get_uint64(env, "chunk", 4 * 1024, &chunk);
+	if (rc != EOK || chunk == 0)
+		return bench_run_fail(run, "invalid chunk: %s", str_error(rc));
+
+	buf = malloc(chunk);
+	if (buf == NULL)
+		return bench_run_fail(run, "failed to allocate %" PRIu64 "B", chunk);
+
+	memset(buf, 'x', chunk);
+
+	rc = vfs_lookup_open(path, WALK_REGULAR | WALK_MAY_CREATE, MODE_WRITE,
+	    &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s: %s", path,
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		errno_t rc = vfs_resize(fd, 0);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to truncate %s: %s",
+			    path, str_error(rc));
+		}
+
+		aoff64_t pos = 0;
+		while (pos < file_size) {
+			size_t nwritten;
+			size_t n = min(chunk, file_size - pos);
+			rc = vfs_write(fd, &pos, buf, n, &nwritten);
+			if (rc != EOK) {
+				return bench_run_fail(run,
+				    "failed to append to %s: %s", path,
+				    str_error(rc));
+			}
+		}
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	free(buf);
+	buf = NULL;
+
+	if (fd >= 0) {
+		vfs_put(fd);
+		fd = -1;
+	}
+
+	errno_t rc = vfs_unlink_path(path);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to remove %s: %s", path,
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_file_append = {
+	.name = "file_append",
+	.desc = "Grow a file by small appends (use 'filename', 'file_size' and 'chunk' params to alter the defaults, sweep 'file_size' from 1M to 1G).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
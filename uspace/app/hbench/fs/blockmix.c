@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <block.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <loc.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <task.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Runs a mix of sequential and random block requests from several fibrils
+ * against a file-backed disk, going through the libblock I/O scheduler.
+ * The disk image is created and attached with file_bd by the setup.
+ *
+ * Parameters:
+ *  - image: disk image to use (created by the setup)
+ *  - disk_size: size of the disk in bytes (default 32 MiB)
+ *  - policy: none, fifo, elevator or deadline (default deadline)
+ *  - depth: requests outstanding at the device (default 1)
+ *  - fibrils: number of fibrils issuing requests (default 8)
+ *  - seq_pct: percentage of fibrils reading sequentially (default 50)
+ *  - write_pct: percentage of requests which are writes (default 25)
+ *  - chunk: blocks per request (default 8)
+ */
+
+#define FILE_BD "/srv/bd/file_bd"
+#define BLOCK_MIX_SVC "bd/hbench_mix"
+
+/** Fibril issuing requests */
+typedef struct {
+	/** Buffer for one request */
+	void *buf;
+	/** Issue sequential requests */
+	bool sequential;
+	/** Next block for sequential requests */
+	aoff64_t next;
+	/** Random generator state */
+	uint64_t seed;
+	/** Number of requests to issue */
+	uint64_t count;
+} mix_fibril_t;
+
+static const char *image;
+static uint64_t disk_size;
+static uint64_t nfibrils;
+static uint64_t seq_pct;
+static uint64_t write_pct;
+static uint64_t chunk;
+static mix_fibril_t *fibrils;
+static service_id_t svc_id;
+static task_id_t filebd_id;
+static bool filebd_running;
+static bool block_inited;
+static size_t bsize;
+static aoff64_t nchunks;
+
+static FIBRIL_MUTEX_INITIALIZE(mix_lock);
+static FIBRIL_CONDVAR_INITIALIZE(mix_cv);
+static uint64_t mix_running;
+static errno_t mix_rc;
+
+/** Simple xorshift generator, stable across runs. */
+static uint64_t next_random(uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+	return *seed;
+}
+
+static errno_t mix_fibril(void *arg)
+{
+	mix_fibril_t *f = (mix_fibril_t *) arg;
+	errno_t rc = EOK;
+
+	for (uint64_t i = 0; i < f->count; i++) {
+		uint64_t r = next_random(&f->seed);
+		aoff64_t ba;
+
+		if (f->sequential) {
+			ba = f->next;
+			f->next = (f->next + chunk) % (nchunks * chunk);
+		} else {
+			ba = (r % nchunks) * chunk;
+		}
+
+		if ((r >> 32) % 100 < write_pct)
+			rc = block_write_direct(svc_id, ba, chunk, f->buf);
+		else
+			rc = block_read_direct(svc_id, ba, chunk, f->buf);
+		if (rc != EOK)
+			break;
+	}
+
+	fibril_mutex_lock(&mix_lock);
+	if (rc != EOK)
+		mix_rc = rc;
+	mix_running--;
+	fibril_condvar_broadcast(&mix_cv);
+	fibril_mutex_unlock(&mix_lock);
+	return EOK;
+}
+
+static bool create_image(bench_run_t *run)
+{
+	size_t bufsize = 64 * 1024;
+	char *buf;
+	int fd;
+
+	buf = calloc(1, bufsize);
+	if (buf == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	errno_t rc = vfs_lookup_open(image, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK) {
+		free(buf);
+		return bench_run_fail(run, "failed to create %s: %s", image,
+		    str_error(rc));
+	}
+
+	aoff64_t pos = 0;
+	while (pos < disk_size) {
+		size_t nwritten;
+		rc = vfs_write(fd, &pos, buf, min(bufsize, disk_size - pos),
+		    &nwritten);
+		if (rc != EOK) {
+			vfs_put(fd);
+			free(buf);
+			return bench_run_fail(run, "failed to write to %s: %s",
+			    image, str_error(rc));
+		}
+	}
+
+	vfs_put(fd);
+	free(buf);
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	block_sched_policy_t policy;
+	uint64_t depth;
+	task_wait_t wait;
+	task_exit_t texit;
+	int retval;
+	aoff64_t nblocks;
+
+	image = bench_env_param_get(env, "image", "/tmp/hbench_blockmix.img");
+
+	errno_t rc = bench_env_param_get_uint64(env, "disk_size",
+	    32 * 1024 * 1024, &disk_size);
+	if (rc != EOK || disk_size == 0)
+		return bench_run_fail(run, "invalid disk_size");
+
+	const char *pname = bench_env_param_get(env, "policy", "deadline");
+	if (str_cmp(pname, "none") == 0)
+		policy = BLOCK_SCHED_NONE;
+	else if (str_cmp(pname, "fifo") == 0)
+		policy = BLOCK_SCHED_FIFO;
+	else if (str_cmp(pname, "elevator") == 0)
+		policy = BLOCK_SCHED_ELEVATOR;
+	else if (str_cmp(pname, "deadline") == 0)
+		policy = BLOCK_SCHED_DEADLINE;
+	else
+		return bench_run_fail(run, "invalid policy '%s'", pname);
+
+	rc = bench_env_param_get_uint64(env, "depth", 1, &depth);
+	if (rc != EOK || depth == 0)
+		return bench_run_fail(run, "invalid depth");
+
+	rc = bench_env_param_get_uint64(env, "fibrils", 8, &nfibrils);
+	if (rc != EOK || nfibrils == 0)
+		return bench_run_fail(run, "invalid number of fibrils");
+
+	rc = bench_env_param_get_uint64(env, "seq_pct", 50, &seq_pct);
+	if (rc != EOK || seq_pct > 100)
+		return bench_run_fail(run, "invalid seq_pct");
+
+	rc = bench_env_param_get_uint64(env, "write_pct", 25, &write_pct);
+	if (rc != EOK || write_pct > 100)
+		return bench_run_fail(run, "invalid write_pct");
+
+	rc = bench_env_param_get_uint64(env, "chunk", 8, &chunk);
+	if (rc != EOK || chunk == 0)
+		return bench_run_fail(run, "invalid chunk");
+
+	if (!create_image(run))
+		return false;
+
+	rc = task_spawnl(&filebd_id, &wait, FILE_BD, FILE_BD, image,
+	    BLOCK_MIX_SVC, NULL);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to start " FILE_BD ": %s",
+		    str_error(rc));
+	}
+
+	rc = task_wait(&wait, &texit, &retval);
+	if (rc != EOK || texit != TASK_EXIT_NORMAL || retval != 0)
+		return bench_run_fail(run, FILE_BD " failed to start");
+
+	filebd_running = true;
+
+	rc = loc_service_get_id(BLOCK_MIX_SVC, &svc_id, IPC_FLAG_BLOCKING);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to find " BLOCK_MIX_SVC
+		    ": %s", str_error(rc));
+	}
+
+	rc = block_init(svc_id, 4096);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open " BLOCK_MIX_SVC
+		    ": %s", str_error(rc));
+	}
+
+	block_inited = true;
+
+	rc = block_get_bsize(svc_id, &bsize);
+	if (rc == EOK)
+		rc = block_get_nblocks(svc_id, &nblocks);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to query " BLOCK_MIX_SVC
+		    ": %s", str_error(rc));
+	}
+
+	nchunks = nblocks / chunk;
+	if (nchunks == 0)
+		return bench_run_fail(run, "chunk larger than the disk");
+
+	rc = block_sched_set(svc_id, policy, depth);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to set scheduling: %s",
+		    str_error(rc));
+	}
+
+	fibrils = calloc(nfibrils, sizeof(mix_fibril_t));
+	if (fibrils == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	for (uint64_t i = 0; i < nfibrils; i++) {
+		fibrils[i].buf = calloc(chunk, bsize);
+		if (fibrils[i].buf == NULL)
+			return bench_run_fail(run, "out of memory");
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	uint64_t nseq = nfibrils * seq_pct / 100;
+
+	mix_rc = EOK;
+	mix_running = 0;
+
+	for (uint64_t i = 0; i < nfibrils; i++) {
+		mix_fibril_t *f = &fibrils[i];
+
+		f->seed = 0x2545f4914f6cdd1dULL + i;
+		f->sequential = i < nseq;
+		f->next = (nchunks * i / nfibrils) * chunk;
+		f->count = size / nfibrils + (i < size % nfibrils ? 1 : 0);
+	}
+
+	bench_run_start(run);
+
+	for (uint64_t i = 0; i < nfibrils; i++) {
+		fid_t fid = fibril_create(mix_fibril, &fibrils[i]);
+		if (fid == 0) {
+			fibril_mutex_lock(&mix_lock);
+			mix_rc = ENOMEM;
+			fibril_mutex_unlock(&mix_lock);
+			break;
+		}
+
+		fibril_mutex_lock(&mix_lock);
+		mix_running++;
+		fibril_mutex_unlock(&mix_lock);
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&mix_lock);
+	while (mix_running > 0)
+		fibril_condvar_wait(&mix_cv, &mix_lock);
+	fibril_mutex_unlock(&mix_lock);
+
+	bench_run_stop(run);
+
+	if (mix_rc != EOK) {
+		return bench_run_fail(run, "block request failed: %s",
+		    str_error(mix_rc));
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	bool ok = true;
+
+	if (fibrils != NULL) {
+		for (uint64_t i = 0; i < nfibrils; i++)
+			free(fibrils[i].buf);
+		free(fibrils);
+		fibrils = NULL;
+	}
+
+	if (block_inited) {
+		block_fini(svc_id);
+		block_inited = false;
+	}
+
+	if (filebd_running) {
+		(void) task_kill(filebd_id);
+		filebd_running = false;
+	}
+
+	errno_t rc = vfs_unlink_path(image);
+	if (rc != EOK) {
+		ok = bench_run_fail(run, "failed to remove %s: %s", image,
+		    str_error(rc));
+	}
+
+	return ok;
+}
+
+benchmark_t benchmark_block_mix = {
+	.name = "block_mix",
+	.desc = "Mixed sequential and random block requests on a file-backed disk (use 'policy', 'depth', 'fibrils', 'seq_pct', 'write_pct' and 'chunk' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <block.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
+#include <loc.h>
+#include <stats.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Reads from a block device with several requests in flight, measuring
+ * raw throughput of the driver. Each request is issued by its own fibril
+ * through libblock, which keeps up to 'depth' requests outstanding at the
+ * device. The device is only read from. The share of CPU cycles spent
+ * busy while reading is printed at the end, so that drivers moving the
+ * same amount of data can be compared by their CPU cost as well.
+ *
+ * Parameters:
+ *  - device: block device service to read (e.g. a virtio-blk disk; required)
+ *  - chunk: size of a single request in bytes (default 64 KiB)
+ *  - depth: number of requests in flight (default 4)
+ *  - pattern: seq or random (default seq)
+ */
+
+static const char *device;
+static service_id_t svc_id;
+static bool block_inited;
+static uint64_t chunk;
+static uint64_t depth;
+static bool random_pattern;
+static size_t bsize;
+static size_t chunk_blocks;
+static aoff64_t nchunks;
+static void **bufs;
+
+static FIBRIL_MUTEX_INITIALIZE(read_lock);
+static FIBRIL_CONDVAR_INITIALIZE(read_cv);
+static uint64_t read_running;
+static uint64_t read_left;
+static aoff64_t read_next;
+static errno_t read_rc;
+static uint64_t seed;
+static uint64_t busy_cycles;
+static uint64_t idle_cycles;
+
+/** Sum busy and idle cycles of all active CPUs. */
+static void cpu_cycles_get(uint64_t *busy, uint64_t *idle)
+{
+	size_t count;
+	stats_cpu_t *cpus = stats_get_cpus(&count);
+
+	*busy = 0;
+	*idle = 0;
+
+	if (cpus == NULL)
+		return;
+
+	for (size_t i = 0; i < count; i++) {
+		if (cpus[i].active) {
+			*busy += cpus[i].busy_cycles;
+			*idle += cpus[i].idle_cycles;
+		}
+	}
+
+	free(cpus);
+}
+
+/** Simple xorshift generator, stable across runs. */
+static uint64_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+	return seed;
+}
+
+static errno_t read_fibril(void *arg)
+{
+	void *buf = arg;
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&read_lock);
+
+	while (read_left > 0 && read_rc == EOK) {
+		aoff64_t idx;
+
+		read_left--;
+		if (random_pattern) {
+			idx = next_random() % nchunks;
+		} else {
+			idx = read_next;
+			read_next = (read_next + 1) % nchunks;
+		}
+
+		fibril_mutex_unlock(&read_lock);
+		rc = block_read_direct(svc_id, idx * chunk_blocks, chunk_blocks,
+		    buf);
+		fibril_mutex_lock(&read_lock);
+
+		if (rc != EOK)
+			read_rc = rc;
+	}
+
+	read_running--;
+	fibril_condvar_broadcast(&read_cv);
+	fibril_mutex_unlock(&read_lock);
+	return EOK;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	aoff64_t nblocks;
+
+	device = bench_env_param_get(env, "device", NULL);
+	if (device == NULL)
+		return bench_run_fail(run, "missing 'device' parameter");
+
+	errno_t rc = bench_env_param_get_uint64(env, "chunk", 64 * 1024,
+	    &chunk);
+	if (rc != EOK || chunk == 0)
+		return bench_run_fail(run, "invalid chunk");
+
+	rc = bench_env_param_get_uint64(env, "depth", 4, &depth);
+	if (rc != EOK || depth == 0)
+		return bench_run_fail(run, "invalid depth");
+
+	const char *pattern = bench_env_param_get(env, "pattern", "seq");
+	if (str_cmp(pattern, "seq") == 0)
+		random_pattern = false;
+	else if (str_cmp(pattern, "random") == 0)
+		random_pattern = true;
+	else
+		return bench_run_fail(run, "invalid pattern '%s'", pattern);
+
+	rc = loc_service_get_id(device, &svc_id, 0);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to find %s: %s", device,
+		    str_error(rc));
+	}
+
+	rc = block_init(svc_id, 4096);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s: %s", device,
+		    str_error(rc));
+	}
+
+	block_inited = true;
+
+	rc = block_get_bsize(svc_id, &bsize);
+	if (rc == EOK)
+		rc = block_get_nblocks(svc_id, &nblocks);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to query %s: %s", device,
+		    str_error(rc));
+	}
+
+	if (chunk % bsize != 0) {
+		return bench_run_fail(run, "chunk is not a multiple of the "
+		    "block size (%zu)", bsize);
+	}
+
+	chunk_blocks = chunk / bsize;
+	nchunks = nblocks / chunk_blocks;
+	if (nchunks == 0)
+		return bench_run_fail(run, "chunk larger than the device");
+
+	/* Queue requests so that several can be outstanding at the device */
+	rc = block_sched_set(svc_id, depth > 1 ? BLOCK_SCHED_FIFO :
+	    BLOCK_SCHED_NONE, depth);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to set scheduling: %s",
+		    str_error(rc));
+	}
+
+	bufs = calloc(depth, sizeof(void *));
+	if (bufs == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	for (uint64_t i = 0; i < depth; i++) {
+		bufs[i] = malloc(chunk);
+		if (bufs[i] == NULL)
+			return bench_run_fail(run, "out of memory");
+	}
+
+	seed = 0x2545f4914f6cdd1dULL;
+	busy_cycles = 0;
+	idle_cycles = 0;
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	uint64_t busy0, idle0, busy1, idle1;
+
+	read_rc = EOK;
+	read_left = size;
+	read_next = 0;
+	read_running = 0;
+
+	cpu_cycles_get(&busy0, &idle0);
+	bench_run_start(run);
+
+	for (uint64_t i = 0; i < depth; i++) {
+		fid_t fid = fibril_create(read_fibril, bufs[i]);
+		if (fid == 0) {
+			fibril_mutex_lock(&read_lock);
+			read_rc = ENOMEM;
+			fibril_mutex_unlock(&read_lock);
+			break;
+		}
+
+		fibril_mutex_lock(&read_lock);
+		read_running++;
+		fibril_mutex_unlock(&read_lock);
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&read_lock);
+	while (read_running > 0)
+		fibril_condvar_wait(&read_cv, &read_lock);
+	fibril_mutex_unlock(&read_lock);
+
+	bench_run_stop(run);
+	cpu_cycles_get(&busy1, &idle1);
+
+	busy_cycles += busy1 - busy0;
+	idle_cycles += idle1 - idle0;
+
+	if (read_rc != EOK) {
+		return bench_run_fail(run, "failed to read from %s: %s",
+		    device, str_error(read_rc));
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (busy_cycles + idle_cycles > 0) {
+		printf("CPU usage: %" PRIu64 "%% busy while reading.\n",
+		    busy_cycles * 100 / (busy_cycles + idle_cycles));
+	}
+
+	if (bufs != NULL) {
+		for (uint64_t i = 0; i < depth; i++)
+			free(bufs[i]);
+		free(bufs);
+		bufs = NULL;
+	}
+
+	if (block_inited) {
+		block_fini(svc_id);
+		block_inited = false;
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_block_read = {
+	.name = "block_read",
+	.desc = "Read from a block device with several requests in flight (set the 'device' param; use 'chunk', 'depth' and 'pattern' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <vfs/aio.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Copies a file with a given number of reads and writes in flight,
+ * submitted by a single fibril through the asynchronous VFS interface.
+ * With depth 1 this is the classic copy loop, higher depths show how
+ * well the file system and the device overlap requests.
+ *
+ * Parameters:
+ *  - filename: file to copy (created by the setup)
+ *  - dest: file to copy to (removed by the teardown)
+ *  - file_size: size of the copied file in bytes (default 8 MiB)
+ *  - chunk: size of each read and write in bytes (default 64 KiB)
+ *  - depth: number of chunks in flight (default 8)
+ */
+
+/** Chunk of the file being copied */
+typedef struct {
+	/** Buffer with the data */
+	char *buf;
+	/** Position of the start of the buffer in the file */
+	aoff64_t pos;
+	/** Bytes of the chunk not yet read */
+	size_t len;
+	/** Bytes read into the buffer */
+	size_t nread;
+	/** Bytes written from the buffer */
+	size_t nwritten;
+	/** The chunk is being written */
+	bool writing;
+} copy_slot_t;
+
+static const char *src_path;
+static const char *dst_path;
+static uint64_t file_size;
+static uint64_t chunk;
+static uint64_t depth;
+static copy_slot_t *slots;
+static aoff64_t next_pos;
+static int src_fd = -1;
+static int dst_fd = -1;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	src_path = bench_env_param_get(env, "filename", "/tmp/hbench_copy_src");
+	dst_path = bench_env_param_get(env, "dest", "/tmp/hbench_copy_dst");
+
+	errno_t rc = bench_env_param_get_uint64(env, "file_size",
+	    8 * 1024 * 1024, &file_size);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid file_size: %s", str_error(rc));
+
+	rc = bench_env_param_get_uint64(env, "chunk", 64 * 1024, &chunk);
+	if (rc != EOK || chunk == 0)
+		return bench_run_fail(run, "invalid chunk: %s", str_error(rc));
+
+	rc = bench_env_param_get_uint64(env, "depth", 8, &depth);
+	if (rc != EOK || depth == 0)
+		return bench_run_fail(run, "invalid depth: %s", str_error(rc));
+
+	slots = calloc(depth, sizeof(copy_slot_t));
+	if (slots == NULL)
+		return bench_run_fail(run, "failed to allocate slots");
+
+	for (uint64_t i = 0; i < depth; i++) {
+		slots[i].buf = malloc(chunk);
+		if (slots[i].buf == NULL) {
+			return bench_run_fail(run, "failed to allocate %" PRIu64 "B",
+			    chunk);
+		}
+
+		memset(slots[i].buf, 'x', chunk);
+	}
+
+	rc = vfs_lookup_open(src_path, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_READ | MODE_WRITE, &src_fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s: %s", src_path,
+		    str_error(rc));
+	}
+
+	rc = vfs_resize(src_fd, 0);
+	aoff64_t pos = 0;
+	while (rc == EOK && pos < file_size) {
+		size_t nwritten;
+		rc = vfs_write(src_fd, &pos, slots[0].buf,
+		    min(chunk, file_size - pos), &nwritten);
+	}
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to fill %s: %s", src_path,
+		    str_error(rc));
+	}
+
+	rc = vfs_lookup_open(dst_path, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &dst_fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s: %s", dst_path,
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+/** Start copying the next chunk of the file using a slot.
+ *
+ * @param queue Queue for the requests
+ * @param slot  Free slot
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t copy_chunk_start(vfs_aio_queue_t *queue, copy_slot_t *slot)
+{
+	if (next_pos >= file_size)
+		return EOK;
+
+	slot->pos = next_pos;
+	slot->len = min(chunk, file_size - next_pos);
+	slot->writing = false;
+	next_pos += slot->len;
+
+	return vfs_read_async(queue, src_fd, slot->pos, slot->buf, slot->len,
+	    slot);
+}
+
+/** Advance the copy of a chunk after one of its requests completed.
+ *
+ * @param queue Queue for the requests
+ * @param comp  Completion of the request
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t copy_chunk_continue(vfs_aio_queue_t *queue,
+    vfs_aio_completion_t *comp)
+{
+	copy_slot_t *slot = (copy_slot_t *) comp->arg;
+
+	if (comp->rc != EOK)
+		return comp->rc;
+
+	if (comp->nbytes == 0)
+		return EIO;
+
+	if (!slot->writing) {
+		/* Write whatever was read */
+		slot->writing = true;
+		slot->nread = comp->nbytes;
+		slot->nwritten = 0;
+		return vfs_write_async(queue, dst_fd, slot->pos, slot->buf,
+		    slot->nread, slot);
+	}
+
+	slot->nwritten += comp->nbytes;
+	if (slot->nwritten < slot->nread) {
+		return vfs_write_async(queue, dst_fd,
+		    slot->pos + slot->nwritten, slot->buf + slot->nwritten,
+		    slot->nread - slot->nwritten, slot);
+	}
+
+	/* Read the rest of a chunk after a short read */
+	slot->pos += slot->nread;
+	slot->len -= slot->nread;
+	if (slot->len > 0) {
+		slot->writing = false;
+		return vfs_read_async(queue, src_fd, slot->pos, slot->buf,
+		    slot->len, slot);
+	}
+
+	return copy_chunk_start(queue, slot);
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	vfs_aio_queue_t *queue;
+	errno_t rc = vfs_aio_queue_create(&queue);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to create queue: %s",
+		    str_error(rc));
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		rc = vfs_resize(dst_fd, 0);
+		if (rc != EOK)
+			break;
+
+		next_pos = 0;
+		for (uint64_t j = 0; j < depth && rc == EOK; j++)
+			rc = copy_chunk_start(queue, &slots[j]);
+
+		vfs_aio_completion_t comp;
+		while (rc == EOK && vfs_aio_wait(queue, 0, &comp) == EOK)
+			rc = copy_chunk_continue(queue, &comp);
+
+		if (rc != EOK)
+			break;
+	}
+	bench_run_stop(run);
+
+	/* Wait for the requests still in flight after a failure */
+	vfs_aio_queue_destroy(queue);
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to copy %s to %s: %s",
+		    src_path, dst_path, str_error(rc));
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	bool ok = true;
+
+	if (slots != NULL) {
+		for (uint64_t i = 0; i < depth; i++)
+			free(slots[i].buf);
+		free(slots);
+		slots = NULL;
+	}
+
+	if (src_fd >= 0) {
+		vfs_put(src_fd);
+		src_fd = -1;
+		if (vfs_unlink_path(src_path) != EOK)
+			ok = bench_run_fail(run, "failed to remove %s", src_path);
+	}
+
+	if (dst_fd >= 0) {
+		vfs_put(dst_fd);
+		dst_fd = -1;
+		if (vfs_unlink_path(dst_path) != EOK)
+			ok = bench_run_fail(run, "failed to remove %s", dst_path);
+	}
+
+	return ok;
+}
+
+benchmark_t benchmark_parallel_copy = {
+	.name = "parallel_copy",
+	.desc = "Copy a file with several requests in flight (use 'filename', 'dest', 'file_size', 'chunk' and 'depth' params to alter the defaults, compare 'depth' 1 against higher values).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
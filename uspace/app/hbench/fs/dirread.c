@@ -32,11 +32,93 @@
  */
 
 #include <dirent.h>
+#include <errno.h>
+#include <str.h>
 #include <str_error.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <vfs/vfs.h>
 #include "../hbench.h"
 
+/*
+ * Parameters:
+ *  - dirname: directory to list (default /)
+ *  - mode: 'names' reads only the names with readdir(), 'stat' also stats
+ *    every entry (the way 'ls -l' does), 'batch' reads the entries with
+ *    their attributes using vfs_readdir() (default 'names')
+ */
+
+/** Size of the buffer for vfs_readdir() */
+#define BATCH_SIZE (16 * 1024)
+
+typedef enum {
+	MODE_NAMES,
+	MODE_STAT,
+	MODE_BATCH
+} dir_read_mode_t;
+
+static uint8_t batch[BATCH_SIZE];
+
+static bool list_readdir(bench_run_t *run, const char *path, bool stat)
+{
+	DIR *dir = opendir(path);
+	if (dir == NULL) {
+		return bench_run_fail(run, "failed to open %s for reading: %s",
+		    path, str_error(errno));
+	}
+
+	struct dirent *dp;
+	while ((dp = readdir(dir))) {
+		if (!stat)
+			continue;
+
+		char *name;
+		if (asprintf(&name, "%s/%s", path, dp->d_name) < 0) {
+			closedir(dir);
+			return bench_run_fail(run, "out of memory");
+		}
+
+		vfs_stat_t st;
+		errno_t rc = vfs_stat_path(name, &st);
+		free(name);
+		if (rc != EOK) {
+			closedir(dir);
+			return bench_run_fail(run, "failed to stat %s/%s: %s",
+			    path, dp->d_name, str_error(rc));
+		}
+	}
+
+	closedir(dir);
+	return true;
+}
+
+static bool list_batch(bench_run_t *run, const char *path)
+{
+	int fd;
+	errno_t rc = vfs_lookup_open(path, WALK_DIRECTORY, MODE_READ, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s for reading: %s",
+		    path, str_error(rc));
+	}
+
+	aoff64_t pos = 0;
+	while (true) {
+		size_t nread;
+		rc = vfs_readdir(fd, &pos, batch, sizeof(batch), &nread);
+		if (rc != EOK) {
+			vfs_put(fd);
+			return bench_run_fail(run, "failed to read %s: %s",
+			    path, str_error(rc));
+		}
+
+		if (nread == 0)
+			break;
+	}
+
+	vfs_put(fd);
+	return true;
+}
+
 /** Execute directory listing benchmark.
  *
  * Note that while this benchmark tries to measure speed of direct
@@ -46,21 +128,29 @@
 static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 {
 	const char *path = bench_env_param_get(env, "dirname", "/");
+	const char *mode_name = bench_env_param_get(env, "mode", "names");
+	dir_read_mode_t mode;
+
+	if (str_cmp(mode_name, "names") == 0)
+		mode = MODE_NAMES;
+	else if (str_cmp(mode_name, "stat") == 0)
+		mode = MODE_STAT;
+	else if (str_cmp(mode_name, "batch") == 0)
+		mode = MODE_BATCH;
+	else
+		return bench_run_fail(run, "unknown mode '%s'", mode_name);
 
 	bench_run_start(run);
 	for (uint64_t i = 0; i < size; i++) {
-		DIR *dir = opendir(path);
-		if (dir == NULL) {
-			return bench_run_fail(run, "failed to open %s for reading: %s",
-			    path, str_error(errno));
-		}
+		bool ok;
 
-		struct dirent *dp;
-		while ((dp = readdir(dir))) {
-			/* Do nothing */
-		}
+		if (mode == MODE_BATCH)
+			ok = list_batch(run, path);
+		else
+			ok = list_readdir(run, path, mode == MODE_STAT);
 
-		closedir(dir);
+		if (!ok)
+			return false;
 	}
 	bench_run_stop(run);
 
@@ -69,7 +159,7 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 
 benchmark_t benchmark_dir_read = {
 	.name = "dir_read",
-	.desc = "Read contents of a directory (use 'dirname' param to alter the default).",
+	.desc = "Read contents of a directory (use 'dirname' and 'mode' params to alter the defaults, 'mode' is one of names, stat or batch).",
 	.entry = &runner,
 	.setup = NULL,
 	.teardown = NULL
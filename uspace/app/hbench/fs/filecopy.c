@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Copies a large file, either through a buffer of the benchmark or
+ * with vfs_copy_range(), which keeps the data out of the client.
+ *
+ * Parameters:
+ *  - filename: file to copy (created by the setup)
+ *  - dest: file to copy to (removed by the teardown), put it on another
+ *    file system to measure the copy streamed by VFS
+ *  - file_size: size of the copied file in bytes (default 64 MiB)
+ *  - mode: 'rw' copies with vfs_read() and vfs_write() through a 64 KiB
+ *    buffer, 'range' uses vfs_copy_range() (default 'range')
+ */
+
+/** Size of the buffer used by the 'rw' mode */
+#define COPY_BUFFER_SIZE (64 * 1024)
+
+typedef enum {
+	MODE_RW,
+	MODE_RANGE
+} file_copy_mode_t;
+
+static const char *src_path;
+static const char *dst_path;
+static uint64_t file_size;
+static file_copy_mode_t mode;
+static char *buf;
+static int src_fd = -1;
+static int dst_fd = -1;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	src_path = bench_env_param_get(env, "filename", "/tmp/hbench_copy_src");
+	dst_path = bench_env_param_get(env, "dest", "/tmp/hbench_copy_dst");
+
+	errno_t rc = bench_env_param_get_uint64(env, "file_size",
+	    64 * 1024 * 1024, &file_size);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid file_size: %s", str_error(rc));
+
+	const char *mode_name = bench_env_param_get(env, "mode", "range");
+	if (str_cmp(mode_name, "rw") == 0)
+		mode = MODE_RW;
+	else if (str_cmp(mode_name, "range") == 0)
+		mode = MODE_RANGE;
+	else
+		return bench_run_fail(run, "unknown mode '%s'", mode_name);
+
+	buf = malloc(COPY_BUFFER_SIZE);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %dB",
+		    COPY_BUFFER_SIZE);
+	}
+
+	memset(buf, 'x', COPY_BUFFER_SIZE);
+
+	rc = vfs_lookup_open(src_path, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_READ | MODE_WRITE, &src_fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s: %s", src_path,
+		    str_error(rc));
+	}
+
+	rc = vfs_resize(src_fd, 0);
+	aoff64_t pos = 0;
+	while (rc == EOK && pos < file_size) {
+		size_t nwritten;
+		rc = vfs_write(src_fd, &pos, buf,
+		    min(COPY_BUFFER_SIZE, file_size - pos), &nwritten);
+	}
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to fill %s: %s", src_path,
+		    str_error(rc));
+	}
+
+	rc = vfs_lookup_open(dst_path, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &dst_fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s: %s", dst_path,
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+static errno_t copy_rw(void)
+{
+	aoff64_t rpos = 0;
+	aoff64_t wpos = 0;
+	size_t nread;
+	errno_t rc;
+
+	while ((rc = vfs_read(src_fd, &rpos, buf, COPY_BUFFER_SIZE,
+	    &nread)) == EOK && nread > 0) {
+		size_t nwritten;
+		rc = vfs_write(dst_fd, &wpos, buf, nread, &nwritten);
+		if (rc != EOK)
+			break;
+	}
+
+	return rc;
+}
+
+static errno_t copy_range(void)
+{
+	aoff64_t pos = 0;
+	aoff64_t copied;
+	errno_t rc = EOK;
+
+	while (pos < file_size) {
+		rc = vfs_copy_range(src_fd, pos, dst_fd, pos, file_size - pos,
+		    &copied);
+		if (rc != EOK)
+			break;
+		if (copied == 0) {
+			rc = EIO;
+			break;
+		}
+
+		pos += copied;
+	}
+
+	return rc;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	errno_t rc = EOK;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		rc = vfs_resize(dst_fd, 0);
+		if (rc != EOK)
+			break;
+
+		rc = (mode == MODE_RW) ? copy_rw() : copy_range();
+		if (rc != EOK)
+			break;
+	}
+	bench_run_stop(run);
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to copy %s to %s: %s",
+		    src_path, dst_path, str_error(rc));
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	bool ok = true;
+
+	free(buf);
+	buf = NULL;
+
+	if (src_fd >= 0) {
+		vfs_put(src_fd);
+		src_fd = -1;
+		if (vfs_unlink_path(src_path) != EOK)
+			ok = bench_run_fail(run, "failed to remove %s", src_path);
+	}
+
+	if (dst_fd >= 0) {
+		vfs_put(dst_fd);
+		dst_fd = -1;
+		if (vfs_unlink_path(dst_path) != EOK)
+			ok = bench_run_fail(run, "failed to remove %s", dst_path);
+	}
+
+	return ok;
+}
+
+benchmark_t benchmark_file_copy = {
+	.name = "file_copy",
+	.desc = "Copy a large file (use 'filename', 'dest', 'file_size' and 'mode' params to alter the defaults, 'mode' is one of rw or range).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
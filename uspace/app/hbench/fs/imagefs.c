@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
+#include <loc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <task.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Runs a file system workload on top of a file-backed disk. The setup
+ * creates the disk image, attaches it with file_bd, formats it and mounts
+ * it. Each run then has several fibrils create, write, synchronize, read
+ * back and remove their own files, so that several requests are in flight
+ * at file_bd at once.
+ *
+ * Parameters:
+ *  - image: disk image to use (created by the setup)
+ *  - disk_size: size of the disk in bytes (default 32 MiB)
+ *  - fs: file system type (default fat)
+ *  - mkfs: program to format the disk with (default /app/mkfat)
+ *  - mountpoint: where to mount the file system (default /tmp/hbench_fs)
+ *  - fibrils: number of fibrils issuing requests (default 4)
+ *  - file_size: size of each file in bytes (default 64 KiB)
+ *
+ * The size of a run is the total number of files.
+ */
+
+#define FILE_BD "/srv/bd/file_bd"
+#define IMAGE_FS_SVC "bd/hbench_fs"
+
+#define BUFFER_SIZE 4096
+
+/** Fibril issuing file system requests */
+typedef struct {
+	/** Fibril index */
+	uint64_t idx;
+	/** Buffer for reading and writing */
+	char *buf;
+	/** Number of files to process */
+	uint64_t count;
+} imagefs_fibril_t;
+
+static const char *image;
+static const char *mountpoint;
+static uint64_t disk_size;
+static uint64_t nfibrils;
+static uint64_t file_size;
+static imagefs_fibril_t *fibrils;
+static task_id_t filebd_id;
+static bool filebd_running;
+static bool mp_created;
+static bool mounted;
+
+static FIBRIL_MUTEX_INITIALIZE(imagefs_lock);
+static FIBRIL_CONDVAR_INITIALIZE(imagefs_cv);
+static uint64_t imagefs_running;
+static errno_t imagefs_rc;
+
+/** Write, synchronize, read back and remove one file. */
+static errno_t imagefs_file(imagefs_fibril_t *f, uint64_t n)
+{
+	char name[64];
+	aoff64_t pos;
+	size_t nbytes;
+	int fd;
+
+	snprintf(name, sizeof(name), "%s/f%" PRIu64 "_%" PRIu64, mountpoint,
+	    f->idx, n);
+
+	errno_t rc = vfs_lookup_open(name, WALK_REGULAR | WALK_MUST_CREATE,
+	    MODE_READ | MODE_WRITE, &fd);
+	if (rc != EOK)
+		return rc;
+
+	pos = 0;
+	while (pos < file_size) {
+		rc = vfs_write(fd, &pos, f->buf, min(BUFFER_SIZE,
+		    file_size - pos), &nbytes);
+		if (rc != EOK)
+			goto out;
+	}
+
+	rc = vfs_sync(fd);
+	if (rc != EOK)
+		goto out;
+
+	pos = 0;
+	while (pos < file_size) {
+		rc = vfs_read(fd, &pos, f->buf, BUFFER_SIZE, &nbytes);
+		if (rc != EOK)
+			goto out;
+		if (nbytes == 0) {
+			rc = EIO;
+			goto out;
+		}
+	}
+
+out:
+	vfs_put(fd);
+	if (rc != EOK)
+		return rc;
+
+	return vfs_unlink_path(name);
+}
+
+static errno_t imagefs_fibril(void *arg)
+{
+	imagefs_fibril_t *f = (imagefs_fibril_t *) arg;
+	errno_t rc = EOK;
+
+	for (uint64_t i = 0; i < f->count; i++) {
+		rc = imagefs_file(f, i);
+		if (rc != EOK)
+			break;
+	}
+
+	fibril_mutex_lock(&imagefs_lock);
+	if (rc != EOK)
+		imagefs_rc = rc;
+	imagefs_running--;
+	fibril_condvar_broadcast(&imagefs_cv);
+	fibril_mutex_unlock(&imagefs_lock);
+	return EOK;
+}
+
+static bool create_image(bench_run_t *run)
+{
+	size_t bufsize = 64 * 1024;
+	char *buf;
+	int fd;
+
+	buf = calloc(1, bufsize);
+	if (buf == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	errno_t rc = vfs_lookup_open(image, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK) {
+		free(buf);
+		return bench_run_fail(run, "failed to create %s: %s", image,
+		    str_error(rc));
+	}
+
+	aoff64_t pos = 0;
+	while (pos < disk_size) {
+		size_t nwritten;
+		rc = vfs_write(fd, &pos, buf, min(bufsize, disk_size - pos),
+		    &nwritten);
+		if (rc != EOK) {
+			vfs_put(fd);
+			free(buf);
+			return bench_run_fail(run, "failed to write to %s: %s",
+			    image, str_error(rc));
+		}
+	}
+
+	vfs_put(fd);
+	free(buf);
+	return true;
+}
+
+/** Run a program until it exits or sets its return value. */
+static bool run_task(bench_run_t *run, task_id_t *id, const char *path, const char *arg1, const char *arg2)
+{
+	task_wait_t wait;
+	task_exit_t texit;
+	int retval;
+
+	errno_t rc = task_spawnl(id, &wait, path, path, arg1, arg2, NULL);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to start %s: %s", path,
+		    str_error(rc));
+	}
+
+	rc = task_wait(&wait, &texit, &retval);
+	if (rc != EOK || texit != TASK_EXIT_NORMAL || retval != 0)
+		return bench_run_fail(run, "%s failed", path);
+
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	task_id_t mkfs_id;
+
+	image = bench_env_param_get(env, "image", "/tmp/hbench_fs.img");
+	mountpoint = bench_env_param_get(env, "mountpoint", "/tmp/hbench_fs");
+	const char *fstype = bench_env_param_get(env, "fs", "fat");
+	const char *mkfs = bench_env_param_get(env, "mkfs", "/app/mkfat");
+
+	errno_t rc = bench_env_param_get_uint64(env, "disk_size",
+	    32 * 1024 * 1024, &disk_size);
+	if (rc != EOK || disk_size == 0)
+		return bench_run_fail(run, "invalid disk_size");
+
+	rc = bench_env_param_get_uint64(env, "fibrils", 4, &nfibrils);
+	if (rc != EOK || nfibrils == 0)
+		return bench_run_fail(run, "invalid number of fibrils");
+
+	rc = bench_env_param_get_uint64(env, "file_size", 64 * 1024,
+	    &file_size);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid file_size");
+
+	if (!create_image(run))
+		return false;
+
+	/* file_bd sets its return value once it accepts connections */
+	if (!run_task(run, &filebd_id, FILE_BD, image, IMAGE_FS_SVC))
+		return false;
+
+	filebd_running = true;
+
+	if (!run_task(run, &mkfs_id, mkfs, IMAGE_FS_SVC, NULL))
+		return false;
+
+	rc = vfs_link_path(mountpoint, KIND_DIRECTORY, NULL);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to create %s: %s",
+		    mountpoint, str_error(rc));
+	}
+
+	mp_created = true;
+
+	rc = vfs_mount_path(mountpoint, fstype, IMAGE_FS_SVC, "", 0, 0);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to mount %s: %s",
+		    IMAGE_FS_SVC, str_error(rc));
+	}
+
+	mounted = true;
+
+	fibrils = calloc(nfibrils, sizeof(imagefs_fibril_t));
+	if (fibrils == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	for (uint64_t i = 0; i < nfibrils; i++) {
+		fibrils[i].idx = i;
+		fibrils[i].buf = calloc(1, BUFFER_SIZE);
+		if (fibrils[i].buf == NULL)
+			return bench_run_fail(run, "out of memory");
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	imagefs_rc = EOK;
+	imagefs_running = 0;
+
+	for (uint64_t i = 0; i < nfibrils; i++) {
+		fibrils[i].count = size / nfibrils +
+		    (i < size % nfibrils ? 1 : 0);
+	}
+
+	bench_run_start(run);
+
+	for (uint64_t i = 0; i < nfibrils; i++) {
+		fid_t fid = fibril_create(imagefs_fibril, &fibrils[i]);
+		if (fid == 0) {
+			fibril_mutex_lock(&imagefs_lock);
+			imagefs_rc = ENOMEM;
+			fibril_mutex_unlock(&imagefs_lock);
+			break;
+		}
+
+		fibril_mutex_lock(&imagefs_lock);
+		imagefs_running++;
+		fibril_mutex_unlock(&imagefs_lock);
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&imagefs_lock);
+	while (imagefs_running > 0)
+		fibril_condvar_wait(&imagefs_cv, &imagefs_lock);
+	fibril_mutex_unlock(&imagefs_lock);
+
+	bench_run_stop(run);
+
+	if (imagefs_rc != EOK) {
+		return bench_run_fail(run, "file request failed: %s",
+		    str_error(imagefs_rc));
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	bool ok = true;
+	errno_t rc;
+
+	if (fibrils != NULL) {
+		for (uint64_t i = 0; i < nfibrils; i++)
+			free(fibrils[i].buf);
+		free(fibrils);
+		fibrils = NULL;
+	}
+
+	if (mounted) {
+		rc = vfs_unmount_path(mountpoint);
+		if (rc != EOK) {
+			ok = bench_run_fail(run, "failed to unmount %s: %s",
+			    mountpoint, str_error(rc));
+		}
+		mounted = false;
+	}
+
+	if (mp_created) {
+		(void) vfs_unlink_path(mountpoint);
+		mp_created = false;
+	}
+
+	if (filebd_running) {
+		(void) task_kill(filebd_id);
+		filebd_running = false;
+	}
+
+	rc = vfs_unlink_path(image);
+	if (rc != EOK) {
+		ok = bench_run_fail(run, "failed to remove %s: %s", image,
+		    str_error(rc));
+	}
+
+	return ok;
+}
+
+benchmark_t benchmark_image_fs = {
+	.name = "image_fs",
+	.desc = "File system workload on a file-backed disk (use 'fs', 'mkfs', 'fibrils' and 'file_size' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
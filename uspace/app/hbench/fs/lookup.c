@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Measures path lookups. Most of the lookups are expected to be answered by
+ * the directory entry cache in VFS, the hit rate of the cache during the
+ * benchmark is reported by the teardown.
+ *
+ * Use the 'path' parameter to look up a different (e.g. deeper) path and the
+ * 'missing' parameter to look up a name which does not exist.
+ */
+
+static vfs_dcache_stat_t stat_start;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	errno_t rc = vfs_dcache_stat(&stat_start);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to get cache statistics: %s",
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	const char *path = bench_env_param_get(env, "path", "/app/hbench");
+	const char *missing = bench_env_param_get(env, "missing", NULL);
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		int fd;
+		errno_t rc;
+
+		if (missing != NULL) {
+			rc = vfs_lookup(missing, 0, &fd);
+			if (rc != ENOENT) {
+				if (rc == EOK)
+					vfs_put(fd);
+				return bench_run_fail(run, "%s should not exist: %s",
+				    missing, str_error(rc));
+			}
+			continue;
+		}
+
+		rc = vfs_lookup(path, 0, &fd);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to look up %s: %s",
+			    path, str_error(rc));
+		}
+
+		vfs_put(fd);
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	vfs_dcache_stat_t stat;
+	errno_t rc = vfs_dcache_stat(&stat);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to get cache statistics: %s",
+		    str_error(rc));
+	}
+
+	uint64_t hits = stat.hits - stat_start.hits;
+	uint64_t neg_hits = stat.neg_hits - stat_start.neg_hits;
+	uint64_t misses = stat.misses - stat_start.misses;
+	uint64_t total = hits + neg_hits + misses;
+
+	printf("dcache: %" PRIu64 " hits, %" PRIu64 " negative hits, %"
+	    PRIu64 " misses", hits, neg_hits, misses);
+	if (total > 0) {
+		printf(" (hit rate %" PRIu64 "%%)",
+		    (hits + neg_hits) * 100 / total);
+	}
+	printf(", %" PRIu64 "/%" PRIu64 " entries\n", stat.entries,
+	    stat.capacity);
+
+	return true;
+}
+
+benchmark_t benchmark_path_lookup = {
+	.name = "path_lookup",
+	.desc = "Look up a path (use 'path' or 'missing' param to alter the default).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Creates many small files in a directory. Each created file is allocated
+ * space on the device, which stresses the free space management of the
+ * file system.
+ *
+ * Parameters:
+ *  - dirname: directory to create the files in (created by the setup)
+ *  - file_size: size of each file in bytes (default 4 KiB)
+ */
+
+#define NAME_SIZE 256
+
+static const char *path;
+static uint64_t file_size;
+static char *buf;
+/** Number of files created so far, across all runs */
+static uint64_t files;
+
+static bool create_file(bench_run_t *run, uint64_t n)
+{
+	char name[NAME_SIZE];
+	int fd;
+
+	snprintf(name, sizeof(name), "%s/f%" PRIu64, path, n);
+
+	errno_t rc = vfs_lookup_open(name, WALK_REGULAR | WALK_MUST_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to create %s: %s", name,
+		    str_error(rc));
+	}
+
+	aoff64_t pos = 0;
+	while (pos < file_size) {
+		size_t nwritten;
+		rc = vfs_write(fd, &pos, buf, file_size - pos, &nwritten);
+		if (rc != EOK) {
+			vfs_put(fd);
+			return bench_run_fail(run, "failed to write to %s: %s",
+			    name, str_error(rc));
+		}
+	}
+
+	vfs_put(fd);
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	path = bench_env_param_get(env, "dirname", "/tmp/hbench_mkfiles");
+
+	errno_t rc = bench_env_param_get_uint64(env, "file_size", 4 * 1024,
+	    &file_size);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid file_size: %s", str_error(rc));
+
+	buf = malloc(file_size > 0 ? file_size : 1);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %" PRIu64 "B",
+		    file_size);
+	}
+
+	memset(buf, 'x', file_size);
+
+	rc = vfs_link_path(path, KIND_DIRECTORY, NULL);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to create %s: %s", path,
+		    str_error(rc));
+	}
+
+	files = 0;
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		if (!create_file(run, files))
+			return false;
+		files++;
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	char name[NAME_SIZE];
+	errno_t rc;
+
+	free(buf);
+	buf = NULL;
+
+	for (uint64_t n = 0; n < files; n++) {
+		snprintf(name, sizeof(name), "%s/f%" PRIu64, path, n);
+		rc = vfs_unlink_path(name);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to remove %s: %s",
+			    name, str_error(rc));
+		}
+	}
+
+	rc = vfs_unlink_path(path);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to remove %s: %s", path,
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_make_files = {
+	.name = "make_files",
+	.desc = "Create many small files in a directory (use 'dirname' and 'file_size' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
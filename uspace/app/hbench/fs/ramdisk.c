@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <as.h>
+#include <bd.h>
+#include <errno.h>
+#include <loc.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <task.h>
+#include "../hbench.h"
+
+/*
+ * Reads blocks from a scratch RAM disk, either through block requests
+ * which copy the data over IPC, or directly from the disk mapped into
+ * our address space. The setup starts rd with a scratch disk and fills
+ * it, so that all of its pages are allocated.
+ *
+ * Parameters:
+ *  - mode: copy or share (default copy)
+ *  - disk_size: size of the disk in bytes (default 16 MiB)
+ *  - chunk: size of a single read in bytes (default 4 KiB)
+ */
+
+#define RD "/srv/bd/rd"
+#define RAMDISK_SVC "bd/hbench_rd"
+
+static bool share_mode;
+static uint64_t disk_size;
+static uint64_t chunk;
+static size_t bsize;
+static uint64_t nchunks;
+static char *buf;
+static void *area;
+static task_id_t rd_id;
+static bool rd_running;
+static async_sess_t *sess;
+static bd_t *bd;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	task_wait_t wait;
+	task_exit_t texit;
+	service_id_t svc_id;
+	char size_str[32];
+	int retval;
+
+	const char *mode = bench_env_param_get(env, "mode", "copy");
+	if (str_cmp(mode, "copy") == 0)
+		share_mode = false;
+	else if (str_cmp(mode, "share") == 0)
+		share_mode = true;
+	else
+		return bench_run_fail(run, "invalid mode '%s'", mode);
+
+	errno_t rc = bench_env_param_get_uint64(env, "disk_size",
+	    16 * 1024 * 1024, &disk_size);
+	if (rc != EOK || disk_size == 0)
+		return bench_run_fail(run, "invalid disk_size");
+
+	rc = bench_env_param_get_uint64(env, "chunk", 4096, &chunk);
+	if (rc != EOK || chunk == 0 || chunk > disk_size)
+		return bench_run_fail(run, "invalid chunk");
+
+	snprintf(size_str, sizeof(size_str), "%" PRIu64, disk_size);
+	rc = task_spawnl(&rd_id, &wait, RD, RD, "-s", size_str, RAMDISK_SVC,
+	    NULL);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to start " RD ": %s",
+		    str_error(rc));
+	}
+
+	rc = task_wait(&wait, &texit, &retval);
+	if (rc != EOK || texit != TASK_EXIT_NORMAL || retval != 0)
+		return bench_run_fail(run, RD " failed to start");
+
+	rd_running = true;
+
+	rc = loc_service_get_id(RAMDISK_SVC, &svc_id, IPC_FLAG_BLOCKING);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to find " RAMDISK_SVC
+		    ": %s", str_error(rc));
+	}
+
+	sess = loc_service_connect(svc_id, INTERFACE_BLOCK, IPC_FLAG_BLOCKING);
+	if (sess == NULL)
+		return bench_run_fail(run, "failed to connect to " RAMDISK_SVC);
+
+	rc = bd_open(sess, &bd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open " RAMDISK_SVC
+		    ": %s", str_error(rc));
+	}
+
+	rc = bd_get_block_size(bd, &bsize);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to query " RAMDISK_SVC
+		    ": %s", str_error(rc));
+	}
+
+	if (chunk % bsize != 0) {
+		return bench_run_fail(run, "chunk is not a multiple of the "
+		    "block size (%zu)", bsize);
+	}
+
+	nchunks = disk_size / chunk;
+
+	buf = malloc(chunk);
+	if (buf == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	/* Fill the disk so that the reads do not hit unallocated pages */
+	memset(buf, 0x5a, chunk);
+	for (uint64_t i = 0; i < nchunks; i++) {
+		rc = bd_write_blocks(bd, i * chunk / bsize, chunk / bsize, buf,
+		    chunk);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to write to "
+			    RAMDISK_SVC ": %s", str_error(rc));
+		}
+	}
+
+	if (share_mode) {
+		rc = bd_share_in(bd, disk_size, &area);
+		if (rc != EOK) {
+			area = NULL;
+			return bench_run_fail(run, "failed to map " RAMDISK_SVC
+			    ": %s", str_error(rc));
+		}
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t i = 0; i < size; i++) {
+		uint64_t idx = i % nchunks;
+
+		if (share_mode) {
+			memcpy(buf, (char *) area + idx * chunk, chunk);
+		} else {
+			rc = bd_read_blocks(bd, idx * chunk / bsize,
+			    chunk / bsize, buf, chunk);
+			if (rc != EOK) {
+				bench_run_stop(run);
+				return bench_run_fail(run, "failed to read from "
+				    RAMDISK_SVC ": %s", str_error(rc));
+			}
+		}
+	}
+
+	bench_run_stop(run);
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (area != NULL) {
+		as_area_destroy(area);
+		area = NULL;
+	}
+
+	free(buf);
+	buf = NULL;
+
+	if (bd != NULL) {
+		bd_close(bd);
+		bd = NULL;
+	}
+
+	if (sess != NULL) {
+		async_hangup(sess);
+		sess = NULL;
+	}
+
+	if (rd_running) {
+		(void) task_kill(rd_id);
+		rd_running = false;
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_ramdisk_read = {
+	.name = "ramdisk_read",
+	.desc = "Read from a scratch RAM disk by copying or through a shared mapping (use 'mode', 'disk_size' and 'chunk' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Reads randomly chosen chunks of a large file. This stresses seeking
+ * within the file, i.e. mapping file offsets to blocks on the device. The
+ * file is created by the setup.
+ *
+ * Parameters:
+ *  - filename: file to use (created by the setup)
+ *  - file_size: size of the file in bytes (default 16 MiB)
+ *  - chunk: size of a single read in bytes (default 4 KiB)
+ */
+
+static const char *path;
+static uint64_t file_size;
+static uint64_t chunk;
+static char *buf;
+static uint64_t seed;
+
+/** Simple xorshift generator, stable across runs. */
+static uint64_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+	return seed;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	path = bench_env_param_get(env, "filename", "/tmp/hbench_randread");
+
+	errno_t rc = bench_env_param_get_uint64(env, "file_size",
+	    16 * 1024 * 1024, &file_size);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid file_size: %s", str_error(rc));
+
+	rc = bench_env_param_get_uint64(env, "chunk", 4 * 1024, &chunk);
+	if (rc != EOK || chunk == 0 || chunk > file_size)
+		return bench_run_fail(run, "invalid chunk");
+
+	buf = malloc(chunk);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %" PRIu64 "B",
+		    chunk);
+	}
+
+	memset(buf, 'x', chunk);
+
+	int fd;
+	rc = vfs_lookup_open(path, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s for writing: %s",
+		    path, str_error(rc));
+	}
+
+	aoff64_t pos = 0;
+	while (pos < file_size) {
+		size_t nwritten;
+		rc = vfs_write(fd, &pos, buf, min(chunk, file_size - pos),
+		    &nwritten);
+		if (rc != EOK) {
+			vfs_put(fd);
+			return bench_run_fail(run, "failed to write to %s: %s",
+			    path, str_error(rc));
+		}
+	}
+
+	vfs_put(fd);
+
+	seed = 0x2545f4914f6cdd1dULL;
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	int fd;
+	errno_t rc = vfs_lookup_open(path, WALK_REGULAR, MODE_READ, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s for reading: %s",
+		    path, str_error(rc));
+	}
+
+	uint64_t nchunks = file_size / chunk;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		aoff64_t pos = (next_random() % nchunks) * chunk;
+		size_t nread;
+
+		rc = vfs_read(fd, &pos, buf, chunk, &nread);
+		if (rc != EOK) {
+			vfs_put(fd);
+			return bench_run_fail(run, "failed to read from %s: %s",
+			    path, str_error(rc));
+		}
+	}
+	bench_run_stop(run);
+
+	vfs_put(fd);
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	free(buf);
+	buf = NULL;
+
+	errno_t rc = vfs_unlink_path(path);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to remove %s: %s", path,
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_random_read = {
+	.name = "random_read",
+	.desc = "Read random chunks of a large file (use 'filename', 'file_size' and 'chunk' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Sequentially writes or reads a file in large chunks. To measure the file
+ * system rather than the block cache, point 'filename' at a file system
+ * mounted from a disk image (e.g. an ext4 image attached with file_bd).
+ *
+ * Parameters:
+ *  - filename: file to use (created if needed)
+ *  - mode: 'write' (default) rewrites the file from scratch in each
+ *    iteration, 'read' reads the file which is created by the setup
+ *  - file_size: size of the file in bytes (default 4 MiB)
+ *  - chunk: size of a single read or write in bytes (default 64 KiB)
+ */
+
+static const char *path;
+static bool write_mode;
+static uint64_t file_size;
+static uint64_t chunk;
+static char *buf;
+
+static bool write_file(bench_run_t *run)
+{
+	int fd;
+	errno_t rc = vfs_lookup_open(path, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s for writing: %s",
+		    path, str_error(rc));
+	}
+
+	rc = vfs_resize(fd, 0);
+	if (rc != EOK) {
+		vfs_put(fd);
+		return bench_run_fail(run, "failed to truncate %s: %s", path,
+		    str_error(rc));
+	}
+
+	aoff64_t pos = 0;
+	while (pos < file_size) {
+		size_t nwritten;
+		rc = vfs_write(fd, &pos, buf, min(chunk, file_size - pos),
+		    &nwritten);
+		if (rc != EOK) {
+			vfs_put(fd);
+			return bench_run_fail(run, "failed to write to %s: %s",
+			    path, str_error(rc));
+		}
+	}
+
+	vfs_put(fd);
+	return true;
+}
+
+static bool read_file(bench_run_t *run)
+{
+	int fd;
+	errno_t rc = vfs_lookup_open(path, WALK_REGULAR, MODE_READ, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s for reading: %s",
+		    path, str_error(rc));
+	}
+
+	aoff64_t pos = 0;
+	while (pos < file_size) {
+		size_t nread;
+		rc = vfs_read(fd, &pos, buf, chunk, &nread);
+		if (rc != EOK) {
+			vfs_put(fd);
+			return bench_run_fail(run, "failed to read from %s: %s",
+			    path, str_error(rc));
+		}
+
+		if (nread == 0) {
+			vfs_put(fd);
+			return bench_run_fail(run, "%s is too short", path);
+		}
+	}
+
+	vfs_put(fd);
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	path = bench_env_param_get(env, "filename", "/tmp/hbench_seqio");
+
+	const char *mode = bench_env_param_get(env, "mode", "write");
+	if (str_cmp(mode, "write") == 0)
+		write_mode = true;
+	else if (str_cmp(mode, "read") == 0)
+		write_mode = false;
+	else
+		return bench_run_fail(run, "unknown mode '%s'", mode);
+
+	errno_t rc = bench_env_param_get_uint64(env, "file_size",
+	    4 * 1024 * 1024, &file_size);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid file_size: %s", str_error(rc));
+
+	rc = bench_env_param_get_uint64(env, "chunk", 64 * 1024, &chunk);
+	if (rc != EOK || chunk == 0)
+		return bench_run_fail(run, "invalid chunk");
+
+	buf = malloc(chunk);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %" PRIu64 "B",
+		    chunk);
+	}
+
+	memset(buf, 'x', chunk);
+
+	/* The file to be read must exist before the measurement starts. */
+	if (!write_mode)
+		return write_file(run);
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		bool ok = write_mode ? write_file(run) : read_file(run);
+		if (!ok)
+			return false;
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	free(buf);
+	buf = NULL;
+
+	errno_t rc = vfs_unlink_path(path);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to remove %s: %s", path,
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_seq_io = {
+	.name = "seq_io",
+	.desc = "Sequentially write or read a file (use 'filename', 'mode', 'file_size' and 'chunk' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -125,19 +125,36 @@ extern void csv_report_close(void);
 extern errno_t bench_env_init(bench_env_t *);
 extern errno_t bench_env_param_set(bench_env_t *, const char *, const char *);
 extern const char *bench_env_param_get(bench_env_t *, const char *, const char *);
+extern errno_t bench_env_param_get_uint64(bench_env_t *, const char *,
+    uint64_t, uint64_t *);
 extern void bench_env_cleanup(bench_env_t *);
 
 extern benchmark_t *benchmarks[];
 extern size_t benchmark_count;
 
 /* Put your benchmark descriptors here (and also to benchlist.c). */
+extern benchmark_t benchmark_block_mix;
+extern benchmark_t benchmark_block_read;
 extern benchmark_t benchmark_dir_read;
 extern benchmark_t benchmark_fibril_mutex;
+extern benchmark_t benchmark_file_append;
+extern benchmark_t benchmark_file_copy;
 extern benchmark_t benchmark_file_read;
+extern benchmark_t benchmark_futex;
+extern benchmark_t benchmark_image_fs;
 extern benchmark_t benchmark_malloc1;
 extern benchmark_t benchmark_malloc2;
+extern benchmark_t benchmark_make_files;
+extern benchmark_t benchmark_memcpy;
 extern benchmark_t benchmark_ns_ping;
+extern benchmark_t benchmark_parallel_copy;
+extern benchmark_t benchmark_path_lookup;
+extern benchmark_t benchmark_seq_io;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_ramdisk_read;
+extern benchmark_t benchmark_random_read;
+extern benchmark_t benchmark_tcp_xfer;
+extern benchmark_t benchmark_udp_irq;
 
 #endif
 
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <mem.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Copy a buffer of 'size' bytes (default 64 KiB) in each iteration.
+ * Use 'offset' to misalign the source relative to the destination.
+ */
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	uint64_t size;
+	uint64_t offset;
+	errno_t rc;
+
+	rc = bench_env_param_get_uint64(env, "size", 64 * 1024, &size);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid size: %s", str_error(rc));
+
+	rc = bench_env_param_get_uint64(env, "offset", 0, &offset);
+	if (rc != EOK || offset >= 64)
+		return bench_run_fail(run, "invalid offset (must be below 64)");
+
+	char *src = malloc(size + offset);
+	char *dst = malloc(size);
+	if (src == NULL || dst == NULL) {
+		free(src);
+		free(dst);
+		return bench_run_fail(run, "failed to allocate 2x %" PRIu64 "B",
+		    size);
+	}
+
+	memset(src, 'x', size + offset);
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < niter; i++)
+		memcpy(dst, src + offset, size);
+	bench_run_stop(run);
+
+	free(src);
+	free(dst);
+	return true;
+}
+
+benchmark_t benchmark_memcpy = {
+	.name = "memcpy",
+	.desc = "Copy a memory block (use 'size' and 'offset' params to alter the defaults)",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
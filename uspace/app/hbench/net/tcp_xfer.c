@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <inet/endpoint.h>
+#include <inet/hostport.h>
+#include <inet/tcp.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Measures TCP throughput through a single connection, e.g. to a sink or
+ * source on the emulator host, so that the NIC driver ring sizes and
+ * checksum or segmentation offloads can be compared.
+ *
+ * In the send mode data is only sent (e.g. to 'nc -l' on the host). In
+ * the recv mode the benchmark only reads whatever the remote side sends
+ * (e.g. 'nc -l < /dev/zero'), which exercises the receive path. The
+ * throughput over all runs is printed when the benchmark finishes.
+ *
+ * Parameters:
+ *  - dest: host:port to connect to (required)
+ *  - mode: send or recv (default send)
+ *  - bufsize: size of a single send or receive in bytes (default 65536)
+ *
+ * The workload size is the number of buffers transferred in one run.
+ */
+
+static bool recv_mode;
+static uint64_t buf_size;
+static tcp_t *tcp;
+static tcp_conn_t *conn;
+static char *buf;
+
+/** Totals over all runs */
+static uint64_t total_bytes;
+static nsec_t total_nsec;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	inet_ep2_t epp;
+	const char *errmsg;
+
+	const char *dest = bench_env_param_get(env, "dest", NULL);
+	if (dest == NULL)
+		return bench_run_fail(run, "missing dest (host:port)");
+
+	const char *mode = bench_env_param_get(env, "mode", "send");
+	if (str_cmp(mode, "send") == 0)
+		recv_mode = false;
+	else if (str_cmp(mode, "recv") == 0)
+		recv_mode = true;
+	else
+		return bench_run_fail(run, "invalid mode '%s'", mode);
+
+	errno_t rc = bench_env_param_get_uint64(env, "bufsize", 65536,
+	    &buf_size);
+	if (rc != EOK || buf_size == 0 || buf_size > SIZE_MAX)
+		return bench_run_fail(run, "invalid bufsize");
+
+	inet_ep2_init(&epp);
+	rc = inet_hostport_plookup_one(dest, ip_any, &epp.remote, NULL,
+	    &errmsg);
+	if (rc != EOK)
+		return bench_run_fail(run, "%s (host:port %s)", errmsg, dest);
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		tcp = NULL;
+		return bench_run_fail(run, "failed to connect to TCP: %s",
+		    str_error(rc));
+	}
+
+	rc = tcp_conn_create(tcp, &epp, NULL, NULL, &conn);
+	if (rc != EOK) {
+		conn = NULL;
+		return bench_run_fail(run, "failed to connect to %s: %s",
+		    dest, str_error(rc));
+	}
+
+	buf = malloc(buf_size);
+	if (buf == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	memset(buf, 0x5a, buf_size);
+
+	total_bytes = 0;
+	total_nsec = 0;
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	uint64_t bytes = 0;
+	size_t nrecv;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t i = 0; i < size; i++) {
+		if (!recv_mode) {
+			rc = tcp_conn_send(conn, buf, buf_size);
+			if (rc != EOK) {
+				bench_run_stop(run);
+				return bench_run_fail(run, "failed to send data: %s",
+				    str_error(rc));
+			}
+
+			bytes += buf_size;
+			continue;
+		}
+
+		/* A single receive can return less than the buffer size */
+		nrecv = 0;
+		while (nrecv < buf_size) {
+			size_t n;
+
+			rc = tcp_conn_recv_wait(conn, buf + nrecv,
+			    buf_size - nrecv, &n);
+			if (rc != EOK || n == 0) {
+				bench_run_stop(run);
+				return bench_run_fail(run, "failed to receive data: %s",
+				    rc != EOK ? str_error(rc) : "connection closed");
+			}
+
+			nrecv += n;
+		}
+
+		bytes += nrecv;
+	}
+
+	if (!recv_mode) {
+		rc = tcp_conn_push(conn);
+		if (rc != EOK) {
+			bench_run_stop(run);
+			return bench_run_fail(run, "failed to push data: %s",
+			    str_error(rc));
+		}
+	}
+
+	bench_run_stop(run);
+
+	total_bytes += bytes;
+	total_nsec += stopwatch_get_nanos(&run->stopwatch);
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (total_nsec > 0) {
+		uint64_t usec = NSEC2USEC(total_nsec);
+		if (usec == 0)
+			usec = 1;
+
+		printf("Transferred %" PRIu64 " KiB, throughput: %" PRIu64
+		    " KiB/s\n", total_bytes / 1024,
+		    total_bytes * 1000000 / usec / 1024);
+	}
+
+	free(buf);
+	buf = NULL;
+
+	if (conn != NULL) {
+		tcp_conn_destroy(conn);
+		conn = NULL;
+	}
+
+	if (tcp != NULL) {
+		tcp_destroy(tcp);
+		tcp = NULL;
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_tcp_xfer = {
+	.name = "tcp_xfer",
+	.desc = "Measure TCP throughput over one connection (use 'dest', 'mode' and 'bufsize' params).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/endpoint.h>
+#include <inet/hostport.h>
+#include <inet/udp.h>
+#include <mem.h>
+#include <stats.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Sends UDP datagrams through the network stack and counts the device
+ * interrupts taken meanwhile, so that the interrupt rate can be compared
+ * with the throughput, e.g. with and without MSI-X or notification
+ * coalescing in the NIC driver. The totals over all runs are printed
+ * when the benchmark finishes.
+ *
+ * In the echo mode every datagram waits for its reply, e.g. from netecho
+ * running on the other side, which exercises the receive path as well.
+ *
+ * The interrupts counted are all exceptions named "irq" or "msi", which
+ * includes the timer, unless a single exception is selected with the
+ * 'vector' parameter.
+ *
+ * Parameters:
+ *  - dest: host:port to send the datagrams to (required)
+ *  - mode: send or echo (default send)
+ *  - size: datagram payload size in bytes (default 1024)
+ *  - vector: only count this exception (default all device interrupts)
+ */
+
+/** How long to wait for an echo reply */
+#define ECHO_TIMEOUT_USEC (1000 * 1000)
+
+static bool echo_mode;
+static uint64_t dgram_size;
+static uint64_t vector;
+static bool all_vectors;
+static inet_ep_t remote;
+static udp_t *udp;
+static udp_assoc_t *assoc;
+static char *buf;
+
+static FIBRIL_MUTEX_INITIALIZE(echo_lock);
+static FIBRIL_CONDVAR_INITIALIZE(echo_cv);
+static uint64_t echo_received;
+
+/** Totals over all runs */
+static uint64_t total_irqs;
+static uint64_t total_bytes;
+static nsec_t total_nsec;
+
+static void udp_irq_recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
+{
+	fibril_mutex_lock(&echo_lock);
+	echo_received++;
+	fibril_mutex_unlock(&echo_lock);
+	fibril_condvar_broadcast(&echo_cv);
+}
+
+static udp_cb_t udp_irq_cb = {
+	.recv_msg = udp_irq_recv_msg
+};
+
+/** Count the interrupts handled so far. */
+static bool count_irqs(uint64_t *count)
+{
+	size_t n;
+	stats_exc_t *exc = stats_get_exceptions(&n);
+	if (exc == NULL)
+		return false;
+
+	*count = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (all_vectors) {
+			if (str_cmp(exc[i].desc, "irq") != 0 &&
+			    str_cmp(exc[i].desc, "msi") != 0)
+				continue;
+		} else if (exc[i].id != vector) {
+			continue;
+		}
+
+		*count += exc[i].count;
+	}
+
+	free(exc);
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	inet_ep2_t epp;
+	const char *errmsg;
+
+	const char *dest = bench_env_param_get(env, "dest", NULL);
+	if (dest == NULL)
+		return bench_run_fail(run, "missing dest (host:port)");
+
+	const char *mode = bench_env_param_get(env, "mode", "send");
+	if (str_cmp(mode, "send") == 0)
+		echo_mode = false;
+	else if (str_cmp(mode, "echo") == 0)
+		echo_mode = true;
+	else
+		return bench_run_fail(run, "invalid mode '%s'", mode);
+
+	errno_t rc = bench_env_param_get_uint64(env, "size", 1024,
+	    &dgram_size);
+	if (rc != EOK || dgram_size == 0 || dgram_size > 65507)
+		return bench_run_fail(run, "invalid size");
+
+	all_vectors = bench_env_param_get(env, "vector", NULL) == NULL;
+	if (!all_vectors) {
+		rc = bench_env_param_get_uint64(env, "vector", 0, &vector);
+		if (rc != EOK)
+			return bench_run_fail(run, "invalid vector");
+	}
+
+	inet_ep2_init(&epp);
+	rc = inet_hostport_plookup_one(dest, ip_any, &epp.remote, NULL,
+	    &errmsg);
+	if (rc != EOK)
+		return bench_run_fail(run, "%s (host:port %s)", errmsg, dest);
+
+	remote = epp.remote;
+
+	rc = udp_create(&udp);
+	if (rc != EOK) {
+		udp = NULL;
+		return bench_run_fail(run, "failed to connect to UDP: %s",
+		    str_error(rc));
+	}
+
+	rc = udp_assoc_create(udp, &epp, &udp_irq_cb, NULL, &assoc);
+	if (rc != EOK) {
+		assoc = NULL;
+		return bench_run_fail(run, "failed to create association: %s",
+		    str_error(rc));
+	}
+
+	buf = malloc(dgram_size);
+	if (buf == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	memset(buf, 0x5a, dgram_size);
+
+	total_irqs = 0;
+	total_bytes = 0;
+	total_nsec = 0;
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	uint64_t irqs_start;
+	uint64_t irqs_end;
+	errno_t rc;
+
+	if (!count_irqs(&irqs_start))
+		return bench_run_fail(run, "failed to read exception statistics");
+
+	fibril_mutex_lock(&echo_lock);
+	echo_received = 0;
+	fibril_mutex_unlock(&echo_lock);
+
+	bench_run_start(run);
+
+	for (uint64_t i = 0; i < size; i++) {
+		rc = udp_assoc_send_msg(assoc, &remote, buf, dgram_size);
+		if (rc != EOK) {
+			bench_run_stop(run);
+			return bench_run_fail(run, "failed to send datagram: %s",
+			    str_error(rc));
+		}
+
+		if (!echo_mode)
+			continue;
+
+		fibril_mutex_lock(&echo_lock);
+		while (echo_received <= i) {
+			rc = fibril_condvar_wait_timeout(&echo_cv, &echo_lock,
+			    ECHO_TIMEOUT_USEC);
+			if (rc == ETIMEOUT)
+				break;
+		}
+		fibril_mutex_unlock(&echo_lock);
+
+		if (rc == ETIMEOUT) {
+			bench_run_stop(run);
+			return bench_run_fail(run, "no reply to datagram %" PRIu64,
+			    i);
+		}
+	}
+
+	bench_run_stop(run);
+
+	if (!count_irqs(&irqs_end))
+		return bench_run_fail(run, "failed to read exception statistics");
+
+	total_irqs += irqs_end - irqs_start;
+	total_bytes += size * dgram_size * (echo_mode ? 2 : 1);
+	total_nsec += stopwatch_get_nanos(&run->stopwatch);
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (total_nsec > 0 && total_bytes > 0) {
+		uint64_t usec = NSEC2USEC(total_nsec);
+		if (usec == 0)
+			usec = 1;
+
+		printf("Interrupts: %" PRIu64 " (%" PRIu64 "/s), "
+		    "throughput: %" PRIu64 " KiB/s, %" PRIu64
+		    " interrupts per MiB\n", total_irqs,
+		    total_irqs * 1000000 / usec,
+		    total_bytes * 1000000 / usec / 1024,
+		    total_irqs * 1024 * 1024 / total_bytes);
+	}
+
+	free(buf);
+	buf = NULL;
+
+	if (assoc != NULL) {
+		udp_assoc_destroy(assoc);
+		assoc = NULL;
+	}
+
+	if (udp != NULL) {
+		udp_destroy(udp);
+		udp = NULL;
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_udp_irq = {
+	.name = "udp_irq",
+	.desc = "Send UDP datagrams and count device interrupts per second (use 'dest', 'mode', 'size' and 'vector' params).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -30,21 +30,46 @@
  * @{
  */
 
+#include <fibril.h>
 #include <fibril_synch.h>
-#include <stdatomic.h>
+#include <limits.h>
+#include <stdio.h>
+#include <str_error.h>
 #include "../hbench.h"
 
 /*
- * Simple benchmark for fibril mutexes. There are two fibrils that compete
- * over the same mutex as that is the simplest scenario.
+ * Benchmark for fibril mutexes. Several fibrils (two by default, use
+ * the 'fibrils' parameter to change that) compete over the same mutex,
+ * performing the given number of lock/unlock operations in total.
+ *
+ * Use the 'threads' parameter to run the fibrils on more than one thread
+ * (so that they really contend with each other), 'hold' to make the
+ * critical section longer (number of busy loop iterations) and 'spin'
+ * to change the spin limit of the mutex (0 disables spinning).
  */
 
 typedef struct {
 	fibril_mutex_t mutex;
 	uint64_t counter;
-	atomic_bool done;
+	uint64_t hold;
+
+	fibril_mutex_t done_lock;
+	fibril_condvar_t done_cv;
+	uint64_t running;
 } shared_t;
 
+static fibril_mutex_class_t bench_class =
+    FIBRIL_MUTEX_CLASS_INITIALIZER("hbench");
+
+/** Number of runner threads spawned so far (they cannot be stopped). */
+static uint64_t threads_spawned = 1;
+
+static void busy_loop(uint64_t iterations)
+{
+	for (volatile uint64_t i = 0; i < iterations; i++)
+		;
+}
+
 static errno_t competitor(void *arg)
 {
 	shared_t *shared = arg;
@@ -52,49 +77,118 @@ static errno_t competitor(void *arg)
 
 	while (true) {
 		fibril_mutex_lock(&shared->mutex);
-		uint64_t local = shared->counter;
-		fibril_mutex_unlock(&shared->mutex);
-		if (local == 0) {
+		if (shared->counter == 0) {
+			fibril_mutex_unlock(&shared->mutex);
 			break;
 		}
+		shared->counter--;
+		busy_loop(shared->hold);
+		fibril_mutex_unlock(&shared->mutex);
 	}
 
-	atomic_store(&shared->done, true);
+	fibril_mutex_lock(&shared->done_lock);
+	if (--shared->running == 0)
+		fibril_condvar_signal(&shared->done_cv);
+	fibril_mutex_unlock(&shared->done_lock);
 
 	return EOK;
 }
 
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	uint64_t threads;
+	uint64_t spin;
+	errno_t rc;
+
+	rc = bench_env_param_get_uint64(env, "threads", 1, &threads);
+	if (rc != EOK || threads == 0)
+		return bench_run_fail(run, "invalid number of threads");
+
+	rc = bench_env_param_get_uint64(env, "spin",
+	    FIBRIL_MUTEX_SPIN_LIMIT_DEFAULT, &spin);
+	if (rc != EOK || spin > UINT_MAX)
+		return bench_run_fail(run, "invalid spin limit");
+
+	if (threads > threads_spawned) {
+		threads_spawned += fibril_test_spawn_runners(
+		    threads - threads_spawned);
+		if (threads > threads_spawned) {
+			return bench_run_fail(run, "failed to spawn %" PRIu64
+			    " threads", threads);
+		}
+	}
+
+	fibril_mutex_class_set_spin_limit(&bench_class, spin);
+	fibril_mutex_class_reset_stats(&bench_class);
+	return true;
+}
+
 static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 {
+	uint64_t fibrils;
+	errno_t rc;
+
 	shared_t shared;
-	fibril_mutex_initialize(&shared.mutex);
+	fibril_mutex_initialize_class(&shared.mutex, &bench_class);
+	fibril_mutex_initialize(&shared.done_lock);
+	fibril_condvar_initialize(&shared.done_cv);
 	shared.counter = size;
-	atomic_store(&shared.done, false);
 
-	fid_t other = fibril_create(competitor, &shared);
-	fibril_add_ready(other);
+	rc = bench_env_param_get_uint64(env, "fibrils", 2, &fibrils);
+	if (rc != EOK || fibrils == 0)
+		return bench_run_fail(run, "invalid number of fibrils");
+
+	rc = bench_env_param_get_uint64(env, "hold", 0, &shared.hold);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid hold: %s", str_error(rc));
+
+	shared.running = fibrils;
 
 	bench_run_start(run);
-	for (uint64_t i = 0; i < size; i++) {
-		fibril_mutex_lock(&shared.mutex);
-		shared.counter--;
-		fibril_mutex_unlock(&shared.mutex);
+
+	for (uint64_t i = 0; i < fibrils; i++) {
+		fid_t other = fibril_create(competitor, &shared);
+		if (other == 0) {
+			/* Let the already started fibrils finish the work. */
+			fibril_mutex_lock(&shared.done_lock);
+			shared.running -= fibrils - i;
+			fibril_mutex_unlock(&shared.done_lock);
+			if (i == 0)
+				return bench_run_fail(run, "failed to create fibril");
+			break;
+		}
+		fibril_add_ready(other);
 	}
+
+	fibril_mutex_lock(&shared.done_lock);
+	while (shared.running > 0)
+		fibril_condvar_wait(&shared.done_cv, &shared.done_lock);
+	fibril_mutex_unlock(&shared.done_lock);
+
 	bench_run_stop(run);
 
-	while (!atomic_load(&shared.done)) {
-		fibril_yield();
-	}
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	fibril_mutex_stats_t stats;
+
+	fibril_mutex_class_get_stats(&bench_class, &stats);
+	printf("Mutex contention: %zu contended, %zu spun, %zu blocked, "
+	    "%zu spin iterations.\n", stats.contended, stats.spun,
+	    stats.blocked, stats.spins);
 
 	return true;
 }
 
 benchmark_t benchmark_fibril_mutex = {
 	.name = "fibril_mutex",
-	.desc = "Speed of mutex lock/unlock operations",
+	.desc = "Speed of mutex lock/unlock operations (use 'threads', "
+	    "'fibrils', 'hold' and 'spin' params to alter the defaults)",
 	.entry = &runner,
-	.setup = NULL,
-	.teardown = NULL
+	.setup = &setup,
+	.teardown = &teardown
 };
 
 /** @}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <abi/cap.h>
+#include <abi/synch.h>
+#include <errno.h>
+#include <futex.h>
+#include <libc.h>
+#include <stdatomic.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Compares the cost of the kernel futex with the cost of a wait queue
+ * capability, which is what the futexes in libc used before.
+ *
+ * Each iteration performs a wakeup with no thread sleeping and a sleep which
+ * returns immediately. With the 'waitq' method (the default is 'futex'), the
+ * wakeup is recorded as a missed wakeup and consumed by the sleep and each
+ * of the two syscalls resolves the wait queue capability. With the 'futex'
+ * method, the sleep fails as the futex does not have the expected value and
+ * each of the two syscalls translates the address of the futex.
+ */
+
+typedef enum {
+	METHOD_FUTEX,
+	METHOD_WAITQ
+} method_t;
+
+static method_t method;
+static cap_waitq_handle_t whandle;
+static atomic_int word;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *name = bench_env_param_get(env, "method", "futex");
+
+	if (str_cmp(name, "futex") == 0) {
+		method = METHOD_FUTEX;
+	} else if (str_cmp(name, "waitq") == 0) {
+		method = METHOD_WAITQ;
+		errno_t rc = __SYSCALL1(SYS_WAITQ_CREATE, (sysarg_t) &whandle);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to create waitq: %s",
+			    str_error(rc));
+		}
+	} else {
+		return bench_run_fail(run, "unknown method '%s'", name);
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t i = 0; i < size; i++) {
+		if (method == METHOD_FUTEX) {
+			rc = futex_wake(&word, 1);
+			if (rc == EOK) {
+				rc = futex_wait(&word, 1, 0);
+				if (rc == EAGAIN)
+					rc = EOK;
+			}
+		} else {
+			rc = __SYSCALL1(SYS_WAITQ_WAKEUP, (sysarg_t) whandle);
+			if (rc == EOK) {
+				rc = __SYSCALL3(SYS_WAITQ_SLEEP, (sysarg_t) whandle,
+				    0, SYNCH_FLAGS_NON_BLOCKING);
+			}
+		}
+
+		if (rc != EOK) {
+			bench_run_stop(run);
+			return bench_run_fail(run, "wakeup/sleep failed: %s",
+			    str_error(rc));
+		}
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (method == METHOD_WAITQ)
+		(void) __SYSCALL1(SYS_WAITQ_DESTROY, (sysarg_t) whandle);
+
+	return true;
+}
+
+benchmark_t benchmark_futex = {
+	.name = "futex",
+	.desc = "Speed of kernel wakeup and sleep operations (use 'method' "
+	    "param to select 'futex' or 'waitq')",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -56,6 +56,7 @@ int main(int argc, char **argv)
 	aoff64_t nblocks;
 	const char *label = "";
 	unsigned int bsize = 4096;
+	uint32_t journal_blocks = 0;
 
 	cfg.version = ext4_def_fs_version;
 
@@ -111,6 +112,27 @@ int main(int argc, char **argv)
 			continue;
 		}
 
+		if (str_cmp(*argv, "--journal") == 0) {
+			--argc;
+			++argv;
+			if (*argv == NULL) {
+				printf(NAME ": Error, argument missing.\n");
+				syntax_print();
+				return 1;
+			}
+
+			journal_blocks = strtol(*argv, &endptr, 10);
+			if (*endptr != '\0') {
+				printf(NAME ": Error, invalid argument.\n");
+				syntax_print();
+				return 1;
+			}
+
+			--argc;
+			++argv;
+			continue;
+		}
+
 		if (str_cmp(*argv, "--type") == 0) {
 			--argc;
 			++argv;
@@ -170,6 +192,12 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
+	if (journal_blocks != 0 && cfg.version == extver_ext2_old) {
+		printf(NAME ": Error, journal requires a revision 1 "
+		    "file system.\n");
+		return 1;
+	}
+
 	dev_path = *argv;
 	printf("Device: %s\n", dev_path);
 
@@ -181,6 +209,7 @@ int main(int argc, char **argv)
 
 	cfg.volume_name = label;
 	cfg.bsize = bsize;
+	cfg.journal_blocks = journal_blocks;
 	(void) nblocks;
 
 	rc = ext4_filesystem_create(&cfg, service_id);
@@ -201,7 +230,8 @@ static void syntax_print(void)
 	    "\t--size <sectors> Filesystem size, overrides device size\n"
 	    "\t--label <label>  Volume label\n"
 	    "\t--type <fstype>  Filesystem type (ext2, ext2old)\n"
-	    "\t--bsize <bytes>  Filesystem block size in bytes (default = 4096)\n");
+	    "\t--bsize <bytes>  Filesystem block size in bytes (default = 4096)\n"
+	    "\t--journal <blocks> Create a journal of the given size in blocks\n");
 }
 
 static errno_t ext4_version_parse(const char *str, ext4_cfg_ver_t *ver)
@@ -58,6 +58,9 @@ const sc_desc_t syscall_desc[] = {
 	[SYS_WAITQ_SLEEP] = { "waitq_sleep", 3, V_ERRNO },
 	[SYS_WAITQ_WAKEUP] = { "waitq_wakeup", 1, V_ERRNO },
 	[SYS_WAITQ_DESTROY] = { "waitq_destroy", 1, V_ERRNO },
+	[SYS_FUTEX_WAIT] = { "futex_wait", 3, V_ERRNO },
+	[SYS_FUTEX_WAKE] = { "futex_wake", 2, V_ERRNO },
+	[SYS_FUTEX_REQUEUE] = { "futex_requeue", 4, V_ERRNO },
 	[SYS_SMC_COHERENCE] = { "smc_coherence", 2, V_ERRNO },
 
 	/* Address space related syscalls. */
@@ -101,6 +104,7 @@ const sc_desc_t syscall_desc[] = {
 
 	[SYS_IPC_IRQ_SUBSCRIBE] = { "ipc_irq_subscribe", 4, V_ERRNO },
 	[SYS_IPC_IRQ_UNSUBSCRIBE] = { "ipc_irq_unsubscribe", 2, V_ERRNO },
+	[SYS_IPC_IRQ_COALESCE] = { "ipc_irq_coalesce", 2, V_ERRNO },
 
 	/* Sysinfo syscalls. */
 	[SYS_SYSINFO_GET_KEYS_SIZE] = { "sysinfo_get_keys_size", 3, V_ERRNO },
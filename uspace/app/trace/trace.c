@@ -644,8 +644,12 @@ static void main_init(void)
 	p = proto_new("vfs");
 	o = oper_new("read", 3, arg_def, V_ERRNO, 1, resp_def);
 	proto_add_oper(p, VFS_IN_READ, o);
+	o = oper_new("readdir", 3, arg_def, V_ERRNO, 3, resp_def);
+	proto_add_oper(p, VFS_IN_READDIR, o);
 	o = oper_new("write", 3, arg_def, V_ERRNO, 1, resp_def);
 	proto_add_oper(p, VFS_IN_WRITE, o);
+	o = oper_new("copy_range", 2, arg_def, V_ERRNO, 2, resp_def);
+	proto_add_oper(p, VFS_IN_COPY_RANGE, o);
 	o = oper_new("vfs_resize", 5, arg_def, V_ERRNO, 0, resp_def);
 	proto_add_oper(p, VFS_IN_RESIZE, o);
 	o = oper_new("vfs_stat", 1, arg_def, V_ERRNO, 0, resp_def);
@@ -31,7 +31,9 @@
  */
 
 #include <as.h>
+#include <ddi.h>
 #include <errno.h>
+#include <macros.h>
 #include <stdio.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
@@ -116,8 +118,8 @@ static errno_t write_blocks(ddf_fun_t *, uint64_t, size_t, void *);
 
 static errno_t ahci_identify_device(sata_dev_t *);
 static errno_t ahci_set_highest_ultra_dma_mode(sata_dev_t *);
-static errno_t ahci_rb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
-static errno_t ahci_wb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
+static errno_t ahci_fpdma(sata_dev_t *, bool, uint64_t, size_t, void *);
+static void ahci_port_recover(sata_dev_t *);
 
 static void ahci_sata_devices_create(ahci_dev_t *, ddf_dev_t *);
 static ahci_dev_t *ahci_ahci_create(ddf_dev_t *);
@@ -214,47 +216,52 @@ static errno_t get_block_size(ddf_fun_t *fun, size_t *block_size)
 	return EOK;
 }
 
-/** Read data blocks into SATA device.
+/** Read or write data blocks, splitting the transfer into FPDMA commands.
  *
- * @param fun      Device function handling the call.
+ * @param sata     SATA device structure.
+ * @param write    @c true to write to the device.
  * @param blocknum Number of first block.
- * @param count    Number of blocks to read.
- * @param buf      Buffer for data.
+ * @param count    Number of blocks.
+ * @param buf      Data buffer.
  *
  * @return EOK if succeed, error code otherwise
  *
  */
-static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
+static errno_t ahci_rw_blocks(sata_dev_t *sata, bool write, uint64_t blocknum,
     size_t count, void *buf)
 {
-	sata_dev_t *sata = fun_sata_dev(fun);
+	size_t max_blocks = AHCI_MAX_XFER / sata->block_size;
+	uint8_t *p = buf;
 
-	uintptr_t phys;
-	void *ibuf = AS_AREA_ANY;
-	errno_t rc = dmamem_map_anonymous(sata->block_size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
-	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Cannot allocate read buffer.");
-		return rc;
-	}
-
-	memset(buf, 0, sata->block_size);
-
-	fibril_mutex_lock(&sata->lock);
+	while (count > 0) {
+		size_t cnt = min(count, max_blocks);
 
-	for (size_t cur = 0; cur < count; cur++) {
-		rc = ahci_rb_fpdma(sata, phys, blocknum + cur);
+		errno_t rc = ahci_fpdma(sata, write, blocknum, cnt, p);
 		if (rc != EOK)
-			break;
+			return rc;
 
-		memcpy((void *) (((uint8_t *) buf) + (sata->block_size * cur)),
-		    ibuf, sata->block_size);
+		p += cnt * sata->block_size;
+		blocknum += cnt;
+		count -= cnt;
 	}
 
-	fibril_mutex_unlock(&sata->lock);
-	dmamem_unmap_anonymous(ibuf);
+	return EOK;
+}
 
-	return rc;
+/** Read data blocks into SATA device.
+ *
+ * @param fun      Device function handling the call.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks to read.
+ * @param buf      Buffer for data.
+ *
+ * @return EOK if succeed, error code otherwise
+ *
+ */
+static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
+    size_t count, void *buf)
+{
+	return ahci_rw_blocks(fun_sata_dev(fun), false, blocknum, count, buf);
 }
 
 /** Write data blocks into SATA device.
@@ -270,31 +277,7 @@ static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
 static errno_t write_blocks(ddf_fun_t *fun, uint64_t blocknum,
     size_t count, void *buf)
 {
-	sata_dev_t *sata = fun_sata_dev(fun);
-
-	uintptr_t phys;
-	void *ibuf = AS_AREA_ANY;
-	errno_t rc = dmamem_map_anonymous(sata->block_size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
-	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Cannot allocate write buffer.");
-		return rc;
-	}
-
-	fibril_mutex_lock(&sata->lock);
-
-	for (size_t cur = 0; cur < count; cur++) {
-		memcpy(ibuf, (void *) (((uint8_t *) buf) + (sata->block_size * cur)),
-		    sata->block_size);
-		rc = ahci_wb_fpdma(sata, phys, blocknum + cur);
-		if (rc != EOK)
-			break;
-	}
-
-	fibril_mutex_unlock(&sata->lock);
-	dmamem_unmap_anonymous(ibuf);
-
-	return rc;
+	return ahci_rw_blocks(fun_sata_dev(fun), true, blocknum, count, buf);
 }
 
 /*
@@ -478,6 +461,13 @@ static errno_t ahci_identify_device(sata_dev_t *sata)
 		goto error;
 	}
 
+	/* Use as many command slots as both the HBA and the device queue. */
+	ahci_ghc_cap_t cap;
+	cap.u32 = sata->ahci->memregs->ghc.cap;
+
+	sata->slots = min(cap.ncs + 1, (idata->queue_depth & 0x1f) + 1);
+	sata->dma64 = cap.s64a;
+
 	uint16_t logsec = idata->physical_logic_sector_size;
 	if ((logsec & 0xc000) == 0x4000) {
 		/* Length of sector may be larger than 512 B */
@@ -668,110 +658,181 @@ error:
 	return EINTR;
 }
 
-/** Set AHCI registers for reading one sector from the SATA device using FPDMA.
+/** Get command table of a command slot.
  *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * @param sata SATA device structure.
+ * @param slot Command slot.
+ *
+ * @return Command table.
  *
  */
-static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
+static volatile uint32_t *ahci_slot_table(sata_dev_t *sata, unsigned int slot)
 {
-	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
-
-	cmd->fis_type = SATA_CMD_FIS_TYPE;
-	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x60;
-	cmd->tag = 0;
-	cmd->control = 0;
+	return sata->cmd_table + slot * (AHCI_CMD_TABLE_SIZE / sizeof(uint32_t));
+}
 
-	cmd->reserved1 = 0;
-	cmd->reserved2 = 0;
-	cmd->reserved3 = 0;
-	cmd->reserved4 = 0;
-	cmd->reserved5 = 0;
-	cmd->reserved6 = 0;
+/** Allocate a free command slot, wait for one if all are in use.
+ *
+ * @param sata SATA device structure.
+ *
+ * @return Command slot.
+ *
+ */
+static unsigned int ahci_slot_alloc(sata_dev_t *sata)
+{
+	uint32_t all = (sata->slots == 32) ? 0xffffffff :
+	    (1U << sata->slots) - 1;
 
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
+	fibril_mutex_lock(&sata->event_lock);
 
-	cmd->lba0 = blocknum & 0xff;
-	cmd->lba1 = (blocknum >> 8) & 0xff;
-	cmd->lba2 = (blocknum >> 16) & 0xff;
-	cmd->lba3 = (blocknum >> 24) & 0xff;
-	cmd->lba4 = (blocknum >> 32) & 0xff;
-	cmd->lba5 = (blocknum >> 40) & 0xff;
+	while ((sata->slots_busy & all) == all)
+		fibril_condvar_wait(&sata->slot_free_cv, &sata->event_lock);
 
-	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	unsigned int slot = 0;
+	while (sata->slots_busy & (1U << slot))
+		slot++;
 
-	prdt->data_address_low = LO(phys);
-	prdt->data_address_upper = HI(phys);
-	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
-	prdt->reserved2 = 0;
-	prdt->ioc = 0;
+	sata->slots_busy |= 1U << slot;
 
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
-	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
-	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
+	fibril_mutex_unlock(&sata->event_lock);
 
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
+	return slot;
 }
 
-/** Read one sector from the SATA device using FPDMA.
+/** Free a command slot.
  *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * @param sata SATA device structure.
+ * @param slot Command slot.
  *
- * @return EOK if succeed, error code otherwise
+ */
+static void ahci_slot_free(sata_dev_t *sata, unsigned int slot)
+{
+	fibril_mutex_lock(&sata->event_lock);
+
+	sata->slots_busy &= ~(1U << slot);
+	fibril_condvar_signal(&sata->slot_free_cv);
+
+	fibril_mutex_unlock(&sata->event_lock);
+}
+
+/** Unmap a buffer mapped by ahci_buf_map().
+ *
+ * @param buf  Buffer.
+ * @param size Number of bytes mapped.
  *
  */
-static errno_t ahci_rb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
+static void ahci_buf_unmap(void *buf, size_t size)
 {
-	if (sata->is_invalid_device) {
-		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA read from invalid device", sata->model);
-		return EINTR;
+	uint8_t *p = buf;
+
+	while (size > 0) {
+		size_t len = min(size, PAGE_SIZE - ((uintptr_t) p % PAGE_SIZE));
+		(void) dmamem_unmap(p, len);
+		p += len;
+		size -= len;
 	}
+}
 
-	ahci_rb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
+/** Describe a buffer by the PRDT of a command slot.
+ *
+ * Physically contiguous pages of the buffer are merged into one entry.
+ *
+ * @param sata  SATA device structure.
+ * @param prdt  PRDT of the command slot.
+ * @param buf   Buffer.
+ * @param size  Size of the buffer.
+ * @param read  @c true if the device is going to write to the buffer.
+ * @param prdtl Place to store the number of PRDT entries.
+ *
+ * @return EOK if succeed, error code if the buffer cannot be used for DMA
+ *         directly.
+ *
+ */
+static errno_t ahci_buf_map(sata_dev_t *sata, volatile ahci_cmd_prdt_t *prdt,
+    void *buf, size_t size, bool read, unsigned int *prdtl)
+{
+	uint8_t *p = buf;
+	size_t mapped = 0;
+	unsigned int n = 0;
+	uint64_t last = 0;
+	errno_t rc;
 
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA read", sata->model);
-		return EINTR;
+	/* Data base address must be word aligned. */
+	if (((uintptr_t) buf & 1) != 0)
+		return EINVAL;
+
+	while (mapped < size) {
+		size_t len = min(size - mapped,
+		    PAGE_SIZE - ((uintptr_t) p % PAGE_SIZE));
+		uintptr_t phys;
+
+		/* Make sure the page is backed by a frame */
+		if (read)
+			*(volatile uint8_t *) p = 0;
+		else
+			(void) *(volatile uint8_t *) p;
+
+		rc = dmamem_map(p, len, 0, 0, &phys);
+		if (rc != EOK)
+			goto error;
+
+		if ((!sata->dma64) && ((uint64_t) phys + len > 0x100000000ULL)) {
+			(void) dmamem_unmap(p, len);
+			rc = ELIMIT;
+			goto error;
+		}
+
+		if ((n > 0) && (last == phys)) {
+			prdt[n - 1].dbc += len;
+		} else if (n < AHCI_MAX_PRDT) {
+			prdt[n].data_address_low = LO(phys);
+			prdt[n].data_address_upper = HI(phys);
+			prdt[n].reserved1 = 0;
+			prdt[n].dbc = len - 1;
+			prdt[n].reserved2 = 0;
+			prdt[n].ioc = 0;
+			n++;
+		} else {
+			(void) dmamem_unmap(p, len);
+			rc = ELIMIT;
+			goto error;
+		}
+
+		last = (uint64_t) phys + len;
+		p += len;
+		mapped += len;
 	}
 
+	*prdtl = n;
 	return EOK;
+
+error:
+	ahci_buf_unmap(buf, mapped);
+	return rc;
 }
 
-/** Set AHCI registers for writing one sector to the SATA device, use FPDMA.
+/** Set AHCI registers for FPDMA transfer and issue the command.
  *
  * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
+ * @param slot     Command slot, also used as the NCQ tag.
+ * @param write    @c true for FPDMA write, @c false for FPDMA read.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks, at most 65535.
+ * @param prdtl    Number of entries in the PRDT of the slot.
  *
- * @return EOK if succeed, error code otherwise
+ * @return EOK if the command was issued, EINTR if the device is invalid.
  *
  */
-static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
+static errno_t ahci_fpdma_cmd(sata_dev_t *sata, unsigned int slot, bool write,
+    uint64_t blocknum, size_t count, unsigned int prdtl)
 {
 	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
+	    (sata_ncq_command_frame_t *) ahci_slot_table(sata, slot);
 
 	cmd->fis_type = SATA_CMD_FIS_TYPE;
 	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x61;
-	cmd->tag = 0;
+	cmd->command = write ? 0x61 : 0x60;
+	cmd->tag = slot << 3;
 	cmd->control = 0;
 
 	cmd->reserved1 = 0;
@@ -781,8 +842,12 @@ static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->reserved5 = 0;
 	cmd->reserved6 = 0;
 
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
+	/* FPDMA commands carry the sector count in the features field. */
+	cmd->sector_count_low = count & 0xff;
+	cmd->sector_count_high = (count >> 8) & 0xff;
+
+	/* Device register: LBA addressing, no forced unit access. */
+	cmd->fua = 0x40;
 
 	cmd->lba0 = blocknum & 0xff;
 	cmd->lba1 = (blocknum >> 8) & 0xff;
@@ -791,54 +856,145 @@ static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->lba4 = (blocknum >> 32) & 0xff;
 	cmd->lba5 = (blocknum >> 40) & 0xff;
 
-	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	volatile ahci_cmdhdr_t *hdr = &sata->cmd_header[slot];
 
-	prdt->data_address_low = LO(phys);
-	prdt->data_address_upper = HI(phys);
-	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
-	prdt->reserved2 = 0;
-	prdt->ioc = 0;
-
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
+	hdr->prdtl = prdtl;
+	hdr->flags =
 	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
-	    AHCI_CMDHDR_FLAGS_WRITE |
+	    (write ? AHCI_CMDHDR_FLAGS_WRITE : 0) |
 	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
+	hdr->bytesprocessed = 0;
 
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
+	fibril_mutex_lock(&sata->event_lock);
+
+	while (sata->needs_recovery)
+		fibril_condvar_wait(&sata->recovery_cv, &sata->event_lock);
+
+	if (sata->is_invalid_device) {
+		fibril_mutex_unlock(&sata->event_lock);
+		return EINTR;
+	}
+
+	/*
+	 * Write only the bit of this slot. Writing back the value read
+	 * would set again the bits of commands completed in the meantime.
+	 */
+	sata->slots_issued |= 1U << slot;
+	sata->port->pxsact = 1U << slot;
+	sata->port->pxci = 1U << slot;
+
+	fibril_mutex_unlock(&sata->event_lock);
+
+	return EOK;
 }
 
-/** Write one sector into the SATA device, use FPDMA.
+/** Wait for completion of the command in a command slot.
+ *
+ * @param sata SATA device structure.
+ * @param slot Command slot.
+ *
+ * @return EOK if succeed, EINTR if the command failed.
+ *
+ */
+static errno_t ahci_slot_wait(sata_dev_t *sata, unsigned int slot)
+{
+	uint32_t mask = 1U << slot;
+
+	fibril_mutex_lock(&sata->event_lock);
+
+	while (sata->slots_issued & mask) {
+		fibril_condvar_wait(&sata->slot_done_cv[slot],
+		    &sata->event_lock);
+	}
+
+	errno_t rc = (sata->slots_failed & mask) ? EINTR : EOK;
+	sata->slots_failed &= ~mask;
+
+	fibril_mutex_unlock(&sata->event_lock);
+
+	if (rc != EOK)
+		ahci_port_recover(sata);
+
+	return rc;
+}
+
+/** Transfer data blocks using one FPDMA command.
+ *
+ * The data is transferred directly from or to @a buf if its pages can be
+ * described by the PRDT of one command slot, otherwise a bounce buffer is
+ * used. Several fibrils can have commands outstanding at the same time,
+ * each one in its own command slot.
  *
  * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
+ * @param write    @c true to write to the device.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks, at most AHCI_MAX_XFER bytes.
+ * @param buf      Data buffer.
  *
  * @return EOK if succeed, error code otherwise
  *
  */
-static errno_t ahci_wb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
+static errno_t ahci_fpdma(sata_dev_t *sata, bool write, uint64_t blocknum,
+    size_t count, void *buf)
 {
 	if (sata->is_invalid_device) {
 		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA write to invalid device", sata->model);
+		    "%s: FPDMA transfer on invalid device", sata->model);
 		return EINTR;
 	}
 
-	ahci_wb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
+	size_t size = count * sata->block_size;
+	unsigned int slot = ahci_slot_alloc(sata);
+	volatile ahci_cmd_prdt_t *prdt = (ahci_cmd_prdt_t *)
+	    &ahci_slot_table(sata, slot)[AHCI_CMDTBL_PRDT_OFFSET /
+	    sizeof(uint32_t)];
+	unsigned int prdtl;
+	void *ibuf = NULL;
 
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA write", sata->model);
-		return EINTR;
+	errno_t rc = ahci_buf_map(sata, prdt, buf, size, !write, &prdtl);
+	if (rc != EOK) {
+		uintptr_t phys;
+
+		ibuf = AS_AREA_ANY;
+		rc = dmamem_map_anonymous(size, DMAMEM_4GiB,
+		    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
+		if (rc != EOK) {
+			ddf_msg(LVL_ERROR, "Cannot allocate bounce buffer.");
+			ahci_slot_free(sata, slot);
+			return rc;
+		}
+
+		if (write)
+			memcpy(ibuf, buf, size);
+
+		prdt->data_address_low = LO(phys);
+		prdt->data_address_upper = HI(phys);
+		prdt->reserved1 = 0;
+		prdt->dbc = size - 1;
+		prdt->reserved2 = 0;
+		prdt->ioc = 0;
+		prdtl = 1;
 	}
 
-	return EOK;
+	rc = ahci_fpdma_cmd(sata, slot, write, blocknum, count, prdtl);
+	if (rc == EOK)
+		rc = ahci_slot_wait(sata, slot);
+
+	if (rc != EOK) {
+		ddf_msg(LVL_ERROR, "%s: Unrecoverable error during FPDMA %s",
+		    sata->model, write ? "write" : "read");
+	}
+
+	if (ibuf != NULL) {
+		if ((rc == EOK) && (!write))
+			memcpy(buf, ibuf, size);
+		dmamem_unmap_anonymous(ibuf);
+	} else {
+		ahci_buf_unmap(buf, size);
+	}
+
+	ahci_slot_free(sata, slot);
+	return rc;
 }
 
 /*
@@ -906,16 +1062,48 @@ static void ahci_interrupt(ipc_call_t *icall, ddf_dev_t *dev)
 	if (sata == NULL)
 		return;
 
+	fibril_mutex_lock(&sata->event_lock);
+
 	/* Evaluate port event */
 	if ((ahci_port_is_end_of_operation(pxis)) ||
 	    (ahci_port_is_error(pxis))) {
-		fibril_mutex_lock(&sata->event_lock);
-
 		sata->event_pxis = pxis;
 		fibril_condvar_signal(&sata->event_condvar);
+	}
 
-		fibril_mutex_unlock(&sata->event_lock);
+	/*
+	 * Demultiplex NCQ completions. One interrupt can report
+	 * several commands, those no longer active in PxSACT and PxCI
+	 * have finished. On error the remaining active commands fail.
+	 */
+	if (sata->slots_issued != 0) {
+		uint32_t active = sata->port->pxsact | sata->port->pxci;
+		uint32_t done = sata->slots_issued & ~active;
+
+		if (ahci_port_is_error(pxis)) {
+			sata->slots_failed |= sata->slots_issued & active;
+			done = sata->slots_issued;
+		}
+
+		if (ahci_port_is_permanent_error(pxis))
+			sata->is_invalid_device = true;
+
+		sata->slots_issued &= ~done;
+
+		/*
+		 * Restarting the port can take long, leave it to a fibril
+		 * waiting for one of the failed commands.
+		 */
+		if (ahci_port_is_error(pxis))
+			sata->needs_recovery = true;
+
+		for (unsigned int slot = 0; slot < AHCI_MAX_SLOTS; slot++) {
+			if (done & (1U << slot))
+				fibril_condvar_signal(&sata->slot_done_cv[slot]);
+		}
 	}
+
+	fibril_mutex_unlock(&sata->event_lock);
 }
 
 /*
@@ -968,15 +1156,19 @@ static sata_dev_t *ahci_sata_allocate(ahci_dev_t *ahci, volatile ahci_port_t *po
 	sata->port->pxclb = LO(phys);
 	sata->cmd_header = (ahci_cmdhdr_t *) virt_cmd;
 
-	/* Allocate and init command table structure. */
-	rc = dmamem_map_anonymous(size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &virt_table);
+	/* Allocate and init command tables for all command slots. */
+	rc = dmamem_map_anonymous(AHCI_MAX_SLOTS * AHCI_CMD_TABLE_SIZE,
+	    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &virt_table);
 	if (rc != EOK)
 		goto error_table;
 
-	memset(virt_table, 0, size);
-	sata->cmd_header->cmdtableu = HI(phys);
-	sata->cmd_header->cmdtable = LO(phys);
+	memset(virt_table, 0, AHCI_MAX_SLOTS * AHCI_CMD_TABLE_SIZE);
+	for (unsigned int slot = 0; slot < AHCI_MAX_SLOTS; slot++) {
+		uintptr_t table = phys + slot * AHCI_CMD_TABLE_SIZE;
+
+		sata->cmd_header[slot].cmdtableu = HI(table);
+		sata->cmd_header[slot].cmdtable = LO(table);
+	}
 	sata->cmd_table = (uint32_t *) virt_table;
 
 	return sata;
@@ -1027,6 +1219,65 @@ static void ahci_sata_hw_start(sata_dev_t *sata)
 	sata->port->pxcmd = pxcmd.u32;
 }
 
+/** Recover SATA port after an error.
+ *
+ * The HBA stops processing the command list on an error and does not
+ * resume until software clears the error and restarts the port. The
+ * interrupt handler only marks the port, the first fibril whose command
+ * failed restarts it. New commands are not issued until it is done.
+ *
+ * @param sata SATA device structure.
+ *
+ */
+static void ahci_port_recover(sata_dev_t *sata)
+{
+	fibril_mutex_lock(&sata->event_lock);
+
+	if ((!sata->needs_recovery) || (sata->recovering)) {
+		fibril_mutex_unlock(&sata->event_lock);
+		return;
+	}
+
+	sata->recovering = true;
+
+	fibril_mutex_unlock(&sata->event_lock);
+
+	ahci_port_cmd_t pxcmd;
+
+	pxcmd.u32 = sata->port->pxcmd;
+
+	/* Stop processing the command list. */
+	pxcmd.st = 0;
+	sata->port->pxcmd = pxcmd.u32;
+
+	/* Wait up to 500 ms for the command list engine to stop. */
+	for (unsigned int i = 0; i < 50; i++) {
+		pxcmd.u32 = sata->port->pxcmd;
+		if (pxcmd.cr == 0)
+			break;
+
+		fibril_usleep(10000);
+	}
+
+	/* Clear error status. */
+	sata->port->pxserr = 0xffffffff;
+
+	/* Clear interrupt status. */
+	sata->port->pxis = 0xffffffff;
+
+	/* Enable process the command list. */
+	pxcmd.st = 1;
+	sata->port->pxcmd = pxcmd.u32;
+
+	fibril_mutex_lock(&sata->event_lock);
+
+	sata->needs_recovery = false;
+	sata->recovering = false;
+	fibril_condvar_broadcast(&sata->recovery_cv);
+
+	fibril_mutex_unlock(&sata->event_lock);
+}
+
 /** Create and initialize connected SATA structure device
  *
  * @param ahci     AHCI device structure.
@@ -1056,6 +1307,10 @@ static errno_t ahci_sata_create(ahci_dev_t *ahci, ddf_dev_t *dev,
 	fibril_mutex_initialize(&sata->lock);
 	fibril_mutex_initialize(&sata->event_lock);
 	fibril_condvar_initialize(&sata->event_condvar);
+	fibril_condvar_initialize(&sata->slot_free_cv);
+	for (unsigned int slot = 0; slot < AHCI_MAX_SLOTS; slot++)
+		fibril_condvar_initialize(&sata->slot_done_cv[slot]);
+	fibril_condvar_initialize(&sata->recovery_cv);
 
 	ahci_sata_hw_start(sata);
 
@@ -1081,9 +1336,9 @@ static errno_t ahci_sata_create(ahci_dev_t *ahci, ddf_dev_t *dev,
 		goto error;
 	}
 
-	ddf_fun_set_ops(fun, &ahci_ops);
+	ddf_fun_set_ops(sata->fun, &ahci_ops);
 
-	rc = ddf_fun_bind(fun);
+	rc = ddf_fun_bind(sata->fun);
 	if (rc != EOK) {
 		ddf_msg(LVL_ERROR, "Failed binding function.");
 		goto error;
@@ -40,6 +40,16 @@
 #include <stdint.h>
 #include "ahci_hw.h"
 
+/** Size of the command table of one command slot. */
+#define AHCI_CMD_TABLE_SIZE  512
+
+/** Maximum number of PRDT entries of one command. */
+#define AHCI_MAX_PRDT \
+	((AHCI_CMD_TABLE_SIZE - AHCI_CMDTBL_PRDT_OFFSET) / sizeof(ahci_cmd_prdt_t))
+
+/** Maximum number of bytes transferred by one FPDMA command. */
+#define AHCI_MAX_XFER  (64 * 1024)
+
 /** AHCI Device. */
 typedef struct {
 	/** Pointer to ddf device. */
@@ -72,12 +82,18 @@ typedef struct {
 	/** Pointer to SATA port. */
 	volatile ahci_port_t *port;
 
-	/** Pointer to command header. */
+	/** Pointer to command header list. */
 	volatile ahci_cmdhdr_t *cmd_header;
 
-	/** Pointer to command table. */
+	/** Pointer to command tables, AHCI_CMD_TABLE_SIZE bytes per slot. */
 	volatile uint32_t *cmd_table;
 
+	/** Number of command slots used for NCQ commands. */
+	unsigned int slots;
+
+	/** HBA can address buffers above 4 GiB. */
+	bool dma64;
+
 	/** Mutex for single operation on device. */
 	fibril_mutex_t lock;
 
@@ -90,6 +106,30 @@ typedef struct {
 	/** Event interrupt state. */
 	ahci_port_is_t event_pxis;
 
+	/** Command slots allocated to requests (protected by event_lock). */
+	uint32_t slots_busy;
+
+	/** Command slots issued to the device and not completed yet. */
+	uint32_t slots_issued;
+
+	/** Command slots completed with an error. */
+	uint32_t slots_failed;
+
+	/** Signalled when a command slot is freed. */
+	fibril_condvar_t slot_free_cv;
+
+	/** Signalled when the command in the respective slot completes. */
+	fibril_condvar_t slot_done_cv[AHCI_MAX_SLOTS];
+
+	/** Port stopped on an error and must be restarted. */
+	bool needs_recovery;
+
+	/** Port recovery in progress. */
+	bool recovering;
+
+	/** Signalled when port recovery finishes. */
+	fibril_condvar_t recovery_cv;
+
 	/** Number of device data blocks. */
 	uint64_t blocks;
 
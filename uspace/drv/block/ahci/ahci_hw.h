@@ -1004,8 +1004,16 @@ typedef volatile struct {
 	uint32_t cmdtable;
 	/** Command Table Descriptor Base Address Upper 32-bits. */
 	uint32_t cmdtableu;
+	/** Reserved. */
+	uint32_t reserved[4];
 } ahci_cmdhdr_t;
 
+/** Maximum number of command slots per port. */
+#define AHCI_MAX_SLOTS  32
+
+/** Offset of the Physical Region Descriptor Table in a command table. */
+#define AHCI_CMDTBL_PRDT_OFFSET  0x80
+
 /** Clear Busy upon R_OK (C) flag. */
 #define AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK  0x0400
 
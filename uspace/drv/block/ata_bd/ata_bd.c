@@ -35,20 +35,24 @@
  * @brief ATA disk driver
  *
  * This driver supports CHS, 28-bit and 48-bit LBA addressing, as well as
- * PACKET devices. It only uses PIO transfers. There is no support DMA
- * or any other fancy features such as S.M.A.R.T, removable devices, etc.
+ * PACKET devices. Register devices attached to a PCI IDE controller capable
+ * of bus mastering transfer data using bus master DMA, otherwise PIO is
+ * used. There is no support for any other fancy features such as S.M.A.R.T,
+ * removable devices, etc.
  *
  * This driver is based on the ATA-1, ATA-2, ATA-3 and ATA/ATAPI-4 through 7
  * standards, as published by the ANSI, NCITS and INCITS standards bodies,
  * which are freely available. This driver contains no vendor-specific
  * code at this moment.
  *
- * The driver services a single controller which can have up to two disks
- * attached.
+ * The driver services a single ISA channel or a PCI IDE controller with two
+ * channels. Each channel can have up to two disks attached.
  */
 
 #include <ddi.h>
+#include <ddf/interrupt.h>
 #include <ddf/log.h>
+#include <device/hw_res.h>
 #include <async.h>
 #include <as.h>
 #include <bd_srv.h>
@@ -100,6 +104,8 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t cnt,
 static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
     const void *buf);
 static errno_t ata_rcmd_flush_cache(disk_t *disk);
+static errno_t ata_rcmd_dma(disk_t *disk, bool write, uint64_t ba, size_t cnt,
+    void *buf);
 static errno_t disk_init(ata_ctrl_t *ctrl, disk_t *d, int disk_id);
 static errno_t ata_identify_dev(disk_t *disk, void *buf);
 static errno_t ata_identify_pkt_dev(disk_t *disk, void *buf);
@@ -119,6 +125,7 @@ static void coord_sc_program(ata_ctrl_t *ctrl, const block_coord_t *bc,
     uint16_t scnt);
 static errno_t wait_status(ata_ctrl_t *ctrl, unsigned set, unsigned n_reset,
     uint8_t *pstatus, unsigned timeout);
+static void ata_irq_handler(ipc_call_t *call, ddf_dev_t *dev);
 
 bd_ops_t ata_bd_ops = {
 	.open = ata_bd_open,
@@ -151,8 +158,12 @@ errno_t ata_ctrl_init(ata_ctrl_t *ctrl, ata_base_t *res)
 	ddf_msg(LVL_DEBUG, "ata_ctrl_init()");
 
 	fibril_mutex_initialize(&ctrl->lock);
+	fibril_mutex_initialize(&ctrl->irq_lock);
+	fibril_condvar_initialize(&ctrl->irq_cv);
 	ctrl->cmd_physical = res->cmd;
 	ctrl->ctl_physical = res->ctl;
+	ctrl->bmi_physical = res->bmi;
+	ctrl->irq = res->irq;
 
 	ddf_msg(LVL_NOTE, "I/O address %p/%p", (void *) ctrl->cmd_physical,
 	    (void *) ctrl->ctl_physical);
@@ -164,7 +175,7 @@ errno_t ata_ctrl_init(ata_ctrl_t *ctrl, ata_base_t *res)
 	for (i = 0; i < MAX_DISKS; i++) {
 		ddf_msg(LVL_DEBUG, "Identify drive %d...", i);
 
-		rc = disk_init(ctrl, &ctrl->disk[i], i);
+		rc = disk_init(ctrl, &ctrl->disk[i], ctrl->chan * MAX_DISKS + i);
 
 		if (rc == EOK) {
 			disk_print_summary(&ctrl->disk[i]);
@@ -299,13 +310,127 @@ static void disk_print_summary(disk_t *d)
 		}
 	}
 
-	ddf_msg(LVL_NOTE, "%s: %s %" PRIu64 " blocks%s", d->model, atype,
-	    d->blocks, cap);
+	ddf_msg(LVL_NOTE, "%s: %s %" PRIu64 " blocks%s %s", d->model, atype,
+	    d->blocks, cap != NULL ? cap : "", d->dma ? "DMA" : "PIO");
 cleanup:
 	free(atype);
 	free(cap);
 }
 
+/** Set up bus master DMA.
+ *
+ * Maps the bus master registers, allocates the PRD table and the bounce
+ * buffer and, if the channel has an interrupt, registers a handler for it.
+ * Without an interrupt the completion of DMA transfers is polled.
+ */
+static errno_t ata_bd_init_dma(ata_ctrl_t *ctrl)
+{
+	void *vaddr;
+	errno_t rc;
+
+	rc = pio_enable((void *) ctrl->bmi_physical, sizeof(ata_bmi_t), &vaddr);
+	if (rc != EOK)
+		return rc;
+
+	ctrl->bmi = vaddr;
+
+	/*
+	 * A simplex controller can only run DMA on one channel at a time,
+	 * leave the other one to PIO.
+	 */
+	if ((pio_read_8(&ctrl->bmi->status) & BMISR_SIMPLEX) != 0 &&
+	    ctrl->chan != 0) {
+		rc = ENOTSUP;
+		goto error;
+	}
+
+	ctrl->prdt = AS_AREA_ANY;
+	rc = dmamem_map_anonymous(ATA_DMA_MAX_PRD * sizeof(ata_prd_t),
+	    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0, &ctrl->prdt_phys,
+	    (void **) &ctrl->prdt);
+	if (rc != EOK)
+		goto error;
+
+	ctrl->dma_buf = AS_AREA_ANY;
+	rc = dmamem_map_anonymous(ATA_MAX_XFER, DMAMEM_4GiB,
+	    AS_AREA_READ | AS_AREA_WRITE, 0, &ctrl->dma_buf_phys,
+	    &ctrl->dma_buf);
+	if (rc != EOK)
+		goto error_buf;
+
+	if (ctrl->irq < 0)
+		return EOK;
+
+	uintptr_t bmis = ctrl->bmi_physical + offsetof(ata_bmi_t, status);
+	uintptr_t status = ctrl->cmd_physical + offsetof(ata_cmd_t, status);
+
+	ctrl->irq_ranges[0].base = ctrl->bmi_physical;
+	ctrl->irq_ranges[0].size = sizeof(ata_bmi_t);
+	ctrl->irq_ranges[1].base = ctrl->cmd_physical;
+	ctrl->irq_ranges[1].size = sizeof(ata_cmd_t);
+
+	/* Read bus master status */
+	ctrl->irq_cmds[0].cmd = CMD_PIO_READ_8;
+	ctrl->irq_cmds[0].addr = (void *) bmis;
+	ctrl->irq_cmds[0].dstarg = 1;
+	/* Is the interrupt ours? */
+	ctrl->irq_cmds[1].cmd = CMD_AND;
+	ctrl->irq_cmds[1].value = BMISR_INTR;
+	ctrl->irq_cmds[1].srcarg = 1;
+	ctrl->irq_cmds[1].dstarg = 2;
+	ctrl->irq_cmds[2].cmd = CMD_PREDICATE;
+	ctrl->irq_cmds[2].value = 4;
+	ctrl->irq_cmds[2].srcarg = 2;
+	/* Clear the interrupt bit by writing it back */
+	ctrl->irq_cmds[3].cmd = CMD_PIO_WRITE_A_8;
+	ctrl->irq_cmds[3].addr = (void *) bmis;
+	ctrl->irq_cmds[3].srcarg = 1;
+	/* Reading the status register deasserts INTRQ */
+	ctrl->irq_cmds[4].cmd = CMD_PIO_READ_8;
+	ctrl->irq_cmds[4].addr = (void *) status;
+	ctrl->irq_cmds[4].dstarg = 3;
+	/* Indicate the channel */
+	ctrl->irq_cmds[5].cmd = CMD_LOAD;
+	ctrl->irq_cmds[5].value = ctrl->chan;
+	ctrl->irq_cmds[5].dstarg = 4;
+	ctrl->irq_cmds[6].cmd = CMD_ACCEPT;
+	ctrl->irq_cmds[7].cmd = CMD_DECLINE;
+
+	irq_code_t irq_code = {
+		.rangecount = sizeof(ctrl->irq_ranges) / sizeof(irq_pio_range_t),
+		.ranges = ctrl->irq_ranges,
+		.cmdcount = sizeof(ctrl->irq_cmds) / sizeof(irq_cmd_t),
+		.cmds = ctrl->irq_cmds
+	};
+
+	rc = register_interrupt_handler(ctrl->dev, ctrl->irq, ata_irq_handler,
+	    &irq_code, &ctrl->irq_cap);
+	if (rc != EOK) {
+		ddf_msg(LVL_WARN, "Failed registering interrupt handler, "
+		    "polling for DMA completion.");
+		ctrl->irq = -1;
+		return EOK;
+	}
+
+	rc = hw_res_enable_interrupt(ddf_dev_parent_sess_get(ctrl->dev),
+	    ctrl->irq);
+	if (rc != EOK) {
+		ddf_msg(LVL_WARN, "Failed enabling interrupt, "
+		    "polling for DMA completion.");
+		unregister_interrupt_handler(ctrl->dev, ctrl->irq_cap);
+		ctrl->irq = -1;
+	}
+
+	return EOK;
+error_buf:
+	dmamem_unmap_anonymous(ctrl->prdt);
+error:
+	ctrl->prdt = NULL;
+	ctrl->dma_buf = NULL;
+	ctrl->bmi = NULL;
+	return rc;
+}
+
 /** Enable device I/O. */
 static errno_t ata_bd_init_io(ata_ctrl_t *ctrl)
 {
@@ -328,13 +453,28 @@ static errno_t ata_bd_init_io(ata_ctrl_t *ctrl)
 
 	ctrl->ctl = vaddr;
 
+	if (ctrl->bmi_physical != 0 && ata_bd_init_dma(ctrl) != EOK)
+		ddf_msg(LVL_NOTE, "Bus master DMA not available, using PIO.");
+
 	return EOK;
 }
 
 /** Clean up device I/O. */
 static void ata_bd_fini_io(ata_ctrl_t *ctrl)
 {
-	(void) ctrl;
+	if (ctrl->bmi != NULL) {
+		if (ctrl->irq >= 0) {
+			unregister_interrupt_handler(ctrl->dev, ctrl->irq_cap);
+			ctrl->irq = -1;
+		}
+
+		dmamem_unmap_anonymous(ctrl->dma_buf);
+		dmamem_unmap_anonymous(ctrl->prdt);
+		ctrl->dma_buf = NULL;
+		ctrl->prdt = NULL;
+		ctrl->bmi = NULL;
+	}
+
 	/* XXX TODO */
 }
 
@@ -362,6 +502,7 @@ static errno_t disk_init(ata_ctrl_t *ctrl, disk_t *d, int disk_id)
 	d->disk_id = disk_id;
 	d->present = false;
 	d->afun = NULL;
+	d->dma = false;
 
 	/* Try identify command. */
 	rc = ata_identify_dev(d, &idata);
@@ -492,6 +633,18 @@ static errno_t disk_init(ata_ctrl_t *ctrl, disk_t *d, int disk_id)
 	} else {
 		/* Assume register Read always uses 512-byte blocks. */
 		d->block_size = 512;
+
+		/* Use DMA if both the controller and the device support it. */
+		if (ctrl->bmi != NULL && (idata.caps & rd_cap_dma) != 0) {
+			d->dma = true;
+
+			/* Write zeros to the interrupt and error bits. */
+			pio_write_8(&ctrl->bmi->status,
+			    (pio_read_8(&ctrl->bmi->status) &
+			    ~(BMISR_INTR | BMISR_ERROR)) |
+			    (disk_dev_idx(d) != 0 ? BMISR_DRV1_DMA :
+			    BMISR_DRV0_DMA));
+		}
 	}
 
 	d->present = true;
@@ -513,15 +666,25 @@ static errno_t ata_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
     void *buf, size_t size)
 {
 	disk_t *disk = bd_srv_disk(bd);
+	size_t max_cnt = ATA_MAX_XFER / disk->block_size;
+	size_t n;
 	errno_t rc;
 
 	if (size < cnt * disk->block_size)
 		return EINVAL;
 
+	if (disk->dev_type == ata_reg_dev && ba + cnt > disk->blocks)
+		return EINVAL;
+
 	while (cnt > 0) {
 		if (disk->dev_type == ata_reg_dev) {
-			rc = ata_rcmd_read(disk, ba, 1, buf);
+			n = min(cnt, max_cnt);
+			if (disk->dma)
+				rc = ata_rcmd_dma(disk, false, ba, n, buf);
+			else
+				rc = ata_rcmd_read(disk, ba, n, buf);
 		} else {
+			n = 1;
 			rc = ata_pcmd_read_12(disk, ba, 1, buf,
 			    disk->block_size);
 		}
@@ -529,9 +692,9 @@ static errno_t ata_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
 		if (rc != EOK)
 			return rc;
 
-		++ba;
-		--cnt;
-		buf += disk->block_size;
+		ba += n;
+		cnt -= n;
+		buf += n * disk->block_size;
 	}
 
 	return EOK;
@@ -550,22 +713,28 @@ static errno_t ata_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
     const void *buf, size_t size)
 {
 	disk_t *disk = bd_srv_disk(bd);
+	size_t max_cnt = ATA_MAX_XFER / disk->block_size;
+	size_t n;
 	errno_t rc;
 
 	if (disk->dev_type != ata_reg_dev)
 		return ENOTSUP;
 
-	if (size < cnt * disk->block_size)
+	if (size < cnt * disk->block_size || ba + cnt > disk->blocks)
 		return EINVAL;
 
 	while (cnt > 0) {
-		rc = ata_rcmd_write(disk, ba, 1, buf);
+		n = min(cnt, max_cnt);
+		if (disk->dma)
+			rc = ata_rcmd_dma(disk, true, ba, n, (void *) buf);
+		else
+			rc = ata_rcmd_write(disk, ba, n, buf);
 		if (rc != EOK)
 			return rc;
 
-		++ba;
-		--cnt;
-		buf += disk->block_size;
+		ba += n;
+		cnt -= n;
+		buf += n * disk->block_size;
 	}
 
 	return EOK;
@@ -607,22 +776,25 @@ static errno_t ata_pio_data_in(disk_t *disk, void *obuf, size_t obuf_size,
 {
 	ata_ctrl_t *ctrl = disk->ctrl;
 	uint16_t data;
-	size_t i;
+	size_t i, blk;
 	uint8_t status;
 
-	/* XXX Support multiple blocks */
-	assert(nblocks == 1);
 	assert(blk_size % 2 == 0);
+	assert(obuf_size >= nblocks * blk_size);
 
-	if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
-		return EIO;
+	for (blk = 0; blk < nblocks; blk++) {
+		if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
+			return EIO;
+
+		if ((status & SR_DRQ) == 0)
+			break;
 
-	if ((status & SR_DRQ) != 0) {
 		/* Read data from the device buffer. */
+		uint16_t *bbuf = (uint16_t *) ((uint8_t *) obuf + blk * blk_size);
 
 		for (i = 0; i < blk_size / 2; i++) {
 			data = pio_read_16(&ctrl->cmd->data_port);
-			((uint16_t *) obuf)[i] = data;
+			bbuf[i] = data;
 		}
 	}
 
@@ -637,24 +809,32 @@ static errno_t ata_pio_data_out(disk_t *disk, const void *buf, size_t buf_size,
     size_t blk_size, size_t nblocks)
 {
 	ata_ctrl_t *ctrl = disk->ctrl;
-	size_t i;
+	size_t i, blk;
 	uint8_t status;
 
-	/* XXX Support multiple blocks */
-	assert(nblocks == 1);
 	assert(blk_size % 2 == 0);
+	assert(buf_size >= nblocks * blk_size);
 
-	if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
-		return EIO;
+	for (blk = 0; blk < nblocks; blk++) {
+		if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
+			return EIO;
+
+		if ((status & SR_ERR) != 0 || (status & SR_DRQ) == 0)
+			break;
 
-	if ((status & SR_DRQ) != 0) {
 		/* Write data to the device buffer. */
+		const uint16_t *bbuf = (const uint16_t *)
+		    ((const uint8_t *) buf + blk * blk_size);
 
-		for (i = 0; i < blk_size / 2; i++) {
-			pio_write_16(&ctrl->cmd->data_port, ((uint16_t *) buf)[i]);
-		}
+		for (i = 0; i < blk_size / 2; i++)
+			pio_write_16(&ctrl->cmd->data_port, bbuf[i]);
 	}
 
+	/* Wait for the last block to be written. */
+	if (blk == nblocks &&
+	    wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
+		return EIO;
+
 	if (status & SR_ERR)
 		return EIO;
 
@@ -992,7 +1172,7 @@ static errno_t ata_pcmd_read_toc(disk_t *disk, uint8_t session, void *obuf,
 	return EOK;
 }
 
-/** Read a physical block from the device.
+/** Read physical blocks from the device using PIO.
  *
  * @param disk		Disk
  * @param ba		Address the first block.
@@ -1039,7 +1219,7 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t blk_cnt,
 	}
 
 	/* Program block coordinates into the device. */
-	coord_sc_program(ctrl, &bc, 1);
+	coord_sc_program(ctrl, &bc, blk_cnt);
 
 	pio_write_8(&ctrl->cmd->command, disk->amode == am_lba48 ?
 	    CMD_READ_SECTORS_EXT : CMD_READ_SECTORS);
@@ -1052,7 +1232,7 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t blk_cnt,
 	return rc;
 }
 
-/** Write a physical block to the device.
+/** Write physical blocks to the device using PIO.
  *
  * @param disk		Disk
  * @param ba		Address of the first block.
@@ -1099,7 +1279,7 @@ static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
 	}
 
 	/* Program block coordinates into the device. */
-	coord_sc_program(ctrl, &bc, 1);
+	coord_sc_program(ctrl, &bc, cnt);
 
 	pio_write_8(&ctrl->cmd->command, disk->amode == am_lba48 ?
 	    CMD_WRITE_SECTORS_EXT : CMD_WRITE_SECTORS);
@@ -1111,6 +1291,315 @@ static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
 	return rc;
 }
 
+/** Add a physical memory region to the PRD table.
+ *
+ * The region is merged with the previous entry if it continues it within
+ * the same 64 KiB window, it is split at 64 KiB boundaries otherwise.
+ *
+ * @param ctrl		Controller
+ * @param nprd		Number of entries in the table, updated
+ * @param end		End of the last entry, updated
+ * @param phys		Physical address of the region
+ * @param len		Length of the region
+ *
+ * @return EOK on success, ELIMIT if the table is full.
+ */
+static errno_t ata_prd_add(ata_ctrl_t *ctrl, size_t *nprd, uintptr_t *end,
+    uintptr_t phys, size_t len)
+{
+	while (len > 0) {
+		size_t chunk = min(len, PRD_BOUNDARY - phys % PRD_BOUNDARY);
+
+		if (*nprd > 0 && *end == phys && phys % PRD_BOUNDARY != 0) {
+			/* A full 64 KiB entry wraps to 0, which encodes 64 KiB. */
+			uint16_t count =
+			    uint16_t_le2host(ctrl->prdt[*nprd - 1].count);
+			ctrl->prdt[*nprd - 1].count =
+			    host2uint16_t_le((uint16_t) (count + chunk));
+		} else {
+			if (*nprd >= ATA_DMA_MAX_PRD)
+				return ELIMIT;
+
+			ctrl->prdt[*nprd].base = host2uint32_t_le(phys);
+			ctrl->prdt[*nprd].count = host2uint16_t_le((uint16_t) chunk);
+			ctrl->prdt[*nprd].flags = 0;
+			++*nprd;
+		}
+
+		*end = phys + chunk;
+		phys += chunk;
+		len -= chunk;
+	}
+
+	return EOK;
+}
+
+/** Unmap a buffer mapped by ata_dma_map().
+ *
+ * @param buf		Buffer
+ * @param size		Number of bytes mapped
+ */
+static void ata_dma_unmap(void *buf, size_t size)
+{
+	uint8_t *p = buf;
+
+	while (size > 0) {
+		size_t len = min(size, PAGE_SIZE - ((uintptr_t) p % PAGE_SIZE));
+		(void) dmamem_unmap(p, len);
+		p += len;
+		size -= len;
+	}
+}
+
+/** Describe a client buffer by the PRD table.
+ *
+ * @param ctrl		Controller
+ * @param buf		Buffer
+ * @param size		Size of the buffer
+ * @param read		@c true if the device is going to write to the buffer
+ * @param nprd		Place to store the number of PRD table entries
+ *
+ * @return EOK on success, an error code if the buffer cannot be used
+ *         for bus master DMA directly.
+ */
+static errno_t ata_dma_map(ata_ctrl_t *ctrl, void *buf, size_t size,
+    bool read, size_t *nprd)
+{
+	uint8_t *p = buf;
+	size_t mapped = 0;
+	uintptr_t end = 0;
+	errno_t rc;
+
+	/* Regions must be word aligned. */
+	if (((uintptr_t) buf & 1) != 0)
+		return EINVAL;
+
+	*nprd = 0;
+	while (mapped < size) {
+		size_t len = min(size - mapped,
+		    PAGE_SIZE - ((uintptr_t) p % PAGE_SIZE));
+		uintptr_t phys;
+
+		/* Make sure the page is backed by a frame */
+		if (read)
+			*(volatile uint8_t *) p = 0;
+		else
+			(void) *(volatile uint8_t *) p;
+
+		rc = dmamem_map(p, len, 0, 0, &phys);
+		if (rc != EOK)
+			goto error;
+
+		/* Bus master IDE only addresses the low 4 GiB. */
+		if ((uint64_t) phys + len > UINT32_MAX + (uint64_t) 1) {
+			(void) dmamem_unmap(p, len);
+			rc = ELIMIT;
+			goto error;
+		}
+
+		rc = ata_prd_add(ctrl, nprd, &end, phys, len);
+		if (rc != EOK) {
+			(void) dmamem_unmap(p, len);
+			goto error;
+		}
+
+		p += len;
+		mapped += len;
+	}
+
+	return EOK;
+error:
+	ata_dma_unmap(buf, mapped);
+	return rc;
+}
+
+/** Wait for a bus master DMA transfer to finish.
+ *
+ * @param ctrl		Controller
+ * @param pbmis		Place to store the bus master status
+ *
+ * @return EOK on success, EIO on timeout.
+ */
+static errno_t ata_dma_wait(ata_ctrl_t *ctrl, uint8_t *pbmis)
+{
+	uint8_t bmis;
+	int cnt;
+
+	if (ctrl->irq >= 0) {
+		errno_t rc = EOK;
+
+		fibril_mutex_lock(&ctrl->irq_lock);
+
+		while (rc == EOK &&
+		    (!ctrl->irq_done || (ctrl->irq_bmis & BMISR_ACTIVE) != 0)) {
+			ctrl->irq_done = false;
+			rc = fibril_condvar_wait_timeout(&ctrl->irq_cv,
+			    &ctrl->irq_lock, TIMEOUT_DMA * 10000);
+		}
+
+		bmis = ctrl->irq_bmis;
+		fibril_mutex_unlock(&ctrl->irq_lock);
+
+		*pbmis = bmis;
+		return (rc == EOK) ? EOK : EIO;
+	}
+
+	/* Poll the bus master status, in the same fashion as wait_status(). */
+	bmis = pio_read_8(&ctrl->bmi->status);
+
+	cnt = 1000;
+	while ((bmis & BMISR_INTR) == 0 && (bmis & BMISR_ACTIVE) != 0) {
+		--cnt;
+		if (cnt <= 0)
+			break;
+
+		bmis = pio_read_8(&ctrl->bmi->status);
+	}
+
+	cnt = TIMEOUT_DMA;
+	while ((bmis & BMISR_INTR) == 0 && (bmis & BMISR_ACTIVE) != 0) {
+		fibril_usleep(10000);
+		--cnt;
+		if (cnt <= 0)
+			break;
+
+		bmis = pio_read_8(&ctrl->bmi->status);
+	}
+
+	*pbmis = bmis;
+
+	if (cnt == 0)
+		return EIO;
+
+	/* Clear the interrupt bit, reading status deasserts INTRQ. */
+	pio_write_8(&ctrl->bmi->status, bmis);
+	(void) pio_read_8(&ctrl->cmd->status);
+
+	return EOK;
+}
+
+/** Read or write physical blocks using bus master DMA.
+ *
+ * The data is transferred directly from or to @a buf if its pages can be
+ * described by the PRD table, otherwise through the bounce buffer of the
+ * controller.
+ *
+ * @param disk		Disk
+ * @param write		@c true to write to the device
+ * @param ba		Address of the first block
+ * @param cnt		Number of blocks to transfer, at most ATA_MAX_XFER
+ *			bytes
+ * @param buf		Data buffer
+ *
+ * @return EOK on success, EIO on error.
+ */
+static errno_t ata_rcmd_dma(disk_t *disk, bool write, uint64_t ba, size_t cnt,
+    void *buf)
+{
+	ata_ctrl_t *ctrl = disk->ctrl;
+	size_t size = cnt * disk->block_size;
+	uint8_t bmicr = write ? 0 : BMICR_READ;
+	uint8_t drv_head;
+	uint8_t status;
+	uint8_t bmis;
+	uintptr_t end;
+	size_t nprd;
+	bool bounce;
+	block_coord_t bc;
+	errno_t rc;
+
+	assert(size <= ATA_MAX_XFER);
+
+	/* Silence warning. */
+	memset(&bc, 0, sizeof(bc));
+
+	/* Compute block coordinates. */
+	if (coord_calc(disk, ba, &bc) != EOK)
+		return EINVAL;
+
+	/* New value for Drive/Head register */
+	drv_head =
+	    ((disk_dev_idx(disk) != 0) ? DHR_DRV : 0) |
+	    ((disk->amode != am_chs) ? DHR_LBA : 0) |
+	    (bc.h & 0x0f);
+
+	fibril_mutex_lock(&ctrl->lock);
+
+	bounce = ata_dma_map(ctrl, buf, size, !write, &nprd) != EOK;
+	if (bounce) {
+		if (write)
+			memcpy(ctrl->dma_buf, buf, size);
+
+		nprd = 0;
+		rc = ata_prd_add(ctrl, &nprd, &end, ctrl->dma_buf_phys, size);
+		assert(rc == EOK);
+	}
+
+	ctrl->prdt[nprd - 1].flags = host2uint16_t_le(PRD_EOT);
+
+	/* Program the bus master, clear interrupt and error status. */
+	pio_write_8(&ctrl->bmi->command, bmicr);
+	pio_write_32(&ctrl->bmi->prdt, host2uint32_t_le(ctrl->prdt_phys));
+	pio_write_8(&ctrl->bmi->status, pio_read_8(&ctrl->bmi->status) |
+	    BMISR_INTR | BMISR_ERROR);
+
+	/* Program a Read/Write DMA operation. */
+
+	if (wait_status(ctrl, 0, ~SR_BSY, NULL, TIMEOUT_BSY) != EOK) {
+		rc = EIO;
+		goto out;
+	}
+
+	pio_write_8(&ctrl->cmd->drive_head, drv_head);
+
+	if (wait_status(ctrl, SR_DRDY, ~SR_BSY, NULL, TIMEOUT_DRDY) != EOK) {
+		rc = EIO;
+		goto out;
+	}
+
+	/* Program block coordinates into the device. */
+	coord_sc_program(ctrl, &bc, cnt);
+
+	fibril_mutex_lock(&ctrl->irq_lock);
+	ctrl->irq_done = false;
+	fibril_mutex_unlock(&ctrl->irq_lock);
+
+	if (write) {
+		pio_write_8(&ctrl->cmd->command, disk->amode == am_lba48 ?
+		    CMD_WRITE_DMA_EXT : CMD_WRITE_DMA);
+	} else {
+		pio_write_8(&ctrl->cmd->command, disk->amode == am_lba48 ?
+		    CMD_READ_DMA_EXT : CMD_READ_DMA);
+	}
+
+	/* Start the transfer. */
+	pio_write_8(&ctrl->bmi->command, bmicr | BMICR_START);
+
+	rc = ata_dma_wait(ctrl, &bmis);
+
+	/* Stop the bus master. */
+	pio_write_8(&ctrl->bmi->command, bmicr);
+
+	if (rc == EOK && wait_status(ctrl, 0, ~SR_BSY, &status,
+	    TIMEOUT_BSY) != EOK)
+		rc = EIO;
+
+	if (rc == EOK && ((bmis & BMISR_ERROR) != 0 ||
+	    (status & (SR_ERR | SR_DWF)) != 0))
+		rc = EIO;
+
+out:
+	if (bounce) {
+		if (rc == EOK && !write)
+			memcpy(buf, ctrl->dma_buf, size);
+	} else {
+		ata_dma_unmap(buf, size);
+	}
+
+	fibril_mutex_unlock(&ctrl->lock);
+	return rc;
+}
+
 /** Flush cached data to nonvolatile storage.
  *
  * @param disk		Disk
@@ -1288,6 +1777,28 @@ static errno_t wait_status(ata_ctrl_t *ctrl, unsigned set, unsigned n_reset,
 	return EOK;
 }
 
+/** Interrupt handler.
+ *
+ * The interrupt pseudocode has cleared the interrupt of the channel
+ * indicated in argument 4 and passed its bus master status in argument 1.
+ */
+static void ata_irq_handler(ipc_call_t *call, ddf_dev_t *dev)
+{
+	ata_dev_t *adev = (ata_dev_t *) ddf_dev_data_get(dev);
+	int chan = ipc_get_arg4(call);
+
+	if (chan < 0 || chan >= adev->nchans)
+		return;
+
+	ata_ctrl_t *ctrl = &adev->chan[chan];
+
+	fibril_mutex_lock(&ctrl->irq_lock);
+	ctrl->irq_bmis = ipc_get_arg1(call);
+	ctrl->irq_done = true;
+	fibril_condvar_broadcast(&ctrl->irq_cv);
+	fibril_mutex_unlock(&ctrl->irq_lock);
+}
+
 /**
  * @}
  */
@@ -38,6 +38,7 @@
 #include <async.h>
 #include <bd_srv.h>
 #include <ddf/driver.h>
+#include <ddf/interrupt.h>
 #include <fibril_synch.h>
 #include <str.h>
 #include <stdint.h>
@@ -46,17 +47,29 @@
 
 #define NAME "ata_bd"
 
+/** Maximum number of channels of one controller. */
+#define ATA_MAX_CHANNELS  2
+
+/** Maximum number of bytes transferred by one command. */
+#define ATA_MAX_XFER  (64 * 1024)
+
+/** Number of entries in the Physical Region Descriptor Table. */
+#define ATA_DMA_MAX_PRD  32
+
 /** Base addresses for ATA I/O blocks. */
 typedef struct {
 	uintptr_t cmd;	/**< Command block base address. */
 	uintptr_t ctl;	/**< Control block base address. */
+	uintptr_t bmi;	/**< Bus master IDE base address or 0. */
+	int irq;	/**< Channel interrupt or -1. */
 } ata_base_t;
 
 /** Timeout definitions. Unit is 10 ms. */
 enum ata_timeout {
 	TIMEOUT_PROBE	=  100, /*  1 s */
 	TIMEOUT_BSY	=  100, /*  1 s */
-	TIMEOUT_DRDY	= 1000  /* 10 s */
+	TIMEOUT_DRDY	= 1000, /* 10 s */
+	TIMEOUT_DMA	= 1000  /* 10 s */
 };
 
 enum ata_dev_type {
@@ -121,6 +134,9 @@ typedef struct {
 	uint64_t blocks;
 	size_t block_size;
 
+	/** Transfer data using bus master DMA */
+	bool dma;
+
 	char model[STR_BOUNDS(40) + 1];
 
 	int disk_id;
@@ -135,10 +151,37 @@ typedef struct ata_ctrl {
 	/** I/O base address of the control registers */
 	uintptr_t ctl_physical;
 
+	/** I/O base address of the bus master registers or 0 */
+	uintptr_t bmi_physical;
+	/** Channel number within the controller */
+	int chan;
+
 	/** Command registers */
 	ata_cmd_t *cmd;
 	/** Control registers */
 	ata_ctl_t *ctl;
+	/** Bus master registers or @c NULL if DMA is not available */
+	ata_bmi_t *bmi;
+
+	/** Physical Region Descriptor Table */
+	ata_prd_t *prdt;
+	uintptr_t prdt_phys;
+	/** Bounce buffer for client buffers that cannot be used for DMA */
+	void *dma_buf;
+	uintptr_t dma_buf_phys;
+
+	/** Interrupt signalling DMA completion or -1 to poll */
+	int irq;
+	cap_irq_handle_t irq_cap;
+	irq_pio_range_t irq_ranges[2];
+	irq_cmd_t irq_cmds[8];
+	/** Protects the interrupt state below */
+	fibril_mutex_t irq_lock;
+	fibril_condvar_t irq_cv;
+	/** Interrupt arrived since the last command was issued */
+	bool irq_done;
+	/** Bus master status read by the interrupt pseudocode */
+	uint8_t irq_bmis;
 
 	/** Per-disk state. */
 	disk_t disk[MAX_DISKS];
@@ -146,6 +189,14 @@ typedef struct ata_ctrl {
 	fibril_mutex_t lock;
 } ata_ctrl_t;
 
+/** ATA device: a single ISA channel or a PCI IDE controller */
+typedef struct {
+	/** Channels */
+	ata_ctrl_t chan[ATA_MAX_CHANNELS];
+	/** Number of channels */
+	int nchans;
+} ata_dev_t;
+
 typedef struct ata_fun {
 	ddf_fun_t *fun;
 	disk_t *disk;
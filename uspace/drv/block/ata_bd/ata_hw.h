@@ -133,12 +133,67 @@ enum ata_command {
 	CMD_READ_SECTORS_EXT	= 0x24,
 	CMD_WRITE_SECTORS	= 0x30,
 	CMD_WRITE_SECTORS_EXT	= 0x34,
+	CMD_READ_DMA_EXT	= 0x25,
+	CMD_WRITE_DMA_EXT	= 0x35,
+	CMD_READ_DMA		= 0xC8,
+	CMD_WRITE_DMA		= 0xCA,
 	CMD_PACKET		= 0xA0,
 	CMD_IDENTIFY_PKT_DEV	= 0xA1,
 	CMD_IDENTIFY_DRIVE	= 0xEC,
 	CMD_FLUSH_CACHE		= 0xE7
 };
 
+/** PCI IDE configuration space registers. */
+enum ata_pci_regs {
+	ATA_PCI_CMD	= 0x04,
+	ATA_PCI_PROG_IF	= 0x09
+};
+
+enum ata_pci_bits {
+	ATA_PCI_CMD_BME		= 0x04, /**< Bus master enable */
+	ATA_PCI_PROG_IF_BM	= 0x80  /**< Bus master IDE capable */
+};
+
+/** Bus Master IDE registers of one channel. */
+typedef struct {
+	uint8_t command;
+	uint8_t pad0;
+	uint8_t status;
+	uint8_t pad1;
+	uint32_t prdt;
+} ata_bmi_t;
+
+enum bmi_command_bits {
+	BMICR_READ	= 0x08, /**< Bus master writes to memory */
+	BMICR_START	= 0x01  /**< Start/Stop Bus Master */
+};
+
+enum bmi_status_bits {
+	BMISR_SIMPLEX	= 0x80, /**< Only one channel can use DMA at a time */
+	BMISR_DRV1_DMA	= 0x40, /**< Drive 1 is DMA capable */
+	BMISR_DRV0_DMA	= 0x20, /**< Drive 0 is DMA capable */
+	BMISR_INTR	= 0x04, /**< Device asserted interrupt */
+	BMISR_ERROR	= 0x02, /**< DMA transfer error */
+	BMISR_ACTIVE	= 0x01  /**< Bus master is active */
+};
+
+/** Physical Region Descriptor. */
+typedef struct {
+	/** Physical address of the region */
+	uint32_t base;
+	/** Byte count, 0 means 64 KiB */
+	uint16_t count;
+	/** PRD_EOT in the last entry of the table */
+	uint16_t flags;
+} ata_prd_t;
+
+enum {
+	/** End of table flag */
+	PRD_EOT		= 0x8000,
+	/** Region must not cross a 64 KiB boundary */
+	PRD_BOUNDARY	= 0x10000
+};
+
 /** Data returned from identify device and identify packet device command. */
 typedef struct {
 	uint16_t gen_conf;
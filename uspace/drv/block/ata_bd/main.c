@@ -40,6 +40,7 @@
 #include <ddf/driver.h>
 #include <ddf/log.h>
 #include <device/hw_res_parsed.h>
+#include <pci_dev_iface.h>
 
 #include "ata_bd.h"
 #include "main.h"
@@ -65,11 +66,26 @@ static driver_t ata_driver = {
 	.driver_ops = &driver_ops
 };
 
-static errno_t ata_get_res(ddf_dev_t *dev, ata_base_t *ata_res)
+/** Get hardware resources of the ATA channels.
+ *
+ * The device is either a single channel described by its command and
+ * control block (ISA), or a PCI IDE controller with two channels, each
+ * described by a command and a control block, optionally followed by
+ * the bus master IDE registers.
+ *
+ * @param dev     Device
+ * @param ata_res Array of ATA_MAX_CHANNELS channel resources to fill in
+ * @param nchans  Place to store number of channels
+ * @param pci     Place to store @c true if @a dev is a PCI IDE controller
+ * @return        EOK on success or an error code.
+ */
+static errno_t ata_get_res(ddf_dev_t *dev, ata_base_t *ata_res, int *nchans,
+    bool *pci)
 {
 	async_sess_t *parent_sess;
 	hw_res_list_parsed_t hw_res;
 	errno_t rc;
+	int i;
 
 	parent_sess = ddf_dev_parent_sess_get(dev);
 	if (parent_sess == NULL)
@@ -80,32 +96,108 @@ static errno_t ata_get_res(ddf_dev_t *dev, ata_base_t *ata_res)
 	if (rc != EOK)
 		return rc;
 
-	if (hw_res.io_ranges.count != 2) {
-		rc = EINVAL;
-		goto error;
-	}
-
-	addr_range_t *cmd_rng = &hw_res.io_ranges.ranges[0];
-	addr_range_t *ctl_rng = &hw_res.io_ranges.ranges[1];
-	ata_res->cmd = RNGABS(*cmd_rng);
-	ata_res->ctl = RNGABS(*ctl_rng);
-
-	if (RNGSZ(*ctl_rng) < sizeof(ata_ctl_t)) {
-		rc = EINVAL;
-		goto error;
-	}
-
-	if (RNGSZ(*cmd_rng) < sizeof(ata_cmd_t)) {
+	if (hw_res.io_ranges.count == 2) {
+		addr_range_t *cmd_rng = &hw_res.io_ranges.ranges[0];
+		addr_range_t *ctl_rng = &hw_res.io_ranges.ranges[1];
+		ata_res[0].cmd = RNGABS(*cmd_rng);
+		ata_res[0].ctl = RNGABS(*ctl_rng);
+		ata_res[0].bmi = 0;
+		ata_res[0].irq = -1;
+
+		if (RNGSZ(*ctl_rng) < sizeof(ata_ctl_t)) {
+			rc = EINVAL;
+			goto error;
+		}
+
+		if (RNGSZ(*cmd_rng) < sizeof(ata_cmd_t)) {
+			rc = EINVAL;
+			goto error;
+		}
+
+		*nchans = 1;
+		*pci = false;
+	} else if (hw_res.io_ranges.count >= 2 * ATA_MAX_CHANNELS) {
+		addr_range_t *bmi_rng = NULL;
+
+		if (hw_res.io_ranges.count > 2 * ATA_MAX_CHANNELS &&
+		    RNGSZ(hw_res.io_ranges.ranges[2 * ATA_MAX_CHANNELS]) >=
+		    ATA_MAX_CHANNELS * 8)
+			bmi_rng = &hw_res.io_ranges.ranges[2 * ATA_MAX_CHANNELS];
+
+		for (i = 0; i < ATA_MAX_CHANNELS; i++) {
+			addr_range_t *cmd_rng = &hw_res.io_ranges.ranges[2 * i];
+			addr_range_t *ctl_rng = &hw_res.io_ranges.ranges[2 * i + 1];
+
+			if (RNGSZ(*cmd_rng) < sizeof(ata_cmd_t) ||
+			    RNGSZ(*ctl_rng) < 4) {
+				rc = EINVAL;
+				goto error;
+			}
+
+			/*
+			 * The PCI control block starts two bytes before the
+			 * alternate status register, ata_ctl_t six bytes.
+			 */
+			ata_res[i].cmd = RNGABS(*cmd_rng);
+			ata_res[i].ctl = RNGABS(*ctl_rng) - 4;
+			ata_res[i].bmi = (bmi_rng != NULL) ?
+			    RNGABS(*bmi_rng) + 8 * i : 0;
+
+			/* Channels share the interrupt in native mode. */
+			if (hw_res.irqs.count > (size_t) i)
+				ata_res[i].irq = hw_res.irqs.irqs[i];
+			else if (hw_res.irqs.count > 0)
+				ata_res[i].irq = hw_res.irqs.irqs[0];
+			else
+				ata_res[i].irq = -1;
+		}
+
+		*nchans = ATA_MAX_CHANNELS;
+		*pci = true;
+	} else {
 		rc = EINVAL;
 		goto error;
 	}
 
+	hw_res_list_parsed_clean(&hw_res);
 	return EOK;
 error:
 	hw_res_list_parsed_clean(&hw_res);
 	return rc;
 }
 
+/** Enable bus mastering of a PCI IDE controller.
+ *
+ * @param dev Device
+ * @return    EOK on success, ENOTSUP if the controller is not capable
+ *            of bus mastering, or an error code.
+ */
+static errno_t ata_pci_enable_dma(ddf_dev_t *dev)
+{
+	async_sess_t *parent_sess;
+	uint8_t progif;
+	uint16_t cmd;
+	errno_t rc;
+
+	parent_sess = ddf_dev_parent_sess_get(dev);
+	if (parent_sess == NULL)
+		return ENOMEM;
+
+	rc = pci_config_space_read_8(parent_sess, ATA_PCI_PROG_IF, &progif);
+	if (rc != EOK)
+		return rc;
+
+	if ((progif & ATA_PCI_PROG_IF_BM) == 0)
+		return ENOTSUP;
+
+	rc = pci_config_space_read_16(parent_sess, ATA_PCI_CMD, &cmd);
+	if (rc != EOK)
+		return rc;
+
+	return pci_config_space_write_16(parent_sess, ATA_PCI_CMD,
+	    cmd | ATA_PCI_CMD_BME);
+}
+
 /** Add new device
  *
  * @param  dev New device
@@ -113,37 +205,71 @@ error:
  */
 static errno_t ata_dev_add(ddf_dev_t *dev)
 {
-	ata_ctrl_t *ctrl;
-	ata_base_t res;
+	ata_dev_t *adev;
+	ata_base_t res[ATA_MAX_CHANNELS];
+	int nchans;
+	bool pci;
+	bool found;
+	int i;
 	errno_t rc;
 
-	rc = ata_get_res(dev, &res);
+	rc = ata_get_res(dev, res, &nchans, &pci);
 	if (rc != EOK) {
 		ddf_msg(LVL_ERROR, "Invalid HW resource configuration.");
 		return EINVAL;
 	}
 
-	ctrl = ddf_dev_data_alloc(dev, sizeof(ata_ctrl_t));
-	if (ctrl == NULL) {
+	if (pci && res[0].bmi != 0) {
+		rc = ata_pci_enable_dma(dev);
+		if (rc != EOK) {
+			ddf_msg(LVL_NOTE, "Bus mastering not available, "
+			    "using PIO.");
+			for (i = 0; i < nchans; i++)
+				res[i].bmi = 0;
+		}
+	}
+
+	i = 0;
+	adev = ddf_dev_data_alloc(dev, sizeof(ata_dev_t));
+	if (adev == NULL) {
 		ddf_msg(LVL_ERROR, "Failed allocating soft state.");
 		rc = ENOMEM;
 		goto error;
 	}
 
-	ctrl->dev = dev;
+	adev->nchans = nchans;
+	found = false;
 
-	rc = ata_ctrl_init(ctrl, &res);
-	if (rc == ENOENT)
-		goto error;
+	for (i = 0; i < nchans; i++) {
+		ata_ctrl_t *ctrl = &adev->chan[i];
 
-	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Failed initializing ATA controller.");
-		rc = EIO;
+		ctrl->dev = dev;
+		ctrl->chan = i;
+
+		rc = ata_ctrl_init(ctrl, &res[i]);
+		if (rc == ENOENT)
+			continue;
+
+		if (rc != EOK) {
+			ddf_msg(LVL_ERROR, "Failed initializing ATA controller.");
+			rc = EIO;
+			goto error;
+		}
+
+		found = true;
+	}
+
+	if (!found) {
+		rc = ENOENT;
 		goto error;
 	}
 
 	return EOK;
 error:
+	while (--i >= 0) {
+		if (ata_ctrl_remove(&adev->chan[i]) != EOK)
+			ddf_msg(LVL_ERROR, "Failed cleaning up channel %d.", i);
+	}
 	return rc;
 }
 
@@ -300,20 +426,36 @@ error:
 
 static errno_t ata_dev_remove(ddf_dev_t *dev)
 {
-	ata_ctrl_t *ctrl = (ata_ctrl_t *)ddf_dev_data_get(dev);
+	ata_dev_t *adev = (ata_dev_t *)ddf_dev_data_get(dev);
+	errno_t rc;
+	int i;
 
 	ddf_msg(LVL_DEBUG, "ata_dev_remove(%p)", dev);
 
-	return ata_ctrl_remove(ctrl);
+	for (i = 0; i < adev->nchans; i++) {
+		rc = ata_ctrl_remove(&adev->chan[i]);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
 }
 
 static errno_t ata_dev_gone(ddf_dev_t *dev)
 {
-	ata_ctrl_t *ctrl = (ata_ctrl_t *)ddf_dev_data_get(dev);
+	ata_dev_t *adev = (ata_dev_t *)ddf_dev_data_get(dev);
+	errno_t rc;
+	int i;
 
 	ddf_msg(LVL_DEBUG, "ata_dev_gone(%p)", dev);
 
-	return ata_ctrl_gone(ctrl);
+	for (i = 0; i < adev->nchans; i++) {
+		rc = ata_ctrl_gone(&adev->chan[i]);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
 }
 
 static errno_t ata_fun_online(ddf_fun_t *fun)
@@ -36,6 +36,8 @@
 
 #include <stdbool.h>
 #include <errno.h>
+#include <macros.h>
+#include <mem.h>
 #include <str_error.h>
 #include <usb/debug.h>
 #include <usb/dev/request.h>
@@ -47,16 +49,75 @@
 #define MASTLOG(format, ...) \
 	usb_log_debug2("USB cl08: " format, ##__VA_ARGS__)
 
-/** Send command via bulk-only transport.
+/** Receive the data stage through the DMA buffer of the device.
  *
- * @param mfun		Mass storage function
- * @param tag		Command block wrapper tag (automatically compared
- *			with answer)
- * @param cmd		SCSI command
+ * Data larger than the buffer are received by several bulk transfers, which
+ * the device sees as one stream of packets.
+ *
+ * @param mdev		Mass storage device
+ * @param buf		Buffer for the data
+ * @param size		Size of the data stage
+ * @param act_size	Place to store the number of bytes received
  *
  * @return		Error code
  */
-errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
+static errno_t usb_massstor_data_in(usbmast_dev_t *mdev, void *buf,
+    size_t size, size_t *act_size)
+{
+	errno_t rc = EOK;
+	size_t done = 0;
+
+	while (done < size) {
+		const size_t chunk = min(size - done, USBMAST_DMA_BUF_SIZE);
+		size_t rcvd;
+
+		rc = usb_pipe_read_dma(mdev->bulk_in_pipe, mdev->dma_buf,
+		    mdev->dma_buf, chunk, &rcvd);
+		if (rc != EOK)
+			break;
+
+		memcpy(buf + done, mdev->dma_buf, rcvd);
+		done += rcvd;
+
+		/* Short transfer ends the data stage */
+		if (rcvd < chunk)
+			break;
+	}
+
+	*act_size = done;
+	return rc;
+}
+
+/** Send the data stage through the DMA buffer of the device.
+ *
+ * @param mdev		Mass storage device
+ * @param data		Data to send
+ * @param size		Size of the data stage
+ *
+ * @return		Error code
+ */
+static errno_t usb_massstor_data_out(usbmast_dev_t *mdev, const void *data,
+    size_t size)
+{
+	size_t done = 0;
+
+	while (done < size) {
+		const size_t chunk = min(size - done, USBMAST_DMA_BUF_SIZE);
+
+		memcpy(mdev->dma_buf, data + done, chunk);
+		const errno_t rc = usb_pipe_write_dma(mdev->bulk_out_pipe,
+		    mdev->dma_buf, mdev->dma_buf, chunk);
+		if (rc != EOK)
+			return rc;
+
+		done += chunk;
+	}
+
+	return EOK;
+}
+
+static errno_t usb_massstor_cmd_locked(usbmast_fun_t *mfun, uint32_t tag,
+    scsi_cmd_t *cmd)
 {
 	errno_t rc;
 
@@ -96,15 +157,16 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	if (cmd->data_in) {
 		size_t act_size;
 		/* Recieve data from the device. */
-		rc = usb_pipe_read(dpipe, cmd->data_in, cmd->data_in_size,
-		    &act_size);
+		rc = usb_massstor_data_in(mfun->mdev, cmd->data_in,
+		    cmd->data_in_size, &act_size);
 		MASTLOG("Received %zu bytes (%s): %s.\n", act_size,
 		    usb_debug_str_buffer(cmd->data_in, act_size, 0),
 		    str_error(rc));
 	}
 	if (cmd->data_out) {
 		/* Send data to the device. */
-		rc = usb_pipe_write(dpipe, cmd->data_out, cmd->data_out_size);
+		rc = usb_massstor_data_out(mfun->mdev, cmd->data_out,
+		    cmd->data_out_size);
 		MASTLOG("Sent %zu bytes (%s): %s.\n", cmd->data_out_size,
 		    usb_debug_str_buffer(cmd->data_out, cmd->data_out_size, 0),
 		    str_error(rc));
@@ -185,6 +247,24 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	return rc;
 }
 
+/** Send command via bulk-only transport.
+ *
+ * @param mfun		Mass storage function
+ * @param tag		Command block wrapper tag (automatically compared
+ *			with answer)
+ * @param cmd		SCSI command
+ *
+ * @return		Error code
+ */
+errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
+{
+	fibril_mutex_lock(&mfun->mdev->cmd_lock);
+	const errno_t rc = usb_massstor_cmd_locked(mfun, tag, cmd);
+	fibril_mutex_unlock(&mfun->mdev->cmd_lock);
+
+	return rc;
+}
+
 /** Perform bulk-only mass storage reset.
  *
  * @param mfun		Mass storage function
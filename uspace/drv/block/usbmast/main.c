@@ -124,6 +124,7 @@ static errno_t usbmast_device_gone(usb_device_t *dev)
 		mdev->luns[i] = NULL;
 	}
 	free(mdev->luns);
+	usb_pipe_free_buffer(mdev->bulk_in_pipe, mdev->dma_buf);
 	return EOK;
 }
 
@@ -185,6 +186,16 @@ static errno_t usbmast_device_add(usb_device_t *dev)
 
 	mdev->bulk_in_pipe = &epm_in->pipe;
 	mdev->bulk_out_pipe = &epm_out->pipe;
+	fibril_mutex_initialize(&mdev->cmd_lock);
+
+	mdev->dma_buf = usb_pipe_alloc_buffer(mdev->bulk_in_pipe,
+	    USBMAST_DMA_BUF_SIZE);
+	if (mdev->dma_buf == NULL) {
+		usb_log_error("Failed allocating DMA buffer.");
+		free(mdev->luns);
+		return ENOMEM;
+	}
+
 	for (i = 0; i < mdev->lun_count; i++) {
 		rc = usbmast_fun_create(mdev, i);
 		if (rc != EOK)
@@ -205,6 +216,7 @@ error:
 		ddf_fun_destroy(mdev->luns[i]);
 	}
 	free(mdev->luns);
+	usb_pipe_free_buffer(mdev->bulk_in_pipe, mdev->dma_buf);
 	return rc;
 }
 
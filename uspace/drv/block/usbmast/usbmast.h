@@ -37,10 +37,17 @@
 #define USBMAST_H_
 
 #include <bd_srv.h>
+#include <fibril_synch.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <usb/usb.h>
 
+/** Size of the DMA buffer used for the data stage of commands.
+ *
+ * Larger data stages are carried by several bulk transfers.
+ */
+#define USBMAST_DMA_BUF_SIZE (64 * 1024)
+
 /** Mass storage device. */
 typedef struct usbmast_dev {
 	/** USB device */
@@ -53,6 +60,10 @@ typedef struct usbmast_dev {
 	usb_pipe_t *bulk_in_pipe;
 	/** Data write pipe */
 	usb_pipe_t *bulk_out_pipe;
+	/** Serializes commands, the transport carries one at a time */
+	fibril_mutex_t cmd_lock;
+	/** DMA buffer for the data stage, see USBMAST_DMA_BUF_SIZE */
+	void *dma_buf;
 } usbmast_dev_t;
 
 /** Mass storage function.
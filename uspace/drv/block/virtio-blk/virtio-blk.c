@@ -31,10 +31,13 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include <align.h>
 #include <as.h>
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
+#include <ddi.h>
+#include <macros.h>
 #include <pci_dev_iface.h>
 #include <fibril_synch.h>
 
@@ -44,23 +47,36 @@
 
 #define NAME	"virtio-blk"
 
-#define VIRTIO_BLK_NUM_QUEUES	1
-
-#define RQ_QUEUE	0
-
 /*
- * VIRTIO_BLK requests need at least two descriptors so that device-read-only
- * buffers are separated from device-writable buffers. For convenience, we
- * always use three descriptors for the request header, buffer and footer.
- * We therefore organize the virtque so that first RQ_BUFFERS descriptors are
- * used for request headers, the following RQ_BUFFERS descriptors are used
- * for in/out buffers and the last RQ_BUFFERS descriptors are used for request
- * footers.
+ * Without indirect descriptors, VIRTIO_BLK requests need at least two
+ * descriptors so that device-read-only buffers are separated from
+ * device-writable buffers. For convenience, we always use three descriptors
+ * for the request header, buffer and footer. We therefore organize the
+ * virtqueue so that first RQ_BUFFERS descriptors are used for request
+ * headers, the following RQ_BUFFERS descriptors are used for in/out buffers
+ * and the last RQ_BUFFERS descriptors are used for request footers.
+ *
+ * With indirect descriptors, each request takes a single descriptor of the
+ * virtqueue, which points to the request's own descriptor table with the
+ * header, the data segments and the footer. The data segments describe the
+ * client's buffer directly, so that no copying is needed.
  */
 #define REQ_HEADER_DESC(descno)	(0 * RQ_BUFFERS + (descno))
 #define REQ_BUFFER_DESC(descno)	(1 * RQ_BUFFERS + (descno))
 #define REQ_FOOTER_DESC(descno)	(2 * RQ_BUFFERS + (descno))
 
+/** Virtqueue size without indirect descriptors (a power of two) */
+#define RQ_QUEUE_SIZE		128
+
+/** Indirect descriptor table entries: header, data segments and footer */
+#define RQ_INDIRECT_DESCS	(VIRTIO_BLK_MAX_SEGS + 2)
+
+/** Data segment of a request */
+typedef struct {
+	uintptr_t phys;
+	size_t len;
+} virtio_blk_seg_t;
+
 static errno_t virtio_blk_dev_add(ddf_dev_t *dev);
 
 static driver_ops_t virtio_blk_driver_ops = {
@@ -72,6 +88,9 @@ static driver_t virtio_blk_driver = {
 	.driver_ops = &virtio_blk_driver_ops
 };
 
+static void virtio_blk_rq_finish(virtio_blk_t *, virtio_blk_queue_t *,
+    uint16_t, bd_req_t *);
+
 static void virtio_blk_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 {
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) ddf_dev_data_get(dev);
@@ -80,11 +99,24 @@ static void virtio_blk_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	uint16_t descno;
 	uint32_t len;
 
-	while (virtio_virtq_consume_used(vdev, RQ_QUEUE, &descno, &len)) {
-		assert(descno < RQ_BUFFERS);
-		fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
-		fibril_condvar_signal(&virtio_blk->completion_cv[descno]);
-		fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
+	for (unsigned i = 0; i < virtio_blk->num_queues; i++) {
+		virtio_blk_queue_t *q = &virtio_blk->queues[i];
+
+		while (virtio_virtq_consume_used(vdev, q->num, &descno, &len)) {
+			assert(descno < RQ_BUFFERS);
+			fibril_mutex_lock(&q->lock);
+			bd_req_t *req = q->rq_req[descno];
+			q->rq_req[descno] = NULL;
+			if (req == NULL) {
+				q->rq_done[descno] = true;
+				fibril_condvar_signal(&q->completion_cv[descno]);
+			}
+			fibril_mutex_unlock(&q->lock);
+
+			/* Nobody waits for a queued request, complete it here */
+			if (req != NULL)
+				virtio_blk_rq_finish(virtio_blk, q, descno, req);
+		}
 	}
 }
 
@@ -157,71 +189,129 @@ static errno_t virtio_blk_bd_close(bd_srv_t *bd)
 	return EOK;
 }
 
-static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
-    aoff64_t ba, void *buf)
+/** Pick the request queue with the fewest requests in flight. */
+static virtio_blk_queue_t *virtio_blk_queue_get(virtio_blk_t *virtio_blk)
+{
+	virtio_blk_queue_t *q = &virtio_blk->queues[0];
+
+	for (unsigned i = 1; i < virtio_blk->num_queues; i++) {
+		if (virtio_blk->queues[i].rq_busy < q->rq_busy)
+			q = &virtio_blk->queues[i];
+	}
+
+	return q;
+}
+
+/** Allocate a request slot in a queue, waiting for one to become free.
+ *
+ * The allocated descno will determine the header descriptor
+ * (REQ_HEADER_DESC), the buffer descriptor (REQ_BUFFER_DESC) and the
+ * footer (REQ_FOOTER_DESC) descriptor, or the indirect descriptor table.
+ */
+static uint16_t virtio_blk_rq_alloc(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q)
 {
 	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
 
-	/*
-	 * Allocate a descriptor.
-	 *
-	 * The allocated descno will determine the header descriptor
-	 * (REQ_HEADER_DESC), the buffer descriptor (REQ_BUFFER_DESC) and the
-	 * footer (REQ_FOOTER_DESC) descriptor.
-	 */
-	fibril_mutex_lock(&virtio_blk->free_lock);
-	uint16_t descno = virtio_alloc_desc(vdev, RQ_QUEUE,
-	    &virtio_blk->rq_free_head);
+	fibril_mutex_lock(&q->lock);
+	uint16_t descno = virtio_alloc_desc(vdev, q->num, &q->rq_free_head);
 	while (descno == (uint16_t) -1U) {
-		fibril_condvar_wait(&virtio_blk->free_cv,
-		    &virtio_blk->free_lock);
-		descno = virtio_alloc_desc(vdev, RQ_QUEUE,
-		    &virtio_blk->rq_free_head);
+		fibril_condvar_wait(&q->free_cv, &q->lock);
+		descno = virtio_alloc_desc(vdev, q->num, &q->rq_free_head);
 	}
-	fibril_mutex_unlock(&virtio_blk->free_lock);
+	q->rq_busy++;
+	fibril_mutex_unlock(&q->lock);
 
 	assert(descno < RQ_BUFFERS);
+	return descno;
+}
+
+/** Free a request slot. */
+static void virtio_blk_rq_free(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q, uint16_t descno)
+{
+	fibril_mutex_lock(&q->lock);
+	virtio_free_desc(&virtio_blk->virtio_dev, q->num, &q->rq_free_head,
+	    descno);
+	q->rq_busy--;
+	fibril_condvar_signal(&q->free_cv);
+	fibril_mutex_unlock(&q->lock);
+}
+
+/** Pass a request to the device.
+ *
+ * @param virtio_blk Device
+ * @param q Request queue
+ * @param descno Request slot
+ * @param read @c true to read from the device, @c false to write
+ * @param ba Address of the first block
+ * @param segs Data segments
+ * @param nsegs Number of data segments (1 without indirect descriptors)
+ * @param req Queued client request to complete from the interrupt handler
+ *        or @c NULL if the caller waits for the completion
+ */
+static void virtio_blk_rq_start(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q, uint16_t descno, bool read, aoff64_t ba,
+    virtio_blk_seg_t *segs, size_t nsegs, bd_req_t *req)
+{
+	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
+	uint16_t dflags = VIRTQ_DESC_F_NEXT | (read ? VIRTQ_DESC_F_WRITE : 0);
 
 	/* Setup the request header */
 	virtio_blk_req_header_t *req_header =
-	    (virtio_blk_req_header_t *) virtio_blk->rq_header[descno];
+	    (virtio_blk_req_header_t *) q->rq_header[descno];
 	memset(req_header, 0, sizeof(virtio_blk_req_header_t));
 	pio_write_le32(&req_header->type,
 	    read ? VIRTIO_BLK_T_IN : VIRTIO_BLK_T_OUT);
 	pio_write_le64(&req_header->sector, ba);
 
-	/* Copy write data to the request. */
-	if (!read)
-		memcpy(virtio_blk->rq_buf[descno], buf, VIRTIO_BLK_BLOCK_SIZE);
-
-	fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
+	fibril_mutex_lock(&q->lock);
+	q->rq_done[descno] = false;
+	q->rq_req[descno] = req;
+	fibril_mutex_unlock(&q->lock);
 
 	/*
 	 * Set the descriptors, chain them in the virtqueue and notify the
 	 * device.
 	 */
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_HEADER_DESC(descno),
-	    virtio_blk->rq_header_p[descno], sizeof(virtio_blk_req_header_t),
-	    VIRTQ_DESC_F_NEXT, REQ_BUFFER_DESC(descno));
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_BUFFER_DESC(descno),
-	    virtio_blk->rq_buf_p[descno], VIRTIO_BLK_BLOCK_SIZE,
-	    VIRTQ_DESC_F_NEXT | (read ? VIRTQ_DESC_F_WRITE : 0),
-	    REQ_FOOTER_DESC(descno));
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_FOOTER_DESC(descno),
-	    virtio_blk->rq_footer_p[descno], sizeof(virtio_blk_req_footer_t),
-	    VIRTQ_DESC_F_WRITE, 0);
-	virtio_virtq_produce_available(vdev, RQ_QUEUE, descno);
+	if (virtio_blk->indirect) {
+		virtq_desc_t *table = (virtq_desc_t *) q->rq_indirect[descno];
+
+		virtio_indirect_desc_set(table, 0, q->rq_header_p[descno],
+		    sizeof(virtio_blk_req_header_t), VIRTQ_DESC_F_NEXT, 1);
+		for (size_t i = 0; i < nsegs; i++) {
+			virtio_indirect_desc_set(table, i + 1, segs[i].phys,
+			    segs[i].len, dflags, i + 2);
+		}
+		virtio_indirect_desc_set(table, nsegs + 1,
+		    q->rq_footer_p[descno], sizeof(virtio_blk_req_footer_t),
+		    VIRTQ_DESC_F_WRITE, 0);
+
+		virtio_virtq_desc_set(vdev, q->num, descno,
+		    q->rq_indirect_p[descno], (nsegs + 2) * sizeof(virtq_desc_t),
+		    VIRTQ_DESC_F_INDIRECT, 0);
+	} else {
+		assert(nsegs == 1);
+
+		virtio_virtq_desc_set(vdev, q->num, REQ_HEADER_DESC(descno),
+		    q->rq_header_p[descno], sizeof(virtio_blk_req_header_t),
+		    VIRTQ_DESC_F_NEXT, REQ_BUFFER_DESC(descno));
+		virtio_virtq_desc_set(vdev, q->num, REQ_BUFFER_DESC(descno),
+		    segs[0].phys, segs[0].len, dflags, REQ_FOOTER_DESC(descno));
+		virtio_virtq_desc_set(vdev, q->num, REQ_FOOTER_DESC(descno),
+		    q->rq_footer_p[descno], sizeof(virtio_blk_req_footer_t),
+		    VIRTQ_DESC_F_WRITE, 0);
+	}
 
-	/*
-	 * Wait for the completion of the request.
-	 */
-	fibril_condvar_wait(&virtio_blk->completion_cv[descno],
-	    &virtio_blk->completion_lock[descno]);
-	fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
+	virtio_virtq_produce_available(vdev, q->num, descno);
+}
 
+/** Get the result of a request completed by the device. */
+static errno_t virtio_blk_rq_status(virtio_blk_queue_t *q, uint16_t descno)
+{
 	errno_t rc;
 	virtio_blk_req_footer_t *footer =
-	    (virtio_blk_req_footer_t *) virtio_blk->rq_footer[descno];
+	    (virtio_blk_req_footer_t *) q->rq_footer[descno];
 	switch (footer->status) {
 	case VIRTIO_BLK_S_OK:
 		rc = EOK;
@@ -239,16 +329,164 @@ static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
 		break;
 	}
 
-	/* Copy read data from the request */
-	if (rc == EOK && read)
-		memcpy(buf, virtio_blk->rq_buf[descno], VIRTIO_BLK_BLOCK_SIZE);
+	return rc;
+}
+
+/** Submit a request to the device and wait for its completion.
+ *
+ * @param virtio_blk Device
+ * @param q Request queue
+ * @param descno Request slot
+ * @param read @c true to read from the device, @c false to write
+ * @param ba Address of the first block
+ * @param segs Data segments
+ * @param nsegs Number of data segments (1 without indirect descriptors)
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_blk_rq_submit(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q, uint16_t descno, bool read, aoff64_t ba,
+    virtio_blk_seg_t *segs, size_t nsegs)
+{
+	virtio_blk_rq_start(virtio_blk, q, descno, read, ba, segs, nsegs,
+	    NULL);
+
+	/*
+	 * Wait for the completion of the request.
+	 */
+	fibril_mutex_lock(&q->lock);
+	while (!q->rq_done[descno])
+		fibril_condvar_wait(&q->completion_cv[descno], &q->lock);
+	fibril_mutex_unlock(&q->lock);
+
+	return virtio_blk_rq_status(q, descno);
+}
+
+/** Unmap the first @a size bytes of a buffer mapped for DMA. */
+static void virtio_blk_buf_unmap(void *buf, size_t size)
+{
+	uint8_t *p = buf;
+
+	while (size > 0) {
+		size_t len = min(size, PAGE_SIZE - ((uintptr_t) p % PAGE_SIZE));
+		(void) dmamem_unmap(p, len);
+		p += len;
+		size -= len;
+	}
+}
+
+/** Map a client buffer for DMA.
+ *
+ * The buffer is described page by page, physically contiguous pages are
+ * merged into one segment.
+ *
+ * @param virtio_blk Device
+ * @param buf Buffer
+ * @param size Size of the buffer
+ * @param read @c true if the device is going to write to the buffer
+ * @param segs Array for at least VIRTIO_BLK_MAX_SEGS segments
+ * @param nsegs Place to store the number of segments
+ * @return EOK on success, an error code if the buffer cannot be described
+ *         within the limits of the device
+ */
+static errno_t virtio_blk_buf_map(virtio_blk_t *virtio_blk, void *buf,
+    size_t size, bool read, virtio_blk_seg_t *segs, size_t *nsegs)
+{
+	uint8_t *p = buf;
+	size_t mapped = 0;
+	size_t n = 0;
+	errno_t rc;
+
+	while (mapped < size) {
+		size_t len = min(size - mapped,
+		    PAGE_SIZE - ((uintptr_t) p % PAGE_SIZE));
+		uintptr_t phys;
 
-	/* Free the descriptor and buffer */
-	fibril_mutex_lock(&virtio_blk->free_lock);
-	virtio_free_desc(vdev, RQ_QUEUE, &virtio_blk->rq_free_head, descno);
-	fibril_condvar_signal(&virtio_blk->free_cv);
-	fibril_mutex_unlock(&virtio_blk->free_lock);
+		/* Make sure the page is backed by a frame */
+		if (read)
+			*(volatile uint8_t *) p = 0;
+		else
+			(void) *(volatile uint8_t *) p;
 
+		rc = dmamem_map(p, len, 0, 0, &phys);
+		if (rc != EOK)
+			goto error;
+
+		if (n > 0 && segs[n - 1].phys + segs[n - 1].len == phys &&
+		    segs[n - 1].len + len <= virtio_blk->size_max) {
+			segs[n - 1].len += len;
+		} else if (n < virtio_blk->seg_max &&
+		    len <= virtio_blk->size_max) {
+			segs[n].phys = phys;
+			segs[n].len = len;
+			n++;
+		} else {
+			(void) dmamem_unmap(p, len);
+			rc = ELIMIT;
+			goto error;
+		}
+
+		p += len;
+		mapped += len;
+	}
+
+	*nsegs = n;
+	return EOK;
+error:
+	virtio_blk_buf_unmap(buf, mapped);
+	return rc;
+}
+
+/** Read or write blocks with a single request if possible.
+ *
+ * The data is transferred directly from or to @a buf if it can be mapped,
+ * otherwise it goes through the bounce buffer of the request.
+ */
+static errno_t virtio_blk_rw(virtio_blk_t *virtio_blk, bool read,
+    aoff64_t ba, size_t cnt, void *buf)
+{
+	virtio_blk_queue_t *q = virtio_blk_queue_get(virtio_blk);
+	uint16_t descno = virtio_blk_rq_alloc(virtio_blk, q);
+	virtio_blk_seg_t segs[VIRTIO_BLK_MAX_SEGS];
+	size_t size = cnt * VIRTIO_BLK_BLOCK_SIZE;
+	size_t nsegs;
+	errno_t rc;
+
+	if (virtio_blk->indirect && virtio_blk_buf_map(virtio_blk, buf, size,
+	    read, segs, &nsegs) == EOK) {
+		rc = virtio_blk_rq_submit(virtio_blk, q, descno, read, ba,
+		    segs, nsegs);
+		virtio_blk_buf_unmap(buf, size);
+		virtio_blk_rq_free(virtio_blk, q, descno);
+		return rc;
+	}
+
+	size_t bounce_size = min(VIRTIO_BLK_BOUNCE_SIZE,
+	    ALIGN_DOWN(virtio_blk->size_max, VIRTIO_BLK_BLOCK_SIZE));
+	uint8_t *p = buf;
+
+	rc = EOK;
+	while (size > 0 && rc == EOK) {
+		size_t len = min(size, bounce_size);
+
+		/* Copy write data to the request. */
+		if (!read)
+			memcpy(q->rq_buf[descno], p, len);
+
+		segs[0].phys = q->rq_buf_p[descno];
+		segs[0].len = len;
+		rc = virtio_blk_rq_submit(virtio_blk, q, descno, read, ba,
+		    segs, 1);
+
+		/* Copy read data from the request */
+		if (rc == EOK && read)
+			memcpy(p, q->rq_buf[descno], len);
+
+		ba += len / VIRTIO_BLK_BLOCK_SIZE;
+		p += len;
+		size -= len;
+	}
+
+	virtio_blk_rq_free(virtio_blk, q, descno);
 	return rc;
 }
 
@@ -256,17 +494,22 @@ static errno_t virtio_blk_bd_rw_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
     void *buf, size_t size, bool read)
 {
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) bd->srvs->sarg;
-	aoff64_t i;
+	size_t max_blocks = VIRTIO_BLK_MAX_XFER / VIRTIO_BLK_BLOCK_SIZE;
 	errno_t rc;
 
 	if (size != cnt * VIRTIO_BLK_BLOCK_SIZE)
 		return EINVAL;
 
-	for (i = 0; i < cnt; i++) {
-		rc = virtio_blk_rw_block(virtio_blk, read, ba + i,
-		    buf + i * VIRTIO_BLK_BLOCK_SIZE);
+	while (cnt > 0) {
+		size_t n = min(cnt, max_blocks);
+
+		rc = virtio_blk_rw(virtio_blk, read, ba, n, buf);
 		if (rc != EOK)
 			return rc;
+
+		ba += n;
+		cnt -= n;
+		buf += n * VIRTIO_BLK_BLOCK_SIZE;
 	}
 
 	return EOK;
@@ -284,6 +527,47 @@ static errno_t virtio_blk_bd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 	return virtio_blk_bd_rw_blocks(bd, ba, cnt, (void *) buf, size, false);
 }
 
+/** Complete a queued client request finished by the device. */
+static void virtio_blk_rq_finish(virtio_blk_t *virtio_blk,
+    virtio_blk_queue_t *q, uint16_t descno, bd_req_t *req)
+{
+	errno_t rc = virtio_blk_rq_status(q, descno);
+
+	virtio_blk_buf_unmap(req->buf, req->cnt * VIRTIO_BLK_BLOCK_SIZE);
+	virtio_blk_rq_free(virtio_blk, q, descno);
+	bd_req_complete(req, rc);
+}
+
+/** Start a queued client request.
+ *
+ * The data segments describe the buffer shared with the client, so that
+ * the device transfers the data directly from or to the client. Requests
+ * which cannot be passed to the device as a single request are left to
+ * virtio_blk_bd_read_blocks() and virtio_blk_bd_write_blocks().
+ */
+static errno_t virtio_blk_bd_submit(bd_srv_t *bd, bd_req_t *req)
+{
+	virtio_blk_t *virtio_blk = (virtio_blk_t *) bd->srvs->sarg;
+	virtio_blk_seg_t segs[VIRTIO_BLK_MAX_SEGS];
+	size_t size = req->cnt * VIRTIO_BLK_BLOCK_SIZE;
+	bool read = req->type == BD_REQ_READ;
+	size_t nsegs;
+
+	if (!virtio_blk->indirect || size == 0 || size > VIRTIO_BLK_MAX_XFER)
+		return ENOTSUP;
+
+	if (virtio_blk_buf_map(virtio_blk, req->buf, size, read, segs,
+	    &nsegs) != EOK)
+		return ENOTSUP;
+
+	virtio_blk_queue_t *q = virtio_blk_queue_get(virtio_blk);
+	uint16_t descno = virtio_blk_rq_alloc(virtio_blk, q);
+
+	virtio_blk_rq_start(virtio_blk, q, descno, read, req->ba, segs, nsegs,
+	    req);
+	return EOK;
+}
+
 static errno_t virtio_blk_bd_get_block_size(bd_srv_t *bd, size_t *size)
 {
 	*size = VIRTIO_BLK_BLOCK_SIZE;
@@ -305,8 +589,78 @@ bd_ops_t virtio_blk_bd_ops = {
 	.write_blocks = virtio_blk_bd_write_blocks,
 	.get_block_size = virtio_blk_bd_get_block_size,
 	.get_num_blocks = virtio_blk_bd_get_num_blocks,
+	.submit = virtio_blk_bd_submit
 };
 
+/** Set up a request queue and its DMA buffers. */
+static errno_t virtio_blk_queue_setup(virtio_blk_t *virtio_blk, uint16_t num)
+{
+	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
+	virtio_blk_queue_t *q = &virtio_blk->queues[num];
+	errno_t rc;
+
+	q->num = num;
+	fibril_mutex_initialize(&q->lock);
+	fibril_condvar_initialize(&q->free_cv);
+	for (unsigned i = 0; i < RQ_BUFFERS; i++)
+		fibril_condvar_initialize(&q->completion_cv[i]);
+
+	/*
+	 * With indirect descriptors, each request needs one descriptor,
+	 * otherwise 3.
+	 */
+	rc = virtio_virtq_setup(vdev, num, virtio_blk->indirect ?
+	    RQ_BUFFERS : RQ_QUEUE_SIZE);
+	if (rc != EOK)
+		return rc;
+
+	/*
+	 * Setup DMA buffers
+	 */
+	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_header_t),
+	    true, q->rq_header, q->rq_header_p);
+	if (rc != EOK)
+		return rc;
+	rc = virtio_setup_dma_bufs(RQ_BUFFERS, VIRTIO_BLK_BOUNCE_SIZE,
+	    true, q->rq_buf, q->rq_buf_p);
+	if (rc != EOK)
+		return rc;
+	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_footer_t),
+	    false, q->rq_footer, q->rq_footer_p);
+	if (rc != EOK)
+		return rc;
+	if (virtio_blk->indirect) {
+		rc = virtio_setup_dma_bufs(RQ_BUFFERS,
+		    RQ_INDIRECT_DESCS * sizeof(virtq_desc_t), true,
+		    q->rq_indirect, q->rq_indirect_p);
+		if (rc != EOK)
+			return rc;
+	}
+
+	/*
+	 * Put all request descriptors on a free list. Because of the
+	 * correspondence between the request, buffer and footer descriptors,
+	 * we only need to manage allocations for one set: the request header
+	 * descriptors.
+	 */
+	virtio_create_desc_free_list(vdev, num, RQ_BUFFERS, &q->rq_free_head);
+
+	return EOK;
+}
+
+/** Release the DMA buffers of all request queues. */
+static void virtio_blk_queues_teardown(virtio_blk_t *virtio_blk)
+{
+	for (unsigned i = 0; i < VIRTIO_BLK_MAX_QUEUES; i++) {
+		virtio_blk_queue_t *q = &virtio_blk->queues[i];
+
+		virtio_teardown_dma_bufs(q->rq_header);
+		virtio_teardown_dma_bufs(q->rq_buf);
+		virtio_teardown_dma_bufs(q->rq_footer);
+		virtio_teardown_dma_bufs(q->rq_indirect);
+	}
+}
+
 static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 {
 	virtio_blk_t *virtio_blk = ddf_dev_data_alloc(dev,
@@ -314,14 +668,6 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	if (!virtio_blk)
 		return ENOMEM;
 
-	fibril_mutex_initialize(&virtio_blk->free_lock);
-	fibril_condvar_initialize(&virtio_blk->free_cv);
-
-	for (unsigned i = 0; i < RQ_BUFFERS; i++) {
-		fibril_mutex_initialize(&virtio_blk->completion_lock[i]);
-		fibril_condvar_initialize(&virtio_blk->completion_cv[i]);
-	}
-
 	bd_srvs_init(&virtio_blk->bds);
 	virtio_blk->bds.ops = &virtio_blk_bd_ops;
 	virtio_blk->bds.sarg = virtio_blk;
@@ -332,6 +678,7 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 
 	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
 	virtio_pci_common_cfg_t *cfg = virtio_blk->virtio_dev.common_cfg;
+	virtio_blk_cfg_t *blkcfg = virtio_blk->virtio_dev.device_cfg;
 
 	/*
 	 * Register IRQ
@@ -341,58 +688,62 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev, 0);
+	rc = virtio_device_setup_negotiate(vdev, 0, VIRTIO_F_INDIRECT_DESC |
+	    VIRTIO_F_EVENT_IDX | VIRTIO_BLK_F_SIZE_MAX | VIRTIO_BLK_F_SEG_MAX |
+	    VIRTIO_BLK_F_MQ);
 	if (rc != EOK)
 		goto fail;
 
 	/* Perform device-specific setup */
+	virtio_blk->indirect = (vdev->features & VIRTIO_F_INDIRECT_DESC) != 0;
+
+	virtio_blk->seg_max = VIRTIO_BLK_MAX_SEGS;
+	if (vdev->features & VIRTIO_BLK_F_SEG_MAX) {
+		uint32_t seg_max = pio_read_le32(&blkcfg->seg_max);
+		if (seg_max > 0)
+			virtio_blk->seg_max = min(seg_max, VIRTIO_BLK_MAX_SEGS);
+	}
+
+	virtio_blk->size_max = VIRTIO_BLK_MAX_XFER;
+	if (vdev->features & VIRTIO_BLK_F_SIZE_MAX) {
+		uint32_t size_max = pio_read_le32(&blkcfg->size_max);
+		if (size_max >= VIRTIO_BLK_BLOCK_SIZE)
+			virtio_blk->size_max = min(size_max, VIRTIO_BLK_MAX_XFER);
+	}
+
+	virtio_blk->num_queues = 1;
+	if (vdev->features & VIRTIO_BLK_F_MQ) {
+		uint16_t nq = pio_read_le16(&blkcfg->num_queues);
+		virtio_blk->num_queues = max(1, min(nq, VIRTIO_BLK_MAX_QUEUES));
+	}
 
 	/*
-	 * Discover and configure the virtqueue
+	 * Discover and configure the virtqueues
 	 */
 	uint16_t num_queues = pio_read_le16(&cfg->num_queues);
-	if (num_queues != VIRTIO_BLK_NUM_QUEUES) {
+	if (num_queues < virtio_blk->num_queues) {
 		ddf_msg(LVL_NOTE, "Unsupported number of virtqueues: %u",
 		    num_queues);
 		rc = ELIMIT;
 		goto fail;
 	}
 
-	vdev->queues = calloc(sizeof(virtq_t), num_queues);
+	vdev->queues = calloc(sizeof(virtq_t), virtio_blk->num_queues);
 	if (!vdev->queues) {
 		rc = ENOMEM;
 		goto fail;
 	}
 
-	/* For each in/out request we need 3 descriptors */
-	rc = virtio_virtq_setup(vdev, RQ_QUEUE, 3 * RQ_BUFFERS);
-	if (rc != EOK)
-		goto fail;
-
-	/*
-	 * Setup DMA buffers
-	 */
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_header_t),
-	    true, virtio_blk->rq_header, virtio_blk->rq_header_p);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, VIRTIO_BLK_BLOCK_SIZE,
-	    true, virtio_blk->rq_buf, virtio_blk->rq_buf_p);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_footer_t),
-	    false, virtio_blk->rq_footer, virtio_blk->rq_footer_p);
-	if (rc != EOK)
-		goto fail;
+	for (unsigned i = 0; i < virtio_blk->num_queues; i++) {
+		rc = virtio_blk_queue_setup(virtio_blk, i);
+		if (rc != EOK)
+			goto fail;
+	}
 
-	/*
-	 * Put all request descriptors on a free list. Because of the
-	 * correspondence between the request, buffer and footer descriptors,
-	 * we only need to manage allocations for one set: the request header
-	 * descriptors.
-	 */
-	virtio_create_desc_free_list(vdev, RQ_QUEUE, RQ_BUFFERS,
-	    &virtio_blk->rq_free_head);
+	ddf_msg(LVL_NOTE, "%u request queue(s), indirect descriptors %s, "
+	    "event index %s", virtio_blk->num_queues,
+	    virtio_blk->indirect ? "on" : "off",
+	    (vdev->features & VIRTIO_F_EVENT_IDX) ? "on" : "off");
 
 	/*
 	 * Enable IRQ
@@ -412,9 +763,7 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	return EOK;
 
 fail:
-	virtio_teardown_dma_bufs(virtio_blk->rq_header);
-	virtio_teardown_dma_bufs(virtio_blk->rq_buf);
-	virtio_teardown_dma_bufs(virtio_blk->rq_footer);
+	virtio_blk_queues_teardown(virtio_blk);
 
 	virtio_device_setup_fail(vdev);
 	virtio_pci_dev_cleanup(vdev);
@@ -425,9 +774,7 @@ static void virtio_blk_uninitialize(ddf_dev_t *dev)
 {
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) ddf_dev_data_get(dev);
 
-	virtio_teardown_dma_bufs(virtio_blk->rq_header);
-	virtio_teardown_dma_bufs(virtio_blk->rq_buf);
-	virtio_teardown_dma_bufs(virtio_blk->rq_footer);
+	virtio_blk_queues_teardown(virtio_blk);
 
 	virtio_device_setup_fail(&virtio_blk->virtio_dev);
 	virtio_pci_dev_cleanup(&virtio_blk->virtio_dev);
@@ -32,6 +32,8 @@
 #include <virtio-pci.h>
 #include <bd_srv.h>
 #include <abi/cap.h>
+#include <abi/ipc/ipc.h>
+#include <as.h>
 
 #include <fibril_synch.h>
 
@@ -46,10 +48,29 @@
 #define VIRTIO_BLK_S_IOERR	1
 #define VIRTIO_BLK_S_UNSUPP	2
 
+/** Number of requests which can be in flight in one virtqueue */
 #define RQ_BUFFERS	32
 
+/** Maximum number of virtqueues used */
+#define VIRTIO_BLK_MAX_QUEUES	4
+
+/** Largest transfer submitted as a single request */
+#define VIRTIO_BLK_MAX_XFER	DATA_XFER_LIMIT
+
+/** Maximum number of data segments of a request */
+#define VIRTIO_BLK_MAX_SEGS	(VIRTIO_BLK_MAX_XFER / PAGE_SIZE + 1)
+
+/** Size of the bounce buffer of a request */
+#define VIRTIO_BLK_BOUNCE_SIZE	(16 * 1024)
+
+/** Maximum segment size is in size_max. */
+#define VIRTIO_BLK_F_SIZE_MAX	(1U << 1)
+/** Maximum number of segments is in seg_max. */
+#define VIRTIO_BLK_F_SEG_MAX	(1U << 2)
 /** Device is read-only. */
 #define VIRTIO_BLK_F_RO		(1U << 5)
+/** Number of request queues is in num_queues. */
+#define VIRTIO_BLK_F_MQ		(1U << 12)
 
 typedef struct {
 	uint32_t type;
@@ -63,32 +84,75 @@ typedef struct {
 
 typedef struct {
 	uint64_t capacity;
+	uint32_t size_max;
+	uint32_t seg_max;
+	struct {
+		uint16_t cylinders;
+		uint8_t heads;
+		uint8_t sectors;
+	} geometry;
+	uint32_t blk_size;
+	struct {
+		uint8_t physical_block_exp;
+		uint8_t alignment_offset;
+		uint16_t min_io_size;
+		uint32_t opt_io_size;
+	} topology;
+	uint8_t writeback;
+	uint8_t unused0;
+	uint16_t num_queues;
 } virtio_blk_cfg_t;
 
+/** Request virtqueue */
 typedef struct {
-	virtio_dev_t virtio_dev;
+	/** Index of the virtqueue */
+	uint16_t num;
 
 	void *rq_header[RQ_BUFFERS];
 	uintptr_t rq_header_p[RQ_BUFFERS];
 
+	/** Bounce buffers for data which cannot be mapped directly */
 	void *rq_buf[RQ_BUFFERS];
 	uintptr_t rq_buf_p[RQ_BUFFERS];
 
 	void *rq_footer[RQ_BUFFERS];
 	uintptr_t rq_footer_p[RQ_BUFFERS];
 
+	/** Indirect descriptor tables */
+	void *rq_indirect[RQ_BUFFERS];
+	uintptr_t rq_indirect_p[RQ_BUFFERS];
+
 	uint16_t rq_free_head;
+	/** Number of requests in flight */
+	unsigned rq_busy;
+	/** The device has completed the request */
+	bool rq_done[RQ_BUFFERS];
+	/** Queued client request completed from the interrupt handler */
+	bd_req_t *rq_req[RQ_BUFFERS];
+
+	/** Lock protecting the free list and the completion flags */
+	fibril_mutex_t lock;
+	fibril_condvar_t free_cv;
+	fibril_condvar_t completion_cv[RQ_BUFFERS];
+} virtio_blk_queue_t;
+
+typedef struct {
+	virtio_dev_t virtio_dev;
+
+	virtio_blk_queue_t queues[VIRTIO_BLK_MAX_QUEUES];
+	unsigned num_queues;
+
+	/** Requests are described by indirect descriptor tables */
+	bool indirect;
+	/** Maximum number of data segments of a request */
+	size_t seg_max;
+	/** Maximum size of a data segment */
+	size_t size_max;
 
 	int irq;
 	cap_irq_handle_t irq_handle;
 
 	bd_srvs_t bds;
-
-	fibril_mutex_t free_lock;
-	fibril_condvar_t free_cv;
-
-	fibril_mutex_t completion_lock[RQ_BUFFERS];
-	fibril_condvar_t completion_cv[RQ_BUFFERS];
 } virtio_blk_t;
 
 #endif
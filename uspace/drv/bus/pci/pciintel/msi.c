@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup pciintel
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Message signaled interrupts.
+ *
+ * The kernel reserves a small block of interrupt vectors for message
+ * signaled interrupts and publishes the message address, the data value of
+ * the first vector and the IRQ number it is dispatched as in sysinfo. The
+ * vectors are shared by all functions on the bus and are handed out here.
+ *
+ * A function is given a block of consecutive IRQs. MSI-X is preferred, since
+ * every table entry is programmed separately. With plain MSI the device
+ * modifies the low bits of the data value, so the block must be a power of
+ * two in size and its first vector must be aligned to it.
+ */
+
+#include <ddi.h>
+#include <ddf/log.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <pci_dev_iface.h>
+#include <sysinfo.h>
+
+#include "msi.h"
+#include "pci.h"
+#include "pci_regs.h"
+
+/** Maximum number of MSI vectors the allocator can track */
+#define MSI_MAX_VECTORS 64
+
+/** Maximum number of messages a function can request with plain MSI */
+#define MSI_MAX_MESSAGES 32
+
+static FIBRIL_MUTEX_INITIALIZE(msi_lock);
+
+/** Allocator state, read from sysinfo on first use */
+static bool msi_initialized;
+static bool msi_supported;
+static uint64_t msi_address;
+static sysarg_t msi_data;
+static sysarg_t msi_inr;
+static size_t msi_vectors;
+/** Bitmap of allocated vectors */
+static uint64_t msi_used;
+
+static void msi_init(void)
+{
+	sysarg_t address, data, inr, count;
+
+	if (msi_initialized)
+		return;
+
+	msi_initialized = true;
+
+	if (sysinfo_get_value("msi.address", &address) != EOK ||
+	    sysinfo_get_value("msi.data", &data) != EOK ||
+	    sysinfo_get_value("msi.inr", &inr) != EOK ||
+	    sysinfo_get_value("msi.count", &count) != EOK || count == 0)
+		return;
+
+	msi_address = address;
+	msi_data = data;
+	msi_inr = inr;
+	msi_vectors = min(count, MSI_MAX_VECTORS);
+	msi_supported = true;
+}
+
+static uint64_t msi_mask(size_t first, size_t count)
+{
+	uint64_t mask = (count == 64) ? UINT64_MAX : ((1ULL << count) - 1);
+
+	return mask << first;
+}
+
+/** Allocate a block of consecutive vectors.
+ *
+ * @param count Number of vectors
+ * @param align If @c true, the data value of the first vector must be
+ *              aligned to @a count
+ * @param first Place to store the index of the first vector
+ * @return EOK on success, ENOENT if there is no free block
+ */
+static errno_t msi_alloc(size_t count, bool align, size_t *first)
+{
+	size_t i;
+
+	for (i = 0; i + count <= msi_vectors; i++) {
+		if (align && ((msi_data + i) % count) != 0)
+			continue;
+
+		if ((msi_used & msi_mask(i, count)) == 0) {
+			msi_used |= msi_mask(i, count);
+			*first = i;
+			return EOK;
+		}
+	}
+
+	return ENOENT;
+}
+
+static void msi_free(size_t first, size_t count)
+{
+	msi_used &= ~msi_mask(first, count);
+}
+
+/** Find a capability in the function's capability list.
+ *
+ * @return Offset of the capability in configuration space or 0
+ */
+static uint8_t pci_find_cap(pci_fun_t *fun, uint8_t id)
+{
+	uint8_t ptr;
+	unsigned int ttl = 48;
+
+	if ((pci_conf_read_16(fun, PCI_STATUS) & PCI_STATUS_CAP_LIST) == 0)
+		return 0;
+
+	ptr = pci_conf_read_8(fun, PCI_CAP_PTR) & ~0x3;
+	while (ptr != 0 && ttl-- > 0) {
+		if (pci_conf_read_8(fun, PCI_CAP_ID(ptr)) == id)
+			return ptr;
+		ptr = pci_conf_read_8(fun, PCI_CAP_NEXT(ptr)) & ~0x3;
+	}
+
+	return 0;
+}
+
+/** Read the physical address a memory BAR decodes. */
+static uint64_t pci_bar_address(pci_fun_t *fun, unsigned int bir)
+{
+	int addr = PCI_BASE_ADDR_0 + 4 * bir;
+	uint32_t lo = pci_conf_read_32(fun, addr);
+	uint64_t base = lo & ~0xfU;
+
+	/* 64-bit memory BAR */
+	if ((lo & 0x6) == 0x4 && bir < 5)
+		base |= (uint64_t) pci_conf_read_32(fun, addr + 4) << 32;
+
+	return base;
+}
+
+static void pci_intx_disable(pci_fun_t *fun, bool disable)
+{
+	uint16_t cmd = pci_conf_read_16(fun, PCI_COMMAND);
+
+	if (disable)
+		cmd |= PCI_COMMAND_INTX_DISABLE;
+	else
+		cmd &= ~PCI_COMMAND_INTX_DISABLE;
+
+	pci_conf_write_16(fun, PCI_COMMAND, cmd);
+}
+
+static errno_t pci_msix_enable(pci_fun_t *fun, uint8_t cap, size_t count,
+    size_t *rcount, size_t *first)
+{
+	uint16_t ctl = pci_conf_read_16(fun, cap + PCI_MSIX_CTL);
+	uint32_t table = pci_conf_read_32(fun, cap + PCI_MSIX_TABLE);
+	size_t size = (ctl & PCI_MSIX_CTL_SIZE_MASK) + 1;
+	uint64_t phys;
+	void *virt;
+	errno_t rc;
+	size_t i;
+
+	count = min(count, size);
+
+	if (fun->msix_table == NULL) {
+		phys = pci_bar_address(fun, table & PCI_MSIX_TABLE_BIR_MASK) +
+		    (table & PCI_MSIX_TABLE_OFF_MASK);
+		rc = pio_enable((void *) (uintptr_t) phys,
+		    size * PCI_MSIX_ENTRY_WORDS * sizeof(uint32_t), &virt);
+		if (rc != EOK)
+			return rc;
+
+		fun->msix_table = virt;
+		fun->msix_table_size = size;
+	}
+
+	/* Find the largest block that is available */
+	while (msi_alloc(count, false, first) != EOK) {
+		if (--count == 0)
+			return ENOENT;
+	}
+
+	pci_conf_write_16(fun, cap + PCI_MSIX_CTL,
+	    ctl | PCI_MSIX_CTL_ENABLE | PCI_MSIX_CTL_MASK_ALL);
+
+	for (i = 0; i < size; i++) {
+		ioport32_t *entry = fun->msix_table + i * PCI_MSIX_ENTRY_WORDS;
+
+		if (i >= count) {
+			pio_write_le32(&entry[PCI_MSIX_ENTRY_CTRL],
+			    PCI_MSIX_ENTRY_CTRL_MASKED);
+			continue;
+		}
+
+		pio_write_le32(&entry[PCI_MSIX_ENTRY_ADDR_LO],
+		    (uint32_t) msi_address);
+		pio_write_le32(&entry[PCI_MSIX_ENTRY_ADDR_HI],
+		    (uint32_t) (msi_address >> 32));
+		pio_write_le32(&entry[PCI_MSIX_ENTRY_DATA],
+		    msi_data + *first + i);
+		pio_write_le32(&entry[PCI_MSIX_ENTRY_CTRL], 0);
+	}
+
+	pci_conf_write_16(fun, cap + PCI_MSIX_CTL,
+	    (ctl | PCI_MSIX_CTL_ENABLE) & ~PCI_MSIX_CTL_MASK_ALL);
+
+	*rcount = count;
+	return EOK;
+}
+
+static errno_t pci_msi_enable_plain(pci_fun_t *fun, uint8_t cap, size_t count,
+    size_t *rcount, size_t *first)
+{
+	uint16_t ctl = pci_conf_read_16(fun, cap + PCI_MSI_CTL);
+	size_t mmc = (ctl >> PCI_MSI_CTL_MMC_SHIFT) & PCI_MSI_CTL_MMC_MASK;
+	size_t n = 1;
+	size_t log = 0;
+
+	/* Round down to a power of two the device and the allocator support */
+	count = min(count, min((size_t) 1 << mmc, MSI_MAX_MESSAGES));
+	while (n * 2 <= count) {
+		n *= 2;
+		log++;
+	}
+
+	while (msi_alloc(n, true, first) != EOK) {
+		if (n == 1)
+			return ENOENT;
+		n /= 2;
+		log--;
+	}
+
+	pci_conf_write_32(fun, cap + PCI_MSI_ADDR_LO, (uint32_t) msi_address);
+	if ((ctl & PCI_MSI_CTL_64BIT) != 0) {
+		pci_conf_write_32(fun, cap + PCI_MSI_ADDR_HI,
+		    (uint32_t) (msi_address >> 32));
+		pci_conf_write_16(fun, cap + PCI_MSI_DATA_64, msi_data + *first);
+	} else {
+		pci_conf_write_16(fun, cap + PCI_MSI_DATA_32, msi_data + *first);
+	}
+
+	ctl &= ~PCI_MSI_CTL_MME_MASK;
+	ctl |= (log << PCI_MSI_CTL_MME_SHIFT) | PCI_MSI_CTL_ENABLE;
+	pci_conf_write_16(fun, cap + PCI_MSI_CTL, ctl);
+
+	*rcount = n;
+	return EOK;
+}
+
+/** Enable message signaled interrupts for a function.
+ *
+ * @param fun    PCI function
+ * @param count  Number of interrupts the driver would like to use
+ * @param irq    Place to store the IRQ number of the first interrupt
+ * @param rcount Place to store the number of interrupts actually allocated,
+ *               at least one and at most @a count
+ * @return EOK on success, ENOTSUP if neither the platform nor the function
+ *         support message signaled interrupts, ENOENT if all vectors are
+ *         taken, EBUSY if they are already enabled
+ */
+errno_t pci_msi_enable(pci_fun_t *fun, size_t count, int *irq, size_t *rcount)
+{
+	uint8_t cap;
+	size_t first;
+	errno_t rc;
+
+	if (count == 0)
+		return EINVAL;
+
+	fibril_mutex_lock(&msi_lock);
+
+	msi_init();
+	if (!msi_supported) {
+		fibril_mutex_unlock(&msi_lock);
+		return ENOTSUP;
+	}
+
+	if (fun->msi_count != 0) {
+		fibril_mutex_unlock(&msi_lock);
+		return EBUSY;
+	}
+
+	cap = pci_find_cap(fun, PCI_CAP_MSIXID);
+	if (cap != 0) {
+		rc = pci_msix_enable(fun, cap, count, rcount, &first);
+		fun->msix = true;
+	} else {
+		cap = pci_find_cap(fun, PCI_CAP_MSIID);
+		if (cap == 0) {
+			fibril_mutex_unlock(&msi_lock);
+			return ENOTSUP;
+		}
+
+		rc = pci_msi_enable_plain(fun, cap, count, rcount, &first);
+		fun->msix = false;
+	}
+
+	if (rc != EOK) {
+		fibril_mutex_unlock(&msi_lock);
+		return rc;
+	}
+
+	pci_intx_disable(fun, true);
+
+	fun->msi_cap = cap;
+	fun->msi_count = *rcount;
+	fun->msi_irq = msi_inr + first;
+	*irq = fun->msi_irq;
+
+	fibril_mutex_unlock(&msi_lock);
+
+	ddf_msg(LVL_NOTE, "Function %02x:%02x.%x: %zu %s vector(s) at IRQ %d.",
+	    fun->bus, fun->dev, fun->fn, *rcount, fun->msix ? "MSI-X" : "MSI",
+	    *irq);
+	return EOK;
+}
+
+/** Disable message signaled interrupts and return to INTx. */
+errno_t pci_msi_disable(pci_fun_t *fun)
+{
+	uint16_t ctl;
+	size_t i;
+
+	fibril_mutex_lock(&msi_lock);
+
+	if (fun->msi_count == 0) {
+		fibril_mutex_unlock(&msi_lock);
+		return EOK;
+	}
+
+	if (fun->msix) {
+		ctl = pci_conf_read_16(fun, fun->msi_cap + PCI_MSIX_CTL);
+		pci_conf_write_16(fun, fun->msi_cap + PCI_MSIX_CTL,
+		    ctl | PCI_MSIX_CTL_MASK_ALL);
+
+		for (i = 0; i < fun->msi_count; i++) {
+			pio_write_le32(&fun->msix_table[i *
+			    PCI_MSIX_ENTRY_WORDS + PCI_MSIX_ENTRY_CTRL],
+			    PCI_MSIX_ENTRY_CTRL_MASKED);
+		}
+
+		pci_conf_write_16(fun, fun->msi_cap + PCI_MSIX_CTL,
+		    ctl & ~(PCI_MSIX_CTL_ENABLE | PCI_MSIX_CTL_MASK_ALL));
+	} else {
+		ctl = pci_conf_read_16(fun, fun->msi_cap + PCI_MSI_CTL);
+		pci_conf_write_16(fun, fun->msi_cap + PCI_MSI_CTL,
+		    ctl & ~(PCI_MSI_CTL_ENABLE | PCI_MSI_CTL_MME_MASK));
+	}
+
+	pci_intx_disable(fun, false);
+
+	msi_free(fun->msi_irq - msi_inr, fun->msi_count);
+	fun->msi_irq = -1;
+	fun->msi_count = 0;
+
+	fibril_mutex_unlock(&msi_lock);
+	return EOK;
+}
+
+/** Check whether an IRQ belongs to the function's message signaled block. */
+bool pci_msi_owns_interrupt(pci_fun_t *fun, int irq)
+{
+	return fun->msi_count != 0 && irq >= fun->msi_irq &&
+	    (size_t) (irq - fun->msi_irq) < fun->msi_count;
+}
+
+/**
+ * @}
+ */
@@ -58,6 +58,7 @@
 #include <pci_dev_iface.h>
 
 #include "ctl.h"
+#include "msi.h"
 #include "pci.h"
 #include "pci_regs.h"
 
@@ -116,6 +117,10 @@ static errno_t pciintel_enable_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	/* Message signaled interrupts do not go through the controller */
+	if (pci_msi_owns_interrupt(fun, irq))
+		return EOK;
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
@@ -126,6 +131,10 @@ static errno_t pciintel_disable_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	/* Message signaled interrupts do not go through the controller */
+	if (pci_msi_owns_interrupt(fun, irq))
+		return EOK;
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
@@ -136,12 +145,27 @@ static errno_t pciintel_clear_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	/* Message signaled interrupts do not go through the controller */
+	if (pci_msi_owns_interrupt(fun, irq))
+		return EOK;
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
 	return irc_clear_interrupt(irq);
 }
 
+static errno_t pciintel_enable_msi(ddf_fun_t *fnode, size_t count, int *irq,
+    size_t *rcount)
+{
+	return pci_msi_enable(pci_fun(fnode), count, irq, rcount);
+}
+
+static errno_t pciintel_disable_msi(ddf_fun_t *fnode)
+{
+	return pci_msi_disable(pci_fun(fnode));
+}
+
 static pio_window_t *pciintel_get_pio_window(ddf_fun_t *fnode)
 {
 	pci_fun_t *fun = pci_fun(fnode);
@@ -210,6 +234,8 @@ static hw_res_ops_t pciintel_hw_res_ops = {
 	.enable_interrupt = &pciintel_enable_interrupt,
 	.disable_interrupt = &pciintel_disable_interrupt,
 	.clear_interrupt = &pciintel_clear_interrupt,
+	.enable_msi = &pciintel_enable_msi,
+	.disable_msi = &pciintel_disable_msi,
 };
 
 static pio_window_ops_t pciintel_pio_window_ops = {
@@ -614,10 +640,41 @@ void pci_add_interrupt(pci_fun_t *fun, int irq)
 	ddf_msg(LVL_NOTE, "Function %s uses irq %x.", ddf_fun_get_name(fun->fnode), irq);
 }
 
+/** Determine whether an IDE channel operates in compatibility mode.
+ *
+ * A channel in compatibility (legacy) mode ignores its BARs and decodes
+ * the fixed ISA addresses and interrupt instead.
+ *
+ * @param fun	PCI function
+ * @param chan	Channel number (0 for primary, 1 for secondary)
+ * @return	@c true if @a fun is an IDE controller and @a chan is in
+ *		compatibility mode
+ */
+static bool pci_ide_legacy_chan(pci_fun_t *fun, int chan)
+{
+	if (fun->class_code != PCI_CLASS_STORAGE ||
+	    fun->subclass_code != PCI_SUBCLASS_IDE)
+		return false;
+
+	/* Bits 0 and 2 of the programming interface select native mode. */
+	return (fun->prog_if & (1 << (2 * chan))) == 0;
+}
+
 void pci_read_interrupt(pci_fun_t *fun)
 {
 	uint8_t irq = pci_conf_read_8(fun, PCI_BRIDGE_INT_LINE);
 	uint8_t pin = pci_conf_read_8(fun, PCI_BRIDGE_INT_PIN);
+	bool legacy0 = pci_ide_legacy_chan(fun, 0);
+	bool legacy1 = pci_ide_legacy_chan(fun, 1);
+
+	/* IDE channels in compatibility mode use the ISA interrupts. */
+	if (legacy0)
+		pci_add_interrupt(fun, PCI_IDE_LEGACY_IRQ0);
+	if (legacy1)
+		pci_add_interrupt(fun, PCI_IDE_LEGACY_IRQ1);
+
+	if (legacy0 && legacy1)
+		return;
 
 	if (pin != 0 && irq != 0xff)
 		pci_add_interrupt(fun, irq);
@@ -906,6 +963,7 @@ pci_fun_t *pci_fun_new(pci_bus_t *bus)
 
 	fun->busptr = bus;
 	fun->fnode = fnode;
+	fun->msi_irq = -1;
 	return fun;
 }
 
@@ -968,8 +1026,31 @@ void pci_read_bars(pci_fun_t *fun)
 	 */
 	int addr = PCI_BASE_ADDR_0;
 
-	while (addr <= PCI_BASE_ADDR_5)
+	while (addr <= PCI_BASE_ADDR_5) {
+		int chan = (addr - PCI_BASE_ADDR_0) / 8;
+
+		/*
+		 * The first four BARs of an IDE controller are replaced
+		 * by the legacy command and control block addresses for
+		 * channels in compatibility mode.
+		 */
+		if (addr < PCI_BASE_ADDR_4 && pci_ide_legacy_chan(fun, chan)) {
+			if (addr == PCI_BASE_ADDR_0 || addr == PCI_BASE_ADDR_2) {
+				pci_add_range(fun, chan == 0 ?
+				    PCI_IDE_LEGACY_CMD0 : PCI_IDE_LEGACY_CMD1,
+				    PCI_IDE_LEGACY_CMD_SIZE, true);
+			} else {
+				pci_add_range(fun, chan == 0 ?
+				    PCI_IDE_LEGACY_CTL0 : PCI_IDE_LEGACY_CTL1,
+				    PCI_IDE_LEGACY_CTL_SIZE, true);
+			}
+
+			addr += 4;
+			continue;
+		}
+
 		addr = pci_read_bar(fun, addr);
+	}
 }
 
 size_t pci_bar_mask_to_size(uint32_t mask)
@@ -74,6 +74,19 @@ typedef struct pci_fun_data {
 	hw_resource_list_t hw_resources;
 	hw_resource_t resources[PCI_MAX_HW_RES];
 	pio_window_t pio_window;
+
+	/** First IRQ of the message signaled interrupt block or -1 */
+	int msi_irq;
+	/** Number of message signaled interrupts allocated */
+	size_t msi_count;
+	/** Offset of the MSI or MSI-X capability in configuration space */
+	uint8_t msi_cap;
+	/** @c true if MSI-X is used rather than MSI */
+	bool msix;
+	/** Mapped MSI-X table */
+	ioport32_t *msix_table;
+	/** Number of entries in the mapped MSI-X table */
+	size_t msix_table_size;
 } pci_fun_t;
 
 extern pci_bus_t *pci_bus(ddf_dev_t *);
@@ -59,7 +59,7 @@
 
 /* Header type 0 */
 #define PCI_BASE_ADDR_2			0x18
-#define PCI_BASE_ADDR_3			0x1B
+#define PCI_BASE_ADDR_3			0x1C
 #define PCI_BASE_ADDR_4			0x20
 #define PCI_BASE_ADDR_5			0x24
 
@@ -107,6 +107,54 @@
 #define PCI_COMMAND_FAST_BACK     0x200
 #define PCI_COMMAND_INTX_DISABLE  0x400
 
+/* MSI capability */
+#define PCI_MSI_CTL               0x02
+#define PCI_MSI_ADDR_LO           0x04
+#define PCI_MSI_ADDR_HI           0x08
+#define PCI_MSI_DATA_32           0x08
+#define PCI_MSI_DATA_64           0x0C
+
+#define PCI_MSI_CTL_ENABLE        0x0001
+#define PCI_MSI_CTL_MMC_SHIFT     1
+#define PCI_MSI_CTL_MMC_MASK      0x0007
+#define PCI_MSI_CTL_MME_SHIFT     4
+#define PCI_MSI_CTL_MME_MASK      0x0070
+#define PCI_MSI_CTL_64BIT         0x0080
+
+/* MSI-X capability */
+#define PCI_MSIX_CTL              0x02
+#define PCI_MSIX_TABLE            0x04
+
+#define PCI_MSIX_CTL_SIZE_MASK    0x07ff
+#define PCI_MSIX_CTL_MASK_ALL     0x4000
+#define PCI_MSIX_CTL_ENABLE       0x8000
+
+#define PCI_MSIX_TABLE_BIR_MASK   0x00000007
+#define PCI_MSIX_TABLE_OFF_MASK   0xfffffff8
+
+/* MSI-X table entry (in 32-bit words) */
+#define PCI_MSIX_ENTRY_ADDR_LO    0
+#define PCI_MSIX_ENTRY_ADDR_HI    1
+#define PCI_MSIX_ENTRY_DATA       2
+#define PCI_MSIX_ENTRY_CTRL       3
+#define PCI_MSIX_ENTRY_WORDS      4
+
+#define PCI_MSIX_ENTRY_CTRL_MASKED  0x00000001
+
+/* Mass storage controller, IDE */
+#define PCI_CLASS_STORAGE  0x01
+#define PCI_SUBCLASS_IDE   0x01
+
+/* Addresses decoded by IDE channels in compatibility mode */
+#define PCI_IDE_LEGACY_CMD0      0x1F0
+#define PCI_IDE_LEGACY_CTL0      0x3F4
+#define PCI_IDE_LEGACY_CMD1      0x170
+#define PCI_IDE_LEGACY_CTL1      0x374
+#define PCI_IDE_LEGACY_CMD_SIZE  8
+#define PCI_IDE_LEGACY_CTL_SIZE  4
+#define PCI_IDE_LEGACY_IRQ0      14
+#define PCI_IDE_LEGACY_IRQ1      15
+
 #endif
 
 /**
@@ -56,6 +56,37 @@
 
 static void (*const batch_setup[])(ehci_transfer_batch_t *);
 
+/** Size of the pages addressed by TD buffer pointers */
+#define EHCI_TD_PAGE_SIZE   4096
+
+/** Collect the pages holding a part of the transfer.
+ *
+ * The pages need not be physically contiguous, every one of them has its
+ * own buffer pointer in the TD.
+ *
+ * @param[in] ehci_batch Batch structure to use.
+ * @param[in] pos Position of the part in the transfer.
+ * @param[in] size Size of the part, at most EHCI_TD_MAX_TRANSFER.
+ * @param[out] buffer Buffer pointers for the TD.
+ */
+static void batch_td_buffer(const ehci_transfer_batch_t *ehci_batch,
+    size_t pos, size_t size, uintptr_t *buffer)
+{
+	for (unsigned i = 0; size > 0; ++i) {
+		assert(i < TD_BUFFER_POINTER_COUNT);
+
+		size_t len;
+		const uintptr_t phys = usb_transfer_batch_phys(&ehci_batch->base,
+		    pos, &len);
+		len = min(min(len, size),
+		    EHCI_TD_PAGE_SIZE - (phys & TD_BUFFER_POINTER_OFFSET_MASK));
+
+		buffer[i] = phys;
+		pos += len;
+		size -= len;
+	}
+}
+
 /** Safely destructs ehci_transfer_batch_t structure
  *
  * @param[in] ehci_batch Instance to destroy.
@@ -137,9 +168,6 @@ int ehci_transfer_batch_prepare(ehci_transfer_batch_t *ehci_batch)
 	ehci_batch->setup_buffer = ehci_batch->ehci_dma_buffer.virt + tds_size;
 	memcpy(ehci_batch->setup_buffer, ehci_batch->base.setup.buffer, setup_size);
 
-	/* Generic data already prepared */
-	ehci_batch->data_buffer = ehci_batch->base.dma_buffer.virt;
-
 	if (!batch_setup[ehci_batch->base.ep->transfer_type])
 		return ENOTSUP;
 
@@ -274,10 +302,11 @@ static void batch_control(ehci_transfer_batch_t *ehci_batch)
 	const usb_direction_t status_dir = reverse_dir[dir];
 
 	/* Setup stage */
+	const uintptr_t setup_buffer = dma_buffer_phys(
+	    &ehci_batch->ehci_dma_buffer, ehci_batch->setup_buffer);
 	td_init(&ehci_batch->tds[0],
 	    dma_buffer_phys(&ehci_batch->ehci_dma_buffer, &ehci_batch->tds[1]),
-	    dma_buffer_phys(&ehci_batch->ehci_dma_buffer, ehci_batch->setup_buffer),
-	    USB_DIRECTION_BOTH, USB_SETUP_PACKET_SIZE, toggle, false);
+	    &setup_buffer, USB_DIRECTION_BOTH, USB_SETUP_PACKET_SIZE, toggle, false);
 	usb_log_debug2("Batch %p: Created CONTROL SETUP TD(%" PRIxn "): "
 	    "%08x:%08x:%08x", ehci_batch,
 	    dma_buffer_phys(&ehci_batch->ehci_dma_buffer, &ehci_batch->tds[0]),
@@ -286,13 +315,15 @@ static void batch_control(ehci_transfer_batch_t *ehci_batch)
 
 	/* Data stage */
 	unsigned td_current = 1;
+	size_t pos = 0;
 	size_t remain_size = ehci_batch->base.size;
-	uintptr_t buffer = dma_buffer_phys(&ehci_batch->base.dma_buffer,
-	    ehci_batch->data_buffer);
 	while (remain_size > 0) {
 		const size_t transfer_size = min(remain_size, EHCI_TD_MAX_TRANSFER);
 		toggle = 1 - toggle;
 
+		uintptr_t buffer[TD_BUFFER_POINTER_COUNT];
+		batch_td_buffer(ehci_batch, pos, transfer_size, buffer);
+
 		td_init(&ehci_batch->tds[td_current],
 		    dma_buffer_phys(&ehci_batch->ehci_dma_buffer, &ehci_batch->tds[td_current + 1]),
 		    buffer, data_dir, transfer_size, toggle, false);
@@ -303,7 +334,7 @@ static void batch_control(ehci_transfer_batch_t *ehci_batch)
 		    ehci_batch->tds[td_current].next,
 		    ehci_batch->tds[td_current].alternate);
 
-		buffer += transfer_size;
+		pos += transfer_size;
 		remain_size -= transfer_size;
 		assert(td_current < ehci_batch->td_count - 1);
 		++td_current;
@@ -311,7 +342,7 @@ static void batch_control(ehci_transfer_batch_t *ehci_batch)
 
 	/* Status stage */
 	assert(td_current == ehci_batch->td_count - 1);
-	td_init(&ehci_batch->tds[td_current], 0, 0, status_dir, 0, 1, true);
+	td_init(&ehci_batch->tds[td_current], 0, NULL, status_dir, 0, 1, true);
 	usb_log_debug2("Batch %p: Created CONTROL STATUS TD %d(%" PRIxn "): "
 	    "%08x:%08x:%08x", ehci_batch, td_current,
 	    dma_buffer_phys(&ehci_batch->ehci_dma_buffer, &ehci_batch->tds[td_current]),
@@ -340,13 +371,15 @@ static void batch_data(ehci_transfer_batch_t *ehci_batch)
 	    ehci_batch->qh->next, ehci_batch->qh->alternate);
 
 	size_t td_current = 0;
+	size_t pos = 0;
 	size_t remain_size = ehci_batch->base.size;
-	uintptr_t buffer = dma_buffer_phys(&ehci_batch->base.dma_buffer,
-	    ehci_batch->data_buffer);
 	while (remain_size > 0) {
 		const size_t transfer_size = remain_size > EHCI_TD_MAX_TRANSFER ?
 		    EHCI_TD_MAX_TRANSFER : remain_size;
 
+		uintptr_t buffer[TD_BUFFER_POINTER_COUNT];
+		batch_td_buffer(ehci_batch, pos, transfer_size, buffer);
+
 		const bool last = (remain_size == transfer_size);
 		td_init(&ehci_batch->tds[td_current],
 		    last ? 0 : dma_buffer_phys(&ehci_batch->ehci_dma_buffer,
@@ -361,7 +394,7 @@ static void batch_data(ehci_transfer_batch_t *ehci_batch)
 		    ehci_batch->tds[td_current].next,
 		    ehci_batch->tds[td_current].alternate);
 
-		buffer += transfer_size;
+		pos += transfer_size;
 		remain_size -= transfer_size;
 		assert(td_current < ehci_batch->td_count);
 		++td_current;
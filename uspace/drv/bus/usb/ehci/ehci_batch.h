@@ -55,9 +55,8 @@ typedef struct ehci_transfer_batch {
 	dma_buffer_t ehci_dma_buffer;
 	/** List of TDs needed for the transfer - backed by dma_buffer */
 	td_t *tds;
-	/** Data buffers - backed by dma_buffer */
+	/** Setup buffer - backed by dma_buffer */
 	void *setup_buffer;
-	void *data_buffer;
 	/** Generic USB transfer structure */
 	usb_transfer_batch_t *usb_batch;
 } ehci_transfer_batch_t;
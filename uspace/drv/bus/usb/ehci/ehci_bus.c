@@ -83,6 +83,10 @@ static endpoint_t *ehci_endpoint_create(device_t *dev,
 
 	endpoint_init(&ehci_ep->base, dev, desc);
 
+	/* TDs address the data page by page, but only below 4 GiB */
+	ehci_ep->base.required_transfer_buffer_policy =
+	    dma_policy_create(DMA_POLICY_4GiB, PAGE_SIZE);
+
 	if (dma_buffer_alloc(&ehci_ep->dma_buffer, sizeof(qh_t)))
 		return NULL;
 
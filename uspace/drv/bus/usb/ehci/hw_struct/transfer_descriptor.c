@@ -75,12 +75,13 @@ static const uint32_t dir[] = {
  * @param instance TD structure to initialize.
  * @param next_phys Next TD in ED list.
  * @param direction Used to determine PID, BOTH means setup PID.
- * @param buffer Pointer to the first byte of transferred data.
+ * @param buffer Physical addresses of the 4 KiB pages holding the data, the
+ *        first one pointing to the first byte, NULL if there are no data.
  * @param size Size of the buffer.
  * @param toggle Toggle bit value, use 0/1 to set explicitly,
  *        any other value means that ED toggle will be used.
  */
-void td_init(td_t *instance, uintptr_t next_phys, uintptr_t buffer,
+void td_init(td_t *instance, uintptr_t next_phys, const uintptr_t *buffer,
     usb_direction_t direction, size_t size, int toggle, bool ioc)
 {
 	assert(instance);
@@ -97,17 +98,17 @@ void td_init(td_t *instance, uintptr_t next_phys, uintptr_t buffer,
 		    toggle ? TD_STATUS_TOGGLE_FLAG : 0);
 	}
 
-	if (buffer != 0) {
+	if (buffer != NULL) {
 		assert(size != 0);
 		for (unsigned i = 0; (i < ARRAY_SIZE(instance->buffer_pointer)) &&
 		    size; ++i) {
-			const uintptr_t offset = buffer & TD_BUFFER_POINTER_OFFSET_MASK;
+			const uintptr_t offset = buffer[i] & TD_BUFFER_POINTER_OFFSET_MASK;
 			assert(offset == 0 || i == 0);
 			const size_t this_size = min(size, 4096 - offset);
-			EHCI_MEM32_WR(instance->buffer_pointer[i], buffer);
+			EHCI_MEM32_WR(instance->buffer_pointer[i], buffer[i]);
 			size -= this_size;
-			buffer += this_size;
 		}
+		assert(size == 0);
 	}
 
 	EHCI_MEM32_WR(instance->next, next_phys ?
@@ -40,6 +40,9 @@
 #include "link_pointer.h"
 #include "mem_access.h"
 
+/** Number of 4 KiB pages a TD can address */
+#define TD_BUFFER_POINTER_COUNT  5
+
 /** Transfer descriptor (non-ISO) */
 typedef struct td {
 	link_pointer_t next;
@@ -47,10 +50,10 @@ typedef struct td {
 
 	volatile uint32_t status;
 
-	volatile uint32_t buffer_pointer[5];
+	volatile uint32_t buffer_pointer[TD_BUFFER_POINTER_COUNT];
 
 	/* 64 bit struct only */
-	volatile uint32_t extended_bp[5];
+	volatile uint32_t extended_bp[TD_BUFFER_POINTER_COUNT];
 
 } __attribute__((packed, aligned(32))) td_t;
 
@@ -104,8 +107,8 @@ static inline size_t td_remain_size(const td_t *td)
 
 errno_t td_error(const td_t *td);
 
-void td_init(td_t *td, uintptr_t next_phys, uintptr_t buf, usb_direction_t dir,
-    size_t buf_size, int toggle, bool ioc);
+void td_init(td_t *td, uintptr_t next_phys, const uintptr_t *buf,
+    usb_direction_t dir, size_t buf_size, int toggle, bool ioc);
 
 #endif
 /**
@@ -119,47 +119,56 @@ static xhci_trb_ring_t *get_ring(xhci_transfer_t *transfer)
 	return xhci_endpoint_get_ring(xhci_ep, transfer->batch.target.stream);
 }
 
+/** TRB buffers must not cross a 64 KiB boundary */
 #define MAX_CHUNK_SIZE (1 << 16)
 
 typedef struct {
 	/* Input parameters */
-	dma_buffer_t buf;
-	size_t chunk_size, packet_count, mps, max_trb_count;
+	usb_transfer_batch_t *batch;
+	size_t packet_count, mps, max_trb_count;
 
 	/* Changing at runtime */
 	size_t transferred, remaining;
-	void *pos;
 } trb_splitter_t;
 
 static void trb_splitter_init(trb_splitter_t *ts, xhci_transfer_t *transfer)
 {
-	ts->buf = transfer->batch.dma_buffer;
+	ts->batch = &transfer->batch;
 
-	const size_t chunk_mask = dma_policy_chunk_mask(ts->buf.policy);
-	ts->chunk_size = (chunk_mask > MAX_CHUNK_SIZE + 1) ?
-	    MAX_CHUNK_SIZE : (chunk_mask + 1);
+	/*
+	 * Every TRB ends at a page boundary at the latest, as the 64 KiB
+	 * boundaries and the buffer chunks are page aligned.
+	 */
+	const size_t head = (uintptr_t) (transfer->batch.dma_buffer.virt +
+	    transfer->batch.offset) % PAGE_SIZE;
 
 	ts->remaining = transfer->batch.size;
-	ts->max_trb_count = (ts->remaining + ts->chunk_size - 1) / ts->chunk_size + 1;
+	ts->max_trb_count = (head + ts->remaining + PAGE_SIZE - 1) / PAGE_SIZE + 1;
 	ts->mps = transfer->batch.ep->max_packet_size;
 	ts->packet_count = (ts->remaining + ts->mps - 1) / ts->mps;
 
 	ts->transferred = 0;
-	ts->pos = ts->buf.virt + transfer->batch.offset;
 }
 
 static void trb_split_next(xhci_trb_t *trb, trb_splitter_t *ts)
 {
 	xhci_trb_clean(trb);
 
-	size_t size = min(ts->remaining, ts->chunk_size);
-
-	/* First TRB might be misaligned */
-	if (ts->transferred == 0) {
-		const size_t offset = (ts->pos - ts->buf.virt) % ts->chunk_size;
-		size = min(size, ts->chunk_size - offset);
+	size_t size;
+	const uintptr_t phys = usb_transfer_batch_phys(ts->batch,
+	    ts->transferred, &size);
+
+	/* Merge physically contiguous pages of a scatter-gather buffer */
+	while (size < ts->remaining && (phys + size) % MAX_CHUNK_SIZE != 0) {
+		size_t next_size;
+		if (usb_transfer_batch_phys(ts->batch, ts->transferred + size,
+		    &next_size) != phys + size)
+			break;
+		size += next_size;
 	}
 
+	size = min(size, MAX_CHUNK_SIZE - phys % MAX_CHUNK_SIZE);
+
 	ts->transferred += size;
 	ts->remaining -= size;
 
@@ -169,8 +178,6 @@ static void trb_split_next(xhci_trb_t *trb, trb_splitter_t *ts)
 	/* Last TRB must have TD Size = 0 */
 	assert(ts->remaining > 0 || td_size == 0);
 
-	uintptr_t phys = dma_buffer_phys(&ts->buf, ts->pos);
-
 	trb->parameter = host2xhci(64, phys);
 	TRB_CTRL_SET_TD_SIZE(*trb, td_size);
 	TRB_CTRL_SET_XFER_LEN(*trb, size);
@@ -178,8 +185,6 @@ static void trb_split_next(xhci_trb_t *trb, trb_splitter_t *ts)
 
 	if (ts->remaining)
 		TRB_CTRL_SET_CHAIN(*trb, 1);
-
-	ts->pos += size;
 }
 
 static errno_t schedule_control(xhci_hc_t *hc, xhci_transfer_t *transfer)
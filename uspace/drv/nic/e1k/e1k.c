@@ -54,6 +54,9 @@
 
 #define E1000_DEFAULT_INTERRUPT_INTERVAL_USEC  250
 
+/** Maximum number of interrupts merged into one notification */
+#define E1000_IRQ_COALESCE  16
+
 /* Must be power of 8 */
 #define E1000_RX_FRAME_COUNT  128
 #define E1000_TX_FRAME_COUNT  128
@@ -1281,11 +1284,43 @@ inline static errno_t e1000_register_int_handler(nic_t *nic,
 	e1000_irq_code.cmds[0].addr = e1000->reg_base_phys + E1000_ICR;
 	e1000_irq_code.cmds[3].addr = e1000->reg_base_phys + E1000_IMC;
 
+	/*
+	 * Prefer a message signaled interrupt if the adapter has one. It is
+	 * never shared, the top-half code stays the same.
+	 */
+	int msi_irq;
+	size_t msi_count;
+	bool msi = hw_res_enable_msi(e1000->parent_sess, 1, &msi_irq,
+	    &msi_count) == EOK;
+	if (msi)
+		e1000->irq = msi_irq;
+
 	errno_t rc = register_interrupt_handler(nic_get_ddf_dev(nic), e1000->irq,
 	    e1000_interrupt_handler, &e1000_irq_code, handle);
 
 	fibril_mutex_unlock(&irq_reg_mutex);
-	return rc;
+
+	if (rc != EOK) {
+		if (msi)
+			(void) hw_res_disable_msi(e1000->parent_sess);
+		return rc;
+	}
+
+	/*
+	 * The causes in ICR are or-ed together when notifications are merged,
+	 * which is what the handler needs.
+	 */
+	rc = set_interrupt_coalescing(nic_get_ddf_dev(nic), *handle,
+	    E1000_IRQ_COALESCE);
+	if (rc != EOK) {
+		unregister_interrupt_handler(nic_get_ddf_dev(nic), *handle);
+		if (msi)
+			(void) hw_res_disable_msi(e1000->parent_sess);
+		return rc;
+	}
+
+	ddf_msg(LVL_NOTE, "Using %s IRQ %d", msi ? "MSI" : "INTx", e1000->irq);
+	return EOK;
 }
 
 /** Force receiving all frames in the receive buffer
@@ -32,6 +32,8 @@
 #include <stdint.h>
 
 #include <as.h>
+#include <byteorder.h>
+#include <macros.h>
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
@@ -56,6 +58,22 @@
 #define TX_BUF_SIZE	BUFFER_SIZE
 #define CT_BUF_SIZE	BUFFER_SIZE
 
+/** Largest frame handed to the device, an IPv4 packet with Ethernet header */
+#define TX_FRAME_MAX	(14 + 65535)
+/** TX buffers needed for the largest frame, the first one with the header */
+#define TX_CHAIN_MAX	\
+	((sizeof(virtio_net_hdr_t) + TX_FRAME_MAX + TX_BUF_SIZE - 1) / \
+	TX_BUF_SIZE)
+
+/** Features used if the device offers them */
+#define VIRTIO_NET_OPTIONAL_FEATURES \
+	(VIRTIO_NET_F_CSUM | VIRTIO_NET_F_GUEST_CSUM | \
+	VIRTIO_NET_F_HOST_TSO4 | VIRTIO_NET_F_GUEST_TSO4 | \
+	VIRTIO_NET_F_MRG_RXBUF)
+
+/** Maximum number of interrupts merged into one notification */
+#define VIRTIO_NET_IRQ_COALESCE	32
+
 static ddf_dev_ops_t virtio_net_dev_ops;
 
 static errno_t virtio_net_dev_add(ddf_dev_t *dev);
@@ -69,48 +87,195 @@ static driver_t virtio_net_driver = {
 	.driver_ops = &virtio_net_driver_ops
 };
 
-static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+/** Give back the remaining buffers of a dropped merged packet. */
+static void virtio_net_rx_skip(virtio_dev_t *vdev, uint16_t buffers)
+{
+	uint16_t descno;
+	uint32_t len;
+
+	while (buffers-- > 0) {
+		if (!virtio_virtq_consume_used(vdev, RX_QUEUE_1, &descno, &len))
+			break;
+		virtio_virtq_produce_available(vdev, RX_QUEUE_1, descno);
+	}
+}
+
+/** Pass the received packets to the NIC framework.
+ *
+ * With mergeable RX buffers a packet larger than one buffer, such as a
+ * merged TCP segment, is spread over the number of consecutively used
+ * buffers given in the header of the first one.
+ *
+ * A partial checksum of a packet flagged with VIRTIO_NET_HDR_F_NEEDS_CSUM
+ * is left as it is, the packet was not checksummed because it never
+ * crossed a wire.
+ */
+static void virtio_net_rx_process(nic_t *nic)
 {
-	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	bool merge = (vdev->features & VIRTIO_NET_F_MRG_RXBUF) != 0;
 
 	uint16_t descno;
 	uint32_t len;
 	while (virtio_virtq_consume_used(vdev, RX_QUEUE_1, &descno, &len)) {
 		virtio_net_hdr_t *hdr =
 		    (virtio_net_hdr_t *) virtio_net->rx_buf[descno];
-		if (len <= sizeof(*hdr)) {
+		uint16_t buffers = merge ?
+		    uint16_t_le2host(hdr->num_buffers) : 1;
+
+		if (len <= sizeof(*hdr) || len > RX_BUF_SIZE || buffers == 0) {
 			ddf_msg(LVL_WARN,
-			    "RX data length too short, packet dropped");
+			    "Invalid RX data length, packet dropped");
 			virtio_virtq_produce_available(vdev, RX_QUEUE_1,
 			    descno);
+			if (buffers > 1)
+				virtio_net_rx_skip(vdev, buffers - 1);
 			continue;
 		}
 
-		nic_frame_t *frame = nic_alloc_frame(nic, len - sizeof(*hdr));
-		if (frame) {
-			memcpy(frame->data, &hdr[1], len - sizeof(*hdr));
-			nic_received_frame(nic, frame);
-		} else {
+		nic_frame_t *frame = nic_alloc_frame(nic,
+		    buffers * RX_BUF_SIZE - sizeof(*hdr));
+		if (!frame) {
 			ddf_msg(LVL_WARN,
 			    "Cannot allocate RX frame, packet dropped");
+			virtio_virtq_produce_available(vdev, RX_QUEUE_1,
+			    descno);
+			if (buffers > 1)
+				virtio_net_rx_skip(vdev, buffers - 1);
+			continue;
 		}
 
+		size_t size = len - sizeof(*hdr);
+		memcpy(frame->data, &hdr[1], size);
 		virtio_virtq_produce_available(vdev, RX_QUEUE_1, descno);
+
+		uint16_t i;
+		for (i = 1; i < buffers; i++) {
+			if (!virtio_virtq_consume_used(vdev, RX_QUEUE_1,
+			    &descno, &len))
+				break;
+
+			len = min(len, RX_BUF_SIZE);
+			memcpy((uint8_t *) frame->data + size,
+			    virtio_net->rx_buf[descno], len);
+			size += len;
+			virtio_virtq_produce_available(vdev, RX_QUEUE_1,
+			    descno);
+		}
+
+		if (i < buffers) {
+			ddf_msg(LVL_WARN, "RX packet incomplete, dropped");
+			nic_release_frame(nic, frame);
+			continue;
+		}
+
+		frame->size = size;
+		nic_received_frame(nic, frame);
 	}
+}
 
+static void virtio_net_tx_process(nic_t *nic)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	uint16_t descno;
+	uint32_t len;
 	while (virtio_virtq_consume_used(vdev, TX_QUEUE_1, &descno, &len)) {
-		virtio_free_desc(vdev, TX_QUEUE_1, &virtio_net->tx_free_head,
-		    descno);
+		/* Free the whole descriptor chain of the frame */
+		do {
+			uint16_t next = virtio_virtq_desc_get_next(vdev,
+			    TX_QUEUE_1, descno);
+			virtio_free_desc(vdev, TX_QUEUE_1,
+			    &virtio_net->tx_free_head, descno);
+			descno = next;
+		} while (descno != (uint16_t) -1U);
 	}
+}
+
+static void virtio_net_ct_process(nic_t *nic)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	uint16_t descno;
+	uint32_t len;
 	while (virtio_virtq_consume_used(vdev, CT_QUEUE_1, &descno, &len)) {
 		virtio_free_desc(vdev, CT_QUEUE_1, &virtio_net->ct_free_head,
 		    descno);
 	}
 }
 
-static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
+/** Handle the INT#x interrupt or the only MSI-X vector. */
+static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+
+	virtio_net_rx_process(nic);
+	virtio_net_tx_process(nic);
+	virtio_net_ct_process(nic);
+}
+
+/** Handle the MSI-X vector of the RX and control queues. */
+static void virtio_net_rx_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+
+	virtio_net_rx_process(nic);
+	virtio_net_ct_process(nic);
+}
+
+/** Handle the MSI-X vector of the TX queue. */
+static void virtio_net_tx_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	virtio_net_tx_process(ddf_dev_data_get(dev));
+}
+
+static errno_t virtio_net_register_msix(ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	errno_t rc = virtio_pci_msix_enable(dev, vdev,
+	    VIRTIO_NET_MSIX_VECTORS);
+	if (rc != EOK)
+		return rc;
+
+	virtio_net->irq = vdev->msix_irq;
+	virtio_net->irq_count = vdev->msix_count;
+
+	/*
+	 * Virtqueue n is signaled by vector n % irq_count, so with two
+	 * vectors the RX and control queues share the first one.
+	 */
+	if (virtio_net->irq_count == 1) {
+		return register_interrupt_handler(dev, virtio_net->irq,
+		    virtio_net_irq_handler, NULL, &virtio_net->irq_handle[0]);
+	}
+
+	rc = register_interrupt_handler(dev, virtio_net->irq,
+	    virtio_net_rx_irq_handler, NULL, &virtio_net->irq_handle[0]);
+	if (rc != EOK)
+		return rc;
+
+	rc = register_interrupt_handler(dev, virtio_net->irq + 1,
+	    virtio_net_tx_irq_handler, NULL, &virtio_net->irq_handle[1]);
+	if (rc != EOK) {
+		/*
+		 * The vectors go back to the bus driver, which may hand them
+		 * to another function. Do not leave a handler subscribed.
+		 */
+		(void) unregister_interrupt_handler(dev,
+		    virtio_net->irq_handle[0]);
+		return rc;
+	}
+
+	return EOK;
+}
+
+static errno_t virtio_net_register_intx(ddf_dev_t *dev)
 {
 	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = nic_get_specific(nic);
@@ -130,6 +295,7 @@ static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 	}
 
 	virtio_net->irq = res.irqs.irqs[0];
+	virtio_net->irq_count = 1;
 	hw_res_list_parsed_clean(&res);
 
 	irq_pio_range_t pio_ranges[] = {
@@ -163,7 +329,100 @@ static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 	};
 
 	return register_interrupt_handler(dev, virtio_net->irq,
-	    virtio_net_irq_handler, &irq_code, &virtio_net->irq_handle);
+	    virtio_net_irq_handler, &irq_code, &virtio_net->irq_handle[0]);
+}
+
+static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	errno_t rc;
+
+	/* MSI-X vectors need no top-half code and are not shared */
+	rc = virtio_net_register_msix(dev);
+	if (rc != EOK) {
+		if (virtio_net->virtio_dev.msix_count != 0) {
+			(void) hw_res_disable_msi(ddf_dev_parent_sess_get(dev));
+			virtio_net->virtio_dev.msix_count = 0;
+		}
+
+		rc = virtio_net_register_intx(dev);
+		if (rc != EOK)
+			return rc;
+	}
+
+	/*
+	 * The handlers drain the whole virtqueue, so interrupts arriving
+	 * before a handler runs do not need notifications of their own.
+	 */
+	for (size_t i = 0; i < virtio_net->irq_count; i++) {
+		rc = set_interrupt_coalescing(dev, virtio_net->irq_handle[i],
+		    VIRTIO_NET_IRQ_COALESCE);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
+}
+
+/** Allocate the RX and TX buffers and their bookkeeping arrays. */
+static errno_t virtio_net_setup_bufs(virtio_net_t *virtio_net)
+{
+	virtio_net->rx_buf = calloc(virtio_net->rx_count, sizeof(void *));
+	virtio_net->rx_buf_p = calloc(virtio_net->rx_count, sizeof(uintptr_t));
+	virtio_net->tx_buf = calloc(virtio_net->tx_count, sizeof(void *));
+	virtio_net->tx_buf_p = calloc(virtio_net->tx_count, sizeof(uintptr_t));
+	if (!virtio_net->rx_buf || !virtio_net->rx_buf_p ||
+	    !virtio_net->tx_buf || !virtio_net->tx_buf_p)
+		return ENOMEM;
+
+	errno_t rc = virtio_setup_dma_bufs(virtio_net->rx_count, RX_BUF_SIZE,
+	    false, virtio_net->rx_buf, virtio_net->rx_buf_p);
+	if (rc != EOK)
+		return rc;
+
+	return virtio_setup_dma_bufs(virtio_net->tx_count, TX_BUF_SIZE, true,
+	    virtio_net->tx_buf, virtio_net->tx_buf_p);
+}
+
+static void virtio_net_teardown_bufs(virtio_net_t *virtio_net)
+{
+	if (virtio_net->rx_buf)
+		virtio_teardown_dma_bufs(virtio_net->rx_buf);
+	if (virtio_net->tx_buf)
+		virtio_teardown_dma_bufs(virtio_net->tx_buf);
+	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+
+	free(virtio_net->rx_buf);
+	free(virtio_net->rx_buf_p);
+	free(virtio_net->tx_buf);
+	free(virtio_net->tx_buf_p);
+	virtio_net->rx_buf = NULL;
+	virtio_net->rx_buf_p = NULL;
+	virtio_net->tx_buf = NULL;
+	virtio_net->tx_buf_p = NULL;
+}
+
+/** Determine the offloads permitted by the negotiated features. */
+static void virtio_net_setup_offload(virtio_net_t *virtio_net)
+{
+	uint32_t features = virtio_net->virtio_dev.features;
+	uint32_t offload = 0;
+
+	if (features & VIRTIO_NET_F_CSUM)
+		offload |= NIC_OFFLOAD_TX_CSUM;
+	if (features & VIRTIO_NET_F_GUEST_CSUM)
+		offload |= NIC_OFFLOAD_RX_CSUM;
+	if (features & VIRTIO_NET_F_GUEST_TSO4)
+		offload |= NIC_OFFLOAD_LRO4;
+
+	/* The largest frame must fit into the TX virtqueue */
+	if ((features & VIRTIO_NET_F_HOST_TSO4) &&
+	    virtio_net->tx_count >= TX_CHAIN_MAX)
+		offload |= NIC_OFFLOAD_TSO4;
+
+	virtio_net->offload_supported = offload;
+	virtio_net->offload_active = offload;
 }
 
 static errno_t virtio_net_initialize(ddf_dev_t *dev)
@@ -196,8 +455,16 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev,
-	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ);
+	rc = virtio_device_setup_negotiate(vdev,
+	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ,
+	    VIRTIO_NET_OPTIONAL_FEATURES);
+	if (rc == EOK && (vdev->features & VIRTIO_NET_F_GUEST_TSO4) &&
+	    !(vdev->features & VIRTIO_NET_F_MRG_RXBUF)) {
+		/* Merged TCP segments would not fit into the RX buffers */
+		rc = virtio_device_setup_negotiate(vdev,
+		    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ,
+		    VIRTIO_NET_OPTIONAL_FEATURES & ~VIRTIO_NET_F_GUEST_TSO4);
+	}
 	if (rc != EOK)
 		goto fail;
 
@@ -220,10 +487,20 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 	}
 
-	rc = virtio_virtq_setup(vdev, RX_QUEUE_1, RX_BUFFERS);
+	/* Use as many RX and TX buffers as the device allows, up to a limit */
+	virtio_net->rx_count = min(virtio_virtq_max_size(vdev, RX_QUEUE_1),
+	    VIRTIO_NET_RING_MAX);
+	virtio_net->tx_count = min(virtio_virtq_max_size(vdev, TX_QUEUE_1),
+	    VIRTIO_NET_RING_MAX);
+	if (virtio_net->rx_count == 0 || virtio_net->tx_count == 0) {
+		rc = ENOMEM;
+		goto fail;
+	}
+
+	rc = virtio_virtq_setup(vdev, RX_QUEUE_1, virtio_net->rx_count);
 	if (rc != EOK)
 		goto fail;
-	rc = virtio_virtq_setup(vdev, TX_QUEUE_1, TX_BUFFERS);
+	rc = virtio_virtq_setup(vdev, TX_QUEUE_1, virtio_net->tx_count);
 	if (rc != EOK)
 		goto fail;
 	rc = virtio_virtq_setup(vdev, CT_QUEUE_1, CT_BUFFERS);
@@ -233,12 +510,7 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/*
 	 * Setup DMA buffers
 	 */
-	rc = virtio_setup_dma_bufs(RX_BUFFERS, RX_BUF_SIZE, false,
-	    virtio_net->rx_buf, virtio_net->rx_buf_p);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_setup_dma_bufs(TX_BUFFERS, TX_BUF_SIZE, true,
-	    virtio_net->tx_buf, virtio_net->tx_buf_p);
+	rc = virtio_net_setup_bufs(virtio_net);
 	if (rc != EOK)
 		goto fail;
 	rc = virtio_setup_dma_bufs(CT_BUFFERS, CT_BUF_SIZE, true,
@@ -249,7 +521,7 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/*
 	 * Give all RX buffers to the NIC
 	 */
-	for (unsigned i = 0; i < RX_BUFFERS; i++) {
+	for (unsigned i = 0; i < virtio_net->rx_count; i++) {
 		/*
 		 * Associtate the buffer with the descriptor, set length and
 		 * flags.
@@ -267,7 +539,7 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/*
 	 * Put all TX and CT buffers on a free list
 	 */
-	virtio_create_desc_free_list(vdev, TX_QUEUE_1, TX_BUFFERS,
+	virtio_create_desc_free_list(vdev, TX_QUEUE_1, virtio_net->tx_count,
 	    &virtio_net->tx_free_head);
 	virtio_create_desc_free_list(vdev, CT_QUEUE_1, CT_BUFFERS,
 	    &virtio_net->ct_free_head);
@@ -284,17 +556,25 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 
 	ddf_msg(LVL_NOTE, "MAC address: " PRIMAC, ARGSMAC(nic_addr.address));
 
+	virtio_net_setup_offload(virtio_net);
+	ddf_msg(LVL_NOTE, "%u RX and %u TX buffers, offloads %" PRIx32,
+	    virtio_net->rx_count, virtio_net->tx_count,
+	    virtio_net->offload_supported);
+
 	/*
 	 * Enable IRQ
 	 */
-	rc = hw_res_enable_interrupt(ddf_dev_parent_sess_get(dev),
-	    virtio_net->irq);
-	if (rc != EOK) {
-		ddf_msg(LVL_NOTE, "Failed to enable interrupt");
-		goto fail;
+	for (size_t i = 0; i < virtio_net->irq_count; i++) {
+		rc = hw_res_enable_interrupt(ddf_dev_parent_sess_get(dev),
+		    virtio_net->irq + i);
+		if (rc != EOK) {
+			ddf_msg(LVL_NOTE, "Failed to enable interrupt");
+			goto fail;
+		}
 	}
 
-	ddf_msg(LVL_NOTE, "Registered IRQ %d", virtio_net->irq);
+	ddf_msg(LVL_NOTE, "Registered IRQ %d (%zu vector(s))", virtio_net->irq,
+	    virtio_net->irq_count);
 
 	/* Go live */
 	virtio_device_setup_finalize(vdev);
@@ -302,9 +582,7 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	return EOK;
 
 fail:
-	virtio_teardown_dma_bufs(virtio_net->rx_buf);
-	virtio_teardown_dma_bufs(virtio_net->tx_buf);
-	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+	virtio_net_teardown_bufs(virtio_net);
 
 	virtio_device_setup_fail(vdev);
 	virtio_pci_dev_cleanup(vdev);
@@ -316,47 +594,138 @@ static void virtio_net_uninitialize(ddf_dev_t *dev)
 	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = (virtio_net_t *) nic_get_specific(nic);
 
-	virtio_teardown_dma_bufs(virtio_net->rx_buf);
-	virtio_teardown_dma_bufs(virtio_net->tx_buf);
-	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+	virtio_net_teardown_bufs(virtio_net);
 
 	virtio_device_setup_fail(&virtio_net->virtio_dev);
 	virtio_pci_dev_cleanup(&virtio_net->virtio_dev);
 }
 
-static void virtio_net_send(nic_t *nic, void *data, size_t size)
+/** Fill in the packet header for the offloads requested for a frame.
+ *
+ * @return EOK on success, ENOTSUP if the offloads are not active or EINVAL
+ *         if they do not match the frame.
+ */
+static errno_t virtio_net_hdr_offload(virtio_net_t *virtio_net,
+    virtio_net_hdr_t *hdr, const uint8_t *data, size_t size,
+    const nic_tx_offload_t *offload)
+{
+	if (offload->csum_start == 0)
+		return offload->gso_size == 0 ? EOK : EINVAL;
+
+	if (!(virtio_net->offload_active & NIC_OFFLOAD_TX_CSUM))
+		return ENOTSUP;
+	if ((size_t) offload->csum_start + offload->csum_offset + 2 > size)
+		return EINVAL;
+
+	hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+	hdr->csum_start = host2uint16_t_le(offload->csum_start);
+	hdr->csum_offset = host2uint16_t_le(offload->csum_offset);
+
+	if (offload->gso_size == 0)
+		return EOK;
+
+	if (!(virtio_net->offload_active & NIC_OFFLOAD_TSO4))
+		return ENOTSUP;
+
+	/* The headers end with the TCP header starting at csum_start */
+	if ((size_t) offload->csum_start + 13 > size)
+		return EINVAL;
+	size_t hdr_len = offload->csum_start +
+	    (data[offload->csum_start + 12] >> 4) * sizeof(uint32_t);
+
+	hdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+	hdr->gso_size = host2uint16_t_le(offload->gso_size);
+	hdr->hdr_len = host2uint16_t_le(hdr_len);
+	return EOK;
+}
+
+/** Send a frame, copying it into a chain of TX buffers.
+ *
+ * The first buffer starts with the packet header, frames larger than
+ * one buffer continue in the next buffers of the chain.
+ *
+ * @param offload  Offloads requested for the frame or NULL
+ */
+static void virtio_net_send_frame(nic_t *nic, void *data, size_t size,
+    const nic_tx_offload_t *offload)
 {
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	uint16_t chain[TX_CHAIN_MAX];
 
-	if (size > sizeof(virtio_net) + TX_BUF_SIZE) {
+	if (size > TX_FRAME_MAX) {
 		ddf_msg(LVL_WARN, "TX data too big, frame dropped");
 		return;
 	}
 
-	uint16_t descno = virtio_alloc_desc(vdev, TX_QUEUE_1,
-	    &virtio_net->tx_free_head);
-	if (descno == (uint16_t) -1U) {
-		ddf_msg(LVL_WARN, "No TX buffers available, frame dropped");
-		return;
+	size_t count = (sizeof(virtio_net_hdr_t) + size + TX_BUF_SIZE - 1) /
+	    TX_BUF_SIZE;
+	for (size_t i = 0; i < count; i++) {
+		chain[i] = virtio_alloc_desc(vdev, TX_QUEUE_1,
+		    &virtio_net->tx_free_head);
+		if (chain[i] == (uint16_t) -1U) {
+			ddf_msg(LVL_WARN,
+			    "No TX buffers available, frame dropped");
+			while (i-- > 0) {
+				virtio_free_desc(vdev, TX_QUEUE_1,
+				    &virtio_net->tx_free_head, chain[i]);
+			}
+			return;
+		}
+		assert(chain[i] < virtio_net->tx_count);
 	}
-	assert(descno < TX_BUFFERS);
 
 	/* Setup the packet header */
-	virtio_net_hdr_t *hdr = (virtio_net_hdr_t *) virtio_net->tx_buf[descno];
+	virtio_net_hdr_t *hdr =
+	    (virtio_net_hdr_t *) virtio_net->tx_buf[chain[0]];
 	memset(hdr, 0, sizeof(virtio_net_hdr_t));
 	hdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
 	hdr->num_buffers = 0;
 
-	/* Copy packet data into the buffer just past the header */
-	memcpy(&hdr[1], data, size);
+	if (offload != NULL) {
+		errno_t rc = virtio_net_hdr_offload(virtio_net, hdr, data,
+		    size, offload);
+		if (rc != EOK) {
+			ddf_msg(LVL_WARN, "Invalid TX offload, frame dropped");
+			for (size_t i = 0; i < count; i++) {
+				virtio_free_desc(vdev, TX_QUEUE_1,
+				    &virtio_net->tx_free_head, chain[i]);
+			}
+			return;
+		}
+	}
 
 	/*
-	 * Set the descriptor, put it into the virtqueue and notify the device
+	 * Copy the packet data just past the header and set the descriptors
 	 */
-	virtio_virtq_desc_set(vdev, TX_QUEUE_1, descno,
-	    virtio_net->tx_buf_p[descno], sizeof(virtio_net_hdr_t) + size, 0, 0);
-	virtio_virtq_produce_available(vdev, TX_QUEUE_1, descno);
+	size_t offs = 0;
+	for (size_t i = 0; i < count; i++) {
+		size_t hsize = (i == 0) ? sizeof(virtio_net_hdr_t) : 0;
+		size_t chunk = min(TX_BUF_SIZE - hsize, size - offs);
+		bool last = (i + 1 == count);
+
+		memcpy((uint8_t *) virtio_net->tx_buf[chain[i]] + hsize,
+		    (uint8_t *) data + offs, chunk);
+		offs += chunk;
+
+		virtio_virtq_desc_set(vdev, TX_QUEUE_1, chain[i],
+		    virtio_net->tx_buf_p[chain[i]], hsize + chunk,
+		    last ? 0 : VIRTQ_DESC_F_NEXT, last ? 0 : chain[i + 1]);
+	}
+
+	/* Put the chain into the virtqueue and notify the device */
+	virtio_virtq_produce_available(vdev, TX_QUEUE_1, chain[0]);
+}
+
+static void virtio_net_send(nic_t *nic, void *data, size_t size)
+{
+	virtio_net_send_frame(nic, data, size, NULL);
+}
+
+static void virtio_net_send_offload(nic_t *nic, void *data, size_t size,
+    const nic_tx_offload_t *offload)
+{
+	virtio_net_send_frame(nic, data, size, offload);
 }
 
 static errno_t virtio_net_on_multicast_mode_change(nic_t *nic,
@@ -411,6 +780,7 @@ static errno_t virtio_net_dev_add(ddf_dev_t *dev)
 	ddf_fun_set_ops(fun, &virtio_net_dev_ops);
 
 	nic_set_send_frame_handler(nic, virtio_net_send);
+	nic_set_send_offload_handler(nic, virtio_net_send_offload);
 	nic_set_filtering_change_handlers(nic, NULL,
 	    virtio_net_on_multicast_mode_change,
 	    virtio_net_on_broadcast_mode_change, NULL, NULL);
@@ -471,10 +841,52 @@ static errno_t virtio_net_get_operation_mode(ddf_fun_t *fun, int *speed,
 	return EOK;
 }
 
+static errno_t virtio_net_offload_probe(ddf_fun_t *fun, uint32_t *supported,
+    uint32_t *active)
+{
+	nic_t *nic = nic_get_from_ddf_fun(fun);
+	if (!nic)
+		return ENOENT;
+
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	*supported = virtio_net->offload_supported;
+	*active = virtio_net->offload_active;
+	return EOK;
+}
+
+static errno_t virtio_net_offload_set(ddf_fun_t *fun, uint32_t mask,
+    uint32_t active)
+{
+	nic_t *nic = nic_get_from_ddf_fun(fun);
+	if (!nic)
+		return ENOENT;
+
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	uint32_t offload = (virtio_net->offload_active & ~mask) |
+	    (active & mask);
+
+	if ((offload & ~virtio_net->offload_supported) != 0)
+		return ENOTSUP;
+
+	/* Receive offloads are fixed by the negotiated features */
+	uint32_t rx = NIC_OFFLOAD_RX_CSUM | NIC_OFFLOAD_LRO4;
+	if ((offload & rx) != (virtio_net->offload_active & rx))
+		return ENOTSUP;
+
+	/* Segmentation relies on the device completing the checksums */
+	if ((offload & NIC_OFFLOAD_TSO4) && !(offload & NIC_OFFLOAD_TX_CSUM))
+		return EINVAL;
+
+	virtio_net->offload_active = offload;
+	return EOK;
+}
+
 static nic_iface_t virtio_net_nic_iface = {
 	.get_device_info = virtio_net_get_device_info,
 	.get_cable_state = virtio_net_get_cable_state,
 	.get_operation_mode = virtio_net_get_operation_mode,
+	.offload_probe = virtio_net_offload_probe,
+	.offload_set = virtio_net_offload_set,
 };
 
 int main(void)
@@ -33,20 +33,33 @@
 #include <abi/cap.h>
 #include <nic/nic.h>
 
-#define RX_BUFFERS	8
-#define TX_BUFFERS	8
+/** Upper bound of the number of RX and TX buffers, each of them 2 KiB */
+#define VIRTIO_NET_RING_MAX	256
 #define CT_BUFFERS	4
 
+/** MSI-X vectors, one for RX and control, one for TX */
+#define VIRTIO_NET_MSIX_VECTORS	2
+
 /** Device handles packets with partial checksum. */
 #define VIRTIO_NET_F_CSUM		(1U << 0)
 /** Driver handles packets with partial checksum. */
 #define VIRTIO_NET_F_GUEST_CSUM		(1U << 2)
 /** Device has given MAC address. */
 #define VIRTIO_NET_F_MAC		(1U << 5)
+/** Driver can receive TSOv4. */
+#define VIRTIO_NET_F_GUEST_TSO4		(1U << 7)
+/** Device can receive TSOv4. */
+#define VIRTIO_NET_F_HOST_TSO4		(1U << 11)
+/** Driver can merge receive buffers. */
+#define VIRTIO_NET_F_MRG_RXBUF		(1U << 15)
 /** Control channel is available */
 #define VIRTIO_NET_F_CTRL_VQ		(1U << 17)
 
+/** Checksum from csum_start to the end of the packet is to be completed */
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM	1
+
 #define VIRTIO_NET_HDR_GSO_NONE 0
+#define VIRTIO_NET_HDR_GSO_TCPV4 1
 typedef struct {
 	uint8_t flags;
 	uint8_t gso_type;
@@ -63,18 +76,30 @@ typedef struct {
 
 typedef struct {
 	virtio_dev_t virtio_dev;
-	void *rx_buf[RX_BUFFERS];
-	uintptr_t rx_buf_p[RX_BUFFERS];
-	void *tx_buf[TX_BUFFERS];
-	uintptr_t tx_buf_p[TX_BUFFERS];
+
+	/** Number of RX and TX buffers, follows the size of the virtqueues */
+	uint16_t rx_count;
+	uint16_t tx_count;
+
+	void **rx_buf;
+	uintptr_t *rx_buf_p;
+	void **tx_buf;
+	uintptr_t *tx_buf_p;
 	void *ct_buf[CT_BUFFERS];
 	uintptr_t ct_buf_p[CT_BUFFERS];
 
 	uint16_t tx_free_head;
 	uint16_t ct_free_head;
 
+	/** Offloads permitted by the negotiated features, see NIC_OFFLOAD_* */
+	uint32_t offload_supported;
+	/** Offloads currently in use */
+	uint32_t offload_active;
+
+	/** First IRQ and number of IRQs used by the device */
 	int irq;
-	cap_irq_handle_t irq_handle;
+	size_t irq_count;
+	cap_irq_handle_t irq_handle[VIRTIO_NET_MSIX_VECTORS];
 } virtio_net_t;
 
 #endif
@@ -55,6 +55,7 @@
 #include <offset.h>
 #include <inttypes.h>
 #include "block.h"
+#include "bsched.h"
 
 #define MAX_WRITE_RETRIES 10
 
@@ -72,6 +73,10 @@ typedef struct {
 	hash_table_t block_hash;
 	list_t free_list;
 	enum cache_mode mode;
+	/** Journal which takes over dirty blocks or NULL */
+	block_journal_ops_t *jops;
+	/** Argument of the journal operations */
+	void *jarg;
 } cache_t;
 
 typedef struct {
@@ -84,6 +89,7 @@ typedef struct {
 	aoff64_t pblocks;    /**< Number of physical blocks */
 	size_t pblock_size;  /**< Physical block size. */
 	cache_t *cache;
+	bsched_t *sched;     /**< I/O scheduler or NULL */
 } devcon_t;
 
 static errno_t read_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
@@ -123,6 +129,7 @@ static errno_t devcon_add(service_id_t service_id, async_sess_t *sess,
 	devcon->pblock_size = bsize;
 	devcon->pblocks = dev_size;
 	devcon->cache = NULL;
+	devcon->sched = NULL;
 
 	fibril_mutex_lock(&dcl_lock);
 	list_foreach(dcl, link, devcon_t, d) {
@@ -194,6 +201,9 @@ void block_fini(service_id_t service_id)
 	if (devcon->cache)
 		(void) block_cache_fini(service_id);
 
+	if (devcon->sched)
+		bsched_destroy(devcon->sched);
+
 	(void)bd_sync_cache(devcon->bd, 0, 0);
 
 	devcon_remove(devcon);
@@ -267,6 +277,21 @@ static hash_table_ops_t cache_ops = {
 	.remove_callback = NULL
 };
 
+/** Write a dirty block back.
+ *
+ * If a journal is attached to the cache, the block is handed over to the
+ * journal, which becomes responsible for writing it to its home location.
+ * Otherwise the block is written to the device.
+ */
+static errno_t cache_write_back(devcon_t *devcon, cache_t *cache, block_t *b)
+{
+	if (cache->jops != NULL)
+		return cache->jops->write(cache->jarg, b->lba, b->data, b->size);
+
+	return write_blocks(devcon, b->pba, cache->blocks_cluster, b->data,
+	    b->size);
+}
+
 errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
     enum cache_mode mode)
 {
@@ -286,6 +311,8 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 	cache->block_count = blocks;
 	cache->blocks_cached = 0;
 	cache->mode = mode;
+	cache->jops = NULL;
+	cache->jarg = NULL;
 
 	/* Allow 1:1 or small-to-large block size translation */
 	if (cache->lblock_size % devcon->pblock_size != 0) {
@@ -327,8 +354,7 @@ errno_t block_cache_fini(service_id_t service_id)
 
 		list_remove(&b->free_link);
 		if (b->dirty) {
-			rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, b->size);
+			rc = cache_write_back(devcon, cache, b);
 			if (rc != EOK)
 				return rc;
 		}
@@ -346,6 +372,39 @@ errno_t block_cache_fini(service_id_t service_id)
 	return EOK;
 }
 
+/** Attach a journal to a block cache.
+ *
+ * From now on, dirty blocks are not written to the device. They are handed
+ * over to @a ops->write instead. Before a block is read from the device,
+ * @a ops->read is given a chance to supply a newer copy. Blocks transferred
+ * with block_read_range() and block_write_range() bypass the journal.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param ops		Journal operations or NULL to detach the journal.
+ * @param arg		Argument passed to the journal operations.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_cache_set_journal(service_id_t service_id,
+    block_journal_ops_t *ops, void *arg)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+
+	if (!devcon)
+		return ENOENT;
+	if (!devcon->cache)
+		return ENOENT;
+	cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->lock);
+	cache->jops = ops;
+	cache->jarg = arg;
+	fibril_mutex_unlock(&cache->lock);
+
+	return EOK;
+}
+
 #define CACHE_LO_WATERMARK	10
 #define CACHE_HI_WATERMARK	20
 static bool cache_can_grow(cache_t *cache)
@@ -473,8 +532,7 @@ retry:
 				list_remove(&b->free_link);
 				list_append(&b->free_link, &cache->free_list);
 				fibril_mutex_unlock(&cache->lock);
-				rc = write_blocks(devcon, b->pba,
-				    cache->blocks_cluster, b->data, b->size);
+				rc = cache_write_back(devcon, cache, b);
 				if (rc != EOK) {
 					/*
 					 * We did not manage to write the block
@@ -548,10 +606,17 @@ retry:
 		if (!(flags & BLOCK_FLAGS_NOREAD)) {
 			/*
 			 * The block contains old or no data. We need to read
-			 * the new contents from the device.
+			 * the new contents from the journal, which may hold a
+			 * newer copy than the home location, or from the
+			 * device.
 			 */
-			rc = read_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, cache->lblock_size);
+			if (cache->jops == NULL ||
+			    !cache->jops->read(cache->jarg, b->lba, b->data,
+			    cache->lblock_size)) {
+				rc = read_blocks(devcon, b->pba,
+				    cache->blocks_cluster, b->data,
+				    cache->lblock_size);
+			}
 			if (rc != EOK)
 				b->toxic = true;
 		} else
@@ -583,6 +648,7 @@ errno_t block_put(block_t *block)
 	cache_t *cache;
 	unsigned blocks_cached;
 	enum cache_mode mode;
+	bool journal;
 	errno_t rc = EOK;
 
 	assert(devcon);
@@ -595,6 +661,7 @@ retry:
 	fibril_mutex_lock(&cache->lock);
 	blocks_cached = cache->blocks_cached;
 	mode = cache->mode;
+	journal = cache->jops != NULL;
 	fibril_mutex_unlock(&cache->lock);
 
 	/*
@@ -603,14 +670,17 @@ retry:
 	 * Since the situation may have changed when we unlocked the cache, the
 	 * blocks_cached and mode variables are mere hints. We will recheck the
 	 * conditions later when the cache lock is held again.
+	 *
+	 * A journal takes over the block on every put, even if there are
+	 * other references. The journal must see all modifications made by an
+	 * operation by the time the operation finishes.
 	 */
 	fibril_mutex_lock(&block->lock);
 	if (block->toxic)
 		block->dirty = false;	/* will not write back toxic block */
-	if (block->dirty && (block->refcnt == 1) &&
-	    (blocks_cached > CACHE_HI_WATERMARK || mode != CACHE_MODE_WB)) {
-		rc = write_blocks(devcon, block->pba, cache->blocks_cluster,
-		    block->data, block->size);
+	if (block->dirty && (journal || ((block->refcnt == 1) &&
+	    (blocks_cached > CACHE_HI_WATERMARK || mode != CACHE_MODE_WB)))) {
+		rc = cache_write_back(devcon, cache, block);
 		if (rc == EOK)
 			block->write_failures = 0;
 		block->dirty = false;
@@ -787,6 +857,172 @@ errno_t block_write_direct(service_id_t service_id, aoff64_t ba, size_t cnt,
 	return write_blocks(devcon, ba, cnt, (void *)data, devcon->pblock_size * cnt);
 }
 
+/** Find a cached block.
+ *
+ * @param cache		Cache to search.
+ * @param ba		Logical block address.
+ *
+ * @return		Block with its lock held or NULL if the block is not
+ *			cached.
+ */
+static block_t *cache_lock_block(cache_t *cache, aoff64_t ba)
+{
+	block_t *b = NULL;
+
+	fibril_mutex_lock(&cache->lock);
+	ht_link_t *hlink = hash_table_find(&cache->block_hash, &ba);
+	if (hlink) {
+		b = hash_table_get_inst(hlink, block_t, hash_link);
+		fibril_mutex_lock(&b->lock);
+	}
+	fibril_mutex_unlock(&cache->lock);
+
+	return b;
+}
+
+/** Read a range of logical blocks.
+ *
+ * The blocks are not instantiated in the cache, which makes this suitable for
+ * large sequential transfers. Blocks which are cached are copied from the
+ * cache, so that their latest contents are returned even if they have not
+ * been written back yet. Each run of blocks which are not cached is read from
+ * the device with as few requests as possible, each at most one data transfer
+ * (DATA_XFER_LIMIT) long.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param ba		Address of the first block (logical).
+ * @param cnt		Number of blocks.
+ * @param buf		Buffer for storing the data.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_read_range(service_id_t service_id, aoff64_t ba, size_t cnt,
+    void *buf)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+	uint8_t *dst = buf;
+	size_t run = 0;
+	size_t max_run;
+	errno_t rc;
+
+	assert(devcon);
+	assert(devcon->cache);
+
+	cache = devcon->cache;
+	max_run = max(DATA_XFER_LIMIT / cache->lblock_size, 1);
+
+	if (ba_ltop(devcon, ba + cnt) > devcon->pblocks)
+		return EIO;
+
+	for (size_t i = 0; i <= cnt; i++) {
+		if (i < cnt) {
+			block_t *b = cache_lock_block(cache, ba + i);
+			if (b == NULL || b->toxic) {
+				if (b != NULL)
+					fibril_mutex_unlock(&b->lock);
+
+				/* Read a run which fills a whole data transfer. */
+				if (run == max_run) {
+					rc = read_blocks(devcon,
+					    ba_ltop(devcon, ba + i - run),
+					    run * cache->blocks_cluster,
+					    dst + (i - run) * cache->lblock_size,
+					    run * cache->lblock_size);
+					if (rc != EOK)
+						return rc;
+					run = 0;
+				}
+
+				run++;
+				continue;
+			}
+
+			memcpy(dst + i * cache->lblock_size, b->data,
+			    cache->lblock_size);
+			fibril_mutex_unlock(&b->lock);
+		}
+
+		if (run > 0) {
+			/* Read the preceding run of uncached blocks. */
+			rc = read_blocks(devcon, ba_ltop(devcon, ba + i - run),
+			    run * cache->blocks_cluster,
+			    dst + (i - run) * cache->lblock_size,
+			    run * cache->lblock_size);
+			if (rc != EOK)
+				return rc;
+			run = 0;
+		}
+	}
+
+	return EOK;
+}
+
+/** Write a range of logical blocks.
+ *
+ * The range is written to the device in requests of at most one data
+ * transfer (DATA_XFER_LIMIT) each. Cached copies of the blocks are updated
+ * first, so that a later write-back of an older dirty copy cannot overwrite
+ * the new data.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param ba		Address of the first block (logical).
+ * @param cnt		Number of blocks.
+ * @param data		The data to be written.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_write_range(service_id_t service_id, aoff64_t ba, size_t cnt,
+    const void *data)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+	const uint8_t *src = data;
+	size_t max_run;
+	size_t n;
+	errno_t rc = EOK;
+
+	assert(devcon);
+	assert(devcon->cache);
+
+	cache = devcon->cache;
+	max_run = max(DATA_XFER_LIMIT / cache->lblock_size, 1);
+
+	if (ba_ltop(devcon, ba + cnt) > devcon->pblocks)
+		return EIO;
+
+	for (size_t i = 0; i < cnt; i++) {
+		block_t *b = cache_lock_block(cache, ba + i);
+		if (b != NULL) {
+			memcpy(b->data, src + i * cache->lblock_size,
+			    cache->lblock_size);
+			b->dirty = false;
+			fibril_mutex_unlock(&b->lock);
+		}
+	}
+
+	for (size_t i = 0; i < cnt && rc == EOK; i += n) {
+		n = min(cnt - i, max_run);
+		rc = write_blocks(devcon, ba_ltop(devcon, ba + i),
+		    n * cache->blocks_cluster,
+		    (void *) (src + i * cache->lblock_size),
+		    n * cache->lblock_size);
+	}
+
+	if (rc != EOK) {
+		/* Let the cached copies be written back later. */
+		for (size_t i = 0; i < cnt; i++) {
+			block_t *b = cache_lock_block(cache, ba + i);
+			if (b != NULL) {
+				b->dirty = true;
+				fibril_mutex_unlock(&b->lock);
+			}
+		}
+	}
+
+	return rc;
+}
+
 /** Synchronize blocks to persistent storage.
  *
  * @param service_id	Service ID of the block device.
@@ -805,6 +1041,43 @@ errno_t block_sync_cache(service_id_t service_id, aoff64_t ba, size_t cnt)
 	return bd_sync_cache(devcon->bd, ba, cnt);
 }
 
+/** Set I/O scheduling for a block device.
+ *
+ * With a policy other than @c BLOCK_SCHED_NONE, requests from concurrent
+ * fibrils are queued, adjacent requests are merged into larger transfers
+ * and up to @a depth requests are kept outstanding at the device. This
+ * must not be called while requests to the device are in progress.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param policy	Scheduling policy.
+ * @param depth		Maximum number of requests outstanding at the device.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_sched_set(service_id_t service_id, block_sched_policy_t policy,
+    unsigned depth)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	bsched_t *sched = NULL;
+	errno_t rc;
+
+	if (!devcon)
+		return ENOENT;
+
+	if (policy != BLOCK_SCHED_NONE) {
+		rc = bsched_create(service_id, devcon->pblock_size, policy,
+		    depth, &sched);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if (devcon->sched)
+		bsched_destroy(devcon->sched);
+	devcon->sched = sched;
+
+	return EOK;
+}
+
 /** Get device block size.
  *
  * @param service_id	Service ID of the block device.
@@ -921,7 +1194,12 @@ static errno_t read_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt, void *buf,
 {
 	assert(devcon);
 
-	errno_t rc = bd_read_blocks(devcon->bd, ba, cnt, buf, size);
+	errno_t rc;
+
+	if (devcon->sched != NULL)
+		rc = bsched_read(devcon->sched, ba, cnt, buf, size);
+	else
+		rc = bd_read_blocks(devcon->bd, ba, cnt, buf, size);
 	if (rc != EOK) {
 		printf("Error %s reading %zu blocks starting at block %" PRIuOFF64
 		    " from device handle %" PRIun "\n", str_error_name(rc), cnt, ba,
@@ -948,7 +1226,12 @@ static errno_t write_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt, void *dat
 {
 	assert(devcon);
 
-	errno_t rc = bd_write_blocks(devcon->bd, ba, cnt, data, size);
+	errno_t rc;
+
+	if (devcon->sched != NULL)
+		rc = bsched_write(devcon->sched, ba, cnt, data, size);
+	else
+		rc = bd_write_blocks(devcon->bd, ba, cnt, data, size);
 	if (rc != EOK) {
 		printf("Error %s writing %zu blocks starting at block %" PRIuOFF64
 		    " to device handle %" PRIun "\n", str_error_name(rc), cnt, ba, devcon->service_id);
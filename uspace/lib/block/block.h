@@ -90,6 +90,14 @@ typedef struct block {
 	void *data;
 } block_t;
 
+/** Journal attached to a block cache. */
+typedef struct {
+	/** Take over a dirty block instead of writing it to the device. */
+	errno_t (*write)(void *, aoff64_t, const void *, size_t);
+	/** Supply a newer copy of a block than its home location holds. */
+	bool (*read)(void *, aoff64_t, void *, size_t);
+} block_journal_ops_t;
+
 /** Caching mode */
 enum cache_mode {
 	/** Write-Through */
@@ -98,6 +106,18 @@ enum cache_mode {
 	CACHE_MODE_WB
 };
 
+/** I/O scheduling policy */
+typedef enum {
+	/** Pass requests to the device one by one, as they are submitted */
+	BLOCK_SCHED_NONE,
+	/** Dispatch in submission order, merging adjacent requests */
+	BLOCK_SCHED_FIFO,
+	/** Dispatch in one-way elevator (C-LOOK) order */
+	BLOCK_SCHED_ELEVATOR,
+	/** Elevator order, but expired requests are dispatched first */
+	BLOCK_SCHED_DEADLINE
+} block_sched_policy_t;
+
 extern errno_t block_init(service_id_t, size_t);
 extern void block_fini(service_id_t);
 
@@ -106,6 +126,8 @@ extern void *block_bb_get(service_id_t);
 
 extern errno_t block_cache_init(service_id_t, size_t, unsigned, enum cache_mode);
 extern errno_t block_cache_fini(service_id_t);
+extern errno_t block_cache_set_journal(service_id_t, block_journal_ops_t *,
+    void *);
 
 extern errno_t block_get(block_t **, service_id_t, aoff64_t, int);
 extern errno_t block_put(block_t *);
@@ -119,7 +141,10 @@ extern errno_t block_read_toc(service_id_t, uint8_t, void *, size_t);
 extern errno_t block_read_direct(service_id_t, aoff64_t, size_t, void *);
 extern errno_t block_read_bytes_direct(service_id_t, aoff64_t, size_t, void *);
 extern errno_t block_write_direct(service_id_t, aoff64_t, size_t, const void *);
+extern errno_t block_read_range(service_id_t, aoff64_t, size_t, void *);
+extern errno_t block_write_range(service_id_t, aoff64_t, size_t, const void *);
 extern errno_t block_sync_cache(service_id_t, aoff64_t, size_t);
+extern errno_t block_sched_set(service_id_t, block_sched_policy_t, unsigned);
 
 #endif
 
@@ -0,0 +1,756 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libblock
+ * @{
+ */
+/**
+ * @file
+ * @brief Block I/O scheduler.
+ *
+ * Requests from all fibrils of the client are put into a queue, from which
+ * up to @c depth requests at a time are passed to the device. If the device
+ * supports request queues, the requests are submitted to the slots of a
+ * request queue on a single connection, with the data in the buffer shared
+ * with the device, and a completion fibril collects them as they finish.
+ * Servers which forward requests, such as vbd for partitions, pass the
+ * request queue on to the underlying device. Otherwise the queue is served
+ * by a number of worker fibrils, one for each request that may be
+ * outstanding at the device, each with its own connection to the device.
+ *
+ * A worker picks the next request according to the policy and merges it
+ * with queued requests of the same direction which are adjacent to it on
+ * the device, up to the size of a single data transfer. Requests which
+ * overlap an older queued request or a request in flight, where either of
+ * the two is a write, are held back so that the data seen by the client is
+ * the same as if the requests were served in submission order.
+ */
+
+#include <adt/list.h>
+#include <async.h>
+#include <bd.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <ipc/loc.h>
+#include <loc.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bsched.h"
+
+/** Time after which a queued read is dispatched ahead of others */
+#define BSCHED_READ_EXPIRE	(500 * 1000 * 1000)
+/** Time after which a queued write is dispatched ahead of others */
+#define BSCHED_WRITE_EXPIRE	((nsec_t) 5 * 1000 * 1000 * 1000)
+
+/** Maximum number of requests outstanding at the device */
+#define BSCHED_DEPTH_MAX	32
+
+/** Queued block request */
+typedef struct {
+	/** Link to bsched_t.queue or bsched_t.inflight, in submission order */
+	link_t link;
+	/** Link to bsched_t.sorted or to the batch being dispatched */
+	link_t sorted_link;
+	/** Request writes data to the device */
+	bool write;
+	/** Address of the first block */
+	aoff64_t ba;
+	/** Number of blocks */
+	size_t cnt;
+	/** Data buffer */
+	void *buf;
+	/** Time after which the request is served first */
+	struct timespec deadline;
+	/** Request has been completed */
+	bool done;
+	/** Result of the request */
+	errno_t rc;
+	/** Signalled when the request is completed */
+	fibril_condvar_t done_cv;
+} bsched_req_t;
+
+/** Worker serving the queue */
+typedef struct {
+	bsched_t *sched;
+	/** Session to the device */
+	async_sess_t *sess;
+	/** Block device */
+	bd_t *bd;
+	/** Buffer for merged requests */
+	void *buf;
+} bsched_worker_t;
+
+/** Block I/O scheduler */
+struct bsched {
+	/** Lock protecting the scheduler */
+	fibril_mutex_t lock;
+	/** Signalled when a request may have become ready for dispatch */
+	fibril_condvar_t queue_cv;
+	/** Signalled when a worker exits */
+	fibril_condvar_t exit_cv;
+	/** Queued requests in submission order */
+	list_t queue;
+	/** Queued requests sorted by block address */
+	list_t sorted;
+	/** Requests being served by the device */
+	list_t inflight;
+	/** Scheduling policy */
+	block_sched_policy_t policy;
+	/** Block size */
+	size_t bsize;
+	/** Maximum number of blocks in one merged request */
+	size_t max_blocks;
+	/** Block following the last dispatched request */
+	aoff64_t head;
+	/** Workers, one per request outstanding at the device */
+	bsched_worker_t *workers;
+	/** Number of workers */
+	unsigned depth;
+	/** Number of running workers */
+	unsigned running;
+	/** Workers should exit once the queue is empty */
+	bool quit;
+	/** Session used with the request queue */
+	async_sess_t *qsess;
+	/** Block device used with the request queue */
+	bd_t *qbd;
+	/** Request queue or @c NULL if the workers are used */
+	bd_queue_t *bdq;
+	/** Requests of the batch in each slot of the request queue */
+	list_t slot_batch[BSCHED_DEPTH_MAX];
+	/** Slot is taken by a batch in flight */
+	bool slot_busy[BSCHED_DEPTH_MAX];
+	/** Number of batches in flight in the request queue */
+	unsigned slots_busy;
+};
+
+static errno_t bsched_worker_fibril(void *);
+
+/** Determine whether two requests must be served in submission order. */
+static bool bsched_req_conflict(bsched_req_t *a, bsched_req_t *b)
+{
+	if (!a->write && !b->write)
+		return false;
+
+	return a->ba < b->ba + b->cnt && b->ba < a->ba + a->cnt;
+}
+
+/** Determine whether a queued request may be dispatched now.
+ *
+ * @param sched Scheduler (locked)
+ * @param req Queued request
+ * @return @c true if no older queued request and no request in flight
+ *         conflicts with @a req
+ */
+static bool bsched_req_ready(bsched_t *sched, bsched_req_t *req)
+{
+	list_foreach(sched->inflight, link, bsched_req_t, r) {
+		if (bsched_req_conflict(r, req))
+			return false;
+	}
+
+	list_foreach(sched->queue, link, bsched_req_t, r) {
+		if (r == req)
+			break;
+		if (bsched_req_conflict(r, req))
+			return false;
+	}
+
+	return true;
+}
+
+/** Pick the next request to dispatch according to the policy.
+ *
+ * @param sched Scheduler (locked)
+ * @return Request or @c NULL if no queued request is ready
+ */
+static bsched_req_t *bsched_pick(bsched_t *sched)
+{
+	struct timespec now;
+
+	if (sched->policy == BLOCK_SCHED_DEADLINE) {
+		/* The oldest request is always ready */
+		bsched_req_t *oldest = list_get_instance(list_first(
+		    &sched->queue), bsched_req_t, link);
+
+		getuptime(&now);
+		if (ts_gteq(&now, &oldest->deadline) &&
+		    bsched_req_ready(sched, oldest))
+			return oldest;
+	}
+
+	if (sched->policy == BLOCK_SCHED_FIFO) {
+		list_foreach(sched->queue, link, bsched_req_t, r) {
+			if (bsched_req_ready(sched, r))
+				return r;
+		}
+
+		return NULL;
+	}
+
+	/* C-LOOK: first request at or above the head, then wrap around */
+	bsched_req_t *wrap = NULL;
+	list_foreach(sched->sorted, sorted_link, bsched_req_t, r) {
+		if (!bsched_req_ready(sched, r))
+			continue;
+		if (r->ba >= sched->head)
+			return r;
+		if (wrap == NULL)
+			wrap = r;
+	}
+
+	return wrap;
+}
+
+/** Determine whether a queued request can be merged into the batch. */
+static bool bsched_can_merge(bsched_t *sched, bsched_req_t *req,
+    bool write, size_t cnt)
+{
+	return req->write == write && cnt + req->cnt <= sched->max_blocks &&
+	    bsched_req_ready(sched, req);
+}
+
+/** Move a queued request to the in-flight list. */
+static void bsched_req_dispatch(bsched_t *sched, bsched_req_t *req)
+{
+	list_remove(&req->link);
+	list_remove(&req->sorted_link);
+	list_append(&req->link, &sched->inflight);
+}
+
+/** Build a batch of adjacent requests starting from the picked one.
+ *
+ * @param sched Scheduler (locked)
+ * @param first Request picked for dispatch
+ * @param batch List which receives the requests in block address order
+ * @param rba Place to store the address of the first block of the batch
+ * @param rcnt Place to store the number of blocks of the batch
+ */
+static void bsched_batch(bsched_t *sched, bsched_req_t *first, list_t *batch,
+    aoff64_t *rba, size_t *rcnt)
+{
+	aoff64_t ba = first->ba;
+	size_t cnt = first->cnt;
+	link_t *prev = list_prev(&first->sorted_link, &sched->sorted);
+	link_t *next = list_next(&first->sorted_link, &sched->sorted);
+
+	bsched_req_dispatch(sched, first);
+	list_append(&first->sorted_link, batch);
+
+	/* Merge requests which end where the batch begins */
+	while (prev != NULL) {
+		bsched_req_t *r = list_get_instance(prev, bsched_req_t,
+		    sorted_link);
+		if (r->ba + r->cnt != ba ||
+		    !bsched_can_merge(sched, r, first->write, cnt))
+			break;
+
+		prev = list_prev(prev, &sched->sorted);
+		bsched_req_dispatch(sched, r);
+		list_prepend(&r->sorted_link, batch);
+		ba = r->ba;
+		cnt += r->cnt;
+	}
+
+	/* Merge requests which begin where the batch ends */
+	while (next != NULL) {
+		bsched_req_t *r = list_get_instance(next, bsched_req_t,
+		    sorted_link);
+		if (r->ba != ba + cnt ||
+		    !bsched_can_merge(sched, r, first->write, cnt))
+			break;
+
+		next = list_next(next, &sched->sorted);
+		bsched_req_dispatch(sched, r);
+		list_append(&r->sorted_link, batch);
+		cnt += r->cnt;
+	}
+
+	*rba = ba;
+	*rcnt = cnt;
+}
+
+/** Complete the requests of a batch.
+ *
+ * @param sched Scheduler (locked)
+ * @param batch Batch
+ * @param rc Result of the batch
+ */
+static void bsched_batch_complete(bsched_t *sched, list_t *batch, errno_t rc)
+{
+	while (!list_empty(batch)) {
+		bsched_req_t *r = list_get_instance(list_first(batch),
+		    bsched_req_t, sorted_link);
+		list_remove(&r->sorted_link);
+		list_remove(&r->link);
+		r->rc = rc;
+		r->done = true;
+		fibril_condvar_signal(&r->done_cv);
+	}
+
+	/* Held back requests may have become ready */
+	fibril_condvar_broadcast(&sched->queue_cv);
+}
+
+/** Submit ready requests to free slots of the request queue.
+ *
+ * @param sched Scheduler (locked)
+ */
+static void bsched_queue_dispatch(bsched_t *sched)
+{
+	bsched_req_t *first;
+	aoff64_t ba;
+	size_t cnt;
+	errno_t rc;
+
+	while (sched->slots_busy < sched->depth &&
+	    !list_empty(&sched->queue)) {
+		first = bsched_pick(sched);
+		if (first == NULL)
+			break;
+
+		unsigned slot = 0;
+		while (sched->slot_busy[slot])
+			slot++;
+
+		list_t *batch = &sched->slot_batch[slot];
+		list_initialize(batch);
+		bsched_batch(sched, first, batch, &ba, &cnt);
+		sched->head = ba + cnt;
+
+		if (first->write) {
+			uint8_t *dst = bd_queue_slot_buf(sched->bdq, slot);
+			list_foreach(*batch, sorted_link, bsched_req_t, r) {
+				memcpy(dst, r->buf, r->cnt * sched->bsize);
+				dst += r->cnt * sched->bsize;
+			}
+
+			rc = bd_queue_write(sched->bdq, slot, ba, cnt, NULL);
+		} else {
+			rc = bd_queue_read(sched->bdq, slot, ba, cnt, NULL);
+		}
+
+		if (rc != EOK) {
+			bsched_batch_complete(sched, batch, rc);
+			continue;
+		}
+
+		sched->slot_busy[slot] = true;
+		sched->slots_busy++;
+	}
+}
+
+/** Fibril collecting completions from the request queue. */
+static errno_t bsched_queue_fibril(void *arg)
+{
+	bsched_t *sched = (bsched_t *) arg;
+	bd_completion_t comp;
+	errno_t rc;
+
+	fibril_mutex_lock(&sched->lock);
+
+	while (true) {
+		if (sched->slots_busy == 0) {
+			if (sched->quit && list_empty(&sched->queue))
+				break;
+			fibril_condvar_wait(&sched->queue_cv, &sched->lock);
+			continue;
+		}
+
+		fibril_mutex_unlock(&sched->lock);
+		rc = bd_queue_wait(sched->bdq, 0, &comp);
+		fibril_mutex_lock(&sched->lock);
+
+		if (rc != EOK)
+			continue;
+
+		list_t *batch = &sched->slot_batch[comp.slot];
+		bsched_req_t *first = list_get_instance(list_first(batch),
+		    bsched_req_t, sorted_link);
+
+		if (!first->write && comp.rc == EOK) {
+			uint8_t *src = bd_queue_slot_buf(sched->bdq, comp.slot);
+			list_foreach(*batch, sorted_link, bsched_req_t, r) {
+				memcpy(r->buf, src, r->cnt * sched->bsize);
+				src += r->cnt * sched->bsize;
+			}
+		}
+
+		bsched_batch_complete(sched, batch, comp.rc);
+		sched->slot_busy[comp.slot] = false;
+		sched->slots_busy--;
+
+		bsched_queue_dispatch(sched);
+	}
+
+	sched->running--;
+	fibril_condvar_broadcast(&sched->exit_cv);
+	fibril_mutex_unlock(&sched->lock);
+	return EOK;
+}
+
+/** Worker fibril serving the queue. */
+static errno_t bsched_worker_fibril(void *arg)
+{
+	bsched_worker_t *worker = (bsched_worker_t *) arg;
+	bsched_t *sched = worker->sched;
+	bsched_req_t *first;
+	list_t batch;
+	aoff64_t ba;
+	size_t cnt;
+	errno_t rc;
+
+	fibril_mutex_lock(&sched->lock);
+
+	while (true) {
+		first = NULL;
+		if (!list_empty(&sched->queue))
+			first = bsched_pick(sched);
+
+		if (first == NULL) {
+			if (sched->quit && list_empty(&sched->queue))
+				break;
+			fibril_condvar_wait(&sched->queue_cv, &sched->lock);
+			continue;
+		}
+
+		list_initialize(&batch);
+		bsched_batch(sched, first, &batch, &ba, &cnt);
+		sched->head = ba + cnt;
+
+		bool merged = list_count(&batch) > 1;
+		bool write = first->write;
+
+		fibril_mutex_unlock(&sched->lock);
+
+		if (merged && write) {
+			uint8_t *dst = worker->buf;
+			list_foreach(batch, sorted_link, bsched_req_t, r) {
+				memcpy(dst, r->buf, r->cnt * sched->bsize);
+				dst += r->cnt * sched->bsize;
+			}
+		}
+
+		void *buf = merged ? worker->buf : first->buf;
+		if (write) {
+			rc = bd_write_blocks(worker->bd, ba, cnt, buf,
+			    cnt * sched->bsize);
+		} else {
+			rc = bd_read_blocks(worker->bd, ba, cnt, buf,
+			    cnt * sched->bsize);
+		}
+
+		if (merged && !write && rc == EOK) {
+			uint8_t *src = worker->buf;
+			list_foreach(batch, sorted_link, bsched_req_t, r) {
+				memcpy(r->buf, src, r->cnt * sched->bsize);
+				src += r->cnt * sched->bsize;
+			}
+		}
+
+		fibril_mutex_lock(&sched->lock);
+		bsched_batch_complete(sched, &batch, rc);
+	}
+
+	sched->running--;
+	fibril_condvar_broadcast(&sched->exit_cv);
+	fibril_mutex_unlock(&sched->lock);
+	return EOK;
+}
+
+/** Submit a request and wait for its completion. */
+static errno_t bsched_submit(bsched_t *sched, bool write, aoff64_t ba,
+    size_t cnt, void *buf, size_t size)
+{
+	bsched_req_t req;
+
+	if (size < cnt * sched->bsize)
+		return EINVAL;
+
+	link_initialize(&req.link);
+	link_initialize(&req.sorted_link);
+	req.write = write;
+	req.ba = ba;
+	req.cnt = cnt;
+	req.buf = buf;
+	req.done = false;
+	req.rc = EOK;
+	fibril_condvar_initialize(&req.done_cv);
+
+	getuptime(&req.deadline);
+	ts_add_diff(&req.deadline, write ? BSCHED_WRITE_EXPIRE :
+	    BSCHED_READ_EXPIRE);
+
+	fibril_mutex_lock(&sched->lock);
+
+	list_append(&req.link, &sched->queue);
+
+	/* Keep the sorted list ordered by address, FIFO among equal ones */
+	link_t *succ = NULL;
+	list_foreach(sched->sorted, sorted_link, bsched_req_t, r) {
+		if (r->ba > ba) {
+			succ = &r->sorted_link;
+			break;
+		}
+	}
+
+	if (succ != NULL)
+		list_insert_before(&req.sorted_link, succ);
+	else
+		list_append(&req.sorted_link, &sched->sorted);
+
+	fibril_condvar_broadcast(&sched->queue_cv);
+	if (sched->bdq != NULL)
+		bsched_queue_dispatch(sched);
+
+	while (!req.done)
+		fibril_condvar_wait(&req.done_cv, &sched->lock);
+
+	fibril_mutex_unlock(&sched->lock);
+	return req.rc;
+}
+
+/** Read blocks through the scheduler.
+ *
+ * @param sched Scheduler
+ * @param ba Address of the first block
+ * @param cnt Number of blocks
+ * @param buf Buffer for the data
+ * @param size Size of @a buf in bytes
+ * @return EOK on success or an error code
+ */
+errno_t bsched_read(bsched_t *sched, aoff64_t ba, size_t cnt, void *buf,
+    size_t size)
+{
+	return bsched_submit(sched, false, ba, cnt, buf, size);
+}
+
+/** Write blocks through the scheduler.
+ *
+ * @param sched Scheduler
+ * @param ba Address of the first block
+ * @param cnt Number of blocks
+ * @param data Data to write
+ * @param size Size of @a data in bytes
+ * @return EOK on success or an error code
+ */
+errno_t bsched_write(bsched_t *sched, aoff64_t ba, size_t cnt,
+    const void *data, size_t size)
+{
+	return bsched_submit(sched, true, ba, cnt, (void *) data, size);
+}
+
+/** Close the device connection of a worker. */
+static void bsched_worker_fini(bsched_worker_t *worker)
+{
+	if (worker->bd != NULL)
+		bd_close(worker->bd);
+	if (worker->sess != NULL)
+		async_hangup(worker->sess);
+	free(worker->buf);
+}
+
+/** Set up the request queue on a connection of its own.
+ *
+ * @param sched Scheduler
+ * @param service_id Service ID of the block device
+ * @return EOK on success, ENOTSUP if the device does not support request
+ *         queues or an error code
+ */
+static errno_t bsched_queue_init(bsched_t *sched, service_id_t service_id)
+{
+	errno_t rc;
+
+	sched->qsess = loc_service_connect(service_id, INTERFACE_BLOCK,
+	    IPC_FLAG_BLOCKING);
+	if (sched->qsess == NULL)
+		return ENOENT;
+
+	rc = bd_open(sched->qsess, &sched->qbd);
+	if (rc != EOK)
+		goto error;
+
+	rc = bd_queue_create(sched->qbd, sched->depth,
+	    sched->max_blocks * sched->bsize, &sched->bdq);
+	if (rc != EOK)
+		goto error;
+
+	fid_t fid = fibril_create(bsched_queue_fibril, sched);
+	if (fid == 0) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	sched->running++;
+	fibril_add_ready(fid);
+	return EOK;
+error:
+	if (sched->bdq != NULL)
+		bd_queue_destroy(sched->bdq);
+	if (sched->qbd != NULL)
+		bd_close(sched->qbd);
+	async_hangup(sched->qsess);
+	sched->bdq = NULL;
+	sched->qbd = NULL;
+	sched->qsess = NULL;
+	return rc;
+}
+
+/** Create block I/O scheduler.
+ *
+ * @param service_id Service ID of the block device
+ * @param bsize Block size of the device
+ * @param policy Scheduling policy (other than @c BLOCK_SCHED_NONE)
+ * @param depth Maximum number of requests outstanding at the device
+ * @param rsched Place to store pointer to the new scheduler
+ * @return EOK on success or an error code
+ */
+errno_t bsched_create(service_id_t service_id, size_t bsize,
+    block_sched_policy_t policy, unsigned depth, bsched_t **rsched)
+{
+	bsched_t *sched;
+	errno_t rc;
+
+	if (depth < 1 || depth > BSCHED_DEPTH_MAX || bsize == 0 ||
+	    bsize > DATA_XFER_LIMIT)
+		return EINVAL;
+
+	sched = calloc(1, sizeof(bsched_t));
+	if (sched == NULL)
+		return ENOMEM;
+
+	sched->workers = calloc(depth, sizeof(bsched_worker_t));
+	if (sched->workers == NULL) {
+		free(sched);
+		return ENOMEM;
+	}
+
+	fibril_mutex_initialize(&sched->lock);
+	fibril_condvar_initialize(&sched->queue_cv);
+	fibril_condvar_initialize(&sched->exit_cv);
+	list_initialize(&sched->queue);
+	list_initialize(&sched->sorted);
+	list_initialize(&sched->inflight);
+	sched->policy = policy;
+	sched->bsize = bsize;
+	sched->max_blocks = DATA_XFER_LIMIT / bsize;
+	sched->depth = depth;
+
+	/* Prefer a request queue, fall back to a connection per worker */
+	if (bsched_queue_init(sched, service_id) == EOK) {
+		*rsched = sched;
+		return EOK;
+	}
+
+	for (unsigned i = 0; i < depth; i++) {
+		bsched_worker_t *worker = &sched->workers[i];
+
+		worker->sched = sched;
+		worker->buf = malloc(sched->max_blocks * bsize);
+		if (worker->buf == NULL) {
+			rc = ENOMEM;
+			goto error;
+		}
+
+		worker->sess = loc_service_connect(service_id, INTERFACE_BLOCK,
+		    IPC_FLAG_BLOCKING);
+		if (worker->sess == NULL) {
+			rc = ENOENT;
+			goto error;
+		}
+
+		rc = bd_open(worker->sess, &worker->bd);
+		if (rc != EOK) {
+			worker->bd = NULL;
+			goto error;
+		}
+	}
+
+	for (unsigned i = 0; i < depth; i++) {
+		fid_t fid = fibril_create(bsched_worker_fibril,
+		    &sched->workers[i]);
+		if (fid == 0) {
+			rc = ENOMEM;
+			goto error;
+		}
+
+		fibril_mutex_lock(&sched->lock);
+		sched->running++;
+		fibril_mutex_unlock(&sched->lock);
+		fibril_add_ready(fid);
+	}
+
+	*rsched = sched;
+	return EOK;
+error:
+	if (sched->running > 0) {
+		/* Could not create all workers, let the others finish */
+		bsched_destroy(sched);
+		return rc;
+	}
+
+	for (unsigned i = 0; i < depth; i++)
+		bsched_worker_fini(&sched->workers[i]);
+	free(sched->workers);
+	free(sched);
+	return rc;
+}
+
+/** Destroy block I/O scheduler.
+ *
+ * Queued requests are served before the workers exit.
+ *
+ * @param sched Scheduler
+ */
+void bsched_destroy(bsched_t *sched)
+{
+	fibril_mutex_lock(&sched->lock);
+	sched->quit = true;
+	fibril_condvar_broadcast(&sched->queue_cv);
+	while (sched->running > 0)
+		fibril_condvar_wait(&sched->exit_cv, &sched->lock);
+	fibril_mutex_unlock(&sched->lock);
+
+	if (sched->bdq != NULL) {
+		bd_queue_destroy(sched->bdq);
+		bd_close(sched->qbd);
+		async_hangup(sched->qsess);
+	}
+
+	for (unsigned i = 0; i < sched->depth; i++)
+		bsched_worker_fini(&sched->workers[i]);
+
+	free(sched->workers);
+	free(sched);
+}
+
+/** @}
+ */
@@ -0,0 +1,502 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcamd64
+ * @{
+ */
+/** @file
+ * @brief SSE2 versions of memory and string primitives.
+ *
+ * SSE2 is part of the base amd64 instruction set, so these are used
+ * unconditionally. Large block copies and fills use the REP MOVSB and
+ * REP STOSB instructions instead if the processor advertises Enhanced
+ * REP MOVSB/STOSB (ERMS).
+ *
+ * The scanning functions read whole aligned 16-byte blocks, possibly past
+ * the end of the buffer or string. An aligned block never crosses a page
+ * boundary, so such reads cannot fault.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <libarch/mem.h>
+#include "../../../generic/private/mem.h"
+
+/** CPUID leaf with structured extended feature flags */
+#define CPUID_STRUCTURED_FEATURES  7
+
+/** Enhanced REP MOVSB/STOSB (leaf 7, EBX) */
+#define CPUID_EBX_ERMS  (1 << 9)
+
+/** Minimum size for which REP MOVSB/STOSB is preferred over SSE2 */
+#define ERMS_THRESHOLD  2048
+
+typedef char v16_t __attribute__((vector_size(16), may_alias));
+typedef char v16u_t __attribute__((vector_size(16), may_alias, aligned(1)));
+typedef uint64_t u64u_t __attribute__((may_alias, aligned(1)));
+typedef uint32_t u32u_t __attribute__((may_alias, aligned(1)));
+typedef uint16_t u16u_t __attribute__((may_alias, aligned(1)));
+
+static bool have_erms = false;
+
+static inline v16_t load(const void *p)
+{
+	return *(const v16u_t *) p;
+}
+
+static inline v16_t load_aligned(const void *p)
+{
+	return *(const v16_t *) p;
+}
+
+static inline void store(void *p, v16_t v)
+{
+	*(v16u_t *) p = v;
+}
+
+static inline void store_aligned(void *p, v16_t v)
+{
+	*(v16_t *) p = v;
+}
+
+static inline v16_t splat(int c)
+{
+	v16_t zero = { 0 };
+	return zero + (char) c;
+}
+
+/** Get bit mask of the most significant bits of all bytes. */
+static inline unsigned int movemask(v16_t v)
+{
+	return (unsigned int) __builtin_ia32_pmovmskb128(v);
+}
+
+static inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+    uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+	    : "a" (leaf), "c" (subleaf)
+	);
+}
+
+/** Copy less than 16 bytes.
+ *
+ * All source bytes are loaded before anything is stored, therefore the
+ * areas may overlap.
+ */
+static inline void copy_small(uint8_t *d, const uint8_t *s, size_t n)
+{
+	if (n >= 8) {
+		uint64_t a = *(const u64u_t *) s;
+		uint64_t b = *(const u64u_t *) (s + n - 8);
+		*(u64u_t *) d = a;
+		*(u64u_t *) (d + n - 8) = b;
+	} else if (n >= 4) {
+		uint32_t a = *(const u32u_t *) s;
+		uint32_t b = *(const u32u_t *) (s + n - 4);
+		*(u32u_t *) d = a;
+		*(u32u_t *) (d + n - 4) = b;
+	} else if (n >= 2) {
+		uint16_t a = *(const u16u_t *) s;
+		uint16_t b = *(const u16u_t *) (s + n - 2);
+		*(u16u_t *) d = a;
+		*(u16u_t *) (d + n - 2) = b;
+	} else if (n == 1) {
+		*d = *s;
+	}
+}
+
+/** Copy at most 64 bytes.
+ *
+ * All source bytes are loaded before anything is stored, therefore the
+ * areas may overlap.
+ */
+static inline void copy_upto_64(uint8_t *d, const uint8_t *s, size_t n)
+{
+	if (n < 16) {
+		copy_small(d, s, n);
+		return;
+	}
+
+	v16_t a = load(s);
+	v16_t b = load(s + n - 16);
+
+	if (n > 32) {
+		v16_t c = load(s + 16);
+		v16_t e = load(s + n - 32);
+		store(d + 16, c);
+		store(d + n - 32, e);
+	}
+
+	store(d, a);
+	store(d + n - 16, b);
+}
+
+static void *sse2_memcpy(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+
+	if (n <= 64) {
+		copy_upto_64(d, s, n);
+		return dst;
+	}
+
+	if (have_erms && n >= ERMS_THRESHOLD) {
+		asm volatile (
+		    "rep movsb\n"
+		    : "+D" (d), "+S" (s), "+c" (n)
+		    :: "memory"
+		);
+		return dst;
+	}
+
+	/*
+	 * The unaligned head and tail are stored separately at the end,
+	 * the rest is stored with aligned stores.
+	 */
+	v16_t head = load(s);
+	v16_t tail = load(s + n - 16);
+
+	size_t skew = 16 - ((uintptr_t) d & 15);
+	uint8_t *dp = d + skew;
+	const uint8_t *sp = s + skew;
+	size_t left = n - skew;
+
+	while (left > 64) {
+		v16_t a = load(sp);
+		v16_t b = load(sp + 16);
+		v16_t c = load(sp + 32);
+		v16_t e = load(sp + 48);
+		store_aligned(dp, a);
+		store_aligned(dp + 16, b);
+		store_aligned(dp + 32, c);
+		store_aligned(dp + 48, e);
+		sp += 64;
+		dp += 64;
+		left -= 64;
+	}
+
+	while (left > 16) {
+		store_aligned(dp, load(sp));
+		sp += 16;
+		dp += 16;
+		left -= 16;
+	}
+
+	store(d, head);
+	store(d + n - 16, tail);
+	return dst;
+}
+
+static void *sse2_memmove(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+
+	if (d == s)
+		return dst;
+
+	/* Non-overlapping areas or a short block? */
+	if (d >= s + n || s >= d + n)
+		return sse2_memcpy(dst, src, n);
+
+	if (n <= 64) {
+		copy_upto_64(d, s, n);
+		return dst;
+	}
+
+	/*
+	 * Both ends are loaded before the loop can overwrite them and they
+	 * are stored after it. In each loop iteration the source is loaded
+	 * before the destination is stored and the loop proceeds in the
+	 * direction that never overwrites source bytes not yet loaded.
+	 */
+	v16_t head = load(s);
+	v16_t tail = load(s + n - 16);
+
+	if (d < s) {
+		/* Forwards. */
+		size_t skew = 16 - ((uintptr_t) d & 15);
+		uint8_t *dp = d + skew;
+		const uint8_t *sp = s + skew;
+		size_t left = n - skew;
+
+		while (left > 64) {
+			v16_t a = load(sp);
+			v16_t b = load(sp + 16);
+			v16_t c = load(sp + 32);
+			v16_t e = load(sp + 48);
+			store_aligned(dp, a);
+			store_aligned(dp + 16, b);
+			store_aligned(dp + 32, c);
+			store_aligned(dp + 48, e);
+			sp += 64;
+			dp += 64;
+			left -= 64;
+		}
+
+		while (left > 16) {
+			store_aligned(dp, load(sp));
+			sp += 16;
+			dp += 16;
+			left -= 16;
+		}
+	} else {
+		/* Backwards. */
+		size_t skew = ((uintptr_t) (d + n) & 15);
+		if (skew == 0)
+			skew = 16;
+
+		uint8_t *dp = d + n - skew;
+		const uint8_t *sp = s + n - skew;
+		size_t left = n - skew;
+
+		while (left > 64) {
+			v16_t a = load(sp - 16);
+			v16_t b = load(sp - 32);
+			v16_t c = load(sp - 48);
+			v16_t e = load(sp - 64);
+			store_aligned(dp - 16, a);
+			store_aligned(dp - 32, b);
+			store_aligned(dp - 48, c);
+			store_aligned(dp - 64, e);
+			sp -= 64;
+			dp -= 64;
+			left -= 64;
+		}
+
+		while (left > 16) {
+			store_aligned(dp - 16, load(sp - 16));
+			sp -= 16;
+			dp -= 16;
+			left -= 16;
+		}
+	}
+
+	store(d, head);
+	store(d + n - 16, tail);
+	return dst;
+}
+
+static void *sse2_memset(void *dst, int c, size_t n)
+{
+	uint8_t *d = dst;
+
+	if (n < 16) {
+		uint64_t pattern = (uint8_t) c * UINT64_C(0x0101010101010101);
+
+		if (n >= 8) {
+			*(u64u_t *) d = pattern;
+			*(u64u_t *) (d + n - 8) = pattern;
+		} else if (n >= 4) {
+			*(u32u_t *) d = (uint32_t) pattern;
+			*(u32u_t *) (d + n - 4) = (uint32_t) pattern;
+		} else if (n >= 2) {
+			*(u16u_t *) d = (uint16_t) pattern;
+			*(u16u_t *) (d + n - 2) = (uint16_t) pattern;
+		} else if (n == 1) {
+			*d = (uint8_t) c;
+		}
+
+		return dst;
+	}
+
+	v16_t v = splat(c);
+
+	if (n <= 32) {
+		store(d, v);
+		store(d + n - 16, v);
+		return dst;
+	}
+
+	if (have_erms && n >= ERMS_THRESHOLD) {
+		asm volatile (
+		    "rep stosb\n"
+		    : "+D" (d), "+c" (n)
+		    : "a" (c)
+		    : "memory"
+		);
+		return dst;
+	}
+
+	uint8_t *end = d + n;
+	uint8_t *p = (uint8_t *) (((uintptr_t) d + 16) & ~(uintptr_t) 15);
+
+	store(d, v);
+
+	while (end - p > 64) {
+		store_aligned(p, v);
+		store_aligned(p + 16, v);
+		store_aligned(p + 32, v);
+		store_aligned(p + 48, v);
+		p += 64;
+	}
+
+	while (end - p > 16) {
+		store_aligned(p, v);
+		p += 16;
+	}
+
+	store(end - 16, v);
+	return dst;
+}
+
+static int sse2_memcmp(const void *s1, const void *s2, size_t n)
+{
+	const uint8_t *u1 = s1;
+	const uint8_t *u2 = s2;
+	size_t i = 0;
+	unsigned int m;
+
+	if (n < 16) {
+		for (i = 0; i < n; i++) {
+			if (u1[i] != u2[i])
+				return (int) u1[i] - (int) u2[i];
+		}
+
+		return 0;
+	}
+
+	while (i + 16 <= n) {
+		m = movemask(load(u1 + i) == load(u2 + i));
+		if (m != 0xffff)
+			goto differ;
+
+		i += 16;
+	}
+
+	if (i == n)
+		return 0;
+
+	/* Compare the tail using an overlapping block. */
+	i = n - 16;
+	m = movemask(load(u1 + i) == load(u2 + i));
+	if (m == 0xffff)
+		return 0;
+
+differ:
+	i += __builtin_ctz(~m);
+	return (int) u1[i] - (int) u2[i];
+}
+
+static void *sse2_memchr(const void *s, int c, size_t n)
+{
+	if (n == 0)
+		return NULL;
+
+	const uint8_t *p = s;
+	size_t off = (uintptr_t) p & 15;
+	v16_t v = splat(c);
+
+	/* Ignore matches before the start of the area. */
+	unsigned int m = movemask(load_aligned(p - off) == v) >> off;
+	size_t i = 16 - off;
+
+	if (m != 0) {
+		i = __builtin_ctz(m);
+		return (i < n) ? (void *) (p + i) : NULL;
+	}
+
+	while (i < n) {
+		m = movemask(load_aligned(p + i) == v);
+		if (m != 0) {
+			i += __builtin_ctz(m);
+			return (i < n) ? (void *) (p + i) : NULL;
+		}
+
+		i += 16;
+	}
+
+	return NULL;
+}
+
+static size_t sse2_str_size(const char *str)
+{
+	size_t off = (uintptr_t) str & 15;
+	const char *blk = str - off;
+	v16_t zero = { 0 };
+
+	unsigned int m = movemask(load_aligned(blk) == zero) >> off;
+	if (m != 0)
+		return __builtin_ctz(m);
+
+	while (true) {
+		blk += 16;
+		m = movemask(load_aligned(blk) == zero);
+		if (m != 0)
+			return (size_t) (blk - str) + __builtin_ctz(m);
+	}
+}
+
+static size_t sse2_ascii_span(const char *str)
+{
+	size_t off = (uintptr_t) str & 15;
+	const char *blk = str - off;
+	v16_t zero = { 0 };
+
+	/*
+	 * Bytes are signed, so both the NULL-terminator and bytes
+	 * 0x80 .. 0xff compare less than or equal to zero.
+	 */
+	unsigned int m = movemask(load_aligned(blk) <= zero) >> off;
+	if (m != 0)
+		return __builtin_ctz(m);
+
+	while (true) {
+		blk += 16;
+		m = movemask(load_aligned(blk) <= zero);
+		if (m != 0)
+			return (size_t) (blk - str) + __builtin_ctz(m);
+	}
+}
+
+void arch_mem_init(void)
+{
+	uint32_t eax, ebx, ecx, edx;
+
+	cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+	if (eax >= CPUID_STRUCTURED_FEATURES) {
+		cpuid(CPUID_STRUCTURED_FEATURES, 0, &eax, &ebx, &ecx, &edx);
+		have_erms = (ebx & CPUID_EBX_ERMS) != 0;
+	}
+
+	__mem_ops.set = sse2_memset;
+	__mem_ops.copy = sse2_memcpy;
+	__mem_ops.move = sse2_memmove;
+	__mem_ops.cmp = sse2_memcmp;
+	__mem_ops.chr = sse2_memchr;
+	__mem_ops.str_size = sse2_str_size;
+	__mem_ops.ascii_span = sse2_ascii_span;
+}
+
+/** @}
+ */
@@ -0,0 +1,451 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcarm64
+ * @{
+ */
+/** @file
+ * @brief Advanced SIMD (NEON) versions of memory and string primitives.
+ *
+ * Advanced SIMD is mandatory in AArch64, so these are used unconditionally.
+ * The code is written using the compiler's generic vector extensions which
+ * are translated to NEON instructions.
+ *
+ * The scanning functions read whole aligned 16-byte blocks, possibly past
+ * the end of the buffer or string. An aligned block never crosses a page
+ * boundary, so such reads cannot fault.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <libarch/mem.h>
+#include "../../../generic/private/mem.h"
+
+typedef uint8_t v16_t __attribute__((vector_size(16), may_alias));
+typedef uint8_t v16u_t __attribute__((vector_size(16), may_alias, aligned(1)));
+typedef uint64_t v2_t __attribute__((vector_size(16), may_alias));
+typedef uint64_t u64u_t __attribute__((may_alias, aligned(1)));
+typedef uint32_t u32u_t __attribute__((may_alias, aligned(1)));
+typedef uint16_t u16u_t __attribute__((may_alias, aligned(1)));
+
+/** Byte indices within a vector */
+static const v16_t byte_index = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+static inline v16_t load(const void *p)
+{
+	return *(const v16u_t *) p;
+}
+
+static inline v16_t load_aligned(const void *p)
+{
+	return *(const v16_t *) p;
+}
+
+static inline void store(void *p, v16_t v)
+{
+	*(v16u_t *) p = v;
+}
+
+static inline void store_aligned(void *p, v16_t v)
+{
+	*(v16_t *) p = v;
+}
+
+static inline v16_t splat(int c)
+{
+	v16_t zero = { 0 };
+	return zero + (uint8_t) c;
+}
+
+/** Get index of the first non-zero byte of a vector.
+ *
+ * @return Byte index or 16 if all bytes are zero.
+ */
+static inline unsigned int first_set(v16_t v)
+{
+	v2_t w = (v2_t) v;
+
+	if (w[0] != 0)
+		return __builtin_ctzll(w[0]) / 8;
+	if (w[1] != 0)
+		return 8 + __builtin_ctzll(w[1]) / 8;
+
+	return 16;
+}
+
+/** Clear the first @a off bytes of a vector. */
+static inline v16_t skip_bytes(v16_t v, size_t off)
+{
+	return v & (v16_t) (byte_index >= (uint8_t) off);
+}
+
+/** Copy less than 16 bytes.
+ *
+ * All source bytes are loaded before anything is stored, therefore the
+ * areas may overlap.
+ */
+static inline void copy_small(uint8_t *d, const uint8_t *s, size_t n)
+{
+	if (n >= 8) {
+		uint64_t a = *(const u64u_t *) s;
+		uint64_t b = *(const u64u_t *) (s + n - 8);
+		*(u64u_t *) d = a;
+		*(u64u_t *) (d + n - 8) = b;
+	} else if (n >= 4) {
+		uint32_t a = *(const u32u_t *) s;
+		uint32_t b = *(const u32u_t *) (s + n - 4);
+		*(u32u_t *) d = a;
+		*(u32u_t *) (d + n - 4) = b;
+	} else if (n >= 2) {
+		uint16_t a = *(const u16u_t *) s;
+		uint16_t b = *(const u16u_t *) (s + n - 2);
+		*(u16u_t *) d = a;
+		*(u16u_t *) (d + n - 2) = b;
+	} else if (n == 1) {
+		*d = *s;
+	}
+}
+
+/** Copy at most 64 bytes.
+ *
+ * All source bytes are loaded before anything is stored, therefore the
+ * areas may overlap.
+ */
+static inline void copy_upto_64(uint8_t *d, const uint8_t *s, size_t n)
+{
+	if (n < 16) {
+		copy_small(d, s, n);
+		return;
+	}
+
+	v16_t a = load(s);
+	v16_t b = load(s + n - 16);
+
+	if (n > 32) {
+		v16_t c = load(s + 16);
+		v16_t e = load(s + n - 32);
+		store(d + 16, c);
+		store(d + n - 32, e);
+	}
+
+	store(d, a);
+	store(d + n - 16, b);
+}
+
+static void *neon_memcpy(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+
+	if (n <= 64) {
+		copy_upto_64(d, s, n);
+		return dst;
+	}
+
+	/*
+	 * The unaligned head and tail are stored separately at the end,
+	 * the rest is stored with aligned stores.
+	 */
+	v16_t head = load(s);
+	v16_t tail = load(s + n - 16);
+
+	size_t skew = 16 - ((uintptr_t) d & 15);
+	uint8_t *dp = d + skew;
+	const uint8_t *sp = s + skew;
+	size_t left = n - skew;
+
+	while (left > 64) {
+		v16_t a = load(sp);
+		v16_t b = load(sp + 16);
+		v16_t c = load(sp + 32);
+		v16_t e = load(sp + 48);
+		store_aligned(dp, a);
+		store_aligned(dp + 16, b);
+		store_aligned(dp + 32, c);
+		store_aligned(dp + 48, e);
+		sp += 64;
+		dp += 64;
+		left -= 64;
+	}
+
+	while (left > 16) {
+		store_aligned(dp, load(sp));
+		sp += 16;
+		dp += 16;
+		left -= 16;
+	}
+
+	store(d, head);
+	store(d + n - 16, tail);
+	return dst;
+}
+
+static void *neon_memmove(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+
+	if (d == s)
+		return dst;
+
+	/* Non-overlapping areas? */
+	if (d >= s + n || s >= d + n)
+		return neon_memcpy(dst, src, n);
+
+	if (n <= 64) {
+		copy_upto_64(d, s, n);
+		return dst;
+	}
+
+	/*
+	 * Both ends are loaded before the loop can overwrite them and they
+	 * are stored after it. In each loop iteration the source is loaded
+	 * before the destination is stored and the loop proceeds in the
+	 * direction that never overwrites source bytes not yet loaded.
+	 */
+	v16_t head = load(s);
+	v16_t tail = load(s + n - 16);
+
+	if (d < s) {
+		/* Forwards. */
+		size_t skew = 16 - ((uintptr_t) d & 15);
+		uint8_t *dp = d + skew;
+		const uint8_t *sp = s + skew;
+		size_t left = n - skew;
+
+		while (left > 16) {
+			store_aligned(dp, load(sp));
+			sp += 16;
+			dp += 16;
+			left -= 16;
+		}
+	} else {
+		/* Backwards. */
+		size_t skew = ((uintptr_t) (d + n) & 15);
+		if (skew == 0)
+			skew = 16;
+
+		uint8_t *dp = d + n - skew;
+		const uint8_t *sp = s + n - skew;
+		size_t left = n - skew;
+
+		while (left > 16) {
+			store_aligned(dp - 16, load(sp - 16));
+			sp -= 16;
+			dp -= 16;
+			left -= 16;
+		}
+	}
+
+	store(d, head);
+	store(d + n - 16, tail);
+	return dst;
+}
+
+static void *neon_memset(void *dst, int c, size_t n)
+{
+	uint8_t *d = dst;
+
+	if (n < 16) {
+		uint64_t pattern = (uint8_t) c * UINT64_C(0x0101010101010101);
+
+		if (n >= 8) {
+			*(u64u_t *) d = pattern;
+			*(u64u_t *) (d + n - 8) = pattern;
+		} else if (n >= 4) {
+			*(u32u_t *) d = (uint32_t) pattern;
+			*(u32u_t *) (d + n - 4) = (uint32_t) pattern;
+		} else if (n >= 2) {
+			*(u16u_t *) d = (uint16_t) pattern;
+			*(u16u_t *) (d + n - 2) = (uint16_t) pattern;
+		} else if (n == 1) {
+			*d = (uint8_t) c;
+		}
+
+		return dst;
+	}
+
+	v16_t v = splat(c);
+
+	if (n <= 32) {
+		store(d, v);
+		store(d + n - 16, v);
+		return dst;
+	}
+
+	uint8_t *end = d + n;
+	uint8_t *p = (uint8_t *) (((uintptr_t) d + 16) & ~(uintptr_t) 15);
+
+	store(d, v);
+
+	while (end - p > 64) {
+		store_aligned(p, v);
+		store_aligned(p + 16, v);
+		store_aligned(p + 32, v);
+		store_aligned(p + 48, v);
+		p += 64;
+	}
+
+	while (end - p > 16) {
+		store_aligned(p, v);
+		p += 16;
+	}
+
+	store(end - 16, v);
+	return dst;
+}
+
+static int neon_memcmp(const void *s1, const void *s2, size_t n)
+{
+	const uint8_t *u1 = s1;
+	const uint8_t *u2 = s2;
+	size_t i = 0;
+	unsigned int first;
+
+	if (n < 16) {
+		for (i = 0; i < n; i++) {
+			if (u1[i] != u2[i])
+				return (int) u1[i] - (int) u2[i];
+		}
+
+		return 0;
+	}
+
+	while (i + 16 <= n) {
+		first = first_set((v16_t) (load(u1 + i) != load(u2 + i)));
+		if (first < 16)
+			goto differ;
+
+		i += 16;
+	}
+
+	if (i == n)
+		return 0;
+
+	/* Compare the tail using an overlapping block. */
+	i = n - 16;
+	first = first_set((v16_t) (load(u1 + i) != load(u2 + i)));
+	if (first == 16)
+		return 0;
+
+differ:
+	i += first;
+	return (int) u1[i] - (int) u2[i];
+}
+
+static void *neon_memchr(const void *s, int c, size_t n)
+{
+	if (n == 0)
+		return NULL;
+
+	const uint8_t *p = s;
+	size_t off = (uintptr_t) p & 15;
+	v16_t v = splat(c);
+
+	/* Ignore matches before the start of the area. */
+	v16_t m = skip_bytes((v16_t) (load_aligned(p - off) == v), off);
+	size_t first = first_set(m);
+	size_t i = 16 - off;
+
+	if (first < 16) {
+		i = first - off;
+		return (i < n) ? (void *) (p + i) : NULL;
+	}
+
+	while (i < n) {
+		first = first_set((v16_t) (load_aligned(p + i) == v));
+		if (first < 16) {
+			i += first;
+			return (i < n) ? (void *) (p + i) : NULL;
+		}
+
+		i += 16;
+	}
+
+	return NULL;
+}
+
+static size_t neon_str_size(const char *str)
+{
+	size_t off = (uintptr_t) str & 15;
+	const char *blk = str - off;
+	v16_t zero = { 0 };
+
+	v16_t m = skip_bytes((v16_t) (load_aligned(blk) == zero), off);
+	size_t first = first_set(m);
+	if (first < 16)
+		return first - off;
+
+	while (true) {
+		blk += 16;
+		first = first_set((v16_t) (load_aligned(blk) == zero));
+		if (first < 16)
+			return (size_t) (blk - str) + first;
+	}
+}
+
+static size_t neon_ascii_span(const char *str)
+{
+	size_t off = (uintptr_t) str & 15;
+	const char *blk = str - off;
+	v16_t one = { 0 };
+	one += 1;
+
+	/*
+	 * With unsigned bytes, subtracting one maps both the NULL-terminator
+	 * and bytes 0x80 .. 0xff to values 0x7f and above.
+	 */
+	v16_t m = skip_bytes((v16_t) (load_aligned(blk) - one >= 0x7f), off);
+	size_t first = first_set(m);
+	if (first < 16)
+		return first - off;
+
+	while (true) {
+		blk += 16;
+		first = first_set((v16_t) (load_aligned(blk) - one >= 0x7f));
+		if (first < 16)
+			return (size_t) (blk - str) + first;
+	}
+}
+
+void arch_mem_init(void)
+{
+	__mem_ops.set = neon_memset;
+	__mem_ops.copy = neon_memcpy;
+	__mem_ops.move = neon_memmove;
+	__mem_ops.cmp = neon_memcmp;
+	__mem_ops.chr = neon_memchr;
+	__mem_ops.str_size = neon_str_size;
+	__mem_ops.ascii_span = neon_ascii_span;
+}
+
+/** @}
+ */
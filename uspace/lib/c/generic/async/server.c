@@ -771,6 +771,19 @@ errno_t async_irq_unsubscribe(cap_irq_handle_t ihandle)
 	return ipc_irq_unsubscribe(ihandle);
 }
 
+/** Set coalescing of IRQ notifications.
+ *
+ * @param handle  IRQ capability handle.
+ * @param limit   Maximum number of interrupts per notification.
+ *
+ * @return Zero on success or an error code.
+ *
+ */
+errno_t async_irq_coalesce(cap_irq_handle_t ihandle, size_t limit)
+{
+	return ipc_irq_coalesce(ihandle, limit);
+}
+
 /** Subscribe to event notifications.
  *
  * @param evno    Event type to subscribe.
@@ -107,6 +107,61 @@ errno_t hw_res_clear_interrupt(async_sess_t *sess, int irq)
 	return rc;
 }
 
+/** Switch the device to message signaled interrupts.
+ *
+ * The interrupts are delivered as a block of consecutive IRQs, each of
+ * which can be subscribed to separately. While they are enabled, the
+ * device does not raise its legacy interrupt.
+ *
+ * @param sess   Session to the device's parent.
+ * @param count  Number of interrupts the driver can use.
+ * @param irq    Place to store the first IRQ of the block.
+ * @param rcount Place to store the number of IRQs allocated, which can
+ *               be lower than @a count.
+ *
+ * @return Error code. ENOTSUP if message signaled interrupts are not
+ *         available for the device.
+ *
+ */
+errno_t hw_res_enable_msi(async_sess_t *sess, size_t count, int *irq,
+    size_t *rcount)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	sysarg_t first;
+	sysarg_t n;
+	const errno_t ret = async_req_2_2(exch, DEV_IFACE_ID(HW_RES_DEV_IFACE),
+	    HW_RES_ENABLE_MSI, count, &first, &n);
+
+	async_exchange_end(exch);
+
+	if (ret == EOK) {
+		*irq = first;
+		*rcount = n;
+	}
+
+	return ret;
+}
+
+/** Switch the device back to legacy interrupts.
+ *
+ * @param sess Session to the device's parent.
+ *
+ * @return Error code.
+ *
+ */
+errno_t hw_res_disable_msi(async_sess_t *sess)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	const errno_t ret = async_req_1_0(exch, DEV_IFACE_ID(HW_RES_DEV_IFACE),
+	    HW_RES_DISABLE_MSI);
+
+	async_exchange_end(exch);
+
+	return ret;
+}
+
 /** Setup DMA channel to specified place and mode.
  *
  * @param channel DMA channel.
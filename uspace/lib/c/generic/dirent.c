@@ -39,11 +39,22 @@
 #include <errno.h>
 #include <assert.h>
 #include <string.h>
+#include <str.h>
+
+/** Size of the buffer for batches of directory entries */
+#define DIR_BUF_SIZE 4096
 
 struct __dirstream {
 	int fd;
 	struct dirent res;
+	/** Position of the first entry not in the buffer */
 	aoff64_t pos;
+	/** Entries read in a batch or @c NULL if batches are not supported */
+	uint8_t *buf;
+	/** Offset of the next entry in the buffer */
+	size_t buf_pos;
+	/** Number of bytes of entries in the buffer */
+	size_t buf_len;
 };
 
 /** Open directory.
@@ -78,6 +89,9 @@ DIR *opendir(const char *dirname)
 
 	dirp->fd = fd;
 	dirp->pos = 0;
+	dirp->buf = malloc(DIR_BUF_SIZE);
+	dirp->buf_pos = 0;
+	dirp->buf_len = 0;
 	return dirp;
 }
 
@@ -92,6 +106,31 @@ struct dirent *readdir(DIR *dirp)
 	errno_t rc;
 	ssize_t len = 0;
 
+	if (dirp->buf != NULL && dirp->buf_pos >= dirp->buf_len) {
+		dirp->buf_pos = 0;
+		dirp->buf_len = 0;
+		rc = vfs_readdir(dirp->fd, &dirp->pos, dirp->buf, DIR_BUF_SIZE,
+		    &dirp->buf_len);
+		if (rc == ENOTSUP) {
+			/* Fall back to reading one entry at a time. */
+			free(dirp->buf);
+			dirp->buf = NULL;
+		} else if (rc != EOK) {
+			errno = rc;
+			return NULL;
+		} else if (dirp->buf_len == 0) {
+			errno = ENOENT;
+			return NULL;
+		}
+	}
+
+	if (dirp->buf != NULL) {
+		vfs_dirent_t *ent = (vfs_dirent_t *) (dirp->buf + dirp->buf_pos);
+		str_cpy(dirp->res.d_name, sizeof(dirp->res.d_name), ent->name);
+		dirp->buf_pos += ent->reclen;
+		return &dirp->res;
+	}
+
 	rc = vfs_read_short(dirp->fd, dirp->pos, dirp->res.d_name,
 	    sizeof(dirp->res.d_name), &len);
 	if (rc != EOK) {
@@ -113,6 +152,8 @@ struct dirent *readdir(DIR *dirp)
 void rewinddir(DIR *dirp)
 {
 	dirp->pos = 0;
+	dirp->buf_pos = 0;
+	dirp->buf_len = 0;
 }
 
 /** Close directory.
@@ -123,6 +164,7 @@ void rewinddir(DIR *dirp)
 int closedir(DIR *dirp)
 {
 	errno_t rc = vfs_put(dirp->fd);
+	free(dirp->buf);
 	free(dirp);
 
 	if (rc == EOK) {
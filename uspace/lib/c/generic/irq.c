@@ -85,5 +85,24 @@ errno_t ipc_irq_unsubscribe(cap_irq_handle_t cap)
 	    cap_handle_raw(cap));
 }
 
+/** Set coalescing of IRQ notifications.
+ *
+ * Interrupts arriving while the previous notification has not been
+ * received yet are merged into it, up to @a limit interrupts per
+ * notification. The payload of merged interrupts is or-ed together.
+ *
+ * @param cap   IRQ capability handle.
+ * @param limit Maximum number of interrupts per notification, values
+ *              below two disable coalescing.
+ *
+ * @return Value returned by the kernel.
+ *
+ */
+errno_t ipc_irq_coalesce(cap_irq_handle_t cap, size_t limit)
+{
+	return (errno_t) __SYSCALL2(SYS_IPC_IRQ_COALESCE,
+	    cap_handle_raw(cap), limit);
+}
+
 /** @}
  */
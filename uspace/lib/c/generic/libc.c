@@ -48,6 +48,7 @@
 #include "private/libc.h"
 #include "private/async.h"
 #include "private/malloc.h"
+#include "private/mem.h"
 #include "private/io.h"
 #include "private/fibril.h"
 
@@ -62,6 +63,7 @@ static fibril_t main_fibril;
 
 void __libc_main(void *pcb_ptr)
 {
+	__mem_init();
 	__kio_init();
 
 	assert(!__tcb_is_set());
@@ -37,11 +37,13 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <libarch/mem.h>
 #include "private/cc.h"
+#include "private/mem.h"
 
-/** Fill memory block with a constant value. */
+/** Fill memory block with a constant value (generic version). */
 ATTRIBUTE_OPTIMIZE_NO_TLDP
-    void *memset(void *dest, int b, size_t n)
+    static void *generic_memset(void *dest, int b, size_t n)
 {
 	char *pb;
 	unsigned long *pw;
@@ -114,9 +116,9 @@ static void *unaligned_memcpy(void *dst, const void *src, size_t n)
 	return (char *) dst;
 }
 
-/** Copy memory block. */
+/** Copy memory block (generic version). */
 ATTRIBUTE_OPTIMIZE_NO_TLDP
-    void *memcpy(void *dst, const void *src, size_t n)
+    static void *generic_memcpy(void *dst, const void *src, size_t n)
 {
 	size_t i;
 	size_t mod, fill;
@@ -192,8 +194,8 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 	return dst;
 }
 
-/** Move memory block with possible overlapping. */
-void *memmove(void *dst, const void *src, size_t n)
+/** Move memory block with possible overlapping (generic version). */
+static void *generic_memmove(void *dst, const void *src, size_t n)
 {
 	const uint8_t *sp;
 	uint8_t *dp;
@@ -204,7 +206,7 @@ void *memmove(void *dst, const void *src, size_t n)
 
 	/* Non-overlapping? */
 	if (dst >= src + n || src >= dst + n) {
-		return memcpy(dst, src, n);
+		return generic_memcpy(dst, src, n);
 	}
 
 	/* Which direction? */
@@ -227,18 +229,8 @@ void *memmove(void *dst, const void *src, size_t n)
 	return dst;
 }
 
-/** Compare two memory areas.
- *
- * @param s1  Pointer to the first area to compare.
- * @param s2  Pointer to the second area to compare.
- * @param len Size of the areas in bytes.
- *
- * @return Zero if areas have the same contents. If they differ,
- *	   the sign of the result is the same as the sign of the
- *	   difference of the first pair of different bytes.
- *
- */
-int memcmp(const void *s1, const void *s2, size_t len)
+/** Compare two memory areas (generic version). */
+static int generic_memcmp(const void *s1, const void *s2, size_t len)
 {
 	uint8_t *u1 = (uint8_t *) s1;
 	uint8_t *u2 = (uint8_t *) s2;
@@ -254,16 +246,8 @@ int memcmp(const void *s1, const void *s2, size_t len)
 	return 0;
 }
 
-/** Search memory area.
- *
- * @param s Memory area
- * @param c Character (byte) to search for
- * @param n Size of memory area in bytes
- *
- * @return Pointer to the first occurrence of @a c in the first @a n
- *         bytes of @a s or @c NULL if not found.
- */
-void *memchr(const void *s, int c, size_t n)
+/** Search memory area (generic version). */
+static void *generic_memchr(const void *s, int c, size_t n)
 {
 	uint8_t *u = (uint8_t *) s;
 	unsigned char uc = (unsigned char) c;
@@ -277,5 +261,96 @@ void *memchr(const void *s, int c, size_t n)
 	return NULL;
 }
 
+/** Get size of string (generic version). */
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    static size_t generic_str_size(const char *str)
+{
+	size_t size = 0;
+
+	while (*str++ != 0)
+		size++;
+
+	return size;
+}
+
+/** Get number of leading ASCII characters in string (generic version). */
+static size_t generic_ascii_span(const char *str)
+{
+	const uint8_t *u = (const uint8_t *) str;
+	size_t size = 0;
+
+	while (u[size] != 0 && u[size] < 0x80)
+		size++;
+
+	return size;
+}
+
+mem_ops_t __mem_ops = {
+	.set = generic_memset,
+	.copy = generic_memcpy,
+	.move = generic_memmove,
+	.cmp = generic_memcmp,
+	.chr = generic_memchr,
+	.str_size = generic_str_size,
+	.ascii_span = generic_ascii_span
+};
+
+/** Select the best implementations of memory primitives.
+ *
+ * Called once during libc initialization.
+ */
+void __mem_init(void)
+{
+	arch_mem_init();
+}
+
+/** Fill memory block with a constant value. */
+void *memset(void *dest, int b, size_t n)
+{
+	return __mem_ops.set(dest, b, n);
+}
+
+/** Copy memory block. */
+void *memcpy(void *dst, const void *src, size_t n)
+{
+	return __mem_ops.copy(dst, src, n);
+}
+
+/** Move memory block with possible overlapping. */
+void *memmove(void *dst, const void *src, size_t n)
+{
+	return __mem_ops.move(dst, src, n);
+}
+
+/** Compare two memory areas.
+ *
+ * @param s1  Pointer to the first area to compare.
+ * @param s2  Pointer to the second area to compare.
+ * @param len Size of the areas in bytes.
+ *
+ * @return Zero if areas have the same contents. If they differ,
+ *	   the sign of the result is the same as the sign of the
+ *	   difference of the first pair of different bytes.
+ *
+ */
+int memcmp(const void *s1, const void *s2, size_t len)
+{
+	return __mem_ops.cmp(s1, s2, len);
+}
+
+/** Search memory area.
+ *
+ * @param s Memory area
+ * @param c Character (byte) to search for
+ * @param n Size of memory area in bytes
+ *
+ * @return Pointer to the first occurrence of @a c in the first @a n
+ *         bytes of @a s or @c NULL if not found.
+ */
+void *memchr(const void *s, int c, size_t n)
+{
+	return __mem_ops.chr(s, c, n);
+}
+
 /** @}
  */
@@ -32,8 +32,8 @@
 /** @file
  */
 
-#ifndef _LIBC_FUTEX_H_
-#define _LIBC_FUTEX_H_
+#ifndef _LIBC_PRIVATE_FUTEX_H_
+#define _LIBC_PRIVATE_FUTEX_H_
 
 #include <assert.h>
 #include <stdatomic.h>
@@ -41,12 +41,25 @@
 #include <libc.h>
 #include <time.h>
 #include <fibril.h>
-#include <abi/cap.h>
-#include <abi/synch.h>
+#include <futex.h>
 
+/** Counting semaphore built on top of the kernel address-keyed futex.
+ *
+ * @c val is the semaphore counter. When negative, its absolute value is the
+ * number of threads which need to be woken up. They wait for @c tokens, which
+ * futex_up() hands out when there are threads to be woken up. A token which
+ * is not yet claimed by a thread stays available for the next futex_down(),
+ * just like a missed wakeup of a kernel wait queue. A negative number of
+ * tokens means that the next tokens will be ignored (see
+ * futex_down_composable()).
+ *
+ * @c sleepers counts threads which are about to sleep in the kernel, so that
+ * futex_up() can avoid the wakeup syscall when no one is sleeping.
+ */
 typedef struct futex {
 	volatile atomic_int val;
-	volatile cap_waitq_handle_t whandle;
+	atomic_int tokens;
+	atomic_int sleepers;
 
 #ifdef CONFIG_DEBUG_FUTEX
 	_Atomic(fibril_t *) owner;
@@ -54,15 +67,12 @@ typedef struct futex {
 } futex_t;
 
 extern errno_t futex_initialize(futex_t *futex, int value);
+extern errno_t __futex_sleep(futex_t *, const struct timespec *);
+extern errno_t __futex_wakeup(futex_t *);
 
 static inline errno_t futex_destroy(futex_t *futex)
 {
-	if (futex->whandle) {
-		errno_t rc;
-		rc = __SYSCALL1(SYS_WAITQ_DESTROY, (sysarg_t) futex->whandle);
-		futex->whandle = CAP_NIL;
-		return rc;
-	}
+	(void) futex;
 	return EOK;
 }
 
@@ -95,11 +105,6 @@ void __futex_give_to(futex_t *, void *, const char *);
 
 #endif
 
-static inline errno_t futex_allocate_waitq(futex_t *futex)
-{
-	return __SYSCALL1(SYS_WAITQ_CREATE, (sysarg_t) &futex->whandle);
-}
-
 /** Down the futex with timeout, composably.
  *
  * This means that when the operation fails due to a timeout or being
@@ -119,36 +124,11 @@ static inline errno_t futex_allocate_waitq(futex_t *futex)
 static inline errno_t futex_down_composable(futex_t *futex,
     const struct timespec *expires)
 {
-	// TODO: Add tests for this.
-
-	assert(futex->whandle != CAP_NIL);
-
 	if (atomic_fetch_sub_explicit(&futex->val, 1, memory_order_acquire) > 0)
 		return EOK;
 
-	/* There wasn't any token. We must defer to the underlying semaphore. */
-
-	usec_t timeout;
-
-	if (!expires) {
-		/* No timeout. */
-		timeout = 0;
-	} else {
-		if (expires->tv_sec == 0) {
-			/* We can't just return ETIMEOUT. That wouldn't be composable. */
-			timeout = 1;
-		} else {
-			struct timespec tv;
-			getuptime(&tv);
-			timeout = ts_gteq(&tv, expires) ? 1 :
-			    NSEC2USEC(ts_sub_diff(expires, &tv));
-		}
-
-		assert(timeout > 0);
-	}
-
-	return __SYSCALL3(SYS_WAITQ_SLEEP, (sysarg_t) futex->whandle,
-	    (sysarg_t) timeout, (sysarg_t) SYNCH_FLAGS_FUTEX);
+	/* There wasn't any token. We must wait for futex_up(). */
+	return __futex_sleep(futex, expires);
 }
 
 /** Up the futex.
@@ -163,7 +143,7 @@ static inline errno_t futex_down_composable(futex_t *futex,
 static inline errno_t futex_up(futex_t *futex)
 {
 	if (atomic_fetch_add_explicit(&futex->val, 1, memory_order_release) < 0)
-		return __SYSCALL1(SYS_WAITQ_WAKEUP, (sysarg_t) futex->whandle);
+		return __futex_wakeup(futex);
 
 	return EOK;
 }
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_PRIVATE_MEM_H_
+#define _LIBC_PRIVATE_MEM_H_
+
+#include <stddef.h>
+
+/** Memory and string primitives.
+ *
+ * The table initially points to the generic implementations. Architectures
+ * which provide faster variants replace individual entries from
+ * arch_mem_init(), which is called once during libc initialization (before
+ * any other fibril or thread exists). This allows the selection to depend on
+ * features detected at run time.
+ */
+typedef struct {
+	void *(*set)(void *, int, size_t);
+	void *(*copy)(void *, const void *, size_t);
+	void *(*move)(void *, const void *, size_t);
+	int (*cmp)(const void *, const void *, size_t);
+	void *(*chr)(const void *, int, size_t);
+	/** Number of bytes before the NULL-terminator */
+	size_t (*str_size)(const char *);
+	/** Number of leading bytes in the range 0x01 .. 0x7f */
+	size_t (*ascii_span)(const char *);
+} mem_ops_t;
+
+extern mem_ops_t __mem_ops;
+
+extern void __mem_init(void);
+
+#endif
+
+/** @}
+ */
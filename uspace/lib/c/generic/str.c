@@ -118,6 +118,8 @@
 #include <align.h>
 #include <mem.h>
 
+#include "private/mem.h"
+
 /** Byte mask consisting of lowest @n bits (out of 8) */
 #define LO_MASK_8(n)  ((uint8_t) ((1 << (n)) - 1))
 
@@ -326,12 +328,7 @@ errno_t chr_encode(const char32_t ch, char *str, size_t *offset, size_t size)
  */
 size_t str_size(const char *str)
 {
-	size_t size = 0;
-
-	while (*str++ != 0)
-		size++;
-
-	return size;
+	return __mem_ops.str_size(str);
 }
 
 /** Get size of wide string.
@@ -444,8 +441,17 @@ size_t str_length(const char *str)
 	size_t len = 0;
 	size_t offset = 0;
 
-	while (str_decode(str, &offset, STR_NO_LIMIT) != 0)
+	while (true) {
+		/* Plain ASCII characters are one byte each */
+		size_t span = __mem_ops.ascii_span(str + offset);
+		len += span;
+		offset += span;
+
+		if (str_decode(str, &offset, STR_NO_LIMIT) == 0)
+			break;
+
 		len++;
+	}
 
 	return len;
 }
@@ -584,8 +590,17 @@ int str_cmp(const char *s1, const char *s2)
 	char32_t c1 = 0;
 	char32_t c2 = 0;
 
-	size_t off1 = 0;
-	size_t off2 = 0;
+	/*
+	 * Skip the common prefix of plain ASCII characters without
+	 * decoding. Such bytes are always whole characters.
+	 */
+	size_t off = 0;
+	while (s1[off] == s2[off] && s1[off] != 0 &&
+	    (uint8_t) s1[off] < 0x80)
+		off++;
+
+	size_t off1 = off;
+	size_t off2 = off;
 
 	while (true) {
 		c1 = str_decode(s1, &off1, STR_NO_LIMIT);
@@ -1217,12 +1232,29 @@ char *str_chr(const char *str, char32_t ch)
 {
 	char32_t acc;
 	size_t off = 0;
-	size_t last = 0;
+	size_t last;
+
+	while (true) {
+		/*
+		 * Scan the run of plain ASCII characters first. These
+		 * can be searched for bytewise.
+		 */
+		size_t span = __mem_ops.ascii_span(str + off);
+		if (ch != 0 && ascii_check(ch)) {
+			char *p = memchr(str + off, (int) ch, span);
+			if (p != NULL)
+				return p;
+		}
+
+		off += span;
+		last = off;
+
+		acc = str_decode(str, &off, STR_NO_LIMIT);
+		if (acc == 0)
+			break;
 
-	while ((acc = str_decode(str, &off, STR_NO_LIMIT)) != 0) {
 		if (acc == ch)
 			return (char *) (str + last);
-		last = off;
 	}
 
 	return NULL;
@@ -38,6 +38,8 @@
 #include <str_error.h>
 #include <string.h>
 
+#include "private/mem.h"
+
 /** Copy string.
  *
  * Copy the string pointed to by @a s2 to the array pointed to by @a s1
@@ -490,15 +492,7 @@ char *strerror(int errnum)
  */
 size_t strlen(const char *s)
 {
-	size_t n;
-
-	n = 0;
-	while (*s != '\0') {
-		++s;
-		++n;
-	}
-
-	return n;
+	return __mem_ops.str_size(s);
 }
 
 /** Return number of characters in string with length limit.
@@ -161,11 +161,85 @@ static void check_for_deadlock(fibril_owner_info_t *oi)
 	check_fibril_for_deadlock(oi, fibril_self());
 }
 
+/** Class of mutexes which were not assigned a class explicitly. */
+static fibril_mutex_class_t default_class =
+    FIBRIL_MUTEX_CLASS_INITIALIZER("default");
+
+static fibril_mutex_class_t *_fibril_mutex_class(fibril_mutex_class_t *cls)
+{
+	return (cls != NULL) ? cls : &default_class;
+}
+
 void fibril_mutex_initialize(fibril_mutex_t *fm)
+{
+	fibril_mutex_initialize_class(fm, NULL);
+}
+
+/** Initialize fibril mutex belonging to a mutex class.
+ *
+ * @param fm   Mutex.
+ * @param cls  Mutex class or NULL for the default class.
+ */
+void fibril_mutex_initialize_class(fibril_mutex_t *fm,
+    fibril_mutex_class_t *cls)
 {
 	fm->oi.owned_by = NULL;
 	fm->counter = 1;
 	list_initialize(&fm->waiters);
+	fm->cls = cls;
+}
+
+/** Find out whether it makes sense to spin waiting for a mutex.
+ *
+ * Spinning is only worthwhile while the owner is executing on another
+ * thread and nobody is queued for the mutex (a waiter would receive the
+ * mutex directly on unlock).
+ *
+ * This is called without fibril_synch_futex held and the result is only
+ * a hint. The owner cannot terminate while it holds the mutex, so its
+ * fibril structure remains valid as long as it is observed as the owner.
+ */
+static bool _fibril_mutex_spinnable(fibril_mutex_t *fm)
+{
+	fibril_t *owner = __atomic_load_n(&fm->oi.owned_by, __ATOMIC_RELAXED);
+	if (owner == NULL)
+		return false;
+
+	return __atomic_load_n(&owner->thread_ctx, __ATOMIC_RELAXED) != NULL &&
+	    __atomic_load_n(&fm->waiters.head.next, __ATOMIC_RELAXED) ==
+	    &fm->waiters.head;
+}
+
+/** Spin waiting for a contended mutex to become free.
+ *
+ * Must be called with fibril_synch_futex held and returns with it held.
+ *
+ * @return True if the mutex was acquired, false if the caller must block.
+ */
+static bool _fibril_mutex_spin(fibril_mutex_t *fm, fibril_mutex_class_t *cls)
+{
+	unsigned int limit = cls->spin_limit;
+	unsigned int spins = 0;
+	bool locked = false;
+
+	while (spins < limit && _fibril_mutex_spinnable(fm)) {
+		futex_unlock(&fibril_synch_futex);
+
+		while (spins < limit &&
+		    __atomic_load_n(&fm->counter, __ATOMIC_RELAXED) <= 0 &&
+		    _fibril_mutex_spinnable(fm))
+			spins++;
+
+		futex_lock(&fibril_synch_futex);
+
+		if (fm->counter > 0) {
+			locked = true;
+			break;
+		}
+	}
+
+	cls->stats.spins += spins;
+	return locked;
 }
 
 void fibril_mutex_lock(fibril_mutex_t *fm)
@@ -174,12 +248,27 @@ void fibril_mutex_lock(fibril_mutex_t *fm)
 
 	futex_lock(&fibril_synch_futex);
 
-	if (fm->counter-- > 0) {
+	if (fm->counter > 0) {
+		fm->counter--;
+		fm->oi.owned_by = f;
+		futex_unlock(&fibril_synch_futex);
+		return;
+	}
+
+	fibril_mutex_class_t *cls = _fibril_mutex_class(fm->cls);
+	cls->stats.contended++;
+
+	if (_fibril_mutex_spin(fm, cls)) {
+		cls->stats.spun++;
+		fm->counter--;
 		fm->oi.owned_by = f;
 		futex_unlock(&fibril_synch_futex);
 		return;
 	}
 
+	cls->stats.blocked++;
+	fm->counter--;
+
 	awaiter_t wdata = AWAITER_INIT;
 	list_append(&wdata.link, &fm->waiters);
 	check_for_deadlock(&fm->oi);
@@ -238,6 +327,44 @@ bool fibril_mutex_is_locked(fibril_mutex_t *fm)
 	return locked;
 }
 
+/** Set spin limit of a mutex class.
+ *
+ * @param cls    Mutex class or NULL for the default class.
+ * @param limit  Maximum number of spin iterations of a contended lock
+ *               operation before it blocks. Zero disables spinning.
+ */
+void fibril_mutex_class_set_spin_limit(fibril_mutex_class_t *cls,
+    unsigned int limit)
+{
+	futex_lock(&fibril_synch_futex);
+	_fibril_mutex_class(cls)->spin_limit = limit;
+	futex_unlock(&fibril_synch_futex);
+}
+
+/** Get contention statistics of a mutex class.
+ *
+ * @param cls    Mutex class or NULL for the default class.
+ * @param stats  Place to store the statistics.
+ */
+void fibril_mutex_class_get_stats(fibril_mutex_class_t *cls,
+    fibril_mutex_stats_t *stats)
+{
+	futex_lock(&fibril_synch_futex);
+	*stats = _fibril_mutex_class(cls)->stats;
+	futex_unlock(&fibril_synch_futex);
+}
+
+/** Reset contention statistics of a mutex class.
+ *
+ * @param cls  Mutex class or NULL for the default class.
+ */
+void fibril_mutex_class_reset_stats(fibril_mutex_class_t *cls)
+{
+	futex_lock(&fibril_synch_futex);
+	memset(&_fibril_mutex_class(cls)->stats, 0, sizeof(fibril_mutex_stats_t));
+	futex_unlock(&fibril_synch_futex);
+}
+
 void fibril_rwlock_initialize(fibril_rwlock_t *frw)
 {
 	frw->oi.owned_by = NULL;
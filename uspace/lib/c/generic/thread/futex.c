@@ -35,6 +35,8 @@
 #include <assert.h>
 #include <stdatomic.h>
 #include <fibril.h>
+#include <futex.h>
+#include <libc.h>
 #include <io/kio.h>
 
 #include "../private/fibril.h"
@@ -53,8 +55,148 @@
 errno_t futex_initialize(futex_t *futex, int val)
 {
 	atomic_store_explicit(&futex->val, val, memory_order_relaxed);
-	futex->whandle = CAP_NIL;
-	return futex_allocate_waitq(futex);
+	atomic_store_explicit(&futex->tokens, 0, memory_order_relaxed);
+	atomic_store_explicit(&futex->sleepers, 0, memory_order_relaxed);
+	return EOK;
+}
+
+/** Wait for a token passed by futex_up().
+ *
+ * Called after futex_down_composable() failed to acquire the semaphore
+ * without waiting. When the wait fails, the next token is ignored.
+ *
+ * @param futex    Futex.
+ * @param expires  Absolute deadline or NULL for no timeout.
+ *
+ * @return EOK if a token was claimed, ETIMEOUT, EINTR or another error code.
+ */
+errno_t __futex_sleep(futex_t *futex, const struct timespec *expires)
+{
+	errno_t rc;
+
+	while (true) {
+		int tokens = atomic_load_explicit(&futex->tokens,
+		    memory_order_relaxed);
+		if (tokens > 0) {
+			if (atomic_compare_exchange_weak_explicit(&futex->tokens,
+			    &tokens, tokens - 1, memory_order_acquire,
+			    memory_order_relaxed))
+				return EOK;
+			continue;
+		}
+
+		usec_t timeout = 0;
+		if (expires) {
+			struct timespec tv;
+			getuptime(&tv);
+
+			if ((expires->tv_sec == 0) || ts_gteq(&tv, expires)) {
+				rc = ETIMEOUT;
+				break;
+			}
+
+			timeout = NSEC2USEC(ts_sub_diff(expires, &tv));
+			if (timeout == 0)
+				timeout = 1;
+		}
+
+		/*
+		 * Announce the sleep before the kernel compares the number of
+		 * tokens, so that __futex_wakeup() either sees us or changes
+		 * the number of tokens before the comparison.
+		 */
+		atomic_fetch_add_explicit(&futex->sleepers, 1,
+		    memory_order_seq_cst);
+		rc = futex_wait(&futex->tokens, tokens, timeout);
+		atomic_fetch_sub_explicit(&futex->sleepers, 1,
+		    memory_order_relaxed);
+
+		if ((rc != EOK) && (rc != EAGAIN))
+			break;
+	}
+
+	/*
+	 * The thread is still accounted for in futex->val, so the next token
+	 * is meant for it. Make sure it is ignored. This keeps the operation
+	 * composable (see futex_down_composable()).
+	 */
+	atomic_fetch_sub_explicit(&futex->tokens, 1, memory_order_relaxed);
+	return rc;
+}
+
+/** Pass a token to a thread waiting in __futex_sleep().
+ *
+ * The wakeup syscall is only made if there is a thread which might be
+ * sleeping in the kernel.
+ *
+ * @param futex  Futex.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t __futex_wakeup(futex_t *futex)
+{
+	atomic_fetch_add_explicit(&futex->tokens, 1, memory_order_seq_cst);
+
+	if (atomic_load_explicit(&futex->sleepers, memory_order_seq_cst) > 0)
+		return futex_wake(&futex->tokens, 1);
+
+	return EOK;
+}
+
+/** Sleep in the kernel while the futex has the expected value.
+ *
+ * The futex is identified by the physical address of @a futex, so it can be
+ * shared with other tasks through shared memory.
+ *
+ * @param futex    Futex.
+ * @param val      Expected value.
+ * @param timeout  Timeout in microseconds or zero for no timeout.
+ *
+ * @return EOK if woken up by futex_wake() or futex_requeue(). Spurious
+ *         wakeups are possible, so the caller must check the condition it
+ *         is waiting for.
+ * @return EAGAIN if the futex did not have the expected value.
+ * @return ETIMEOUT or EINTR if the wait timed out or was interrupted.
+ * @return Other error code on failure.
+ */
+errno_t futex_wait(atomic_int *futex, int val, usec_t timeout)
+{
+	return (errno_t) __SYSCALL3(SYS_FUTEX_WAIT, (sysarg_t) futex,
+	    (sysarg_t) val, (sysarg_t) timeout);
+}
+
+/** Wake up threads sleeping in futex_wait().
+ *
+ * @param futex  Futex.
+ * @param count  Maximum number of threads to wake up.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t futex_wake(atomic_int *futex, size_t count)
+{
+	return (errno_t) __SYSCALL2(SYS_FUTEX_WAKE, (sysarg_t) futex,
+	    (sysarg_t) count);
+}
+
+/** Wake up threads sleeping on one futex and move the others to another.
+ *
+ * The moved threads remain asleep until woken up through @a futex2. For
+ * example, a condition variable broadcast can wake up one waiter and requeue
+ * the rest to the mutex, instead of waking them all up just to have them
+ * contend for the mutex.
+ *
+ * @param futex    Futex.
+ * @param wake     Maximum number of threads to wake up.
+ * @param futex2   Futex to which the remaining threads are moved.
+ * @param requeue  Maximum number of threads to move.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t futex_requeue(atomic_int *futex, size_t wake, atomic_int *futex2,
+    size_t requeue)
+{
+	return (errno_t) __SYSCALL4(SYS_FUTEX_REQUEUE, (sysarg_t) futex,
+	    (sysarg_t) wake, (sysarg_t) futex2, (sysarg_t) requeue);
 }
 
 #ifdef CONFIG_DEBUG_FUTEX
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Asynchronous file I/O
+ *
+ * Reads and writes submitted by vfs_read_async() and vfs_write_async() are
+ * sent to VFS right away and the caller continues without waiting for the
+ * answer. Each request in flight holds its own exchange, so VFS and the file
+ * system server handle the requests in parallel and a single fibril can keep
+ * many of them outstanding, across any number of files. When a request is
+ * answered, its completion is appended to the queue it was submitted to,
+ * from which it is collected by vfs_aio_wait().
+ *
+ * Example:
+ * @code
+ * 	vfs_aio_queue_t *queue;
+ * 	vfs_aio_completion_t comp;
+ *
+ * 	rc = vfs_aio_queue_create(&queue);
+ * 	for (i = 0; i < n; i++)
+ * 		rc = vfs_read_async(queue, file, i * size, buf[i], size, buf[i]);
+ * 	while (vfs_aio_wait(queue, 0, &comp) == EOK)
+ * 		process(comp.arg, comp.nbytes);
+ * 	vfs_aio_queue_destroy(queue);
+ * @endcode
+ */
+
+#include <adt/list.h>
+#include <async.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <ipc/vfs.h>
+#include <macros.h>
+#include <stdlib.h>
+#include <vfs/aio.h>
+#include <vfs/vfs.h>
+
+struct vfs_aio_queue {
+	/** Protects the queue */
+	fibril_mutex_t lock;
+	/** Signalled when a request completes */
+	fibril_condvar_t cv;
+	/** Completed requests not yet collected (vfs_aio_req_t) */
+	list_t done;
+	/** Number of requests in flight */
+	size_t pending;
+};
+
+/** Asynchronous request */
+typedef struct {
+	/** Link to vfs_aio_queue_t.done */
+	link_t link;
+	/** Queue the request was submitted to */
+	vfs_aio_queue_t *queue;
+	/** Exchange held for the duration of the request */
+	async_exch_t *exch;
+	/** VFS_IN_READ or VFS_IN_WRITE message */
+	aid_t req;
+	/** Data transfer message */
+	aid_t data;
+	/** Answer to @c req */
+	ipc_call_t answer;
+	/** Completion to be passed to the caller */
+	vfs_aio_completion_t comp;
+} vfs_aio_req_t;
+
+/** Create a queue for asynchronous requests.
+ *
+ * @param[out] rqueue Place to store pointer to the new queue
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t vfs_aio_queue_create(vfs_aio_queue_t **rqueue)
+{
+	vfs_aio_queue_t *queue = calloc(1, sizeof(vfs_aio_queue_t));
+	if (queue == NULL)
+		return ENOMEM;
+
+	fibril_mutex_initialize(&queue->lock);
+	fibril_condvar_initialize(&queue->cv);
+	list_initialize(&queue->done);
+
+	*rqueue = queue;
+	return EOK;
+}
+
+/** Destroy a queue for asynchronous requests.
+ *
+ * Waits for the requests still in flight and discards all completions
+ * not collected yet.
+ *
+ * @param queue Queue
+ */
+void vfs_aio_queue_destroy(vfs_aio_queue_t *queue)
+{
+	fibril_mutex_lock(&queue->lock);
+
+	while (queue->pending > 0)
+		fibril_condvar_wait(&queue->cv, &queue->lock);
+
+	while (!list_empty(&queue->done)) {
+		vfs_aio_req_t *req = list_get_instance(list_first(&queue->done),
+		    vfs_aio_req_t, link);
+		list_remove(&req->link);
+		free(req);
+	}
+
+	fibril_mutex_unlock(&queue->lock);
+	free(queue);
+}
+
+/** Get number of requests not collected yet.
+ *
+ * @param queue Queue
+ *
+ * @return Number of requests in flight plus completions not yet collected
+ */
+size_t vfs_aio_queue_pending(vfs_aio_queue_t *queue)
+{
+	fibril_mutex_lock(&queue->lock);
+	size_t count = queue->pending + list_count(&queue->done);
+	fibril_mutex_unlock(&queue->lock);
+
+	return count;
+}
+
+/** Wait for the answers to a request and complete it.
+ *
+ * @param arg Request (vfs_aio_req_t)
+ *
+ * @return EOK
+ */
+static errno_t vfs_aio_req_fibril(void *arg)
+{
+	vfs_aio_req_t *req = (vfs_aio_req_t *) arg;
+	vfs_aio_queue_t *queue = req->queue;
+	errno_t data_rc;
+	errno_t rc;
+
+	async_wait_for(req->data, &data_rc);
+	async_wait_for(req->req, &rc);
+	vfs_exchange_end(req->exch);
+
+	if (rc == EOK)
+		rc = data_rc;
+
+	req->comp.rc = rc;
+	req->comp.nbytes = (rc == EOK) ? ipc_get_arg1(&req->answer) : 0;
+
+	fibril_mutex_lock(&queue->lock);
+	queue->pending--;
+	list_append(&req->link, &queue->done);
+	fibril_condvar_broadcast(&queue->cv);
+	fibril_mutex_unlock(&queue->lock);
+
+	return EOK;
+}
+
+/** Submit an asynchronous read or write.
+ *
+ * @param queue Queue for the completion
+ * @param file  File handle
+ * @param pos   Position in the file
+ * @param buf   Buffer
+ * @param nbyte Number of bytes to transfer
+ * @param read  @c true to read, @c false to write
+ * @param arg   Argument passed back in the completion
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t vfs_aio_submit(vfs_aio_queue_t *queue, int file, aoff64_t pos,
+    void *buf, size_t nbyte, bool read, void *arg)
+{
+	vfs_aio_req_t *req = calloc(1, sizeof(vfs_aio_req_t));
+	if (req == NULL)
+		return ENOMEM;
+
+	fid_t fid = fibril_create(vfs_aio_req_fibril, req);
+	if (fid == 0) {
+		free(req);
+		return ENOMEM;
+	}
+
+	if (nbyte > DATA_XFER_LIMIT)
+		nbyte = DATA_XFER_LIMIT;
+
+	link_initialize(&req->link);
+	req->queue = queue;
+	req->comp.arg = arg;
+
+	req->exch = vfs_exchange_begin();
+	if (read) {
+		req->req = async_send_3(req->exch, VFS_IN_READ, file,
+		    LOWER32(pos), UPPER32(pos), &req->answer);
+		req->data = async_data_read(req->exch, buf, nbyte, NULL);
+	} else {
+		req->req = async_send_3(req->exch, VFS_IN_WRITE, file,
+		    LOWER32(pos), UPPER32(pos), &req->answer);
+		req->data = async_data_write(req->exch, buf, nbyte, NULL);
+	}
+
+	if ((req->req == 0) || (req->data == 0)) {
+		if (req->data != 0)
+			async_forget(req->data);
+		if (req->req != 0)
+			async_forget(req->req);
+		vfs_exchange_end(req->exch);
+		fibril_destroy(fid);
+		free(req);
+		return ENOMEM;
+	}
+
+	fibril_mutex_lock(&queue->lock);
+	queue->pending++;
+	fibril_mutex_unlock(&queue->lock);
+
+	fibril_add_ready(fid);
+	return EOK;
+}
+
+/** Submit an asynchronous read.
+ *
+ * The read is sent to VFS and the function returns without waiting for
+ * the data. As with vfs_read_short(), fewer bytes than requested may be
+ * read, the actual number is passed in the completion. The buffer must
+ * not be touched until the request completes.
+ *
+ * @param queue Queue for the completion
+ * @param file  File handle to read from
+ * @param pos   Position to read from
+ * @param buf   Buffer, @a nbyte bytes long
+ * @param nbyte Maximum number of bytes to read
+ * @param arg   Argument passed back in the completion
+ *
+ * @return EOK on success or an error code
+ */
+errno_t vfs_read_async(vfs_aio_queue_t *queue, int file, aoff64_t pos,
+    void *buf, size_t nbyte, void *arg)
+{
+	return vfs_aio_submit(queue, file, pos, buf, nbyte, true, arg);
+}
+
+/** Submit an asynchronous write.
+ *
+ * The write is sent to VFS and the function returns without waiting for
+ * it to finish. As with vfs_write_short(), fewer bytes than requested may be
+ * written, the actual number is passed in the completion. The buffer must
+ * not be touched until the request completes.
+ *
+ * @param queue Queue for the completion
+ * @param file  File handle to write to
+ * @param pos   Position to write to
+ * @param buf   Buffer, @a nbyte bytes long
+ * @param nbyte Maximum number of bytes to write
+ * @param arg   Argument passed back in the completion
+ *
+ * @return EOK on success or an error code
+ */
+errno_t vfs_write_async(vfs_aio_queue_t *queue, int file, aoff64_t pos,
+    const void *buf, size_t nbyte, void *arg)
+{
+	return vfs_aio_submit(queue, file, pos, (void *) buf, nbyte, false,
+	    arg);
+}
+
+/** Wait for completion of an asynchronous request.
+ *
+ * Requests are completed in the order in which they finish, which need not
+ * be the order of submission.
+ *
+ * @param queue   Queue
+ * @param timeout Timeout in microseconds, zero to wait indefinitely
+ * @param[out] comp Place to store the completion
+ *
+ * @return EOK on success, ENOENT if there are no requests to wait for,
+ *         ETIMEOUT if no request completed within @a timeout
+ */
+errno_t vfs_aio_wait(vfs_aio_queue_t *queue, usec_t timeout,
+    vfs_aio_completion_t *comp)
+{
+	fibril_mutex_lock(&queue->lock);
+
+	while (list_empty(&queue->done)) {
+		if (queue->pending == 0) {
+			fibril_mutex_unlock(&queue->lock);
+			return ENOENT;
+		}
+
+		errno_t rc = fibril_condvar_wait_timeout(&queue->cv,
+		    &queue->lock, timeout);
+		if (rc == ETIMEOUT) {
+			fibril_mutex_unlock(&queue->lock);
+			return ETIMEOUT;
+		}
+	}
+
+	vfs_aio_req_t *req = list_get_instance(list_first(&queue->done),
+	    vfs_aio_req_t, link);
+	list_remove(&req->link);
+	fibril_mutex_unlock(&queue->lock);
+
+	*comp = req->comp;
+	free(req);
+	return EOK;
+}
+
+/** @}
+ */
@@ -253,6 +253,56 @@ errno_t vfs_clone(int file_from, int file_to, bool high, int *handle)
 	return rc;
 }
 
+/** Copy a range of bytes between files
+ *
+ * The data do not pass through the client. If both files are on the same
+ * file system instance and the file system supports it, the copy is done
+ * by the file system itself, otherwise VFS streams the data from one file
+ * system server to the other.
+ *
+ * @param file_from     Handle of the file to copy from, open for reading
+ * @param pos_from      Position in @a file_from to copy from
+ * @param file_to       Handle of the file to copy to, open for writing
+ * @param pos_to        Position in @a file_to to copy to
+ * @param size          Number of bytes to copy
+ * @param[out] copied   Place to store the number of bytes actually copied,
+ *                      which may be less than @a size, zero if @a pos_from
+ *                      is at or past the end of @a file_from
+ *
+ * @return              EOK on success, EINVAL if the ranges overlap within
+ *                      the same file, or an error code
+ */
+errno_t vfs_copy_range(int file_from, aoff64_t pos_from, int file_to,
+    aoff64_t pos_to, aoff64_t size, aoff64_t *copied)
+{
+	vfs_copy_range_t range = {
+		.src_pos = pos_from,
+		.dst_pos = pos_to,
+		.size = size
+	};
+	ipc_call_t answer;
+	errno_t rc;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	aid_t req = async_send_2(exch, VFS_IN_COPY_RANGE, file_from, file_to,
+	    &answer);
+	rc = async_data_write_start(exch, &range, sizeof(range));
+
+	vfs_exchange_end(exch);
+
+	if (rc == EOK)
+		async_wait_for(req, &rc);
+	else
+		async_forget(req);
+
+	if (rc != EOK)
+		return rc;
+
+	*copied = MERGE_LOUP32(ipc_get_arg1(&answer), ipc_get_arg2(&answer));
+	return EOK;
+}
+
 /** Get current working directory path
  *
  * @param[out] buf      Buffer
@@ -906,6 +956,55 @@ errno_t vfs_read_short(int file, aoff64_t pos, void *buf, size_t nbyte,
 	return EOK;
 }
 
+/** Read a batch of directory entries
+ *
+ * Fills @a buf with as many entries as fit, each followed by the attributes
+ * of the node it refers to (see vfs_dirent_t). This replaces a read and
+ * a stat per entry with a single request for the whole batch.
+ *
+ * @param file          Handle of an open directory
+ * @param[in,out] pos   Position to read from, updated to the position of
+ *                      the first entry not returned
+ * @param buf           Buffer for the entries
+ * @param size          Size of the buffer
+ * @param[out] nread    Number of bytes of entries stored in @a buf, zero
+ *                      at the end of the directory
+ *
+ * @return              EOK on success, EOVERFLOW if not even the first entry
+ *                      fits in the buffer, ENOTSUP if the file system does
+ *                      not support batched reading or an error code
+ */
+errno_t vfs_readdir(int file, aoff64_t *pos, void *buf, size_t size,
+    size_t *nread)
+{
+	errno_t rc;
+	ipc_call_t answer;
+	aid_t req;
+
+	if (size > DATA_XFER_LIMIT)
+		size = DATA_XFER_LIMIT;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_3(exch, VFS_IN_READDIR, file, LOWER32(*pos),
+	    UPPER32(*pos), &answer);
+	rc = async_data_read_start(exch, buf, size);
+
+	vfs_exchange_end(exch);
+
+	if (rc == EOK)
+		async_wait_for(req, &rc);
+	else
+		async_forget(req);
+
+	if (rc != EOK)
+		return rc;
+
+	*nread = ipc_get_arg1(&answer);
+	*pos = MERGE_LOUP32(ipc_get_arg2(&answer), ipc_get_arg3(&answer));
+	return EOK;
+}
+
 /** Rename a file or directory
  *
  * There is no file-handle-based variant to disallow attempts to introduce loops
@@ -1042,6 +1141,40 @@ errno_t vfs_root_set(int nroot)
 	return EOK;
 }
 
+/** Get statistics of the VFS directory entry cache
+ *
+ * @param[out] stat     Place to store the statistics
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_dcache_stat(vfs_dcache_stat_t *stat)
+{
+	errno_t rc;
+	aid_t req;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_0(exch, VFS_IN_DCACHE_STAT, NULL);
+	rc = async_data_read_start(exch, (void *) stat,
+	    sizeof(vfs_dcache_stat_t));
+	if (rc != EOK) {
+		vfs_exchange_end(exch);
+
+		errno_t rc_orig;
+		async_wait_for(req, &rc_orig);
+
+		if (rc_orig != EOK)
+			rc = rc_orig;
+
+		return rc;
+	}
+
+	vfs_exchange_end(exch);
+	async_wait_for(req, &rc);
+
+	return rc;
+}
+
 /** Get file information
  *
  * @param file          File handle to get information about
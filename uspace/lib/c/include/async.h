@@ -140,6 +140,7 @@ extern errno_t async_create_callback_port(async_exch_t *, iface_t, sysarg_t,
 extern errno_t async_irq_subscribe(int, async_notification_handler_t, void *,
     const irq_code_t *, cap_irq_handle_t *);
 extern errno_t async_irq_unsubscribe(cap_irq_handle_t);
+extern errno_t async_irq_coalesce(cap_irq_handle_t, size_t);
 
 extern errno_t async_event_subscribe(event_type_t, async_notification_handler_t,
     void *);
@@ -336,6 +337,8 @@ extern errno_t async_data_read_start(async_exch_t *, void *, size_t);
 extern bool async_data_read_receive(ipc_call_t *, size_t *);
 extern errno_t async_data_read_finalize(ipc_call_t *, const void *, size_t);
 
+extern aid_t async_data_write(async_exch_t *, const void *, size_t,
+    ipc_call_t *);
 extern errno_t async_data_write_forward_0_0(async_exch_t *, sysarg_t);
 extern errno_t async_data_write_forward_1_0(async_exch_t *, sysarg_t, sysarg_t);
 extern errno_t async_data_write_forward_2_0(async_exch_t *, sysarg_t, sysarg_t,
@@ -55,6 +55,8 @@ typedef enum {
 	HW_RES_CLEAR_INTERRUPT,
 	HW_RES_DMA_CHANNEL_SETUP,
 	HW_RES_DMA_CHANNEL_REMAIN,
+	HW_RES_ENABLE_MSI,
+	HW_RES_DISABLE_MSI,
 } hw_res_method_t;
 
 /** HW resource types */
@@ -119,6 +121,8 @@ extern errno_t hw_res_get_resource_list(async_sess_t *, hw_resource_list_t *);
 extern errno_t hw_res_enable_interrupt(async_sess_t *, int);
 extern errno_t hw_res_disable_interrupt(async_sess_t *, int);
 extern errno_t hw_res_clear_interrupt(async_sess_t *, int);
+extern errno_t hw_res_enable_msi(async_sess_t *, size_t, int *, size_t *);
+extern errno_t hw_res_disable_msi(async_sess_t *);
 
 extern errno_t hw_res_dma_channel_setup(async_sess_t *, unsigned int, uint32_t,
     uint32_t, uint8_t);
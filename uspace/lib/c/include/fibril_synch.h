@@ -39,6 +39,7 @@
 #include <adt/list.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <_bits/decls.h>
 
 #ifndef __cplusplus
@@ -89,10 +90,51 @@
 
 __HELENOS_DECLS_BEGIN;
 
+/** Default number of spin iterations before a contended lock blocks */
+#define FIBRIL_MUTEX_SPIN_LIMIT_DEFAULT  1000
+
+/** Contention statistics of a fibril mutex class. */
+typedef struct {
+	/** Number of lock operations which found the mutex locked */
+	size_t contended;
+	/** Number of contended lock operations satisfied by spinning */
+	size_t spun;
+	/** Number of contended lock operations which had to block */
+	size_t blocked;
+	/** Total number of spin iterations */
+	size_t spins;
+} fibril_mutex_stats_t;
+
+/** Class of fibril mutexes.
+ *
+ * Mutexes of one class share the spinning policy and their contention
+ * statistics. Mutexes which are not explicitly assigned to a class belong
+ * to the default class.
+ */
+typedef struct {
+	/** Name of the class */
+	const char *name;
+	/**
+	 * Maximum number of spin iterations of a contended lock operation
+	 * before it blocks. Zero disables spinning.
+	 */
+	unsigned int spin_limit;
+	/** Contention statistics (protected by an internal lock) */
+	fibril_mutex_stats_t stats;
+} fibril_mutex_class_t;
+
+#define FIBRIL_MUTEX_CLASS_INITIALIZER(cname) \
+	{ \
+		.name = (cname), \
+		.spin_limit = FIBRIL_MUTEX_SPIN_LIMIT_DEFAULT, \
+	}
+
 typedef struct {
 	fibril_owner_info_t oi;  /**< Keep this the first thing. */
 	int counter;
 	list_t waiters;
+	/** Mutex class or NULL for the default class */
+	fibril_mutex_class_t *cls;
 } fibril_mutex_t;
 
 typedef struct {
@@ -153,11 +195,19 @@ extern void __fibril_synch_init(void);
 extern void __fibril_synch_fini(void);
 
 extern void fibril_mutex_initialize(fibril_mutex_t *);
+extern void fibril_mutex_initialize_class(fibril_mutex_t *,
+    fibril_mutex_class_t *);
 extern void fibril_mutex_lock(fibril_mutex_t *);
 extern bool fibril_mutex_trylock(fibril_mutex_t *);
 extern void fibril_mutex_unlock(fibril_mutex_t *);
 extern bool fibril_mutex_is_locked(fibril_mutex_t *);
 
+extern void fibril_mutex_class_set_spin_limit(fibril_mutex_class_t *,
+    unsigned int);
+extern void fibril_mutex_class_get_stats(fibril_mutex_class_t *,
+    fibril_mutex_stats_t *);
+extern void fibril_mutex_class_reset_stats(fibril_mutex_class_t *);
+
 extern void fibril_rwlock_initialize(fibril_rwlock_t *);
 extern void fibril_rwlock_read_lock(fibril_rwlock_t *);
 extern void fibril_rwlock_write_lock(fibril_rwlock_t *);
@@ -42,6 +42,7 @@
 extern errno_t ipc_irq_subscribe(int, sysarg_t, const irq_code_t *,
     cap_irq_handle_t *);
 extern errno_t ipc_irq_unsubscribe(cap_irq_handle_t);
+extern errno_t ipc_irq_coalesce(cap_irq_handle_t, size_t);
 
 #endif
 
@@ -61,6 +61,13 @@ typedef struct {
 	unsigned int instance;
 	bool concurrent_read_write;
 	bool write_retains_size;
+	/**
+	 * The namespace of the fs only changes through VFS, so VFS may cache
+	 * the results of name lookups. The fs must be able to find a node by
+	 * its index at any time, even after the node was dropped from its own
+	 * caches.
+	 */
+	bool cache_names;
 } vfs_info_t;
 
 /** Data returned by filesystem probe regarding a specific volume. */
@@ -69,14 +76,24 @@ typedef struct {
 	char vuid[FS_VUID_MAXLEN + 1];
 } vfs_fs_probe_info_t;
 
+/** Ranges of a copy, sent with VFS_IN_COPY_RANGE and VFS_OUT_COPY_RANGE. */
+typedef struct {
+	uint64_t src_pos;
+	uint64_t dst_pos;
+	uint64_t size;
+} vfs_copy_range_t;
+
 typedef enum {
 	VFS_IN_CLONE = IPC_FIRST_USER_METHOD,
+	VFS_IN_COPY_RANGE,
+	VFS_IN_DCACHE_STAT,
 	VFS_IN_FSPROBE,
 	VFS_IN_FSTYPES,
 	VFS_IN_MOUNT,
 	VFS_IN_OPEN,
 	VFS_IN_PUT,
 	VFS_IN_READ,
+	VFS_IN_READDIR,
 	VFS_IN_REGISTER,
 	VFS_IN_RENAME,
 	VFS_IN_RESIZE,
@@ -92,6 +109,7 @@ typedef enum {
 
 typedef enum {
 	VFS_OUT_CLOSE = IPC_FIRST_USER_METHOD,
+	VFS_OUT_COPY_RANGE,
 	VFS_OUT_DESTROY,
 	VFS_OUT_FSPROBE,
 	VFS_OUT_IS_EMPTY,
@@ -100,6 +118,7 @@ typedef enum {
 	VFS_OUT_MOUNTED,
 	VFS_OUT_OPEN_NODE,
 	VFS_OUT_READ,
+	VFS_OUT_READDIR,
 	VFS_OUT_STAT,
 	VFS_OUT_STATFS,
 	VFS_OUT_SYNC,
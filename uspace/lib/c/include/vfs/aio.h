@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_VFS_AIO_H_
+#define _LIBC_VFS_AIO_H_
+
+#include <errno.h>
+#include <offset.h>
+#include <stddef.h>
+#include <time.h>
+
+/** Queue collecting completions of asynchronous requests */
+typedef struct vfs_aio_queue vfs_aio_queue_t;
+
+/** Completion of an asynchronous request */
+typedef struct {
+	/** Argument passed when the request was submitted */
+	void *arg;
+	/** Result of the request */
+	errno_t rc;
+	/** Number of bytes actually transferred */
+	size_t nbytes;
+} vfs_aio_completion_t;
+
+extern errno_t vfs_aio_queue_create(vfs_aio_queue_t **);
+extern void vfs_aio_queue_destroy(vfs_aio_queue_t *);
+extern size_t vfs_aio_queue_pending(vfs_aio_queue_t *);
+
+extern errno_t vfs_read_async(vfs_aio_queue_t *, int, aoff64_t, void *,
+    size_t, void *);
+extern errno_t vfs_write_async(vfs_aio_queue_t *, int, aoff64_t, const void *,
+    size_t, void *);
+extern errno_t vfs_aio_wait(vfs_aio_queue_t *, usec_t, vfs_aio_completion_t *);
+
+#endif
+
+/** @}
+ */
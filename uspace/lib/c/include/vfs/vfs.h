@@ -64,6 +64,24 @@ typedef struct {
 	service_id_t service;
 } vfs_stat_t;
 
+/** Directory entry returned by vfs_readdir()
+ *
+ * Entries are packed one after another, the next entry starts @c reclen
+ * bytes after the beginning of this one. The attributes are those of the
+ * node in the file system of the directory, mount points are not crossed.
+ */
+typedef struct {
+	/** Length of the entry including the name and padding */
+	size_t reclen;
+	fs_index_t index;
+	unsigned int lnkcnt;
+	bool is_file;
+	bool is_directory;
+	aoff64_t size;
+	/** Null-terminated name of the entry */
+	char name[];
+} vfs_dirent_t;
+
 typedef struct {
 	char fs_name[FS_NAME_MAXLEN + 1];
 	uint32_t f_bsize;    /* fundamental file system block size */
@@ -71,6 +89,24 @@ typedef struct {
 	uint64_t f_bfree;    /* free blocks in fs */
 } vfs_statfs_t;
 
+/** Statistics of the VFS directory entry cache */
+typedef struct {
+	/** Lookups answered by a positive entry */
+	uint64_t hits;
+	/** Lookups answered by a negative entry */
+	uint64_t neg_hits;
+	/** Lookups which had to be passed to the file system */
+	uint64_t misses;
+	/** Entries evicted to make room for new ones */
+	uint64_t evictions;
+	/** Entries invalidated by namespace changes */
+	uint64_t invalidations;
+	/** Number of cached entries */
+	uint64_t entries;
+	/** Maximum number of cached entries */
+	uint64_t capacity;
+} vfs_dcache_stat_t;
+
 /** List of file system types */
 typedef struct {
 	char **fstypes;
@@ -82,8 +118,11 @@ extern errno_t vfs_fhandle(FILE *, int *);
 
 extern char *vfs_absolutize(const char *, size_t *);
 extern errno_t vfs_clone(int, int, bool, int *);
+extern errno_t vfs_copy_range(int, aoff64_t, int, aoff64_t, aoff64_t,
+    aoff64_t *);
 extern errno_t vfs_cwd_get(char *path, size_t);
 extern errno_t vfs_cwd_set(const char *path);
+extern errno_t vfs_dcache_stat(vfs_dcache_stat_t *);
 extern async_exch_t *vfs_exchange_begin(void);
 extern void vfs_exchange_end(async_exch_t *);
 extern errno_t vfs_fsprobe(const char *, service_id_t, vfs_fs_probe_info_t *);
@@ -102,6 +141,7 @@ extern errno_t vfs_pass_handle(async_exch_t *, int, async_exch_t *);
 extern errno_t vfs_put(int);
 extern errno_t vfs_read(int, aoff64_t *, void *, size_t, size_t *);
 extern errno_t vfs_read_short(int, aoff64_t, void *, size_t, ssize_t *);
+extern errno_t vfs_readdir(int, aoff64_t *, void *, size_t, size_t *);
 extern errno_t vfs_receive_handle(bool, int *);
 extern errno_t vfs_rename_path(const char *, const char *);
 extern errno_t vfs_resize(int, aoff64_t);
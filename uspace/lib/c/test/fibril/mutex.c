@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(fibril_mutex);
+
+typedef struct {
+	fibril_mutex_t *lock;
+	bool done;
+} locker_t;
+
+static errno_t locker_fn(void *arg)
+{
+	locker_t *locker = (locker_t *) arg;
+
+	fibril_mutex_lock(locker->lock);
+	locker->done = true;
+	fibril_mutex_unlock(locker->lock);
+
+	return EOK;
+}
+
+PCUT_TEST(lock_unlock)
+{
+	fibril_mutex_t lock;
+
+	fibril_mutex_initialize(&lock);
+	fibril_mutex_lock(&lock);
+	PCUT_ASSERT_TRUE(fibril_mutex_is_locked(&lock));
+	PCUT_ASSERT_FALSE(fibril_mutex_trylock(&lock));
+	fibril_mutex_unlock(&lock);
+
+	PCUT_ASSERT_TRUE(fibril_mutex_trylock(&lock));
+	fibril_mutex_unlock(&lock);
+}
+
+/** Uncontended lock operations are not counted */
+PCUT_TEST(class_uncontended)
+{
+	fibril_mutex_class_t cls = FIBRIL_MUTEX_CLASS_INITIALIZER("test");
+	fibril_mutex_stats_t stats;
+	fibril_mutex_t lock;
+
+	fibril_mutex_initialize_class(&lock, &cls);
+	fibril_mutex_lock(&lock);
+	fibril_mutex_unlock(&lock);
+
+	fibril_mutex_class_get_stats(&cls, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.contended);
+	PCUT_ASSERT_INT_EQUALS(0, stats.spun);
+	PCUT_ASSERT_INT_EQUALS(0, stats.blocked);
+}
+
+/** A contended lock blocks when the owner is not running */
+PCUT_TEST(class_contended)
+{
+	fibril_mutex_class_t cls = FIBRIL_MUTEX_CLASS_INITIALIZER("test");
+	fibril_mutex_stats_t stats;
+	fibril_mutex_t lock;
+	locker_t locker;
+	fid_t fid;
+
+	fibril_mutex_initialize_class(&lock, &cls);
+	locker.lock = &lock;
+	locker.done = false;
+
+	fibril_mutex_lock(&lock);
+
+	fid = fibril_create(locker_fn, &locker);
+	PCUT_ASSERT_TRUE(fid != 0);
+	fibril_add_ready(fid);
+
+	/* Let the other fibril block on the mutex */
+	fibril_yield();
+	PCUT_ASSERT_FALSE(locker.done);
+
+	fibril_mutex_unlock(&lock);
+
+	while (!locker.done)
+		fibril_yield();
+
+	fibril_mutex_class_get_stats(&cls, &stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.contended);
+	PCUT_ASSERT_INT_EQUALS(0, stats.spun);
+	PCUT_ASSERT_INT_EQUALS(1, stats.blocked);
+
+	fibril_mutex_class_reset_stats(&cls);
+	fibril_mutex_class_get_stats(&cls, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.contended);
+	PCUT_ASSERT_INT_EQUALS(0, stats.blocked);
+}
+
+PCUT_TEST(class_spin_limit)
+{
+	fibril_mutex_class_t cls = FIBRIL_MUTEX_CLASS_INITIALIZER("test");
+
+	PCUT_ASSERT_INT_EQUALS(FIBRIL_MUTEX_SPIN_LIMIT_DEFAULT, cls.spin_limit);
+	fibril_mutex_class_set_spin_limit(&cls, 0);
+	PCUT_ASSERT_INT_EQUALS(0, cls.spin_limit);
+}
+
+PCUT_EXPORT(fibril_mutex);
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <futex.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(futex);
+
+/** Waiting on a futex which does not have the expected value fails */
+PCUT_TEST(wait_mismatch)
+{
+	atomic_int word = 1;
+
+	PCUT_ASSERT_ERRNO_VAL(EAGAIN, futex_wait(&word, 0, 0));
+}
+
+/** Waiting on a futex which is never woken up times out */
+PCUT_TEST(wait_timeout)
+{
+	atomic_int word = 0;
+
+	PCUT_ASSERT_ERRNO_VAL(ETIMEOUT, futex_wait(&word, 0, 1000));
+}
+
+/** Waking up a futex without waiters succeeds */
+PCUT_TEST(wake_no_waiters)
+{
+	atomic_int word = 0;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, futex_wake(&word, 1));
+	PCUT_ASSERT_ERRNO_VAL(EOK, futex_wake(&word, SIZE_MAX));
+}
+
+/** Requeueing a futex without waiters succeeds */
+PCUT_TEST(requeue_no_waiters)
+{
+	atomic_int word = 0;
+	atomic_int word2 = 0;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, futex_requeue(&word, 1, &word2, SIZE_MAX));
+	PCUT_ASSERT_ERRNO_VAL(EOK, futex_requeue(&word, 1, &word, SIZE_MAX));
+}
+
+/** Futex must be naturally aligned */
+PCUT_TEST(unaligned)
+{
+	alignas(int) char buf[2 * sizeof(int)] = { 0 };
+	atomic_int *word = (atomic_int *) (buf + 1);
+
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, futex_wait(word, 0, 1000));
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, futex_wake(word, 1));
+}
+
+PCUT_EXPORT(futex);
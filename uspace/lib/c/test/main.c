@@ -35,7 +35,9 @@ PCUT_IMPORT(capa);
 PCUT_IMPORT(casting);
 PCUT_IMPORT(circ_buf);
 PCUT_IMPORT(double_to_str);
+PCUT_IMPORT(fibril_mutex);
 PCUT_IMPORT(fibril_timer);
+PCUT_IMPORT(futex);
 PCUT_IMPORT(getopt);
 PCUT_IMPORT(gsort);
 PCUT_IMPORT(ieee_double);
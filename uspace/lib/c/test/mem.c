@@ -27,8 +27,48 @@
  */
 
 #include <mem.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <pcut/pcut.h>
 
+/** Size of buffers used for exercising all size and alignment classes */
+#define TEST_BUF_SIZE 600
+
+static uint8_t tbuf_a[TEST_BUF_SIZE];
+static uint8_t tbuf_b[TEST_BUF_SIZE];
+static uint8_t tbuf_ref[TEST_BUF_SIZE];
+
+/** Sizes covering the short, medium and looping code paths */
+static const size_t test_sizes[] = {
+	0, 1, 2, 3, 4, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65,
+	127, 128, 129, 255, 300, 511
+};
+
+#define TEST_SIZES (sizeof(test_sizes) / sizeof(test_sizes[0]))
+
+/** Fill buffer with a pattern that differs for each seed. */
+static void fill_pattern(uint8_t *buf, size_t size, unsigned seed)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		buf[i] = (uint8_t) (i * 7 + seed * 13 + 1);
+}
+
+/** Compare two buffers bytewise. */
+static bool buf_equal(const uint8_t *a, const uint8_t *b, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		if (a[i] != b[i])
+			return false;
+	}
+
+	return true;
+}
+
 PCUT_INIT;
 
 PCUT_TEST_SUITE(mem);
@@ -115,4 +155,156 @@ PCUT_TEST(memset)
 	PCUT_ASSERT_INT_EQUALS('x', buf[4]);
 }
 
+/** memcpy with various sizes and alignments */
+PCUT_TEST(memcpy_sizes)
+{
+	size_t i, j, soff, doff;
+	void *p;
+
+	for (i = 0; i < TEST_SIZES; i++) {
+		for (soff = 0; soff < 16; soff += 3) {
+			for (doff = 0; doff < 16; doff += 5) {
+				size_t n = test_sizes[i];
+
+				fill_pattern(tbuf_a, TEST_BUF_SIZE, 1);
+				fill_pattern(tbuf_b, TEST_BUF_SIZE, 2);
+				fill_pattern(tbuf_ref, TEST_BUF_SIZE, 2);
+
+				for (j = 0; j < n; j++)
+					tbuf_ref[doff + j] = tbuf_a[soff + j];
+
+				p = memcpy(tbuf_b + doff, tbuf_a + soff, n);
+				PCUT_ASSERT_TRUE(p == tbuf_b + doff);
+				PCUT_ASSERT_TRUE(buf_equal(tbuf_ref, tbuf_b,
+				    TEST_BUF_SIZE));
+			}
+		}
+	}
+}
+
+/** memmove with overlapping areas in both directions */
+PCUT_TEST(memmove_overlap)
+{
+	size_t i, j, off;
+	void *p;
+
+	for (i = 0; i < TEST_SIZES; i++) {
+		for (off = 1; off < 40; off += 3) {
+			size_t n = test_sizes[i];
+
+			/* Forwards (destination below source) */
+			fill_pattern(tbuf_a, TEST_BUF_SIZE, 3);
+			fill_pattern(tbuf_ref, TEST_BUF_SIZE, 3);
+			for (j = 0; j < n; j++)
+				tbuf_ref[5 + j] = tbuf_a[5 + off + j];
+
+			p = memmove(tbuf_a + 5, tbuf_a + 5 + off, n);
+			PCUT_ASSERT_TRUE(p == tbuf_a + 5);
+			PCUT_ASSERT_TRUE(buf_equal(tbuf_ref, tbuf_a,
+			    TEST_BUF_SIZE));
+
+			/* Backwards (destination above source) */
+			fill_pattern(tbuf_a, TEST_BUF_SIZE, 4);
+			fill_pattern(tbuf_ref, TEST_BUF_SIZE, 4);
+			for (j = n; j > 0; j--)
+				tbuf_ref[5 + off + j - 1] = tbuf_a[5 + j - 1];
+
+			p = memmove(tbuf_a + 5 + off, tbuf_a + 5, n);
+			PCUT_ASSERT_TRUE(p == tbuf_a + 5 + off);
+			PCUT_ASSERT_TRUE(buf_equal(tbuf_ref, tbuf_a,
+			    TEST_BUF_SIZE));
+		}
+	}
+}
+
+/** memset with various sizes and alignments */
+PCUT_TEST(memset_sizes)
+{
+	size_t i, j, off;
+	void *p;
+
+	for (i = 0; i < TEST_SIZES; i++) {
+		for (off = 0; off < 16; off++) {
+			size_t n = test_sizes[i];
+
+			fill_pattern(tbuf_a, TEST_BUF_SIZE, 5);
+			fill_pattern(tbuf_ref, TEST_BUF_SIZE, 5);
+			for (j = 0; j < n; j++)
+				tbuf_ref[off + j] = 0xa5;
+
+			p = memset(tbuf_a + off, 0xa5, n);
+			PCUT_ASSERT_TRUE(p == tbuf_a + off);
+			PCUT_ASSERT_TRUE(buf_equal(tbuf_ref, tbuf_a,
+			    TEST_BUF_SIZE));
+		}
+	}
+}
+
+/** memcmp detecting a difference at every position */
+PCUT_TEST(memcmp_sizes)
+{
+	size_t i, pos, off;
+	int c;
+
+	for (i = 0; i < TEST_SIZES; i++) {
+		size_t n = test_sizes[i];
+
+		for (off = 0; off < 16; off += 7) {
+			fill_pattern(tbuf_a, TEST_BUF_SIZE, 6);
+			fill_pattern(tbuf_b, TEST_BUF_SIZE, 6);
+
+			c = memcmp(tbuf_a + off, tbuf_b + off, n);
+			PCUT_ASSERT_INT_EQUALS(0, c);
+
+			for (pos = 0; pos < n; pos++) {
+				tbuf_b[off + pos] = tbuf_a[off + pos] + 1;
+				if (tbuf_b[off + pos] == 0) {
+					/* Wrapped around, b is now less */
+					c = memcmp(tbuf_a + off, tbuf_b + off, n);
+					PCUT_ASSERT_TRUE(c > 0);
+				} else {
+					c = memcmp(tbuf_a + off, tbuf_b + off, n);
+					PCUT_ASSERT_TRUE(c < 0);
+				}
+
+				tbuf_b[off + pos] = tbuf_a[off + pos];
+			}
+		}
+	}
+}
+
+/** memchr finding a byte at every position */
+PCUT_TEST(memchr_sizes)
+{
+	size_t i, pos, off;
+	void *p;
+
+	for (i = 0; i < TEST_SIZES; i++) {
+		size_t n = test_sizes[i];
+
+		for (off = 0; off < 16; off += 5) {
+			memset(tbuf_a, 'x', TEST_BUF_SIZE);
+
+			/* Not found, even if present just past the end */
+			tbuf_a[off + n] = 'y';
+			p = memchr(tbuf_a + off, 'y', n);
+			PCUT_ASSERT_TRUE(p == NULL);
+
+			/* Present just before the start */
+			if (off > 0) {
+				tbuf_a[off - 1] = 'y';
+				p = memchr(tbuf_a + off, 'y', n);
+				PCUT_ASSERT_TRUE(p == NULL);
+			}
+
+			for (pos = 0; pos < n; pos++) {
+				tbuf_a[off + pos] = 'y';
+				p = memchr(tbuf_a + off, 'y', n);
+				PCUT_ASSERT_TRUE(p == tbuf_a + off + pos);
+				tbuf_a[off + pos] = 'x';
+			}
+		}
+	}
+}
+
 PCUT_EXPORT(mem);
@@ -114,4 +114,64 @@ PCUT_TEST(str_str_empty_n)
 	PCUT_ASSERT_TRUE((const char *)p == hs);
 }
 
+PCUT_TEST(str_size)
+{
+	size_t off;
+
+	PCUT_ASSERT_INT_EQUALS(0, str_size(""));
+	PCUT_ASSERT_INT_EQUALS(7, str_size("\u010dern\u00fd"));
+
+	/* Terminator at various positions relative to alignment */
+	for (off = 0; off < 40; off++) {
+		memset(buffer, 'a', BUFFER_SIZE);
+		buffer[off + 70] = '\0';
+		PCUT_ASSERT_INT_EQUALS(70, str_size(buffer + off));
+	}
+}
+
+PCUT_TEST(str_length)
+{
+	PCUT_ASSERT_INT_EQUALS(0, str_length(""));
+	PCUT_ASSERT_INT_EQUALS(11, str_length("abracadabra"));
+	PCUT_ASSERT_INT_EQUALS(5, str_length("\u010dern\u00fd"));
+	PCUT_ASSERT_INT_EQUALS(25,
+	    str_length("long ascii prefix \u010dern\u00fd x"));
+}
+
+PCUT_TEST(str_chr)
+{
+	const char *s = "long ascii prefix \u010dern\u00fd kocour";
+	char *p;
+
+	p = str_chr(s, 'a');
+	PCUT_ASSERT_TRUE((const char *) p == s + 5);
+
+	p = str_chr(s, 'k');
+	PCUT_ASSERT_TRUE((const char *) p == s + 26);
+
+	p = str_chr(s, 0x010d);
+	PCUT_ASSERT_TRUE((const char *) p == s + 18);
+
+	p = str_chr(s, 0x00fd);
+	PCUT_ASSERT_TRUE((const char *) p == s + 23);
+
+	p = str_chr(s, 'z');
+	PCUT_ASSERT_NULL(p);
+
+	p = str_chr(s, 0x0161);
+	PCUT_ASSERT_NULL(p);
+}
+
+PCUT_TEST(str_cmp)
+{
+	PCUT_ASSERT_INT_EQUALS(0, str_cmp("", ""));
+	PCUT_ASSERT_INT_EQUALS(0, str_cmp("abc\u010d", "abc\u010d"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("abc", "abd"));
+	PCUT_ASSERT_INT_EQUALS(1, str_cmp("abd", "abc"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("ab", "abc"));
+	PCUT_ASSERT_INT_EQUALS(1, str_cmp("abc", "ab"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("abcz", "abc\u010d"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("abc\u00fd", "abc\u010d"));
+}
+
 PCUT_EXPORT(str);
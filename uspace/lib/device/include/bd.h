@@ -37,11 +37,32 @@
 
 #include <async.h>
 #include <offset.h>
+#include <time.h>
+
+/** Queue of block requests sharing a data buffer with the device */
+typedef struct bd_queue bd_queue_t;
 
 typedef struct {
 	async_sess_t *sess;
+	/** Request queue or @c NULL */
+	bd_queue_t *queue;
+	/**
+	 * Session to pass completions on to if a server forwards the request
+	 * queue of its client to this device, or @c NULL
+	 */
+	async_sess_t *ev_sess;
 } bd_t;
 
+/** Completion of a queued request */
+typedef struct {
+	/** Slot of the request */
+	unsigned slot;
+	/** Argument passed when the request was submitted */
+	void *arg;
+	/** Result of the request */
+	errno_t rc;
+} bd_completion_t;
+
 extern errno_t bd_open(async_sess_t *, bd_t **);
 extern void bd_close(bd_t *);
 extern errno_t bd_read_blocks(bd_t *, aoff64_t, size_t, void *, size_t);
@@ -50,6 +71,18 @@ extern errno_t bd_write_blocks(bd_t *, aoff64_t, size_t, const void *, size_t);
 extern errno_t bd_sync_cache(bd_t *, aoff64_t, size_t);
 extern errno_t bd_get_block_size(bd_t *, size_t *);
 extern errno_t bd_get_num_blocks(bd_t *, aoff64_t *);
+extern errno_t bd_share_in(bd_t *, size_t, void **);
+extern errno_t bd_resize(bd_t *, aoff64_t);
+
+extern errno_t bd_queue_create(bd_t *, unsigned, size_t, bd_queue_t **);
+extern void bd_queue_destroy(bd_queue_t *);
+extern void *bd_queue_slot_buf(bd_queue_t *, unsigned);
+extern size_t bd_queue_slot_size(bd_queue_t *);
+extern errno_t bd_queue_read(bd_queue_t *, unsigned, aoff64_t, size_t,
+    void *);
+extern errno_t bd_queue_write(bd_queue_t *, unsigned, aoff64_t, size_t,
+    void *);
+extern errno_t bd_queue_wait(bd_queue_t *, usec_t, bd_completion_t *);
 
 #endif
 
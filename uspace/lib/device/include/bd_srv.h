@@ -37,11 +37,13 @@
 
 #include <adt/list.h>
 #include <async.h>
+#include <bd.h>
 #include <fibril_synch.h>
 #include <stdbool.h>
 #include <offset.h>
 
 typedef struct bd_ops bd_ops_t;
+typedef struct bd_srv_queue bd_srv_queue_t;
 
 /** Service setup (per sevice) */
 typedef struct {
@@ -54,8 +56,37 @@ typedef struct {
 	bd_srvs_t *srvs;
 	async_sess_t *client_sess;
 	void *carg;
+	/** Request queue shared with the client or @c NULL */
+	bd_srv_queue_t *queue;
 } bd_srv_t;
 
+/** Type of a queued request */
+typedef enum {
+	BD_REQ_READ,
+	BD_REQ_WRITE
+} bd_req_type_t;
+
+/** Queued block request */
+typedef struct {
+	/** Link for use by the server while it serves the request */
+	link_t link;
+	/** Server structure of the client which submitted the request */
+	bd_srv_t *srv;
+	bd_req_type_t type;
+	/** Slot of the request in the client's queue */
+	unsigned slot;
+	/** Address of the first block */
+	aoff64_t ba;
+	/** Number of blocks */
+	size_t cnt;
+	/** Data buffer in the area shared with the client */
+	void *buf;
+	/** Size of @c buf in bytes, at least @c cnt blocks */
+	size_t size;
+	/** Argument for use by the server */
+	void *arg;
+} bd_req_t;
+
 struct bd_ops {
 	errno_t (*open)(bd_srvs_t *, bd_srv_t *);
 	errno_t (*close)(bd_srv_t *);
@@ -65,9 +96,30 @@ struct bd_ops {
 	errno_t (*write_blocks)(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 	errno_t (*get_block_size)(bd_srv_t *, size_t *);
 	errno_t (*get_num_blocks)(bd_srv_t *, aoff64_t *);
+	errno_t (*share_in)(bd_srv_t *, size_t, void **);
+	errno_t (*resize)(bd_srv_t *, aoff64_t);
+	/*
+	 * Optional. If set, block reads and writes are forwarded, together
+	 * with their data transfer, to the device and address returned by
+	 * fwd_begin. fwd_begin gets the size of the client buffer and must
+	 * check it against the block count. fwd_end is called once the
+	 * forwarded request finishes. Request queues are forwarded as well,
+	 * to the device returned for zero blocks, which must stay valid
+	 * until the client connection is closed.
+	 */
+	errno_t (*fwd_begin)(bd_srv_t *, aoff64_t, size_t, size_t, bd_t **,
+	    aoff64_t *);
+	void (*fwd_end)(bd_srv_t *);
+	/*
+	 * Optional. Start serving a queued request without waiting for it to
+	 * finish and call bd_req_complete() once it does. If ENOTSUP is
+	 * returned, the request is served by read_blocks or write_blocks.
+	 */
+	errno_t (*submit)(bd_srv_t *, bd_req_t *);
 };
 
 extern void bd_srvs_init(bd_srvs_t *);
+extern void bd_req_complete(bd_req_t *, errno_t);
 
 extern errno_t bd_conn(ipc_call_t *, bd_srvs_t *);
 
@@ -43,9 +43,23 @@ typedef enum {
 	BD_READ_BLOCKS,
 	BD_SYNC_CACHE,
 	BD_WRITE_BLOCKS,
-	BD_READ_TOC
+	BD_READ_TOC,
+	BD_SHARE_IN,
+	BD_RESIZE,
+	BD_QUEUE_CREATE,
+	BD_QUEUE_DESTROY,
+	BD_QUEUE_READ,
+	BD_QUEUE_WRITE
 } bd_request_t;
 
+/** Events sent to the client over the callback connection */
+typedef enum {
+	BD_EV_COMPLETE = IPC_FIRST_USER_METHOD
+} bd_event_t;
+
+/** Maximum number of slots of a request queue */
+#define BD_QUEUE_SLOTS_MAX	64
+
 #endif
 
 /** @}
@@ -75,6 +75,16 @@
 #define NIC_DEFECTIVE_BAD_TCP_CHECKSUM   0x0080
 #define NIC_DEFECTIVE_BAD_UDP_CHECKSUM   0x0100
 
+/** Offload computations, see nic_offload_probe() and nic_offload_set() */
+/** NIC completes partial TCP and UDP checksums of transmitted frames */
+#define NIC_OFFLOAD_TX_CSUM  0x0001
+/** NIC may deliver frames with a partial TCP or UDP checksum */
+#define NIC_OFFLOAD_RX_CSUM  0x0002
+/** NIC segments large TCP/IPv4 frames */
+#define NIC_OFFLOAD_TSO4     0x0004
+/** NIC may merge received TCP/IPv4 segments into frames above the MTU */
+#define NIC_OFFLOAD_LRO4     0x0008
+
 /**
  * The bitmap uses single bit for each of the 2^12 = 4096 possible VLAN tags.
  * This means its size is 4096/8 = 512 bytes.
@@ -83,6 +93,22 @@
 
 #define NIC_DEVICE_PRINT_FMT  "%x"
 
+/**
+ * Offloads requested for a single transmitted frame.
+ */
+typedef struct nic_tx_offload {
+	/**
+	 * Offset of the first byte covered by the TCP or UDP checksum, zero
+	 * if the frame carries a complete checksum. The checksum field holds
+	 * the pseudo-header sum.
+	 */
+	uint16_t csum_start;
+	/** Offset of the checksum field from @c csum_start */
+	uint16_t csum_offset;
+	/** TCP payload size of the segments, zero not to segment the frame */
+	uint16_t gso_size;
+} nic_tx_offload_t;
+
 /**
  * Structure covering the MAC address.
  */
@@ -34,10 +34,14 @@
  * @brief Block device client interface
  */
 
+#include <adt/list.h>
+#include <align.h>
+#include <as.h>
 #include <async.h>
 #include <assert.h>
 #include <bd.h>
 #include <errno.h>
+#include <fibril_synch.h>
 #include <ipc/bd.h>
 #include <ipc/services.h>
 #include <loc.h>
@@ -45,6 +49,37 @@
 #include <stdlib.h>
 #include <offset.h>
 
+/** Slot of a request queue */
+typedef struct {
+	/** Link to bd_queue_t.done */
+	link_t link;
+	/** Slot is taken by a request in flight or by its completion */
+	bool busy;
+	/** Completion to be passed to the caller */
+	bd_completion_t comp;
+} bd_queue_slot_t;
+
+struct bd_queue {
+	/** Block device */
+	bd_t *bd;
+	/** Protects the queue */
+	fibril_mutex_t lock;
+	/** Signalled when a request completes */
+	fibril_condvar_t cv;
+	/** Completed requests not yet collected (bd_queue_slot_t) */
+	list_t done;
+	/** Number of requests in flight */
+	size_t pending;
+	/** Data buffer shared with the device */
+	void *buf;
+	/** Size of the data buffer of one slot */
+	size_t slot_size;
+	/** Number of slots */
+	unsigned nslots;
+	/** Slots */
+	bd_queue_slot_t *slots;
+};
+
 static void bd_cb_conn(ipc_call_t *icall, void *arg);
 
 errno_t bd_open(async_sess_t *sess, bd_t **rbd)
@@ -195,12 +230,376 @@ errno_t bd_get_num_blocks(bd_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Map the device contents into the address space of the caller.
+ *
+ * Only supported by devices which keep their contents in memory. Blocks
+ * can then be accessed directly in the shared area, without any copying.
+ *
+ * @param bd Block device
+ * @param size Size of the device contents in bytes
+ * @param rdata Place to store the address of the shared area
+ * @return EOK on success or an error code
+ */
+errno_t bd_share_in(bd_t *bd, size_t size, void **rdata)
+{
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, BD_SHARE_IN, &answer);
+	errno_t rc = async_share_in_start_0_0(exch, ALIGN_UP(size, PAGE_SIZE),
+	    rdata);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+
+	if (retval != EOK) {
+		as_area_destroy(*rdata);
+		return retval;
+	}
+
+	return EOK;
+}
+
+/** Change the number of blocks of the device.
+ *
+ * @param bd Block device
+ * @param nblocks New number of blocks
+ * @return EOK on success or an error code
+ */
+errno_t bd_resize(bd_t *bd, aoff64_t nblocks)
+{
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+	errno_t rc = async_req_2_0(exch, BD_RESIZE, LOWER32(nblocks),
+	    UPPER32(nblocks));
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/*
+ * Request queue
+ *
+ * A client can keep many block requests in flight on a single connection
+ * by means of a request queue. The queue consists of a number of slots,
+ * each with its own part of a data buffer, which is shared with the device
+ * once, when the queue is created. A request is submitted to a free slot
+ * with bd_queue_read() or bd_queue_write(), which only send a message
+ * naming the slot and do not wait for any answer. The device transfers the
+ * data directly from or to the buffer of the slot and reports the
+ * completion over the callback connection, tagged with the slot. The
+ * completions are collected by bd_queue_wait() in the order in which the
+ * requests finish.
+ *
+ * Example:
+ * @code
+ * 	rc = bd_queue_create(bd, 2, 65536, &queue);
+ * 	rc = bd_queue_read(queue, 0, ba, cnt, NULL);
+ * 	memcpy(bd_queue_slot_buf(queue, 1), data, size);
+ * 	rc = bd_queue_write(queue, 1, ba2, cnt2, NULL);
+ * 	while (bd_queue_wait(queue, 0, &comp) == EOK)
+ * 		process(comp.slot, comp.rc);
+ * 	bd_queue_destroy(queue);
+ * @endcode
+ */
+
+/** Create a request queue.
+ *
+ * Only one queue can exist per block device.
+ *
+ * @param bd Block device
+ * @param nslots Number of slots, at most @c BD_QUEUE_SLOTS_MAX
+ * @param slot_size Minimum size of the data buffer of one slot
+ * @param rqueue Place to store pointer to the new queue
+ * @return EOK on success, ENOTSUP if the device does not support request
+ *         queues or an error code
+ */
+errno_t bd_queue_create(bd_t *bd, unsigned nslots, size_t slot_size,
+    bd_queue_t **rqueue)
+{
+	bd_queue_t *queue;
+	errno_t rc;
+
+	if (nslots == 0 || nslots > BD_QUEUE_SLOTS_MAX || slot_size == 0)
+		return EINVAL;
+
+	if (bd->queue != NULL)
+		return EBUSY;
+
+	/* Keep the buffer of each slot page-aligned */
+	slot_size = ALIGN_UP(slot_size, PAGE_SIZE);
+	if (slot_size > SIZE_MAX / nslots)
+		return EINVAL;
+
+	queue = calloc(1, sizeof(bd_queue_t));
+	if (queue == NULL)
+		return ENOMEM;
+
+	queue->slots = calloc(nslots, sizeof(bd_queue_slot_t));
+	if (queue->slots == NULL) {
+		free(queue);
+		return ENOMEM;
+	}
+
+	queue->bd = bd;
+	fibril_mutex_initialize(&queue->lock);
+	fibril_condvar_initialize(&queue->cv);
+	list_initialize(&queue->done);
+	queue->slot_size = slot_size;
+	queue->nslots = nslots;
+
+	for (unsigned i = 0; i < nslots; i++) {
+		link_initialize(&queue->slots[i].link);
+		queue->slots[i].comp.slot = i;
+	}
+
+	queue->buf = as_area_create(AS_AREA_ANY, nslots * slot_size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (queue->buf == AS_MAP_FAILED) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_2(exch, BD_QUEUE_CREATE, nslots, slot_size,
+	    &answer);
+	rc = async_share_out_start(exch, queue->buf, AS_AREA_READ |
+	    AS_AREA_WRITE);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		goto error;
+	}
+
+	async_wait_for(req, &rc);
+	if (rc != EOK)
+		goto error;
+
+	bd->queue = queue;
+	*rqueue = queue;
+	return EOK;
+error:
+	if (queue->buf != AS_MAP_FAILED)
+		as_area_destroy(queue->buf);
+	free(queue->slots);
+	free(queue);
+	return rc;
+}
+
+/** Destroy a request queue.
+ *
+ * Waits for the requests still in flight and discards all completions
+ * not collected yet.
+ *
+ * @param queue Request queue
+ */
+void bd_queue_destroy(bd_queue_t *queue)
+{
+	bd_t *bd = queue->bd;
+
+	fibril_mutex_lock(&queue->lock);
+	while (queue->pending > 0)
+		fibril_condvar_wait(&queue->cv, &queue->lock);
+	fibril_mutex_unlock(&queue->lock);
+
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+	(void) async_req_0_0(exch, BD_QUEUE_DESTROY);
+	async_exchange_end(exch);
+
+	bd->queue = NULL;
+	as_area_destroy(queue->buf);
+	free(queue->slots);
+	free(queue);
+}
+
+/** Get the data buffer of a slot.
+ *
+ * @param queue Request queue
+ * @param slot Slot number
+ * @return Data buffer of the slot, bd_queue_slot_size() bytes long
+ */
+void *bd_queue_slot_buf(bd_queue_t *queue, unsigned slot)
+{
+	assert(slot < queue->nslots);
+	return (uint8_t *) queue->buf + slot * queue->slot_size;
+}
+
+/** Get the size of the data buffer of a slot.
+ *
+ * @param queue Request queue
+ * @return Size of the data buffer of a slot in bytes
+ */
+size_t bd_queue_slot_size(bd_queue_t *queue)
+{
+	return queue->slot_size;
+}
+
+/** Submit a queued request.
+ *
+ * @param queue Request queue
+ * @param method BD_QUEUE_READ or BD_QUEUE_WRITE
+ * @param slot Free slot, whose buffer holds the data
+ * @param ba Address of the first block
+ * @param cnt Number of blocks
+ * @param arg Argument passed back in the completion
+ * @return EOK on success, EBUSY if the slot is not free or an error code
+ */
+static errno_t bd_queue_submit(bd_queue_t *queue, sysarg_t method,
+    unsigned slot, aoff64_t ba, size_t cnt, void *arg)
+{
+	if (slot >= queue->nslots)
+		return EINVAL;
+
+	bd_queue_slot_t *s = &queue->slots[slot];
+
+	fibril_mutex_lock(&queue->lock);
+	if (s->busy) {
+		fibril_mutex_unlock(&queue->lock);
+		return EBUSY;
+	}
+
+	s->busy = true;
+	s->comp.arg = arg;
+	s->comp.rc = EOK;
+	queue->pending++;
+	fibril_mutex_unlock(&queue->lock);
+
+	async_exch_t *exch = async_exchange_begin(queue->bd->sess);
+	async_msg_4(exch, method, slot, LOWER32(ba), UPPER32(ba), cnt);
+	async_exchange_end(exch);
+
+	return EOK;
+}
+
+/** Submit a queued read.
+ *
+ * The function returns without waiting for the data, which is stored
+ * to the buffer of the slot. The slot stays taken until the completion
+ * is collected by bd_queue_wait().
+ *
+ * @param queue Request queue
+ * @param slot Free slot
+ * @param ba Address of the first block
+ * @param cnt Number of blocks, which must fit into the buffer of the slot
+ * @param arg Argument passed back in the completion
+ * @return EOK on success, EBUSY if the slot is not free or an error code
+ */
+errno_t bd_queue_read(bd_queue_t *queue, unsigned slot, aoff64_t ba,
+    size_t cnt, void *arg)
+{
+	return bd_queue_submit(queue, BD_QUEUE_READ, slot, ba, cnt, arg);
+}
+
+/** Submit a queued write.
+ *
+ * The data is taken from the buffer of the slot, which must not be
+ * modified until the request completes.
+ *
+ * @param queue Request queue
+ * @param slot Free slot
+ * @param ba Address of the first block
+ * @param cnt Number of blocks, which must fit into the buffer of the slot
+ * @param arg Argument passed back in the completion
+ * @return EOK on success, EBUSY if the slot is not free or an error code
+ */
+errno_t bd_queue_write(bd_queue_t *queue, unsigned slot, aoff64_t ba,
+    size_t cnt, void *arg)
+{
+	return bd_queue_submit(queue, BD_QUEUE_WRITE, slot, ba, cnt, arg);
+}
+
+/** Wait for completion of a queued request.
+ *
+ * Requests are completed in the order in which they finish, which need not
+ * be the order of submission. The slot of the returned request is free
+ * again.
+ *
+ * @param queue Request queue
+ * @param timeout Timeout in microseconds, zero to wait indefinitely
+ * @param[out] comp Place to store the completion
+ *
+ * @return EOK on success, ENOENT if there are no requests to wait for,
+ *         ETIMEOUT if no request completed within @a timeout
+ */
+errno_t bd_queue_wait(bd_queue_t *queue, usec_t timeout,
+    bd_completion_t *comp)
+{
+	fibril_mutex_lock(&queue->lock);
+
+	while (list_empty(&queue->done)) {
+		if (queue->pending == 0) {
+			fibril_mutex_unlock(&queue->lock);
+			return ENOENT;
+		}
+
+		errno_t rc = fibril_condvar_wait_timeout(&queue->cv,
+		    &queue->lock, timeout);
+		if (rc == ETIMEOUT) {
+			fibril_mutex_unlock(&queue->lock);
+			return ETIMEOUT;
+		}
+	}
+
+	bd_queue_slot_t *s = list_get_instance(list_first(&queue->done),
+	    bd_queue_slot_t, link);
+	list_remove(&s->link);
+	*comp = s->comp;
+	s->busy = false;
+
+	fibril_mutex_unlock(&queue->lock);
+	return EOK;
+}
+
+/** Handle completion of a queued request reported by the device. */
+static void bd_ev_complete(bd_t *bd, ipc_call_t *call)
+{
+	bd_queue_t *queue = bd->queue;
+	unsigned slot = ipc_get_arg1(call);
+	errno_t rc = (errno_t) ipc_get_arg2(call);
+
+	async_answer_0(call, EOK);
+
+	/* A server forwarding the queue of its client passes it on */
+	async_sess_t *ev_sess = bd->ev_sess;
+	if (ev_sess != NULL) {
+		async_exch_t *exch = async_exchange_begin(ev_sess);
+		async_msg_2(exch, BD_EV_COMPLETE, slot, (sysarg_t) rc);
+		async_exchange_end(exch);
+		return;
+	}
+
+	if (queue == NULL || slot >= queue->nslots)
+		return;
+
+	bd_queue_slot_t *s = &queue->slots[slot];
+
+	fibril_mutex_lock(&queue->lock);
+
+	/* Ignore a completion of a request which is not in flight */
+	if (!s->busy || link_used(&s->link)) {
+		fibril_mutex_unlock(&queue->lock);
+		return;
+	}
+
+	s->comp.rc = rc;
+	list_append(&s->link, &queue->done);
+	queue->pending--;
+	fibril_condvar_broadcast(&queue->cv);
+	fibril_mutex_unlock(&queue->lock);
+}
+
 static void bd_cb_conn(ipc_call_t *icall, void *arg)
 {
 	bd_t *bd = (bd_t *)arg;
 
-	(void)bd;
-
 	while (true) {
 		ipc_call_t call;
 		async_get_call(&call);
@@ -211,6 +610,9 @@ static void bd_cb_conn(ipc_call_t *icall, void *arg)
 		}
 
 		switch (ipc_get_imethod(&call)) {
+		case BD_EV_COMPLETE:
+			bd_ev_complete(bd, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 		}
@@ -33,7 +33,11 @@
  * @file
  * @brief Block device server stub
  */
+#include <adt/list.h>
+#include <as.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <ipc/bd.h>
 #include <macros.h>
 #include <stdlib.h>
@@ -42,6 +46,130 @@
 
 #include <bd_srv.h>
 
+/** Request queue shared with a client */
+struct bd_srv_queue {
+	/** Protects the queue */
+	fibril_mutex_t lock;
+	/** Signalled when a request is added or completed */
+	fibril_condvar_t cv;
+	/** Requests waiting to be served by the worker (bd_req_t) */
+	list_t pending;
+	/** Number of requests not completed yet */
+	size_t active;
+	/** Data buffer shared with the client */
+	void *buf;
+	/** Size of the data buffer of one slot */
+	size_t slot_size;
+	/** Number of slots */
+	unsigned nslots;
+	/** Block size of the device */
+	size_t bsize;
+	/** The worker fibril is running */
+	bool worker;
+	/** The worker fibril should exit */
+	bool quit;
+	/** Device the queue is forwarded to or @c NULL */
+	bd_t *fwd;
+};
+
+/** Forward a received data transfer to the device provided by the server.
+ *
+ * @param bd     Device to forward to
+ * @param method Request the data transfer belongs to
+ * @param arg1   First argument of the request
+ * @param arg2   Second argument of the request
+ * @param arg3   Third argument of the request
+ * @param dcall  Received data read, data write or share out call
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t bd_fwd_data(bd_t *bd, sysarg_t method, sysarg_t arg1,
+    sysarg_t arg2, sysarg_t arg3, ipc_call_t *dcall)
+{
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	aid_t req = async_send_3(exch, method, arg1, arg2, arg3, NULL);
+	if (req == 0) {
+		async_exchange_end(exch);
+		async_answer_0(dcall, ENOMEM);
+		return ENOMEM;
+	}
+
+	/* If forwarding fails, the data call is answered by the kernel. */
+	errno_t rc = async_forward_0(dcall, exch, 0, IPC_FF_ROUTE_FROM_ME);
+	if (rc != EOK) {
+		async_forget(req);
+		async_exchange_end(exch);
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+	async_exchange_end(exch);
+	return rc;
+}
+
+/** Forward block read to the device provided by the server.
+ *
+ * The data transfer is forwarded as well, so the data moves directly
+ * between the client and the device the server translated the request to.
+ */
+static void bd_read_blocks_fwd(bd_srv_t *srv, ipc_call_t *call, aoff64_t ba,
+    size_t cnt)
+{
+	ipc_call_t rcall;
+	size_t size;
+	bd_t *bd;
+	aoff64_t fba;
+	errno_t rc;
+
+	if (!async_data_read_receive(&rcall, &size)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	rc = srv->srvs->ops->fwd_begin(srv, ba, cnt, size, &bd, &fba);
+	if (rc != EOK) {
+		async_answer_0(&rcall, rc);
+		async_answer_0(call, rc);
+		return;
+	}
+
+	rc = bd_fwd_data(bd, BD_READ_BLOCKS, LOWER32(fba), UPPER32(fba), cnt,
+	    &rcall);
+
+	srv->srvs->ops->fwd_end(srv);
+	async_answer_0(call, rc);
+}
+
+/** Forward block write to the device provided by the server. */
+static void bd_write_blocks_fwd(bd_srv_t *srv, ipc_call_t *call, aoff64_t ba,
+    size_t cnt)
+{
+	ipc_call_t wcall;
+	size_t size;
+	bd_t *bd;
+	aoff64_t fba;
+	errno_t rc;
+
+	if (!async_data_write_receive(&wcall, &size)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	rc = srv->srvs->ops->fwd_begin(srv, ba, cnt, size, &bd, &fba);
+	if (rc != EOK) {
+		async_answer_0(&wcall, rc);
+		async_answer_0(call, rc);
+		return;
+	}
+
+	rc = bd_fwd_data(bd, BD_WRITE_BLOCKS, LOWER32(fba), UPPER32(fba), cnt,
+	    &wcall);
+
+	srv->srvs->ops->fwd_end(srv);
+	async_answer_0(call, rc);
+}
+
 static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 {
 	aoff64_t ba;
@@ -53,6 +181,11 @@ static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
 	cnt = ipc_get_arg3(call);
 
+	if (srv->srvs->ops->fwd_begin != NULL) {
+		bd_read_blocks_fwd(srv, call, ba, cnt);
+		return;
+	}
+
 	ipc_call_t rcall;
 	if (!async_data_read_receive(&rcall, &size)) {
 		async_answer_0(call, EINVAL);
@@ -159,6 +292,11 @@ static void bd_write_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
 	cnt = ipc_get_arg3(call);
 
+	if (srv->srvs->ops->fwd_begin != NULL) {
+		bd_write_blocks_fwd(srv, call, ba, cnt);
+		return;
+	}
+
 	rc = async_data_write_accept(&data, false, 0, 0, 0, &size);
 	if (rc != EOK) {
 		async_answer_0(call, rc);
@@ -203,6 +341,416 @@ static void bd_get_num_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	async_answer_2(call, rc, LOWER32(num_blocks), UPPER32(num_blocks));
 }
 
+static void bd_share_in_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	ipc_call_t scall;
+	size_t size;
+	void *data;
+	errno_t rc;
+
+	if (!async_share_in_receive(&scall, &size)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (srv->srvs->ops->share_in == NULL) {
+		async_answer_0(&scall, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	rc = srv->srvs->ops->share_in(srv, size, &data);
+	if (rc != EOK) {
+		async_answer_0(&scall, rc);
+		async_answer_0(call, rc);
+		return;
+	}
+
+	rc = async_share_in_finalize(&scall, data, AS_AREA_READ | AS_AREA_WRITE);
+	async_answer_0(call, rc);
+}
+
+static void bd_resize_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	aoff64_t nblocks;
+	errno_t rc;
+
+	nblocks = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
+
+	if (srv->srvs->ops->resize == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	rc = srv->srvs->ops->resize(srv, nblocks);
+	async_answer_0(call, rc);
+}
+
+/** Complete a queued request.
+ *
+ * Reports the result to the client and frees the request.
+ *
+ * @param req Request
+ * @param rc Result of the request
+ */
+void bd_req_complete(bd_req_t *req, errno_t rc)
+{
+	bd_srv_t *srv = req->srv;
+	bd_srv_queue_t *queue = srv->queue;
+
+	async_exch_t *exch = async_exchange_begin(srv->client_sess);
+	async_msg_2(exch, BD_EV_COMPLETE, req->slot, (sysarg_t) rc);
+	async_exchange_end(exch);
+
+	free(req);
+
+	fibril_mutex_lock(&queue->lock);
+	queue->active--;
+	fibril_condvar_broadcast(&queue->cv);
+	fibril_mutex_unlock(&queue->lock);
+}
+
+/** Worker fibril serving queued requests with read_blocks/write_blocks.
+ *
+ * Serves the requests which the server does not start by itself, one at
+ * a time, so that the connection fibril is free to accept more requests.
+ */
+static errno_t bd_srv_queue_worker(void *arg)
+{
+	bd_srv_t *srv = (bd_srv_t *) arg;
+	bd_srv_queue_t *queue = srv->queue;
+	bd_ops_t *ops = srv->srvs->ops;
+	errno_t rc;
+
+	fibril_mutex_lock(&queue->lock);
+
+	while (true) {
+		if (list_empty(&queue->pending)) {
+			if (queue->quit)
+				break;
+			fibril_condvar_wait(&queue->cv, &queue->lock);
+			continue;
+		}
+
+		bd_req_t *req = list_get_instance(list_first(&queue->pending),
+		    bd_req_t, link);
+		list_remove(&req->link);
+		fibril_mutex_unlock(&queue->lock);
+
+		if (req->type == BD_REQ_READ) {
+			rc = ops->read_blocks != NULL ?
+			    ops->read_blocks(srv, req->ba, req->cnt, req->buf,
+			    req->size) : ENOTSUP;
+		} else {
+			rc = ops->write_blocks != NULL ?
+			    ops->write_blocks(srv, req->ba, req->cnt, req->buf,
+			    req->size) : ENOTSUP;
+		}
+
+		bd_req_complete(req, rc);
+		fibril_mutex_lock(&queue->lock);
+	}
+
+	queue->worker = false;
+	fibril_condvar_broadcast(&queue->cv);
+	fibril_mutex_unlock(&queue->lock);
+	return EOK;
+}
+
+/** Destroy the request queue of a client.
+ *
+ * Waits for the requests in flight to complete.
+ */
+static void bd_srv_queue_destroy(bd_srv_t *srv)
+{
+	bd_srv_queue_t *queue = srv->queue;
+
+	if (queue->fwd != NULL) {
+		/* The device waits for the requests in flight */
+		async_exch_t *exch = async_exchange_begin(queue->fwd->sess);
+		(void) async_req_0_0(exch, BD_QUEUE_DESTROY);
+		async_exchange_end(exch);
+
+		queue->fwd->ev_sess = NULL;
+		srv->queue = NULL;
+		free(queue);
+		return;
+	}
+
+	fibril_mutex_lock(&queue->lock);
+	queue->quit = true;
+	fibril_condvar_broadcast(&queue->cv);
+	while (queue->active > 0 || queue->worker)
+		fibril_condvar_wait(&queue->cv, &queue->lock);
+	fibril_mutex_unlock(&queue->lock);
+
+	srv->queue = NULL;
+	as_area_destroy(queue->buf);
+	free(queue);
+}
+
+/** Forward creation of a request queue to the device provided by the server.
+ *
+ * The buffer is shared directly with the device. Queued requests are then
+ * translated and passed on to the device, which reports the completions
+ * to the client through the bd_t of the server.
+ */
+static void bd_queue_create_fwd(bd_srv_t *srv, ipc_call_t *call,
+    ipc_call_t *scall, unsigned nslots, size_t slot_size, size_t bsize)
+{
+	bd_srv_queue_t *queue;
+	bd_t *bd;
+	aoff64_t fba;
+	errno_t rc;
+
+	/* Zero blocks only look up the device */
+	rc = srv->srvs->ops->fwd_begin(srv, 0, 0, 0, &bd, &fba);
+	if (rc != EOK) {
+		async_answer_0(scall, rc);
+		async_answer_0(call, rc);
+		return;
+	}
+
+	/* Completions can only be passed on to a single client */
+	if (bd->queue != NULL || bd->ev_sess != NULL) {
+		rc = EBUSY;
+		goto error;
+	}
+
+	queue = calloc(1, sizeof(bd_srv_queue_t));
+	if (queue == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	fibril_mutex_initialize(&queue->lock);
+	fibril_condvar_initialize(&queue->cv);
+	list_initialize(&queue->pending);
+	queue->slot_size = slot_size;
+	queue->nslots = nslots;
+	queue->bsize = bsize;
+	queue->fwd = bd;
+
+	bd->ev_sess = srv->client_sess;
+
+	rc = bd_fwd_data(bd, BD_QUEUE_CREATE, nslots, slot_size, 0, scall);
+	srv->srvs->ops->fwd_end(srv);
+
+	if (rc != EOK) {
+		bd->ev_sess = NULL;
+		free(queue);
+		async_answer_0(call, rc);
+		return;
+	}
+
+	srv->queue = queue;
+	async_answer_0(call, EOK);
+	return;
+error:
+	srv->srvs->ops->fwd_end(srv);
+	async_answer_0(scall, rc);
+	async_answer_0(call, rc);
+}
+
+static void bd_queue_create_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	bd_srv_queue_t *queue;
+	ipc_call_t scall;
+	unsigned nslots;
+	size_t slot_size;
+	size_t bsize;
+	size_t size;
+	unsigned flags;
+	errno_t rc;
+
+	nslots = ipc_get_arg1(call);
+	slot_size = ipc_get_arg2(call);
+
+	if (!async_share_out_receive(&scall, &size, &flags)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (srv->srvs->ops->get_block_size == NULL) {
+		rc = ENOTSUP;
+		goto error;
+	}
+
+	if (srv->queue != NULL) {
+		rc = EBUSY;
+		goto error;
+	}
+
+	if (nslots == 0 || nslots > BD_QUEUE_SLOTS_MAX || slot_size == 0 ||
+	    slot_size > size / nslots) {
+		rc = EINVAL;
+		goto error;
+	}
+
+	rc = srv->srvs->ops->get_block_size(srv, &bsize);
+	if (rc != EOK)
+		goto error;
+
+	if (srv->srvs->ops->fwd_begin != NULL) {
+		bd_queue_create_fwd(srv, call, &scall, nslots, slot_size,
+		    bsize);
+		return;
+	}
+
+	queue = calloc(1, sizeof(bd_srv_queue_t));
+	if (queue == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	fibril_mutex_initialize(&queue->lock);
+	fibril_condvar_initialize(&queue->cv);
+	list_initialize(&queue->pending);
+	queue->slot_size = slot_size;
+	queue->nslots = nslots;
+	queue->bsize = bsize;
+
+	fid_t fid = fibril_create(bd_srv_queue_worker, srv);
+	if (fid == 0) {
+		free(queue);
+		rc = ENOMEM;
+		goto error;
+	}
+
+	rc = async_share_out_finalize(&scall, &queue->buf);
+	if (rc != EOK || queue->buf == AS_MAP_FAILED) {
+		fibril_destroy(fid);
+		free(queue);
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+
+	srv->queue = queue;
+	queue->worker = true;
+	fibril_add_ready(fid);
+
+	async_answer_0(call, EOK);
+	return;
+error:
+	async_answer_0(&scall, rc);
+	async_answer_0(call, rc);
+}
+
+static void bd_queue_destroy_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	if (srv->queue == NULL) {
+		async_answer_0(call, ENOENT);
+		return;
+	}
+
+	bd_srv_queue_destroy(srv);
+	async_answer_0(call, EOK);
+}
+
+/** Forward a queued request to the device provided by the server.
+ *
+ * The device reports the completion, which is passed on to the client.
+ */
+static void bd_queue_rw_fwd(bd_srv_t *srv, bd_req_type_t type,
+    unsigned slot, aoff64_t ba, size_t cnt)
+{
+	bd_srv_queue_t *queue = srv->queue;
+	async_exch_t *exch;
+	bd_t *bd;
+	aoff64_t fba;
+	errno_t rc;
+
+	if (cnt > queue->slot_size / queue->bsize) {
+		rc = EINVAL;
+	} else {
+		rc = srv->srvs->ops->fwd_begin(srv, ba, cnt,
+		    cnt * queue->bsize, &bd, &fba);
+	}
+
+	if (rc != EOK) {
+		exch = async_exchange_begin(srv->client_sess);
+		async_msg_2(exch, BD_EV_COMPLETE, slot, (sysarg_t) rc);
+		async_exchange_end(exch);
+		return;
+	}
+
+	exch = async_exchange_begin(queue->fwd->sess);
+	async_msg_4(exch, type == BD_REQ_READ ? BD_QUEUE_READ : BD_QUEUE_WRITE,
+	    slot, LOWER32(fba), UPPER32(fba), cnt);
+	async_exchange_end(exch);
+
+	srv->srvs->ops->fwd_end(srv);
+}
+
+static void bd_queue_rw_srv(bd_srv_t *srv, ipc_call_t *call,
+    bd_req_type_t type)
+{
+	bd_srv_queue_t *queue = srv->queue;
+	bd_req_t *req;
+	unsigned slot;
+	aoff64_t ba;
+	size_t cnt;
+	errno_t rc;
+
+	slot = ipc_get_arg1(call);
+	ba = MERGE_LOUP32(ipc_get_arg2(call), ipc_get_arg3(call));
+	cnt = ipc_get_arg4(call);
+
+	/* The request is a message, the result is reported separately */
+	async_answer_0(call, EOK);
+
+	/* Without a valid slot the completion could not be reported */
+	if (queue == NULL || slot >= queue->nslots)
+		return;
+
+	if (queue->fwd != NULL) {
+		bd_queue_rw_fwd(srv, type, slot, ba, cnt);
+		return;
+	}
+
+	req = calloc(1, sizeof(bd_req_t));
+	if (req == NULL) {
+		async_exch_t *exch = async_exchange_begin(srv->client_sess);
+		async_msg_2(exch, BD_EV_COMPLETE, slot, (sysarg_t) ENOMEM);
+		async_exchange_end(exch);
+		return;
+	}
+
+	link_initialize(&req->link);
+	req->srv = srv;
+	req->type = type;
+	req->slot = slot;
+	req->ba = ba;
+	req->cnt = cnt;
+	req->buf = (uint8_t *) queue->buf + slot * queue->slot_size;
+	req->size = queue->slot_size;
+
+	fibril_mutex_lock(&queue->lock);
+	queue->active++;
+	fibril_mutex_unlock(&queue->lock);
+
+	if (cnt > queue->slot_size / queue->bsize) {
+		bd_req_complete(req, EINVAL);
+		return;
+	}
+
+	if (srv->srvs->ops->submit != NULL) {
+		rc = srv->srvs->ops->submit(srv, req);
+		if (rc == EOK)
+			return;
+
+		if (rc != ENOTSUP) {
+			bd_req_complete(req, rc);
+			return;
+		}
+	}
+
+	fibril_mutex_lock(&queue->lock);
+	list_append(&req->link, &queue->pending);
+	fibril_condvar_broadcast(&queue->cv);
+	fibril_mutex_unlock(&queue->lock);
+}
+
 static bd_srv_t *bd_srv_create(bd_srvs_t *srvs)
 {
 	bd_srv_t *srv;
@@ -273,11 +821,32 @@ errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
 		case BD_GET_NUM_BLOCKS:
 			bd_get_num_blocks_srv(srv, &call);
 			break;
+		case BD_SHARE_IN:
+			bd_share_in_srv(srv, &call);
+			break;
+		case BD_RESIZE:
+			bd_resize_srv(srv, &call);
+			break;
+		case BD_QUEUE_CREATE:
+			bd_queue_create_srv(srv, &call);
+			break;
+		case BD_QUEUE_DESTROY:
+			bd_queue_destroy_srv(srv, &call);
+			break;
+		case BD_QUEUE_READ:
+			bd_queue_rw_srv(srv, &call, BD_REQ_READ);
+			break;
+		case BD_QUEUE_WRITE:
+			bd_queue_rw_srv(srv, &call, BD_REQ_WRITE);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
 	}
 
+	if (srv->queue != NULL)
+		bd_srv_queue_destroy(srv);
+
 	rc = srvs->ops->close(srv);
 	free(srv);
 
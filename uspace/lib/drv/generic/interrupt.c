@@ -54,6 +54,17 @@ errno_t unregister_interrupt_handler(ddf_dev_t *dev, cap_irq_handle_t handle)
 	return async_irq_unsubscribe(handle);
 }
 
+/** Merge interrupts into pending notifications.
+ *
+ * Up to @a limit interrupts arriving before the handler gets to run are
+ * delivered as a single call with the payloads or-ed together.
+ */
+errno_t set_interrupt_coalescing(ddf_dev_t *dev, cap_irq_handle_t handle,
+    size_t limit)
+{
+	return async_irq_coalesce(handle, limit);
+}
+
 /**
  * @}
  */
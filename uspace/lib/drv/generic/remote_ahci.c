@@ -140,8 +140,21 @@ errno_t ahci_get_block_size(async_sess_t *sess, size_t *blocks_size)
 	return rc;
 }
 
+/** Read blocks from a SATA device.
+ *
+ * The exchange is kept until the driver answers, so requests sent by
+ * several fibrils are served by the driver concurrently.
+ *
+ * @param sess     Session to the AHCI function.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks.
+ * @param buf      Buffer for the data.
+ * @param size     Size of the buffer, at most DATA_XFER_LIMIT.
+ *
+ * @return EOK on success or an error code.
+ */
 errno_t ahci_read_blocks(async_sess_t *sess, uint64_t blocknum, size_t count,
-    void *buf)
+    void *buf, size_t size)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
 	if (!exch)
@@ -151,18 +164,32 @@ errno_t ahci_read_blocks(async_sess_t *sess, uint64_t blocknum, size_t count,
 	req = async_send_4(exch, DEV_IFACE_ID(AHCI_DEV_IFACE),
 	    IPC_M_AHCI_READ_BLOCKS, HI(blocknum),  LO(blocknum), count, NULL);
 
-	async_share_out_start(exch, buf, AS_AREA_READ | AS_AREA_WRITE);
+	errno_t rc = async_data_read_start(exch, buf, size);
 
 	async_exchange_end(exch);
 
-	errno_t rc;
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
 	async_wait_for(req, &rc);
 
 	return rc;
 }
 
+/** Write blocks to a SATA device.
+ *
+ * @param sess     Session to the AHCI function.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks.
+ * @param buf      Buffer with the data.
+ * @param size     Size of the buffer, at most DATA_XFER_LIMIT.
+ *
+ * @return EOK on success or an error code.
+ */
 errno_t ahci_write_blocks(async_sess_t *sess, uint64_t blocknum, size_t count,
-    void *buf)
+    const void *buf, size_t size)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
 	if (!exch)
@@ -171,12 +198,16 @@ errno_t ahci_write_blocks(async_sess_t *sess, uint64_t blocknum, size_t count,
 	aid_t req = async_send_4(exch, DEV_IFACE_ID(AHCI_DEV_IFACE),
 	    IPC_M_AHCI_WRITE_BLOCKS, HI(blocknum),  LO(blocknum), count, NULL);
 
-	async_share_out_start(exch, buf, AS_AREA_READ | AS_AREA_WRITE);
-
-	async_exchange_end(exch);
+	errno_t rc = async_data_write_start(exch, buf, size);
+	if (rc != EOK) {
+		async_exchange_end(exch);
+		async_forget(req);
+		return rc;
+	}
 
-	errno_t rc;
+	/* Keep the exchange so that the driver handles us in parallel. */
 	async_wait_for(req, &rc);
+	async_exchange_end(exch);
 
 	return rc;
 }
@@ -284,47 +315,99 @@ void remote_ahci_read_blocks(ddf_fun_t *fun, void *iface, ipc_call_t *call)
 	}
 
 	ipc_call_t data;
-	size_t maxblock_size;
-	unsigned int flags;
-	async_share_out_receive(&data, &maxblock_size, &flags);
+	size_t size;
+	if (!async_data_read_receive(&data, &size)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
 
-	void *buf;
-	async_share_out_finalize(&data, &buf);
+	if (size > DATA_XFER_LIMIT) {
+		async_answer_0(&data, ELIMIT);
+		async_answer_0(call, ELIMIT);
+		return;
+	}
 
 	const uint64_t blocknum =
 	    (((uint64_t) (DEV_IPC_GET_ARG1(*call))) << 32) |
 	    (((uint64_t) (DEV_IPC_GET_ARG2(*call))) & 0xffffffff);
 	const size_t cnt = (size_t) DEV_IPC_GET_ARG3(*call);
 
-	const errno_t ret = ahci_iface->read_blocks(fun, blocknum, cnt, buf);
+	/*
+	 * The buffer is sized by the client, so it must be checked against
+	 * the block count before the driver fills it. The count is not
+	 * trusted either, hence the division instead of a multiplication.
+	 */
+	size_t block_size;
+	errno_t ret;
+	if (ahci_iface->get_block_size == NULL)
+		ret = ENOTSUP;
+	else
+		ret = ahci_iface->get_block_size(fun, &block_size);
 
-	async_answer_0(call, ret);
+	if ((ret == EOK) &&
+	    ((block_size == 0) || (cnt > size / block_size)))
+		ret = EINVAL;
+
+	void *buf = NULL;
+	if (ret == EOK) {
+		buf = malloc(size);
+		if (buf == NULL)
+			ret = ENOMEM;
+	}
+
+	if (ret == EOK)
+		ret = ahci_iface->read_blocks(fun, blocknum, cnt, buf);
+
+	if (ret != EOK) {
+		async_answer_0(&data, ret);
+		async_answer_0(call, ret);
+		free(buf);
+		return;
+	}
+
+	async_data_read_finalize(&data, buf, size);
+	free(buf);
+
+	async_answer_0(call, EOK);
 }
 
 void remote_ahci_write_blocks(ddf_fun_t *fun, void *iface, ipc_call_t *call)
 {
 	const ahci_iface_t *ahci_iface = (ahci_iface_t *) iface;
 
-	if (ahci_iface->read_blocks == NULL) {
+	if (ahci_iface->write_blocks == NULL) {
 		async_answer_0(call, ENOTSUP);
 		return;
 	}
 
-	ipc_call_t data;
-	size_t maxblock_size;
-	unsigned int flags;
-	async_share_out_receive(&data, &maxblock_size, &flags);
-
 	void *buf;
-	async_share_out_finalize(&data, &buf);
+	size_t size;
+	errno_t ret = async_data_write_accept(&buf, false, 0, DATA_XFER_LIMIT,
+	    0, &size);
+	if (ret != EOK) {
+		async_answer_0(call, ret);
+		return;
+	}
 
 	const uint64_t blocknum =
 	    (((uint64_t)(DEV_IPC_GET_ARG1(*call))) << 32) |
 	    (((uint64_t)(DEV_IPC_GET_ARG2(*call))) & 0xffffffff);
 	const size_t cnt = (size_t) DEV_IPC_GET_ARG3(*call);
 
-	const errno_t ret = ahci_iface->write_blocks(fun, blocknum, cnt, buf);
+	size_t block_size;
+	if (ahci_iface->get_block_size == NULL)
+		ret = ENOTSUP;
+	else
+		ret = ahci_iface->get_block_size(fun, &block_size);
+
+	if ((ret == EOK) &&
+	    ((block_size == 0) || (cnt > size / block_size)))
+		ret = EINVAL;
+
+	if (ret == EOK)
+		ret = ahci_iface->write_blocks(fun, blocknum, cnt, buf);
 
+	free(buf);
 	async_answer_0(call, ret);
 }
 
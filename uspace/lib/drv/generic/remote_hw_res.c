@@ -46,6 +46,8 @@ static void remote_hw_res_disable_interrupt(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_hw_res_clear_interrupt(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_hw_res_dma_channel_setup(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_hw_res_dma_channel_remain(ddf_fun_t *, void *, ipc_call_t *);
+static void remote_hw_res_enable_msi(ddf_fun_t *, void *, ipc_call_t *);
+static void remote_hw_res_disable_msi(ddf_fun_t *, void *, ipc_call_t *);
 
 static const remote_iface_func_ptr_t remote_hw_res_iface_ops [] = {
 	[HW_RES_GET_RESOURCE_LIST] = &remote_hw_res_get_resource_list,
@@ -54,6 +56,8 @@ static const remote_iface_func_ptr_t remote_hw_res_iface_ops [] = {
 	[HW_RES_CLEAR_INTERRUPT] = &remote_hw_res_clear_interrupt,
 	[HW_RES_DMA_CHANNEL_SETUP] = &remote_hw_res_dma_channel_setup,
 	[HW_RES_DMA_CHANNEL_REMAIN] = &remote_hw_res_dma_channel_remain,
+	[HW_RES_ENABLE_MSI] = &remote_hw_res_enable_msi,
+	[HW_RES_DISABLE_MSI] = &remote_hw_res_disable_msi,
 };
 
 const remote_iface_t remote_hw_res_iface = {
@@ -170,6 +174,37 @@ static void remote_hw_res_dma_channel_remain(ddf_fun_t *fun, void *ops,
 	async_answer_1(call, ret, remain);
 }
 
+static void remote_hw_res_enable_msi(ddf_fun_t *fun, void *ops,
+    ipc_call_t *call)
+{
+	hw_res_ops_t *hw_res_ops = ops;
+
+	if (hw_res_ops->enable_msi == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	const size_t count = DEV_IPC_GET_ARG1(*call);
+	int irq = 0;
+	size_t rcount = 0;
+	const errno_t ret = hw_res_ops->enable_msi(fun, count, &irq, &rcount);
+	async_answer_2(call, ret, irq, rcount);
+}
+
+static void remote_hw_res_disable_msi(ddf_fun_t *fun, void *ops,
+    ipc_call_t *call)
+{
+	hw_res_ops_t *hw_res_ops = ops;
+
+	if (hw_res_ops->disable_msi == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	const errno_t ret = hw_res_ops->disable_msi(fun);
+	async_answer_0(call, ret);
+}
+
 /**
  * @}
  */
@@ -85,7 +85,8 @@ typedef enum {
 	NIC_OFFLOAD_SET,
 	NIC_POLL_GET_MODE,
 	NIC_POLL_SET_MODE,
-	NIC_POLL_NOW
+	NIC_POLL_NOW,
+	NIC_SEND_OFFLOAD
 } nic_funcs_t;
 
 /** Send frame from NIC
@@ -1244,12 +1245,48 @@ errno_t nic_offload_set(async_sess_t *dev_sess, uint32_t mask, uint32_t active)
 {
 	async_exch_t *exch = async_exchange_begin(dev_sess);
 	errno_t rc = async_req_3_0(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
-	    NIC_AUTONEG_RESTART, (sysarg_t) mask, (sysarg_t) active);
+	    NIC_OFFLOAD_SET, (sysarg_t) mask, (sysarg_t) active);
 	async_exchange_end(exch);
 
 	return rc;
 }
 
+/** Send frame from NIC with offloaded computations
+ *
+ * Only the offloads reported as active by nic_offload_probe() can be
+ * requested.
+ *
+ * @param[in] dev_sess
+ * @param[in] data     Frame data
+ * @param[in] size     Frame size in bytes
+ * @param[in] offload  Offloads requested for the frame
+ *
+ * @return EOK If the operation was successfully completed
+ * @return ENOTSUP If the NIC cannot perform the offloads
+ *
+ */
+errno_t nic_send_frame_offload(async_sess_t *dev_sess, void *data, size_t size,
+    const nic_tx_offload_t *offload)
+{
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_4(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_SEND_OFFLOAD, offload->csum_start, offload->csum_offset,
+	    offload->gso_size, &answer);
+	errno_t retval = async_data_write_start(exch, data, size);
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
 /** Query the current interrupt/poll mode of the NIC
  *
  * @param[in]  dev_sess
@@ -2392,6 +2429,35 @@ static void remote_nic_offload_set(ddf_fun_t *dev, void *iface,
 	async_answer_0(call, rc);
 }
 
+static void remote_nic_send_frame_offload(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+
+	nic_tx_offload_t offload;
+	offload.csum_start = (uint16_t) ipc_get_arg2(call);
+	offload.csum_offset = (uint16_t) ipc_get_arg3(call);
+	offload.gso_size = (uint16_t) ipc_get_arg4(call);
+
+	void *data;
+	size_t size;
+	errno_t rc;
+
+	rc = async_data_write_accept(&data, false, 0, 0, 0, &size);
+	if (rc != EOK) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (nic_iface->send_frame_offload == NULL)
+		rc = ENOTSUP;
+	else
+		rc = nic_iface->send_frame_offload(dev, data, size, &offload);
+
+	async_answer_0(call, rc);
+	free(data);
+}
+
 static void remote_nic_poll_get_mode(ddf_fun_t *dev, void *iface,
     ipc_call_t *call)
 {
@@ -2529,7 +2595,8 @@ static const remote_iface_func_ptr_t remote_nic_iface_ops[] = {
 	[NIC_OFFLOAD_SET] = remote_nic_offload_set,
 	[NIC_POLL_GET_MODE] = remote_nic_poll_get_mode,
 	[NIC_POLL_SET_MODE] = remote_nic_poll_set_mode,
-	[NIC_POLL_NOW] = remote_nic_poll_now
+	[NIC_POLL_NOW] = remote_nic_poll_now,
+	[NIC_SEND_OFFLOAD] = remote_nic_send_frame_offload
 };
 
 /** Remote NIC interface structure.
@@ -44,8 +44,10 @@ extern async_sess_t *ahci_get_sess(devman_handle_t, char **);
 extern errno_t ahci_get_sata_device_name(async_sess_t *, size_t, char *);
 extern errno_t ahci_get_num_blocks(async_sess_t *, uint64_t *);
 extern errno_t ahci_get_block_size(async_sess_t *, size_t *);
-extern errno_t ahci_read_blocks(async_sess_t *, uint64_t, size_t, void *);
-extern errno_t ahci_write_blocks(async_sess_t *, uint64_t, size_t, void *);
+extern errno_t ahci_read_blocks(async_sess_t *, uint64_t, size_t, void *,
+    size_t);
+extern errno_t ahci_write_blocks(async_sess_t *, uint64_t, size_t,
+    const void *, size_t);
 
 /** AHCI device communication interface. */
 typedef struct {
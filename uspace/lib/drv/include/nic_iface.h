@@ -102,6 +102,8 @@ extern errno_t nic_wol_load_info(async_sess_t *, nic_wv_type_t *, size_t, uint8_
 
 extern errno_t nic_offload_probe(async_sess_t *, uint32_t *, uint32_t *);
 extern errno_t nic_offload_set(async_sess_t *, uint32_t, uint32_t);
+extern errno_t nic_send_frame_offload(async_sess_t *, void *, size_t,
+    const nic_tx_offload_t *);
 
 extern errno_t nic_poll_get_mode(async_sess_t *, nic_poll_mode_t *,
     struct timespec *);
@@ -54,6 +54,8 @@ typedef struct {
 	const char *volume_name;
 	/** Filesystem block size */
 	size_t bsize;
+	/** Size of the journal in blocks or zero for no journal */
+	uint32_t journal_blocks;
 } ext4_cfg_t;
 
 #endif
@@ -36,6 +36,7 @@
 #define LIBEXT4_TYPES_H_
 
 #include <block.h>
+#include <fibril_synch.h>
 
 /*
  * Structure of the super block
@@ -215,6 +216,7 @@ typedef struct ext4_superblock {
 
 #define EXT4_FEATURE_INCOMPAT_SUPP \
 	(EXT4_FEATURE_INCOMPAT_FILETYPE | \
+	EXT4_FEATURE_INCOMPAT_RECOVER | \
 	EXT4_FEATURE_INCOMPAT_EXTENTS | \
 	EXT4_FEATURE_INCOMPAT_64BIT | \
 	EXT4_FEATURE_INCOMPAT_FLEX_BG)
@@ -227,11 +229,23 @@ typedef struct ext4_superblock {
 	EXT4_FEATURE_RO_COMPAT_GDT_CSUM | \
 	EXT4_FEATURE_RO_COMPAT_EXTRA_ISIZE)
 
+struct ext4_journal;
+
 typedef struct ext4_filesystem {
 	service_id_t device;
 	ext4_superblock_t *superblock;
 	aoff64_t inode_block_limits[4];
 	aoff64_t inode_blocks_per_level[4];
+	/** Metadata journal or NULL if the file system is not journaled */
+	struct ext4_journal *journal;
+	/** Name indexes of linear directories or NULL if none were built */
+	struct ext4_dir_cache *dir_cache;
+	/** Protects dx_prefetches */
+	fibril_mutex_t dx_prefetch_lock;
+	/** Signalled when a prefetch of htree leaf blocks finishes */
+	fibril_condvar_t dx_prefetch_cv;
+	/** Number of prefetches of htree leaf blocks in progress */
+	unsigned dx_prefetches;
 } ext4_filesystem_t;
 
 /** Size of buffer for volume name. To hold 16 latin-1 chars encoded as UTF-8
@@ -385,7 +399,8 @@ typedef struct ext4_inode {
 #define EXT4_INODE_FLAG_EOFBLOCKS     0x00400000  /* Blocks allocated beyond EOF */
 #define EXT4_INODE_FLAG_RESERVED      0x80000000  /* reserved for ext4 lib */
 
-#define EXT4_INODE_ROOT_INDEX  2
+#define EXT4_INODE_ROOT_INDEX     2
+#define EXT4_INODE_JOURNAL_INDEX  8
 
 typedef struct ext4_inode_ref {
 	block_t *block;         /* Reference to a block containing this inode */
@@ -488,6 +503,9 @@ typedef struct ext4_directory_dx_block {
 
 #define EXT4_DIRECTORY_HTREE_EOF  UINT32_C(0x7fffffff)
 
+/** Size in blocks at which a full linear directory gets an htree index */
+#define EXT4_DIRECTORY_DX_THRESHOLD  4
+
 /*
  * This is the extent on-disk structure.
  * It's used at the bottom of the tree.
@@ -537,6 +555,9 @@ typedef struct ext4_extent_path {
 
 #define EXT4_EXTENT_MAGIC  0xF30A
 
+/** Maximum number of blocks covered by an initialized extent */
+#define EXT4_EXTENT_MAX_INIT_LEN  (1U << 15)
+
 #define	EXT4_EXTENT_FIRST(header) \
 	((ext4_extent_t *) (((void *) (header)) + sizeof(ext4_extent_header_t)))
 
@@ -557,6 +578,87 @@ typedef struct ext4_hash_info {
 	const uint32_t *seed;
 } ext4_hash_info_t;
 
+/*
+ * Structures of the journal (JBD2). Unlike the rest of the file system,
+ * the journal is stored in big endian.
+ */
+#define EXT4_JOURNAL_MAGIC  0xC03B3998U
+
+#define EXT4_JOURNAL_DESCRIPTOR_BLOCK  1
+#define EXT4_JOURNAL_COMMIT_BLOCK      2
+#define EXT4_JOURNAL_SUPERBLOCK_V1     3
+#define EXT4_JOURNAL_SUPERBLOCK_V2     4
+#define EXT4_JOURNAL_REVOKE_BLOCK      5
+
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE        0x0001
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT         0x0002
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_ASYNC_COMMIT  0x0004
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_CSUM_V2       0x0008
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_CSUM_V3       0x0010
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_FAST_COMMIT   0x0020
+
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_SUPP \
+	(EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE | \
+	EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT)
+
+#define EXT4_JOURNAL_FLAG_ESCAPE     0x0001  /* Magic number replaced */
+#define EXT4_JOURNAL_FLAG_SAME_UUID  0x0002  /* UUID of the previous tag */
+#define EXT4_JOURNAL_FLAG_DELETED    0x0004  /* Block deleted by this trans */
+#define EXT4_JOURNAL_FLAG_LAST_TAG   0x0008  /* Last tag in the descriptor */
+
+typedef struct ext4_journal_header {
+	uint32_t magic;
+	uint32_t block_type;
+	uint32_t sequence;
+} __attribute__((packed)) ext4_journal_header_t;
+
+typedef struct ext4_journal_superblock {
+	ext4_journal_header_t header;
+
+	/* Static information describing the journal */
+	uint32_t block_size;            /* Journal device block size */
+	uint32_t max_len;               /* Total blocks in journal file */
+	uint32_t first;                 /* First block of log information */
+
+	/* Dynamic information describing the current state of the log */
+	uint32_t sequence;              /* First commit ID expected in log */
+	uint32_t start;                 /* Block number of start of log */
+	uint32_t error;                 /* Error value, as set by abort */
+
+	/* Remaining fields are only valid in a version 2 superblock */
+	uint32_t features_compatible;
+	uint32_t features_incompatible;
+	uint32_t features_read_only;
+	uint8_t uuid[16];               /* UUID of the journal */
+	uint32_t nr_users;              /* Number of file systems sharing log */
+	uint32_t dyn_super;             /* Block number of dynamic superblock */
+	uint32_t max_transaction;       /* Limit of journal blocks per trans */
+	uint32_t max_trans_data;        /* Limit of data blocks per trans */
+	uint8_t checksum_type;
+	uint8_t padding2[3];
+	uint32_t num_fc_blocks;         /* Number of fast commit blocks */
+	uint32_t padding[41];
+	uint32_t checksum;
+	uint8_t users[16 * 48];         /* IDs of all file systems sharing log */
+} __attribute__((packed)) ext4_journal_superblock_t;
+
+/*
+ * Descriptor blocks contain a series of tags, each followed by 16 bytes of
+ * UUID unless EXT4_JOURNAL_FLAG_SAME_UUID is set. The high part of the block
+ * number is present only with EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT.
+ */
+typedef struct ext4_journal_block_tag {
+	uint32_t block;
+	uint16_t checksum;
+	uint16_t flags;
+	uint32_t block_hi;
+} __attribute__((packed)) ext4_journal_block_tag_t;
+
+typedef struct ext4_journal_revoke_header {
+	ext4_journal_header_t header;
+	uint32_t count;                 /* Bytes used in the block */
+} __attribute__((packed)) ext4_journal_revoke_header_t;
+
 #endif
 
 /**
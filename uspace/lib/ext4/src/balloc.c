@@ -35,6 +35,7 @@
  * @brief Physical block allocator.
  */
 
+#include <assert.h>
 #include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -43,6 +44,7 @@
 #include "ext4/block_group.h"
 #include "ext4/filesystem.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 #include "ext4/types.h"
 
@@ -84,6 +86,9 @@ errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
 	ext4_bitmap_free_bit(bitmap_block->data, index_in_group);
 	bitmap_block->dirty = true;
 
+	/* The block may be reused for file data */
+	ext4_journal_revoke(fs, block_addr, 1);
+
 	/* Release block with bitmap */
 	rc = block_put(bitmap_block);
 	if (rc != EOK) {
@@ -157,6 +162,9 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 	ext4_bitmap_free_bits(bitmap_block->data, index_in_group_first, count);
 	bitmap_block->dirty = true;
 
+	/* The blocks may be reused for file data */
+	ext4_journal_revoke(fs, first, count);
+
 	/* Release block with bitmap */
 	rc = block_put(bitmap_block);
 	if (rc != EOK) {
@@ -614,6 +622,249 @@ success:
 	return rc;
 }
 
+/** Account for blocks allocated from a block group.
+ *
+ * @param inode_ref Inode the blocks were allocated for
+ * @param bg_ref    Block group the blocks were allocated from
+ * @param count     Number of allocated blocks
+ *
+ */
+static void ext4_balloc_account(ext4_inode_ref_t *inode_ref,
+    ext4_block_group_ref_t *bg_ref, uint32_t count)
+{
+	ext4_superblock_t *sb = inode_ref->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	/* Update superblock free blocks count */
+	uint32_t sb_free_blocks = ext4_superblock_get_free_blocks_count(sb);
+	sb_free_blocks -= count;
+	ext4_superblock_set_free_blocks_count(sb, sb_free_blocks);
+
+	/* Update inode blocks (different block size!) count */
+	uint64_t ino_blocks =
+	    ext4_inode_get_blocks_count(sb, inode_ref->inode);
+	ino_blocks += count * (block_size / EXT4_INODE_BLOCK_SIZE);
+	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
+	inode_ref->dirty = true;
+
+	/* Update block group free blocks count */
+	uint32_t bg_free_blocks =
+	    ext4_block_group_get_free_blocks_count(bg_ref->block_group, sb);
+	bg_free_blocks -= count;
+	ext4_block_group_set_free_blocks_count(bg_ref->block_group, sb,
+	    bg_free_blocks);
+	bg_ref->dirty = true;
+}
+
+/** Allocate a run of free blocks in a block group.
+ *
+ * @param inode_ref Inode to allocate blocks for
+ * @param bgid      Index of the block group
+ * @param start     Index in the group where to start searching
+ * @param count     Number of blocks to allocate
+ * @param fblock    Output address of the first allocated block
+ * @param allocated Output number of allocated blocks (0 if the group is full)
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_balloc_alloc_blocks_in_group(ext4_inode_ref_t *inode_ref,
+    uint32_t bgid, uint32_t start, uint32_t count, uint32_t *fblock,
+    uint32_t *allocated)
+{
+	ext4_superblock_t *sb = inode_ref->fs->superblock;
+
+	*allocated = 0;
+
+	ext4_block_group_ref_t *bg_ref;
+	errno_t rc = ext4_filesystem_get_block_group_ref(inode_ref->fs, bgid,
+	    &bg_ref);
+	if (rc != EOK)
+		return rc;
+
+	if (ext4_block_group_get_free_blocks_count(bg_ref->block_group,
+	    sb) == 0) {
+		/* This group has no free blocks */
+		return ext4_filesystem_put_block_group_ref(bg_ref);
+	}
+
+	uint32_t first_in_group =
+	    ext4_balloc_get_first_data_block_in_group(sb, bg_ref);
+	uint32_t first_in_group_index =
+	    ext4_filesystem_blockaddr2_index_in_group(sb, first_in_group);
+	uint32_t blocks_in_group = ext4_superblock_get_blocks_in_group(sb, bgid);
+
+	if (start < first_in_group_index)
+		start = first_in_group_index;
+
+	/* Load block with bitmap */
+	uint32_t bitmap_block_addr =
+	    ext4_block_group_get_block_bitmap(bg_ref->block_group, sb);
+
+	block_t *bitmap_block;
+	rc = block_get(&bitmap_block, inode_ref->fs->device, bitmap_block_addr,
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	/* Search from the start index, then wrap around */
+	uint32_t index;
+	uint32_t len = ext4_bitmap_find_free_run(bitmap_block->data, start,
+	    blocks_in_group, count, &index);
+	if (len < count && start > first_in_group_index) {
+		uint32_t index2;
+		uint32_t len2 = ext4_bitmap_find_free_run(bitmap_block->data,
+		    first_in_group_index, start, count, &index2);
+		if (len2 > len) {
+			len = len2;
+			index = index2;
+		}
+	}
+
+	if (len > 0) {
+		ext4_bitmap_set_bits(bitmap_block->data, index, len);
+		bitmap_block->dirty = true;
+	}
+
+	rc = block_put(bitmap_block);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	if (len > 0) {
+		ext4_balloc_account(inode_ref, bg_ref, len);
+		*fblock = ext4_filesystem_index_in_group2blockaddr(sb, index,
+		    bgid);
+		*allocated = len;
+	}
+
+	return ext4_filesystem_put_block_group_ref(bg_ref);
+}
+
+/** Multi-block allocation algorithm.
+ *
+ * Allocates a contiguous run of up to @a count blocks, preferably right
+ * after the last block of the inode. The first block group with free blocks
+ * (starting with the group of the goal) provides its longest free run, so
+ * fewer blocks than requested may be allocated.
+ *
+ * @param inode_ref Inode to allocate blocks for
+ * @param count     Number of blocks to allocate
+ * @param fblock    Output address of the first allocated block
+ * @param allocated Output number of allocated blocks
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_alloc_blocks(ext4_inode_ref_t *inode_ref, uint32_t count,
+    uint32_t *fblock, uint32_t *allocated)
+{
+	ext4_superblock_t *sb = inode_ref->fs->superblock;
+	uint32_t goal;
+
+	assert(count > 0);
+
+	/* Find GOAL */
+	errno_t rc = ext4_balloc_find_goal(inode_ref, &goal);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t block_group = ext4_filesystem_blockaddr2group(sb, goal);
+	uint32_t index_in_group =
+	    ext4_filesystem_blockaddr2_index_in_group(sb, goal);
+	uint32_t block_group_count = ext4_superblock_get_block_group_count(sb);
+
+	for (uint32_t i = 0; i < block_group_count; i++) {
+		uint32_t bgid = (block_group + i) % block_group_count;
+
+		rc = ext4_balloc_alloc_blocks_in_group(inode_ref, bgid,
+		    i == 0 ? index_in_group : 0, count, fblock, allocated);
+		if (rc != EOK)
+			return rc;
+
+		if (*allocated > 0)
+			return EOK;
+	}
+
+	return ENOSPC;
+}
+
+/** Try to allocate a run of concrete blocks.
+ *
+ * Allocates blocks starting with @a fblock for as long as they are free,
+ * but at most @a count blocks and not past the end of the block group.
+ *
+ * @param inode_ref Inode to allocate blocks for
+ * @param fblock    Address of the first block to allocate
+ * @param count     Maximum number of blocks to allocate
+ * @param allocated Output number of allocated blocks (0 if @a fblock is not
+ *                  free)
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_try_alloc_blocks(ext4_inode_ref_t *inode_ref,
+    uint32_t fblock, uint32_t count, uint32_t *allocated)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	ext4_superblock_t *sb = fs->superblock;
+
+	*allocated = 0;
+
+	/* Compute indexes */
+	uint32_t block_group = ext4_filesystem_blockaddr2group(sb, fblock);
+	uint32_t index_in_group =
+	    ext4_filesystem_blockaddr2_index_in_group(sb, fblock);
+	uint32_t blocks_in_group =
+	    ext4_superblock_get_blocks_in_group(sb, block_group);
+
+	/* Load block group reference */
+	ext4_block_group_ref_t *bg_ref;
+	errno_t rc = ext4_filesystem_get_block_group_ref(fs, block_group,
+	    &bg_ref);
+	if (rc != EOK)
+		return rc;
+
+	/* Load block with bitmap */
+	uint32_t bitmap_block_addr =
+	    ext4_block_group_get_block_bitmap(bg_ref->block_group, sb);
+	block_t *bitmap_block;
+	rc = block_get(&bitmap_block, fs->device, bitmap_block_addr, 0);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	/* Count free blocks following the target */
+	uint32_t len = 0;
+	while (len < count && index_in_group + len < blocks_in_group &&
+	    ext4_bitmap_is_free_bit(bitmap_block->data, index_in_group + len))
+		len++;
+
+	if (len > 0) {
+		ext4_bitmap_set_bits(bitmap_block->data, index_in_group, len);
+		bitmap_block->dirty = true;
+	}
+
+	/* Release block with bitmap */
+	rc = block_put(bitmap_block);
+	if (rc != EOK) {
+		/* Error in saving bitmap */
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	if (len > 0) {
+		ext4_balloc_account(inode_ref, bg_ref, len);
+		*allocated = len;
+	}
+
+	return ext4_filesystem_put_block_group_ref(bg_ref);
+}
+
 /** Try to allocate concrete block.
  *
  * @param inode_ref Inode to allocate block for
@@ -0,0 +1,575 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+/**
+ * @file  dir_cache.c
+ * @brief In-memory name index of linear directories.
+ *
+ * Looking up a name in a directory without an htree index means reading all
+ * of its blocks. For large linear directories, the first such scan records
+ * a hash of every name together with the block holding it. Later lookups
+ * read only the blocks whose names have a matching hash and a name which is
+ * not in the index is known not to exist without any I/O.
+ *
+ * The index of a directory is kept up to date by the functions adding and
+ * removing directory entries. Only a limited number of directories are
+ * indexed at a time, the least recently used one is dropped first.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <block.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <mem.h>
+#include <stdlib.h>
+#include "ext4/dir_cache.h"
+#include "ext4/directory.h"
+#include "ext4/filesystem.h"
+#include "ext4/inode.h"
+#include "ext4/superblock.h"
+
+/** Smallest directory (in blocks) worth indexing */
+#define EXT4_DIR_CACHE_MIN_BLOCKS  4
+
+/** Maximum number of directories indexed at a time */
+#define EXT4_DIR_CACHE_MAX_DIRS  16
+
+/** Maximum number of blocks tried for a single name */
+#define EXT4_DIR_CACHE_MAX_CANDIDATES  8
+
+/** Name index of one directory */
+typedef struct {
+	/** Link in ext4_dir_cache_t.dirs */
+	ht_link_t link;
+	/** Link in ext4_dir_cache_t.lru */
+	link_t lru_link;
+	/** Number of the directory i-node */
+	uint32_t index;
+	/** Names of the directory (ext4_dir_cache_name_t) */
+	hash_table_t names;
+} ext4_dir_cache_dir_t;
+
+/** Name present in a directory */
+typedef struct {
+	ht_link_t link;
+	/** Hash of the name */
+	uint32_t hash;
+	/** Address of the block holding the entry */
+	aoff64_t fblock;
+} ext4_dir_cache_name_t;
+
+/** Name indexes of a file system */
+typedef struct ext4_dir_cache {
+	fibril_mutex_t lock;
+	/** Indexed directories (ext4_dir_cache_dir_t) */
+	hash_table_t dirs;
+	/** Indexed directories, the least recently used first */
+	list_t lru;
+	size_t count;
+} ext4_dir_cache_t;
+
+static uint32_t ext4_dir_cache_name_hash(size_t name_len, const char *name)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < name_len; i++) {
+		hash ^= (uint8_t) name[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static size_t names_key_hash(const void *key)
+{
+	return *(const uint32_t *) key;
+}
+
+static size_t names_hash(const ht_link_t *item)
+{
+	return hash_table_get_inst(item, ext4_dir_cache_name_t, link)->hash;
+}
+
+static bool names_key_equal(const void *key, const ht_link_t *item)
+{
+	return *(const uint32_t *) key ==
+	    hash_table_get_inst(item, ext4_dir_cache_name_t, link)->hash;
+}
+
+static bool names_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	return hash_table_get_inst(item1, ext4_dir_cache_name_t, link)->hash ==
+	    hash_table_get_inst(item2, ext4_dir_cache_name_t, link)->hash;
+}
+
+static void names_remove_callback(ht_link_t *item)
+{
+	free(hash_table_get_inst(item, ext4_dir_cache_name_t, link));
+}
+
+static hash_table_ops_t names_ops = {
+	.hash = names_hash,
+	.key_hash = names_key_hash,
+	.key_equal = names_key_equal,
+	.equal = names_equal,
+	.remove_callback = names_remove_callback
+};
+
+static size_t dirs_key_hash(const void *key)
+{
+	return hash_mix32(*(const uint32_t *) key);
+}
+
+static size_t dirs_hash(const ht_link_t *item)
+{
+	return hash_mix32(hash_table_get_inst(item, ext4_dir_cache_dir_t,
+	    link)->index);
+}
+
+static bool dirs_key_equal(const void *key, const ht_link_t *item)
+{
+	return *(const uint32_t *) key ==
+	    hash_table_get_inst(item, ext4_dir_cache_dir_t, link)->index;
+}
+
+static void dirs_remove_callback(ht_link_t *item)
+{
+	ext4_dir_cache_dir_t *dir = hash_table_get_inst(item,
+	    ext4_dir_cache_dir_t, link);
+
+	list_remove(&dir->lru_link);
+	hash_table_destroy(&dir->names);
+	free(dir);
+}
+
+static hash_table_ops_t dirs_ops = {
+	.hash = dirs_hash,
+	.key_hash = dirs_key_hash,
+	.key_equal = dirs_key_equal,
+	.equal = NULL,
+	.remove_callback = dirs_remove_callback
+};
+
+/** Get the name indexes of a file system, creating them if needed.
+ *
+ * @param fs File system
+ *
+ * @return Name indexes or NULL if out of memory
+ *
+ */
+static ext4_dir_cache_t *ext4_dir_cache_get(ext4_filesystem_t *fs)
+{
+	if (fs->dir_cache != NULL)
+		return fs->dir_cache;
+
+	ext4_dir_cache_t *cache = malloc(sizeof(ext4_dir_cache_t));
+	if (cache == NULL)
+		return NULL;
+
+	if (!hash_table_create(&cache->dirs, 0, 0, &dirs_ops)) {
+		free(cache);
+		return NULL;
+	}
+
+	fibril_mutex_initialize(&cache->lock);
+	list_initialize(&cache->lru);
+	cache->count = 0;
+
+	fs->dir_cache = cache;
+	return cache;
+}
+
+/** Find the index of a directory.
+ *
+ * The cache must be locked.
+ *
+ * @param cache Name indexes
+ * @param index Number of the directory i-node
+ *
+ * @return Index of the directory or NULL if it is not indexed
+ *
+ */
+static ext4_dir_cache_dir_t *ext4_dir_cache_dir_find(ext4_dir_cache_t *cache,
+    uint32_t index)
+{
+	ht_link_t *link = hash_table_find(&cache->dirs, &index);
+	if (link == NULL)
+		return NULL;
+
+	ext4_dir_cache_dir_t *dir = hash_table_get_inst(link,
+	    ext4_dir_cache_dir_t, link);
+
+	list_remove(&dir->lru_link);
+	list_append(&dir->lru_link, &cache->lru);
+	return dir;
+}
+
+/** Record a name in the index of a directory.
+ *
+ * @param dir    Index of the directory
+ * @param hash   Hash of the name
+ * @param fblock Address of the block holding the entry
+ *
+ * @return EOK or ENOMEM
+ *
+ */
+static errno_t ext4_dir_cache_dir_insert(ext4_dir_cache_dir_t *dir,
+    uint32_t hash, aoff64_t fblock)
+{
+	ext4_dir_cache_name_t *name = malloc(sizeof(ext4_dir_cache_name_t));
+	if (name == NULL)
+		return ENOMEM;
+
+	name->hash = hash;
+	name->fblock = fblock;
+	hash_table_insert(&dir->names, &name->link);
+	return EOK;
+}
+
+/** Build the index of a directory by reading all its blocks.
+ *
+ * @param parent Directory i-node
+ * @param rdir   Output value - index of the directory
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_dir_cache_build(ext4_inode_ref_t *parent,
+    ext4_dir_cache_dir_t **rdir)
+{
+	ext4_superblock_t *sb = parent->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+	uint32_t total_blocks = ext4_inode_get_size(sb, parent->inode) /
+	    block_size;
+
+	ext4_dir_cache_dir_t *dir = malloc(sizeof(ext4_dir_cache_dir_t));
+	if (dir == NULL)
+		return ENOMEM;
+
+	if (!hash_table_create(&dir->names, 0, 0, &names_ops)) {
+		free(dir);
+		return ENOMEM;
+	}
+
+	link_initialize(&dir->lru_link);
+	dir->index = parent->index;
+
+	errno_t rc = EOK;
+	for (uint32_t iblock = 0; iblock < total_blocks; iblock++) {
+		uint32_t fblock;
+		rc = ext4_filesystem_get_inode_data_block_index(parent, iblock,
+		    &fblock);
+		if (rc != EOK)
+			break;
+
+		block_t *block;
+		rc = block_get(&block, parent->fs->device, fblock,
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			break;
+
+		uint8_t *addr = block->data;
+		uint8_t *addr_limit = addr + block_size;
+		while (rc == EOK && addr + sizeof(ext4_fake_directory_entry_t) <=
+		    addr_limit) {
+			ext4_directory_entry_ll_t *dentry =
+			    (ext4_directory_entry_ll_t *) addr;
+			uint16_t dentry_len =
+			    ext4_directory_entry_ll_get_entry_length(dentry);
+			uint16_t name_len =
+			    ext4_directory_entry_ll_get_name_length(sb, dentry);
+
+			/* Corrupted entry, leave it to the linear search */
+			if (dentry_len == 0 || addr + dentry_len > addr_limit ||
+			    name_len > dentry_len) {
+				rc = EINVAL;
+				break;
+			}
+
+			if (ext4_directory_entry_ll_get_inode(dentry) != 0) {
+				rc = ext4_dir_cache_dir_insert(dir,
+				    ext4_dir_cache_name_hash(name_len,
+				    (char *) dentry->name), fblock);
+			}
+
+			addr += dentry_len;
+		}
+
+		errno_t rc2 = block_put(block);
+		if (rc == EOK)
+			rc = rc2;
+		if (rc != EOK)
+			break;
+	}
+
+	if (rc != EOK) {
+		hash_table_destroy(&dir->names);
+		free(dir);
+		return rc;
+	}
+
+	*rdir = dir;
+	return EOK;
+}
+
+/** Find a directory entry using the in-memory index.
+ *
+ * The index of the directory is built if the directory is large enough
+ * and is not indexed yet.
+ *
+ * @param result   Output value - found entry
+ * @param parent   Directory i-node
+ * @param name_len Length of the name
+ * @param name     Name to be found
+ *
+ * @return EOK if found, ENOENT if there is no such entry, ENOTSUP if the
+ *         directory cannot be searched using the index or an error code
+ *
+ */
+errno_t ext4_dir_cache_find(ext4_directory_search_result_t *result,
+    ext4_inode_ref_t *parent, size_t name_len, const char *name)
+{
+	ext4_filesystem_t *fs = parent->fs;
+	ext4_superblock_t *sb = fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	if (ext4_inode_get_size(sb, parent->inode) / block_size <
+	    EXT4_DIR_CACHE_MIN_BLOCKS)
+		return ENOTSUP;
+
+	ext4_dir_cache_t *cache = ext4_dir_cache_get(fs);
+	if (cache == NULL)
+		return ENOTSUP;
+
+	uint32_t hash = ext4_dir_cache_name_hash(name_len, name);
+	aoff64_t candidates[EXT4_DIR_CACHE_MAX_CANDIDATES];
+	size_t count = 0;
+
+	fibril_mutex_lock(&cache->lock);
+
+	ext4_dir_cache_dir_t *dir = ext4_dir_cache_dir_find(cache,
+	    parent->index);
+	if (dir == NULL) {
+		/* Do the I/O without holding the lock. */
+		fibril_mutex_unlock(&cache->lock);
+
+		ext4_dir_cache_dir_t *new_dir;
+		if (ext4_dir_cache_build(parent, &new_dir) != EOK)
+			return ENOTSUP;
+
+		fibril_mutex_lock(&cache->lock);
+
+		/* Somebody could have built it in the meantime. */
+		dir = ext4_dir_cache_dir_find(cache, parent->index);
+		if (dir == NULL) {
+			if (cache->count == EXT4_DIR_CACHE_MAX_DIRS) {
+				ext4_dir_cache_dir_t *old = list_get_instance(
+				    list_first(&cache->lru),
+				    ext4_dir_cache_dir_t, lru_link);
+				hash_table_remove_item(&cache->dirs, &old->link);
+				cache->count--;
+			}
+
+			dir = new_dir;
+			hash_table_insert(&cache->dirs, &dir->link);
+			list_append(&dir->lru_link, &cache->lru);
+			cache->count++;
+		} else {
+			hash_table_destroy(&new_dir->names);
+			free(new_dir);
+		}
+	}
+
+	ht_link_t *first = hash_table_find(&dir->names, &hash);
+	ht_link_t *link = first;
+	while (link != NULL) {
+		if (count == EXT4_DIR_CACHE_MAX_CANDIDATES) {
+			fibril_mutex_unlock(&cache->lock);
+			return ENOTSUP;
+		}
+
+		candidates[count++] = hash_table_get_inst(link,
+		    ext4_dir_cache_name_t, link)->fblock;
+		link = hash_table_find_next(&dir->names, first, link);
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+
+	for (size_t i = 0; i < count; i++) {
+		block_t *block;
+		errno_t rc = block_get(&block, fs->device, candidates[i],
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			return rc;
+
+		ext4_directory_entry_ll_t *res_entry;
+		rc = ext4_directory_find_in_block(block, sb, name_len, name,
+		    &res_entry);
+		if (rc == EOK) {
+			result->block = block;
+			result->dentry = res_entry;
+			return EOK;
+		}
+
+		rc = block_put(block);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if (count > 0) {
+		/*
+		 * Only a hash collision with another name. This is rare
+		 * enough not to bother telling it from a stale index.
+		 */
+		return ENOTSUP;
+	}
+
+	result->block = NULL;
+	result->dentry = NULL;
+	return ENOENT;
+}
+
+/** Record a new entry in the index of its directory.
+ *
+ * @param parent   Directory i-node
+ * @param name_len Length of the name
+ * @param name     Name of the new entry
+ * @param fblock   Address of the block holding the entry
+ *
+ */
+void ext4_dir_cache_add(ext4_inode_ref_t *parent, size_t name_len,
+    const char *name, aoff64_t fblock)
+{
+	ext4_dir_cache_t *cache = parent->fs->dir_cache;
+	if (cache == NULL)
+		return;
+
+	fibril_mutex_lock(&cache->lock);
+
+	ext4_dir_cache_dir_t *dir = ext4_dir_cache_dir_find(cache,
+	    parent->index);
+	if (dir != NULL &&
+	    ext4_dir_cache_dir_insert(dir, ext4_dir_cache_name_hash(name_len,
+	    name), fblock) != EOK) {
+		/* An incomplete index would hide the entry, drop it. */
+		hash_table_remove_item(&cache->dirs, &dir->link);
+		cache->count--;
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Remove an entry from the index of its directory.
+ *
+ * @param parent   Directory i-node
+ * @param name_len Length of the name
+ * @param name     Name of the removed entry
+ * @param fblock   Address of the block which held the entry
+ *
+ */
+void ext4_dir_cache_remove(ext4_inode_ref_t *parent, size_t name_len,
+    const char *name, aoff64_t fblock)
+{
+	ext4_dir_cache_t *cache = parent->fs->dir_cache;
+	if (cache == NULL)
+		return;
+
+	uint32_t hash = ext4_dir_cache_name_hash(name_len, name);
+
+	fibril_mutex_lock(&cache->lock);
+
+	ext4_dir_cache_dir_t *dir = ext4_dir_cache_dir_find(cache,
+	    parent->index);
+	if (dir != NULL) {
+		ht_link_t *first = hash_table_find(&dir->names, &hash);
+		ht_link_t *link = first;
+		while (link != NULL) {
+			ext4_dir_cache_name_t *cname = hash_table_get_inst(link,
+			    ext4_dir_cache_name_t, link);
+			if (cname->fblock == fblock) {
+				hash_table_remove_item(&dir->names, link);
+				break;
+			}
+
+			link = hash_table_find_next(&dir->names, first, link);
+		}
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Drop the index of a directory.
+ *
+ * Used when the directory gets an htree index or is destroyed.
+ *
+ * @param fs    File system
+ * @param index Number of the directory i-node
+ *
+ */
+void ext4_dir_cache_invalidate(ext4_filesystem_t *fs, uint32_t index)
+{
+	ext4_dir_cache_t *cache = fs->dir_cache;
+	if (cache == NULL)
+		return;
+
+	fibril_mutex_lock(&cache->lock);
+
+	ht_link_t *link = hash_table_find(&cache->dirs, &index);
+	if (link != NULL) {
+		hash_table_remove_item(&cache->dirs, link);
+		cache->count--;
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Drop all indexes of a file system.
+ *
+ * @param fs File system
+ *
+ */
+void ext4_dir_cache_fini(ext4_filesystem_t *fs)
+{
+	ext4_dir_cache_t *cache = fs->dir_cache;
+	if (cache == NULL)
+		return;
+
+	hash_table_destroy(&cache->dirs);
+	free(cache);
+	fs->dir_cache = NULL;
+}
+
+/**
+ * @}
+ */
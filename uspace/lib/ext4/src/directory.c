@@ -40,6 +40,7 @@
 #include <mem.h>
 #include <stdlib.h>
 #include <str.h>
+#include "ext4/dir_cache.h"
 #include "ext4/directory.h"
 #include "ext4/directory_index.h"
 #include "ext4/filesystem.h"
@@ -434,8 +435,10 @@ errno_t ext4_directory_add_entry(ext4_inode_ref_t *parent, const char *name,
 		/* If adding is successful, function can finish */
 		rc = ext4_directory_try_insert_entry(fs->superblock, block,
 		    child, name, name_len);
-		if (rc == EOK)
+		if (rc == EOK) {
+			ext4_dir_cache_add(parent, name_len, name, fblock);
 			success = true;
+		}
 
 		rc = block_put(block);
 		if (rc != EOK)
@@ -445,11 +448,26 @@ errno_t ext4_directory_add_entry(ext4_inode_ref_t *parent, const char *name,
 			return EOK;
 	}
 
-	/* No free block found - needed to allocate next data block */
+	/*
+	 * No free block found. Rather than growing a large linear directory
+	 * further, give it an index if possible.
+	 */
+	errno_t rc;
+	if ((total_blocks >= EXT4_DIRECTORY_DX_THRESHOLD) &&
+	    (ext4_superblock_has_feature_compatible(fs->superblock,
+	    EXT4_FEATURE_COMPAT_DIR_INDEX))) {
+		rc = ext4_directory_dx_convert(parent);
+		if (rc == EOK)
+			return ext4_directory_dx_add_entry(parent, child, name);
+		if (rc != ENOTSUP)
+			return rc;
+	}
+
+	/* Needed to allocate next data block */
 
 	iblock = 0;
 	fblock = 0;
-	errno_t rc = ext4_filesystem_append_inode_block(parent, &fblock, &iblock);
+	rc = ext4_filesystem_append_inode_block(parent, &fblock, &iblock);
 	if (rc != EOK)
 		return rc;
 
@@ -464,6 +482,7 @@ errno_t ext4_directory_add_entry(ext4_inode_ref_t *parent, const char *name,
 	ext4_directory_entry_ll_t *block_entry = new_block->data;
 	ext4_directory_write_entry(fs->superblock, block_entry, block_size,
 	    child, name, name_len);
+	ext4_dir_cache_add(parent, name_len, name, fblock);
 
 	/* Save new block */
 	new_block->dirty = true;
@@ -508,6 +527,11 @@ errno_t ext4_directory_find_entry(ext4_directory_search_result_t *result,
 		parent->dirty = true;
 	}
 
+	/* In-memory index of a large linear directory */
+	errno_t rc = ext4_dir_cache_find(result, parent, name_len, name);
+	if (rc != ENOTSUP)
+		return rc;
+
 	/* Linear algorithm */
 
 	uint32_t iblock;
@@ -519,7 +543,7 @@ errno_t ext4_directory_find_entry(ext4_directory_search_result_t *result,
 	/* Walk through all data blocks */
 	for (iblock = 0; iblock < total_blocks; ++iblock) {
 		/* Load block address */
-		errno_t rc = ext4_filesystem_get_inode_data_block_index(parent, iblock,
+		rc = ext4_filesystem_get_inode_data_block_index(parent, iblock,
 		    &fblock);
 		if (rc != EOK)
 			return rc;
@@ -576,6 +600,8 @@ errno_t ext4_directory_remove_entry(ext4_inode_ref_t *parent, const char *name)
 	if (rc != EOK)
 		return rc;
 
+	ext4_dir_cache_remove(parent, str_size(name), name, result.block->lba);
+
 	/* Invalidate entry */
 	ext4_directory_entry_ll_set_inode(result.dentry, 0);
 
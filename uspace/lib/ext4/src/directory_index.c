@@ -36,9 +36,12 @@
 
 #include <byteorder.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <mem.h>
 #include <stdlib.h>
 #include <str.h>
+#include "ext4/dir_cache.h"
 #include "ext4/directory.h"
 #include "ext4/directory_index.h"
 #include "ext4/filesystem.h"
@@ -55,6 +58,19 @@ typedef struct ext4_dx_sort_entry {
 	void *dentry;
 } ext4_dx_sort_entry_t;
 
+/** Number of leaf blocks following the one looked up which are read ahead */
+#define EXT4_DIRECTORY_DX_PREFETCH  8
+
+/** Maximum number of prefetches in progress on one file system */
+#define EXT4_DIRECTORY_DX_PREFETCH_MAX  2
+
+/** Leaf blocks to be read ahead by a prefetch fibril. */
+typedef struct ext4_dx_prefetch {
+	ext4_filesystem_t *fs;
+	size_t count;
+	uint32_t fblocks[EXT4_DIRECTORY_DX_PREFETCH];
+} ext4_dx_prefetch_t;
+
 /** Get hash version used in directory index.
  *
  * @param root_info Pointer to root info structure of index
@@ -544,6 +560,108 @@ static errno_t ext4_directory_dx_next_block(ext4_inode_ref_t *inode_ref,
 	return ENOENT;
 }
 
+/** Finish a prefetch of leaf blocks.
+ *
+ * @param fs File system
+ *
+ */
+static void ext4_directory_dx_prefetch_done(ext4_filesystem_t *fs)
+{
+	fibril_mutex_lock(&fs->dx_prefetch_lock);
+	fs->dx_prefetches--;
+	fibril_condvar_broadcast(&fs->dx_prefetch_cv);
+	fibril_mutex_unlock(&fs->dx_prefetch_lock);
+}
+
+/** Read leaf blocks into the block cache.
+ *
+ * @param arg Leaf blocks to read (ext4_dx_prefetch_t)
+ *
+ * @return EOK
+ *
+ */
+static errno_t ext4_directory_dx_prefetch_fibril(void *arg)
+{
+	ext4_dx_prefetch_t *prefetch = arg;
+	ext4_filesystem_t *fs = prefetch->fs;
+
+	for (size_t i = 0; i < prefetch->count; i++) {
+		block_t *block;
+		if (block_get(&block, fs->device, prefetch->fblocks[i],
+		    BLOCK_FLAGS_NONE) != EOK)
+			break;
+
+		if (block_put(block) != EOK)
+			break;
+	}
+
+	free(prefetch);
+	ext4_directory_dx_prefetch_done(fs);
+	return EOK;
+}
+
+/** Start reading leaf blocks which follow the current one.
+ *
+ * The leaf blocks pointed to by the index entries after the current one are
+ * read by a separate fibril, while the caller goes on with the lookup. Later
+ * lookups in the same part of the hash space, as well as lookups that have
+ * to continue to the next leaf due to hash collisions, then find the blocks
+ * in the cache.
+ *
+ * @param inode_ref Directory i-node
+ * @param dx_block  Index node pointing to the current leaf
+ *
+ */
+static void ext4_directory_dx_prefetch(ext4_inode_ref_t *inode_ref,
+    ext4_directory_dx_block_t *dx_block)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+
+	fibril_mutex_lock(&fs->dx_prefetch_lock);
+	if (fs->dx_prefetches >= EXT4_DIRECTORY_DX_PREFETCH_MAX) {
+		fibril_mutex_unlock(&fs->dx_prefetch_lock);
+		return;
+	}
+	fs->dx_prefetches++;
+	fibril_mutex_unlock(&fs->dx_prefetch_lock);
+
+	ext4_dx_prefetch_t *prefetch = malloc(sizeof(ext4_dx_prefetch_t));
+	if (prefetch == NULL) {
+		ext4_directory_dx_prefetch_done(fs);
+		return;
+	}
+
+	prefetch->fs = fs;
+	prefetch->count = 0;
+
+	uint16_t count = ext4_directory_dx_countlimit_get_count(
+	    (ext4_directory_dx_countlimit_t *) dx_block->entries);
+	ext4_directory_dx_entry_t *p = dx_block->position + 1;
+
+	while ((p < dx_block->entries + count) &&
+	    (prefetch->count < EXT4_DIRECTORY_DX_PREFETCH)) {
+		uint32_t fblock;
+		if (ext4_filesystem_get_inode_data_block_index(inode_ref,
+		    ext4_directory_dx_entry_get_block(p), &fblock) != EOK)
+			break;
+
+		prefetch->fblocks[prefetch->count++] = fblock;
+		p++;
+	}
+
+	fid_t fid = 0;
+	if (prefetch->count > 0)
+		fid = fibril_create(ext4_directory_dx_prefetch_fibril, prefetch);
+
+	if (fid == 0) {
+		free(prefetch);
+		ext4_directory_dx_prefetch_done(fs);
+		return;
+	}
+
+	fibril_add_ready(fid);
+}
+
 /** Try to find directory entry using directory index.
  *
  * @param result    Output value - if entry will be found,
@@ -598,6 +716,8 @@ errno_t ext4_directory_dx_find_entry(ext4_directory_search_result_t *result,
 		return EXT4_ERR_BAD_DX_DIR;
 	}
 
+	ext4_directory_dx_prefetch(inode_ref, dx_block);
+
 	do {
 		/* Load leaf block */
 		uint32_t leaf_block_idx =
@@ -686,6 +806,287 @@ static int ext4_directory_dx_entry_comparator(const void *arg1,
 		return 1;
 }
 
+/** Convert a linear directory to an indexed one.
+ *
+ * All entries of the directory are sorted by hash value and distributed
+ * among leaf blocks, block 0 is rewritten as the index root. The directory
+ * keeps its blocks and gets one more leaf, which leaves room for new entries
+ * in every leaf.
+ *
+ * @param dir Directory i-node
+ *
+ * @return ENOTSUP if the directory cannot be converted (it is left unchanged
+ *         in that case), other error code on failure
+ *
+ */
+errno_t ext4_directory_dx_convert(ext4_inode_ref_t *dir)
+{
+	ext4_superblock_t *sb = dir->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+	uint32_t total_blocks =
+	    ext4_inode_get_size(sb, dir->inode) / block_size;
+
+	uint32_t entry_space = block_size -
+	    2 * sizeof(ext4_directory_dx_dot_entry_t) -
+	    sizeof(ext4_directory_dx_root_info_t);
+	uint16_t root_limit = entry_space / sizeof(ext4_directory_dx_entry_t);
+
+	/* Leave room in the root for splitting the leaves later */
+	if ((total_blocks < 2) || (total_blocks > root_limit / 2u))
+		return ENOTSUP;
+
+	ext4_hash_info_t hinfo;
+	uint8_t hash_version = ext4_superblock_get_default_hash_version(sb);
+	if ((hash_version != EXT4_HASH_VERSION_TEA) &&
+	    (hash_version != EXT4_HASH_VERSION_HALF_MD4) &&
+	    (hash_version != EXT4_HASH_VERSION_LEGACY))
+		return ENOTSUP;
+
+	hinfo.hash_version = hash_version;
+	if (ext4_superblock_has_flag(sb, EXT4_SUPERBLOCK_FLAGS_UNSIGNED_HASH))
+		hinfo.hash_version += 3;
+	hinfo.seed = ext4_superblock_get_hash_seed(sb);
+
+	uint32_t *fblocks = malloc(total_blocks * sizeof(uint32_t));
+	void *entry_buffer = malloc(total_blocks * block_size);
+	uint32_t max_entry_count = total_blocks * block_size /
+	    sizeof(ext4_directory_dx_dot_entry_t);
+	ext4_dx_sort_entry_t *sort_array =
+	    malloc(max_entry_count * sizeof(ext4_dx_sort_entry_t));
+	uint32_t *leaf_start = malloc((total_blocks + 1) * sizeof(uint32_t));
+	if ((fblocks == NULL) || (entry_buffer == NULL) ||
+	    (sort_array == NULL) || (leaf_start == NULL)) {
+		free(fblocks);
+		free(entry_buffer);
+		free(sort_array);
+		free(leaf_start);
+		return ENOMEM;
+	}
+
+	errno_t rc;
+	uint32_t idx = 0;
+	uint32_t real_size = 0;
+	uint32_t parent_index = 0;
+	void *entry_buffer_ptr = entry_buffer;
+
+	/* Load all valid entries except the dot entries to the buffer */
+	for (uint32_t iblock = 0; iblock < total_blocks; iblock++) {
+		rc = ext4_filesystem_get_inode_data_block_index(dir, iblock,
+		    &fblocks[iblock]);
+		if (rc != EOK)
+			goto out;
+
+		/* Holes cannot be handled */
+		if (fblocks[iblock] == 0) {
+			rc = ENOTSUP;
+			goto out;
+		}
+
+		block_t *block;
+		rc = block_get(&block, dir->fs->device, fblocks[iblock],
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			goto out;
+
+		uint32_t offset = 0;
+		while (offset < block_size) {
+			ext4_directory_entry_ll_t *dentry = block->data + offset;
+			uint16_t entry_len =
+			    ext4_directory_entry_ll_get_entry_length(dentry);
+			uint16_t name_len =
+			    ext4_directory_entry_ll_get_name_length(sb, dentry);
+
+			if ((entry_len < 8) || ((entry_len % 4) != 0) ||
+			    (offset + entry_len > block_size) ||
+			    (8u + name_len > entry_len)) {
+				block_put(block);
+				rc = ENOTSUP;
+				goto out;
+			}
+
+			uint32_t inode = ext4_directory_entry_ll_get_inode(dentry);
+			bool dot = (name_len == 1) && (dentry->name[0] == '.');
+			bool dotdot = (name_len == 2) &&
+			    (dentry->name[0] == '.') && (dentry->name[1] == '.');
+
+			if (dotdot) {
+				parent_index = inode;
+			} else if ((inode != 0) && !dot) {
+				ext4_hash_string(&hinfo, name_len,
+				    (char *) dentry->name);
+
+				uint32_t rec_len = 8 + name_len;
+				if ((rec_len % 4) != 0)
+					rec_len += 4 - (rec_len % 4);
+
+				memcpy(entry_buffer_ptr, dentry, rec_len);
+
+				sort_array[idx].dentry = entry_buffer_ptr;
+				sort_array[idx].rec_len = rec_len;
+				sort_array[idx].hash = hinfo.hash;
+
+				entry_buffer_ptr += rec_len;
+				real_size += rec_len;
+				idx++;
+			}
+
+			offset += entry_len;
+		}
+
+		rc = block_put(block);
+		if (rc != EOK)
+			goto out;
+	}
+
+	/* Every leaf gets at least one entry */
+	uint32_t leaf_count = total_blocks;
+	if ((parent_index == 0) || (idx < leaf_count)) {
+		rc = ENOTSUP;
+		goto out;
+	}
+
+	qsort(sort_array, idx, sizeof(ext4_dx_sort_entry_t),
+	    ext4_directory_dx_entry_comparator);
+
+	/*
+	 * Distribute the entries evenly, the first entry of each leaf is
+	 * stored in leaf_start. Check that everything fits before anything
+	 * is written.
+	 */
+	uint32_t target = (real_size + leaf_count - 1) / leaf_count;
+	uint32_t leaf = 0;
+	uint32_t current_size = 0;
+
+	leaf_start[0] = 0;
+	for (uint32_t i = 0; i < idx; i++) {
+		uint32_t remaining_leaves = leaf_count - leaf - 1;
+		uint32_t remaining_entries = idx - i;
+
+		if ((current_size > 0) && (remaining_leaves > 0) &&
+		    ((current_size + sort_array[i].rec_len > target) ||
+		    (remaining_entries == remaining_leaves))) {
+			leaf_start[++leaf] = i;
+			current_size = 0;
+		}
+
+		current_size += sort_array[i].rec_len;
+		if (current_size > block_size) {
+			rc = ENOTSUP;
+			goto out;
+		}
+	}
+
+	leaf_start[leaf_count] = idx;
+
+	/* Append the extra leaf */
+	uint32_t new_fblock;
+	uint32_t new_iblock;
+	rc = ext4_filesystem_append_inode_block(dir, &new_fblock, &new_iblock);
+	if (rc != EOK)
+		goto out;
+
+	/* Write the leaves to blocks 1 .. leaf_count */
+	for (leaf = 0; leaf < leaf_count; leaf++) {
+		uint32_t fblock = (leaf + 1 < total_blocks) ?
+		    fblocks[leaf + 1] : new_fblock;
+
+		block_t *block;
+		rc = block_get(&block, dir->fs->device, fblock,
+		    BLOCK_FLAGS_NOREAD);
+		if (rc != EOK)
+			goto out;
+
+		uint32_t offset = 0;
+		for (uint32_t i = leaf_start[leaf]; i < leaf_start[leaf + 1];
+		    i++) {
+			void *ptr = block->data + offset;
+			memcpy(ptr, sort_array[i].dentry, sort_array[i].rec_len);
+
+			if (i < leaf_start[leaf + 1] - 1)
+				ext4_directory_entry_ll_set_entry_length(ptr,
+				    sort_array[i].rec_len);
+			else
+				ext4_directory_entry_ll_set_entry_length(ptr,
+				    block_size - offset);
+
+			offset += sort_array[i].rec_len;
+		}
+
+		block->dirty = true;
+		rc = block_put(block);
+		if (rc != EOK)
+			goto out;
+	}
+
+	/* Rewrite block 0 as the index root */
+	block_t *root_block;
+	rc = block_get(&root_block, dir->fs->device, fblocks[0],
+	    BLOCK_FLAGS_NOREAD);
+	if (rc != EOK)
+		goto out;
+
+	memset(root_block->data, 0, block_size);
+	ext4_directory_dx_root_t *root = root_block->data;
+
+	ext4_directory_entry_ll_t *dot =
+	    (ext4_directory_entry_ll_t *) &root->dots[0];
+	ext4_directory_entry_ll_set_inode(dot, dir->index);
+	ext4_directory_entry_ll_set_entry_length(dot, 12);
+	ext4_directory_entry_ll_set_name_length(sb, dot, 1);
+	ext4_directory_entry_ll_set_inode_type(sb, dot,
+	    EXT4_DIRECTORY_FILETYPE_DIR);
+	dot->name[0] = '.';
+
+	ext4_directory_entry_ll_t *dotdot =
+	    (ext4_directory_entry_ll_t *) &root->dots[1];
+	ext4_directory_entry_ll_set_inode(dotdot, parent_index);
+	ext4_directory_entry_ll_set_entry_length(dotdot, block_size - 12);
+	ext4_directory_entry_ll_set_name_length(sb, dotdot, 2);
+	ext4_directory_entry_ll_set_inode_type(sb, dotdot,
+	    EXT4_DIRECTORY_FILETYPE_DIR);
+	dotdot->name[0] = '.';
+	dotdot->name[1] = '.';
+
+	ext4_directory_dx_root_info_set_hash_version(&root->info, hash_version);
+	ext4_directory_dx_root_info_set_indirect_levels(&root->info, 0);
+	ext4_directory_dx_root_info_set_info_length(&root->info, 8);
+
+	ext4_directory_dx_countlimit_t *countlimit =
+	    (ext4_directory_dx_countlimit_t *) &root->entries;
+	ext4_directory_dx_countlimit_set_limit(countlimit, root_limit);
+	ext4_directory_dx_countlimit_set_count(countlimit, leaf_count);
+
+	ext4_directory_dx_entry_set_block(&root->entries[0], 1);
+	for (leaf = 1; leaf < leaf_count; leaf++) {
+		uint32_t first = leaf_start[leaf];
+		uint32_t hash = sort_array[first].hash;
+
+		/* Mark hash collision with the previous leaf */
+		if (hash == sort_array[first - 1].hash)
+			hash |= 1;
+
+		ext4_directory_dx_entry_set_hash(&root->entries[leaf], hash);
+		ext4_directory_dx_entry_set_block(&root->entries[leaf],
+		    leaf + 1);
+	}
+
+	root_block->dirty = true;
+	rc = block_put(root_block);
+	if (rc != EOK)
+		goto out;
+
+	ext4_inode_set_flag(dir->inode, EXT4_INODE_FLAG_INDEX);
+	dir->dirty = true;
+	ext4_dir_cache_invalidate(dir->fs, dir->index);
+
+out:
+	free(fblocks);
+	free(entry_buffer);
+	free(sort_array);
+	free(leaf_start);
+	return rc;
+}
+
 /** Insert new index entry to block.
  *
  * Note that space for new entry must be checked by caller.
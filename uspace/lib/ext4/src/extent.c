@@ -36,6 +36,7 @@
 
 #include <byteorder.h>
 #include <errno.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include "ext4/balloc.h"
@@ -441,6 +442,118 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 	return rc;
 }
 
+/** Find a run of physical blocks in the extent tree.
+ *
+ * Like ext4_extent_find_block(), but also returns how many of the following
+ * logical blocks are stored contiguously on the device, so that the caller can
+ * transfer them at once. A run of logical blocks which are not mapped to
+ * device blocks (or mapped by an uninitialized extent) is reported with
+ * physical block 0.
+ *
+ * @param inode_ref I-node to load blocks from
+ * @param iblock    Logical number of the first block of the run
+ * @param fblock    Output value for physical number of the first block
+ * @param count     Output value for number of blocks in the run
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_extent_find_blocks(ext4_inode_ref_t *inode_ref, uint32_t iblock,
+    uint32_t *fblock, uint32_t *count)
+{
+	errno_t rc = EOK;
+	/* Compute bound defined by i-node size */
+	uint64_t inode_size =
+	    ext4_inode_get_size(inode_ref->fs->superblock, inode_ref->inode);
+
+	uint32_t block_size =
+	    ext4_superblock_get_block_size(inode_ref->fs->superblock);
+
+	uint32_t last_idx = (inode_size - 1) / block_size;
+
+	*fblock = 0;
+	*count = 1;
+
+	/* Check if requested iblock is not over size of i-node */
+	if (inode_size == 0 || iblock > last_idx)
+		return EOK;
+
+	block_t *block = NULL;
+
+	/* Walk through extent tree */
+	ext4_extent_header_t *header =
+	    ext4_inode_get_extent_header(inode_ref->inode);
+
+	while (ext4_extent_header_get_depth(header) != 0) {
+		/* Search index in node */
+		ext4_extent_index_t *index;
+		ext4_extent_binsearch_idx(header, &index, iblock);
+
+		/* Load child node and set values for the next iteration */
+		uint64_t child = ext4_extent_index_get_leaf(index);
+
+		if (block != NULL) {
+			rc = block_put(block);
+			if (rc != EOK)
+				return rc;
+		}
+
+		rc = block_get(&block, inode_ref->fs->device, child,
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			return rc;
+
+		header = (ext4_extent_header_t *)block->data;
+	}
+
+	/* Search extent in the leaf block */
+	ext4_extent_t *extent = NULL;
+	ext4_extent_binsearch(header, &extent, iblock);
+
+	/* Blocks up to the end of file or to the next extent in the leaf */
+	uint32_t run = last_idx - iblock + 1;
+
+	if (extent != NULL) {
+		uint32_t first = ext4_extent_get_first_block(extent);
+		uint32_t len = ext4_extent_get_block_count(extent);
+		bool uninit = false;
+
+		if (len > EXT4_EXTENT_MAX_INIT_LEN) {
+			len -= EXT4_EXTENT_MAX_INIT_LEN;
+			uninit = true;
+		}
+
+		if (iblock >= first && iblock < first + len) {
+			run = min(run, first + len - iblock);
+			if (!uninit) {
+				*fblock = ext4_extent_get_start(extent) +
+				    iblock - first;
+			}
+		} else {
+			ext4_extent_t *last = EXT4_EXTENT_FIRST(header) +
+			    ext4_extent_header_get_entries_count(header) - 1;
+			ext4_extent_t *next = (iblock < first) ? extent :
+			    extent + 1;
+
+			if (next <= last) {
+				run = min(run,
+				    ext4_extent_get_first_block(next) - iblock);
+			} else if (block != NULL) {
+				/* The next extent may be in another leaf */
+				run = 1;
+			}
+		}
+	}
+
+	*count = run;
+
+	/* Cleanup */
+	if (block != NULL)
+		rc = block_put(block);
+
+	return rc;
+}
+
 /** Find extent for specified iblock.
  *
  * This function is used for finding block in the extent tree with
@@ -948,6 +1061,152 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 	return EOK;
 }
 
+/** Append a contiguous run of data blocks to the i-node.
+ *
+ * Up to @a count blocks are allocated at once and appended after the last
+ * block of the i-node. The last extent is extended if the blocks following it
+ * are free, otherwise a new extent is added. Fewer blocks than requested may
+ * be appended if there is no long enough free run on the device.
+ *
+ * The size of the i-node is not updated, this is left to the caller.
+ *
+ * @param inode_ref I-node to append blocks to
+ * @param count     Number of blocks to append
+ * @param iblock    Output logical number of the first appended block
+ * @param fblock    Output physical number of the first appended block
+ * @param appended  Output number of appended blocks
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_extent_append_blocks(ext4_inode_ref_t *inode_ref, uint32_t count,
+    uint32_t *iblock, uint32_t *fblock, uint32_t *appended)
+{
+	ext4_superblock_t *sb = inode_ref->fs->superblock;
+	uint64_t inode_size = ext4_inode_get_size(sb, inode_ref->inode);
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	/* Calculate number of new logical block */
+	uint32_t new_block_idx = 0;
+	if (inode_size > 0) {
+		if ((inode_size % block_size) != 0)
+			inode_size += block_size - (inode_size % block_size);
+
+		new_block_idx = inode_size / block_size;
+	}
+
+	/* Load the nearest leaf (with extent) */
+	ext4_extent_path_t *path;
+	errno_t rc2;
+	errno_t rc = ext4_extent_find_extent(inode_ref, new_block_idx, &path);
+	if (rc != EOK)
+		return rc;
+
+	/* Jump to last item of the path (extent) */
+	ext4_extent_path_t *path_ptr = path;
+	while (path_ptr->depth != 0)
+		path_ptr++;
+
+	uint32_t phys_block = 0;
+	uint32_t allocated = 0;
+
+	/* Add new extent to the node if not present */
+	if (path_ptr->extent == NULL)
+		goto append_extent;
+
+	uint16_t block_count = ext4_extent_get_block_count(path_ptr->extent);
+
+	if (block_count == 0) {
+		/* Existing extent is empty */
+		rc = ext4_balloc_alloc_blocks(inode_ref,
+		    min(count, EXT4_EXTENT_MAX_INIT_LEN), &phys_block,
+		    &allocated);
+		if (rc != EOK)
+			goto finish;
+
+		/* Initialize extent */
+		ext4_extent_set_first_block(path_ptr->extent, new_block_idx);
+		ext4_extent_set_start(path_ptr->extent, phys_block);
+		ext4_extent_set_block_count(path_ptr->extent, allocated);
+
+		path_ptr->block->dirty = true;
+		goto finish;
+	}
+
+	if (block_count < EXT4_EXTENT_MAX_INIT_LEN) {
+		/* Try to extend the existing extent in place */
+		phys_block = ext4_extent_get_start(path_ptr->extent) +
+		    block_count;
+
+		rc = ext4_balloc_try_alloc_blocks(inode_ref, phys_block,
+		    min(count, EXT4_EXTENT_MAX_INIT_LEN - block_count),
+		    &allocated);
+		if (rc != EOK)
+			goto finish;
+
+		if (allocated > 0) {
+			ext4_extent_set_block_count(path_ptr->extent,
+			    block_count + allocated);
+
+			path_ptr->block->dirty = true;
+			goto finish;
+		}
+	}
+
+append_extent:
+	/* Append new extent to the tree */
+	phys_block = 0;
+
+	/* Allocate new data blocks */
+	rc = ext4_balloc_alloc_blocks(inode_ref,
+	    min(count, EXT4_EXTENT_MAX_INIT_LEN), &phys_block, &allocated);
+	if (rc != EOK)
+		goto finish;
+
+	/* Append extent for new blocks (includes tree splitting if needed) */
+	rc = ext4_extent_append_extent(inode_ref, path, new_block_idx);
+	if (rc != EOK) {
+		ext4_balloc_free_blocks(inode_ref, phys_block, allocated);
+		allocated = 0;
+		goto finish;
+	}
+
+	uint32_t tree_depth = ext4_extent_header_get_depth(path->header);
+	path_ptr = path + tree_depth;
+
+	/* Initialize newly created extent */
+	ext4_extent_set_block_count(path_ptr->extent, allocated);
+	ext4_extent_set_first_block(path_ptr->extent, new_block_idx);
+	ext4_extent_set_start(path_ptr->extent, phys_block);
+
+	path_ptr->block->dirty = true;
+
+finish:
+	rc2 = EOK;
+
+	/* Set return values */
+	*iblock = new_block_idx;
+	*fblock = phys_block;
+	*appended = allocated;
+
+	/*
+	 * Put loaded blocks
+	 * starting from 1: 0 is a block with inode data
+	 */
+	for (uint16_t i = 1; i <= path->depth; ++i) {
+		if (path[i].block) {
+			rc2 = block_put(path[i].block);
+			if (rc == EOK && rc2 != EOK)
+				rc = rc2;
+		}
+	}
+
+	/* Destroy temporary data structure */
+	free(path);
+
+	return rc;
+}
+
 /** Append data block to the i-node.
  *
  * This function allocates data block, tries to append it
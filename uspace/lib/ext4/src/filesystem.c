@@ -36,8 +36,10 @@
  * @brief More complex filesystem operations.
  */
 
+#include <assert.h>
 #include <byteorder.h>
 #include <errno.h>
+#include <macros.h>
 #include <mem.h>
 #include <align.h>
 #include <crypto.h>
@@ -48,11 +50,13 @@
 #include "ext4/bitmap.h"
 #include "ext4/block_group.h"
 #include "ext4/cfg.h"
+#include "ext4/dir_cache.h"
 #include "ext4/directory.h"
 #include "ext4/extent.h"
 #include "ext4/filesystem.h"
 #include "ext4/ialloc.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/ops.h"
 #include "ext4/superblock.h"
 
@@ -80,6 +84,10 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 	ext4_superblock_t *temp_superblock = NULL;
 
 	fs->device = service_id;
+	fs->dir_cache = NULL;
+	fibril_mutex_initialize(&fs->dx_prefetch_lock);
+	fibril_condvar_initialize(&fs->dx_prefetch_cv);
+	fs->dx_prefetches = 0;
 
 	/* Initialize block library (4096 is size of communication channel) */
 	rc = block_init(fs->device, 4096);
@@ -103,6 +111,13 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 	if (rc != EOK)
 		goto err_1;
 
+	/*
+	 * Queue device requests so that those of concurrent fibrils (e.g.
+	 * directory index prefetch) are sorted and merged. If this fails,
+	 * requests are simply passed to the device one by one.
+	 */
+	(void) block_sched_set(fs->device, BLOCK_SCHED_DEADLINE, 2);
+
 	/* Compute limits for indirect block levels */
 	uint32_t block_ids_per_block = block_size / sizeof(uint32_t);
 	fs->inode_block_limits[0] = EXT4_INODE_DIRECT_BLOCK_COUNT;
@@ -119,10 +134,17 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 
 	uint16_t state = ext4_superblock_get_state(fs->superblock);
 
-	if (((state & EXT4_SUPERBLOCK_STATE_VALID_FS) !=
+	/*
+	 * A journaled file system which was not unmounted properly is made
+	 * consistent by replaying the journal when it is mounted.
+	 */
+	bool journaled = ext4_superblock_has_feature_compatible(fs->superblock,
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL);
+
+	if (!journaled && (((state & EXT4_SUPERBLOCK_STATE_VALID_FS) !=
 	    EXT4_SUPERBLOCK_STATE_VALID_FS) ||
 	    ((state & EXT4_SUPERBLOCK_STATE_ERROR_FS) ==
-	    EXT4_SUPERBLOCK_STATE_ERROR_FS)) {
+	    EXT4_SUPERBLOCK_STATE_ERROR_FS))) {
 		rc = ENOTSUP;
 		goto err_2;
 	}
@@ -155,6 +177,14 @@ err:
  */
 static void ext4_filesystem_fini(ext4_filesystem_t *fs)
 {
+	/* Wait for prefetches which still use the block cache */
+	fibril_mutex_lock(&fs->dx_prefetch_lock);
+	while (fs->dx_prefetches > 0)
+		fibril_condvar_wait(&fs->dx_prefetch_cv, &fs->dx_prefetch_lock);
+	fibril_mutex_unlock(&fs->dx_prefetch_lock);
+
+	ext4_dir_cache_fini(fs);
+
 	/* Release memory space for superblock */
 	free(fs->superblock);
 
@@ -348,6 +378,13 @@ errno_t ext4_filesystem_create(ext4_cfg_t *cfg, service_id_t service_id)
 	if (rc != EOK)
 		goto err;
 
+	/* Create journal */
+	if (cfg->journal_blocks > 0) {
+		rc = ext4_journal_create(fs, cfg->journal_blocks);
+		if (rc != EOK)
+			goto err;
+	}
+
 	/* Write superblock to device */
 	rc = ext4_superblock_write_direct(service_id, fs->superblock);
 	if (rc != EOK)
@@ -440,6 +477,11 @@ errno_t ext4_filesystem_open(ext4_instance_t *inst, service_id_t service_id,
 
 	fs_inited = 1;
 
+	/* Replay the journal if needed and start journaling */
+	rc = ext4_journal_open(fs);
+	if (rc != EOK)
+		goto error;
+
 	/* Read root node */
 	rc = ext4_node_get_core(&root_node, inst, EXT4_INODE_ROOT_INDEX);
 	if (rc != EOK)
@@ -465,8 +507,10 @@ error:
 	if (root_node != NULL)
 		ext4_node_put(root_node);
 
-	if (fs_inited)
+	if (fs_inited) {
+		(void) ext4_journal_close(fs);
 		ext4_filesystem_fini(fs);
+	}
 	free(fs);
 	return rc;
 }
@@ -481,9 +525,14 @@ error:
  */
 errno_t ext4_filesystem_close(ext4_filesystem_t *fs)
 {
+	/* Write all journaled metadata to its home location */
+	errno_t rc = ext4_journal_close(fs);
+	if (rc != EOK)
+		return rc;
+
 	/* Write the superblock to the device */
 	ext4_superblock_set_state(fs->superblock, EXT4_SUPERBLOCK_STATE_VALID_FS);
-	errno_t rc = ext4_superblock_write_direct(fs->device, fs->superblock);
+	rc = ext4_superblock_write_direct(fs->device, fs->superblock);
 	if (rc != EOK)
 		return rc;
 
@@ -1504,10 +1553,13 @@ finish:
 	/* Free inode by allocator */
 	errno_t rc;
 	if (ext4_inode_is_type(fs->superblock, inode_ref->inode,
-	    EXT4_INODE_MODE_DIRECTORY))
+	    EXT4_INODE_MODE_DIRECTORY)) {
+		/* The i-node number may be reused by another directory */
+		ext4_dir_cache_invalidate(fs, inode_ref->index);
 		rc = ext4_ialloc_free_inode(fs, inode_ref->index, true);
-	else
+	} else {
 		rc = ext4_ialloc_free_inode(fs, inode_ref->index, false);
+	}
 
 	return rc;
 }
@@ -1689,6 +1741,63 @@ errno_t ext4_filesystem_get_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 	return EOK;
 }
 
+/** Get physical block addresses of consecutive logical blocks of the i-node.
+ *
+ * @param inode_ref I-node to read block addresses from
+ * @param iblock    Logical index of the first block
+ * @param max       Maximum number of blocks to look up
+ * @param fblock    Output physical address of the first block (0 if the
+ *                  blocks are not allocated)
+ * @param count     Output number of blocks (at least 1 and at most @a max)
+ *                  which are stored contiguously starting with @a fblock
+ *                  (or are all unallocated)
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_filesystem_get_inode_data_blocks(ext4_inode_ref_t *inode_ref,
+    aoff64_t iblock, uint32_t max, uint32_t *fblock, uint32_t *count)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	errno_t rc;
+
+	assert(max > 0);
+
+	/* Extents describe whole runs of blocks */
+	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
+		rc = ext4_extent_find_blocks(inode_ref, iblock, fblock, count);
+		if (rc != EOK)
+			return rc;
+
+		*count = min(*count, max);
+		return EOK;
+	}
+
+	rc = ext4_filesystem_get_inode_data_block_index(inode_ref, iblock,
+	    fblock);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t n = 1;
+	while (n < max) {
+		uint32_t next;
+		rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
+		    iblock + n, &next);
+		if (rc != EOK)
+			return rc;
+
+		if (next != (*fblock == 0 ? 0 : *fblock + n))
+			break;
+
+		n++;
+	}
+
+	*count = n;
+	return EOK;
+}
+
 /** Set physical block address for the block logical address into the i-node.
  *
  * @param inode_ref I-node to set block address to
@@ -34,14 +34,243 @@
  * @brief Hashing algorithms for ext4 HTree.
  */
 
+#include <byteorder.h>
 #include <errno.h>
+#include <mem.h>
 #include "ext4/hash.h"
 
+#define TEA_DELTA  0x9E3779B9
+
+#define MD4_F(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#define MD4_G(x, y, z)  (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define MD4_H(x, y, z)  ((x) ^ (y) ^ (z))
+
+#define MD4_K1  UINT32_C(0)
+#define MD4_K2  UINT32_C(013240474631)
+#define MD4_K3  UINT32_C(015666365641)
+
+#define MD4_ROUND(f, a, b, c, d, x, s) \
+	do { \
+		(a) += f((b), (c), (d)) + (x); \
+		(a) = ((a) << (s)) | ((a) >> (32 - (s))); \
+	} while (0)
+
+/** TEA block transformation.
+ *
+ * @param buf Hash state
+ * @param in  Input block of four words
+ *
+ */
+static void ext4_hash_tea_transform(uint32_t buf[4], const uint32_t in[4])
+{
+	uint32_t sum = 0;
+	uint32_t b0 = buf[0];
+	uint32_t b1 = buf[1];
+
+	for (unsigned int n = 0; n < 16; n++) {
+		sum += TEA_DELTA;
+		b0 += ((b1 << 4) + in[0]) ^ (b1 + sum) ^ ((b1 >> 5) + in[1]);
+		b1 += ((b0 << 4) + in[2]) ^ (b0 + sum) ^ ((b0 >> 5) + in[3]);
+	}
+
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+/** Reduced MD4 block transformation.
+ *
+ * @param buf Hash state
+ * @param in  Input block of eight words
+ *
+ */
+static void ext4_hash_half_md4_transform(uint32_t buf[4],
+    const uint32_t in[8])
+{
+	uint32_t a = buf[0];
+	uint32_t b = buf[1];
+	uint32_t c = buf[2];
+	uint32_t d = buf[3];
+
+	MD4_ROUND(MD4_F, a, b, c, d, in[0] + MD4_K1, 3);
+	MD4_ROUND(MD4_F, d, a, b, c, in[1] + MD4_K1, 7);
+	MD4_ROUND(MD4_F, c, d, a, b, in[2] + MD4_K1, 11);
+	MD4_ROUND(MD4_F, b, c, d, a, in[3] + MD4_K1, 19);
+	MD4_ROUND(MD4_F, a, b, c, d, in[4] + MD4_K1, 3);
+	MD4_ROUND(MD4_F, d, a, b, c, in[5] + MD4_K1, 7);
+	MD4_ROUND(MD4_F, c, d, a, b, in[6] + MD4_K1, 11);
+	MD4_ROUND(MD4_F, b, c, d, a, in[7] + MD4_K1, 19);
+
+	MD4_ROUND(MD4_G, a, b, c, d, in[1] + MD4_K2, 3);
+	MD4_ROUND(MD4_G, d, a, b, c, in[3] + MD4_K2, 5);
+	MD4_ROUND(MD4_G, c, d, a, b, in[5] + MD4_K2, 9);
+	MD4_ROUND(MD4_G, b, c, d, a, in[7] + MD4_K2, 13);
+	MD4_ROUND(MD4_G, a, b, c, d, in[0] + MD4_K2, 3);
+	MD4_ROUND(MD4_G, d, a, b, c, in[2] + MD4_K2, 5);
+	MD4_ROUND(MD4_G, c, d, a, b, in[4] + MD4_K2, 9);
+	MD4_ROUND(MD4_G, b, c, d, a, in[6] + MD4_K2, 13);
+
+	MD4_ROUND(MD4_H, a, b, c, d, in[3] + MD4_K3, 3);
+	MD4_ROUND(MD4_H, d, a, b, c, in[7] + MD4_K3, 9);
+	MD4_ROUND(MD4_H, c, d, a, b, in[2] + MD4_K3, 11);
+	MD4_ROUND(MD4_H, b, c, d, a, in[6] + MD4_K3, 15);
+	MD4_ROUND(MD4_H, a, b, c, d, in[1] + MD4_K3, 3);
+	MD4_ROUND(MD4_H, d, a, b, c, in[5] + MD4_K3, 9);
+	MD4_ROUND(MD4_H, c, d, a, b, in[0] + MD4_K3, 11);
+	MD4_ROUND(MD4_H, b, c, d, a, in[4] + MD4_K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+/** Original hash function of the directory index.
+ *
+ * @param name         Name to be hashed
+ * @param len          Length of the name
+ * @param unsigned_chr Treat characters of the name as unsigned
+ *
+ * @return Hash value
+ *
+ */
+static uint32_t ext4_hash_legacy(const char *name, int len, bool unsigned_chr)
+{
+	uint32_t hash;
+	uint32_t hash0 = 0x12a3fe2d;
+	uint32_t hash1 = 0x37abe8f9;
+
+	for (int i = 0; i < len; i++) {
+		int chr = unsigned_chr ? (int) (unsigned char) name[i] :
+		    (int) (signed char) name[i];
+
+		hash = hash1 + (hash0 ^ (uint32_t) (chr * 7152373));
+		if ((hash & 0x80000000) != 0)
+			hash -= 0x7fffffff;
+
+		hash1 = hash0;
+		hash0 = hash;
+	}
+
+	return hash0 << 1;
+}
+
+/** Convert part of a name to an input block of the hash transformations.
+ *
+ * @param name         Remaining part of the name
+ * @param len          Length of the remaining part
+ * @param buf          Input block to be filled
+ * @param num          Number of words in the input block
+ * @param unsigned_chr Treat characters of the name as unsigned
+ *
+ */
+static void ext4_hash_str2hashbuf(const char *name, int len, uint32_t *buf,
+    int num, bool unsigned_chr)
+{
+	uint32_t pad = (uint32_t) len | ((uint32_t) len << 8);
+	pad |= pad << 16;
+
+	uint32_t val = pad;
+	if (len > num * 4)
+		len = num * 4;
+
+	for (int i = 0; i < len; i++) {
+		int chr = unsigned_chr ? (int) (unsigned char) name[i] :
+		    (int) (signed char) name[i];
+
+		val = (uint32_t) chr + (val << 8);
+		if ((i % 4) == 3) {
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+
+	if (--num >= 0)
+		*buf++ = val;
+
+	while (--num >= 0)
+		*buf++ = pad;
+}
+
+/** Compute hash value of a directory entry name.
+ *
+ * The algorithms are compatible with the Linux implementation, so that
+ * directory indices can be shared with other systems.
+ *
+ * @param hinfo Hash info with version and seed, hash values are stored here
+ * @param len   Length of the name
+ * @param name  Name to be hashed
+ *
+ * @return Error code
+ *
+ */
 errno_t ext4_hash_string(ext4_hash_info_t *hinfo, int len, const char *name)
 {
-	// TODO
-	hinfo->hash = 0;
-	return ENOTSUP;
+	uint32_t buf[4] = {
+		0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476
+	};
+	uint32_t in[8];
+	uint32_t hash;
+	uint32_t minor_hash = 0;
+	bool unsigned_chr = false;
+
+	/* Use the seed only if it is not all zeros */
+	if (hinfo->seed != NULL) {
+		for (unsigned int i = 0; i < 4; i++) {
+			if (hinfo->seed[i] != 0) {
+				for (unsigned int j = 0; j < 4; j++)
+					buf[j] = uint32_t_le2host(hinfo->seed[j]);
+				break;
+			}
+		}
+	}
+
+	switch (hinfo->hash_version) {
+	case EXT4_HASH_VERSION_LEGACY_UNSIGNED:
+		unsigned_chr = true;
+		/* Fallthrough */
+	case EXT4_HASH_VERSION_LEGACY:
+		hash = ext4_hash_legacy(name, len, unsigned_chr);
+		break;
+	case EXT4_HASH_VERSION_HALF_MD4_UNSIGNED:
+		unsigned_chr = true;
+		/* Fallthrough */
+	case EXT4_HASH_VERSION_HALF_MD4:
+		for (int off = 0; off < len; off += 32) {
+			ext4_hash_str2hashbuf(name + off, len - off, in, 8,
+			    unsigned_chr);
+			ext4_hash_half_md4_transform(buf, in);
+		}
+
+		hash = buf[1];
+		minor_hash = buf[2];
+		break;
+	case EXT4_HASH_VERSION_TEA_UNSIGNED:
+		unsigned_chr = true;
+		/* Fallthrough */
+	case EXT4_HASH_VERSION_TEA:
+		for (int off = 0; off < len; off += 16) {
+			ext4_hash_str2hashbuf(name + off, len - off, in, 4,
+			    unsigned_chr);
+			ext4_hash_tea_transform(buf, in);
+		}
+
+		hash = buf[0];
+		minor_hash = buf[1];
+		break;
+	default:
+		hinfo->hash = 0;
+		return ENOTSUP;
+	}
+
+	/* The lowest bit is reserved for marking hash collisions */
+	hash &= ~UINT32_C(1);
+	if (hash == (EXT4_DIRECTORY_HTREE_EOF << 1))
+		hash = (EXT4_DIRECTORY_HTREE_EOF - 1) << 1;
+
+	hinfo->hash = hash;
+	hinfo->minor_hash = minor_hash;
+	return EOK;
 }
 
 /**
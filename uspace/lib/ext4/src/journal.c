@@ -0,0 +1,1779 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+/**
+ * @file  journal.c
+ * @brief Metadata journal compatible with JBD2 (ordered mode).
+ *
+ * Dirty metadata blocks are not written to their home locations. The block
+ * cache hands them over to the running transaction instead. File system
+ * operations are bracketed by ext4_journal_begin() and ext4_journal_end()
+ * and a transaction is closed only when no operation is in progress, so
+ * that each transaction contains whole operations. File data never passes
+ * through the journal. It is written to its home location before the
+ * transaction which references it commits.
+ *
+ * A background fibril commits the running transaction periodically or when
+ * it grows too large. Metadata updates of many operations are thus written
+ * to the log sequentially, in a single group commit. Committed blocks stay
+ * in memory until they are written to their home locations by a checkpoint,
+ * after which their log space is reused.
+ *
+ * The log of a journal which was not closed properly is replayed when the
+ * file system is mounted.
+ */
+
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <block.h>
+#include <byteorder.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <uuid.h>
+#include "ext4/filesystem.h"
+#include "ext4/inode.h"
+#include "ext4/journal.h"
+#include "ext4/superblock.h"
+
+/** Interval of the periodic commit (in microseconds) */
+#define EXT4_JOURNAL_COMMIT_INTERVAL  (5 * 1000 * 1000)
+
+/** Maximum number of metadata blocks in one transaction */
+#define EXT4_JOURNAL_MAX_TRANS_BLOCKS  1024
+
+/** Number of committed blocks which triggers a checkpoint */
+#define EXT4_JOURNAL_CHECKPOINT_BLOCKS  4096
+
+/** Maximum number of blocks transferred to or from the log at once */
+#define EXT4_JOURNAL_IO_BLOCKS  16
+
+/** Minimum size of a journal (in blocks) */
+#define EXT4_JOURNAL_MIN_BLOCKS  1024
+
+/** Passes of the journal recovery */
+typedef enum {
+	/** Find the end of the log */
+	ext4_journal_pass_scan,
+	/** Collect revoked blocks */
+	ext4_journal_pass_revoke,
+	/** Write logged blocks to their home locations */
+	ext4_journal_pass_replay
+} ext4_journal_pass_t;
+
+struct ext4_journal_trans;
+
+/** Copy of a metadata block logged by a transaction */
+typedef struct ext4_journal_buf {
+	/** Link in the table of current copies */
+	ht_link_t link;
+	/** Link in the list of blocks of the transaction */
+	link_t trans_link;
+	/** Transaction which logs the copy */
+	struct ext4_journal_trans *trans;
+	/** Copy of the same block logged by a later transaction */
+	struct ext4_journal_buf *newer;
+	/** Home location of the block */
+	uint64_t fblock;
+	/** The copy is the newest one (it is in the table of current copies) */
+	bool current;
+	/** The block has been freed and must not be written home */
+	bool revoked;
+	/** Contents of the block */
+	uint8_t data[];
+} ext4_journal_buf_t;
+
+/** Revocation of a block */
+typedef struct {
+	ht_link_t link;
+	link_t trans_link;
+	uint64_t fblock;
+	/** Sequence number of the last transaction revoking the block */
+	uint32_t sequence;
+} ext4_journal_revoke_t;
+
+/** Transaction */
+typedef struct ext4_journal_trans {
+	link_t link;
+	uint32_t sequence;
+	/** Logged blocks (ext4_journal_buf_t) */
+	list_t bufs;
+	/** Number of logged blocks which are not revoked */
+	size_t buf_count;
+	/** Revoked blocks (ext4_journal_revoke_t) */
+	list_t revokes;
+	size_t revoke_count;
+	/** Transaction is being checkpointed */
+	bool checkpoint;
+} ext4_journal_trans_t;
+
+/** Journal of a mounted file system */
+typedef struct ext4_journal {
+	ext4_filesystem_t *fs;
+	uint32_t block_size;
+	/** Number of device blocks per file system block */
+	uint32_t dev_blocks;
+
+	/** File system blocks of the journal inode */
+	uint32_t *map;
+	/** First and last + 1 log block */
+	uint32_t first;
+	uint32_t max_len;
+	/** In-memory copy of the journal superblock */
+	uint8_t *sb_block;
+	ext4_journal_superblock_t *sb;
+	uint32_t features_incompatible;
+	size_t tag_size;
+	size_t revoke_size;
+
+	/** Protects the state below */
+	fibril_mutex_t lock;
+	/** Signalled when handles or the running transaction change */
+	fibril_condvar_t cv;
+	/** Wakes up the commit fibril */
+	fibril_condvar_t kick_cv;
+	/** Number of active handles */
+	unsigned handles;
+	/** A commit waits for active handles to finish */
+	bool locked;
+	bool kick;
+	bool stop;
+	bool done;
+	/** First error which aborted the journal */
+	errno_t error;
+
+	ext4_journal_trans_t *running;
+	/** Committed transactions which are not checkpointed yet */
+	list_t committed;
+	size_t committed_blocks;
+	/** Current copies of blocks (ext4_journal_buf_t) */
+	hash_table_t bufs;
+	/** Revocations by the running transaction (ext4_journal_revoke_t) */
+	hash_table_t revokes;
+
+	/** Serializes commits and checkpoints, protects the log state below */
+	fibril_mutex_t commit_lock;
+	/** Next free log block */
+	uint32_t head;
+	/** Oldest log block which is still needed */
+	uint32_t tail;
+	bool log_empty;
+	uint32_t max_trans;
+	uint32_t checkpoint_limit;
+} ext4_journal_t;
+
+/** Nesting depth of journal handles of the current fibril */
+static fibril_local unsigned handle_depth;
+
+static size_t ext4_journal_buf_key_hash(const void *key)
+{
+	const uint64_t *fblock = key;
+	return *fblock;
+}
+
+static size_t ext4_journal_buf_hash(const ht_link_t *item)
+{
+	ext4_journal_buf_t *buf =
+	    hash_table_get_inst(item, ext4_journal_buf_t, link);
+	return buf->fblock;
+}
+
+static bool ext4_journal_buf_key_equal(const void *key, const ht_link_t *item)
+{
+	const uint64_t *fblock = key;
+	ext4_journal_buf_t *buf =
+	    hash_table_get_inst(item, ext4_journal_buf_t, link);
+	return buf->fblock == *fblock;
+}
+
+static hash_table_ops_t ext4_journal_buf_ops = {
+	.hash = ext4_journal_buf_hash,
+	.key_hash = ext4_journal_buf_key_hash,
+	.key_equal = ext4_journal_buf_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static size_t ext4_journal_revoke_hash(const ht_link_t *item)
+{
+	ext4_journal_revoke_t *revoke =
+	    hash_table_get_inst(item, ext4_journal_revoke_t, link);
+	return revoke->fblock;
+}
+
+static bool ext4_journal_revoke_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const uint64_t *fblock = key;
+	ext4_journal_revoke_t *revoke =
+	    hash_table_get_inst(item, ext4_journal_revoke_t, link);
+	return revoke->fblock == *fblock;
+}
+
+static hash_table_ops_t ext4_journal_revoke_ops = {
+	.hash = ext4_journal_revoke_hash,
+	.key_hash = ext4_journal_buf_key_hash,
+	.key_equal = ext4_journal_revoke_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Get the log block following a given one.
+ *
+ * @param journal Journal
+ * @param pos     Log block
+ *
+ * @return Next log block
+ *
+ */
+static uint32_t ext4_journal_next(ext4_journal_t *journal, uint32_t pos)
+{
+	pos++;
+	if (pos >= journal->max_len)
+		pos = journal->first;
+
+	return pos;
+}
+
+/** Transfer consecutive log blocks.
+ *
+ * The log wraps around at its end.
+ *
+ * @param journal Journal
+ * @param pos     First log block
+ * @param count   Number of blocks
+ * @param buf     Buffer for the data
+ * @param write   Write the blocks instead of reading them
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_log_io(ext4_journal_t *journal, uint32_t pos,
+    uint32_t count, void *buf, bool write)
+{
+	uint8_t *data = buf;
+	errno_t rc;
+
+	while (count > 0) {
+		/* Transfer blocks which are contiguous on the device at once */
+		uint32_t run = 1;
+		while (run < count && run < EXT4_JOURNAL_IO_BLOCKS &&
+		    pos + run < journal->max_len &&
+		    journal->map[pos + run] == journal->map[pos] + run)
+			run++;
+
+		if (write) {
+			rc = block_write_range(journal->fs->device,
+			    journal->map[pos], run, data);
+		} else {
+			rc = block_read_range(journal->fs->device,
+			    journal->map[pos], run, data);
+		}
+		if (rc != EOK)
+			return rc;
+
+		data += run * journal->block_size;
+		count -= run;
+		pos += run;
+		if (pos >= journal->max_len)
+			pos = journal->first;
+	}
+
+	return EOK;
+}
+
+/** Make the blocks written so far persistent.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_flush(ext4_journal_t *journal)
+{
+	errno_t rc = block_sync_cache(journal->fs->device, 0, 0);
+
+	/* Devices without a volatile cache do not need flushing */
+	if (rc == ENOTSUP)
+		rc = EOK;
+
+	return rc;
+}
+
+/** Update the start of the log in the journal superblock.
+ *
+ * @param journal  Journal
+ * @param start    First log block or zero if the log is empty
+ * @param sequence Sequence number of the first transaction in the log
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_write_sb(ext4_journal_t *journal, uint32_t start,
+    uint32_t sequence)
+{
+	journal->sb->start = host2uint32_t_be(start);
+	journal->sb->sequence = host2uint32_t_be(sequence);
+
+	errno_t rc = block_write_range(journal->fs->device, journal->map[0], 1,
+	    journal->sb_block);
+	if (rc != EOK)
+		return rc;
+
+	return ext4_journal_flush(journal);
+}
+
+/** Allocate an empty transaction.
+ *
+ * @return New transaction or NULL if out of memory
+ *
+ */
+static ext4_journal_trans_t *ext4_journal_trans_create(void)
+{
+	ext4_journal_trans_t *trans = calloc(1, sizeof(ext4_journal_trans_t));
+	if (trans == NULL)
+		return NULL;
+
+	link_initialize(&trans->link);
+	list_initialize(&trans->bufs);
+	list_initialize(&trans->revokes);
+
+	return trans;
+}
+
+/** Free a transaction with all its blocks.
+ *
+ * The blocks are removed from the table of current copies.
+ *
+ * @param journal Journal
+ * @param trans   Transaction to free
+ *
+ */
+static void ext4_journal_trans_destroy(ext4_journal_t *journal,
+    ext4_journal_trans_t *trans)
+{
+	while (!list_empty(&trans->bufs)) {
+		ext4_journal_buf_t *buf = list_get_instance(
+		    list_first(&trans->bufs), ext4_journal_buf_t, trans_link);
+		list_remove(&buf->trans_link);
+		if (buf->current)
+			hash_table_remove_item(&journal->bufs, &buf->link);
+		free(buf);
+	}
+
+	while (!list_empty(&trans->revokes)) {
+		ext4_journal_revoke_t *revoke = list_get_instance(
+		    list_first(&trans->revokes), ext4_journal_revoke_t,
+		    trans_link);
+		list_remove(&revoke->trans_link);
+		free(revoke);
+	}
+
+	free(trans);
+}
+
+/** Take over a dirty block from the block cache.
+ *
+ * @param arg  Journal
+ * @param ba   File system block
+ * @param data Contents of the block
+ * @param size Size of the block
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_block_write(void *arg, aoff64_t ba,
+    const void *data, size_t size)
+{
+	ext4_journal_t *journal = arg;
+	uint64_t fblock = ba;
+
+	assert(size == journal->block_size);
+
+	fibril_mutex_lock(&journal->lock);
+
+	ext4_journal_trans_t *running = journal->running;
+	ext4_journal_buf_t *old = NULL;
+	ht_link_t *link = hash_table_find(&journal->bufs, &fblock);
+	if (link != NULL) {
+		old = hash_table_get_inst(link, ext4_journal_buf_t, link);
+		if (old->trans == running) {
+			/* Already logged by the running transaction */
+			memcpy(old->data, data, size);
+			fibril_mutex_unlock(&journal->lock);
+			return EOK;
+		}
+	}
+
+	/*
+	 * Copies logged by closed transactions must not change. Log a new
+	 * copy in the running transaction.
+	 */
+	ext4_journal_buf_t *buf = malloc(sizeof(ext4_journal_buf_t) + size);
+	if (buf == NULL) {
+		fibril_mutex_unlock(&journal->lock);
+		return ENOMEM;
+	}
+
+	link_initialize(&buf->trans_link);
+	buf->trans = running;
+	buf->newer = NULL;
+	buf->fblock = fblock;
+	buf->current = true;
+	buf->revoked = false;
+	memcpy(buf->data, data, size);
+
+	if (old != NULL) {
+		hash_table_remove_item(&journal->bufs, &old->link);
+		old->current = false;
+		old->newer = buf;
+	}
+
+	hash_table_insert(&journal->bufs, &buf->link);
+	list_append(&buf->trans_link, &running->bufs);
+	running->buf_count++;
+
+	/* The block is in use again, cancel its revocation */
+	link = hash_table_find(&journal->revokes, &fblock);
+	if (link != NULL) {
+		ext4_journal_revoke_t *revoke =
+		    hash_table_get_inst(link, ext4_journal_revoke_t, link);
+		hash_table_remove_item(&journal->revokes, &revoke->link);
+		list_remove(&revoke->trans_link);
+		running->revoke_count--;
+		free(revoke);
+	}
+
+	if (running->buf_count >= journal->max_trans) {
+		journal->kick = true;
+		fibril_condvar_broadcast(&journal->kick_cv);
+	}
+
+	fibril_mutex_unlock(&journal->lock);
+	return EOK;
+}
+
+/** Supply the newest copy of a block logged by the journal.
+ *
+ * @param arg  Journal
+ * @param ba   File system block
+ * @param data Buffer for the contents of the block
+ * @param size Size of the block
+ *
+ * @return True if the journal holds a copy of the block
+ *
+ */
+static bool ext4_journal_block_read(void *arg, aoff64_t ba, void *data,
+    size_t size)
+{
+	ext4_journal_t *journal = arg;
+	uint64_t fblock = ba;
+
+	fibril_mutex_lock(&journal->lock);
+
+	ht_link_t *link = hash_table_find(&journal->bufs, &fblock);
+	if (link == NULL) {
+		fibril_mutex_unlock(&journal->lock);
+		return false;
+	}
+
+	ext4_journal_buf_t *buf =
+	    hash_table_get_inst(link, ext4_journal_buf_t, link);
+	memcpy(data, buf->data, size);
+
+	fibril_mutex_unlock(&journal->lock);
+	return true;
+}
+
+static block_journal_ops_t ext4_journal_block_ops = {
+	.write = ext4_journal_block_write,
+	.read = ext4_journal_block_read
+};
+
+/** Check whether a checkpoint needs to write a logged block home.
+ *
+ * A block is written unless it has been revoked or a newer copy is
+ * written by the same checkpoint. Copies logged by transactions which have
+ * not committed yet do not count, because the log space which holds the
+ * older copy is going to be reused.
+ *
+ * @param buf Logged block
+ *
+ * @return True if the block needs to be written
+ *
+ */
+static bool ext4_journal_buf_needs_checkpoint(ext4_journal_buf_t *buf)
+{
+	if (buf->revoked)
+		return false;
+
+	for (buf = buf->newer; buf != NULL; buf = buf->newer) {
+		if (buf->revoked || buf->trans->checkpoint)
+			return false;
+	}
+
+	return true;
+}
+
+/** Write all committed blocks to their home locations and empty the log.
+ *
+ * Must be called with the commit lock held.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_do_checkpoint(ext4_journal_t *journal)
+{
+	list_t batch;
+	errno_t rc = EOK;
+
+	list_initialize(&batch);
+
+	fibril_mutex_lock(&journal->lock);
+
+	if (list_empty(&journal->committed)) {
+		fibril_mutex_unlock(&journal->lock);
+		return EOK;
+	}
+
+	list_foreach(journal->committed, link, ext4_journal_trans_t, trans)
+		trans->checkpoint = true;
+
+	size_t count = 0;
+	list_foreach(journal->committed, link, ext4_journal_trans_t, trans) {
+		list_foreach(trans->bufs, trans_link, ext4_journal_buf_t, buf) {
+			if (ext4_journal_buf_needs_checkpoint(buf))
+				count++;
+		}
+	}
+
+	ext4_journal_buf_t **bufs = NULL;
+	if (count > 0) {
+		bufs = malloc(count * sizeof(ext4_journal_buf_t *));
+		if (bufs == NULL) {
+			list_foreach(journal->committed, link,
+			    ext4_journal_trans_t, trans)
+				trans->checkpoint = false;
+			fibril_mutex_unlock(&journal->lock);
+			return ENOMEM;
+		}
+	}
+
+	size_t i = 0;
+	list_foreach(journal->committed, link, ext4_journal_trans_t, trans) {
+		list_foreach(trans->bufs, trans_link, ext4_journal_buf_t, buf) {
+			if (ext4_journal_buf_needs_checkpoint(buf))
+				bufs[i++] = buf;
+		}
+	}
+
+	list_concat(&batch, &journal->committed);
+	uint32_t sequence = journal->running->sequence;
+
+	fibril_mutex_unlock(&journal->lock);
+
+	/*
+	 * The logged copies do not change any more. Write them to the device
+	 * directly, not through the block cache, which may hold newer contents
+	 * of the same blocks.
+	 */
+	for (i = 0; i < count; i++) {
+		rc = block_write_direct(journal->fs->device,
+		    bufs[i]->fblock * journal->dev_blocks, journal->dev_blocks,
+		    bufs[i]->data);
+		if (rc != EOK)
+			break;
+	}
+
+	free(bufs);
+
+	if (rc == EOK)
+		rc = ext4_journal_flush(journal);
+
+	/* All log space can be reused now */
+	if (rc == EOK && !journal->log_empty) {
+		rc = ext4_journal_write_sb(journal, 0, sequence);
+		if (rc == EOK) {
+			journal->log_empty = true;
+			journal->tail = journal->head;
+		}
+	}
+
+	fibril_mutex_lock(&journal->lock);
+
+	if (rc != EOK) {
+		/* Keep the transactions for another attempt */
+		list_foreach(batch, link, ext4_journal_trans_t, trans)
+			trans->checkpoint = false;
+		list_concat(&journal->committed, &batch);
+		fibril_mutex_unlock(&journal->lock);
+		return rc;
+	}
+
+	journal->committed_blocks = 0;
+	while (!list_empty(&batch)) {
+		ext4_journal_trans_t *trans = list_get_instance(
+		    list_first(&batch), ext4_journal_trans_t, link);
+		list_remove(&trans->link);
+		ext4_journal_trans_destroy(journal, trans);
+	}
+
+	fibril_mutex_unlock(&journal->lock);
+	return EOK;
+}
+
+/** Get the number of free log blocks.
+ *
+ * @param journal Journal
+ *
+ * @return Number of free blocks
+ *
+ */
+static uint32_t ext4_journal_free_space(ext4_journal_t *journal)
+{
+	uint32_t span = journal->max_len - journal->first;
+
+	if (journal->log_empty)
+		return span;
+
+	uint32_t used = (journal->head + span - journal->tail) % span;
+	if (used == 0)
+		used = span;
+
+	return span - used;
+}
+
+/** Write a transaction to the log.
+ *
+ * Must be called with the commit lock held. The transaction is closed, so
+ * its blocks do not change any more.
+ *
+ * @param journal Journal
+ * @param trans   Transaction to write
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_write_trans(ext4_journal_t *journal,
+    ext4_journal_trans_t *trans)
+{
+	uint32_t block_size = journal->block_size;
+	bool is_64bit = (journal->features_incompatible &
+	    EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT) != 0;
+	errno_t rc;
+
+	/* Compute the layout of the transaction in the log */
+	size_t revokes_per_block = (block_size -
+	    sizeof(ext4_journal_revoke_header_t)) / journal->revoke_size;
+	size_t revoke_blocks = (trans->revoke_count + revokes_per_block - 1) /
+	    revokes_per_block;
+	size_t tags_per_block = (block_size - sizeof(ext4_journal_header_t) -
+	    16) / journal->tag_size;
+	size_t desc_blocks = (trans->buf_count + tags_per_block - 1) /
+	    tags_per_block;
+	size_t length = revoke_blocks + desc_blocks + trans->buf_count + 1;
+
+	if (length >= journal->max_len - journal->first)
+		return ENOSPC;
+
+	if (length >= ext4_journal_free_space(journal)) {
+		rc = ext4_journal_do_checkpoint(journal);
+		if (rc != EOK)
+			return rc;
+	}
+
+	uint8_t *log = calloc(length, block_size);
+	if (log == NULL)
+		return ENOMEM;
+
+	uint8_t *block = log;
+
+	/* Revoke blocks */
+	ext4_journal_revoke_header_t *rheader = NULL;
+	size_t offset = 0;
+	list_foreach(trans->revokes, trans_link, ext4_journal_revoke_t, revoke) {
+		if (rheader == NULL || offset + journal->revoke_size >
+		    block_size) {
+			if (rheader != NULL)
+				block += block_size;
+			rheader = (ext4_journal_revoke_header_t *) block;
+			rheader->header.magic =
+			    host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+			rheader->header.block_type =
+			    host2uint32_t_be(EXT4_JOURNAL_REVOKE_BLOCK);
+			rheader->header.sequence =
+			    host2uint32_t_be(trans->sequence);
+			offset = sizeof(ext4_journal_revoke_header_t);
+		}
+
+		if (is_64bit) {
+			uint64_t record = host2uint64_t_be(revoke->fblock);
+			memcpy(block + offset, &record, sizeof(record));
+		} else {
+			uint32_t record = host2uint32_t_be(revoke->fblock);
+			memcpy(block + offset, &record, sizeof(record));
+		}
+
+		offset += journal->revoke_size;
+		rheader->count = host2uint32_t_be(offset);
+	}
+
+	if (rheader != NULL)
+		block += block_size;
+
+	/* Descriptor blocks, each followed by the logged blocks it describes */
+	ext4_journal_block_tag_t *tag = NULL;
+	uint8_t *desc = NULL;
+	size_t tags = 0;
+	list_foreach(trans->bufs, trans_link, ext4_journal_buf_t, buf) {
+		if (buf->revoked)
+			continue;
+
+		if (desc == NULL || tags == tags_per_block) {
+			if (tag != NULL) {
+				tag->flags |= host2uint16_t_be(
+				    EXT4_JOURNAL_FLAG_LAST_TAG);
+			}
+
+			desc = block;
+			block += block_size;
+
+			ext4_journal_header_t *header =
+			    (ext4_journal_header_t *) desc;
+			header->magic = host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+			header->block_type =
+			    host2uint32_t_be(EXT4_JOURNAL_DESCRIPTOR_BLOCK);
+			header->sequence = host2uint32_t_be(trans->sequence);
+			offset = sizeof(ext4_journal_header_t);
+			tags = 0;
+		}
+
+		uint16_t flags = 0;
+		memcpy(block, buf->data, block_size);
+
+		/* Blocks which look like journal blocks must be escaped */
+		uint32_t magic;
+		memcpy(&magic, block, sizeof(magic));
+		if (uint32_t_be2host(magic) == EXT4_JOURNAL_MAGIC) {
+			memset(block, 0, sizeof(magic));
+			flags |= EXT4_JOURNAL_FLAG_ESCAPE;
+		}
+
+		block += block_size;
+
+		if (tags > 0)
+			flags |= EXT4_JOURNAL_FLAG_SAME_UUID;
+
+		tag = (ext4_journal_block_tag_t *) (desc + offset);
+		tag->block = host2uint32_t_be(buf->fblock & UINT32_MAX);
+		tag->checksum = 0;
+		tag->flags = host2uint16_t_be(flags);
+		if (is_64bit)
+			tag->block_hi = host2uint32_t_be(buf->fblock >> 32);
+		offset += journal->tag_size;
+
+		if (tags == 0) {
+			memcpy(desc + offset, journal->sb->uuid, 16);
+			offset += 16;
+		}
+
+		tags++;
+	}
+
+	if (tag != NULL)
+		tag->flags |= host2uint16_t_be(EXT4_JOURNAL_FLAG_LAST_TAG);
+
+	/* Commit block */
+	ext4_journal_header_t *commit = (ext4_journal_header_t *) block;
+	commit->magic = host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+	commit->block_type = host2uint32_t_be(EXT4_JOURNAL_COMMIT_BLOCK);
+	commit->sequence = host2uint32_t_be(trans->sequence);
+
+	assert(block == log + (length - 1) * block_size);
+
+	uint32_t start = journal->head;
+
+	/* Recovery must be able to find the first transaction in the log */
+	if (journal->log_empty) {
+		rc = ext4_journal_write_sb(journal, start, trans->sequence);
+		if (rc != EOK)
+			goto out;
+
+		journal->log_empty = false;
+		journal->tail = start;
+	}
+
+	/*
+	 * The commit block may reach the device only after the rest of the
+	 * transaction. Only then is the transaction complete.
+	 */
+	rc = ext4_journal_log_io(journal, start, length - 1, log, true);
+	if (rc != EOK)
+		goto out;
+
+	rc = ext4_journal_flush(journal);
+	if (rc != EOK)
+		goto out;
+
+	uint32_t pos = start + length - 1;
+	if (pos >= journal->max_len)
+		pos -= journal->max_len - journal->first;
+
+	rc = ext4_journal_log_io(journal, pos, 1, block, true);
+	if (rc != EOK)
+		goto out;
+
+	rc = ext4_journal_flush(journal);
+	if (rc != EOK)
+		goto out;
+
+	journal->head = ext4_journal_next(journal, pos);
+out:
+	free(log);
+	return rc;
+}
+
+/** Commit the running transaction.
+ *
+ * Must be called with the commit lock held.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_do_commit(ext4_journal_t *journal)
+{
+	ext4_journal_trans_t *next = ext4_journal_trans_create();
+	if (next == NULL)
+		return ENOMEM;
+
+	fibril_mutex_lock(&journal->lock);
+
+	ext4_journal_trans_t *trans = journal->running;
+	if (journal->error != EOK || (trans->buf_count == 0 &&
+	    trans->revoke_count == 0)) {
+		errno_t rc = journal->error;
+		fibril_mutex_unlock(&journal->lock);
+		free(next);
+		return rc;
+	}
+
+	/* Wait until the transaction contains only whole operations */
+	journal->locked = true;
+	while (journal->handles > 0)
+		fibril_condvar_wait(&journal->cv, &journal->lock);
+
+	next->sequence = trans->sequence + 1;
+	journal->running = next;
+
+	/* Revocations of the closed transaction cannot be cancelled anymore */
+	list_foreach(trans->revokes, trans_link, ext4_journal_revoke_t, revoke)
+		hash_table_remove_item(&journal->revokes, &revoke->link);
+
+	journal->locked = false;
+	fibril_condvar_broadcast(&journal->cv);
+	fibril_mutex_unlock(&journal->lock);
+
+	errno_t rc = ext4_journal_write_trans(journal, trans);
+
+	fibril_mutex_lock(&journal->lock);
+
+	/*
+	 * Even if the transaction could not be logged, its blocks still need
+	 * to reach their home locations eventually. Further operations are
+	 * refused, though.
+	 */
+	list_append(&trans->link, &journal->committed);
+	journal->committed_blocks += trans->buf_count;
+	if (rc != EOK) {
+		journal->error = rc;
+		fibril_condvar_broadcast(&journal->cv);
+	}
+
+	fibril_mutex_unlock(&journal->lock);
+	return rc;
+}
+
+/** Background fibril committing and checkpointing transactions.
+ *
+ * @param arg Journal
+ *
+ * @return EOK
+ *
+ */
+static errno_t ext4_journal_fibril(void *arg)
+{
+	ext4_journal_t *journal = arg;
+
+	fibril_mutex_lock(&journal->lock);
+
+	while (!journal->stop) {
+		errno_t rc = EOK;
+		if (!journal->kick) {
+			rc = fibril_condvar_wait_timeout(&journal->kick_cv,
+			    &journal->lock, EXT4_JOURNAL_COMMIT_INTERVAL);
+		}
+
+		if (journal->stop)
+			break;
+
+		/* Checkpoint in the background when there is nothing to do */
+		bool idle = rc == ETIMEOUT &&
+		    journal->running->buf_count == 0 &&
+		    journal->running->revoke_count == 0;
+		journal->kick = false;
+
+		fibril_mutex_unlock(&journal->lock);
+
+		fibril_mutex_lock(&journal->commit_lock);
+		(void) ext4_journal_do_commit(journal);
+		if (idle || journal->committed_blocks >=
+		    journal->checkpoint_limit)
+			(void) ext4_journal_do_checkpoint(journal);
+		fibril_mutex_unlock(&journal->commit_lock);
+
+		fibril_mutex_lock(&journal->lock);
+	}
+
+	journal->done = true;
+	fibril_condvar_broadcast(&journal->cv);
+	fibril_mutex_unlock(&journal->lock);
+
+	return EOK;
+}
+
+/** Check whether a logged block has been revoked.
+ *
+ * @param journal  Journal
+ * @param fblock   Home location of the block
+ * @param sequence Sequence number of the transaction which logged it
+ *
+ * @return True if the block must not be replayed
+ *
+ */
+static bool ext4_journal_is_revoked(ext4_journal_t *journal, uint64_t fblock,
+    uint32_t sequence)
+{
+	ht_link_t *link = hash_table_find(&journal->revokes, &fblock);
+	if (link == NULL)
+		return false;
+
+	ext4_journal_revoke_t *revoke =
+	    hash_table_get_inst(link, ext4_journal_revoke_t, link);
+
+	return (int32_t) (sequence - revoke->sequence) <= 0;
+}
+
+/** Record revocations found in a revoke block during recovery.
+ *
+ * @param journal  Journal
+ * @param block    Revoke block
+ * @param sequence Sequence number of the transaction
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_scan_revokes(ext4_journal_t *journal,
+    uint8_t *block, uint32_t sequence)
+{
+	ext4_journal_revoke_header_t *rheader =
+	    (ext4_journal_revoke_header_t *) block;
+	size_t count = min(uint32_t_be2host(rheader->count),
+	    journal->block_size);
+
+	for (size_t offset = sizeof(ext4_journal_revoke_header_t);
+	    offset + journal->revoke_size <= count;
+	    offset += journal->revoke_size) {
+		uint64_t fblock;
+		if (journal->revoke_size == sizeof(uint64_t)) {
+			uint64_t record;
+			memcpy(&record, block + offset, sizeof(record));
+			fblock = uint64_t_be2host(record);
+		} else {
+			uint32_t record;
+			memcpy(&record, block + offset, sizeof(record));
+			fblock = uint32_t_be2host(record);
+		}
+
+		ht_link_t *link = hash_table_find(&journal->revokes, &fblock);
+		if (link != NULL) {
+			ext4_journal_revoke_t *revoke = hash_table_get_inst(link,
+			    ext4_journal_revoke_t, link);
+			if ((int32_t) (sequence - revoke->sequence) > 0)
+				revoke->sequence = sequence;
+			continue;
+		}
+
+		ext4_journal_revoke_t *revoke =
+		    malloc(sizeof(ext4_journal_revoke_t));
+		if (revoke == NULL)
+			return ENOMEM;
+
+		link_initialize(&revoke->trans_link);
+		revoke->fblock = fblock;
+		revoke->sequence = sequence;
+		hash_table_insert(&journal->revokes, &revoke->link);
+		list_append(&revoke->trans_link, &journal->running->revokes);
+	}
+
+	return EOK;
+}
+
+/** Walk the log during recovery.
+ *
+ * @param journal Journal
+ * @param pass    Pass of the recovery
+ * @param end     Sequence number of the first transaction which is not
+ *                complete (output of the scan pass, input of the others)
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_recover_pass(ext4_journal_t *journal,
+    ext4_journal_pass_t pass, uint32_t *end)
+{
+	uint32_t block_size = journal->block_size;
+	uint32_t pos = uint32_t_be2host(journal->sb->start);
+	uint32_t sequence = uint32_t_be2host(journal->sb->sequence);
+	uint32_t visited = 0;
+	errno_t rc = EOK;
+
+	uint8_t *block = malloc(2 * block_size);
+	if (block == NULL)
+		return ENOMEM;
+
+	uint8_t *data = block + block_size;
+
+	while (visited < journal->max_len - journal->first) {
+		if (pass != ext4_journal_pass_scan && sequence == *end)
+			break;
+
+		rc = ext4_journal_log_io(journal, pos, 1, block, false);
+		if (rc != EOK)
+			goto out;
+
+		ext4_journal_header_t *header = (ext4_journal_header_t *) block;
+		if (uint32_t_be2host(header->magic) != EXT4_JOURNAL_MAGIC ||
+		    uint32_t_be2host(header->sequence) != sequence)
+			break;
+
+		pos = ext4_journal_next(journal, pos);
+		visited++;
+
+		switch (uint32_t_be2host(header->block_type)) {
+		case EXT4_JOURNAL_DESCRIPTOR_BLOCK:
+			for (size_t offset = sizeof(ext4_journal_header_t);
+			    offset + journal->tag_size <= block_size;) {
+				ext4_journal_block_tag_t *tag =
+				    (ext4_journal_block_tag_t *) (block + offset);
+				uint16_t flags = uint16_t_be2host(tag->flags);
+				uint64_t fblock = uint32_t_be2host(tag->block);
+				if (journal->tag_size > 8) {
+					fblock |= (uint64_t)
+					    uint32_t_be2host(tag->block_hi) << 32;
+				}
+
+				if (pass == ext4_journal_pass_replay &&
+				    !ext4_journal_is_revoked(journal, fblock,
+				    sequence)) {
+					rc = ext4_journal_log_io(journal, pos, 1,
+					    data, false);
+					if (rc != EOK)
+						goto out;
+
+					if (flags & EXT4_JOURNAL_FLAG_ESCAPE) {
+						uint32_t magic = host2uint32_t_be(
+						    EXT4_JOURNAL_MAGIC);
+						memcpy(data, &magic, sizeof(magic));
+					}
+
+					rc = block_write_range(journal->fs->device,
+					    fblock, 1, data);
+					if (rc != EOK)
+						goto out;
+				}
+
+				pos = ext4_journal_next(journal, pos);
+				visited++;
+
+				offset += journal->tag_size;
+				if ((flags & EXT4_JOURNAL_FLAG_SAME_UUID) == 0)
+					offset += 16;
+				if (flags & EXT4_JOURNAL_FLAG_LAST_TAG)
+					break;
+			}
+			break;
+		case EXT4_JOURNAL_COMMIT_BLOCK:
+			sequence++;
+			break;
+		case EXT4_JOURNAL_REVOKE_BLOCK:
+			if (pass == ext4_journal_pass_revoke) {
+				rc = ext4_journal_scan_revokes(journal, block,
+				    sequence);
+				if (rc != EOK)
+					goto out;
+			}
+			break;
+		default:
+			goto done;
+		}
+	}
+
+done:
+	if (pass == ext4_journal_pass_scan)
+		*end = sequence;
+out:
+	free(block);
+	return rc;
+}
+
+/** Replay the log of a journal which was not closed properly.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_recover(ext4_journal_t *journal)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	uint32_t end;
+
+	errno_t rc = ext4_journal_recover_pass(journal, ext4_journal_pass_scan,
+	    &end);
+	if (rc == EOK) {
+		rc = ext4_journal_recover_pass(journal,
+		    ext4_journal_pass_revoke, &end);
+	}
+	if (rc == EOK) {
+		rc = ext4_journal_recover_pass(journal,
+		    ext4_journal_pass_replay, &end);
+	}
+
+	/* Free the revocations collected by the recovery */
+	while (!list_empty(&journal->running->revokes)) {
+		ext4_journal_revoke_t *revoke = list_get_instance(
+		    list_first(&journal->running->revokes),
+		    ext4_journal_revoke_t, trans_link);
+		list_remove(&revoke->trans_link);
+		hash_table_remove_item(&journal->revokes, &revoke->link);
+		free(revoke);
+	}
+
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_journal_flush(journal);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_journal_write_sb(journal, 0, end + 1);
+	if (rc != EOK)
+		return rc;
+
+	/* The replayed blocks may include the superblock */
+	ext4_superblock_t *superblock;
+	rc = ext4_superblock_read_direct(fs->device, &superblock);
+	if (rc != EOK)
+		return rc;
+
+	ext4_superblock_release(fs->superblock);
+	fs->superblock = superblock;
+	return EOK;
+}
+
+/** Free a journal.
+ *
+ * @param journal Journal to free
+ *
+ */
+static void ext4_journal_destroy(ext4_journal_t *journal)
+{
+	while (!list_empty(&journal->committed)) {
+		ext4_journal_trans_t *trans = list_get_instance(
+		    list_first(&journal->committed), ext4_journal_trans_t, link);
+		list_remove(&trans->link);
+		ext4_journal_trans_destroy(journal, trans);
+	}
+
+	if (journal->running != NULL) {
+		list_foreach(journal->running->revokes, trans_link,
+		    ext4_journal_revoke_t, revoke)
+			hash_table_remove_item(&journal->revokes, &revoke->link);
+		ext4_journal_trans_destroy(journal, journal->running);
+	}
+
+	hash_table_destroy(&journal->bufs);
+	hash_table_destroy(&journal->revokes);
+	free(journal->sb_block);
+	free(journal->map);
+	free(journal);
+}
+
+/** Load the journal inode and the journal superblock.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_load(ext4_journal_t *journal)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	ext4_inode_ref_t *inode_ref;
+	errno_t rc;
+
+	rc = ext4_filesystem_get_inode_ref(fs,
+	    ext4_superblock_get_journal_inode_number(fs->superblock),
+	    &inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	uint64_t size = ext4_inode_get_size(fs->superblock, inode_ref->inode);
+	if (size / journal->block_size > UINT32_MAX) {
+		ext4_filesystem_put_inode_ref(inode_ref);
+		return EINVAL;
+	}
+
+	uint32_t blocks = size / journal->block_size;
+	if (blocks < 2) {
+		ext4_filesystem_put_inode_ref(inode_ref);
+		return EINVAL;
+	}
+
+	journal->map = malloc(blocks * sizeof(uint32_t));
+	if (journal->map == NULL) {
+		ext4_filesystem_put_inode_ref(inode_ref);
+		return ENOMEM;
+	}
+
+	/* Translate the whole journal at once, it is accessed all the time */
+	for (uint32_t iblock = 0; iblock < blocks;) {
+		uint32_t fblock;
+		uint32_t count;
+		rc = ext4_filesystem_get_inode_data_blocks(inode_ref, iblock,
+		    blocks - iblock, &fblock, &count);
+		if (rc == EOK && fblock == 0)
+			rc = EINVAL;
+		if (rc != EOK) {
+			ext4_filesystem_put_inode_ref(inode_ref);
+			return rc;
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+			journal->map[iblock + i] = fblock + i;
+		iblock += count;
+	}
+
+	rc = ext4_filesystem_put_inode_ref(inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	journal->sb_block = malloc(journal->block_size);
+	if (journal->sb_block == NULL)
+		return ENOMEM;
+
+	rc = block_read_range(fs->device, journal->map[0], 1,
+	    journal->sb_block);
+	if (rc != EOK)
+		return rc;
+
+	ext4_journal_superblock_t *sb =
+	    (ext4_journal_superblock_t *) journal->sb_block;
+	journal->sb = sb;
+
+	uint32_t block_type = uint32_t_be2host(sb->header.block_type);
+	if (uint32_t_be2host(sb->header.magic) != EXT4_JOURNAL_MAGIC ||
+	    (block_type != EXT4_JOURNAL_SUPERBLOCK_V1 &&
+	    block_type != EXT4_JOURNAL_SUPERBLOCK_V2))
+		return EINVAL;
+
+	journal->first = uint32_t_be2host(sb->first);
+	journal->max_len = uint32_t_be2host(sb->max_len);
+	if (uint32_t_be2host(sb->block_size) != journal->block_size ||
+	    journal->max_len > blocks || journal->first == 0 ||
+	    journal->first >= journal->max_len)
+		return EINVAL;
+
+	if (block_type == EXT4_JOURNAL_SUPERBLOCK_V2) {
+		journal->features_incompatible =
+		    uint32_t_be2host(sb->features_incompatible);
+	}
+
+	if (journal->features_incompatible &
+	    EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT) {
+		journal->tag_size = sizeof(ext4_journal_block_tag_t);
+		journal->revoke_size = sizeof(uint64_t);
+	} else {
+		journal->tag_size = sizeof(ext4_journal_block_tag_t) -
+		    sizeof(uint32_t);
+		journal->revoke_size = sizeof(uint32_t);
+	}
+
+	return EOK;
+}
+
+/** Create a journal in a new file system.
+ *
+ * The journal i-node must already be allocated.
+ *
+ * @param fs     File system
+ * @param blocks Size of the journal in blocks
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_create(ext4_filesystem_t *fs, uint32_t blocks)
+{
+	ext4_superblock_t *sb = fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+	ext4_inode_ref_t *inode_ref;
+	errno_t rc;
+
+	if (blocks < EXT4_JOURNAL_MIN_BLOCKS)
+		return EINVAL;
+
+	rc = ext4_filesystem_get_inode_ref(fs, EXT4_INODE_JOURNAL_INDEX,
+	    &inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	ext4_inode_set_mode(sb, inode_ref->inode, EXT4_INODE_MODE_FILE | 0600);
+	ext4_inode_set_links_count(inode_ref->inode, 1);
+	inode_ref->dirty = true;
+
+	for (uint32_t i = 0; i < blocks; i++) {
+		uint32_t fblock;
+		uint32_t iblock;
+		rc = ext4_filesystem_append_inode_block(inode_ref, &fblock,
+		    &iblock);
+		if (rc != EOK)
+			goto out;
+	}
+
+	uint8_t *buf = calloc(EXT4_JOURNAL_IO_BLOCKS, block_size);
+	if (buf == NULL) {
+		rc = ENOMEM;
+		goto out;
+	}
+
+	/* Stale data must not be mistaken for log blocks */
+	for (uint32_t iblock = 0; iblock < blocks;) {
+		uint32_t fblock;
+		uint32_t count;
+		rc = ext4_filesystem_get_inode_data_blocks(inode_ref, iblock,
+		    min(blocks - iblock, EXT4_JOURNAL_IO_BLOCKS), &fblock,
+		    &count);
+		if (rc == EOK)
+			rc = block_write_range(fs->device, fblock, count, buf);
+		if (rc != EOK) {
+			free(buf);
+			goto out;
+		}
+
+		iblock += count;
+	}
+
+	ext4_journal_superblock_t *jsb = (ext4_journal_superblock_t *) buf;
+	jsb->header.magic = host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+	jsb->header.block_type = host2uint32_t_be(EXT4_JOURNAL_SUPERBLOCK_V2);
+	jsb->block_size = host2uint32_t_be(block_size);
+	jsb->max_len = host2uint32_t_be(blocks);
+	jsb->first = host2uint32_t_be(1);
+	jsb->sequence = host2uint32_t_be(1);
+	jsb->start = 0;
+
+	uint32_t features = EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE;
+	if (ext4_superblock_has_feature_incompatible(sb,
+	    EXT4_FEATURE_INCOMPAT_64BIT))
+		features |= EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT;
+	jsb->features_incompatible = host2uint32_t_be(features);
+
+	uuid_t uuid;
+	ext4_superblock_get_uuid(sb, &uuid);
+	uuid_encode(&uuid, jsb->uuid);
+	jsb->nr_users = host2uint32_t_be(1);
+	memcpy(jsb->users, jsb->uuid, sizeof(jsb->uuid));
+
+	uint32_t fblock;
+	rc = ext4_filesystem_get_inode_data_block_index(inode_ref, 0, &fblock);
+	if (rc == EOK)
+		rc = block_write_range(fs->device, fblock, 1, buf);
+
+	free(buf);
+	if (rc != EOK)
+		goto out;
+
+	ext4_superblock_set_journal_inode_number(sb, EXT4_INODE_JOURNAL_INDEX);
+	ext4_superblock_set_features_compatible(sb,
+	    ext4_superblock_get_features_compatible(sb) |
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL);
+out:
+	if (rc != EOK) {
+		ext4_filesystem_put_inode_ref(inode_ref);
+		return rc;
+	}
+
+	return ext4_filesystem_put_inode_ref(inode_ref);
+}
+
+/** Open the journal of a file system being mounted.
+ *
+ * If the journal was not closed properly, its log is replayed. Does
+ * nothing if the file system does not have a journal.
+ *
+ * @param fs File system
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_open(ext4_filesystem_t *fs)
+{
+	ext4_superblock_t *sb = fs->superblock;
+	size_t dev_bsize;
+	errno_t rc;
+
+	fs->journal = NULL;
+
+	if (!ext4_superblock_has_feature_compatible(sb,
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL))
+		return EOK;
+
+	/* External journal devices are not supported */
+	if (ext4_superblock_has_feature_incompatible(sb,
+	    EXT4_FEATURE_INCOMPAT_JOURNAL_DEV))
+		return ENOTSUP;
+
+	rc = block_get_bsize(fs->device, &dev_bsize);
+	if (rc != EOK)
+		return rc;
+
+	ext4_journal_t *journal = calloc(1, sizeof(ext4_journal_t));
+	if (journal == NULL)
+		return ENOMEM;
+
+	journal->fs = fs;
+	journal->block_size = ext4_superblock_get_block_size(sb);
+	journal->dev_blocks = journal->block_size / dev_bsize;
+	fibril_mutex_initialize(&journal->lock);
+	fibril_condvar_initialize(&journal->cv);
+	fibril_condvar_initialize(&journal->kick_cv);
+	fibril_mutex_initialize(&journal->commit_lock);
+	list_initialize(&journal->committed);
+
+	if (!hash_table_create(&journal->bufs, 0, 0, &ext4_journal_buf_ops)) {
+		free(journal);
+		return ENOMEM;
+	}
+
+	if (!hash_table_create(&journal->revokes, 0, 0,
+	    &ext4_journal_revoke_ops)) {
+		hash_table_destroy(&journal->bufs);
+		free(journal);
+		return ENOMEM;
+	}
+
+	journal->running = ext4_journal_trans_create();
+	if (journal->running == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	rc = ext4_journal_load(journal);
+	if (rc != EOK)
+		goto error;
+
+	bool supported = (journal->features_incompatible &
+	    ~EXT4_JOURNAL_FEATURE_INCOMPAT_SUPP) == 0;
+
+	if (journal->sb->start != 0) {
+		if (!supported) {
+			rc = ENOTSUP;
+			goto error;
+		}
+
+		rc = ext4_journal_recover(journal);
+		if (rc != EOK)
+			goto error;
+	}
+
+	/*
+	 * The log is empty now. A journal which this driver cannot write is
+	 * left alone and the file system is modified without journaling.
+	 */
+	if (!supported) {
+		ext4_journal_destroy(journal);
+		return EOK;
+	}
+
+	uint32_t span = journal->max_len - journal->first;
+	journal->head = journal->first;
+	journal->tail = journal->first;
+	journal->log_empty = true;
+	journal->max_trans = min(span / 4, EXT4_JOURNAL_MAX_TRANS_BLOCKS);
+	journal->checkpoint_limit = min(span / 2,
+	    EXT4_JOURNAL_CHECKPOINT_BLOCKS);
+	journal->running->sequence = uint32_t_be2host(journal->sb->sequence);
+
+	fid_t fid = fibril_create(ext4_journal_fibril, journal);
+	if (fid == 0) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	rc = block_cache_set_journal(fs->device, &ext4_journal_block_ops,
+	    journal);
+	if (rc != EOK) {
+		fibril_destroy(fid);
+		goto error;
+	}
+
+	fibril_add_ready(fid);
+
+	/* The superblock is written by the caller */
+	ext4_superblock_set_features_incompatible(fs->superblock,
+	    ext4_superblock_get_features_incompatible(fs->superblock) |
+	    EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	fs->journal = journal;
+	return EOK;
+error:
+	ext4_journal_destroy(journal);
+	return rc;
+}
+
+/** Close the journal of a file system being unmounted.
+ *
+ * All transactions are committed and checkpointed, so that the log is
+ * empty.
+ *
+ * @param fs File system
+ *
+ * @return EOK or an error code. On error the journal remains open.
+ *
+ */
+errno_t ext4_journal_close(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return EOK;
+
+	fibril_mutex_lock(&journal->commit_lock);
+	errno_t rc = ext4_journal_do_commit(journal);
+	if (rc == EOK)
+		rc = ext4_journal_do_checkpoint(journal);
+	fibril_mutex_unlock(&journal->commit_lock);
+
+	if (rc != EOK)
+		return rc;
+
+	fibril_mutex_lock(&journal->lock);
+	journal->stop = true;
+	fibril_condvar_broadcast(&journal->kick_cv);
+	while (!journal->done)
+		fibril_condvar_wait(&journal->cv, &journal->lock);
+	fibril_mutex_unlock(&journal->lock);
+
+	(void) block_cache_set_journal(fs->device, NULL, NULL);
+
+	ext4_superblock_set_features_incompatible(fs->superblock,
+	    ext4_superblock_get_features_incompatible(fs->superblock) &
+	    ~EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	ext4_journal_destroy(journal);
+	fs->journal = NULL;
+	return EOK;
+}
+
+/** Begin a file system operation.
+ *
+ * All metadata blocks modified by the operation are logged by the same
+ * transaction. Operations may nest, only the outermost one counts.
+ *
+ * @param fs File system
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_begin(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return EOK;
+
+	if (handle_depth > 0) {
+		handle_depth++;
+		return EOK;
+	}
+
+	fibril_mutex_lock(&journal->lock);
+
+	/* Do not let the running transaction grow beyond its limit */
+	while (journal->error == EOK && (journal->locked ||
+	    journal->running->buf_count >= journal->max_trans)) {
+		if (!journal->locked) {
+			journal->kick = true;
+			fibril_condvar_broadcast(&journal->kick_cv);
+		}
+
+		fibril_condvar_wait(&journal->cv, &journal->lock);
+	}
+
+	errno_t rc = journal->error;
+	if (rc == EOK) {
+		journal->handles++;
+		handle_depth++;
+	}
+
+	fibril_mutex_unlock(&journal->lock);
+	return rc;
+}
+
+/** End a file system operation.
+ *
+ * @param fs File system
+ *
+ */
+void ext4_journal_end(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return;
+
+	assert(handle_depth > 0);
+	if (--handle_depth > 0)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+	assert(journal->handles > 0);
+	if (--journal->handles == 0)
+		fibril_condvar_broadcast(&journal->cv);
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Commit the running transaction.
+ *
+ * When this function returns successfully, all operations which ended
+ * before are persistent. Must not be called within an operation.
+ *
+ * @param fs File system
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_commit(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return EOK;
+
+	assert(handle_depth == 0);
+
+	fibril_mutex_lock(&journal->commit_lock);
+	errno_t rc = ext4_journal_do_commit(journal);
+	if (rc == EOK && journal->committed_blocks >= journal->checkpoint_limit)
+		rc = ext4_journal_do_checkpoint(journal);
+	fibril_mutex_unlock(&journal->commit_lock);
+
+	return rc;
+}
+
+/** Revoke freed blocks.
+ *
+ * Logged copies of the blocks are neither written home by a checkpoint nor
+ * replayed by a recovery. This is necessary because the blocks may be
+ * reused for file data, which does not pass through the journal.
+ *
+ * @param fs     File system
+ * @param fblock First freed block
+ * @param count  Number of freed blocks
+ *
+ */
+void ext4_journal_revoke(ext4_filesystem_t *fs, uint64_t fblock,
+    uint32_t count)
+{
+	ext4_journal_t *journal = fs->journal;
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+
+	ext4_journal_trans_t *running = journal->running;
+
+	for (uint64_t block = fblock; block < fblock + count; block++) {
+		/* Blocks which have never been logged need no revocation */
+		ht_link_t *link = hash_table_find(&journal->bufs, &block);
+		if (link == NULL)
+			continue;
+
+		ext4_journal_buf_t *buf =
+		    hash_table_get_inst(link, ext4_journal_buf_t, link);
+		hash_table_remove_item(&journal->bufs, &buf->link);
+		buf->current = false;
+		buf->revoked = true;
+		if (buf->trans == running)
+			running->buf_count--;
+
+		if (hash_table_find(&journal->revokes, &block) != NULL)
+			continue;
+
+		ext4_journal_revoke_t *revoke =
+		    malloc(sizeof(ext4_journal_revoke_t));
+		if (revoke == NULL) {
+			/*
+			 * Without the revocation, the stale copy could be
+			 * replayed over file data. Make the transaction fail.
+			 */
+			journal->error = ENOMEM;
+			break;
+		}
+
+		link_initialize(&revoke->trans_link);
+		revoke->fblock = block;
+		revoke->sequence = running->sequence;
+		hash_table_insert(&journal->revokes, &revoke->link);
+		list_append(&revoke->trans_link, &running->revokes);
+		running->revoke_count++;
+	}
+
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/**
+ * @}
+ */
@@ -50,17 +50,27 @@
 #include "ext4/directory_index.h"
 #include "ext4/extent.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/ops.h"
 #include "ext4/filesystem.h"
 #include "ext4/fstypes.h"
 #include "ext4/superblock.h"
 
+/** Maximum number of bytes written by one run of ext4_copy_range()
+ *
+ * block_read_range() and block_write_range() split a run into device
+ * requests of at most DATA_XFER_LIMIT, so a chunk may be larger than that.
+ */
+#define EXT4_COPY_CHUNK  (1024 * 1024)
+
 /* Forward declarations of auxiliary functions */
 
 static errno_t ext4_read_directory(ipc_call_t *, aoff64_t, size_t,
     ext4_instance_t *, ext4_inode_ref_t *, size_t *);
 static errno_t ext4_read_file(ipc_call_t *, aoff64_t, size_t, ext4_instance_t *,
     ext4_inode_ref_t *, size_t *);
+static errno_t ext4_readdir(service_id_t, fs_index_t, aoff64_t,
+    libfs_readdir_t *);
 static bool ext4_is_dots(const uint8_t *, size_t);
 static errno_t ext4_instance_get(service_id_t, ext4_instance_t **);
 
@@ -396,34 +406,42 @@ errno_t ext4_node_open(fs_node_t *fn)
  */
 errno_t ext4_node_put(fs_node_t *fn)
 {
+	ext4_node_t *enode = EXT4_NODE(fn);
+	ext4_filesystem_t *fs = enode->instance->filesystem;
+
+	/*
+	 * Writing back the i-node modifies metadata. The node must be
+	 * released even if the journal has failed.
+	 */
+	bool journaled = ext4_journal_begin(fs) == EOK;
+
 	fibril_mutex_lock(&open_nodes_lock);
 
-	ext4_node_t *enode = EXT4_NODE(fn);
+	errno_t rc = EOK;
 	assert(enode->references > 0);
 	enode->references--;
-	if (enode->references == 0) {
-		errno_t rc = ext4_node_put_core(enode);
-		if (rc != EOK) {
-			fibril_mutex_unlock(&open_nodes_lock);
-			return rc;
-		}
-	}
+	if (enode->references == 0)
+		rc = ext4_node_put_core(enode);
 
 	fibril_mutex_unlock(&open_nodes_lock);
 
-	return EOK;
+	if (journaled)
+		ext4_journal_end(fs);
+
+	return rc;
 }
 
-/** Create new node in filesystem.
+/** Create new node in filesystem within a journal operation.
  *
- * @param rfn        Output pointer to newly created node if successful
- * @param service_id Device identifier, where the filesystem is
- * @param flags      Flags for specification of new node parameters
+ * @param rfn   Output pointer to newly created node if successful
+ * @param inst  Instance of the filesystem
+ * @param flags Flags for specification of new node parameters
  *
  * @return Error code
  *
  */
-errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
+static errno_t ext4_create_node_core(fs_node_t **rfn, ext4_instance_t *inst,
+    int flags)
 {
 	/* Allocate enode */
 	ext4_node_t *enode;
@@ -439,18 +457,9 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 		return ENOMEM;
 	}
 
-	/* Load instance */
-	ext4_instance_t *inst;
-	errno_t rc = ext4_instance_get(service_id, &inst);
-	if (rc != EOK) {
-		free(enode);
-		free(fs_node);
-		return rc;
-	}
-
 	/* Allocate new i-node in filesystem */
 	ext4_inode_ref_t *inode_ref;
-	rc = ext4_filesystem_alloc_inode(inst->filesystem, &inode_ref, flags);
+	errno_t rc = ext4_filesystem_alloc_inode(inst->filesystem, &inode_ref, flags);
 	if (rc != EOK) {
 		free(enode);
 		free(fs_node);
@@ -477,14 +486,40 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 	return EOK;
 }
 
-/** Destroy existing node.
+/** Create new node in filesystem.
+ *
+ * @param rfn        Output pointer to newly created node if successful
+ * @param service_id Device identifier, where the filesystem is
+ * @param flags      Flags for specification of new node parameters
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
+{
+	/* Load instance */
+	ext4_instance_t *inst;
+	errno_t rc = ext4_instance_get(service_id, &inst);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_journal_begin(inst->filesystem);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_create_node_core(rfn, inst, flags);
+	ext4_journal_end(inst->filesystem);
+	return rc;
+}
+
+/** Destroy existing node within a journal operation.
  *
  * @param fs Node to destroy
  *
  * @return Error code
  *
  */
-errno_t ext4_destroy_node(fs_node_t *fn)
+static errno_t ext4_destroy_node_core(fs_node_t *fn)
 {
 	/* If directory, check for children */
 	bool has_children;
@@ -526,7 +561,29 @@ errno_t ext4_destroy_node(fs_node_t *fn)
 	return ext4_node_put(fn);
 }
 
-/** Link the specfied node to directory.
+/** Destroy existing node.
+ *
+ * @param fs Node to destroy
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_destroy_node(fs_node_t *fn)
+{
+	ext4_filesystem_t *fs = EXT4_NODE(fn)->instance->filesystem;
+
+	errno_t rc = ext4_journal_begin(fs);
+	if (rc != EOK) {
+		ext4_node_put(fn);
+		return rc;
+	}
+
+	rc = ext4_destroy_node_core(fn);
+	ext4_journal_end(fs);
+	return rc;
+}
+
+/** Link the specfied node to directory within a journal operation.
  *
  * @param pfn  Parent node to link in
  * @param cfn  Node to be linked
@@ -535,12 +592,9 @@ errno_t ext4_destroy_node(fs_node_t *fn)
  * @return Error code
  *
  */
-errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+static errno_t ext4_link_core(fs_node_t *pfn, fs_node_t *cfn,
+    const char *name)
 {
-	/* Check maximum name length */
-	if (str_size(name) > EXT4_DIRECTORY_FILENAME_LEN)
-		return ENAMETOOLONG;
-
 	ext4_node_t *parent = EXT4_NODE(pfn);
 	ext4_node_t *child = EXT4_NODE(cfn);
 	ext4_filesystem_t *fs = parent->instance->filesystem;
@@ -599,7 +653,33 @@ errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return EOK;
 }
 
-/** Unlink node from specified directory.
+/** Link the specfied node to directory.
+ *
+ * @param pfn  Parent node to link in
+ * @param cfn  Node to be linked
+ * @param name Name which will be assigned to directory entry
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	/* Check maximum name length */
+	if (str_size(name) > EXT4_DIRECTORY_FILENAME_LEN)
+		return ENAMETOOLONG;
+
+	ext4_filesystem_t *fs = EXT4_NODE(pfn)->instance->filesystem;
+
+	errno_t rc = ext4_journal_begin(fs);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_link_core(pfn, cfn, name);
+	ext4_journal_end(fs);
+	return rc;
+}
+
+/** Unlink node from specified directory within a journal operation.
  *
  * @param pfn  Parent node to delete node from
  * @param cfn  Child node to be unlinked from directory
@@ -608,7 +688,8 @@ errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
  * @return Error code
  *
  */
-errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+static errno_t ext4_unlink_core(fs_node_t *pfn, fs_node_t *cfn,
+    const char *name)
 {
 	bool has_children;
 	errno_t rc = ext4_has_children(&has_children, cfn);
@@ -671,6 +752,28 @@ errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return EOK;
 }
 
+/** Unlink node from specified directory.
+ *
+ * @param pfn  Parent node to delete node from
+ * @param cfn  Child node to be unlinked from directory
+ * @param name Name of entry that will be removed
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	ext4_filesystem_t *fs = EXT4_NODE(pfn)->instance->filesystem;
+
+	errno_t rc = ext4_journal_begin(fs);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_unlink_core(pfn, cfn, name);
+	ext4_journal_end(fs);
+	return rc;
+}
+
 /** Check if specified node has children.
  *
  * For files is response allways false and check is executed only for directories.
@@ -1180,6 +1283,75 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 	}
 }
 
+/** Read a batch of directory entries.
+ *
+ * @param service_id Device to read data from
+ * @param index      Number of the directory node
+ * @param pos        Position where the read should be started
+ * @param rd         Batch of entries to fill
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_readdir(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, libfs_readdir_t *rd)
+{
+	ext4_instance_t *inst;
+	errno_t rc = ext4_instance_get(service_id, &inst);
+	if (rc != EOK)
+		return rc;
+
+	ext4_inode_ref_t *inode_ref;
+	rc = ext4_filesystem_get_inode_ref(inst->filesystem, index, &inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	if (!ext4_inode_is_type(inst->filesystem->superblock, inode_ref->inode,
+	    EXT4_INODE_MODE_DIRECTORY)) {
+		(void) ext4_filesystem_put_inode_ref(inode_ref);
+		return ENOTDIR;
+	}
+
+	ext4_directory_iterator_t it;
+	rc = ext4_directory_iterator_init(&it, inode_ref, pos);
+	if (rc != EOK) {
+		(void) ext4_filesystem_put_inode_ref(inode_ref);
+		return rc;
+	}
+
+	/* Longest name the on-disk entry can hold plus the terminator */
+	char name[EXT4_DIRECTORY_FILENAME_LEN + 1];
+
+	while (it.current != NULL) {
+		uint32_t inode = it.current->inode;
+		uint16_t name_size = ext4_directory_entry_ll_get_name_length(
+		    inst->filesystem->superblock, it.current);
+
+		bool skip = inode == 0 ||
+		    ext4_is_dots(it.current->name, name_size);
+		if (!skip) {
+			memcpy(name, &it.current->name, name_size);
+			name[name_size] = '\0';
+		}
+
+		rc = ext4_directory_iterator_next(&it);
+		if (rc != EOK)
+			break;
+
+		/* The iterator has moved past the entry, its offset is next */
+		if (!skip && !libfs_readdir_add(rd, name, inode,
+		    it.current_offset))
+			break;
+	}
+
+	errno_t rc2 = ext4_directory_iterator_fini(&it);
+	errno_t rc3 = ext4_filesystem_put_inode_ref(inode_ref);
+
+	if (rc == EOK)
+		rc = rc2;
+	return rc == EOK ? rc3 : rc;
+}
+
 /** Read data from file.
  *
  * @param call      IPC call
@@ -1205,30 +1377,41 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 		return EOK;
 	}
 
-	/* For now, we only read data from one block at a time */
+	/*
+	 * Read at most one run of blocks which are stored contiguously on the
+	 * device (or are all sparse).
+	 */
 	uint32_t block_size = ext4_superblock_get_block_size(sb);
 	aoff64_t file_block = pos / block_size;
 	uint32_t offset_in_block = pos % block_size;
-	uint32_t bytes = min(block_size - offset_in_block, size);
 
 	/* Handle end of file */
-	if (pos + bytes > file_size)
-		bytes = file_size - pos;
+	size = min(size, DATA_XFER_LIMIT);
+	if (pos + size > file_size)
+		size = file_size - pos;
+
+	uint32_t max_blocks = (offset_in_block + size + block_size - 1) /
+	    block_size;
+	if (max_blocks == 0)
+		max_blocks = 1;
 
-	/* Get the real block number */
+	/* Get the real block numbers */
 	uint32_t fs_block;
-	errno_t rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
-	    file_block, &fs_block);
+	uint32_t count;
+	errno_t rc = ext4_filesystem_get_inode_data_blocks(inode_ref,
+	    file_block, max_blocks, &fs_block, &count);
 	if (rc != EOK) {
 		async_answer_0(call, rc);
 		return rc;
 	}
 
+	size_t bytes = min(size, count * block_size - offset_in_block);
+
 	/*
 	 * Check for sparse file.
-	 * If ext4_filesystem_get_inode_data_block_index returned
-	 * fs_block == 0, it means that the given block is not allocated for the
-	 * file and we need to return a buffer of zeros
+	 * If ext4_filesystem_get_inode_data_blocks returned
+	 * fs_block == 0, it means that the given blocks are not allocated for
+	 * the file and we need to return a buffer of zeros
 	 */
 	uint8_t *buffer;
 	if (fs_block == 0) {
@@ -1247,6 +1430,31 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 		return rc;
 	}
 
+	if (count > 1) {
+		/* Read the whole run with one request, bypassing the cache */
+		buffer = malloc(count * block_size);
+		if (buffer == NULL) {
+			async_answer_0(call, ENOMEM);
+			return ENOMEM;
+		}
+
+		rc = block_read_range(inst->service_id, fs_block, count, buffer);
+		if (rc != EOK) {
+			free(buffer);
+			async_answer_0(call, rc);
+			return rc;
+		}
+
+		rc = async_data_read_finalize(call, buffer + offset_in_block,
+		    bytes);
+		free(buffer);
+		if (rc != EOK)
+			return rc;
+
+		*rbytes = bytes;
+		return EOK;
+	}
+
 	/* Usual case - we need to read a block from device */
 	block_t *block;
 	rc = block_get(&block, inst->service_id, fs_block, BLOCK_FLAGS_NONE);
@@ -1270,7 +1478,137 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 	return EOK;
 }
 
-/** Write bytes to file
+/** Write a run of contiguous blocks.
+ *
+ * The data are received from the client into a buffer covering the whole
+ * run, which is then written to the device with one request. Partially
+ * written blocks at the edges of the run are read first, unless they have
+ * just been allocated.
+ *
+ * @param call   Pending data write call
+ * @param fs     Filesystem to write to
+ * @param fblock Physical address of the first block of the run
+ * @param count  Number of blocks in the run
+ * @param offset Offset of the written data in the first block
+ * @param bytes  Number of bytes to write
+ * @param fresh  True if the blocks have just been allocated
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_write_blocks(ipc_call_t *call, ext4_filesystem_t *fs,
+    uint32_t fblock, uint32_t count, uint32_t offset, uint32_t bytes,
+    bool fresh)
+{
+	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+	uint32_t end = offset + bytes;
+	errno_t rc;
+
+	uint8_t *buffer = malloc(count * block_size);
+	if (buffer == NULL) {
+		async_answer_0(call, ENOMEM);
+		return ENOMEM;
+	}
+
+	if (fresh) {
+		memset(buffer, 0, offset);
+		memset(buffer + end, 0, count * block_size - end);
+	} else {
+		rc = EOK;
+		if (offset != 0)
+			rc = block_read_range(fs->device, fblock, 1, buffer);
+		if (rc == EOK && (end % block_size) != 0) {
+			rc = block_read_range(fs->device, fblock + count - 1, 1,
+			    buffer + (count - 1) * block_size);
+		}
+
+		if (rc != EOK) {
+			free(buffer);
+			async_answer_0(call, rc);
+			return rc;
+		}
+	}
+
+	rc = async_data_write_finalize(call, buffer + offset, bytes);
+	if (rc == EOK)
+		rc = block_write_range(fs->device, fblock, count, buffer);
+
+	free(buffer);
+	return rc;
+}
+
+/** Get a run of blocks of a file to be written, allocating it if needed.
+ *
+ * @param inode_ref  I-node of the file
+ * @param iblock     Logical number of the first block of the run
+ * @param max_blocks Maximum number of blocks of the run
+ * @param fblock     Output value - physical number of the first block
+ * @param count      Output value - number of blocks of the run
+ * @param fresh      Output value - true if the blocks have just been
+ *                   allocated and their contents need not be read
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_write_run_get(ext4_inode_ref_t *inode_ref, uint32_t iblock,
+    uint32_t max_blocks, uint32_t *fblock, uint32_t *count, bool *fresh)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+
+	errno_t rc = ext4_filesystem_get_inode_data_blocks(inode_ref, iblock,
+	    max_blocks, fblock, count);
+	if (rc != EOK)
+		return rc;
+
+	*fresh = false;
+	if (*fblock != 0)
+		return EOK;
+
+	/* Sparse file */
+	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
+		uint32_t last_iblock =
+		    ext4_inode_get_size(fs->superblock, inode_ref->inode) /
+		    block_size;
+
+		while (last_iblock < iblock) {
+			rc = ext4_extent_append_block(inode_ref, &last_iblock,
+			    fblock, true);
+			if (rc != EOK)
+				return rc;
+		}
+
+		/*
+		 * Allocate the blocks for the whole request at once, so that
+		 * they are contiguous if possible.
+		 */
+		rc = ext4_extent_append_blocks(inode_ref, max_blocks,
+		    &last_iblock, fblock, count);
+		if (rc != EOK)
+			return rc;
+	} else {
+		rc = ext4_balloc_alloc_block(inode_ref, fblock);
+		if (rc != EOK)
+			return rc;
+
+		rc = ext4_filesystem_set_inode_data_block_index(inode_ref,
+		    iblock, *fblock);
+		if (rc != EOK) {
+			ext4_balloc_free_block(inode_ref, *fblock);
+			return rc;
+		}
+
+		*count = 1;
+	}
+
+	*fresh = true;
+	inode_ref->dirty = true;
+	return EOK;
+}
+
+/** Write bytes to file within a journal operation.
  *
  * @param service_id Device identifier
  * @param index      I-node number of file
@@ -1281,8 +1619,8 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
  * @return Error code
  *
  */
-static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
-    size_t *wbytes, aoff64_t *nsize)
+static errno_t ext4_write_core(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, size_t *wbytes, aoff64_t *nsize)
 {
 	fs_node_t *fn;
 	errno_t rc2;
@@ -1302,94 +1640,71 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	ext4_filesystem_t *fs = enode->instance->filesystem;
 
 	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+	uint32_t offset_in_block = pos % block_size;
 
-	/* Prevent writing to more than one block */
-	uint32_t bytes = min(len, block_size - (pos % block_size));
-
-	int flags = BLOCK_FLAGS_NONE;
-	if (bytes == block_size)
-		flags = BLOCK_FLAGS_NOREAD;
+	/*
+	 * Write at most one run of blocks which are stored contiguously on the
+	 * device.
+	 */
+	len = min(len, DATA_XFER_LIMIT);
+	uint32_t max_blocks = (offset_in_block + len + block_size - 1) /
+	    block_size;
+	if (max_blocks == 0)
+		max_blocks = 1;
 
-	uint32_t iblock =  pos / block_size;
 	uint32_t fblock;
+	uint32_t count;
+	bool fresh;
 
-	/* Load inode */
 	ext4_inode_ref_t *inode_ref = enode->inode_ref;
-	rc = ext4_filesystem_get_inode_data_block_index(inode_ref, iblock,
-	    &fblock);
+	rc = ext4_write_run_get(inode_ref, pos / block_size, max_blocks,
+	    &fblock, &count, &fresh);
 	if (rc != EOK) {
 		async_answer_0(&call, rc);
 		goto exit;
 	}
 
-	/* Check for sparse file */
-	if (fblock == 0) {
-		if ((ext4_superblock_has_feature_incompatible(fs->superblock,
-		    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
-		    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
-			uint32_t last_iblock =
-			    ext4_inode_get_size(fs->superblock, inode_ref->inode) /
-			    block_size;
-
-			while (last_iblock < iblock) {
-				rc = ext4_extent_append_block(inode_ref, &last_iblock,
-				    &fblock, true);
-				if (rc != EOK) {
-					async_answer_0(&call, rc);
-					goto exit;
-				}
-			}
+	uint32_t bytes = min(len, count * block_size - offset_in_block);
 
-			rc = ext4_extent_append_block(inode_ref, &last_iblock,
-			    &fblock, false);
-			if (rc != EOK) {
-				async_answer_0(&call, rc);
-				goto exit;
-			}
-		} else {
-			rc = ext4_balloc_alloc_block(inode_ref, &fblock);
-			if (rc != EOK) {
-				async_answer_0(&call, rc);
-				goto exit;
-			}
+	/*
+	 * File data bypasses the journal. Writing it before the metadata
+	 * which refers to it is committed keeps the file system consistent.
+	 */
+	if (count > 1 || fs->journal != NULL) {
+		rc = ext4_write_blocks(&call, fs, fblock, count, offset_in_block,
+		    bytes, fresh);
+		if (rc != EOK)
+			goto exit;
+	} else {
+		int flags = BLOCK_FLAGS_NONE;
+		if (fresh || bytes == block_size)
+			flags = BLOCK_FLAGS_NOREAD;
 
-			rc = ext4_filesystem_set_inode_data_block_index(inode_ref,
-			    iblock, fblock);
-			if (rc != EOK) {
-				ext4_balloc_free_block(inode_ref, fblock);
-				async_answer_0(&call, rc);
-				goto exit;
-			}
+		/* Load target block */
+		block_t *write_block;
+		rc = block_get(&write_block, service_id, fblock, flags);
+		if (rc != EOK) {
+			async_answer_0(&call, rc);
+			goto exit;
 		}
 
-		flags = BLOCK_FLAGS_NOREAD;
-		inode_ref->dirty = true;
-	}
+		if (flags == BLOCK_FLAGS_NOREAD)
+			memset(write_block->data, 0, block_size);
 
-	/* Load target block */
-	block_t *write_block;
-	rc = block_get(&write_block, service_id, fblock, flags);
-	if (rc != EOK) {
-		async_answer_0(&call, rc);
-		goto exit;
-	}
+		rc = async_data_write_finalize(&call, write_block->data +
+		    offset_in_block, bytes);
+		if (rc != EOK) {
+			block_put(write_block);
+			goto exit;
+		}
 
-	if (flags == BLOCK_FLAGS_NOREAD)
-		memset(write_block->data, 0, block_size);
+		write_block->dirty = true;
 
-	rc = async_data_write_finalize(&call, write_block->data +
-	    (pos % block_size), bytes);
-	if (rc != EOK) {
-		block_put(write_block);
-		goto exit;
+		rc = block_put(write_block);
+		if (rc != EOK)
+			goto exit;
 	}
 
-	write_block->dirty = true;
-
-	rc = block_put(write_block);
-	if (rc != EOK)
-		goto exit;
-
 	/* Do some counting */
 	uint32_t old_inode_size = ext4_inode_get_size(fs->superblock,
 	    inode_ref->inode);
@@ -1406,6 +1721,248 @@ exit:
 	return rc == EOK ? rc2 : rc;
 }
 
+/** Write bytes to file
+ *
+ * @param service_id Device identifier
+ * @param index      I-node number of file
+ * @param pos        Position in file to start reading from
+ * @param wbytes     Output value - real number of written bytes
+ * @param nsize      Output value - new size of i-node
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
+    size_t *wbytes, aoff64_t *nsize)
+{
+	ext4_instance_t *inst;
+	errno_t rc = ext4_instance_get(service_id, &inst);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_journal_begin(inst->filesystem);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_write_core(service_id, index, pos, wbytes, nsize);
+	ext4_journal_end(inst->filesystem);
+	return rc;
+}
+
+/** Read bytes of a file into a buffer.
+ *
+ * The data are read run by run, holes read as zeros.
+ *
+ * @param inode_ref I-node of the file
+ * @param pos       Position in the file
+ * @param size      Number of bytes to read, must be within the file
+ * @param buf       Buffer for the data
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_read_bytes(ext4_inode_ref_t *inode_ref, aoff64_t pos,
+    size_t size, uint8_t *buf)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+
+	while (size > 0) {
+		uint32_t offset = pos % block_size;
+		uint32_t max_blocks = (offset + size + block_size - 1) /
+		    block_size;
+
+		uint32_t fblock;
+		uint32_t count;
+		errno_t rc = ext4_filesystem_get_inode_data_blocks(inode_ref,
+		    pos / block_size, max_blocks, &fblock, &count);
+		if (rc != EOK)
+			return rc;
+
+		size_t bytes = min(size, count * block_size - offset);
+
+		if (fblock == 0) {
+			memset(buf, 0, bytes);
+		} else if (offset == 0 && (bytes % block_size) == 0) {
+			rc = block_read_range(fs->device, fblock, count, buf);
+		} else {
+			/* Partial blocks at the edges of the run */
+			uint8_t *run = malloc(count * block_size);
+			if (run == NULL)
+				return ENOMEM;
+
+			rc = block_read_range(fs->device, fblock, count, run);
+			if (rc == EOK)
+				memcpy(buf, run + offset, bytes);
+			free(run);
+		}
+
+		if (rc != EOK)
+			return rc;
+
+		pos += bytes;
+		buf += bytes;
+		size -= bytes;
+	}
+
+	return EOK;
+}
+
+/** Copy a range of bytes between files within journal operations.
+ *
+ * The destination is written run by run. Blocks of the destination which
+ * are not allocated yet are allocated for the whole run at once, so that
+ * they are contiguous if possible, and each run is written with a single
+ * request. Every run is a separate journal operation.
+ *
+ * @param src     I-node of the source file
+ * @param src_pos Position in the source file
+ * @param dst     I-node of the destination file
+ * @param dst_pos Position in the destination file
+ * @param size    Number of bytes to copy
+ * @param copied  Output value - number of bytes copied
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_copy_range_core(ext4_inode_ref_t *src, aoff64_t src_pos,
+    ext4_inode_ref_t *dst, aoff64_t dst_pos, aoff64_t size, aoff64_t *copied)
+{
+	ext4_filesystem_t *fs = dst->fs;
+	ext4_superblock_t *sb = fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	uint64_t src_size = ext4_inode_get_size(sb, src->inode);
+	if (src_pos >= src_size)
+		size = 0;
+	else
+		size = min(size, src_size - src_pos);
+
+	uint8_t *buffer = malloc(EXT4_COPY_CHUNK + block_size);
+	if (buffer == NULL)
+		return ENOMEM;
+
+	aoff64_t done = 0;
+	errno_t rc = EOK;
+
+	while (done < size) {
+		aoff64_t pos = dst_pos + done;
+		uint32_t offset = pos % block_size;
+		size_t len = min(size - done, EXT4_COPY_CHUNK);
+		uint32_t max_blocks = (offset + len + block_size - 1) /
+		    block_size;
+
+		rc = ext4_journal_begin(fs);
+		if (rc != EOK)
+			break;
+
+		uint32_t fblock;
+		uint32_t count;
+		bool fresh;
+		rc = ext4_write_run_get(dst, pos / block_size, max_blocks,
+		    &fblock, &count, &fresh);
+
+		size_t bytes = 0;
+		if (rc == EOK) {
+			bytes = min(len, count * block_size - offset);
+			uint32_t end = offset + bytes;
+
+			/* Keep the data around the copied range */
+			if (fresh) {
+				memset(buffer, 0, offset);
+				memset(buffer + end, 0, count * block_size - end);
+			} else {
+				if (offset != 0) {
+					rc = block_read_range(fs->device, fblock,
+					    1, buffer);
+				}
+				if (rc == EOK && (end % block_size) != 0) {
+					rc = block_read_range(fs->device,
+					    fblock + count - 1, 1,
+					    buffer + (count - 1) * block_size);
+				}
+			}
+		}
+
+		if (rc == EOK)
+			rc = ext4_read_bytes(src, src_pos + done, bytes,
+			    buffer + offset);
+
+		/* Data bypass the journal, see ext4_write_core() */
+		if (rc == EOK)
+			rc = block_write_range(fs->device, fblock, count, buffer);
+
+		if (rc == EOK) {
+			done += bytes;
+			if (dst_pos + done > ext4_inode_get_size(sb, dst->inode)) {
+				ext4_inode_set_size(dst->inode, dst_pos + done);
+				dst->dirty = true;
+			}
+		}
+
+		ext4_journal_end(fs);
+		if (rc != EOK)
+			break;
+	}
+
+	free(buffer);
+
+	/* Report a partial copy, the error will come with the next request */
+	*copied = done;
+	return (done > 0) ? EOK : rc;
+}
+
+/** Copy a range of bytes between files
+ *
+ * @param service_id Device identifier
+ * @param src_index  I-node number of the source file
+ * @param src_pos    Position in the source file
+ * @param dst_index  I-node number of the destination file
+ * @param dst_pos    Position in the destination file
+ * @param size       Number of bytes to copy
+ * @param copied     Output value - number of bytes copied
+ * @param nsize      Output value - new size of the destination i-node
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_copy_range(service_id_t service_id, fs_index_t src_index,
+    aoff64_t src_pos, fs_index_t dst_index, aoff64_t dst_pos, aoff64_t size,
+    aoff64_t *copied, aoff64_t *nsize)
+{
+	fs_node_t *src_fn;
+	errno_t rc = ext4_node_get(&src_fn, service_id, src_index);
+	if (rc != EOK)
+		return rc;
+
+	fs_node_t *dst_fn;
+	rc = ext4_node_get(&dst_fn, service_id, dst_index);
+	if (rc != EOK) {
+		ext4_node_put(src_fn);
+		return rc;
+	}
+
+	ext4_inode_ref_t *src = EXT4_NODE(src_fn)->inode_ref;
+	ext4_inode_ref_t *dst = EXT4_NODE(dst_fn)->inode_ref;
+	ext4_superblock_t *sb = dst->fs->superblock;
+
+	if (!ext4_inode_is_type(sb, src->inode, EXT4_INODE_MODE_FILE) ||
+	    !ext4_inode_is_type(sb, dst->inode, EXT4_INODE_MODE_FILE))
+		rc = EINVAL;
+	else
+		rc = ext4_copy_range_core(src, src_pos, dst, dst_pos, size,
+		    copied);
+
+	*nsize = ext4_inode_get_size(sb, dst->inode);
+
+	errno_t rc2 = ext4_node_put(dst_fn);
+	errno_t rc3 = ext4_node_put(src_fn);
+	if (rc != EOK)
+		return rc;
+
+	return (rc2 != EOK) ? rc2 : rc3;
+}
+
 /** Truncate file.
  *
  * Only the direction to shorter file is supported.
@@ -1426,9 +1983,15 @@ static errno_t ext4_truncate(service_id_t service_id, fs_index_t index,
 		return rc;
 
 	ext4_node_t *enode = EXT4_NODE(fn);
+	ext4_filesystem_t *fs = enode->instance->filesystem;
 	ext4_inode_ref_t *inode_ref = enode->inode_ref;
 
-	rc = ext4_filesystem_truncate_inode(inode_ref, new_size);
+	rc = ext4_journal_begin(fs);
+	if (rc == EOK) {
+		rc = ext4_filesystem_truncate_inode(inode_ref, new_size);
+		ext4_journal_end(fs);
+	}
+
 	errno_t const rc2 = ext4_node_put(fn);
 
 	return rc == EOK ? rc2 : rc;
@@ -1480,9 +2043,15 @@ static errno_t ext4_sync(service_id_t service_id, fs_index_t index)
 		return rc;
 
 	ext4_node_t *enode = EXT4_NODE(fn);
+	ext4_filesystem_t *fs = enode->instance->filesystem;
 	enode->inode_ref->dirty = true;
 
-	return ext4_node_put(fn);
+	rc = ext4_node_put(fn);
+	if (rc != EOK)
+		return rc;
+
+	/* Make all finished operations persistent */
+	return ext4_journal_commit(fs);
 }
 
 /** VFS operations
@@ -1497,7 +2066,9 @@ vfs_out_ops_t ext4_ops = {
 	.truncate = ext4_truncate,
 	.close = ext4_close,
 	.destroy = ext4_destroy,
-	.sync = ext4_sync
+	.sync = ext4_sync,
+	.readdir = ext4_readdir,
+	.copy_range = ext4_copy_range
 };
 
 /**
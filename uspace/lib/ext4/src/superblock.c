@@ -1395,6 +1395,28 @@ void ext4_superblock_set_reserved_gdt_blocks(ext4_superblock_t *sb,
 	sb->reserved_gdt_blocks = host2uint32_t_le(n);
 }
 
+/** Get the number of the journal i-node
+ *
+ * @param sb    Pointer to the superblock
+ *
+ * @return      I-node number
+ */
+uint32_t ext4_superblock_get_journal_inode_number(ext4_superblock_t *sb)
+{
+	return uint32_t_le2host(sb->journal_inode_number);
+}
+
+/** Set the number of the journal i-node
+ *
+ * @param sb    Pointer to the superblock
+ * @param n     I-node number
+ */
+void ext4_superblock_set_journal_inode_number(ext4_superblock_t *sb,
+    uint32_t n)
+{
+	sb->journal_inode_number = host2uint32_t_le(n);
+}
+
 /** Get the size of the flex groups
  *
  * @param sb	Pointer to the superblock
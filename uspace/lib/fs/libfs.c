@@ -36,6 +36,7 @@
 
 #include "libfs.h"
 #include <macros.h>
+#include <align.h>
 #include <errno.h>
 #include <async.h>
 #include <as.h>
@@ -63,6 +64,19 @@
 		return; \
 	} while (0)
 
+struct libfs_readdir {
+	/** Buffer for the entries. */
+	uint8_t *buf;
+	/** Size of the buffer. */
+	size_t size;
+	/** Number of bytes of entries in the buffer. */
+	size_t used;
+	/** Position following the last entry in the buffer. */
+	aoff64_t pos;
+	/** An entry did not fit in the buffer. */
+	bool overflow;
+};
+
 static fs_reg_t reg;
 
 static vfs_out_ops_t *vfs_out_ops = NULL;
@@ -166,6 +180,130 @@ static void vfs_out_read(ipc_call_t *req)
 		async_answer_0(req, rc);
 }
 
+/** Add a directory entry to a batch.
+ *
+ * Called by the readdir operation of the file system for each entry. The
+ * attributes of the entries are filled in by libfs afterwards, so the file
+ * system may hold locks of the directory while adding the entries.
+ *
+ * @param rd	Batch of entries.
+ * @param name	Name of the entry.
+ * @param index	Index of the node the entry refers to.
+ * @param next	Position of the entry following this one.
+ *
+ * @return	True if the entry was added, false if the batch is full.
+ */
+bool libfs_readdir_add(libfs_readdir_t *rd, const char *name,
+    fs_index_t index, aoff64_t next)
+{
+	size_t len = str_size(name) + 1;
+	size_t reclen = ALIGN_UP(offsetof(vfs_dirent_t, name) + len,
+	    sizeof(aoff64_t));
+
+	if (reclen > rd->size - rd->used) {
+		rd->overflow = true;
+		return false;
+	}
+
+	vfs_dirent_t *ent = (vfs_dirent_t *) (rd->buf + rd->used);
+	memset(ent, 0, reclen);
+	ent->reclen = reclen;
+	ent->index = index;
+	memcpy(ent->name, name, len);
+
+	rd->used += reclen;
+	rd->pos = next;
+	return true;
+}
+
+/** Fill in the attributes of the entries of a batch. */
+static errno_t libfs_readdir_stat(service_id_t service_id, libfs_readdir_t *rd)
+{
+	size_t off = 0;
+
+	while (off < rd->used) {
+		vfs_dirent_t *ent = (vfs_dirent_t *) (rd->buf + off);
+
+		fs_node_t *fn;
+		errno_t rc = libfs_ops->node_get(&fn, service_id, ent->index);
+		if (rc != EOK)
+			return rc;
+		if (fn == NULL)
+			return ENOENT;
+
+		ent->lnkcnt = libfs_ops->lnkcnt_get(fn);
+		ent->is_file = libfs_ops->is_file(fn);
+		ent->is_directory = libfs_ops->is_directory(fn);
+		ent->size = libfs_ops->size_get(fn);
+
+		rc = libfs_ops->node_put(fn);
+		if (rc != EOK)
+			return rc;
+
+		off += ent->reclen;
+	}
+
+	return EOK;
+}
+
+static void vfs_out_readdir(ipc_call_t *req)
+{
+	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
+	fs_index_t index = (fs_index_t) ipc_get_arg2(req);
+	aoff64_t pos = (aoff64_t) MERGE_LOUP32(ipc_get_arg3(req),
+	    ipc_get_arg4(req));
+	errno_t rc;
+
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	if (vfs_out_ops->readdir == NULL) {
+		async_answer_0(&call, ENOTSUP);
+		async_answer_0(req, ENOTSUP);
+		return;
+	}
+
+	libfs_readdir_t rd;
+	rd.buf = malloc(size);
+	rd.size = size;
+	rd.used = 0;
+	rd.pos = pos;
+	rd.overflow = false;
+
+	if (rd.buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(req, ENOMEM);
+		return;
+	}
+
+	rc = vfs_out_ops->readdir(service_id, index, pos, &rd);
+
+	/*
+	 * Return the entries read before an error, the error will be
+	 * reported by the next request.
+	 */
+	if (rd.used > 0)
+		rc = libfs_readdir_stat(service_id, &rd);
+	else if (rc == EOK && rd.overflow)
+		rc = EOVERFLOW;
+
+	if (rc != EOK) {
+		free(rd.buf);
+		async_answer_0(&call, rc);
+		async_answer_0(req, rc);
+		return;
+	}
+
+	(void) async_data_read_finalize(&call, rd.buf, rd.used);
+	free(rd.buf);
+	async_answer_3(req, EOK, rd.used, LOWER32(rd.pos), UPPER32(rd.pos));
+}
+
 static void vfs_out_write(ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
@@ -209,6 +347,46 @@ static void vfs_out_close(ipc_call_t *req)
 	async_answer_0(req, rc);
 }
 
+static void vfs_out_copy_range(ipc_call_t *req)
+{
+	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
+	fs_index_t src_index = (fs_index_t) ipc_get_arg2(req);
+	fs_index_t dst_index = (fs_index_t) ipc_get_arg3(req);
+	vfs_copy_range_t range;
+	errno_t rc;
+
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_write_receive(&call, &size) || size != sizeof(range)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	rc = async_data_write_finalize(&call, &range, sizeof(range));
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		return;
+	}
+
+	if (vfs_out_ops->copy_range == NULL) {
+		async_answer_0(req, ENOTSUP);
+		return;
+	}
+
+	aoff64_t copied = 0;
+	aoff64_t nsize = 0;
+	rc = vfs_out_ops->copy_range(service_id, src_index, range.src_pos,
+	    dst_index, range.dst_pos, range.size, &copied, &nsize);
+
+	if (rc == EOK) {
+		async_answer_4(req, EOK, LOWER32(copied), UPPER32(copied),
+		    LOWER32(nsize), UPPER32(nsize));
+	} else {
+		async_answer_0(req, rc);
+	}
+}
+
 static void vfs_out_destroy(ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
@@ -313,6 +491,9 @@ static void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_OUT_READ:
 			vfs_out_read(&call);
 			break;
+		case VFS_OUT_READDIR:
+			vfs_out_readdir(&call);
+			break;
 		case VFS_OUT_WRITE:
 			vfs_out_write(&call);
 			break;
@@ -322,6 +503,9 @@ static void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_OUT_CLOSE:
 			vfs_out_close(&call);
 			break;
+		case VFS_OUT_COPY_RANGE:
+			vfs_out_copy_range(&call);
+			break;
 		case VFS_OUT_DESTROY:
 			vfs_out_destroy(&call);
 			break;
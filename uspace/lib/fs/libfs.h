@@ -41,6 +41,9 @@
 #include <async.h>
 #include <loc.h>
 
+/** Batch of directory entries being filled by vfs_out_ops_t.readdir. */
+typedef struct libfs_readdir libfs_readdir_t;
+
 typedef struct {
 	errno_t (*fsprobe)(service_id_t, vfs_fs_probe_info_t *);
 	errno_t (*mounted)(service_id_t, const char *, fs_index_t *, aoff64_t *);
@@ -52,6 +55,20 @@ typedef struct {
 	errno_t (*close)(service_id_t, fs_index_t);
 	errno_t (*destroy)(service_id_t, fs_index_t);
 	errno_t (*sync)(service_id_t, fs_index_t);
+	/*
+	 * Optional batched directory read. Starting at the given position,
+	 * pass the entries to libfs_readdir_add() until it returns false or
+	 * the directory ends.
+	 */
+	errno_t (*readdir)(service_id_t, fs_index_t, aoff64_t, libfs_readdir_t *);
+	/*
+	 * Optional copy of a range of bytes from one file to another (source
+	 * index and position, destination index and position, size). Stops
+	 * at the end of the source file. Returns the number of bytes copied
+	 * and the new size of the destination file.
+	 */
+	errno_t (*copy_range)(service_id_t, fs_index_t, aoff64_t, fs_index_t,
+	    aoff64_t, aoff64_t, aoff64_t *, aoff64_t *);
 } vfs_out_ops_t;
 
 typedef struct {
@@ -99,6 +116,9 @@ extern errno_t fs_register(async_sess_t *, vfs_info_t *, vfs_out_ops_t *,
 
 extern void fs_node_initialize(fs_node_t *);
 
+extern bool libfs_readdir_add(libfs_readdir_t *, const char *, fs_index_t,
+    aoff64_t);
+
 extern errno_t fs_instance_create(service_id_t, void *);
 extern errno_t fs_instance_get(service_id_t, void **);
 extern errno_t fs_instance_destroy(service_id_t);
@@ -46,6 +46,14 @@ typedef struct {
 	void *arg;
 } iplink_t;
 
+/** IP link offload capabilities */
+typedef enum {
+	/** Link completes partial TCP and UDP checksums */
+	IPLINK_OFFLOAD_CSUM = 0x1,
+	/** Link segments TCP/IPv4 packets larger than the MTU */
+	IPLINK_OFFLOAD_TSO4 = 0x2
+} iplink_offload_t;
+
 /** IPv4 link Service Data Unit */
 typedef struct {
 	/** Local source address */
@@ -56,6 +64,15 @@ typedef struct {
 	void *data;
 	/** Size of @c data in bytes */
 	size_t size;
+	/**
+	 * Offset of the first byte covered by the TCP or UDP checksum, zero
+	 * if the packet carries a complete checksum (IPLINK_OFFLOAD_CSUM)
+	 */
+	uint16_t csum_start;
+	/** Offset of the partial checksum field from @c csum_start */
+	uint16_t csum_offset;
+	/** TCP segment payload size, zero if not to be segmented */
+	uint16_t gso_size;
 } iplink_sdu_t;
 
 /** IPv6 link Service Data Unit */
@@ -89,6 +106,7 @@ extern errno_t iplink_addr_add(iplink_t *, inet_addr_t *);
 extern errno_t iplink_addr_remove(iplink_t *, inet_addr_t *);
 extern errno_t iplink_get_mtu(iplink_t *, size_t *);
 extern errno_t iplink_get_mac48(iplink_t *, addr48_t *);
+extern errno_t iplink_get_offload(iplink_t *, iplink_offload_t *);
 extern errno_t iplink_set_mac48(iplink_t *, addr48_t);
 extern void *iplink_get_userptr(iplink_t *);
 
@@ -45,6 +45,9 @@ typedef enum {
 	INET_SET_PROTO
 } inet_request_t;
 
+/** INET_SEND checksum offset of a datagram with a complete checksum */
+#define INET_CSUM_NONE ((sysarg_t) -1)
+
 /** Events on Inet default port */
 typedef enum {
 	INET_EV_RECV = IPC_FIRST_USER_METHOD
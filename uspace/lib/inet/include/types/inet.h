@@ -37,6 +37,7 @@
 
 #include <inet/addr.h>
 #include <ipc/loc.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -50,6 +51,14 @@ typedef struct {
 	uint8_t tos;
 	void *data;
 	size_t size;
+	/**
+	 * The TCP or UDP checksum at @c csum_offset only holds the
+	 * pseudo-header sum, the checksum over @c data is completed when
+	 * the datagram is sent
+	 */
+	bool csum_partial;
+	/** Offset of the checksum field within @c data */
+	uint16_t csum_offset;
 } inet_dgram_t;
 
 typedef struct {
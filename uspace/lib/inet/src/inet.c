@@ -114,8 +114,9 @@ errno_t inet_send(inet_dgram_t *dgram, uint8_t ttl, inet_df_t df)
 	async_exch_t *exch = async_exchange_begin(inet_sess);
 
 	ipc_call_t answer;
-	aid_t req = async_send_4(exch, INET_SEND, dgram->iplink, dgram->tos,
-	    ttl, df, &answer);
+	aid_t req = async_send_5(exch, INET_SEND, dgram->iplink, dgram->tos,
+	    ttl, df, dgram->csum_partial ? dgram->csum_offset : INET_CSUM_NONE,
+	    &answer);
 
 	errno_t rc = async_data_write_start(exch, &dgram->src, sizeof(inet_addr_t));
 	if (rc != EOK) {
@@ -181,6 +182,7 @@ static void inet_ev_recv(ipc_call_t *icall)
 
 	dgram.tos = ipc_get_arg1(icall);
 	dgram.iplink = ipc_get_arg2(icall);
+	dgram.csum_partial = false;
 
 	ipc_call_t call;
 	size_t size;
@@ -89,8 +89,9 @@ errno_t iplink_send(iplink_t *iplink, iplink_sdu_t *sdu)
 	async_exch_t *exch = async_exchange_begin(iplink->sess);
 
 	ipc_call_t answer;
-	aid_t req = async_send_2(exch, IPLINK_SEND, (sysarg_t) sdu->src,
-	    (sysarg_t) sdu->dest, &answer);
+	aid_t req = async_send_5(exch, IPLINK_SEND, (sysarg_t) sdu->src,
+	    (sysarg_t) sdu->dest, sdu->csum_start, sdu->csum_offset,
+	    sdu->gso_size, &answer);
 
 	errno_t rc = async_data_write_start(exch, sdu->data, sdu->size);
 
@@ -152,6 +153,29 @@ errno_t iplink_get_mtu(iplink_t *iplink, size_t *rmtu)
 	return EOK;
 }
 
+/** Get offloads the IP link can perform on sent packets.
+ *
+ * @param iplink    IP link
+ * @param roffload  Place to store the offload capabilities
+ *
+ * @return EOK on success, ENOTSUP if the link has no offloads
+ */
+errno_t iplink_get_offload(iplink_t *iplink, iplink_offload_t *roffload)
+{
+	async_exch_t *exch = async_exchange_begin(iplink->sess);
+
+	sysarg_t offload;
+	errno_t rc = async_req_0_1(exch, IPLINK_GET_OFFLOAD, &offload);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK)
+		return rc;
+
+	*roffload = (iplink_offload_t) offload;
+	return EOK;
+}
+
 errno_t iplink_get_mac48(iplink_t *iplink, addr48_t *mac)
 {
 	async_exch_t *exch = async_exchange_begin(iplink->sess);
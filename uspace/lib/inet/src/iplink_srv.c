@@ -48,6 +48,18 @@ static void iplink_get_mtu_srv(iplink_srv_t *srv, ipc_call_t *call)
 	async_answer_1(call, rc, mtu);
 }
 
+static void iplink_get_offload_srv(iplink_srv_t *srv, ipc_call_t *call)
+{
+	if (srv->ops->get_offload == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	iplink_offload_t offload;
+	errno_t rc = srv->ops->get_offload(srv, &offload);
+	async_answer_1(call, rc, offload);
+}
+
 static void iplink_get_mac48_srv(iplink_srv_t *srv, ipc_call_t *icall)
 {
 	addr48_t mac;
@@ -163,6 +175,9 @@ static void iplink_send_srv(iplink_srv_t *srv, ipc_call_t *icall)
 
 	sdu.src = ipc_get_arg1(icall);
 	sdu.dest = ipc_get_arg2(icall);
+	sdu.csum_start = ipc_get_arg3(icall);
+	sdu.csum_offset = ipc_get_arg4(icall);
+	sdu.gso_size = ipc_get_arg5(icall);
 
 	errno_t rc = async_data_write_accept(&sdu.data, false, 0, 0, 0,
 	    &sdu.size);
@@ -285,6 +300,9 @@ errno_t iplink_conn(ipc_call_t *icall, void *arg)
 		case IPLINK_ADDR_REMOVE:
 			iplink_addr_remove_srv(srv, &call);
 			break;
+		case IPLINK_GET_OFFLOAD:
+			iplink_get_offload_srv(srv, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
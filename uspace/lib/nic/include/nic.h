@@ -84,6 +84,21 @@ typedef list_t nic_frame_list_t;
  */
 typedef void (*send_frame_handler)(nic_t *, void *, size_t);
 
+/**
+ * Handler for writing frame data to the NIC device together with the
+ * offloaded computations the NIC should perform on the frame.
+ * The function is responsible for releasing the frame.
+ * It does not return anything, if some error is detected the function just
+ * silently fails (logging on debug level is suggested).
+ *
+ * @param nic_data
+ * @param data		Pointer to frame data
+ * @param size		Size of frame data in bytes
+ * @param offload	Offloads requested for the frame
+ */
+typedef void (*send_offload_handler)(nic_t *, void *, size_t,
+    const nic_tx_offload_t *);
+
 /**
  * The handler for transitions between driver states.
  * If the handler returns error code, the transition between
@@ -218,6 +233,7 @@ extern void nic_driver_implement(driver_ops_t *, ddf_dev_ops_t *,
 extern errno_t nic_get_resources(nic_t *, hw_res_list_parsed_t *);
 extern void nic_set_specific(nic_t *, void *);
 extern void nic_set_send_frame_handler(nic_t *, send_frame_handler);
+extern void nic_set_send_offload_handler(nic_t *, send_offload_handler);
 extern void nic_set_state_change_handlers(nic_t *,
     state_change_handler, state_change_handler, state_change_handler);
 extern void nic_set_filtering_change_handlers(nic_t *,
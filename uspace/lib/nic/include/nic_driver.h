@@ -126,6 +126,12 @@ struct nic {
 	 * Called with the main_lock locked for reading.
 	 */
 	send_frame_handler send_frame;
+	/**
+	 * Function sending the data with offloaded computations, used by
+	 * nic_send_frame_offload_impl. The implementation is optional.
+	 * Called with the main_lock locked for reading.
+	 */
+	send_offload_handler send_offload;
 	/**
 	 * Event handler called when device goes to the ACTIVE state.
 	 * The implementation is optional.
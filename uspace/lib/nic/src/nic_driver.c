@@ -101,6 +101,8 @@ void nic_driver_implement(driver_ops_t *driver_ops, ddf_dev_ops_t *dev_ops,
 			iface->set_state = nic_set_state_impl;
 		if (!iface->send_frame)
 			iface->send_frame = nic_send_frame_impl;
+		if (!iface->send_frame_offload)
+			iface->send_frame_offload = nic_send_frame_offload_impl;
 		if (!iface->callback_create)
 			iface->callback_create = nic_callback_create_impl;
 		if (!iface->get_address)
@@ -160,6 +162,20 @@ void nic_set_send_frame_handler(nic_t *nic_data, send_frame_handler sffunc)
 	nic_data->send_frame = sffunc;
 }
 
+/**
+ * Setup handler for sending frames with offloaded computations. The
+ * handler is optional, it should only be set if the driver reports some
+ * transmit offloads as active. The function can be called only in the
+ * add_device handler.
+ *
+ * @param nic_data
+ * @param sofunc	Function handling the send_frame_offload request
+ */
+void nic_set_send_offload_handler(nic_t *nic_data, send_offload_handler sofunc)
+{
+	nic_data->send_offload = sofunc;
+}
+
 /**
  * Setup event handlers for transitions between driver states.
  * This function can be called only in the add_device handler.
@@ -612,6 +628,7 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->send_frame = NULL;
+	nic_data->send_offload = NULL;
 	nic_data->on_activating = NULL;
 	nic_data->on_going_down = NULL;
 	nic_data->on_stopping = NULL;
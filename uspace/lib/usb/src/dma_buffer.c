@@ -170,7 +170,8 @@ static bool dma_buffer_is_4gib(dma_buffer_t *db, size_t size)
 		return true;
 
 	const size_t chunk_size = dma_policy_chunk_mask(db->policy) + 1;
-	const size_t chunks = chunk_size ? 1 : size / chunk_size;
+	const size_t chunks = chunk_size ?
+	    (size + chunk_size - 1) / chunk_size : 1;
 
 	for (size_t c = 0; c < chunks; c++) {
 		const void *addr = db->virt + (c * chunk_size);
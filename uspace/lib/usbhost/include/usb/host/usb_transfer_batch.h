@@ -53,6 +53,14 @@
 typedef struct endpoint endpoint_t;
 typedef struct bus bus_t;
 
+/** Page of a transfer buffer replaced by a bounce page */
+typedef struct usb_transfer_bounce {
+	/** Index of the replaced page in the scatter-gather map */
+	size_t page;
+	/** The bounce page */
+	dma_buffer_t buffer;
+} usb_transfer_bounce_t;
+
 /** Structure stores additional data needed for communication with EP */
 typedef struct usb_transfer_batch {
 	/** Target for communication */
@@ -82,6 +90,16 @@ typedef struct usb_transfer_batch {
 	char *original_buffer;
 	bool is_bounced;
 
+	/**
+	 * Scatter-gather map of the buffer: physical address of every page the
+	 * transfer touches. NULL if the buffer is to be used as a whole.
+	 */
+	uintptr_t *sg_pages;
+	size_t sg_count;
+	/** Pages that cannot be used for DMA directly and were bounced */
+	usb_transfer_bounce_t *sg_bounces;
+	size_t sg_bounce_count;
+
 	/** Indicates success/failure of the communication */
 	errno_t error;
 	/** Actually used portion of the buffer */
@@ -119,6 +137,12 @@ void usb_transfer_batch_init(usb_transfer_batch_t *, endpoint_t *);
 bool usb_transfer_batch_bounce_required(usb_transfer_batch_t *);
 errno_t usb_transfer_batch_bounce(usb_transfer_batch_t *);
 
+/** Scatter-gather buffer handling */
+bool usb_transfer_batch_sg_supported(usb_transfer_batch_t *);
+errno_t usb_transfer_batch_map(usb_transfer_batch_t *);
+uintptr_t usb_transfer_batch_phys(const usb_transfer_batch_t *, size_t,
+    size_t *);
+
 /** Batch finalization. */
 void usb_transfer_batch_finish(usb_transfer_batch_t *);
 
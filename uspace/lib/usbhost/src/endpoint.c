@@ -267,13 +267,29 @@ errno_t endpoint_send_batch(endpoint_t *ep, const transfer_request_t *req)
 
 	dma_buffer_acquire(&batch->dma_buffer);
 
-	if (batch->offset != 0) {
-		usb_log_debug("A transfer with nonzero offset requested.");
-		usb_transfer_batch_bounce(batch);
-	}
+	/*
+	 * Controllers that take the buffer page by page get the client buffer
+	 * directly. Isochronous transfers are copied by the driver anyway.
+	 */
+	if (batch->size > 0 && ep->transfer_type != USB_TRANSFER_ISOCHRONOUS &&
+	    usb_transfer_batch_sg_supported(batch)) {
+		const errno_t err = usb_transfer_batch_map(batch);
+		if (err != EOK) {
+			usb_log_error("Failed to map transfer buffer: %s",
+			    str_error(err));
+			dma_buffer_release(&batch->dma_buffer);
+			usb_transfer_batch_destroy(batch);
+			return err;
+		}
+	} else {
+		if (batch->offset != 0) {
+			usb_log_debug("A transfer with nonzero offset requested.");
+			usb_transfer_batch_bounce(batch);
+		}
 
-	if (usb_transfer_batch_bounce_required(batch))
-		usb_transfer_batch_bounce(batch);
+		if (usb_transfer_batch_bounce_required(batch))
+			usb_transfer_batch_bounce(batch);
+	}
 
 	batch->on_complete = req->on_complete;
 	batch->on_complete_data = req->arg;
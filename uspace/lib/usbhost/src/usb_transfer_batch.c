@@ -33,8 +33,11 @@
  * USB transfer transaction structures (implementation).
  */
 
+#include <align.h>
+#include <as.h>
 #include <assert.h>
 #include <errno.h>
+#include <macros.h>
 #include <stdlib.h>
 #include <str_error.h>
 #include <usb/debug.h>
@@ -77,6 +80,50 @@ void usb_transfer_batch_init(usb_transfer_batch_t *batch, endpoint_t *ep)
 	batch->ep = ep;
 }
 
+/**
+ * Get the first byte of the transfer in the client buffer.
+ */
+static inline char *batch_data(const usb_transfer_batch_t *batch)
+{
+	return (char *) batch->dma_buffer.virt + batch->offset;
+}
+
+/**
+ * Get the part of the transfer which lies on a page of the scatter-gather map.
+ *
+ * @param[in] batch Mapped batch.
+ * @param[in] page Index of the page in the map.
+ * @param[out] pos Position of the part in the transfer.
+ * @return Size of the part.
+ */
+static size_t batch_page_range(const usb_transfer_batch_t *batch,
+    size_t page, size_t *pos)
+{
+	const size_t head = (uintptr_t) batch_data(batch) % PAGE_SIZE;
+	const size_t start = page ? page * PAGE_SIZE - head : 0;
+	const size_t end = min(batch->size, (page + 1) * PAGE_SIZE - head);
+
+	*pos = start;
+	return end - start;
+}
+
+/**
+ * Free the scatter-gather map together with the bounce pages.
+ */
+static void batch_unmap(usb_transfer_batch_t *batch)
+{
+	for (size_t i = 0; i < batch->sg_bounce_count; ++i)
+		dma_buffer_free(&batch->sg_bounces[i].buffer);
+
+	free(batch->sg_bounces);
+	batch->sg_bounces = NULL;
+	batch->sg_bounce_count = 0;
+
+	free(batch->sg_pages);
+	batch->sg_pages = NULL;
+	batch->sg_count = 0;
+}
+
 /**
  * Destroy the batch. If there's no bus callback, just free it.
  */
@@ -85,6 +132,8 @@ void usb_transfer_batch_destroy(usb_transfer_batch_t *batch)
 	assert(batch);
 	assert(batch->ep);
 
+	batch_unmap(batch);
+
 	bus_t *bus = endpoint_get_bus(batch->ep);
 	endpoint_t *ep = batch->ep;
 
@@ -161,6 +210,179 @@ errno_t usb_transfer_batch_bounce(usb_transfer_batch_t *batch)
 	return err;
 }
 
+/**
+ * Check whether the host controller accepts the buffer page by page.
+ *
+ * Such controllers describe the transfer by a list of pages, so the buffer
+ * need not be physically contiguous, and only the pages which violate the
+ * address restrictions have to be bounced.
+ */
+bool usb_transfer_batch_sg_supported(usb_transfer_batch_t *batch)
+{
+	return dma_policy_chunk_mask(batch->ep->required_transfer_buffer_policy)
+	    == PAGE_SIZE - 1;
+}
+
+/**
+ * Replace one page of the scatter-gather map by a bounce page.
+ *
+ * The data keep their offset within the page, so that the map stays linear.
+ */
+static errno_t batch_bounce_page(usb_transfer_batch_t *batch, size_t page)
+{
+	if (!batch->sg_bounces) {
+		batch->sg_bounces = calloc(batch->sg_count,
+		    sizeof(usb_transfer_bounce_t));
+		if (!batch->sg_bounces)
+			return ENOMEM;
+	}
+
+	usb_transfer_bounce_t *bounce =
+	    &batch->sg_bounces[batch->sg_bounce_count];
+
+	const errno_t err = dma_buffer_alloc_policy(&bounce->buffer, PAGE_SIZE,
+	    batch->ep->required_transfer_buffer_policy);
+	if (err)
+		return err;
+
+	bounce->page = page;
+	++batch->sg_bounce_count;
+
+	size_t pos;
+	const size_t size = batch_page_range(batch, page, &pos);
+	const size_t offset = (uintptr_t) (batch_data(batch) + pos) % PAGE_SIZE;
+
+	/* Copy the data out */
+	if (batch->dir == USB_DIRECTION_OUT)
+		memcpy(bounce->buffer.virt + offset, batch_data(batch) + pos,
+		    size);
+
+	batch->sg_pages[page] = dma_buffer_phys_base(&bounce->buffer);
+	return EOK;
+}
+
+/**
+ * Build a scatter-gather map of the batch buffer.
+ *
+ * The buffer is used in place, page by page. A bounce page is allocated only
+ * for the pages which lie above 4 GiB on a controller that cannot reach them.
+ */
+errno_t usb_transfer_batch_map(usb_transfer_batch_t *batch)
+{
+	assert(batch);
+	assert(!batch->is_bounced);
+	assert(!batch->sg_pages);
+	assert(batch->size > 0);
+
+	char *const data = batch_data(batch);
+	char *const first = (char *) ALIGN_DOWN((uintptr_t) data, PAGE_SIZE);
+	const size_t count =
+	    ALIGN_UP((uintptr_t) (data + batch->size), PAGE_SIZE) / PAGE_SIZE -
+	    (uintptr_t) first / PAGE_SIZE;
+
+	/* Pages of buffers not known to lie below 4 GiB have to be checked */
+	const bool check_4gib =
+	    (batch->ep->required_transfer_buffer_policy & DMA_POLICY_4GiB) &&
+	    !(batch->dma_buffer.policy & DMA_POLICY_4GiB);
+
+	batch->sg_pages = malloc(count * sizeof(uintptr_t));
+	if (!batch->sg_pages)
+		return ENOMEM;
+	batch->sg_count = count;
+
+	errno_t err;
+	for (size_t i = 0; i < count; ++i) {
+		err = as_get_physical_mapping(first + i * PAGE_SIZE,
+		    &batch->sg_pages[i]);
+		if (err)
+			goto error;
+
+		if (!check_4gib ||
+		    batch->sg_pages[i] + PAGE_SIZE - 1 <= UINT32_MAX)
+			continue;
+
+		usb_log_debug2("Batch(%p): Page %zu cannot be used directly, "
+		    "falling back to bounce page.", batch, i);
+
+		err = batch_bounce_page(batch, i);
+		if (err)
+			goto error;
+	}
+
+	return EOK;
+
+error:
+	batch_unmap(batch);
+	return err;
+}
+
+/**
+ * Get the physical address of the transfer data.
+ *
+ * Works both for mapped batches and for batches using the buffer as a whole.
+ *
+ * @param[in] batch Batch to examine.
+ * @param[in] pos Position in the transfer.
+ * @param[out] len Number of bytes physically contiguous from the position,
+ *                 at most to the end of the transfer. Can be NULL.
+ * @return Physical address of the byte at the position.
+ */
+uintptr_t usb_transfer_batch_phys(const usb_transfer_batch_t *batch,
+    size_t pos, size_t *len)
+{
+	assert(batch);
+	assert(pos < batch->size);
+
+	const size_t rest = batch->size - pos;
+	const char *virt = batch_data(batch) + pos;
+
+	if (!batch->sg_pages) {
+		const size_t chunk_mask =
+		    dma_policy_chunk_mask(batch->dma_buffer.policy);
+		const size_t offset =
+		    (virt - (char *) batch->dma_buffer.virt) & chunk_mask;
+
+		/* Wraps to zero for unlimited chunks */
+		size_t contiguous = chunk_mask - offset + 1;
+		if (contiguous == 0 || contiguous > rest)
+			contiguous = rest;
+
+		if (len)
+			*len = contiguous;
+		return dma_buffer_phys(&batch->dma_buffer, virt);
+	}
+
+	const size_t head = (uintptr_t) batch_data(batch) % PAGE_SIZE;
+	const size_t page = (head + pos) / PAGE_SIZE;
+	const size_t offset = (head + pos) % PAGE_SIZE;
+
+	assert(page < batch->sg_count);
+	if (len)
+		*len = min(PAGE_SIZE - offset, rest);
+	return batch->sg_pages[page] + offset;
+}
+
+/**
+ * Copy IN data from the bounce pages to the client buffer.
+ */
+static void batch_sg_copy_in(usb_transfer_batch_t *batch)
+{
+	for (size_t i = 0; i < batch->sg_bounce_count; ++i) {
+		usb_transfer_bounce_t *bounce = &batch->sg_bounces[i];
+
+		size_t pos;
+		size_t size = batch_page_range(batch, bounce->page, &pos);
+		if (pos >= batch->transferred_size)
+			continue;
+
+		size = min(size, batch->transferred_size - pos);
+		const size_t offset =
+		    (uintptr_t) (batch_data(batch) + pos) % PAGE_SIZE;
+		memcpy(batch_data(batch) + pos, bounce->buffer.virt + offset,
+		    size);
+	}
+}
+
 /**
  * Finish a transfer batch: call handler, destroy batch, release endpoint.
  *
@@ -184,6 +406,9 @@ void usb_transfer_batch_finish(usb_transfer_batch_t *batch)
 
 			dma_buffer_free(&batch->dma_buffer);
 		} else {
+			if (batch->dir == USB_DIRECTION_IN)
+				batch_sg_copy_in(batch);
+
 			dma_buffer_release(&batch->dma_buffer);
 		}
 	}
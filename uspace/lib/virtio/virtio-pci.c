@@ -279,6 +279,40 @@ error:
 	return rc;
 }
 
+/** Switch the device to MSI-X interrupts.
+ *
+ * Virtqueue @c n is then signaled using vector <tt>n % msix_count</tt>,
+ * which is delivered as IRQ <tt>msix_irq + n % msix_count</tt>. The vectors
+ * are programmed by virtio_virtq_setup(), so this must be called before the
+ * virtqueues are set up. Configuration change interrupts are not used.
+ *
+ * @param dev    DDF device.
+ * @param vdev   VIRTIO device.
+ * @param count  Number of vectors the driver would like to use.
+ *
+ * @return EOK on success, an error code if the driver needs to keep using
+ *         the INT#x interrupt.
+ */
+errno_t virtio_pci_msix_enable(ddf_dev_t *dev, virtio_dev_t *vdev,
+    size_t count)
+{
+	int irq;
+	size_t rcount;
+
+	errno_t rc = hw_res_enable_msi(ddf_dev_parent_sess_get(dev), count,
+	    &irq, &rcount);
+	if (rc != EOK)
+		return rc;
+
+	vdev->msix_irq = irq;
+	vdev->msix_count = rcount;
+
+	pio_write_le16(&vdev->common_cfg->msix_config, VIRTIO_MSI_NO_VECTOR);
+
+	ddf_msg(LVL_NOTE, "Using %zu MSI-X vector(s) at IRQ %d", rcount, irq);
+	return EOK;
+}
+
 errno_t virtio_pci_dev_cleanup(virtio_dev_t *vdev)
 {
 	if (vdev->queues) {
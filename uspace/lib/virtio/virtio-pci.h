@@ -61,8 +61,16 @@
 #define VIRTIO_FEATURES_0_31	0
 #define VIRTIO_FEATURES_32_63	1
 
+/** Driver can use descriptors with VIRTQ_DESC_F_INDIRECT */
+#define VIRTIO_F_INDIRECT_DESC	(1U << 28)
+/** Used and available event index fields are in use */
+#define VIRTIO_F_EVENT_IDX	(1U << 29)
+
 #define VIRTIO_F_VERSION_1	1
 
+/** MSI-X vector value meaning that no interrupt is delivered */
+#define VIRTIO_MSI_NO_VECTOR	0xffff
+
 /** Common configuration structure layout according to VIRTIO version 1.0 */
 typedef struct virtio_pci_common_cfg {
 	ioport32_t device_feature_select;
@@ -150,6 +158,10 @@ typedef struct {
 	/** Virtual address of the used ring */
 	virtq_used_t *used;
 	uint16_t used_last_idx;
+	/** Available ring index at the last notification of the device */
+	uint16_t avail_notified_idx;
+	/** Event index interrupt and notification suppression is in use */
+	bool event_idx;
 
 	/** Address of the queue's notification register */
 	ioport16_t *notify;
@@ -176,9 +188,17 @@ typedef struct {
 	ioport8_t *isr;
 	uintptr_t isr_phys;
 
+	/** First IRQ of the MSI-X vectors, valid if msix_count is not zero */
+	int msix_irq;
+	/** Number of MSI-X vectors, zero if INT#x is used */
+	size_t msix_count;
+
 	/** Device-specific configuration */
 	void *device_cfg;
 
+	/** Accepted device feature bits 0 - 31 */
+	uint32_t features;
+
 	/** Virtqueues */
 	virtq_t *queues;
 } virtio_dev_t;
@@ -191,6 +211,8 @@ extern void virtio_virtq_desc_set(virtio_dev_t *vdev, uint16_t, uint16_t,
     uint64_t, uint32_t, uint16_t, uint16_t);
 extern uint16_t virtio_virtq_desc_get_next(virtio_dev_t *vdev, uint16_t,
     uint16_t);
+extern void virtio_indirect_desc_set(virtq_desc_t *, uint16_t, uint64_t,
+    uint32_t, uint16_t, uint16_t);
 
 extern void virtio_create_desc_free_list(virtio_dev_t *, uint16_t, uint16_t,
     uint16_t *);
@@ -201,15 +223,19 @@ extern void virtio_virtq_produce_available(virtio_dev_t *, uint16_t, uint16_t);
 extern bool virtio_virtq_consume_used(virtio_dev_t *, uint16_t, uint16_t *,
     uint32_t *);
 
+extern uint16_t virtio_virtq_max_size(virtio_dev_t *, uint16_t);
 extern errno_t virtio_virtq_setup(virtio_dev_t *, uint16_t, uint16_t);
 extern void virtio_virtq_teardown(virtio_dev_t *, uint16_t);
 
 extern errno_t virtio_device_setup_start(virtio_dev_t *, uint32_t);
+extern errno_t virtio_device_setup_negotiate(virtio_dev_t *, uint32_t,
+    uint32_t);
 extern void virtio_device_setup_fail(virtio_dev_t *);
 extern void virtio_device_setup_finalize(virtio_dev_t *);
 
 extern errno_t virtio_pci_dev_initialize(ddf_dev_t *, virtio_dev_t *);
 extern errno_t virtio_pci_dev_cleanup(virtio_dev_t *);
+extern errno_t virtio_pci_msix_enable(ddf_dev_t *, virtio_dev_t *, size_t);
 
 #endif
 
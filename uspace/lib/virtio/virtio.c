@@ -33,6 +33,7 @@
 
 #include <as.h>
 #include <align.h>
+#include <assert.h>
 #include <macros.h>
 #include <stdalign.h>
 
@@ -94,16 +95,38 @@ void virtio_teardown_dma_bufs(void *buf[])
 	}
 }
 
-void virtio_virtq_desc_set(virtio_dev_t *vdev, uint16_t num, uint16_t descno,
-    uint64_t addr, uint32_t len, uint16_t flags, uint16_t next)
+static void virtq_desc_write(virtq_desc_t *d, uint64_t addr, uint32_t len,
+    uint16_t flags, uint16_t next)
 {
-	virtq_desc_t *d = &vdev->queues[num].desc[descno];
 	pio_write_le64(&d->addr, addr);
 	pio_write_le32(&d->len, len);
 	pio_write_le16(&d->flags, flags);
 	pio_write_le16(&d->next, next);
 }
 
+void virtio_virtq_desc_set(virtio_dev_t *vdev, uint16_t num, uint16_t descno,
+    uint64_t addr, uint32_t len, uint16_t flags, uint16_t next)
+{
+	virtq_desc_write(&vdev->queues[num].desc[descno], addr, len, flags,
+	    next);
+}
+
+/** Set a descriptor in an indirect descriptor table
+ *
+ * @param table[in]   Indirect descriptor table in DMA memory.
+ * @param descno[in]  Index of the descriptor within the table.
+ * @param addr[in]    Buffer physical address.
+ * @param len[in]     Buffer length.
+ * @param flags[in]   Descriptor flags (VIRTQ_DESC_F_INDIRECT is not allowed).
+ * @param next[in]    Index of the next descriptor within the table.
+ */
+void virtio_indirect_desc_set(virtq_desc_t *table, uint16_t descno,
+    uint64_t addr, uint32_t len, uint16_t flags, uint16_t next)
+{
+	assert(!(flags & VIRTQ_DESC_F_INDIRECT));
+	virtq_desc_write(&table[descno], addr, len, flags, next);
+}
+
 uint16_t virtio_virtq_desc_get_next(virtio_dev_t *vdev, uint16_t num,
     uint16_t descno)
 {
@@ -170,6 +193,38 @@ void virtio_free_desc(virtio_dev_t *vdev, uint16_t num, uint16_t *head,
 	fibril_mutex_unlock(&q->lock);
 }
 
+/** Address of the used_event field which trails the available ring */
+static ioport16_t *virtq_used_event(virtq_t *q)
+{
+	return &q->avail->ring[q->queue_size];
+}
+
+/** Address of the avail_event field which trails the used ring */
+static ioport16_t *virtq_avail_event(virtq_t *q)
+{
+	return (ioport16_t *) &q->used->ring[q->queue_size];
+}
+
+/** Determine whether the device needs to be notified of a new buffer
+ *
+ * @param q[in]    Virtqueue (locked).
+ * @param idx[in]  Available ring index before the buffer was added.
+ *
+ * @return  True if the device should be notified.
+ */
+static bool virtq_need_notify(virtq_t *q, uint16_t idx)
+{
+	if (!q->event_idx)
+		return !(pio_read_le16(&q->used->flags) & VIRTQ_USED_F_NO_NOTIFY);
+
+	/*
+	 * The device asks to be notified once the available index moves past
+	 * avail_event. As we add one buffer at a time, this is the case
+	 * exactly when the buffer was put at avail_event.
+	 */
+	return pio_read_le16(virtq_avail_event(q)) == idx;
+}
+
 void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
     uint16_t descno)
 {
@@ -180,8 +235,10 @@ void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
 	pio_write_le16(&q->avail->ring[idx % q->queue_size], descno);
 	write_barrier();
 	pio_write_le16(&q->avail->idx, idx + 1);
-	write_barrier();
-	pio_write_le16(q->notify, num);
+	/* The index must be visible before we look at the suppression state */
+	memory_barrier();
+	if (virtq_need_notify(q, idx))
+		pio_write_le16(q->notify, num);
 	fibril_mutex_unlock(&q->lock);
 }
 
@@ -191,12 +248,31 @@ bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
 	virtq_t *q = &vdev->queues[num];
 
 	fibril_mutex_lock(&q->lock);
+	/*
+	 * Compare the free-running indices, the ring positions coincide also
+	 * when the device has used the whole ring.
+	 */
 	uint16_t last_idx = q->used_last_idx % q->queue_size;
-	if (last_idx == (pio_read_le16(&q->used->idx) % q->queue_size)) {
-		fibril_mutex_unlock(&q->lock);
-		return false;
+	if (q->used_last_idx == pio_read_le16(&q->used->idx)) {
+		if (!q->event_idx) {
+			fibril_mutex_unlock(&q->lock);
+			return false;
+		}
+
+		/*
+		 * Ask for an interrupt when the next buffer is used and check
+		 * again to catch a buffer used in the meantime.
+		 */
+		pio_write_le16(virtq_used_event(q), q->used_last_idx);
+		memory_barrier();
+		if (q->used_last_idx == pio_read_le16(&q->used->idx)) {
+			fibril_mutex_unlock(&q->lock);
+			return false;
+		}
 	}
 
+	read_barrier();
+
 	*descno = (uint16_t) pio_read_le32(&q->used->ring[last_idx].id);
 	*len = pio_read_le32(&q->used->ring[last_idx].len);
 
@@ -206,6 +282,22 @@ bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
 	return true;
 }
 
+/** Get the maximum size of a virtqueue supported by the device
+ *
+ * @param vdev[in]  VIRTIO device.
+ * @param num[in]   Index of the virtqueue.
+ *
+ * @return  Maximum number of descriptors of the virtqueue, zero if the
+ *          virtqueue is not available.
+ */
+uint16_t virtio_virtq_max_size(virtio_dev_t *vdev, uint16_t num)
+{
+	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
+
+	pio_write_le16(&cfg->queue_select, num);
+	return pio_read_le16(&cfg->queue_size);
+}
+
 errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 {
 	virtq_t *q = &vdev->queues[num];
@@ -258,6 +350,7 @@ errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 	q->avail = q->virt + avail_offset;
 	q->used = q->virt + used_offset;
 	q->used_last_idx = 0;
+	q->event_idx = (vdev->features & VIRTIO_F_EVENT_IDX) != 0;
 
 	memset(q->virt, 0, q->size);
 
@@ -277,6 +370,18 @@ errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 
 	ddf_msg(LVL_NOTE, "notification register: %p", q->notify);
 
+	/* Route the queue's interrupts to its MSI-X vector */
+	if (vdev->msix_count != 0) {
+		uint16_t vector = num % vdev->msix_count;
+
+		pio_write_le16(&cfg->queue_msix_vector, vector);
+		if (pio_read_le16(&cfg->queue_msix_vector) != vector) {
+			ddf_msg(LVL_ERROR, "Virtq %u: cannot set MSI-X vector",
+			    num);
+			return EIO;
+		}
+	}
+
 	/* Enable the queue */
 	pio_write_le16(&cfg->queue_enable, 1);
 	ddf_msg(LVL_NOTE, "virtq %d set", num);
@@ -302,6 +407,27 @@ void virtio_virtq_teardown(virtio_dev_t *vdev, uint16_t num)
  */
 errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 {
+	return virtio_device_setup_negotiate(vdev, features, 0);
+}
+
+/**
+ * Perform device initialization as described in section 3.1.1 of the
+ * specification, steps 1 - 6, accepting optional features if the device
+ * offers them.
+ *
+ * The accepted features are stored in vdev->features.
+ *
+ * @param vdev[in]      VIRTIO device.
+ * @param required[in]  Feature bits 0 - 31 which the device must offer.
+ * @param optional[in]  Feature bits 0 - 31 which are accepted if offered.
+ *
+ * @return  EOK on success, ENOTSUP if a required feature is not offered.
+ */
+errno_t virtio_device_setup_negotiate(virtio_dev_t *vdev, uint32_t required,
+    uint32_t optional)
+{
+	uint32_t features = required;
+
 	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
 
 	/* 1. Reset the device */
@@ -329,7 +455,8 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 
 	if (features != (features & device_features))
 		return ENOTSUP;
-	features &= device_features;
+	features = (features | optional) & device_features;
+	vdev->features = features;
 
 	if (reserved_features != (reserved_features & device_reserved_features))
 		return ENOTSUP;
@@ -36,12 +36,19 @@
  *
  * Allows accessing a file as a block device. Useful for, e.g., mounting
  * a disk image.
+ *
+ * Blocks are transferred with positioned reads and writes on the image
+ * file, so requests from different clients can be in flight concurrently.
+ * Queued requests are passed to VFS as asynchronous reads and writes
+ * directly from or to the buffer shared with the client, so that all of
+ * them are in flight at the same time.
  */
 
 #include <stdio.h>
 #include <async.h>
 #include <as.h>
 #include <bd_srv.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <loc.h>
 #include <stddef.h>
@@ -51,7 +58,10 @@
 #include <stdbool.h>
 #include <task.h>
 #include <macros.h>
+#include <stdlib.h>
 #include <str.h>
+#include <vfs/aio.h>
+#include <vfs/vfs.h>
 
 #define NAME "file_bd"
 
@@ -59,11 +69,32 @@
 
 static size_t block_size;
 static aoff64_t num_blocks;
-static FILE *img;
+static int img_fd;
+
+/** Number of write requests to perform before simulating a crash */
+static uint64_t crash_writes;
+static bool crash_armed;
 
 static service_id_t service_id;
 static bd_srvs_t bd_srvs;
-static fibril_mutex_t dev_lock;
+/** Protects the simulated crash state */
+static fibril_mutex_t crash_lock;
+
+/** Queued request passed to VFS */
+typedef struct {
+	bd_req_t *req;
+	/** Number of bytes transferred so far */
+	size_t done;
+} file_bd_req_t;
+
+/** Completions of the asynchronous reads and writes of queued requests */
+static vfs_aio_queue_t *aio_queue;
+/** Protects aio_pending */
+static FIBRIL_MUTEX_INITIALIZE(aio_lock);
+/** Signalled when a read or write is submitted to VFS */
+static FIBRIL_CONDVAR_INITIALIZE(aio_cv);
+/** Number of reads and writes submitted to VFS and not collected yet */
+static size_t aio_pending;
 
 static void print_usage(void);
 static errno_t file_bd_init(const char *fname);
@@ -73,16 +104,21 @@ static errno_t file_bd_open(bd_srvs_t *, bd_srv_t *);
 static errno_t file_bd_close(bd_srv_t *);
 static errno_t file_bd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
 static errno_t file_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
+static errno_t file_bd_sync_cache(bd_srv_t *, aoff64_t, size_t);
 static errno_t file_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t file_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t file_bd_submit(bd_srv_t *, bd_req_t *);
+static errno_t file_bd_aio_fibril(void *);
 
 static bd_ops_t file_bd_ops = {
 	.open = file_bd_open,
 	.close = file_bd_close,
 	.read_blocks = file_bd_read_blocks,
 	.write_blocks = file_bd_write_blocks,
+	.sync_cache = file_bd_sync_cache,
 	.get_block_size = file_bd_get_block_size,
-	.get_num_blocks = file_bd_get_num_blocks
+	.get_num_blocks = file_bd_get_num_blocks,
+	.submit = file_bd_submit
 };
 
 int main(int argc, char **argv)
@@ -115,6 +151,23 @@ int main(int argc, char **argv)
 			}
 			++argv;
 			--argc;
+		} else if (str_cmp(*argv, "-c") == 0) {
+			if (argc < 2) {
+				printf("Argument missing.\n");
+				print_usage();
+				return -1;
+			}
+
+			rc = str_uint64_t(argv[1], NULL, 10, true, &crash_writes);
+			if (rc != EOK) {
+				printf("Invalid number of writes '%s'.\n", argv[1]);
+				print_usage();
+				return -1;
+			}
+
+			crash_armed = true;
+			++argv;
+			--argc;
 		} else {
 			printf("Invalid option '%s'.\n", *argv);
 			print_usage();
@@ -166,7 +219,10 @@ int main(int argc, char **argv)
 
 static void print_usage(void)
 {
-	printf("Usage: " NAME " [-b <block_size>] <image_file> <device_name>\n");
+	printf("Usage: " NAME " [-b <block_size>] [-c <writes>] <image_file> "
+	    "<device_name>\n");
+	printf("\t-c <writes> Simulate a crash by silently dropping all "
+	    "writes\n\t            after the given number of write requests\n");
 }
 
 static errno_t file_bd_init(const char *fname)
@@ -181,24 +237,32 @@ static errno_t file_bd_init(const char *fname)
 		return rc;
 	}
 
-	img = fopen(fname, "rb+");
-	if (img == NULL)
+	rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ | MODE_WRITE,
+	    &img_fd);
+	if (rc != EOK)
 		return EINVAL;
 
-	if (fseek(img, 0, SEEK_END) != 0) {
-		fclose(img);
+	vfs_stat_t st;
+	rc = vfs_stat(img_fd, &st);
+	if (rc != EOK) {
+		vfs_put(img_fd);
 		return EIO;
 	}
 
-	off64_t img_size = ftell(img);
-	if (img_size < 0) {
-		fclose(img);
-		return EIO;
-	}
+	num_blocks = st.size / block_size;
 
-	num_blocks = img_size / block_size;
+	fibril_mutex_initialize(&crash_lock);
 
-	fibril_mutex_initialize(&dev_lock);
+	/* Without asynchronous I/O, queued requests are served one by one */
+	if (vfs_aio_queue_create(&aio_queue) == EOK) {
+		fid_t fid = fibril_create(file_bd_aio_fibril, NULL);
+		if (fid != 0) {
+			fibril_add_ready(fid);
+		} else {
+			vfs_aio_queue_destroy(aio_queue);
+			aio_queue = NULL;
+		}
+	}
 
 	return EOK;
 }
@@ -220,16 +284,9 @@ static errno_t file_bd_close(bd_srv_t *bd)
 	return EOK;
 }
 
-/** Read blocks from the device. */
-static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *buf,
-    size_t size)
+/** Check whether access is within device address bounds. */
+static errno_t file_bd_check_range(uint64_t ba, size_t cnt)
 {
-	size_t n_rd;
-
-	if (size < cnt * block_size)
-		return EINVAL;
-
-	/* Check whether access is within device address bounds. */
 	if (ba + cnt > num_blocks) {
 		printf(NAME ": Accessed blocks %" PRIuOFF64 "-%" PRIuOFF64 ", while "
 		    "max block number is %" PRIuOFF64 ".\n", ba, ba + cnt - 1,
@@ -237,24 +294,54 @@ static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *
 		return ELIMIT;
 	}
 
-	fibril_mutex_lock(&dev_lock);
+	return EOK;
+}
 
-	clearerr(img);
-	if (fseek(img, ba * block_size, SEEK_SET) < 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
-	}
+/** Determine whether a write should be dropped to simulate a crash.
+ *
+ * Once the crash point is reached, pretend that the writes succeed
+ * so that the client is not aware of losing them.
+ */
+static bool file_bd_crashed(void)
+{
+	bool crashed = false;
 
-	n_rd = fread(buf, block_size, cnt, img);
+	if (!crash_armed)
+		return false;
 
-	if (ferror(img)) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;	/* Read error */
+	fibril_mutex_lock(&crash_lock);
+
+	if (crash_writes == 0) {
+		crashed = true;
+	} else if (--crash_writes == 0) {
+		printf(NAME ": Simulating crash, dropping further writes\n");
 	}
 
-	fibril_mutex_unlock(&dev_lock);
+	fibril_mutex_unlock(&crash_lock);
+	return crashed;
+}
+
+/** Read blocks from the device. */
+static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *buf,
+    size_t size)
+{
+	aoff64_t pos;
+	size_t n_rd;
+	errno_t rc;
+
+	if (size < cnt * block_size)
+		return EINVAL;
+
+	rc = file_bd_check_range(ba, cnt);
+	if (rc != EOK)
+		return rc;
 
-	if (n_rd < cnt)
+	pos = ba * block_size;
+	rc = vfs_read(img_fd, &pos, buf, cnt * block_size, &n_rd);
+	if (rc != EOK)
+		return EIO;	/* Read error */
+
+	if (n_rd < cnt * block_size)
 		return EINVAL;	/* Read beyond end of device */
 
 	return EOK;
@@ -264,40 +351,146 @@ static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *
 static errno_t file_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
     const void *buf, size_t size)
 {
+	aoff64_t pos;
 	size_t n_wr;
+	errno_t rc;
 
 	if (size < cnt * block_size)
 		return EINVAL;
 
-	/* Check whether access is within device address bounds. */
-	if (ba + cnt > num_blocks) {
-		printf(NAME ": Accessed blocks %" PRIuOFF64 "-%" PRIuOFF64 ", while "
-		    "max block number is %" PRIuOFF64 ".\n", ba, ba + cnt - 1,
-		    num_blocks - 1);
-		return ELIMIT;
-	}
+	rc = file_bd_check_range(ba, cnt);
+	if (rc != EOK)
+		return rc;
 
-	fibril_mutex_lock(&dev_lock);
+	if (file_bd_crashed())
+		return EOK;
 
-	clearerr(img);
-	if (fseek(img, ba * block_size, SEEK_SET) < 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
+	pos = ba * block_size;
+	rc = vfs_write(img_fd, &pos, buf, cnt * block_size, &n_wr);
+	if (rc != EOK || n_wr < cnt * block_size)
+		return EIO;	/* Write error */
+
+	return EOK;
+}
+
+/** Pass the rest of a queued request to VFS. */
+static errno_t file_bd_aio_submit(file_bd_req_t *freq)
+{
+	bd_req_t *req = freq->req;
+	aoff64_t pos = req->ba * block_size + freq->done;
+	size_t nbyte = req->cnt * block_size - freq->done;
+	uint8_t *buf = (uint8_t *) req->buf + freq->done;
+	errno_t rc;
+
+	if (req->type == BD_REQ_READ)
+		rc = vfs_read_async(aio_queue, img_fd, pos, buf, nbyte, freq);
+	else
+		rc = vfs_write_async(aio_queue, img_fd, pos, buf, nbyte, freq);
+
+	if (rc != EOK)
+		return rc;
+
+	fibril_mutex_lock(&aio_lock);
+	aio_pending++;
+	fibril_condvar_signal(&aio_cv);
+	fibril_mutex_unlock(&aio_lock);
+	return EOK;
+}
+
+/** Fibril completing queued requests as VFS finishes them.
+ *
+ * VFS may transfer less than requested at a time, in which case the rest
+ * of the request is submitted again.
+ */
+static errno_t file_bd_aio_fibril(void *arg)
+{
+	vfs_aio_completion_t comp;
+	errno_t rc;
+
+	while (true) {
+		fibril_mutex_lock(&aio_lock);
+		while (aio_pending == 0)
+			fibril_condvar_wait(&aio_cv, &aio_lock);
+		fibril_mutex_unlock(&aio_lock);
+
+		if (vfs_aio_wait(aio_queue, 0, &comp) != EOK)
+			continue;
+
+		fibril_mutex_lock(&aio_lock);
+		aio_pending--;
+		fibril_mutex_unlock(&aio_lock);
+
+		file_bd_req_t *freq = (file_bd_req_t *) comp.arg;
+		bd_req_t *req = freq->req;
+
+		freq->done += comp.nbytes;
+		if (comp.rc != EOK) {
+			rc = EIO;	/* Read or write error */
+		} else if (freq->done >= req->cnt * block_size) {
+			rc = EOK;
+		} else if (comp.nbytes == 0) {
+			/* Read beyond end of device or write error */
+			rc = req->type == BD_REQ_READ ? EINVAL : EIO;
+		} else {
+			rc = file_bd_aio_submit(freq);
+			if (rc == EOK)
+				continue;
+		}
+
+		free(freq);
+		bd_req_complete(req, rc);
 	}
 
-	n_wr = fwrite(buf, block_size, cnt, img);
+	return EOK;
+}
 
-	if (ferror(img) || n_wr < cnt) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;	/* Write error */
+/** Start a queued request. */
+static errno_t file_bd_submit(bd_srv_t *bd, bd_req_t *req)
+{
+	file_bd_req_t *freq;
+	errno_t rc;
+
+	if (aio_queue == NULL)
+		return ENOTSUP;
+
+	if (req->size < req->cnt * block_size)
+		return EINVAL;
+
+	rc = file_bd_check_range(req->ba, req->cnt);
+	if (rc != EOK)
+		return rc;
+
+	if (req->type == BD_REQ_WRITE && file_bd_crashed()) {
+		bd_req_complete(req, EOK);
+		return EOK;
 	}
 
-	if (fflush(img) != 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
+	freq = calloc(1, sizeof(file_bd_req_t));
+	if (freq == NULL)
+		return ENOMEM;
+
+	freq->req = req;
+	rc = file_bd_aio_submit(freq);
+	if (rc != EOK) {
+		free(freq);
+		return rc;
 	}
 
-	fibril_mutex_unlock(&dev_lock);
+	return EOK;
+}
+
+/** Flush the image file to its storage.
+ *
+ * The file system can only synchronize the whole file, so the range is
+ * ignored.
+ */
+static errno_t file_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
+{
+	(void) ba;
+	(void) cnt;
+
+	if (vfs_sync(img_fd) != EOK)
+		return EIO;
 
 	return EOK;
 }
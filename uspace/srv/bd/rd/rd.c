@@ -36,6 +36,16 @@
 /**
  * @file rd.c
  * @brief Initial RAM disk for HelenOS.
+ *
+ * Besides serving the initial RAM disk image, the server can provide
+ * a scratch RAM disk of a given size. The scratch disk is backed by
+ * anonymous memory whose pages are only allocated once they are written
+ * to, and it can be resized while no client has it mapped.
+ *
+ * Clients can map the whole disk into their address space with
+ * bd_share_in() and access blocks without any copying. A client that
+ * does so is responsible for synchronizing its accesses with any block
+ * requests from other clients.
  */
 
 #include <ipc/services.h>
@@ -45,6 +55,9 @@
 #include <bd_srv.h>
 #include <ddi.h>
 #include <align.h>
+#include <stdlib.h>
+#include <str.h>
+#include <task.h>
 #include <stdbool.h>
 #include <errno.h>
 #include <str_error.h>
@@ -66,12 +79,23 @@ static size_t rd_size;
 /** Block size */
 static const size_t block_size = 512;
 
+/** The disk is a scratch disk backed by anonymous memory */
+static bool rd_scratch;
+
+/** Pages of the scratch disk written to so far, one bit per page */
+static uint8_t *rd_pages;
+
+/** The disk is mapped by a client, which may write to any page */
+static bool rd_shared;
+
 static errno_t rd_open(bd_srvs_t *, bd_srv_t *);
 static errno_t rd_close(bd_srv_t *);
 static errno_t rd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
 static errno_t rd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 static errno_t rd_get_block_size(bd_srv_t *, size_t *);
 static errno_t rd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t rd_share_in(bd_srv_t *, size_t, void **);
+static errno_t rd_resize(bd_srv_t *, aoff64_t);
 
 /** This rwlock protects the ramdisk's data.
  *
@@ -88,7 +112,9 @@ static bd_ops_t rd_bd_ops = {
 	.read_blocks = rd_read_blocks,
 	.write_blocks = rd_write_blocks,
 	.get_block_size = rd_get_block_size,
-	.get_num_blocks = rd_get_num_blocks
+	.get_num_blocks = rd_get_num_blocks,
+	.share_in = rd_share_in,
+	.resize = rd_resize
 };
 
 static bd_srvs_t bd_srvs;
@@ -110,17 +136,64 @@ static errno_t rd_close(bd_srv_t *bd)
 	return EOK;
 }
 
+/** Check whether a page of the disk has any backing memory.
+ *
+ * Pages of a scratch disk which have never been written to are not touched,
+ * as doing so would allocate them.
+ */
+static bool rd_page_present(size_t page)
+{
+	if (!rd_scratch || rd_shared)
+		return true;
+
+	return (rd_pages[page / 8] & (1 << (page % 8))) != 0;
+}
+
+/** Read data from the disk image, zero-filling unallocated pages. */
+static void rd_copy_out(void *buf, size_t offs, size_t size)
+{
+	uint8_t *dp = buf;
+
+	while (size > 0) {
+		size_t len = min(size, PAGE_SIZE - offs % PAGE_SIZE);
+
+		if (rd_page_present(offs / PAGE_SIZE))
+			memcpy(dp, rd_addr + offs, len);
+		else
+			memset(dp, 0, len);
+
+		dp += len;
+		offs += len;
+		size -= len;
+	}
+}
+
+/** Write data to the disk image, recording the pages it allocates. */
+static void rd_copy_in(size_t offs, const void *buf, size_t size)
+{
+	memcpy(rd_addr + offs, buf, size);
+
+	if (!rd_scratch || size == 0)
+		return;
+
+	for (size_t page = offs / PAGE_SIZE;
+	    page <= (offs + size - 1) / PAGE_SIZE; page++)
+		rd_pages[page / 8] |= 1 << (page % 8);
+}
+
 /** Read blocks from the device. */
 static errno_t rd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt, void *buf,
     size_t size)
 {
+	fibril_rwlock_read_lock(&rd_lock);
+
 	if ((ba + cnt) * block_size > rd_size) {
 		/* Reading past the end of the device. */
+		fibril_rwlock_read_unlock(&rd_lock);
 		return ELIMIT;
 	}
 
-	fibril_rwlock_read_lock(&rd_lock);
-	memcpy(buf, rd_addr + ba * block_size, min(block_size * cnt, size));
+	rd_copy_out(buf, ba * block_size, min(block_size * cnt, size));
 	fibril_rwlock_read_unlock(&rd_lock);
 
 	return EOK;
@@ -130,18 +203,45 @@ static errno_t rd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt, void *buf,
 static errno_t rd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
     const void *buf, size_t size)
 {
+	fibril_rwlock_write_lock(&rd_lock);
+
 	if ((ba + cnt) * block_size > rd_size) {
 		/* Writing past the end of the device. */
+		fibril_rwlock_write_unlock(&rd_lock);
 		return ELIMIT;
 	}
 
-	fibril_rwlock_write_lock(&rd_lock);
-	memcpy(rd_addr + ba * block_size, buf, min(block_size * cnt, size));
+	rd_copy_in(ba * block_size, buf, min(block_size * cnt, size));
 	fibril_rwlock_write_unlock(&rd_lock);
 
 	return EOK;
 }
 
+/** Register the disk service. */
+static bool rd_register(const char *name)
+{
+	bd_srvs_init(&bd_srvs);
+	bd_srvs.ops = &rd_bd_ops;
+
+	async_set_fallback_port_handler(rd_client_conn, NULL);
+	errno_t ret = loc_server_register(NAME);
+	if (ret != EOK) {
+		printf("%s: Unable to register driver: %s\n", NAME, str_error(ret));
+		return false;
+	}
+
+	service_id_t service_id;
+	ret = loc_service_register(name, &service_id);
+	if (ret != EOK) {
+		printf("%s: Unable to register device service\n", NAME);
+		return false;
+	}
+
+	fibril_rwlock_initialize(&rd_lock);
+
+	return true;
+}
+
 /** Prepare the ramdisk image for operation. */
 static bool rd_init(void)
 {
@@ -173,26 +273,37 @@ static bool rd_init(void)
 	printf("%s: Found RAM disk at %p, %" PRIun " bytes\n", NAME,
 	    (void *) addr_phys, size);
 
-	bd_srvs_init(&bd_srvs);
-	bd_srvs.ops = &rd_bd_ops;
+	return rd_register("bd/initrd");
+}
 
-	async_set_fallback_port_handler(rd_client_conn, NULL);
-	ret = loc_server_register(NAME);
-	if (ret != EOK) {
-		printf("%s: Unable to register driver: %s\n", NAME, str_error(ret));
+/** Prepare a scratch disk of the given size for operation.
+ *
+ * The memory is reserved and allocated only as the disk is written to.
+ */
+static bool rd_init_scratch(size_t size, const char *name)
+{
+	rd_size = ALIGN_UP(size, block_size);
+	rd_scratch = true;
+
+	rd_pages = calloc(ALIGN_UP(rd_size, PAGE_SIZE) / PAGE_SIZE / 8 + 1, 1);
+	if (rd_pages == NULL) {
+		printf("%s: Out of memory\n", NAME);
 		return false;
 	}
 
-	service_id_t service_id;
-	ret = loc_service_register("bd/initrd", &service_id);
-	if (ret != EOK) {
-		printf("%s: Unable to register device service\n", NAME);
+	rd_addr = as_area_create(AS_AREA_ANY, ALIGN_UP(rd_size, PAGE_SIZE),
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE |
+	    AS_AREA_LATE_RESERVE, AS_AREA_UNPAGED);
+	if (rd_addr == AS_MAP_FAILED) {
+		printf("%s: Error allocating RAM disk\n", NAME);
+		free(rd_pages);
 		return false;
 	}
 
-	fibril_rwlock_initialize(&rd_lock);
+	printf("%s: Created scratch RAM disk %s, %zu bytes\n", NAME, name,
+	    rd_size);
 
-	return true;
+	return rd_register(name);
 }
 
 /** Get device block size. */
@@ -205,18 +316,136 @@ static errno_t rd_get_block_size(bd_srv_t *bd, size_t *rsize)
 /** Get number of blocks on device. */
 static errno_t rd_get_num_blocks(bd_srv_t *bd, aoff64_t *rnb)
 {
+	fibril_rwlock_read_lock(&rd_lock);
 	*rnb = rd_size / block_size;
+	fibril_rwlock_read_unlock(&rd_lock);
+
+	return EOK;
+}
+
+/** Map the disk image into the address space of the client. */
+static errno_t rd_share_in(bd_srv_t *bd, size_t size, void **rdata)
+{
+	size_t area_size;
+
+	fibril_rwlock_write_lock(&rd_lock);
+
+	area_size = ALIGN_UP(rd_size, PAGE_SIZE);
+	if (size != area_size) {
+		fibril_rwlock_write_unlock(&rd_lock);
+		return EINVAL;
+	}
+
+	/*
+	 * From now on the client may write to any page without us knowing,
+	 * so pages cannot be assumed to be unallocated anymore.
+	 */
+	rd_shared = true;
+	*rdata = rd_addr;
+
+	fibril_rwlock_write_unlock(&rd_lock);
+	return EOK;
+}
+
+/** Change the size of a scratch disk.
+ *
+ * Pages beyond the new end of the disk are released. When the disk grows,
+ * the new blocks read as zeroes.
+ */
+static errno_t rd_resize(bd_srv_t *bd, aoff64_t nblocks)
+{
+	size_t old_pages;
+	size_t new_pages;
+	size_t size;
+	uint8_t *pages;
+	errno_t rc;
+
+	if (!rd_scratch)
+		return ENOTSUP;
+
+	if (nblocks == 0 || nblocks > (SIZE_MAX - PAGE_SIZE) / block_size)
+		return EINVAL;
+
+	size = nblocks * block_size;
+
+	fibril_rwlock_write_lock(&rd_lock);
+
+	/* A shared area cannot be resized. */
+	if (rd_shared) {
+		fibril_rwlock_write_unlock(&rd_lock);
+		return EBUSY;
+	}
+
+	old_pages = ALIGN_UP(rd_size, PAGE_SIZE) / PAGE_SIZE;
+	new_pages = ALIGN_UP(size, PAGE_SIZE) / PAGE_SIZE;
+
+	pages = calloc(new_pages / 8 + 1, 1);
+	if (pages == NULL) {
+		fibril_rwlock_write_unlock(&rd_lock);
+		return ENOMEM;
+	}
+
+	/* Zero the tail of the last page so that it reads as zeroes later. */
+	if (size < rd_size && rd_page_present(size / PAGE_SIZE)) {
+		memset(rd_addr + size, 0, min(rd_size,
+		    new_pages * PAGE_SIZE) - size);
+	}
+
+	rc = as_area_resize(rd_addr, new_pages * PAGE_SIZE, 0);
+	if (rc != EOK) {
+		fibril_rwlock_write_unlock(&rd_lock);
+		free(pages);
+		return rc;
+	}
+
+	memcpy(pages, rd_pages, min(old_pages, new_pages) / 8 + 1);
+	if (new_pages < old_pages) {
+		/* Drop bits of released pages in the last byte. */
+		pages[new_pages / 8] &= (1 << (new_pages % 8)) - 1;
+	}
+
+	free(rd_pages);
+	rd_pages = pages;
+	rd_size = size;
+
+	fibril_rwlock_write_unlock(&rd_lock);
 	return EOK;
 }
 
+static void print_usage(void)
+{
+	printf("Usage: %s [-s <size> <device_name>]\n", NAME);
+	printf("\tWithout arguments, serve the initial RAM disk.\n");
+	printf("\t-s <size> Create a scratch RAM disk of the given size in "
+	    "bytes\n");
+}
+
 int main(int argc, char **argv)
 {
 	printf("%s: HelenOS RAM disk server\n", NAME);
 
-	if (!rd_init())
+	if (argc == 1) {
+		if (!rd_init())
+			return -1;
+	} else if (argc == 4 && str_cmp(argv[1], "-s") == 0) {
+		size_t size;
+
+		errno_t rc = str_size_t(argv[2], NULL, 10, true, &size);
+		if (rc != EOK || size == 0) {
+			printf("%s: Invalid size '%s'.\n", NAME, argv[2]);
+			print_usage();
+			return -1;
+		}
+
+		if (!rd_init_scratch(size, argv[3]))
+			return -1;
+	} else {
+		print_usage();
 		return -1;
+	}
 
 	printf("%s: Accepting connections\n", NAME);
+	task_retval(0);
 	async_manager();
 
 	/* Never reached */
@@ -209,7 +209,7 @@ static errno_t sata_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt, void *
 	if (size < cnt * sbd->block_size)
 		return EINVAL;
 
-	return ahci_read_blocks(sbd->sess, ba, cnt, buf);
+	return ahci_read_blocks(sbd->sess, ba, cnt, buf, size);
 }
 
 /** Write blocks to partition. */
@@ -221,7 +221,7 @@ static errno_t sata_bd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 	if (size < cnt * sbd->block_size)
 		return EINVAL;
 
-	return ahci_write_blocks(sbd->sess, ba, cnt, (void *)buf);
+	return ahci_write_blocks(sbd->sess, ba, cnt, buf, size);
 }
 
 /** Get device block size. */
@@ -34,6 +34,7 @@
  */
 
 #include <adt/list.h>
+#include <bd.h>
 #include <bd_srv.h>
 #include <block.h>
 #include <errno.h>
@@ -62,10 +63,10 @@ static errno_t vbds_disk_parts_remove(vbds_disk_t *, vbds_rem_flag_t);
 
 static errno_t vbds_bd_open(bd_srvs_t *, bd_srv_t *);
 static errno_t vbds_bd_close(bd_srv_t *);
-static errno_t vbds_bd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
 static errno_t vbds_bd_sync_cache(bd_srv_t *, aoff64_t, size_t);
-static errno_t vbds_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *,
-    size_t);
+static errno_t vbds_bd_fwd_begin(bd_srv_t *, aoff64_t, size_t, size_t,
+    bd_t **, aoff64_t *);
+static void vbds_bd_fwd_end(bd_srv_t *);
 static errno_t vbds_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t vbds_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
 
@@ -86,11 +87,11 @@ static errno_t vbds_label_write(void *, aoff64_t, size_t, const void *);
 static bd_ops_t vbds_bd_ops = {
 	.open = vbds_bd_open,
 	.close = vbds_bd_close,
-	.read_blocks = vbds_bd_read_blocks,
 	.sync_cache = vbds_bd_sync_cache,
-	.write_blocks = vbds_bd_write_blocks,
 	.get_block_size = vbds_bd_get_block_size,
-	.get_num_blocks = vbds_bd_get_num_blocks
+	.get_num_blocks = vbds_bd_get_num_blocks,
+	.fwd_begin = vbds_bd_fwd_begin,
+	.fwd_end = vbds_bd_fwd_end
 };
 
 /** Provide disk access to liblabel */
@@ -522,6 +523,23 @@ errno_t vbds_disk_add(service_id_t sid)
 
 	block_inited = true;
 
+	disk->sess = loc_service_connect(sid, INTERFACE_BLOCK,
+	    IPC_FLAG_BLOCKING);
+	if (disk->sess == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed connecting to %s.",
+		    disk->svc_name);
+		rc = EIO;
+		goto error;
+	}
+
+	rc = bd_open(disk->sess, &disk->bd);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed opening block device %s.",
+		    disk->svc_name);
+		rc = EIO;
+		goto error;
+	}
+
 	lbd.ops = &vbds_label_bd_ops;
 	lbd.arg = (void *) disk;
 
@@ -547,6 +565,10 @@ errno_t vbds_disk_add(service_id_t sid)
 	return EOK;
 error:
 	label_close(label);
+	if (disk != NULL && disk->bd != NULL)
+		bd_close(disk->bd);
+	if (disk != NULL && disk->sess != NULL)
+		async_hangup(disk->sess);
 	if (block_inited) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "block_fini(%zu)", sid);
 		block_fini(sid);
@@ -576,6 +598,8 @@ errno_t vbds_disk_remove(service_id_t sid)
 
 	list_remove(&disk->ldisks);
 	label_close(disk->label);
+	bd_close(disk->bd);
+	async_hangup(disk->sess);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "block_fini(%zu)", sid);
 	block_fini(sid);
 	free(disk);
@@ -942,11 +966,51 @@ error:
 	return rc;
 }
 
+/** Open a connection to the disk for a partition client.
+ *
+ * A forwarded request holds the exchange of its session until the disk
+ * driver finishes it, so each client gets a connection of its own. The
+ * driver can then serve requests of different clients (e.g. of the workers
+ * of a libblock I/O scheduler) in parallel.
+ *
+ * @return Connection or @c NULL if it cannot be opened
+ */
+static vbds_bd_conn_t *vbds_bd_conn_open(vbds_disk_t *disk)
+{
+	vbds_bd_conn_t *conn;
+
+	conn = calloc(1, sizeof(vbds_bd_conn_t));
+	if (conn == NULL)
+		return NULL;
+
+	conn->sess = loc_service_connect(disk->svc_id, INTERFACE_BLOCK, 0);
+	if (conn->sess == NULL) {
+		free(conn);
+		return NULL;
+	}
+
+	if (bd_open(conn->sess, &conn->bd) != EOK) {
+		async_hangup(conn->sess);
+		free(conn);
+		return NULL;
+	}
+
+	return conn;
+}
+
 static errno_t vbds_bd_open(bd_srvs_t *bds, bd_srv_t *bd)
 {
 	vbds_part_t *part = bd_srv_part(bd);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "vbds_bd_open()");
+
+	/* Without a connection of its own, the client uses the shared one */
+	bd->carg = vbds_bd_conn_open(part->disk);
+	if (bd->carg == NULL) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed connecting to %s, "
+		    "sharing the disk connection.", part->disk->svc_name);
+	}
+
 	fibril_rwlock_write_lock(&part->lock);
 	part->open_cnt++;
 	fibril_rwlock_write_unlock(&part->lock);
@@ -956,6 +1020,7 @@ static errno_t vbds_bd_open(bd_srvs_t *bds, bd_srv_t *bd)
 static errno_t vbds_bd_close(bd_srv_t *bd)
 {
 	vbds_part_t *part = bd_srv_part(bd);
+	vbds_bd_conn_t *conn = (vbds_bd_conn_t *) bd->carg;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "vbds_bd_close()");
 
@@ -964,33 +1029,56 @@ static errno_t vbds_bd_close(bd_srv_t *bd)
 	fibril_rwlock_write_lock(&part->lock);
 	part->open_cnt--;
 	fibril_rwlock_write_unlock(&part->lock);
+
+	if (conn != NULL) {
+		bd_close(conn->bd);
+		async_hangup(conn->sess);
+		free(conn);
+		bd->carg = NULL;
+	}
+
 	return EOK;
 }
 
-static errno_t vbds_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
-    void *buf, size_t size)
+/** Start forwarding partition I/O to the disk.
+ *
+ * Block reads and writes are passed to the disk driver with the data
+ * transfer, so that the data is never copied through VBD. The partition
+ * stays read-locked until vbds_bd_fwd_end() is called, which keeps it from
+ * being closed or removed while the request is in progress.
+ */
+static errno_t vbds_bd_fwd_begin(bd_srv_t *bd, aoff64_t ba, size_t cnt,
+    size_t size, bd_t **rbd, aoff64_t *rba)
 {
 	vbds_part_t *part = bd_srv_part(bd);
-	aoff64_t gba;
-	errno_t rc;
+	size_t bsize;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_read_blocks()");
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_fwd_begin()");
 	fibril_rwlock_read_lock(&part->lock);
 
-	if (cnt * part->disk->block_size < size) {
+	/* Do not rely on the disk driver to check the client buffer. */
+	bsize = part->disk->block_size;
+	if (bsize == 0 || size % bsize != 0 || size / bsize != cnt) {
 		fibril_rwlock_read_unlock(&part->lock);
 		return EINVAL;
 	}
 
-	if (vbds_bsa_translate(part, ba, cnt, &gba) != EOK) {
+	if (vbds_bsa_translate(part, ba, cnt, rba) != EOK) {
 		fibril_rwlock_read_unlock(&part->lock);
 		return ELIMIT;
 	}
 
-	rc = block_read_direct(part->disk->svc_id, gba, cnt, buf);
-	fibril_rwlock_read_unlock(&part->lock);
+	vbds_bd_conn_t *conn = (vbds_bd_conn_t *) bd->carg;
+	*rbd = conn != NULL ? conn->bd : part->disk->bd;
+	return EOK;
+}
 
-	return rc;
+/** Finish forwarding partition I/O to the disk. */
+static void vbds_bd_fwd_end(bd_srv_t *bd)
+{
+	vbds_part_t *part = bd_srv_part(bd);
+
+	fibril_rwlock_read_unlock(&part->lock);
 }
 
 static errno_t vbds_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
@@ -1017,31 +1105,6 @@ static errno_t vbds_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
 	return rc;
 }
 
-static errno_t vbds_bd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
-    const void *buf, size_t size)
-{
-	vbds_part_t *part = bd_srv_part(bd);
-	aoff64_t gba;
-	errno_t rc;
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_write_blocks()");
-	fibril_rwlock_read_lock(&part->lock);
-
-	if (cnt * part->disk->block_size < size) {
-		fibril_rwlock_read_unlock(&part->lock);
-		return EINVAL;
-	}
-
-	if (vbds_bsa_translate(part, ba, cnt, &gba) != EOK) {
-		fibril_rwlock_read_unlock(&part->lock);
-		return ELIMIT;
-	}
-
-	rc = block_write_direct(part->disk->svc_id, gba, cnt, buf);
-	fibril_rwlock_read_unlock(&part->lock);
-	return rc;
-}
-
 static errno_t vbds_bd_get_block_size(bd_srv_t *bd, size_t *rsize)
 {
 	vbds_part_t *part = bd_srv_part(bd);
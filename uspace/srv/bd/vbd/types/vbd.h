@@ -38,6 +38,8 @@
 #define TYPES_VBDS_H_
 
 #include <adt/list.h>
+#include <async.h>
+#include <bd.h>
 #include <bd_srv.h>
 #include <label/label.h>
 #include <loc.h>
@@ -85,6 +87,14 @@ typedef struct {
 	atomic_refcount_t refcnt;
 } vbds_part_t;
 
+/** Connection of a partition client to the disk */
+typedef struct {
+	/** Session to the disk */
+	async_sess_t *sess;
+	/** Block device used to forward the client's I/O to the disk */
+	bd_t *bd;
+} vbds_bd_conn_t;
+
 /** Disk */
 typedef struct vbds_disk {
 	/** Link to vbds_disks */
@@ -93,6 +103,13 @@ typedef struct vbds_disk {
 	service_id_t svc_id;
 	/** Disk service name */
 	char *svc_name;
+	/**
+	 * Session used to forward partition I/O to the disk for clients
+	 * which do not have a connection of their own
+	 */
+	async_sess_t *sess;
+	/** Block device used with @c sess */
+	bd_t *bd;
 	/** Label */
 	label_t *label;
 	/** Partitions */
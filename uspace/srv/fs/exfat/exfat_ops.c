@@ -1459,6 +1459,73 @@ static errno_t exfat_sync(service_id_t service_id, fs_index_t index)
 	return rc;
 }
 
+static errno_t
+exfat_readdir(service_id_t service_id, fs_index_t index, aoff64_t pos,
+    libfs_readdir_t *rd)
+{
+	fs_node_t *fn;
+	exfat_node_t *nodep;
+	char name[EXFAT_FILENAME_LEN + 1];
+	exfat_file_dentry_t df;
+	exfat_stream_dentry_t ds;
+	errno_t rc;
+
+	rc = exfat_node_get(&fn, service_id, index);
+	if (rc != EOK)
+		return rc;
+	if (!fn)
+		return ENOENT;
+	nodep = EXFAT_NODE(fn);
+
+	if (nodep->type != EXFAT_DIRECTORY) {
+		(void) exfat_node_put(fn);
+		return ENOTDIR;
+	}
+
+	exfat_directory_t di;
+	rc = exfat_directory_open(nodep, &di);
+	if (rc != EOK) {
+		(void) exfat_node_put(fn);
+		return rc;
+	}
+
+	rc = exfat_directory_seek(&di, pos);
+	if (rc == EOK) {
+		while ((rc = exfat_directory_read_file(&di, name,
+		    EXFAT_FILENAME_LEN, &df, &ds)) == EOK) {
+			/* Index the entry the same way exfat_match() does. */
+			aoff64_t o = di.pos %
+			    (BPS(di.bs) / sizeof(exfat_dentry_t));
+			exfat_idx_t *idx = exfat_idx_get_by_pos(service_id,
+			    nodep->firstc, di.bnum * DPS(di.bs) + o);
+			if (!idx) {
+				rc = ENOMEM;
+				break;
+			}
+			fs_index_t cindex = idx->index;
+			fibril_mutex_unlock(&idx->lock);
+
+			if (!libfs_readdir_add(rd, name, cindex, di.pos + 1))
+				break;
+
+			rc = exfat_directory_next(&di);
+			if (rc != EOK)
+				break;
+		}
+	}
+
+	/* Running past the last entry is not an error. */
+	if (rc == ENOENT)
+		rc = EOK;
+
+	errno_t rc2 = exfat_directory_close(&di);
+	errno_t rc3 = exfat_node_put(fn);
+
+	if (rc == EOK)
+		rc = rc2;
+	return rc == EOK ? rc3 : rc;
+}
+
 static errno_t
 exfat_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
@@ -1622,6 +1689,7 @@ vfs_out_ops_t exfat_ops = {
 	.close = exfat_close,
 	.destroy = exfat_destroy,
 	.sync = exfat_sync,
+	.readdir = exfat_readdir,
 };
 
 /**
@@ -253,10 +253,28 @@ typedef struct fat_node {
 	bool		currc_cached_valid;
 	aoff64_t	currc_cached_bn;
 	fat_cluster_t	currc_cached_value;
+
+	/*
+	 * Map of the node's cluster chain, built on demand. Turns seeking
+	 * into a binary search instead of a walk of the chain.
+	 */
+	bool		extents_valid;
+	fat_extent_t	*extents;
+	size_t		extents_count;
+	size_t		extents_alloc;
 } fat_node_t;
 
 typedef struct {
 	bool lfn_enabled;
+
+	/*
+	 * Free cluster bitmap, built from FAT1 on the first allocation.
+	 * A set bit means the cluster is free.
+	 */
+	uint32_t	*free_map;
+	uint32_t	free_count;
+	/** Cluster where the next search for free clusters starts. */
+	fat_cluster_t	free_next;
 } fat_instance_t;
 
 extern vfs_out_ops_t fat_ops;
@@ -54,11 +54,46 @@
 
 /**
  * The fat_alloc_lock mutex protects all copies of the File Allocation Table
- * during allocation of clusters. The lock does not have to be held durring
- * deallocation of clusters.
+ * during allocation of clusters and the free cluster bitmaps. The lock does
+ * not have to be held durring deallocation of clusters, except for updating
+ * the bitmap.
  */
 static FIBRIL_MUTEX_INITIALIZE(fat_alloc_lock);
 
+#define FAT_MAP_WORD_BITS	32
+
+static inline bool fat_map_test(uint32_t *map, fat_cluster_t clst)
+{
+	return (map[clst / FAT_MAP_WORD_BITS] &
+	    (1U << (clst % FAT_MAP_WORD_BITS))) != 0;
+}
+
+static inline void fat_map_set(uint32_t *map, fat_cluster_t clst)
+{
+	map[clst / FAT_MAP_WORD_BITS] |= 1U << (clst % FAT_MAP_WORD_BITS);
+}
+
+static inline void fat_map_clear(uint32_t *map, fat_cluster_t clst)
+{
+	map[clst / FAT_MAP_WORD_BITS] &= ~(1U << (clst % FAT_MAP_WORD_BITS));
+}
+
+/** Get the mounted instance of a file system.
+ *
+ * @param service_id	Service ID of the device with the file system.
+ *
+ * @return		Instance or NULL if the file system is not mounted.
+ */
+static fat_instance_t *fat_instance_find(service_id_t service_id)
+{
+	void *data;
+
+	if (fs_instance_get(service_id, &data) != EOK)
+		return NULL;
+
+	return (fat_instance_t *) data;
+}
+
 /** Walk the cluster chain.
  *
  * @param bs		Buffer holding the boot sector for the file.
@@ -147,6 +182,16 @@ fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
 		    CLBN2PBN(bs, nodep->lastc_cached_value, bn), flags);
 	}
 
+	rc = fat_node_cluster_get(bs, nodep, bn / SPC(bs), &currc);
+	if (rc == EOK) {
+		return block_get(block, nodep->idx->service_id,
+		    CLBN2PBN(bs, currc, bn), flags);
+	}
+
+	/* Without memory for the cluster map, walk the chain. */
+	if (rc != ENOMEM)
+		return rc;
+
 	if (nodep->currc_cached_valid && bn >= nodep->currc_cached_bn) {
 		/*
 		 * We can start with the cluster cached by the previous call to
@@ -625,35 +670,260 @@ fat_set_cluster(fat_bs_t *bs, service_id_t service_id, unsigned fatno,
 	return rc;
 }
 
-/** Replay the allocatoin of clusters in all shadow instances of FAT.
+/** Set a run of consecutive entries in one instance of FAT.
  *
- * @param bs		Buffer holding the boot sector of the file system.
- * @param service_id	Service ID of the file system.
- * @param lifo		Chain of allocated clusters.
- * @param nclsts	Number of clusters in the lifo chain.
+ * The entries are updated one FAT sector at a time instead of one entry at
+ * a time.
+ *
+ * @param bs		Buffer holding the boot sector for the file system.
+ * @param service_id	Service ID for the file system.
+ * @param fatno		Number of the FAT instance where to make the change.
+ * @param clst		First cluster of the run.
+ * @param count		Number of clusters in the run.
+ * @param value		Value to set the last cluster of the run with. If chain
+ *			is false, all clusters of the run are set with it.
+ * @param chain		If true, each cluster but the last one is set to point
+ *			to the following cluster of the run.
  *
  * @return		EOK on success or an error code.
  */
-errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
-    fat_cluster_t *lifo, unsigned nclsts)
+static errno_t
+fat_set_cluster_run(fat_bs_t *bs, service_id_t service_id, unsigned fatno,
+    fat_cluster_t clst, uint32_t count, fat_cluster_t value, bool chain)
 {
-	uint8_t fatno;
-	unsigned c;
-	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	fat_cluster_t endc = clst + count;
+	block_t *b;
 	errno_t rc;
 
-	for (fatno = FAT1 + 1; fatno < FATCNT(bs); fatno++) {
-		for (c = 0; c < nclsts; c++) {
-			rc = fat_set_cluster(bs, service_id, fatno, lifo[c],
-			    c == 0 ? clst_last1 : lifo[c - 1]);
+	if (FAT_IS_FAT12(bs)) {
+		/* FAT12 entries may span sectors, keep it simple. */
+		for (; clst < endc; clst++) {
+			rc = fat_set_cluster(bs, service_id, fatno, clst,
+			    (chain && clst + 1 < endc) ? clst + 1 : value);
 			if (rc != EOK)
 				return rc;
 		}
+
+		return EOK;
+	}
+
+	unsigned epb = BPS(bs) / FAT_CLST_SIZE(bs);
+
+	while (clst < endc) {
+		rc = block_get(&b, service_id, RSCNT(bs) + SF(bs) * fatno +
+		    clst / epb, BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			return rc;
+
+		fat_cluster_t sendc = min(endc, (clst / epb + 1) * epb);
+		for (; clst < sendc; clst++) {
+			fat_cluster_t v = (chain && clst + 1 < endc) ?
+			    clst + 1 : value;
+
+			if (FAT_IS_FAT32(bs)) {
+				uint32_t *e = (uint32_t *) b->data + clst % epb;
+				fat_cluster_t temp = uint32_t_le2host(*e);
+				temp &= 0xf0000000;
+				temp |= (v & FAT32_MASK);
+				*e = host2uint32_t_le(temp);
+			} else {
+				uint16_t *e = (uint16_t *) b->data + clst % epb;
+				*e = host2uint16_t_le(v);
+			}
+		}
+
+		b->dirty = true;	/* need to sync block */
+		rc = block_put(b);
+		if (rc != EOK)
+			return rc;
 	}
 
 	return EOK;
 }
 
+/** Build the free cluster bitmap of a file system instance.
+ *
+ * Must be called with fat_alloc_lock held.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ * @param instance	Instance of the file system.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_free_map_build(fat_bs_t *bs, service_id_t service_id,
+    fat_instance_t *instance)
+{
+	fat_cluster_t clusters = CC(bs) + FAT_CLST_FIRST;
+	fat_cluster_t clst = FAT_CLST_FIRST;
+	fat_cluster_t value;
+	uint32_t free_count = 0;
+	uint32_t *map;
+	block_t *b;
+	errno_t rc;
+
+	map = calloc((clusters + FAT_MAP_WORD_BITS - 1) / FAT_MAP_WORD_BITS,
+	    sizeof(uint32_t));
+	if (map == NULL)
+		return ENOMEM;
+
+	if (FAT_IS_FAT12(bs)) {
+		for (; clst < clusters; clst++) {
+			rc = fat_get_cluster(bs, service_id, FAT1, clst,
+			    &value);
+			if (rc != EOK) {
+				free(map);
+				return rc;
+			}
+
+			if (value == FAT_CLST_RES0) {
+				fat_map_set(map, clst);
+				free_count++;
+			}
+		}
+	} else {
+		/* Decode whole FAT sectors at once. */
+		unsigned epb = BPS(bs) / FAT_CLST_SIZE(bs);
+
+		/* Clusters not covered by the FAT are never used. */
+		clusters = min(clusters, SF(bs) * epb);
+
+		while (clst < clusters) {
+			rc = block_get(&b, service_id, RSCNT(bs) + clst / epb,
+			    BLOCK_FLAGS_NONE);
+			if (rc != EOK) {
+				free(map);
+				return rc;
+			}
+
+			fat_cluster_t sendc = min(clusters,
+			    (clst / epb + 1) * epb);
+			for (; clst < sendc; clst++) {
+				if (FAT_IS_FAT32(bs)) {
+					value = uint32_t_le2host(((uint32_t *)
+					    b->data)[clst % epb]) & FAT32_MASK;
+				} else {
+					value = uint16_t_le2host(((uint16_t *)
+					    b->data)[clst % epb]);
+				}
+
+				if (value == FAT_CLST_RES0) {
+					fat_map_set(map, clst);
+					free_count++;
+				}
+			}
+
+			rc = block_put(b);
+			if (rc != EOK) {
+				free(map);
+				return rc;
+			}
+		}
+	}
+
+	instance->free_map = map;
+	instance->free_count = free_count;
+	instance->free_next = FAT_CLST_FIRST;
+	return EOK;
+}
+
+/** Get the instance of a file system with its free cluster bitmap built.
+ *
+ * Must be called with fat_alloc_lock held.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ *
+ * @return		Instance or NULL if the file system is not mounted or
+ *			the bitmap could not be built.
+ */
+static fat_instance_t *fat_free_map_get(fat_bs_t *bs, service_id_t service_id)
+{
+	fat_instance_t *instance = fat_instance_find(service_id);
+
+	if (instance == NULL)
+		return NULL;
+
+	if (instance->free_map == NULL &&
+	    fat_free_map_build(bs, service_id, instance) != EOK)
+		return NULL;
+
+	return instance;
+}
+
+/** Mark clusters free in the free cluster bitmap.
+ *
+ * @param service_id	Device service ID of the file system.
+ * @param clst		First cluster of the run.
+ * @param count		Number of clusters in the run.
+ */
+static void fat_free_map_release(service_id_t service_id, fat_cluster_t clst,
+    uint32_t count)
+{
+	fat_instance_t *instance;
+
+	fibril_mutex_lock(&fat_alloc_lock);
+	instance = fat_instance_find(service_id);
+	if (instance != NULL && instance->free_map != NULL) {
+		for (; count > 0; clst++, count--) {
+			if (!fat_map_test(instance->free_map, clst)) {
+				fat_map_set(instance->free_map, clst);
+				instance->free_count++;
+			}
+		}
+	}
+	fibril_mutex_unlock(&fat_alloc_lock);
+}
+
+/** Get the number of free clusters.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ * @param count		Output argument holding the number of free clusters.
+ *
+ * @return		EOK on success, ENOENT if the free cluster bitmap is
+ *			not available.
+ */
+errno_t fat_free_count_get(fat_bs_t *bs, service_id_t service_id,
+    uint32_t *count)
+{
+	fat_instance_t *instance;
+	errno_t rc = ENOENT;
+
+	fibril_mutex_lock(&fat_alloc_lock);
+	instance = fat_free_map_get(bs, service_id);
+	if (instance != NULL) {
+		*count = instance->free_count;
+		rc = EOK;
+	}
+	fibril_mutex_unlock(&fat_alloc_lock);
+
+	return rc;
+}
+
+/** Add a cluster to a run list, extending the last run if possible.
+ *
+ * @param runs		Run list with room for another run.
+ * @param nruns		Number of runs in the list.
+ * @param clst		Cluster to add.
+ */
+static void fat_runs_add(fat_extent_t *runs, unsigned *nruns,
+    fat_cluster_t clst)
+{
+	if (*nruns > 0) {
+		fat_extent_t *last = &runs[*nruns - 1];
+		if (last->clst + last->count == clst) {
+			last->count++;
+			return;
+		}
+	}
+
+	runs[*nruns].index = 0;
+	runs[*nruns].clst = clst;
+	runs[*nruns].count = 1;
+	(*nruns)++;
+}
+
 /** Allocate clusters in all copies of FAT.
  *
  * This function will attempt to allocate the requested number of clusters in
@@ -661,6 +931,10 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
  * clusters form an independent chain (i.e. a chain which does not belong to any
  * file yet).
  *
+ * Free clusters are looked up in the free cluster bitmap of the instance,
+ * starting where the previous allocation ended. Runs of consecutive clusters
+ * are written to the FATs one sector at a time.
+ *
  * @param bs		Buffer holding the boot sector of the file system.
  * @param service_id	Device service ID of the file system.
  * @param nclsts	Number of clusters to allocate.
@@ -675,63 +949,126 @@ errno_t
 fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
     fat_cluster_t *mcl, fat_cluster_t *lcl)
 {
-	fat_cluster_t *lifo;    /* stack for storing free cluster numbers */
-	unsigned found = 0;     /* top of the free cluster number stack */
+	fat_extent_t *runs;	/* runs of found free clusters */
+	unsigned nruns = 0;
+	unsigned found = 0;
+	fat_cluster_t clusters = CC(bs) + FAT_CLST_FIRST;
 	fat_cluster_t clst;
 	fat_cluster_t value = 0;
 	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	fat_instance_t *instance;
+	unsigned fatno = FAT1;
+	unsigned i;
 	errno_t rc = EOK;
 
-	lifo = (fat_cluster_t *) malloc(nclsts * sizeof(fat_cluster_t));
-	if (!lifo)
+	assert(nclsts > 0);
+
+	runs = (fat_extent_t *) malloc(nclsts * sizeof(fat_extent_t));
+	if (!runs)
 		return ENOMEM;
 
-	/*
-	 * Search FAT1 for unused clusters.
-	 */
 	fibril_mutex_lock(&fat_alloc_lock);
-	for (clst = FAT_CLST_FIRST; clst < CC(bs) + 2 && found < nclsts;
-	    clst++) {
-		rc = fat_get_cluster(bs, service_id, FAT1, clst, &value);
-		if (rc != EOK)
-			break;
 
-		if (value == FAT_CLST_RES0) {
-			/*
-			 * The cluster is free. Put it into our stack
-			 * of found clusters and mark it as non-free.
-			 */
-			lifo[found] = clst;
-			rc = fat_set_cluster(bs, service_id, FAT1, clst,
-			    (found == 0) ?  clst_last1 : lifo[found - 1]);
+	instance = fat_free_map_get(bs, service_id);
+	if (instance != NULL) {
+		uint32_t *map = instance->free_map;
+		uint32_t scanned = 0;
+
+		if (instance->free_count < nclsts) {
+			rc = ENOSPC;
+			goto error;
+		}
+
+		clst = instance->free_next;
+		if (clst < FAT_CLST_FIRST || clst >= clusters)
+			clst = FAT_CLST_FIRST;
+
+		while (found < nclsts && scanned < clusters) {
+			if (clst % FAT_MAP_WORD_BITS == 0 &&
+			    clst + FAT_MAP_WORD_BITS <= clusters &&
+			    map[clst / FAT_MAP_WORD_BITS] == 0) {
+				/* Skip a word of used clusters. */
+				clst += FAT_MAP_WORD_BITS;
+				scanned += FAT_MAP_WORD_BITS;
+			} else {
+				if (fat_map_test(map, clst)) {
+					fat_runs_add(runs, &nruns, clst);
+					found++;
+				}
+
+				clst++;
+				scanned++;
+			}
+
+			if (clst >= clusters)
+				clst = FAT_CLST_FIRST;
+		}
+	} else {
+		/*
+		 * Search FAT1 for unused clusters.
+		 */
+		for (clst = FAT_CLST_FIRST; clst < clusters && found < nclsts;
+		    clst++) {
+			rc = fat_get_cluster(bs, service_id, FAT1, clst, &value);
 			if (rc != EOK)
-				break;
+				goto error;
 
-			found++;
+			if (value == FAT_CLST_RES0) {
+				fat_runs_add(runs, &nruns, clst);
+				found++;
+			}
 		}
 	}
 
-	if (rc == EOK && found == nclsts) {
-		rc = fat_alloc_shadow_clusters(bs, service_id, lifo, nclsts);
-		if (rc == EOK) {
-			*mcl = lifo[found - 1];
-			*lcl = lifo[0];
-			free(lifo);
-			fibril_mutex_unlock(&fat_alloc_lock);
-			return EOK;
+	if (found < nclsts) {
+		rc = ENOSPC;
+		goto error;
+	}
+
+	/* Link the runs into an independent chain in all copies of FAT. */
+	for (fatno = FAT1; fatno < FATCNT(bs); fatno++) {
+		for (i = 0; i < nruns; i++) {
+			rc = fat_set_cluster_run(bs, service_id, fatno,
+			    runs[i].clst, runs[i].count,
+			    (i + 1 < nruns) ? runs[i + 1].clst : clst_last1,
+			    true);
+			if (rc != EOK)
+				goto undo;
 		}
 	}
 
-	/* If something wrong - free the clusters */
-	while (found--) {
-		(void) fat_set_cluster(bs, service_id, FAT1, lifo[found],
-		    FAT_CLST_RES0);
+	if (instance != NULL) {
+		for (i = 0; i < nruns; i++) {
+			for (clst = runs[i].clst;
+			    clst < runs[i].clst + runs[i].count; clst++)
+				fat_map_clear(instance->free_map, clst);
+		}
+
+		instance->free_count -= nclsts;
+		instance->free_next = runs[nruns - 1].clst +
+		    runs[nruns - 1].count;
 	}
 
-	free(lifo);
+	*mcl = runs[0].clst;
+	*lcl = runs[nruns - 1].clst + runs[nruns - 1].count - 1;
+
 	fibril_mutex_unlock(&fat_alloc_lock);
+	free(runs);
+	return EOK;
 
-	return ENOSPC;
+undo:
+	/* If something wrong - free the clusters */
+	for (fatno = FAT1; fatno < FATCNT(bs); fatno++) {
+		for (i = 0; i < nruns; i++) {
+			(void) fat_set_cluster_run(bs, service_id, fatno,
+			    runs[i].clst, runs[i].count, FAT_CLST_RES0, false);
+		}
+	}
+
+error:
+	fibril_mutex_unlock(&fat_alloc_lock);
+	free(runs);
+	return rc;
 }
 
 /** Free clusters forming a cluster chain in all copies of FAT.
@@ -746,31 +1083,186 @@ errno_t
 fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 {
 	unsigned fatno;
+	fat_cluster_t clst;
 	fat_cluster_t nextc = 0;
 	fat_cluster_t clst_bad = FAT_CLST_BAD(bs);
+	uint32_t count;
 	errno_t rc;
 
 	/* Mark all clusters in the chain as free in all copies of FAT. */
 	while (firstc < FAT_CLST_LAST1(bs)) {
 		assert(firstc >= FAT_CLST_FIRST && firstc < clst_bad);
 
-		rc = fat_get_cluster(bs, service_id, FAT1, firstc, &nextc);
-		if (rc != EOK)
-			return rc;
+		/* Find the run of consecutive clusters starting with firstc. */
+		clst = firstc;
+		count = 1;
+		for (;;) {
+			rc = fat_get_cluster(bs, service_id, FAT1, clst,
+			    &nextc);
+			if (rc != EOK)
+				return rc;
+
+			if (nextc != clst + 1)
+				break;
+
+			clst = nextc;
+			count++;
+		}
 
 		for (fatno = FAT1; fatno < FATCNT(bs); fatno++) {
-			rc = fat_set_cluster(bs, service_id, fatno, firstc,
-			    FAT_CLST_RES0);
+			rc = fat_set_cluster_run(bs, service_id, fatno, firstc,
+			    count, FAT_CLST_RES0, false);
 			if (rc != EOK)
 				return rc;
 		}
 
+		fat_free_map_release(service_id, firstc, count);
+
 		firstc = nextc;
 	}
 
 	return EOK;
 }
 
+/** Add a cluster to the cluster map of a node.
+ *
+ * @param nodep		FAT node.
+ * @param clst		Cluster following the last mapped cluster of the node.
+ *
+ * @return		EOK on success or ENOMEM.
+ */
+static errno_t fat_extents_add(fat_node_t *nodep, fat_cluster_t clst)
+{
+	fat_extent_t *last = NULL;
+	fat_extent_t *extents;
+	size_t nalloc;
+
+	if (nodep->extents_count > 0) {
+		last = &nodep->extents[nodep->extents_count - 1];
+		if (last->clst + last->count == clst) {
+			last->count++;
+			return EOK;
+		}
+	}
+
+	if (nodep->extents_count == nodep->extents_alloc) {
+		nalloc = nodep->extents_alloc ? 2 * nodep->extents_alloc : 8;
+		extents = realloc(nodep->extents,
+		    nalloc * sizeof(fat_extent_t));
+		if (extents == NULL)
+			return ENOMEM;
+
+		nodep->extents = extents;
+		nodep->extents_alloc = nalloc;
+		if (last != NULL)
+			last = &extents[nodep->extents_count - 1];
+	}
+
+	extents = &nodep->extents[nodep->extents_count++];
+	extents->index = (last != NULL) ? last->index + last->count : 0;
+	extents->clst = clst;
+	extents->count = 1;
+
+	return EOK;
+}
+
+/** Add a cluster chain to the cluster map of a node.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param nodep		FAT node.
+ * @param clst		First cluster of the chain.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_extents_add_chain(fat_bs_t *bs, fat_node_t *nodep,
+    fat_cluster_t clst)
+{
+	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	errno_t rc;
+
+	while (clst < clst_last1) {
+		assert(clst >= FAT_CLST_FIRST);
+
+		rc = fat_extents_add(nodep, clst);
+		if (rc != EOK)
+			return rc;
+
+		/* read FAT1 */
+		rc = fat_get_cluster(bs, nodep->idx->service_id, FAT1, clst,
+		    &clst);
+		if (rc != EOK)
+			return rc;
+
+		assert(clst != FAT_CLST_BAD(bs));
+	}
+
+	return EOK;
+}
+
+/** Drop the cluster map of a node.
+ *
+ * @param nodep		FAT node.
+ */
+void fat_extents_invalidate(fat_node_t *nodep)
+{
+	free(nodep->extents);
+	nodep->extents = NULL;
+	nodep->extents_count = 0;
+	nodep->extents_alloc = 0;
+	nodep->extents_valid = false;
+}
+
+/** Get the n-th cluster of a node.
+ *
+ * The cluster map of the node is built on the first use so that only
+ * a binary search is needed afterwards.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param nodep		FAT node.
+ * @param n		Index of the cluster within the node.
+ * @param clst		Output argument holding the cluster.
+ *
+ * @return		EOK on success, ELIMIT if the node has fewer clusters,
+ *			ENOMEM if the map cannot be built or another error code.
+ */
+errno_t fat_node_cluster_get(fat_bs_t *bs, fat_node_t *nodep, uint32_t n,
+    fat_cluster_t *clst)
+{
+	size_t lo, hi, mid;
+	errno_t rc;
+
+	if (!nodep->extents_valid) {
+		fat_extents_invalidate(nodep);
+		if (nodep->firstc != FAT_CLST_RES0) {
+			rc = fat_extents_add_chain(bs, nodep, nodep->firstc);
+			if (rc != EOK) {
+				fat_extents_invalidate(nodep);
+				return rc;
+			}
+		}
+
+		nodep->extents_valid = true;
+	}
+
+	lo = 0;
+	hi = nodep->extents_count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		fat_extent_t *e = &nodep->extents[mid];
+
+		if (n < e->index) {
+			hi = mid;
+		} else if (n >= e->index + e->count) {
+			lo = mid + 1;
+		} else {
+			*clst = e->clst + (n - e->index);
+			return EOK;
+		}
+	}
+
+	return ELIMIT;
+}
+
 /** Append a cluster chain to the last file cluster in all FATs.
  *
  * @param bs		Buffer holding the boot sector of the file system.
@@ -814,6 +1306,11 @@ errno_t fat_append_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t mcl,
 	nodep->lastc_cached_valid = true;
 	nodep->lastc_cached_value = lcl;
 
+	/* Extend the cluster map with the appended chain. */
+	if (nodep->extents_valid &&
+	    fat_extents_add_chain(bs, nodep, mcl) != EOK)
+		fat_extents_invalidate(nodep);
+
 	return EOK;
 }
 
@@ -840,6 +1337,24 @@ errno_t fat_chop_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t lcl)
 	if (nodep->currc_cached_value != lcl)
 		nodep->currc_cached_valid = false;
 
+	/* Cut the cluster map after lcl. */
+	if (nodep->extents_valid) {
+		size_t i;
+
+		for (i = 0; i < nodep->extents_count; i++) {
+			fat_extent_t *e = &nodep->extents[i];
+			if (lcl >= e->clst && lcl < e->clst + e->count) {
+				e->count = lcl - e->clst + 1;
+				break;
+			}
+		}
+
+		if (i < nodep->extents_count)
+			nodep->extents_count = i + 1;
+		else
+			fat_extents_invalidate(nodep);
+	}
+
 	if (lcl == FAT_CLST_RES0) {
 		/* The node will have zero size and no clusters allocated. */
 		rc = fat_free_clusters(bs, service_id, nodep->firstc);
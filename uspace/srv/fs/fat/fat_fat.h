@@ -105,6 +105,16 @@ struct fat_bs;
 
 typedef uint32_t fat_cluster_t;
 
+/** Run of consecutive clusters belonging to a node. */
+typedef struct {
+	/** Index of the first cluster of the run within the node. */
+	uint32_t	index;
+	/** First cluster of the run. */
+	fat_cluster_t	clst;
+	/** Number of clusters in the run. */
+	uint32_t	count;
+} fat_extent_t;
+
 #define fat_clusters_get(numc, bs, sid, fc) \
     fat_cluster_walk((bs), (sid), (fc), NULL, (numc), (uint32_t) -1)
 extern errno_t fat_cluster_walk(struct fat_bs *, service_id_t, fat_cluster_t,
@@ -122,8 +132,10 @@ extern errno_t fat_chop_clusters(struct fat_bs *, struct fat_node *,
 extern errno_t fat_alloc_clusters(struct fat_bs *, service_id_t, unsigned,
     fat_cluster_t *, fat_cluster_t *);
 extern errno_t fat_free_clusters(struct fat_bs *, service_id_t, fat_cluster_t);
-extern errno_t fat_alloc_shadow_clusters(struct fat_bs *, service_id_t,
-    fat_cluster_t *, unsigned);
+extern errno_t fat_free_count_get(struct fat_bs *, service_id_t, uint32_t *);
+extern errno_t fat_node_cluster_get(struct fat_bs *, struct fat_node *,
+    uint32_t, fat_cluster_t *);
+extern void fat_extents_invalidate(struct fat_node *);
 extern errno_t fat_get_cluster(struct fat_bs *, service_id_t, unsigned,
     fat_cluster_t, fat_cluster_t *);
 extern errno_t fat_set_cluster(struct fat_bs *, service_id_t, unsigned,
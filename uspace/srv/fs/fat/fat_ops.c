@@ -111,6 +111,10 @@ static void fat_node_initialize(fat_node_t *node)
 	node->currc_cached_valid = false;
 	node->currc_cached_bn = 0;
 	node->currc_cached_value = 0;
+	node->extents_valid = false;
+	node->extents = NULL;
+	node->extents_count = 0;
+	node->extents_alloc = 0;
 }
 
 static errno_t fat_node_sync(fat_node_t *node)
@@ -192,6 +196,7 @@ restart:
 				return rc;
 		}
 		nodep->idx->nodep = NULL;
+		fat_extents_invalidate(nodep);
 		free(nodep->bp);
 		free(nodep);
 
@@ -230,12 +235,14 @@ static errno_t fat_node_get_new(fat_node_t **nodepp)
 				idxp_tmp->nodep = NULL;
 				fibril_mutex_unlock(&nodep->lock);
 				fibril_mutex_unlock(&idxp_tmp->lock);
+				fat_extents_invalidate(nodep);
 				free(nodep->bp);
 				free(nodep);
 				return rc;
 			}
 		}
 		idxp_tmp->nodep = NULL;
+		fat_extents_invalidate(nodep);
 		fibril_mutex_unlock(&nodep->lock);
 		fibril_mutex_unlock(&idxp_tmp->lock);
 		fn = FS_NODE(nodep);
@@ -476,6 +483,7 @@ errno_t fat_node_put(fs_node_t *fn)
 	}
 	fibril_mutex_unlock(&nodep->lock);
 	if (destroy) {
+		fat_extents_invalidate(nodep);
 		free(nodep->bp);
 		free(nodep);
 	}
@@ -569,6 +577,7 @@ errno_t fat_destroy_node(fs_node_t *fn)
 	}
 
 	fat_idx_destroy(nodep->idx);
+	fat_extents_invalidate(nodep);
 	free(nodep->bp);
 	free(nodep);
 	return rc;
@@ -869,8 +878,15 @@ errno_t fat_free_block_count(service_id_t service_id, uint64_t *count)
 	errno_t rc;
 	uint32_t cluster_no, clusters;
 
-	block_count = 0;
 	bs = block_bb_get(service_id);
+
+	/* Use the free cluster bitmap if possible. */
+	if (fat_free_count_get(bs, service_id, &clusters) == EOK) {
+		*count = clusters;
+		return EOK;
+	}
+
+	block_count = 0;
 	clusters = (SPC(bs)) ? TS(bs) / SPC(bs) : 0;
 	for (cluster_no = 0; cluster_no < clusters; cluster_no++) {
 		rc = fat_get_cluster(bs, service_id, FAT1, cluster_no, &e0);
@@ -1024,6 +1040,7 @@ static errno_t fat_fs_open(service_id_t service_id, enum cache_mode cmode,
 
 static void fat_fs_close(service_id_t service_id, fs_node_t *rfn)
 {
+	fat_extents_invalidate(FAT_NODE(rfn));
 	free(rfn->data);
 	free(rfn);
 	(void) block_cache_fini(service_id);
@@ -1088,6 +1105,9 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 	if (!instance)
 		return ENOMEM;
 	instance->lfn_enabled = true;
+	instance->free_map = NULL;
+	instance->free_count = 0;
+	instance->free_next = FAT_CLST_FIRST;
 
 	/* Parse mount options. */
 	char *mntopts = (char *) opts;
@@ -1147,8 +1167,24 @@ static errno_t fat_update_fat32_fsinfo(service_id_t service_id)
 		return EINVAL;
 	}
 
-	/* For now, invalidate the counter. */
-	info->free_clusters = host2uint16_t_le(-1);
+	/*
+	 * Store the free cluster count if it is known from the free cluster
+	 * bitmap. Otherwise invalidate the counter.
+	 */
+	void *data;
+	fat_instance_t *instance = NULL;
+	if (fs_instance_get(service_id, &data) == EOK)
+		instance = (fat_instance_t *) data;
+
+	if (instance != NULL && instance->free_map != NULL) {
+		info->free_clusters = host2uint32_t_le(instance->free_count);
+		if (instance->free_next > FAT_CLST_FIRST) {
+			info->last_allocated_cluster =
+			    host2uint32_t_le(instance->free_next - 1);
+		}
+	} else {
+		info->free_clusters = host2uint32_t_le(-1);
+	}
 
 	b->dirty = true;
 	return block_put(b);
@@ -1200,6 +1236,7 @@ static errno_t fat_unmounted(service_id_t service_id)
 	void *data;
 	if (fs_instance_get(service_id, &data) == EOK) {
 		fs_instance_destroy(service_id);
+		free(((fat_instance_t *) data)->free_map);
 		free(data);
 	}
 
@@ -1316,6 +1353,71 @@ fat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	return rc;
 }
 
+static errno_t
+fat_readdir(service_id_t service_id, fs_index_t index, aoff64_t pos,
+    libfs_readdir_t *rd)
+{
+	fs_node_t *fn;
+	fat_node_t *nodep;
+	char name[FAT_LFN_NAME_SIZE];
+	fat_dentry_t *d;
+	errno_t rc;
+
+	rc = fat_node_get(&fn, service_id, index);
+	if (rc != EOK)
+		return rc;
+	if (!fn)
+		return ENOENT;
+	nodep = FAT_NODE(fn);
+
+	if (nodep->type != FAT_DIRECTORY) {
+		(void) fat_node_put(fn);
+		return ENOTDIR;
+	}
+
+	fat_directory_t di;
+	rc = fat_directory_open(nodep, &di);
+	if (rc != EOK) {
+		(void) fat_node_put(fn);
+		return rc;
+	}
+
+	rc = fat_directory_seek(&di, pos);
+	if (rc == EOK) {
+		while ((rc = fat_directory_read(&di, name, &d)) == EOK) {
+			/* Index the entry the same way fat_match() does. */
+			aoff64_t o = di.pos %
+			    (BPS(di.bs) / sizeof(fat_dentry_t));
+			fat_idx_t *idx = fat_idx_get_by_pos(service_id,
+			    nodep->firstc, di.bnum * DPS(di.bs) + o);
+			if (!idx) {
+				rc = ENOMEM;
+				break;
+			}
+			fs_index_t cindex = idx->index;
+			fibril_mutex_unlock(&idx->lock);
+
+			if (!libfs_readdir_add(rd, name, cindex, di.pos + 1))
+				break;
+
+			rc = fat_directory_next(&di);
+			if (rc != EOK)
+				break;
+		}
+	}
+
+	/* Running past the last entry is not an error. */
+	if (rc == ENOENT)
+		rc = EOK;
+
+	errno_t rc2 = fat_directory_close(&di);
+	errno_t rc3 = fat_node_put(fn);
+
+	if (rc == EOK)
+		rc = rc2;
+	return rc == EOK ? rc3 : rc;
+}
+
 static errno_t
 fat_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
@@ -1495,8 +1597,13 @@ fat_truncate(service_id_t service_id, fs_index_t index, aoff64_t size)
 				goto out;
 		} else {
 			fat_cluster_t lastc;
-			rc = fat_cluster_walk(bs, service_id, nodep->firstc,
-			    &lastc, NULL, (size - 1) / BPC(bs));
+			rc = fat_node_cluster_get(bs, nodep, (size - 1) / BPC(bs),
+			    &lastc);
+			if (rc == ENOMEM) {
+				rc = fat_cluster_walk(bs, service_id,
+				    nodep->firstc, &lastc, NULL,
+				    (size - 1) / BPC(bs));
+			}
 			if (rc != EOK)
 				goto out;
 			rc = fat_chop_clusters(bs, nodep, lastc);
@@ -1568,6 +1675,7 @@ vfs_out_ops_t fat_ops = {
 	.close = fat_close,
 	.destroy = fat_destroy,
 	.sync = fat_sync,
+	.readdir = fat_readdir,
 };
 
 /**
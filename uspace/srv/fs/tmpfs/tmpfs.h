@@ -64,7 +64,8 @@ typedef struct tmpfs_node {
 	tmpfs_dentry_type_t type;
 	unsigned lnkcnt;	/**< Link count. */
 	size_t size;		/**< File size if type is TMPFS_FILE. */
-	void *data;		/**< File content's if type is TMPFS_FILE. */
+	void *pages;		/**< Radix tree of file pages if type is TMPFS_FILE. */
+	unsigned pages_height;	/**< Height of the radix tree of pages. */
 	list_t cs_list;		/**< Child's siblings list. */
 } tmpfs_node_t;
 
@@ -73,6 +74,10 @@ extern libfs_ops_t tmpfs_libfs_ops;
 
 extern bool tmpfs_init(void);
 
+extern void *tmpfs_page_get(tmpfs_node_t *, size_t);
+extern errno_t tmpfs_page_alloc(tmpfs_node_t *, size_t, void **);
+extern void tmpfs_pages_truncate(tmpfs_node_t *, size_t);
+
 #endif
 
 /**
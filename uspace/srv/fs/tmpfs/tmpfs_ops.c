@@ -44,6 +44,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <str.h>
+#include <mem.h>
 #include <stdio.h>
 #include <assert.h>
 #include <stddef.h>
@@ -179,14 +180,17 @@ static void nodes_remove_callback(ht_link_t *item)
 		free(dentryp);
 	}
 
-	if (nodep->data) {
+	if (nodep->pages) {
 		assert(nodep->type == TMPFS_FILE);
-		free(nodep->data);
+		tmpfs_pages_truncate(nodep, 0);
 	}
 	free(nodep->bp);
 	free(nodep);
 }
 
+/** Contents of pages which are not allocated. */
+static uint8_t tmpfs_zero_page[PAGE_SIZE];
+
 /** TMPFS nodes hash table operations. */
 hash_table_ops_t nodes_ops = {
 	.hash = nodes_hash,
@@ -204,7 +208,8 @@ static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 	nodep->type = TMPFS_NONE;
 	nodep->lnkcnt = 0;
 	nodep->size = 0;
-	nodep->data = NULL;
+	nodep->pages = NULL;
+	nodep->pages_height = 0;
 	list_initialize(&nodep->cs_list);
 }
 
@@ -491,9 +496,21 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 
 	size_t bytes;
 	if (nodep->type == TMPFS_FILE) {
-		bytes = min(nodep->size - pos, size);
-		(void) async_data_read_finalize(&call, nodep->data + pos,
-		    bytes);
+		/*
+		 * Serve at most one page, the client will ask for the rest.
+		 * Unallocated pages read as zeros.
+		 */
+		size_t offset = pos % PAGE_SIZE;
+		bytes = 0;
+		if (pos < nodep->size)
+			bytes = min(min(nodep->size - pos, size),
+			    PAGE_SIZE - offset);
+
+		void *page = tmpfs_page_get(nodep, pos / PAGE_SIZE);
+		if (page == NULL)
+			page = tmpfs_zero_page;
+
+		(void) async_data_read_finalize(&call, page + offset, bytes);
 	} else {
 		tmpfs_dentry_t *dentryp;
 		link_t *lnk;
@@ -523,6 +540,39 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 	return EOK;
 }
 
+static errno_t tmpfs_readdir(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, libfs_readdir_t *rd)
+{
+	node_key_t key = {
+		.service_id = service_id,
+		.index = index
+	};
+
+	ht_link_t *hlp = hash_table_find(&nodes, &key);
+	if (!hlp)
+		return ENOENT;
+
+	tmpfs_node_t *nodep = hash_table_get_inst(hlp, tmpfs_node_t, nh_link);
+	if (nodep->type != TMPFS_DIRECTORY)
+		return ENOTDIR;
+
+	/* Positions are ordinal numbers of the entries, like in tmpfs_read(). */
+	link_t *lnk = list_nth(&nodep->cs_list, pos);
+	while (lnk != NULL) {
+		tmpfs_dentry_t *dentryp = list_get_instance(lnk, tmpfs_dentry_t,
+		    link);
+
+		if (!libfs_readdir_add(rd, dentryp->name, dentryp->node->index,
+		    pos + 1))
+			break;
+
+		pos++;
+		lnk = list_next(lnk, &nodep->cs_list);
+	}
+
+	return EOK;
+}
+
 static errno_t
 tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
@@ -553,33 +603,28 @@ tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	}
 
 	/*
-	 * Check whether the file needs to grow.
+	 * Write at most one page, the client will send the rest. Growing the
+	 * file only allocates the pages that are written to.
 	 */
-	if (pos + size <= nodep->size) {
-		/* The file size is not changing. */
-		(void) async_data_write_finalize(&call, nodep->data + pos,
-		    size);
+	size_t offset = pos % PAGE_SIZE;
+	size = min(size, PAGE_SIZE - offset);
+	if (pos + size > SIZE_MAX) {
+		async_answer_0(&call, ENOMEM);
+		size = 0;
 		goto out;
 	}
-	size_t delta = (pos + size) - nodep->size;
-	/*
-	 * At this point, we are deliberately extremely straightforward and
-	 * simply realloc the contents of the file on every write that grows the
-	 * file. In the end, the situation might not be as bad as it may look:
-	 * our heap allocator can save us and just grow the block whenever
-	 * possible.
-	 */
-	void *newdata = realloc(nodep->data, nodep->size + delta);
-	if (!newdata) {
-		async_answer_0(&call, ENOMEM);
+
+	void *page;
+	errno_t rc = tmpfs_page_alloc(nodep, pos / PAGE_SIZE, &page);
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
 		size = 0;
 		goto out;
 	}
-	/* Clear any newly allocated memory in order to emulate gaps. */
-	memset(newdata + nodep->size, 0, delta);
-	nodep->size += delta;
-	nodep->data = newdata;
-	(void) async_data_write_finalize(&call, nodep->data + pos, size);
+
+	(void) async_data_write_finalize(&call, page + offset, size);
+	if (pos + size > nodep->size)
+		nodep->size = pos + size;
 
 out:
 	*wbytes = size;
@@ -587,6 +632,79 @@ out:
 	return EOK;
 }
 
+static errno_t tmpfs_copy_range(service_id_t service_id, fs_index_t src_index,
+    aoff64_t src_pos, fs_index_t dst_index, aoff64_t dst_pos, aoff64_t size,
+    aoff64_t *copied, aoff64_t *nsize)
+{
+	node_key_t key = {
+		.service_id = service_id,
+		.index = src_index
+	};
+
+	ht_link_t *hlp = hash_table_find(&nodes, &key);
+	if (!hlp)
+		return ENOENT;
+	tmpfs_node_t *srcp = hash_table_get_inst(hlp, tmpfs_node_t, nh_link);
+
+	key.index = dst_index;
+	hlp = hash_table_find(&nodes, &key);
+	if (!hlp)
+		return ENOENT;
+	tmpfs_node_t *dstp = hash_table_get_inst(hlp, tmpfs_node_t, nh_link);
+
+	if (srcp->type != TMPFS_FILE || dstp->type != TMPFS_FILE)
+		return EINVAL;
+
+	if (src_pos >= srcp->size)
+		size = 0;
+	else
+		size = min(size, srcp->size - src_pos);
+
+	if (dst_pos + size > SIZE_MAX)
+		return ENOMEM;
+
+	/*
+	 * Copy page by page, holes of the source stay holes unless the
+	 * destination already has a page there.
+	 */
+	aoff64_t done = 0;
+	errno_t rc = EOK;
+	while (done < size) {
+		size_t soff = (src_pos + done) % PAGE_SIZE;
+		size_t doff = (dst_pos + done) % PAGE_SIZE;
+		size_t n = min(size - done,
+		    min(PAGE_SIZE - soff, PAGE_SIZE - doff));
+
+		void *src = tmpfs_page_get(srcp, (src_pos + done) / PAGE_SIZE);
+		void *dst = tmpfs_page_get(dstp, (dst_pos + done) / PAGE_SIZE);
+
+		if (src != NULL && dst == NULL) {
+			rc = tmpfs_page_alloc(dstp, (dst_pos + done) / PAGE_SIZE,
+			    &dst);
+			if (rc != EOK)
+				break;
+		}
+
+		if (src != NULL)
+			memcpy(dst + doff, src + soff, n);
+		else if (dst != NULL)
+			memset(dst + doff, 0, n);
+
+		done += n;
+	}
+
+	/* Report a partial copy, the error will come with the next request. */
+	if (done == 0 && rc != EOK)
+		return rc;
+
+	if (dst_pos + done > dstp->size)
+		dstp->size = dst_pos + done;
+
+	*copied = done;
+	*nsize = dstp->size;
+	return EOK;
+}
+
 static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
     aoff64_t size)
 {
@@ -609,17 +727,22 @@ static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
 	if (size > SIZE_MAX)
 		return ENOMEM;
 
-	void *newdata = realloc(nodep->data, size);
-	if (!newdata && size)
-		return ENOMEM;
+	if (size < nodep->size) {
+		/*
+		 * Free the pages past the new end of the file and clear the
+		 * tail of the last one, so that the file can grow again
+		 * without touching the pages.
+		 */
+		tmpfs_pages_truncate(nodep, (size + PAGE_SIZE - 1) / PAGE_SIZE);
 
-	if (size > nodep->size) {
-		size_t delta = size - nodep->size;
-		memset(newdata + nodep->size, 0, delta);
+		void *page = tmpfs_page_get(nodep, size / PAGE_SIZE);
+		if (page != NULL && size % PAGE_SIZE != 0) {
+			memset(page + size % PAGE_SIZE, 0,
+			    PAGE_SIZE - size % PAGE_SIZE);
+		}
 	}
 
 	nodep->size = size;
-	nodep->data = newdata;
 	return EOK;
 }
 
@@ -662,6 +785,8 @@ vfs_out_ops_t tmpfs_ops = {
 	.close = tmpfs_close,
 	.destroy = tmpfs_destroy,
 	.sync = tmpfs_sync,
+	.readdir = tmpfs_readdir,
+	.copy_range = tmpfs_copy_range,
 };
 
 /**
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tmpfs
+ * @{
+ */
+
+/**
+ * @file	tmpfs_pages.c
+ * @brief	Page storage of TMPFS file contents.
+ *
+ * The contents of a file are kept in a radix tree indexed by the page number
+ * within the file. Pages are page-aligned heap blocks. An address space area
+ * per page would let them be shared with clients, but the kernel searches
+ * all areas of the task to place a new one, which makes growing a file
+ * quadratic in its size. Pages which were never written are not allocated
+ * and read as zeros.
+ *
+ * Bytes of allocated pages which lie beyond the end of the file are kept
+ * zero, so that growing the file never needs to touch them.
+ */
+
+#include "tmpfs.h"
+#include <as.h>
+#include <assert.h>
+#include <errno.h>
+#include <malloc.h>
+#include <mem.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/** Number of bits of the page number resolved by one level of the tree. */
+#define TMPFS_RADIX_BITS	8
+#define TMPFS_RADIX_FANOUT	(1 << TMPFS_RADIX_BITS)
+#define TMPFS_RADIX_MASK	(TMPFS_RADIX_FANOUT - 1)
+
+/** Get the number of pages covered by a subtree.
+ *
+ * @param height	Height of the subtree. A subtree of height one is
+ *			a single page.
+ *
+ * @return		Number of pages or SIZE_MAX if it cannot be
+ *			represented.
+ */
+static size_t tmpfs_pages_span(unsigned height)
+{
+	if (height == 0)
+		return 0;
+
+	if ((height - 1) * TMPFS_RADIX_BITS >= sizeof(size_t) * 8)
+		return SIZE_MAX;
+
+	return (size_t) 1 << ((height - 1) * TMPFS_RADIX_BITS);
+}
+
+/** Get the index of the slot leading to a page in an interior node.
+ *
+ * @param idx		Page number.
+ * @param height	Height of the interior node.
+ */
+static size_t tmpfs_pages_slot(size_t idx, unsigned height)
+{
+	return (idx >> ((height - 2) * TMPFS_RADIX_BITS)) & TMPFS_RADIX_MASK;
+}
+
+/** Get a page of a file.
+ *
+ * @param nodep		TMPFS node of the file.
+ * @param idx		Page number within the file.
+ *
+ * @return		Page or NULL if the page is not allocated.
+ */
+void *tmpfs_page_get(tmpfs_node_t *nodep, size_t idx)
+{
+	unsigned height = nodep->pages_height;
+	void *node = nodep->pages;
+
+	if (idx >= tmpfs_pages_span(height))
+		return NULL;
+
+	for (; height > 1 && node != NULL; height--)
+		node = ((void **) node)[tmpfs_pages_slot(idx, height)];
+
+	return node;
+}
+
+/** Get a page of a file, allocating it if needed.
+ *
+ * @param nodep		TMPFS node of the file.
+ * @param idx		Page number within the file.
+ * @param rpage		Place to store the page.
+ *
+ * @return		EOK on success or ENOMEM.
+ */
+errno_t tmpfs_page_alloc(tmpfs_node_t *nodep, size_t idx, void **rpage)
+{
+	/* Grow the tree until it covers the page. */
+	while (idx >= tmpfs_pages_span(nodep->pages_height)) {
+		if (nodep->pages != NULL) {
+			void **node = calloc(TMPFS_RADIX_FANOUT, sizeof(void *));
+			if (node == NULL)
+				return ENOMEM;
+
+			node[0] = nodep->pages;
+			nodep->pages = node;
+		}
+
+		nodep->pages_height++;
+	}
+
+	void **slot = &nodep->pages;
+	for (unsigned height = nodep->pages_height; height > 1; height--) {
+		if (*slot == NULL) {
+			*slot = calloc(TMPFS_RADIX_FANOUT, sizeof(void *));
+			if (*slot == NULL)
+				return ENOMEM;
+		}
+
+		slot = &((void **) *slot)[tmpfs_pages_slot(idx, height)];
+	}
+
+	if (*slot == NULL) {
+		void *page = memalign(PAGE_SIZE, PAGE_SIZE);
+		if (page == NULL)
+			return ENOMEM;
+
+		memset(page, 0, PAGE_SIZE);
+		*slot = page;
+	}
+
+	*rpage = *slot;
+	return EOK;
+}
+
+/** Free pages of a subtree starting with a given page.
+ *
+ * @param node		Root of the subtree.
+ * @param height	Height of the subtree.
+ * @param base		Number of the first page covered by the subtree.
+ * @param first		Number of the first page to free.
+ *
+ * @return		True if the whole subtree has been freed.
+ */
+static bool tmpfs_pages_free(void *node, unsigned height, size_t base,
+    size_t first)
+{
+	if (height == 1) {
+		if (base < first)
+			return false;
+
+		free(node);
+		return true;
+	}
+
+	void **slots = node;
+	size_t span = tmpfs_pages_span(height - 1);
+	bool empty = true;
+
+	for (size_t i = 0; i < TMPFS_RADIX_FANOUT; i++) {
+		size_t child_base = base + i * span;
+
+		if (slots[i] == NULL)
+			continue;
+
+		/* Children are ordered, skip those entirely below first. */
+		if (child_base + span <= first) {
+			empty = false;
+			continue;
+		}
+
+		if (tmpfs_pages_free(slots[i], height - 1, child_base, first))
+			slots[i] = NULL;
+		else
+			empty = false;
+	}
+
+	if (!empty)
+		return false;
+
+	free(slots);
+	return true;
+}
+
+/** Free all pages of a file starting with a given page.
+ *
+ * @param nodep		TMPFS node of the file.
+ * @param first		Number of the first page to free.
+ */
+void tmpfs_pages_truncate(tmpfs_node_t *nodep, size_t first)
+{
+	if (nodep->pages == NULL ||
+	    first >= tmpfs_pages_span(nodep->pages_height))
+		return;
+
+	if (tmpfs_pages_free(nodep->pages, nodep->pages_height, 0, first)) {
+		nodep->pages = NULL;
+		nodep->pages_height = 0;
+	}
+}
+
+/**
+ * @}
+ */
@@ -55,6 +55,7 @@ vfs_info_t udf_vfs_info = {
 	.name = NAME,
 	.concurrent_read_write = false,
 	.write_retains_size = false,
+	.cache_names = true,
 	.instance = 0,
 };
 
@@ -61,6 +61,7 @@ static errno_t ethip_get_mac48(iplink_srv_t *srv, addr48_t *mac);
 static errno_t ethip_set_mac48(iplink_srv_t *srv, addr48_t *mac);
 static errno_t ethip_addr_add(iplink_srv_t *srv, inet_addr_t *addr);
 static errno_t ethip_addr_remove(iplink_srv_t *srv, inet_addr_t *addr);
+static errno_t ethip_get_offload(iplink_srv_t *srv, iplink_offload_t *offload);
 
 static void ethip_client_conn(ipc_call_t *icall, void *arg);
 
@@ -73,7 +74,8 @@ static iplink_ops_t ethip_iplink_ops = {
 	.get_mac48 = ethip_get_mac48,
 	.set_mac48 = ethip_set_mac48,
 	.addr_add = ethip_addr_add,
-	.addr_remove = ethip_addr_remove
+	.addr_remove = ethip_addr_remove,
+	.get_offload = ethip_get_offload
 };
 
 static errno_t ethip_init(void)
@@ -194,7 +196,18 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 	if (rc != EOK)
 		return rc;
 
-	rc = ethip_nic_send(nic, data, size);
+	if (sdu->csum_start != 0) {
+		/* Offsets in the frame start with the Ethernet header */
+		nic_tx_offload_t offload;
+		offload.csum_start = size - sdu->size + sdu->csum_start;
+		offload.csum_offset = sdu->csum_offset;
+		offload.gso_size = sdu->gso_size;
+
+		rc = ethip_nic_send_offload(nic, data, size, &offload);
+	} else {
+		rc = ethip_nic_send(nic, data, size);
+	}
+
 	free(data);
 
 	return rc;
@@ -275,6 +288,22 @@ static errno_t ethip_get_mtu(iplink_srv_t *srv, size_t *mtu)
 	return EOK;
 }
 
+static errno_t ethip_get_offload(iplink_srv_t *srv, iplink_offload_t *offload)
+{
+	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_get_offload()");
+
+	*offload = 0;
+	if ((nic->offload & NIC_OFFLOAD_TX_CSUM) != 0) {
+		*offload |= IPLINK_OFFLOAD_CSUM;
+		if ((nic->offload & NIC_OFFLOAD_TSO4) != 0)
+			*offload |= IPLINK_OFFLOAD_TSO4;
+	}
+
+	return EOK;
+}
+
 static errno_t ethip_get_mac48(iplink_srv_t *srv, addr48_t *mac)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_get_mac48()");
@@ -62,6 +62,9 @@ typedef struct ethip_nic {
 	/** MAC address */
 	addr48_t mac_addr;
 
+	/** Active NIC offloads (NIC_OFFLOAD_*) */
+	uint32_t offload;
+
 	/**
 	 * List of IP addresses configured on this link
 	 * (of the type ethip_link_addr_t)
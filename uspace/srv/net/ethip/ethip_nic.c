@@ -181,6 +181,12 @@ static errno_t ethip_nic_open(service_id_t sid)
 	list_append(&nic->link, &ethip_nic_list);
 	in_list = true;
 
+	/* Offloads must be known before the IP link is used */
+	uint32_t offload_supported;
+	rc = nic_offload_probe(nic->sess, &offload_supported, &nic->offload);
+	if (rc != EOK)
+		nic->offload = 0;
+
 	rc = ethip_iplink_init(nic);
 	if (rc != EOK)
 		goto error;
@@ -349,6 +355,24 @@ ethip_nic_t *ethip_nic_find_by_iplink_sid(service_id_t iplink_sid)
 	return NULL;
 }
 
+/** Send frame with offloaded computations.
+ *
+ * @param nic     NIC
+ * @param data    Frame data
+ * @param size    Frame size in bytes
+ * @param offload Offloads requested for the frame
+ */
+errno_t ethip_nic_send_offload(ethip_nic_t *nic, void *data, size_t size,
+    const nic_tx_offload_t *offload)
+{
+	errno_t rc;
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_send_offload(size=%zu)", size);
+	rc = nic_send_frame_offload(nic->sess, data, size, offload);
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "nic_send_frame_offload -> %s",
+	    str_error_name(rc));
+	return rc;
+}
+
 errno_t ethip_nic_send(ethip_nic_t *nic, void *data, size_t size)
 {
 	errno_t rc;
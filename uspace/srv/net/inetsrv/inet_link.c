@@ -34,6 +34,7 @@
  * @brief
  */
 
+#include <align.h>
 #include <stdbool.h>
 #include <errno.h>
 #include <str_error.h>
@@ -46,6 +47,7 @@
 #include "addrobj.h"
 #include "inetsrv.h"
 #include "inet_link.h"
+#include "inet_std.h"
 #include "pdu.h"
 
 static bool first_link = true;
@@ -204,6 +206,11 @@ errno_t inet_link_open(service_id_t sid)
 	rc = iplink_get_mac48(ilink->iplink, &ilink->mac);
 	ilink->mac_valid = (rc == EOK);
 
+	/* Links without offloads do not implement the request */
+	rc = iplink_get_offload(ilink->iplink, &ilink->offload);
+	if (rc != EOK)
+		ilink->offload = 0;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Opened IP link '%s'", ilink->svc_name);
 
 	fibril_mutex_lock(&inet_links_lock);
@@ -296,6 +303,37 @@ error:
 	return rc;
 }
 
+/** Determine whether a TCP segment can be segmented by the link.
+ *
+ * @param ilink Internet link
+ * @param dgram Datagram with partial checksum larger than the MTU
+ * @param proto Protocol
+ *
+ * @return @c true if the link can cut the segment to fit the MTU
+ */
+static bool inet_link_tso_possible(inet_link_t *ilink, inet_dgram_t *dgram,
+    uint8_t proto)
+{
+	size_t hdr_size = sizeof(ip_header_t);
+
+	if (proto != IP_PROTO_TCP || (ilink->offload & IPLINK_OFFLOAD_TSO4) == 0)
+		return false;
+
+	/* The segment must fit into one IPv4 packet */
+	if (hdr_size + dgram->size > UINT16_MAX)
+		return false;
+
+	if (dgram->size <= TCP_DOFF_OFFS)
+		return false;
+
+	uint8_t *tcp_hdr = dgram->data;
+	size_t tcp_hdr_size = (tcp_hdr[TCP_DOFF_OFFS] >> 4) * sizeof(uint32_t);
+
+	/* Each segment must carry some data */
+	return tcp_hdr_size < dgram->size &&
+	    hdr_size + tcp_hdr_size < ilink->def_mtu;
+}
+
 /** Send IPv4 datagram over Internet link
  *
  * @param ilink Internet link
@@ -333,6 +371,37 @@ errno_t inet_link_send_dgram(inet_link_t *ilink, addr32_t lsrc, addr32_t ldest,
 
 	sdu.src = lsrc;
 	sdu.dest = ldest;
+	sdu.csum_start = 0;
+	sdu.csum_offset = 0;
+	sdu.gso_size = 0;
+
+	size_t hdr_size = sizeof(ip_header_t);
+	size_t mtu = ilink->def_mtu;
+
+	if (dgram->csum_partial) {
+		if ((ilink->offload & IPLINK_OFFLOAD_CSUM) == 0 ||
+		    (hdr_size + dgram->size > mtu &&
+		    !inet_link_tso_possible(ilink, dgram, proto))) {
+			/* Complete the checksum before fragmenting */
+			inet_dgram_checksum_complete(dgram, proto);
+		} else {
+			sdu.csum_start = hdr_size;
+			sdu.csum_offset = dgram->csum_offset;
+		}
+	}
+
+	if (sdu.csum_start != 0 && hdr_size + dgram->size > mtu) {
+		/*
+		 * Let the link cut the TCP segment to segments fitting into
+		 * the MTU instead of fragmenting the packet.
+		 */
+		uint8_t *tcp_hdr = dgram->data;
+		size_t tcp_hdr_size = (tcp_hdr[TCP_DOFF_OFFS] >> 4) *
+		    sizeof(uint32_t);
+
+		sdu.gso_size = mtu - hdr_size - tcp_hdr_size;
+		mtu = hdr_size + ALIGN_UP(dgram->size, FRAG_OFFS_UNIT);
+	}
 
 	inet_packet_t packet;
 
@@ -358,7 +427,7 @@ errno_t inet_link_send_dgram(inet_link_t *ilink, addr32_t lsrc, addr32_t ldest,
 		/* Encode one fragment */
 
 		size_t roffs;
-		rc = inet_pdu_encode(&packet, src_v4, dest_v4, offs, ilink->def_mtu,
+		rc = inet_pdu_encode(&packet, src_v4, dest_v4, offs, mtu,
 		    &sdu.data, &sdu.size, &roffs);
 		if (rc != EOK)
 			return rc;
@@ -399,6 +468,10 @@ errno_t inet_link_send_dgram6(inet_link_t *ilink, addr48_t ldest,
 	if (dest_ver != ip_v6)
 		return EINVAL;
 
+	/* IPv6 links have no checksum offload */
+	if (dgram->csum_partial)
+		inet_dgram_checksum_complete(dgram, proto);
+
 	iplink_sdu6_t sdu6;
 	addr48(ldest, sdu6.dest);
 
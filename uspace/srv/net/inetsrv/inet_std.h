@@ -134,6 +134,12 @@ typedef struct {
 /** Fragment offset is expressed in units of 8 bytes */
 #define FRAG_OFFS_UNIT 8
 
+#define IP_PROTO_TCP 6
+#define IP_PROTO_UDP 17
+
+/** Offset of the data offset field within the TCP header */
+#define TCP_DOFF_OFFS 12
+
 #endif
 
 /** @}
@@ -295,6 +295,7 @@ static void inet_send_srv(inet_client_t *client, ipc_call_t *icall)
 
 	uint8_t ttl = ipc_get_arg3(icall);
 	int df = ipc_get_arg4(icall);
+	sysarg_t csum_offset = ipc_get_arg5(icall);
 
 	ipc_call_t call;
 	size_t size;
@@ -341,6 +342,14 @@ static void inet_send_srv(inet_client_t *client, ipc_call_t *icall)
 		return;
 	}
 
+	dgram.csum_partial = (csum_offset != INET_CSUM_NONE);
+	dgram.csum_offset = dgram.csum_partial ? csum_offset : 0;
+	if (dgram.csum_partial && csum_offset + 2 > dgram.size) {
+		free(dgram.data);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
 	rc = inet_send(client, &dgram, client->protocol, ttl, df);
 
 	free(dgram.data);
@@ -525,6 +534,7 @@ errno_t inet_recv_packet(inet_packet_t *packet)
 			dgram.tos = packet->tos;
 			dgram.data = packet->data;
 			dgram.size = packet->size;
+			dgram.csum_partial = false;
 
 			return inet_recv_dgram_local(&dgram, packet->proto);
 		} else {
@@ -110,6 +110,8 @@ typedef struct {
 	size_t def_mtu;
 	addr48_t mac;
 	bool mac_valid;
+	/** Offloads the link performs on sent packets */
+	iplink_offload_t offload;
 } inet_link_t;
 
 typedef struct {
@@ -83,6 +83,27 @@ uint16_t inet_checksum_calc(uint16_t ivalue, void *data, size_t size)
 	return ~sum;
 }
 
+/** Complete partial TCP or UDP checksum of a datagram.
+ *
+ * @param dgram Datagram with the pseudo-header sum in its checksum field
+ * @param proto Protocol
+ */
+void inet_dgram_checksum_complete(inet_dgram_t *dgram, uint8_t proto)
+{
+	uint8_t *field = (uint8_t *) dgram->data + dgram->csum_offset;
+
+	uint16_t checksum = inet_checksum_calc(INET_CHECKSUM_INIT,
+	    dgram->data, dgram->size);
+
+	/* Zero UDP checksum means no checksum, it is sent as all ones */
+	if (checksum == 0 && proto == IP_PROTO_UDP)
+		checksum = 0xffff;
+
+	field[0] = checksum >> 8;
+	field[1] = checksum & 0xff;
+	dgram->csum_partial = false;
+}
+
 /** Encode IPv4 PDU.
  *
  * Encode internet packet into PDU (serialized form). Will encode a
@@ -479,6 +500,7 @@ errno_t ndp_pdu_encode(ndp_packet_t *ndp, inet_dgram_t *dgram)
 	inet_addr_set6(ndp->target_proto_addr, &dgram->dest);
 	dgram->tos = 0;
 	dgram->size = sizeof(icmpv6_message_t) + sizeof(ndp_message_t);
+	dgram->csum_partial = false;
 
 	dgram->data = calloc(1, dgram->size);
 	if (dgram->data == NULL)
@@ -46,6 +46,7 @@
 #define INET_CHECKSUM_INIT 0xffff
 
 extern uint16_t inet_checksum_calc(uint16_t, void *, size_t);
+extern void inet_dgram_checksum_complete(inet_dgram_t *, uint8_t);
 
 extern errno_t inet_pdu_encode(inet_packet_t *, addr32_t, addr32_t, size_t, size_t,
     void **, size_t *, size_t *);
@@ -329,6 +329,7 @@ static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
 	/* XXX What if different fragments came from different link? */
 	dgram.iplink = frag->packet.link_id;
 	dgram.size = dgram_size;
+	dgram.csum_partial = false;
 	dgram.src = frag->packet.src;
 	dgram.dest = frag->packet.dest;
 	dgram.tos = frag->packet.tos;
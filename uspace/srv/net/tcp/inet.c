@@ -40,6 +40,7 @@
 #include <inet/inet.h>
 #include <mem.h>
 #include <io/log.h>
+#include <stddef.h>
 #include <stdlib.h>
 
 #include "inet.h"
@@ -143,6 +144,8 @@ void tcp_transmit_pdu(tcp_pdu_t *pdu)
 	dgram.tos = 0;
 	dgram.data = pdu_raw;
 	dgram.size = pdu_raw_size;
+	dgram.csum_partial = true;
+	dgram.csum_offset = offsetof(tcp_header_t, checksum);
 
 	rc = inet_send(&dgram, INET_TTL_MAX, 0);
 	if (rc != EOK)
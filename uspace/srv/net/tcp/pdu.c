@@ -260,10 +260,14 @@ void tcp_pdu_delete(tcp_pdu_t *pdu)
 	free(pdu);
 }
 
-static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
+/** Compute the partial checksum of a PDU.
+ *
+ * Only the pseudo-header is summed. The sum is stored in the checksum
+ * field and the checksum is completed over the segment when it is sent.
+ */
+static uint16_t tcp_pdu_checksum_partial(tcp_pdu_t *pdu)
 {
 	uint16_t cs_phdr;
-	uint16_t cs_headers;
 	tcp_phdr_t phdr;
 	tcp_phdr6_t phdr6;
 
@@ -281,8 +285,7 @@ static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
 		assert(false);
 	}
 
-	cs_headers = tcp_checksum_calc(cs_phdr, pdu->header, pdu->header_size);
-	return tcp_checksum_calc(cs_headers, pdu->text, pdu->text_size);
+	return ~cs_phdr;
 }
 
 static void tcp_pdu_set_checksum(tcp_pdu_t *pdu, uint16_t checksum)
@@ -348,8 +351,8 @@ errno_t tcp_pdu_encode(inet_ep2_t *epp, tcp_segment_t *seg, tcp_pdu_t **pdu)
 	npdu->text_size = text_size;
 	memcpy(npdu->text, seg->data, text_size);
 
-	/* Checksum calculation */
-	checksum = tcp_pdu_checksum_calc(npdu);
+	/* Checksum calculation, completed by the internet service or NIC */
+	checksum = tcp_pdu_checksum_partial(npdu);
 	tcp_pdu_set_checksum(npdu, checksum);
 
 	*pdu = npdu;
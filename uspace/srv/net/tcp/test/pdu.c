@@ -26,6 +26,7 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <byteorder.h>
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <mem.h>
@@ -35,11 +36,30 @@
 #include "main.h"
 #include "../pdu.h"
 #include "../segment.h"
+#include "../std.h"
 
 PCUT_INIT;
 
 PCUT_TEST_SUITE(pdu);
 
+/** Add data to a one's complement sum of 16-bit words */
+static uint16_t test_ocsum(uint16_t sum, const void *data, size_t size)
+{
+	const uint8_t *bdata = data;
+	uint32_t s = sum;
+	size_t i;
+
+	for (i = 0; i + 1 < size; i += 2)
+		s += ((uint32_t)bdata[i] << 8) | bdata[i + 1];
+	if (size % 2 != 0)
+		s += (uint32_t)bdata[size - 1] << 8;
+
+	while ((s >> 16) != 0)
+		s = (s & 0xffff) + (s >> 16);
+
+	return s;
+}
+
 /** Test encode/decode round trip for control PDU */
 PCUT_TEST(encdec_syn)
 {
@@ -108,4 +128,56 @@ PCUT_TEST(encdec_data)
 	free(data);
 }
 
+/** Test completing the partial checksum of an encoded PDU */
+PCUT_TEST(checksum_partial)
+{
+	tcp_segment_t *seg;
+	tcp_pdu_t *pdu;
+	tcp_header_t *hdr;
+	tcp_phdr_t phdr;
+	inet_ep2_t epp;
+	uint8_t data[15];
+	uint16_t sum;
+	size_t i;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 1, 2, 3, 4);
+	inet_addr(&epp.remote.addr, 5, 6, 7, 8);
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t) i;
+
+	seg = tcp_segment_make_data(CTL_ACK, data, sizeof(data));
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->ack = 19;
+	seg->wnd = 18;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Complete the checksum over the segment, as the sender does */
+	sum = test_ocsum(0, pdu->header, pdu->header_size);
+	sum = test_ocsum(sum, pdu->text, pdu->text_size);
+	hdr = (tcp_header_t *)pdu->header;
+	hdr->checksum = host2uint16_t_be((uint16_t)~sum);
+
+	/* The receiver sums the pseudo-header and segment to all ones */
+	phdr.src = host2uint32_t_be(0x01020304);
+	phdr.dest = host2uint32_t_be(0x05060708);
+	phdr.zero = 0;
+	phdr.protocol = IP_PROTO_TCP;
+	phdr.tcp_length = host2uint16_t_be(pdu->header_size + pdu->text_size);
+
+	sum = test_ocsum(0, &phdr, sizeof(phdr));
+	sum = test_ocsum(sum, pdu->header, pdu->header_size);
+	sum = test_ocsum(sum, pdu->text, pdu->text_size);
+	PCUT_ASSERT_INT_EQUALS(0xffff, sum);
+
+	tcp_pdu_delete(pdu);
+	tcp_segment_delete(seg);
+}
+
 PCUT_EXPORT(pdu);
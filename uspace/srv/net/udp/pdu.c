@@ -129,7 +129,12 @@ void udp_pdu_delete(udp_pdu_t *pdu)
 	free(pdu);
 }
 
-static uint16_t udp_pdu_checksum_calc(udp_pdu_t *pdu)
+/** Compute the partial checksum of a PDU.
+ *
+ * Only the pseudo-header is summed. The sum is stored in the checksum
+ * field and the checksum is completed over the datagram when it is sent.
+ */
+static uint16_t udp_pdu_checksum_partial(udp_pdu_t *pdu)
 {
 	uint16_t cs_phdr;
 	udp_phdr_t phdr;
@@ -149,7 +154,7 @@ static uint16_t udp_pdu_checksum_calc(udp_pdu_t *pdu)
 		assert(false);
 	}
 
-	return udp_checksum_calc(cs_phdr, pdu->data, pdu->data_size);
+	return ~cs_phdr;
 }
 
 static void udp_pdu_set_checksum(udp_pdu_t *pdu, uint16_t checksum)
@@ -238,8 +243,8 @@ errno_t udp_pdu_encode(inet_ep2_t *epp, udp_msg_t *msg, udp_pdu_t **pdu)
 	memcpy((uint8_t *)npdu->data + sizeof(udp_header_t), msg->data,
 	    msg->data_size);
 
-	/* Checksum calculation */
-	checksum = udp_pdu_checksum_calc(npdu);
+	/* Checksum calculation, completed by the internet service or NIC */
+	checksum = udp_pdu_checksum_partial(npdu);
 	udp_pdu_set_checksum(npdu, checksum);
 
 	*pdu = npdu;
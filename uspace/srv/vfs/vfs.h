@@ -191,6 +191,18 @@ extern unsigned vfs_nodes_refcount_sum_get(fs_handle_t, service_id_t);
 
 extern bool vfs_node_has_children(vfs_node_t *node);
 
+extern bool vfs_dcache_init(void);
+extern bool vfs_dcache_enabled(fs_handle_t);
+extern bool vfs_dcache_lookup(vfs_triplet_t *, const char *,
+    vfs_lookup_res_t *, bool *, uint64_t *);
+extern void vfs_dcache_insert(vfs_triplet_t *, const char *,
+    vfs_lookup_res_t *, uint64_t);
+extern void vfs_dcache_invalidate(vfs_triplet_t *, const char *);
+extern void vfs_dcache_purge_dir(vfs_triplet_t *);
+extern void vfs_dcache_purge_fs(fs_handle_t, service_id_t);
+extern void vfs_dcache_size_set(vfs_triplet_t *, aoff64_t);
+extern void vfs_dcache_stat_get(vfs_dcache_stat_t *);
+
 extern void *vfs_client_data_create(void);
 extern void vfs_client_data_destroy(void *);
 
@@ -208,12 +220,14 @@ extern void vfs_node_delref(vfs_node_t *);
 extern errno_t vfs_open_node_remote(vfs_node_t *);
 
 extern errno_t vfs_op_clone(int oldfd, int newfd, bool desc, int *);
+extern errno_t vfs_op_copy_range(int, int, vfs_copy_range_t *, aoff64_t *);
 extern errno_t vfs_op_fsprobe(const char *, service_id_t, vfs_fs_probe_info_t *);
 extern errno_t vfs_op_mount(int mpfd, unsigned servid, unsigned flags, unsigned instance, const char *opts, const char *fsname, int *outfd);
 extern errno_t vfs_op_mtab_get(void);
 extern errno_t vfs_op_open(int fd, int flags);
 extern errno_t vfs_op_put(int fd);
 extern errno_t vfs_op_read(int fd, aoff64_t, size_t *out_bytes);
+extern errno_t vfs_op_readdir(int fd, aoff64_t, size_t *, aoff64_t *);
 extern errno_t vfs_op_rename(int basefd, char *old, char *new);
 extern errno_t vfs_op_resize(int fd, int64_t size);
 extern errno_t vfs_op_stat(int fd);
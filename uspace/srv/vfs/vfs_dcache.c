@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file	vfs_dcache.c
+ * @brief	Directory entry cache.
+ *
+ * The cache remembers the results of looking up a single name in a directory,
+ * so that path lookups can be resolved inside VFS without asking the file
+ * system server. Positive entries map a name to the node it refers to,
+ * negative entries remember that the name does not exist.
+ *
+ * The namespace of a file system is only modified through VFS, so VFS can keep
+ * the cache coherent by invalidating the entries affected by link, unlink,
+ * rename and unmount. File systems whose namespace changes on its own (e.g.
+ * locfs) do not set vfs_info_t.cache_names and are not cached.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <str.h>
+
+/** Maximum number of cached entries */
+#define DCACHE_MAX_ENTRIES	1024
+
+typedef struct {
+	/** Link to dcache */
+	ht_link_t link;
+	/** Link to dcache_by_node (positive entries only) */
+	ht_link_t node_link;
+	/** Link to dcache_lru */
+	link_t lru_link;
+
+	/** Directory containing the name */
+	vfs_triplet_t parent;
+	char *name;
+
+	/** True if the name exists */
+	bool positive;
+	/** Node the name refers to (only valid if the entry is positive) */
+	vfs_lookup_res_t res;
+} dentry_t;
+
+typedef struct {
+	const vfs_triplet_t *parent;
+	const char *name;
+} dentry_key_t;
+
+static FIBRIL_MUTEX_INITIALIZE(dcache_lock);
+
+/** Entries by parent directory and name */
+static hash_table_t dcache;
+/** Positive entries by the node they refer to */
+static hash_table_t dcache_by_node;
+/** Entries in least recently used order */
+static LIST_INITIALIZE(dcache_lru);
+
+/**
+ * Incremented whenever entries are invalidated. A lookup result obtained from
+ * the file system is only inserted if no invalidation has happened since the
+ * lookup started, otherwise a concurrent creation of the name could be
+ * overwritten with a stale negative entry.
+ */
+static uint64_t dcache_seq;
+
+static vfs_dcache_stat_t dcache_stat;
+
+static size_t triplet_hash(const vfs_triplet_t *tri)
+{
+	size_t hash = hash_combine(tri->fs_handle, tri->index);
+	return hash_combine(hash, tri->service_id);
+}
+
+static bool triplet_equal(const vfs_triplet_t *a, const vfs_triplet_t *b)
+{
+	return a->fs_handle == b->fs_handle &&
+	    a->service_id == b->service_id && a->index == b->index;
+}
+
+static size_t name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash * 31 + (uint8_t) *name++;
+
+	return hash_mix(hash);
+}
+
+static size_t dcache_key_hash(const void *key)
+{
+	const dentry_key_t *dkey = key;
+	return hash_combine(triplet_hash(dkey->parent), name_hash(dkey->name));
+}
+
+static size_t dcache_hash(const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, link);
+	dentry_key_t key = {
+		.parent = &dentry->parent,
+		.name = dentry->name
+	};
+
+	return dcache_key_hash(&key);
+}
+
+static bool dcache_key_equal(const void *key, const ht_link_t *item)
+{
+	const dentry_key_t *dkey = key;
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, link);
+	return triplet_equal(dkey->parent, &dentry->parent) &&
+	    str_cmp(dkey->name, dentry->name) == 0;
+}
+
+static hash_table_ops_t dcache_ops = {
+	.hash = dcache_hash,
+	.key_hash = dcache_key_hash,
+	.key_equal = dcache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static size_t dcache_node_key_hash(const void *key)
+{
+	return triplet_hash(key);
+}
+
+static size_t dcache_node_hash(const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, node_link);
+	return triplet_hash(&dentry->res.triplet);
+}
+
+static bool dcache_node_key_equal(const void *key, const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, node_link);
+	return triplet_equal(key, &dentry->res.triplet);
+}
+
+static bool dcache_node_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	dentry_t *dentry1 = hash_table_get_inst(item1, dentry_t, node_link);
+	dentry_t *dentry2 = hash_table_get_inst(item2, dentry_t, node_link);
+	return triplet_equal(&dentry1->res.triplet, &dentry2->res.triplet);
+}
+
+static hash_table_ops_t dcache_node_ops = {
+	.hash = dcache_node_hash,
+	.key_hash = dcache_node_key_hash,
+	.key_equal = dcache_node_key_equal,
+	.equal = dcache_node_equal,
+	.remove_callback = NULL
+};
+
+/** Initialize the directory entry cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_dcache_init(void)
+{
+	if (!hash_table_create(&dcache, 0, 0, &dcache_ops))
+		return false;
+
+	if (!hash_table_create(&dcache_by_node, 0, 0, &dcache_node_ops)) {
+		hash_table_destroy(&dcache);
+		return false;
+	}
+
+	return true;
+}
+
+/** Check whether names of a file system can be cached.
+ *
+ * @param fs_handle	File system handle.
+ *
+ * @return		True if the file system allows caching of names.
+ */
+bool vfs_dcache_enabled(fs_handle_t fs_handle)
+{
+	vfs_info_t *info = fs_handle_to_info(fs_handle);
+	return info != NULL && info->cache_names;
+}
+
+static void dentry_remove(dentry_t *dentry)
+{
+	hash_table_remove_item(&dcache, &dentry->link);
+	if (dentry->positive)
+		hash_table_remove_item(&dcache_by_node, &dentry->node_link);
+	list_remove(&dentry->lru_link);
+
+	free(dentry->name);
+	free(dentry);
+}
+
+static dentry_t *dentry_find(const vfs_triplet_t *parent, const char *name)
+{
+	dentry_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	ht_link_t *link = hash_table_find(&dcache, &key);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, dentry_t, link);
+}
+
+/** Look up a name in the directory entry cache.
+ *
+ * @param parent	Directory containing the name.
+ * @param name		Name to look up.
+ * @param[out] res	Node the name refers to if the entry is positive.
+ * @param[out] positive	Whether the entry is positive.
+ * @param[out] seq	Sequence number to pass to vfs_dcache_insert() if the
+ *			name was not found.
+ *
+ * @return		True if the name was found in the cache.
+ */
+bool vfs_dcache_lookup(vfs_triplet_t *parent, const char *name,
+    vfs_lookup_res_t *res, bool *positive, uint64_t *seq)
+{
+	fibril_mutex_lock(&dcache_lock);
+
+	dentry_t *dentry = dentry_find(parent, name);
+	if (dentry == NULL) {
+		*seq = dcache_seq;
+		dcache_stat.misses++;
+		fibril_mutex_unlock(&dcache_lock);
+		return false;
+	}
+
+	/* Move the entry to the end of the LRU list. */
+	list_remove(&dentry->lru_link);
+	list_append(&dentry->lru_link, &dcache_lru);
+
+	*positive = dentry->positive;
+	if (dentry->positive) {
+		*res = dentry->res;
+		dcache_stat.hits++;
+	} else {
+		dcache_stat.neg_hits++;
+	}
+
+	fibril_mutex_unlock(&dcache_lock);
+	return true;
+}
+
+/** Insert a lookup result into the directory entry cache.
+ *
+ * @param parent	Directory containing the name.
+ * @param name		Name that was looked up.
+ * @param res		Node the name refers to or NULL if the name does not
+ *			exist.
+ * @param seq		Sequence number returned by vfs_dcache_lookup().
+ */
+void vfs_dcache_insert(vfs_triplet_t *parent, const char *name,
+    vfs_lookup_res_t *res, uint64_t seq)
+{
+	if (!vfs_dcache_enabled(parent->fs_handle))
+		return;
+
+	/* Crossing to a different file system is not a directory entry. */
+	if (res != NULL && (res->triplet.fs_handle != parent->fs_handle ||
+	    res->triplet.service_id != parent->service_id))
+		return;
+
+	dentry_t *dentry = malloc(sizeof(dentry_t));
+	if (dentry == NULL)
+		return;
+
+	dentry->name = str_dup(name);
+	if (dentry->name == NULL) {
+		free(dentry);
+		return;
+	}
+
+	dentry->parent = *parent;
+	dentry->positive = (res != NULL);
+	if (res != NULL)
+		dentry->res = *res;
+
+	fibril_mutex_lock(&dcache_lock);
+
+	if (seq != dcache_seq) {
+		/* The namespace may have changed since the lookup. */
+		fibril_mutex_unlock(&dcache_lock);
+		free(dentry->name);
+		free(dentry);
+		return;
+	}
+
+	/* Replace an existing entry. */
+	dentry_t *old = dentry_find(parent, name);
+	if (old != NULL)
+		dentry_remove(old);
+
+	if (hash_table_size(&dcache) >= DCACHE_MAX_ENTRIES) {
+		dentry_t *lru = list_get_instance(list_first(&dcache_lru),
+		    dentry_t, lru_link);
+		dentry_remove(lru);
+		dcache_stat.evictions++;
+	}
+
+	hash_table_insert(&dcache, &dentry->link);
+	if (dentry->positive)
+		hash_table_insert(&dcache_by_node, &dentry->node_link);
+	list_append(&dentry->lru_link, &dcache_lru);
+
+	fibril_mutex_unlock(&dcache_lock);
+}
+
+/** Invalidate the cached entry for a name.
+ *
+ * @param parent	Directory containing the name.
+ * @param name		Name that was linked or unlinked.
+ */
+void vfs_dcache_invalidate(vfs_triplet_t *parent, const char *name)
+{
+	fibril_mutex_lock(&dcache_lock);
+
+	dcache_seq++;
+
+	dentry_t *dentry = dentry_find(parent, name);
+	if (dentry != NULL) {
+		dentry_remove(dentry);
+		dcache_stat.invalidations++;
+	}
+
+	fibril_mutex_unlock(&dcache_lock);
+}
+
+/** Invalidate all cached entries of a directory.
+ *
+ * This is used when the directory is removed, because the file system may
+ * reuse its index for a new node.
+ *
+ * @param parent	Removed directory.
+ */
+void vfs_dcache_purge_dir(vfs_triplet_t *parent)
+{
+	fibril_mutex_lock(&dcache_lock);
+
+	dcache_seq++;
+
+	list_foreach_safe(dcache_lru, cur, next) {
+		dentry_t *dentry = list_get_instance(cur, dentry_t, lru_link);
+		if (triplet_equal(&dentry->parent, parent)) {
+			dentry_remove(dentry);
+			dcache_stat.invalidations++;
+		}
+	}
+
+	fibril_mutex_unlock(&dcache_lock);
+}
+
+/** Invalidate all cached entries of a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ */
+void vfs_dcache_purge_fs(fs_handle_t fs_handle, service_id_t service_id)
+{
+	fibril_mutex_lock(&dcache_lock);
+
+	dcache_seq++;
+
+	list_foreach_safe(dcache_lru, cur, next) {
+		dentry_t *dentry = list_get_instance(cur, dentry_t, lru_link);
+		if (dentry->parent.fs_handle == fs_handle &&
+		    dentry->parent.service_id == service_id) {
+			dentry_remove(dentry);
+			dcache_stat.invalidations++;
+		}
+	}
+
+	fibril_mutex_unlock(&dcache_lock);
+}
+
+/** Update the size of a node in all positive entries that refer to it.
+ *
+ * @param node		Node whose size has changed.
+ * @param size		New size of the node.
+ */
+void vfs_dcache_size_set(vfs_triplet_t *node, aoff64_t size)
+{
+	fibril_mutex_lock(&dcache_lock);
+
+	ht_link_t *first = hash_table_find(&dcache_by_node, node);
+	ht_link_t *link = first;
+	while (link != NULL) {
+		dentry_t *dentry = hash_table_get_inst(link, dentry_t,
+		    node_link);
+		dentry->res.size = size;
+		link = hash_table_find_next(&dcache_by_node, first, link);
+	}
+
+	fibril_mutex_unlock(&dcache_lock);
+}
+
+/** Get statistics of the directory entry cache.
+ *
+ * @param[out] stat	Place to store the statistics.
+ */
+void vfs_dcache_stat_get(vfs_dcache_stat_t *stat)
+{
+	fibril_mutex_lock(&dcache_lock);
+	*stat = dcache_stat;
+	stat->entries = hash_table_size(&dcache);
+	stat->capacity = DCACHE_MAX_ENTRIES;
+	fibril_mutex_unlock(&dcache_lock);
+}
+
+/**
+ * @}
+ */
@@ -45,6 +45,25 @@ static void vfs_in_clone(ipc_call_t *req)
 	async_answer_1(req, rc, outfd);
 }
 
+static void vfs_in_copy_range(ipc_call_t *req)
+{
+	int src_fd = ipc_get_arg1(req);
+	int dst_fd = ipc_get_arg2(req);
+	vfs_copy_range_t *range = NULL;
+
+	errno_t rc = async_data_write_accept((void **) &range, false,
+	    sizeof(vfs_copy_range_t), sizeof(vfs_copy_range_t), 0, NULL);
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		return;
+	}
+
+	aoff64_t copied = 0;
+	rc = vfs_op_copy_range(src_fd, dst_fd, range, &copied);
+	free(range);
+	async_answer_2(req, rc, LOWER32(copied), UPPER32(copied));
+}
+
 static void vfs_in_fsprobe(ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
@@ -82,6 +101,25 @@ out:
 	free(fs_name);
 }
 
+static void vfs_in_dcache_stat(ipc_call_t *req)
+{
+	vfs_dcache_stat_t stat;
+	vfs_dcache_stat_get(&stat);
+
+	ipc_call_t call;
+	size_t len;
+	if (!async_data_read_receive(&call, &len)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	if (len > sizeof(stat))
+		len = sizeof(stat);
+	errno_t rc = async_data_read_finalize(&call, &stat, len);
+	async_answer_0(req, rc);
+}
+
 static void vfs_in_fstypes(ipc_call_t *req)
 {
 	vfs_fstypes_t fstypes;
@@ -183,6 +221,18 @@ static void vfs_in_read(ipc_call_t *req)
 	async_answer_1(req, rc, bytes);
 }
 
+static void vfs_in_readdir(ipc_call_t *req)
+{
+	int fd = ipc_get_arg1(req);
+	aoff64_t pos = MERGE_LOUP32(ipc_get_arg2(req),
+	    ipc_get_arg3(req));
+
+	size_t bytes = 0;
+	aoff64_t npos = pos;
+	errno_t rc = vfs_op_readdir(fd, pos, &bytes, &npos);
+	async_answer_3(req, rc, bytes, LOWER32(npos), UPPER32(npos));
+}
+
 static void vfs_in_rename(ipc_call_t *req)
 {
 	/* The common base directory. */
@@ -338,6 +388,12 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_CLONE:
 			vfs_in_clone(&call);
 			break;
+		case VFS_IN_COPY_RANGE:
+			vfs_in_copy_range(&call);
+			break;
+		case VFS_IN_DCACHE_STAT:
+			vfs_in_dcache_stat(&call);
+			break;
 		case VFS_IN_FSPROBE:
 			vfs_in_fsprobe(&call);
 			break;
@@ -356,6 +412,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_READ:
 			vfs_in_read(&call);
 			break;
+		case VFS_IN_READDIR:
+			vfs_in_readdir(&call);
+			break;
 		case VFS_IN_REGISTER:
 			vfs_register(&call);
 			cont = false;
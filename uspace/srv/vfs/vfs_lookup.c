@@ -202,6 +202,9 @@ errno_t vfs_link_internal(vfs_node_t *base, char *path, vfs_triplet_t *child)
 	if (orig_rc != EOK)
 		rc = orig_rc;
 
+	/* Drop a negative entry for the new name. */
+	vfs_dcache_invalidate(triplet, component);
+
 out:
 	return rc;
 }
@@ -237,6 +240,139 @@ static errno_t out_lookup(vfs_triplet_t *base, size_t *pfirst, size_t *plen,
 	return EOK;
 }
 
+/** Cross the mount points stacked on top of a node.
+ *
+ * @param res     Node to cross. On return it holds the root of the topmost
+ *                mounted file system.
+ * @param lflag   Flags to be used during lookup.
+ *
+ * @return EOK on success, EXDEV if a mount point should be crossed but
+ *         L_DISABLE_MOUNTS is set.
+ */
+static errno_t lookup_cross_mounts(vfs_lookup_res_t *res, int lflag)
+{
+	vfs_node_t *node = vfs_node_peek(res);
+	if (!node)
+		return EOK;
+
+	if (node->mount && (lflag & L_DISABLE_MOUNTS)) {
+		vfs_node_put(node);
+		return EXDEV;
+	}
+
+	while (node->mount) {
+		vfs_node_addref(node->mount);
+		vfs_node_t *nnode = node->mount;
+		vfs_node_put(node);
+		node = nnode;
+	}
+
+	res->triplet = *((vfs_triplet_t *) node);
+	res->type = node->type;
+	res->size = node->size;
+	vfs_node_put(node);
+	return EOK;
+}
+
+/** Resolve the next path component.
+ *
+ * Components in file systems which allow caching of names are resolved one at
+ * a time through the directory entry cache. Otherwise the rest of the path is
+ * passed to the file system, which resolves as much of it as it can.
+ *
+ * @param res     Directory in which the component is looked up. On return it
+ *                holds the node the component resolves to.
+ * @param path    Path being resolved.
+ * @param first   Index of the first character of the path in PLB.
+ * @param ppos    Offset of the slash preceding the component in the path. On
+ *                return it holds the offset of the unresolved rest of the path.
+ * @param len     Length of the path.
+ * @param lflag   Flags to be used during lookup.
+ *
+ * @return EOK on success or an error code from errno.h.
+ */
+static errno_t lookup_component(vfs_lookup_res_t *res, const char *path,
+    size_t first, size_t *ppos, size_t len, int lflag)
+{
+	vfs_triplet_t parent = res->triplet;
+	char component[NAME_MAX + 1];
+	size_t pos = *ppos;
+	size_t clen = 0;
+	errno_t rc;
+
+	assert(path[pos] == '/');
+
+	while (pos + 1 + clen < len && path[pos + 1 + clen] != '/') {
+		if (clen == NAME_MAX)
+			return ENAMETOOLONG;
+		component[clen] = path[pos + 1 + clen];
+		clen++;
+	}
+	component[clen] = 0;
+
+	bool last = (pos + 1 + clen == len);
+
+	if (clen == 0 || (lflag & (L_CREATE | L_UNLINK)) ||
+	    !vfs_dcache_enabled(parent.fs_handle)) {
+		size_t next = first + pos;
+		size_t nlen = len - pos;
+
+		rc = out_lookup(&parent, &next, &nlen, lflag, res);
+		if (rc != EOK)
+			return rc;
+
+		if (nlen > 0) {
+			/* Only a mount point lets us continue. */
+			vfs_node_t *node = vfs_node_peek(res);
+			if (!node)
+				return ENOENT;
+			bool mp = (node->mount != NULL);
+			vfs_node_put(node);
+			if (!mp)
+				return ENOENT;
+		} else if (last && (lflag & (L_CREATE | L_UNLINK))) {
+			/* Drop the entry for the created or removed name. */
+			vfs_dcache_invalidate(&parent, component);
+			if ((lflag & L_UNLINK) &&
+			    res->type == VFS_NODE_DIRECTORY)
+				vfs_dcache_purge_dir(&res->triplet);
+		}
+
+		*ppos = len - nlen;
+		return EOK;
+	}
+
+	bool positive;
+	uint64_t seq;
+	if (!vfs_dcache_lookup(&parent, component, res, &positive, &seq)) {
+		size_t next = first + pos;
+		size_t nlen = 1 + clen;
+
+		/* The type of the node is checked below. */
+		rc = out_lookup(&parent, &next, &nlen,
+		    lflag & ~(L_FILE | L_DIRECTORY), res);
+		if (rc != EOK)
+			return rc;
+
+		positive = (nlen == 0);
+		vfs_dcache_insert(&parent, component, positive ? res : NULL,
+		    seq);
+	}
+
+	if (!positive)
+		return ENOENT;
+
+	if (!last && res->type != VFS_NODE_DIRECTORY)
+		return ENOTDIR;
+	if (last && (lflag & L_FILE) && res->type == VFS_NODE_DIRECTORY)
+		return EISDIR;
+	if (last && (lflag & L_DIRECTORY) && res->type == VFS_NODE_FILE)
+		return ENOTDIR;
+
+	*ppos = pos + 1 + clen;
+	return EOK;
+}
+
 static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
     vfs_lookup_res_t *result, size_t len)
 {
@@ -248,69 +384,32 @@ static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 	if (rc != EOK)
 		return rc;
 
-	size_t next = first;
-	size_t nlen = len;
+	size_t pos = 0;
 
 	vfs_lookup_res_t res;
+	res.triplet = *((vfs_triplet_t *) base);
+	res.type = base->type;
+	res.size = base->size;
 
-	/* Resolve path as long as there are mount points to cross. */
-	while (nlen > 0) {
-		while (base->mount) {
-			if (lflag & L_DISABLE_MOUNTS) {
-				rc = EXDEV;
-				goto out;
-			}
-
-			base = base->mount;
-		}
-
-		rc = out_lookup((vfs_triplet_t *) base, &next, &nlen, lflag,
-		    &res);
+	/* Resolve path, crossing mount points on the way. */
+	while (pos < len) {
+		rc = lookup_cross_mounts(&res, lflag);
 		if (rc != EOK)
 			goto out;
 
-		if (nlen > 0) {
-			base = vfs_node_peek(&res);
-			if (!base) {
-				rc = ENOENT;
-				goto out;
-			}
-			if (!base->mount) {
-				vfs_node_put(base);
-				rc = ENOENT;
-				goto out;
-			}
-			vfs_node_put(base);
-			if (lflag & L_DISABLE_MOUNTS) {
-				rc = EXDEV;
-				goto out;
-			}
-		}
+		rc = lookup_component(&res, path, first, &pos, len, lflag);
+		if (rc != EOK)
+			goto out;
 	}
 
-	assert(nlen == 0);
 	rc = EOK;
 
 	if (result != NULL) {
 		/* The found file may be a mount point. Try to cross it. */
 		if (!(lflag & (L_MP | L_DISABLE_MOUNTS))) {
-			base = vfs_node_peek(&res);
-			if (base && base->mount) {
-				while (base->mount) {
-					vfs_node_addref(base->mount);
-					vfs_node_t *nbase = base->mount;
-					vfs_node_put(base);
-					base = nbase;
-				}
-
-				result->triplet = *((vfs_triplet_t *) base);
-				result->type = base->type;
-				result->size = base->size;
-				vfs_node_put(base);
+			rc = lookup_cross_mounts(&res, lflag);
+			if (rc != EOK)
 				goto out;
-			}
-			if (base)
-				vfs_node_put(base);
 		}
 
 		*result = res;
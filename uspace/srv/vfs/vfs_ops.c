@@ -348,10 +348,10 @@ errno_t vfs_op_open(int fd, int mode)
 	return EOK;
 }
 
-typedef errno_t (*rdwr_ipc_cb_t)(async_exch_t *, vfs_file_t *, aoff64_t,
+typedef errno_t (*rdwr_ipc_cb_t)(async_exch_t *, vfs_node_t *, aoff64_t,
     ipc_call_t *, bool, void *);
 
-static errno_t rdwr_ipc_client(async_exch_t *exch, vfs_file_t *file, aoff64_t pos,
+static errno_t rdwr_ipc_client(async_exch_t *exch, vfs_node_t *node, aoff64_t pos,
     ipc_call_t *answer, bool read, void *data)
 {
 	size_t *bytes = (size_t *) data;
@@ -367,11 +367,11 @@ static errno_t rdwr_ipc_client(async_exch_t *exch, vfs_file_t *file, aoff64_t po
 
 	if (read) {
 		rc = async_data_read_forward_4_1(exch, VFS_OUT_READ,
-		    file->node->service_id, file->node->index,
+		    node->service_id, node->index,
 		    LOWER32(pos), UPPER32(pos), answer);
 	} else {
 		rc = async_data_write_forward_4_1(exch, VFS_OUT_WRITE,
-		    file->node->service_id, file->node->index,
+		    node->service_id, node->index,
 		    LOWER32(pos), UPPER32(pos), answer);
 	}
 
@@ -379,7 +379,7 @@ static errno_t rdwr_ipc_client(async_exch_t *exch, vfs_file_t *file, aoff64_t po
 	return rc;
 }
 
-static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t pos,
+static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_node_t *node, aoff64_t pos,
     ipc_call_t *answer, bool read, void *data)
 {
 	rdwr_io_chunk_t *chunk = (rdwr_io_chunk_t *) data;
@@ -388,12 +388,16 @@ static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t
 		return ENOENT;
 
 	aid_t msg = async_send_4(exch, read ? VFS_OUT_READ : VFS_OUT_WRITE,
-	    file->node->service_id, file->node->index, LOWER32(pos),
+	    node->service_id, node->index, LOWER32(pos),
 	    UPPER32(pos), answer);
 	if (msg == 0)
 		return EINVAL;
 
-	errno_t retval = async_data_read_start(exch, chunk->buffer, chunk->size);
+	errno_t retval;
+	if (read)
+		retval = async_data_read_start(exch, chunk->buffer, chunk->size);
+	else
+		retval = async_data_write_start(exch, chunk->buffer, chunk->size);
 	if (retval != EOK) {
 		async_forget(msg);
 		return retval;
@@ -407,30 +411,10 @@ static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t
 	return (errno_t) rc;
 }
 
-static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
-    void *ipc_cb_data)
+static errno_t vfs_rdwr_node(vfs_node_t *node, bool append, aoff64_t pos,
+    bool read, rdwr_ipc_cb_t ipc_cb, void *ipc_cb_data)
 {
-	/*
-	 * The following code strongly depends on the fact that the files data
-	 * structure can be only accessed by a single fibril and all file
-	 * operations are serialized (i.e. the reads and writes cannot
-	 * interleave and a file cannot be closed while it is being read).
-	 *
-	 * Additional synchronization needs to be added once the table of
-	 * open files supports parallel access!
-	 */
-
-	/* Lookup the file structure corresponding to the file descriptor. */
-	vfs_file_t *file = vfs_file_get(fd);
-	if (!file)
-		return EBADF;
-
-	if ((read && !file->open_read) || (!read && !file->open_write)) {
-		vfs_file_put(file);
-		return EINVAL;
-	}
-
-	vfs_info_t *fs_info = fs_handle_to_info(file->node->fs_handle);
+	vfs_info_t *fs_info = fs_handle_to_info(node->fs_handle);
 	assert(fs_info);
 
 	bool rlock = read ||
@@ -442,11 +426,11 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 	 * write implementation does not modify the file size.
 	 */
 	if (rlock)
-		fibril_rwlock_read_lock(&file->node->contents_rwlock);
+		fibril_rwlock_read_lock(&node->contents_rwlock);
 	else
-		fibril_rwlock_write_lock(&file->node->contents_rwlock);
+		fibril_rwlock_write_lock(&node->contents_rwlock);
 
-	if (file->node->type == VFS_NODE_DIRECTORY) {
+	if (node->type == VFS_NODE_DIRECTORY) {
 		/*
 		 * Make sure that no one is modifying the namespace
 		 * while we are in readdir().
@@ -455,48 +439,102 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 		if (!read) {
 			if (rlock) {
 				fibril_rwlock_read_unlock(
-				    &file->node->contents_rwlock);
+				    &node->contents_rwlock);
 			} else {
 				fibril_rwlock_write_unlock(
-				    &file->node->contents_rwlock);
+				    &node->contents_rwlock);
 			}
-			vfs_file_put(file);
 			return EINVAL;
 		}
 
 		fibril_rwlock_read_lock(&namespace_rwlock);
 	}
 
-	async_exch_t *fs_exch = vfs_exchange_grab(file->node->fs_handle);
+	async_exch_t *fs_exch = vfs_exchange_grab(node->fs_handle);
 
-	if (!read && file->append)
-		pos = file->node->size;
+	if (!read && append)
+		pos = node->size;
 
 	/*
 	 * Handle communication with the endpoint FS.
 	 */
 	ipc_call_t answer;
-	errno_t rc = ipc_cb(fs_exch, file, pos, &answer, read, ipc_cb_data);
+	errno_t rc = ipc_cb(fs_exch, node, pos, &answer, read, ipc_cb_data);
 
 	vfs_exchange_release(fs_exch);
 
-	if (file->node->type == VFS_NODE_DIRECTORY)
+	if (node->type == VFS_NODE_DIRECTORY)
 		fibril_rwlock_read_unlock(&namespace_rwlock);
 
 	/* Unlock the VFS node. */
 	if (rlock) {
-		fibril_rwlock_read_unlock(&file->node->contents_rwlock);
+		fibril_rwlock_read_unlock(&node->contents_rwlock);
 	} else {
 		/* Update the cached version of node's size. */
 		if (rc == EOK) {
-			file->node->size = MERGE_LOUP32(ipc_get_arg2(&answer),
+			node->size = MERGE_LOUP32(ipc_get_arg2(&answer),
 			    ipc_get_arg3(&answer));
+			vfs_dcache_size_set((vfs_triplet_t *) node,
+			    node->size);
 		}
-		fibril_rwlock_write_unlock(&file->node->contents_rwlock);
+		fibril_rwlock_write_unlock(&node->contents_rwlock);
 	}
 
+	return rc;
+}
+
+/** Get the node of an open file.
+ *
+ * @param fd		File descriptor.
+ * @param read		The file is going to be read.
+ * @param write		The file is going to be written.
+ * @param append	Place to store the append mode of the file or NULL.
+ * @param rc		Place to store the error code on failure.
+ *
+ * @return		Node of the file with an added reference or NULL
+ *			if the file is not open for the requested access.
+ */
+static vfs_node_t *vfs_file_node_get(int fd, bool read, bool write,
+    bool *append, errno_t *rc)
+{
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file) {
+		*rc = EBADF;
+		return NULL;
+	}
+
+	if ((read && !file->open_read) || (write && !file->open_write)) {
+		vfs_file_put(file);
+		*rc = EINVAL;
+		return NULL;
+	}
+
+	vfs_node_t *node = file->node;
+	if (append != NULL)
+		*append = file->append;
+
+	vfs_node_addref(node);
 	vfs_file_put(file);
+	return node;
+}
 
+static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
+    void *ipc_cb_data)
+{
+	/*
+	 * Every request carries its own position, so nothing in the file
+	 * structure is needed beyond the node. Keep only a reference to the
+	 * node and let go of the file, so that further requests on the same
+	 * file descriptor need not wait for this one to finish.
+	 */
+	bool append;
+	errno_t rc;
+	vfs_node_t *node = vfs_file_node_get(fd, read, !read, &append, &rc);
+	if (node == NULL)
+		return rc;
+
+	rc = vfs_rdwr_node(node, append, pos, read, ipc_cb, ipc_cb_data);
+	vfs_node_delref(node);
 	return rc;
 }
 
@@ -505,11 +543,219 @@ errno_t vfs_rdwr_internal(int fd, aoff64_t pos, bool read, rdwr_io_chunk_t *chun
 	return vfs_rdwr(fd, pos, read, rdwr_ipc_internal, chunk);
 }
 
+/** Let the file system copy a range between two of its files. */
+static errno_t vfs_copy_range_native(vfs_node_t *src, vfs_node_t *dst,
+    vfs_copy_range_t *range, aoff64_t *copied)
+{
+	/* Lock the nodes in a fixed order so that two copies cannot deadlock. */
+	if (src == dst) {
+		fibril_rwlock_write_lock(&dst->contents_rwlock);
+	} else if (src < dst) {
+		fibril_rwlock_read_lock(&src->contents_rwlock);
+		fibril_rwlock_write_lock(&dst->contents_rwlock);
+	} else {
+		fibril_rwlock_write_lock(&dst->contents_rwlock);
+		fibril_rwlock_read_lock(&src->contents_rwlock);
+	}
+
+	async_exch_t *exch = vfs_exchange_grab(dst->fs_handle);
+
+	ipc_call_t answer;
+	aid_t req = async_send_3(exch, VFS_OUT_COPY_RANGE, dst->service_id,
+	    src->index, dst->index, &answer);
+	errno_t rc = async_data_write_start(exch, range, sizeof(*range));
+	if (rc == EOK)
+		async_wait_for(req, &rc);
+	else
+		async_forget(req);
+
+	vfs_exchange_release(exch);
+
+	if (rc == EOK) {
+		*copied = MERGE_LOUP32(ipc_get_arg1(&answer),
+		    ipc_get_arg2(&answer));
+		dst->size = MERGE_LOUP32(ipc_get_arg3(&answer),
+		    ipc_get_arg4(&answer));
+		vfs_dcache_size_set((vfs_triplet_t *) dst, dst->size);
+	}
+
+	fibril_rwlock_write_unlock(&dst->contents_rwlock);
+	if (src != dst)
+		fibril_rwlock_read_unlock(&src->contents_rwlock);
+
+	return rc;
+}
+
+/** Copy a range by reading it from one file and writing it to the other. */
+static errno_t vfs_copy_range_stream(vfs_node_t *src, vfs_node_t *dst,
+    vfs_copy_range_t *range, aoff64_t *copied)
+{
+	uint8_t *buf = malloc(DATA_XFER_LIMIT);
+	if (buf == NULL)
+		return ENOMEM;
+
+	aoff64_t done = 0;
+	errno_t rc = EOK;
+
+	while (done < range->size) {
+		rdwr_io_chunk_t chunk = {
+			.buffer = buf,
+			.size = min(DATA_XFER_LIMIT, range->size - done)
+		};
+
+		rc = vfs_rdwr_node(src, false, range->src_pos + done, true,
+		    rdwr_ipc_internal, &chunk);
+		if (rc != EOK || chunk.size == 0)
+			break;
+
+		size_t nread = chunk.size;
+		size_t nwritten = 0;
+		while (nwritten < nread) {
+			chunk.buffer = buf + nwritten;
+			chunk.size = nread - nwritten;
+
+			rc = vfs_rdwr_node(dst, false,
+			    range->dst_pos + done + nwritten, false,
+			    rdwr_ipc_internal, &chunk);
+			if (rc == EOK && chunk.size == 0)
+				rc = EIO;
+			if (rc != EOK)
+				break;
+
+			nwritten += chunk.size;
+		}
+
+		done += nwritten;
+		if (rc != EOK)
+			break;
+	}
+
+	free(buf);
+	*copied = done;
+	return rc;
+}
+
+/** Copy a range of bytes between files.
+ *
+ * Files on the same file system instance are copied by the file system
+ * itself if it supports that. Otherwise, the data are streamed through VFS
+ * from one file system server to the other, the client is not involved
+ * either way.
+ *
+ * @param src_fd	Handle of the file to copy from.
+ * @param dst_fd	Handle of the file to copy to.
+ * @param range		Positions in the files and size of the range.
+ * @param out_copied	Place to store the number of bytes copied.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t vfs_op_copy_range(int src_fd, int dst_fd, vfs_copy_range_t *range,
+    aoff64_t *out_copied)
+{
+	errno_t rc;
+
+	vfs_node_t *src = vfs_file_node_get(src_fd, true, false, NULL, &rc);
+	if (src == NULL)
+		return rc;
+
+	vfs_node_t *dst = vfs_file_node_get(dst_fd, false, true, NULL, &rc);
+	if (dst == NULL) {
+		vfs_node_delref(src);
+		return rc;
+	}
+
+	rc = EOK;
+	if ((src->type == VFS_NODE_DIRECTORY) ||
+	    (dst->type == VFS_NODE_DIRECTORY))
+		rc = EINVAL;
+
+	if ((range->size > UINT64_MAX - range->src_pos) ||
+	    (range->size > UINT64_MAX - range->dst_pos))
+		rc = EINVAL;
+
+	/* Overlapping ranges of the same file */
+	if ((src == dst) &&
+	    (range->src_pos < range->dst_pos + range->size) &&
+	    (range->dst_pos < range->src_pos + range->size))
+		rc = EINVAL;
+
+	*out_copied = 0;
+	if (rc == EOK && range->size > 0) {
+		rc = ENOTSUP;
+		if ((src->fs_handle == dst->fs_handle) &&
+		    (src->service_id == dst->service_id))
+			rc = vfs_copy_range_native(src, dst, range, out_copied);
+
+		if (rc == ENOTSUP)
+			rc = vfs_copy_range_stream(src, dst, range, out_copied);
+	}
+
+	vfs_node_delref(dst);
+	vfs_node_delref(src);
+	return rc;
+}
+
 errno_t vfs_op_read(int fd, aoff64_t pos, size_t *out_bytes)
 {
 	return vfs_rdwr(fd, pos, true, rdwr_ipc_client, out_bytes);
 }
 
+/** Read a batch of directory entries with their attributes.
+ *
+ * The IPC_M_DATA_READ request of the client is forwarded to the file system
+ * of the directory.
+ *
+ * @param fd		Handle of the open directory.
+ * @param pos		Position to read from.
+ * @param out_bytes	Place to store the number of bytes of entries.
+ * @param out_pos	Place to store the position after the entries.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t vfs_op_readdir(int fd, aoff64_t pos, size_t *out_bytes,
+    aoff64_t *out_pos)
+{
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file)
+		return EBADF;
+
+	if (!file->open_read) {
+		vfs_file_put(file);
+		return EINVAL;
+	}
+
+	if (file->node->type != VFS_NODE_DIRECTORY) {
+		vfs_file_put(file);
+		return ENOTDIR;
+	}
+
+	/* Make sure that no one is modifying the namespace while we read. */
+	fibril_rwlock_read_lock(&file->node->contents_rwlock);
+	fibril_rwlock_read_lock(&namespace_rwlock);
+
+	async_exch_t *exch = vfs_exchange_grab(file->node->fs_handle);
+
+	ipc_call_t answer;
+	errno_t rc = async_data_read_forward_4_1(exch, VFS_OUT_READDIR,
+	    file->node->service_id, file->node->index, LOWER32(pos),
+	    UPPER32(pos), &answer);
+
+	vfs_exchange_release(exch);
+
+	fibril_rwlock_read_unlock(&namespace_rwlock);
+	fibril_rwlock_read_unlock(&file->node->contents_rwlock);
+
+	vfs_file_put(file);
+
+	if (rc == EOK) {
+		*out_bytes = ipc_get_arg1(&answer);
+		*out_pos = MERGE_LOUP32(ipc_get_arg2(&answer),
+		    ipc_get_arg3(&answer));
+	}
+
+	return rc;
+}
+
 errno_t vfs_op_rename(int basefd, char *old, char *new)
 {
 	vfs_file_t *base_file = vfs_file_get(basefd);
@@ -626,8 +872,10 @@ errno_t vfs_op_resize(int fd, int64_t size)
 
 	errno_t rc = vfs_truncate_internal(file->node->fs_handle,
 	    file->node->service_id, file->node->index, size);
-	if (rc == EOK)
+	if (rc == EOK) {
 		file->node->size = size;
+		vfs_dcache_size_set((vfs_triplet_t *) file->node, size);
+	}
 
 	fibril_rwlock_write_unlock(&file->node->contents_rwlock);
 	vfs_file_put(file);
@@ -822,6 +1070,8 @@ errno_t vfs_op_unmount(int mpfd)
 		return rc;
 	}
 
+	vfs_dcache_purge_fs(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
 	vfs_node_forget(mp->node->mount);
 	vfs_node_put(mp->node);
 	mp->node->mount = NULL;